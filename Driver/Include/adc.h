@@ -33,6 +33,7 @@ extern "C"
 
 #define ADC_ERR_ARGS            1   /*!< The arguments is wrong */
 #define ADC_ERR_CMD             2   /*!< The command is wrong */
+#define ADC_ERR_BUSY            3   /*!< A scan is running */
 
 /// @cond HIDDEN_SYMBOLS
 typedef INT32 (*ADC_CALLBACK)(UINT32 status, UINT32 userData);
@@ -82,8 +83,61 @@ typedef enum
     NAC_OFF,                         /*!<Disable Normal AD Conversion */
 } ADC_CMD;
 
+#define ADC_SCAN_SLOT_MAX       16          /*!< Conversions in one scan of a scan list */
+#define ADC_SCAN_FREE_RUN       0xFF        /*!< adcScanStart() timer: start each scan as soon as the last ends */
+#define ADC_SCAN_DECIM_MAX      256         /*!< Largest decimation rate */
+#define ADC_SCAN_ORDER_MAX      3           /*!< Largest CIC decimation filter order */
+
 /*@}*/ /* end of group ADC_EXPORTED_CONSTANTS */
 
+/** @addtogroup ADC_EXPORTED_STRUCTS ADC Exported Structs
+  @{
+*/
+
+/**
+ * @brief   Samples of one scanned channel: a lock-free ring between the ADC interrupt and one
+ *          reader, behind an optional CIC decimation filter. Samples are the 12-bit result
+ *          times 16, so averaged samples keep up to 4 more bits.
+ */
+typedef struct
+{
+    uint16_t *pu16Buf;          /*!< Samples */
+    uint32_t u32Size;           /*!< Samples in pu16Buf, a power of 2 */
+    volatile uint32_t u32Head;  /*!< Samples written, changed by the interrupt only */
+    volatile uint32_t u32Tail;  /*!< Samples read, changed by the reader only */
+    uint32_t u32Decim;          /*!< Conversions per sample, 1 for no filter */
+    uint32_t u32Order;          /*!< CIC filter order, 1 for a moving average */
+    uint32_t u32Gain;           /*!< u32Decim^u32Order, the filter gain to remove */
+    uint32_t u32Phase;          /*!< Conversions since the last sample */
+    uint32_t au32Int[ADC_SCAN_ORDER_MAX];   /*!< Integrators */
+    uint32_t au32Comb[ADC_SCAN_ORDER_MAX];  /*!< Comb delays */
+    uint32_t u32Conversions;    /*!< Conversions of the channel */
+    uint32_t u32Overruns;       /*!< Samples dropped on a full ring */
+} ADC_SCAN_CH_T;
+
+/**
+ * @brief   Scan list. A timer starts a scan, then the ADC interrupt of each conversion stores
+ *          the result and starts the conversion of the next slot.
+ */
+typedef struct
+{
+    ADC_SCAN_CH_T *apsCh[ADC_SCAN_SLOT_MAX];    /*!< Channel state of each slot */
+    uint32_t au32Conf[ADC_SCAN_SLOT_MAX];       /*!< ADC_CONF of each slot, channel selected */
+    uint32_t u32Slots;          /*!< Slots in a scan */
+    uint32_t u32Slot;           /*!< Slot converting */
+    volatile uint32_t u32Busy;  /*!< A scan is converting */
+    uint32_t u32Run;            /*!< Started and not stopped */
+    uint32_t u32Timer;          /*!< ETIMER starting the scans, or \ref ADC_SCAN_FREE_RUN */
+    uint32_t u32Ctl;            /*!< ADC_CTL with the menu start bit */
+    uint32_t u32Scans;          /*!< Scans completed */
+    uint32_t u32Missed;         /*!< Timer ticks that found the last scan still converting */
+    uint32_t (*pfnClock)(void); /*!< Tick source for the interrupt time, NULL for none */
+    uint32_t u32ClockMask;      /*!< Valid bits of pfnClock() */
+    uint32_t u32Ticks;          /*!< Clock ticks spent in the ADC and timer interrupts */
+} ADC_SCAN_T;
+
+/*@}*/ /* end of group ADC_EXPORTED_STRUCTS */
+
 /** @addtogroup ADC_EXPORTED_FUNCTIONS ADC Exported Functions
   @{
 */
@@ -96,6 +150,16 @@ int adcReadZ(short *bufZ1, short *bufZ2, int dataCnt);
 int adcIoctl(ADC_CMD cmd, int arg1, int arg2);
 int adcChangeChannel(int channel);
 
+void adcScanInit(ADC_SCAN_T *psScan);
+int adcScanAddChannel(ADC_SCAN_T *psScan, ADC_SCAN_CH_T *psCh, int channel, uint16_t *pu16Buf, uint32_t u32Size);
+int adcScanAddSlot(ADC_SCAN_T *psScan, ADC_SCAN_CH_T *psCh, int channel);
+int adcScanSetDecimation(ADC_SCAN_CH_T *psCh, uint32_t u32Decim, uint32_t u32Order);
+void adcScanSetClock(ADC_SCAN_T *psScan, uint32_t (*pfnClock)(void), uint32_t u32Mask);
+int adcScanStart(ADC_SCAN_T *psScan, uint32_t u32Timer, uint32_t u32ScanRate);
+void adcScanStop(ADC_SCAN_T *psScan);
+uint32_t adcScanCount(ADC_SCAN_CH_T *psCh);
+uint32_t adcScanRead(ADC_SCAN_CH_T *psCh, uint16_t *pu16Dst, uint32_t u32Samples);
+
 /*@}*/ /* end of group ADC_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group ADC_Driver */
@@ -44,6 +44,11 @@
 #define    CAN_REMOTE_FRAME    0ul    /*!< CAN frame select remote frame \hideinitializer */
 #define    CAN_DATA_FRAME    1ul      /*!< CAN frame select data frame \hideinitializer */
 
+/*---------------------------------------------------------------------------------------------------------*/
+/* CAN Queue Constant Definitions                                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+#define    CAN_QUEUE_OBJS    32ul     /*!< Message objects shared by the receive FIFO and the transmit objects of a CAN queue \hideinitializer */
+
 /*@}*/ /* end of group CAN_EXPORTED_CONSTANTS */
 
 
@@ -347,6 +352,75 @@ typedef struct
     uint8_t   u8IdType;   /*!< ID type*/
 } STR_CANMASK_T;
 
+/**
+  * @details    Frame received by a CAN queue
+  */
+typedef struct
+{
+    STR_CANMSG_T sMsg;      /*!< Frame */
+    uint32_t  u32Time;      /*!< Clock of CAN_QueueSetClock() when the frame was read from the FIFO */
+} CAN_FRAME_T;
+
+/**
+  * @details    Frame waiting in the transmit queue of a CAN queue
+  */
+typedef struct
+{
+    STR_CANMSG_T sMsg;      /*!< Frame */
+    uint32_t  u32Key;       /*!< Arbitration priority, the lowest is sent first */
+    uint32_t  u32Seq;       /*!< Order of CAN_QueueSend() among equal keys */
+} CAN_TXENTRY_T;
+
+/**
+  * @details    Interrupt-driven CAN queue. Message objects 0 to u32RxObjs - 1 form the receive
+  *             FIFO, drained by the interrupt into a lock-free ring; the next u32TxObjs objects
+  *             send the frames of a priority queue, refilled from the transmit interrupt.
+  */
+typedef struct
+{
+    CAN_T    *tCAN;                 /*!< Controller */
+    uint32_t u32RxObjs;             /*!< Message objects of the receive FIFO */
+    uint32_t u32TxObjs;             /*!< Message objects sending the transmit queue */
+    uint32_t u32TxFree;             /*!< Bit n set: transmit object u32RxObjs + n is free */
+    uint32_t u32TxNext;             /*!< Transmit object to load next, objects are loaded in ascending order */
+    uint8_t  au8TxBits[CAN_QUEUE_OBJS];     /*!< Bits of the frame in each transmit object */
+
+    CAN_FRAME_T *psRx;              /*!< Receive ring */
+    uint32_t u32RxSize;             /*!< Frames in psRx, a power of 2 */
+    volatile uint32_t u32RxHead;    /*!< Frames written, changed by the interrupt only */
+    volatile uint32_t u32RxTail;    /*!< Frames read, changed by the reader only */
+
+    CAN_TXENTRY_T *psTx;            /*!< Transmit queue, a binary heap */
+    uint32_t u32TxSize;             /*!< Entries in psTx */
+    uint32_t u32TxCount;            /*!< Frames queued, not yet in a transmit object */
+    uint32_t u32TxSeq;              /*!< Frames ever queued */
+
+    uint32_t u32Filter;             /*!< Software ID filter enabled */
+    uint32_t au32StdFilter[2048 / 32];  /*!< Accepted standard IDs, one bit each */
+    uint32_t *pu32ExtFilter;        /*!< Accepted extended IDs, an open addressing hash set */
+    uint32_t u32ExtSize;            /*!< Entries in pu32ExtFilter, a power of 2 */
+    uint32_t u32ExtCount;           /*!< Extended IDs in pu32ExtFilter */
+
+    uint32_t u32RxFrames;           /*!< Frames stored in the receive ring */
+    uint32_t u32RxFiltered;         /*!< Frames rejected by the software filter */
+    uint32_t u32RxOverruns;         /*!< Frames dropped on a full receive ring */
+    uint32_t u32RxLost;             /*!< Frames overwritten in the FIFO before the interrupt read them */
+    uint32_t u32TxFrames;           /*!< Frames sent */
+    uint32_t u32TxFull;             /*!< CAN_QueueSend() calls refused on a full queue */
+    uint32_t au32Lec[8];            /*!< Bus errors seen, by last error code */
+    uint32_t u32Warnings;           /*!< Entries into the error warning state */
+    uint32_t u32Passive;            /*!< Entries into the error passive state */
+    uint32_t u32BusOff;             /*!< Bus-off events, each followed by a recovery */
+    uint32_t u32Status;             /*!< Last error state bits of STATUS */
+    uint32_t u32Bits;               /*!< Bits of frames sent and received since CAN_QueueBusLoad() */
+
+    uint32_t (*pfnClock)(void);     /*!< Timestamp and load clock, NULL for none */
+    uint32_t u32ClockMask;          /*!< Valid bits of pfnClock() */
+    uint32_t u32ClockHz;            /*!< Rate of pfnClock() */
+    uint32_t u32LoadTime;           /*!< pfnClock() at the last CAN_QueueBusLoad() */
+    uint32_t u32Ticks;              /*!< Clock ticks spent in the interrupt handler */
+} CAN_QUEUE_T;
+
 /*@}*/ /* end of group CAN_EXPORTED_STRUCTS */
 
 /** @cond HIDDEN_SYMBOLS */
@@ -450,6 +524,22 @@ int32_t CAN_SetRxMsgObjAndMsk(CAN_T *tCAN, uint8_t u8MsgObj, uint8_t u8idType, u
 int32_t CAN_SetRxMsgObj(CAN_T *tCAN, uint8_t u8MsgObj, uint8_t u8idType, uint32_t u32id, uint8_t u8singleOrFifoLast);
 void CAN_WaitMsg(CAN_T *tCAN);
 int32_t CAN_ReadMsgObj(CAN_T *tCAN, uint8_t u8MsgObj, uint8_t u8Release, STR_CANMSG_T* pCanMsg);
+int32_t CAN_ReserveIF(CAN_T *tCAN, uint32_t u32Reserve);
+
+int32_t CAN_QueueOpen(CAN_QUEUE_T *psQueue, CAN_T *tCAN, uint32_t u32RxObjs, uint32_t u32TxObjs,
+                      CAN_FRAME_T *psRxBuf, uint32_t u32RxSize, CAN_TXENTRY_T *psTxBuf, uint32_t u32TxSize);
+void CAN_QueueClose(CAN_QUEUE_T *psQueue);
+void CAN_QueueIRQHandler(CAN_QUEUE_T *psQueue);
+int32_t CAN_QueueSend(CAN_QUEUE_T *psQueue, STR_CANMSG_T *pCanMsg);
+int32_t CAN_QueueReceive(CAN_QUEUE_T *psQueue, CAN_FRAME_T *psFrame);
+uint32_t CAN_QueueRxCount(CAN_QUEUE_T *psQueue);
+uint32_t CAN_QueueTxCount(CAN_QUEUE_T *psQueue);
+void CAN_QueueEnableFilter(CAN_QUEUE_T *psQueue, uint32_t *pu32ExtTable, uint32_t u32ExtSize);
+void CAN_QueueDisableFilter(CAN_QUEUE_T *psQueue);
+int32_t CAN_QueueAddId(CAN_QUEUE_T *psQueue, uint32_t u32IDType, uint32_t u32ID);
+int32_t CAN_QueueRemoveId(CAN_QUEUE_T *psQueue, uint32_t u32IDType, uint32_t u32ID);
+void CAN_QueueSetClock(CAN_QUEUE_T *psQueue, uint32_t (*pfnClock)(void), uint32_t u32Mask, uint32_t u32Hz);
+uint32_t CAN_QueueBusLoad(CAN_QUEUE_T *psQueue);
 
 /*@}*/ /* end of group CAN_EXPORTED_FUNCTIONS */
 
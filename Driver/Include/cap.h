@@ -388,6 +388,96 @@ static uint32_t u32EscapeFrame = 0;
 #define CAP_INVALID_BUF               ((int32_t)(0xFFFFFFFF-2))
 #define CAP_INVALID_PIPE              ((int32_t)(0xFFFFFFFF-3))
 
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Frame Queue Constant Definitions                                                                       */
+/*---------------------------------------------------------------------------------------------------------*/
+#define CAP_FQ_DEPTH_MAX     8UL        /*!< Frame buffers of a queue  \hideinitializer */
+#define CAP_FQ_DROP_NEW      0UL        /*!< No free buffer at frame end: keep the ready frames, the next frame overwrites the new one  \hideinitializer */
+#define CAP_FQ_DROP_OLD      1UL        /*!< No free buffer at frame end: recycle the oldest ready frame, the consumer gets the newest  \hideinitializer */
+
+/**
+ * @brief   One frame buffer of a queue. Addresses are those given to CAP_FQ_Init(), so
+ *          a cacheable buffer is read through the D-cache.
+ */
+typedef struct
+{
+    uint32_t u32Index;      /*!< Buffer number, 0 ~ u32Num-1 */
+    uint32_t u32Seq;        /*!< Frame number counted from CAP_FQ_Init(), dropped frames included */
+    uint32_t u32Time;       /*!< Clock of CAP_FQ_SetClock() at the frame end interrupt */
+    uint32_t au32Addr[3];   /*!< Packet buffer, or Y, U and V planes */
+} CAP_FRAME_T;
+
+/**
+ * @brief   Ring of frame buffers the capture engine is switched between at each frame end.
+ *          Each buffer is free, being captured, ready, or held by the consumer.
+ */
+typedef struct
+{
+    CAP_T       *VCAP;                          /*!< Capture engine */
+    uint32_t    u32Num;                         /*!< Frame buffers */
+    uint32_t    u32Mode;                        /*!< \ref CAP_FQ_DROP_NEW or \ref CAP_FQ_DROP_OLD */
+    uint32_t    u32Size;                        /*!< Bytes of one frame */
+    uint32_t    (*pfnClock)(void);              /*!< Time stamp source, NULL for none */
+    CAP_FRAME_T asFrame[CAP_FQ_DEPTH_MAX];      /*!< Frame buffers */
+    uint8_t     au8State[CAP_FQ_DEPTH_MAX];     /*!< State of each buffer */
+    uint8_t     au8Free[CAP_FQ_DEPTH_MAX];      /*!< Free buffers, oldest first */
+    uint8_t     au8Ready[CAP_FQ_DEPTH_MAX];     /*!< Ready frames, oldest first */
+    uint32_t    u32FreeHead, u32FreeCnt;        /*!< Free ring */
+    uint32_t    u32ReadyHead, u32ReadyCnt;      /*!< Ready ring */
+    uint32_t    u32Active;                      /*!< Buffer being captured */
+    volatile uint32_t u32Seq;                   /*!< Frame ends since CAP_FQ_Init() */
+    volatile uint32_t u32Dropped;               /*!< Frames overwritten or recycled before the consumer took them */
+} CAP_FQ_T;
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Motion Analysis Constant Definitions                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+#define CAP_MD_BOX_MAX       8UL        /*!< Boxes reported per frame  \hideinitializer */
+#define CAP_MD_EVT_START     0x1UL      /*!< CAP_MD_Process(): motion started this frame  \hideinitializer */
+#define CAP_MD_EVT_END       0x2UL      /*!< CAP_MD_Process(): motion ended this frame  \hideinitializer */
+#define CAP_MD_EVT_MOTION    0x4UL      /*!< CAP_MD_Process(): in a motion event  \hideinitializer */
+
+#define CAP_MD_WORK_SIZE(u32Cols, u32Rows)  ((u32Cols) * (u32Rows))   /*!< uint16_t words of the work area  \hideinitializer */
+
+/**
+ * @brief   Bounding box of moving blocks, in blocks of the motion detection map
+ */
+typedef struct
+{
+    uint16_t u16X;          /*!< Left block column */
+    uint16_t u16Y;          /*!< Top block row */
+    uint16_t u16W;          /*!< Width in blocks */
+    uint16_t u16H;          /*!< Height in blocks */
+    uint16_t u16Blocks;     /*!< Moving blocks inside */
+} CAP_MD_BOX_T;
+
+/**
+ * @brief   Motion analysis of the CAP motion detection output. The tuning fields are set to
+ *          defaults by CAP_MD_Init() and may be changed between frames.
+ */
+typedef struct
+{
+    uint32_t u32Cols;           /*!< Blocks per row of the map */
+    uint32_t u32Rows;           /*!< Block rows of the map */
+    uint32_t u32Format;         /*!< u32Format of CAP_EnableMotionDet(): FALSE one byte, TRUE one bit per block */
+    uint32_t u32Margin;         /*!< Difference above the background level that makes a block move, 0 ~ 126 */
+    uint32_t u32Learn;          /*!< Background follows a still block by 1/2^u32Learn per frame, a moving one 8 times slower */
+    uint32_t u32Gap;            /*!< Blocks between two moving areas that still join them into one box */
+    uint32_t u32MinBlocks;      /*!< Smallest box reported */
+    uint32_t u32OnBlocks;       /*!< Moving blocks in boxes that count as motion */
+    uint32_t u32OffBlocks;      /*!< Moving blocks in boxes below which motion has stopped */
+    uint32_t u32OnFrames;       /*!< Frames of motion that start an event */
+    uint32_t u32OffFrames;      /*!< Frames without motion that end an event */
+    uint16_t *pu16Bg;           /*!< Background level of each block, 8.8 fixed point */
+    uint32_t u32Frames;         /*!< Frames processed */
+    uint32_t u32Motion;         /*!< In a motion event */
+    uint32_t u32Count;          /*!< Consecutive frames toward the next event */
+    uint32_t u32Level;          /*!< Moving blocks in the reported boxes */
+    uint32_t u32Boxes;          /*!< Reported boxes, largest first */
+    CAP_MD_BOX_T asBox[CAP_MD_BOX_MAX]; /*!< Reported boxes */
+    CAP_MD_BOX_T asWork[2 * CAP_MD_BOX_MAX]; /*!< Boxes being built */
+} CAP_MD_T;
+
 
 /*@}*/ /* end of group CAP_EXPORTED_CONSTANTS */
 
@@ -454,6 +544,26 @@ void CAP_SetPacketStride(CAP_T * VCAP,uint32_t u32Stride );
 void CAP_SetPlanarStride(CAP_T * VCAP,uint32_t u32Stride );
 void CAP_EnableMotionDet(CAP_T * VCAP,uint32_t u32Freq, uint32_t u32BlockSize, uint32_t u32Format, uint32_t u32Threshold,  uint32_t u32YDetAddr, uint32_t u32DetAddr);
 void CAP_DisableMotionDet(CAP_T * VCAP);
+int32_t CAP_FQ_Init(CAP_FQ_T *psQ, CAP_T *VCAP, uint32_t u32Base, uint32_t u32Num, uint32_t u32YLen, uint32_t u32UVLen, uint32_t u32Mode);
+void CAP_FQ_SetClock(CAP_FQ_T *psQ, uint32_t (*pfnClock)(void));
+void CAP_FQ_Start(CAP_FQ_T *psQ);
+void CAP_FQ_Stop(CAP_FQ_T *psQ);
+uint32_t CAP_FQ_IRQHandler(CAP_FQ_T *psQ);
+CAP_FRAME_T *CAP_FQ_Dequeue(CAP_FQ_T *psQ);
+int32_t CAP_FQ_Queue(CAP_FQ_T *psQ, CAP_FRAME_T *psFrame);
+void CAP_PixYUYVToRGB565(const void *pvSrc, void *pvDst, uint32_t u32Pixels);
+void CAP_PixYUYVToRGB888(const void *pvSrc, void *pvDst, uint32_t u32Pixels);
+void CAP_PixYUYVToGray(const void *pvSrc, void *pvDst, uint32_t u32Pixels);
+void CAP_PixPlanarToYUYV(const uint8_t *pu8Y, const uint8_t *pu8U, const uint8_t *pu8V, void *pvDst,
+                         uint32_t u32Width, uint32_t u32Height, uint32_t u32Format);
+void CAP_PixDownscale2x(const uint8_t *pu8Src, uint32_t u32SrcStride, uint8_t *pu8Dst, uint32_t u32DstStride,
+                        uint32_t u32Width, uint32_t u32Height);
+void CAP_PixDownscaleYUYV2x(const void *pvSrc, uint32_t u32SrcStride, void *pvDst, uint32_t u32DstStride,
+                            uint32_t u32Width, uint32_t u32Height);
+void CAP_PixCrop(const void *pvSrc, uint32_t u32SrcStride, void *pvDst, uint32_t u32DstStride,
+                 uint32_t u32X, uint32_t u32Y, uint32_t u32Width, uint32_t u32Height, uint32_t u32Bpp);
+void CAP_MD_Init(CAP_MD_T *psMd, uint32_t u32Cols, uint32_t u32Rows, uint32_t u32Format, uint16_t *pu16Work);
+uint32_t CAP_MD_Process(CAP_MD_T *psMd, const uint8_t *pu8Map);
 
 /*@}*/ /* end of group CAP_EXPORTED_FUNCTIONS */
 
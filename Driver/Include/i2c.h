@@ -46,6 +46,22 @@
 #define I2C_GCMODE_ENABLE           1    /*!< Enable  I2C GC Mode                                                         \hideinitializer */
 #define I2C_GCMODE_DISABLE          0    /*!< Disable I2C GC Mode                                                         \hideinitializer */
 
+/*---------------------------------------------------------------------------------------------------------*/
+/*  I2C queue constant definitions.                                                                        */
+/*---------------------------------------------------------------------------------------------------------*/
+#define I2C_MSG_READ                0x01 /*!< I2C_MSG_T::u8Flags: read the message from the slave                          \hideinitializer */
+#define I2C_MSG_NOSTART             0x02 /*!< I2C_MSG_T::u8Flags: continue the previous write message without a START    \hideinitializer */
+
+#define I2C_XFER_OK                 0    /*!< Transaction done                                                            \hideinitializer */
+#define I2C_XFER_QUEUED             1    /*!< Transaction waiting in the queue                                            \hideinitializer */
+#define I2C_XFER_ACTIVE             2    /*!< Transaction on the bus                                                      \hideinitializer */
+#define I2C_XFER_ERR_PARAM          (-1) /*!< Transaction refused, invalid descriptor                                     \hideinitializer */
+#define I2C_XFER_ERR_NACK           (-2) /*!< Slave address or data not acknowledged                                      \hideinitializer */
+#define I2C_XFER_ERR_ARB            (-3) /*!< Arbitration lost on every try                                               \hideinitializer */
+#define I2C_XFER_ERR_BUS            (-4) /*!< Bus error, controller reset                                                 \hideinitializer */
+#define I2C_XFER_ERR_TIMEOUT        (-5) /*!< Bus stalled beyond the time-out counter, controller reset                   \hideinitializer */
+#define I2C_XFER_ERR_ABORT          (-6) /*!< Dropped by I2C_QueueClose()                                                 \hideinitializer */
+
 /*@}*/ /* end of group I2C_EXPORTED_CONSTANTS */
 
 typedef struct
@@ -301,6 +317,81 @@ typedef struct
 #define I2C2                 ((I2C_T *)   I2C2_BA)
 #define I2C3                 ((I2C_T *)   I2C3_BA)
 
+/** @addtogroup I2C_EXPORTED_STRUCTS I2C Exported Structs
+  @{
+*/
+/**
+  * @details    One message of an I2C transaction, started with a START or a repeated START
+  */
+typedef struct
+{
+    uint8_t   u8Addr;       /*!< 7-bit slave address */
+    uint8_t   u8Flags;      /*!< I2C_MSG_READ, I2C_MSG_NOSTART */
+    uint16_t  u16Len;       /*!< Bytes to send or receive, at least 1 to read */
+    uint8_t   *pu8Buf;      /*!< Data */
+} I2C_MSG_T;
+
+/**
+  * @details    One entry of a register table, written as START, address, register, value, STOP
+  */
+typedef struct
+{
+    uint16_t  u16Reg;       /*!< Register, sent most significant byte first */
+    uint16_t  u16Val;       /*!< Value, sent most significant byte first */
+} I2C_REG_T;
+
+/**
+  * @details    I2C transaction descriptor. It holds either messages sent back to back with repeated
+  *             STARTs or a register table. The descriptor belongs to the queue from I2C_QueueSubmit()
+  *             until i32Status leaves I2C_XFER_QUEUED and I2C_XFER_ACTIVE.
+  */
+typedef struct I2C_XFER
+{
+    struct I2C_XFER *psNext;        /*!< Next queued transaction, set by the queue */
+    I2C_MSG_T *psMsg;               /*!< Messages, NULL for a register table */
+    uint32_t  u32Msgs;              /*!< Messages in psMsg */
+    const I2C_REG_T *psRegs;        /*!< Register table */
+    uint32_t  u32Regs;              /*!< Entries in psRegs */
+    uint8_t   u8RegAddr;            /*!< 7-bit slave address of the register table */
+    uint8_t   u8RegBytes;           /*!< Register bytes of a table entry, 1 or 2 */
+    uint8_t   u8ValBytes;           /*!< Value bytes of a table entry, 1 or 2 */
+    uint32_t  u32Retries;           /*!< Extra tries on a not acknowledged address or a lost arbitration */
+    void (*pfnDone)(struct I2C_XFER *psXfer);   /*!< Called from the interrupt when done, NULL for none */
+    void      *pvParam;             /*!< Free for the caller */
+    volatile int32_t i32Status;     /*!< I2C_XFER_OK, I2C_XFER_QUEUED, I2C_XFER_ACTIVE or an error */
+    volatile uint32_t u32Done;      /*!< Messages or table entries completed */
+    uint32_t  u32Pos;               /*!< Byte of the current message or entry */
+    uint32_t  u32Tries;             /*!< Retries used */
+} I2C_XFER_T;
+
+/**
+  * @details    Interrupt-driven I2C master transaction queue
+  */
+typedef struct
+{
+    I2C_T     *i2c;                 /*!< Controller */
+    I2C_XFER_T *psHead;             /*!< Transaction on the bus, NULL when idle */
+    I2C_XFER_T *psTail;             /*!< Last queued transaction */
+    uint32_t  u32TimeoutCtl;        /*!< TOCTL setting applied while a transaction is on the bus */
+    void (*pfnRecover)(I2C_T *i2c); /*!< Frees a bus held by a slave after a controller reset, NULL for none */
+    uint32_t  u32InHandler;         /*!< Set while I2C_QueueIRQHandler() runs */
+
+    uint32_t  u32Xfers;             /*!< Transactions completed */
+    uint32_t  u32Errors;            /*!< Transactions ended with an error */
+    uint32_t  u32Nacks;             /*!< Not acknowledged addresses and data */
+    uint32_t  u32ArbLost;           /*!< Arbitrations lost */
+    uint32_t  u32Retries;           /*!< Tries repeated */
+    uint32_t  u32Timeouts;          /*!< Time-out counter events */
+    uint32_t  u32BusErrors;         /*!< Bus errors */
+    uint32_t  u32Recoveries;        /*!< Controller resets */
+
+    uint32_t (*pfnClock)(void);     /*!< Clock timing the interrupt handler, NULL for none */
+    uint32_t  u32ClockMask;         /*!< Valid bits of pfnClock() */
+    uint32_t  u32Ticks;             /*!< Clock ticks spent in the interrupt handler */
+} I2C_QUEUE_T;
+
+/*@}*/ /* end of group I2C_EXPORTED_STRUCTS */
+
 
 
 
@@ -529,6 +620,18 @@ uint32_t I2C_ReadMultiBytesOneReg(I2C_T *i2c, uint8_t u8SlaveAddr, uint8_t u8Dat
 uint8_t I2C_ReadByteTwoRegs(I2C_T *i2c, uint8_t u8SlaveAddr, uint16_t u16DataAddr);
 uint32_t I2C_ReadMultiBytesTwoRegs(I2C_T *i2c, uint8_t u8SlaveAddr, uint16_t u16DataAddr, uint8_t rdata[], uint32_t u32rLen);
 
+int32_t I2C_QueueOpen(I2C_QUEUE_T *psQueue, I2C_T *i2c, uint8_t u8LongTimeout);
+void I2C_QueueClose(I2C_QUEUE_T *psQueue);
+void I2C_QueueIRQHandler(I2C_QUEUE_T *psQueue);
+int32_t I2C_QueueSubmit(I2C_QUEUE_T *psQueue, I2C_XFER_T *psXfer);
+int32_t I2C_QueueWait(I2C_XFER_T *psXfer);
+uint32_t I2C_QueueCount(I2C_QUEUE_T *psQueue);
+void I2C_QueueSetRecovery(I2C_QUEUE_T *psQueue, void (*pfnRecover)(I2C_T *i2c));
+void I2C_QueueSetClock(I2C_QUEUE_T *psQueue, uint32_t (*pfnClock)(void), uint32_t u32Mask);
+void I2C_XferInit(I2C_XFER_T *psXfer, I2C_MSG_T *psMsg, uint32_t u32Msgs);
+void I2C_XferInitRegTable(I2C_XFER_T *psXfer, uint8_t u8SlaveAddr, const I2C_REG_T *psRegs, uint32_t u32Regs,
+                          uint8_t u8RegBytes, uint8_t u8ValBytes);
+
 /*@}*/ /* end of group I2C_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group I2C_Driver */
@@ -104,8 +104,113 @@ extern "C"
 
 #define I2S_SET_PCM_FS_PERIOD       17  /*!< Set PCM FS pulse period */
 
+#define I2S_PIPE_STREAM_MAX     4       /*!< Play streams mixed by the audio pipeline */
+#define I2S_GAIN_UNITY          0x7FFF  /*!< Stream gain of 1.0 in Q15, the largest gain */
+
+#define I2S_SRC_PHASES          128     /*!< Filter phases of the resampler, interpolated between */
+#define I2S_SRC_TAPS_MAX        128     /*!< Most taps per phase of the resampler */
+#define I2S_SRC_DRIFT_MAX       2000000 /*!< Largest drift correction of the resampler, parts per billion */
+#define I2S_SRC_COEF_SIZE(u32Taps)  ((I2S_SRC_PHASES + 1) * (u32Taps))  /*!< int16_t coefficients of a resampler */
+#define I2S_SRC_HIST_SIZE(u32Taps)  (4 * (u32Taps))                     /*!< Frames of input history of a resampler */
+
 /*@}*/ /* end of group ARM9_I2S_EXPORTED_CONSTANTS */
 
+/** @addtogroup ARM9_I2S_EXPORTED_STRUCTS I2S Exported Structs
+  @{
+*/
+
+/**
+ * @brief   Lock-free FIFO of 16-bit stereo frames between one producer and one consumer,
+ *          one 32-bit word per frame with the left sample in bits 15:0
+ */
+typedef struct
+{
+    uint32_t *pu32Buf;          /*!< Frames */
+    uint32_t u32Size;           /*!< Frames in pu32Buf, a power of 2 */
+    volatile uint32_t u32Head;  /*!< Frames written, changed by the producer only */
+    volatile uint32_t u32Tail;  /*!< Frames read, changed by the consumer only */
+} I2S_FIFO_T;
+
+/**
+ * @brief   Gain with a linear ramp, see i2sPcmSetGain()
+ */
+typedef struct
+{
+    int32_t i32Gain;            /*!< Current gain, Q31. Bits 31:16 are applied */
+    int32_t i32Step;            /*!< Added to i32Gain each frame of the ramp */
+    int32_t i32Target;          /*!< Gain at the end of the ramp */
+    uint32_t u32Ramp;           /*!< Frames left in the ramp */
+} I2S_GAIN_T;
+
+/**
+ * @brief   Play stream of the audio pipeline
+ */
+typedef struct
+{
+    I2S_FIFO_T sFifo;           /*!< Frames to play, written by the application */
+    I2S_GAIN_T sGain;           /*!< Volume */
+    uint32_t u32Enable;         /*!< Mixed while non-zero */
+    uint32_t u32Frames;         /*!< Frames mixed */
+    uint32_t u32Underruns;      /*!< Periods the FIFO ran short of */
+    uint32_t u32Silence;        /*!< Frames of silence played for underruns */
+    uint32_t u32Ticks;          /*!< Clock ticks spent mixing the stream */
+} I2S_STREAM_T;
+
+/**
+ * @brief   Audio pipeline. The DMA buffers are split into periods, one DMA interrupt each;
+ *          the interrupt mixes the streams into the period just played and moves the period
+ *          just recorded into the record FIFO.
+ */
+typedef struct
+{
+    uint32_t *pu32Play;         /*!< Play DMA buffer */
+    uint32_t *pu32Rec;          /*!< Record DMA buffer, NULL for none */
+    int32_t *pi32Mix;           /*!< Mix accumulator, 2 words per frame of a period */
+    uint32_t u32Width;          /*!< \ref I2S_BIT_WIDTH_16 or \ref I2S_BIT_WIDTH_24 */
+    uint32_t u32Periods;        /*!< Periods per DMA buffer: 2, 4 or 8 */
+    uint32_t u32PeriodFrames;   /*!< Frames per period, a multiple of 8 */
+    uint32_t u32PeriodBytes;    /*!< Bytes per period */
+    I2S_STREAM_T *apsStream[I2S_PIPE_STREAM_MAX]; /*!< Play streams */
+    uint32_t u32Streams;        /*!< Entries in apsStream */
+    I2S_FIFO_T *psRecFifo;      /*!< Recorded frames, NULL for none */
+    uint32_t (*pfnClock)(void); /*!< Tick source for the CPU load statistics, NULL for none */
+    uint32_t u32ClockMask;      /*!< Valid bits of pfnClock() */
+    uint32_t u32PlayNext;       /*!< Next play period to fill */
+    uint32_t u32RecNext;        /*!< Next record period to read */
+    uint32_t u32PlayPeriods;    /*!< Play periods filled */
+    uint32_t u32RecPeriods;     /*!< Record periods read */
+    uint32_t u32PlayLate;       /*!< Play interrupts serviced after the DMA had left the next period */
+    uint32_t u32RecLate;        /*!< Record interrupts serviced after the DMA had left the next period */
+    uint32_t u32RecOverruns;    /*!< Record periods that did not fit in psRecFifo */
+    uint32_t u32RecDropped;     /*!< Recorded frames dropped */
+    uint32_t u32Ticks;          /*!< Clock ticks spent in the play and record interrupts */
+    uint32_t u32Elapsed;        /*!< Clock ticks since i2sPipeStart(), summed per play period */
+    uint32_t u32LastTime;       /*!< pfnClock() at the last play interrupt */
+} I2S_PIPE_T;
+
+/**
+ * @brief   Polyphase sample rate converter of 16-bit stereo frames, see i2sSrcInit()
+ */
+typedef struct
+{
+    int16_t *pi16Coef;          /*!< I2S_SRC_PHASES + 1 phases of u32Taps coefficients, Q15, word aligned */
+    uint32_t *pu32Hist;         /*!< Input frames being filtered, \ref I2S_SRC_HIST_SIZE (u32Taps) */
+    uint32_t u32Taps;           /*!< Taps per phase */
+    uint32_t u32HistSize;       /*!< Frames in pu32Hist */
+    uint32_t u32HistCount;      /*!< Frames held in pu32Hist */
+    uint32_t u32Pos;            /*!< Frame of pu32Hist under the first tap of the next output */
+    uint32_t u32Frac;           /*!< Position of the next output past u32Pos, Q32 */
+    uint32_t u32InRate;         /*!< Input sample rate */
+    uint32_t u32OutRate;        /*!< Output sample rate */
+    uint32_t u32StepInt;        /*!< Input frames per output frame with the drift correction, integer part */
+    uint32_t u32StepFrac;       /*!< and fraction, Q32 */
+    int32_t i32Ppb;             /*!< Drift correction, parts per billion faster input */
+    int32_t i32Level;           /*!< i2sSrcTrack() level error, frames in Q8, low-pass filtered */
+    int32_t i32Sum;             /*!< i2sSrcTrack() integral of i32Level */
+} I2S_SRC_T;
+
+/*@}*/ /* end of group ARM9_I2S_EXPORTED_STRUCTS */
+
 /** @addtogroup ARM9_I2S_EXPORTED_FUNCTIONS I2S Exported Functions
   @{
 */
@@ -117,6 +222,40 @@ void i2sSetSampleRate(uint32_t u32SourceClockRate, uint32_t u32SampleRate, uint3
 void i2sSetMCLKFrequency(uint32_t u32SourceClockRate, uint32_t u32SampleRate);
 void i2sSetPCMBCLKFrequency(uint32_t u32SourceClockRate, uint32_t u32Rate);
 
+void i2sFifoInit(I2S_FIFO_T *psFifo, uint32_t *pu32Buf, uint32_t u32Size);
+uint32_t i2sFifoCount(I2S_FIFO_T *psFifo);
+uint32_t i2sFifoSpace(I2S_FIFO_T *psFifo);
+uint32_t i2sFifoWrite(I2S_FIFO_T *psFifo, const uint32_t *pu32Src, uint32_t u32Frames);
+uint32_t i2sFifoRead(I2S_FIFO_T *psFifo, uint32_t *pu32Dst, uint32_t u32Frames);
+int32_t i2sPipeInit(I2S_PIPE_T *psPipe, uint32_t u32Width, uint32_t u32Periods, uint32_t u32PeriodFrames,
+                    uint32_t *pu32Play, uint32_t *pu32Rec, int32_t *pi32Mix);
+void i2sPipeSetClock(I2S_PIPE_T *psPipe, uint32_t (*pfnClock)(void), uint32_t u32Mask);
+int32_t i2sPipeAddStream(I2S_PIPE_T *psPipe, I2S_STREAM_T *psStream, uint32_t *pu32Buf, uint32_t u32Size);
+void i2sPipeSetRecord(I2S_PIPE_T *psPipe, I2S_FIFO_T *psFifo);
+void i2sPipeStart(I2S_PIPE_T *psPipe);
+void i2sPipeStop(I2S_PIPE_T *psPipe);
+void i2sPipePlayPeriod(I2S_PIPE_T *psPipe, uint32_t u32Period);
+void i2sPipeRecPeriod(I2S_PIPE_T *psPipe, uint32_t u32Period);
+
+void i2sPcmSetGain(I2S_GAIN_T *psGain, uint32_t u32Gain, uint32_t u32RampFrames);
+void i2sPcmMix16(int32_t *pi32Acc, const uint32_t *pu32Src, uint32_t u32Frames, I2S_GAIN_T *psGain);
+void i2sPcmOut16(uint32_t *pu32Dst, const int32_t *pi32Acc, uint32_t u32Frames);
+void i2sPcmOut24(int32_t *pi32Dst, const int32_t *pi32Acc, uint32_t u32Frames);
+void i2sPcm16To24(int32_t *pi32Dst, const uint32_t *pu32Src, uint32_t u32Frames);
+void i2sPcm24To16(uint32_t *pu32Dst, const int32_t *pi32Src, uint32_t u32Frames);
+void i2sPcmPack24(uint8_t *pu8Dst, const int32_t *pi32Src, uint32_t u32Samples);
+void i2sPcmUnpack24(int32_t *pi32Dst, const uint8_t *pu8Src, uint32_t u32Samples);
+
+int32_t i2sSrcInit(I2S_SRC_T *psSrc, uint32_t u32InRate, uint32_t u32OutRate, uint32_t u32Taps,
+                   int16_t *pi16Coef, uint32_t *pu32Hist);
+void i2sSrcReset(I2S_SRC_T *psSrc);
+void i2sSrcSetDrift(I2S_SRC_T *psSrc, int32_t i32Ppb);
+int32_t i2sSrcTrack(I2S_SRC_T *psSrc, uint32_t u32Level, uint32_t u32Target);
+uint32_t i2sSrcProcess(I2S_SRC_T *psSrc, const uint32_t *pu32In, uint32_t *pu32InFrames,
+                       uint32_t *pu32Out, uint32_t u32OutFrames);
+uint32_t i2sSrcWriteFifo(I2S_SRC_T *psSrc, I2S_FIFO_T *psFifo, const uint32_t *pu32In, uint32_t u32Frames);
+uint32_t i2sSrcReadFifo(I2S_SRC_T *psSrc, I2S_FIFO_T *psFifo, uint32_t *pu32Out, uint32_t u32Frames);
+
 /*@}*/ /* end of group I2S_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group I2S_Driver */
@@ -1087,6 +1087,46 @@ typedef struct
 #define PDMA_INT_TEMPTY     0x00000001UL            /*!<Table Empty Interrupt  \hideinitializer */
 #define PDMA_INT_TIMEOUT    0x00000002UL            /*!<Timeout Interrupt \hideinitializer */
 
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Channel Service Constant Definitions                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+#define PDMA_SVC_CH_MAX     (2UL * PDMA_CH_MAX)     /*!<Channels of PDMA_RequestChannel(), PDMA0 channels first  \hideinitializer */
+#define PDMA_SVC_DESC_MAX   64UL                    /*!<Scatter-gather descriptors shared by all service channels  \hideinitializer */
+#define PDMA_SVC_TXCNT_MAX  65536UL                 /*!<Transfers of one descriptor, longer segments are split  \hideinitializer */
+
+#define PDMA_EVT_DONE       0x00000001UL            /*!<Transfer list or stream buffer finished  \hideinitializer */
+#define PDMA_EVT_ABORT      0x00000002UL            /*!<Bus error, the channel was paused  \hideinitializer */
+#define PDMA_EVT_TIMEOUT    0x00000004UL            /*!<Peripheral request time-out  \hideinitializer */
+#define PDMA_EVT_PONG       0x00000008UL            /*!<With PDMA_EVT_DONE of a stream: the second buffer finished  \hideinitializer */
+
+#define PDMA_OK             0                       /*!<Request accepted  \hideinitializer */
+#define PDMA_ERR_ARG        -1                      /*!<Invalid channel or transfer list  \hideinitializer */
+#define PDMA_ERR_BUSY       -2                      /*!<Channel still has a transfer in progress  \hideinitializer */
+#define PDMA_ERR_NO_DESC    -3                      /*!<Descriptor pool exhausted, retry when a transfer finished  \hideinitializer */
+
+/**
+ * @brief   Completion callback of a service channel, called in PDMA interrupt context
+ *
+ * @param[in]   i32Ch       Channel returned by PDMA_RequestChannel()
+ * @param[in]   u32Event    PDMA_EVT_xxx bits
+ * @param[in]   pvUserData  Pointer given to PDMA_RequestChannel()
+ */
+typedef void (*PDMA_CALLBACK_T)(int32_t i32Ch, uint32_t u32Event, void *pvUserData);
+
+/**
+ * @brief   One segment of a transfer list. Fixed addresses (PDMA_SAR_FIX / PDMA_DAR_FIX) are
+ *          used as given, incrementing ones advance through the segment.
+ */
+typedef struct
+{
+    uint32_t u32Src;        /*!< Source address */
+    uint32_t u32Dst;        /*!< Destination address */
+    uint32_t u32Len;        /*!< Length in bytes, a multiple of the transfer width */
+} PDMA_SG_T;
+
+#define PDMA_SVC_MODULE(i32Ch)  (((uint32_t)(i32Ch) < PDMA_CH_MAX) ? PDMA0 : PDMA1)  /*!<Controller of a service channel  \hideinitializer */
+#define PDMA_SVC_CHANNEL(i32Ch) ((uint32_t)(i32Ch) % PDMA_CH_MAX)                   /*!<Channel number within the controller  \hideinitializer */
+
 
 /*@}*/ /* end of group PDMA_EXPORTED_CONSTANTS */
 
@@ -1311,6 +1351,13 @@ void PDMA_EnableInt(PDMA_T * pdma,uint32_t u32Ch, uint32_t u32Mask);
 void PDMA_DisableInt(PDMA_T * pdma,uint32_t u32Ch, uint32_t u32Mask);
 void PDMA_SetStride(PDMA_T * pdma,uint32_t u32Ch, uint32_t u32DestLen, uint32_t u32SrcLen, uint32_t u32TransCount);
 
+int32_t PDMA_RequestChannel(uint32_t u32Peripheral, PDMA_CALLBACK_T pfnCallback, void *pvUserData);
+void PDMA_FreeChannel(int32_t i32Ch);
+int32_t PDMA_SubmitSG(int32_t i32Ch, uint32_t u32Ctl, const PDMA_SG_T *psList, uint32_t u32Num);
+int32_t PDMA_StartStream(int32_t i32Ch, uint32_t u32Ctl, const PDMA_SG_T *psPing, const PDMA_SG_T *psPong);
+void PDMA_StopChannel(int32_t i32Ch);
+uint32_t PDMA_IsChannelBusy(int32_t i32Ch);
+
 
 /*@}*/ /* end of group PDMA_EXPORTED_FUNCTIONS */
 
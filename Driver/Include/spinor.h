@@ -0,0 +1,107 @@
+/**************************************************************************//**
+ * @file     spinor.h
+ * @brief    NUC980 series SPI NOR flash driver header file
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#ifndef __SPINOR_H__
+#define __SPINOR_H__
+
+#include "qspi.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup SPINOR_Driver SPINOR Driver
+  @{
+*/
+
+/** @addtogroup SPINOR_EXPORTED_CONSTANTS SPINOR Exported Constants
+  @{
+*/
+
+#define SPINOR_OK               0           /*!< Operation done  \hideinitializer */
+#define SPINOR_ERR_ARG          -1          /*!< Address, length or alignment not supported by the flash  \hideinitializer */
+#define SPINOR_ERR_ID           -2          /*!< No flash answered the JEDEC ID command  \hideinitializer */
+
+#define SPINOR_IO_111           0           /*!< Fast read, opcode, address and data on one line  \hideinitializer */
+#define SPINOR_IO_114           1           /*!< Quad output read, data on four lines  \hideinitializer */
+#define SPINOR_IO_144           2           /*!< Quad I/O read, address and data on four lines  \hideinitializer */
+
+#define SPINOR_ERASE_TYPES      4           /*!< Erase sizes an SFDP table can describe  \hideinitializer */
+#define SPINOR_PDMA_MIN         256         /*!< Default of SPINOR_T::u32PdmaMin  \hideinitializer */
+
+#ifndef SPINOR_RESUME_HOLD_US
+#define SPINOR_RESUME_HOLD_US   100         /*!< Time an erase runs after a resume before it may be suspended again  \hideinitializer */
+#endif
+
+/*@}*/ /* end of group SPINOR_EXPORTED_CONSTANTS */
+
+/** @addtogroup SPINOR_EXPORTED_STRUCTS SPINOR Exported Structs
+  @{
+*/
+
+/**
+ * @brief   One flash on a QSPI port. Filled in by SPINOR_Open(), the geometry fields may be read
+ *          by the application, the others belong to the driver.
+ */
+typedef struct
+{
+    QSPI_T   *qspi;                             /*!< QSPI port, owned by the driver while open */
+    uint8_t   au8Id[3];                         /*!< JEDEC manufacturer and device ID */
+    uint8_t   u8Sfdp;                           /*!< 1 if the geometry came from the SFDP tables */
+    uint32_t  u32Size;                          /*!< Size in bytes */
+    uint32_t  u32PageSize;                      /*!< Program page size in bytes */
+    uint32_t  u32EraseSize;                     /*!< Smallest erase size in bytes */
+    uint32_t  au32EraseSize[SPINOR_ERASE_TYPES];/*!< Erase sizes in bytes, 0 if not supported */
+    uint8_t   au8EraseOp[SPINOR_ERASE_TYPES];   /*!< Erase opcode of each size */
+    uint8_t   u8ReadOp;                         /*!< Read opcode */
+    uint8_t   u8ReadIo;                         /*!< SPINOR_IO_xxx of the read opcode */
+    uint8_t   u8ReadWait;                       /*!< Mode and dummy clocks between address and data */
+    uint8_t   u8ProgramOp;                      /*!< Page program opcode */
+    uint8_t   u8AddrLen;                        /*!< Address bytes, 3 or 4 */
+    uint8_t   u8Qer;                            /*!< SFDP quad enable requirement, 0 if none */
+    uint8_t   u8SuspendOp;                      /*!< Erase suspend opcode, 0 if not supported */
+    uint8_t   u8ResumeOp;                       /*!< Erase resume opcode */
+    uint32_t  u32PdmaMin;                       /*!< Reads with at least this many word-aligned bytes use PDMA */
+    int32_t   i32TxCh;                          /*!< PDMA channel feeding clocks to QSPI TX, <0 if none */
+    int32_t   i32RxCh;                          /*!< PDMA channel draining QSPI RX, <0 if none */
+    uint32_t  u32EraseAddr;                     /*!< Block of the erase started by SPINOR_EraseStart() */
+    uint32_t  u32EraseLen;                      /*!< Its size, 0 while no erase is running */
+} SPINOR_T;
+
+/*@}*/ /* end of group SPINOR_EXPORTED_STRUCTS */
+
+/** @addtogroup SPINOR_EXPORTED_FUNCTIONS SPINOR Exported Functions
+  @{
+*/
+
+int32_t SPINOR_Open(SPINOR_T *psNor, QSPI_T *qspi, uint32_t u32BusClock);
+void SPINOR_Close(SPINOR_T *psNor);
+int32_t SPINOR_Read(SPINOR_T *psNor, uint32_t u32Addr, uint8_t *pu8Buf, uint32_t u32Len);
+int32_t SPINOR_Program(SPINOR_T *psNor, uint32_t u32Addr, const uint8_t *pu8Buf, uint32_t u32Len);
+int32_t SPINOR_Erase(SPINOR_T *psNor, uint32_t u32Addr, uint32_t u32Len);
+int32_t SPINOR_EraseStart(SPINOR_T *psNor, uint32_t u32Addr, uint32_t u32Len);
+uint32_t SPINOR_IsBusy(SPINOR_T *psNor);
+uint32_t SPINOR_ReadStatus(SPINOR_T *psNor);
+
+/*@}*/ /* end of group SPINOR_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group SPINOR_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__SPINOR_H__
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
@@ -155,6 +155,50 @@ typedef enum CLKn
 #define D_CACHE         7
 #define I_D_CACHE       8
 
+#define SYS_DCACHE_LINE_SIZE    32          /*!< ARM926EJ-S D-cache line size in bytes  */
+#define SYS_DCACHE_SIZE         (16*1024)   /*!< D-cache size in bytes  */
+#define SYS_ICACHE_LINE_SIZE    32          /*!< ARM926EJ-S I-cache line size in bytes  */
+#define SYS_ICACHE_WAY_SIZE     (4*1024)    /*!< One of the 4 I-cache ways, the most sysLockFastCode() can hold  */
+
+/* Hot-path placement. Code marked SYS_FASTCODE is linked into one block (.fastcode,
+   see GCC.ld and nuc980.sct) that sysLockFastCode() keeps in I-cache way 3. The linker
+   scripts stop the block from growing past the 4 KB way, so mark only interrupt entry
+   paths that do their work in place, not handlers that call into larger code. Data marked
+   SYS_FASTDATA is grouped in cache line aligned .fastdata next to the other RW data. */
+#define SYS_FASTCODE            __attribute__((section(".fastcode")))
+#define SYS_FASTDATA            __attribute__((section(".fastdata")))
+
+/* Memory attributes of sysMMURegionTable[] entries */
+#define SYS_MMU_NC              0x000       /*!< Non-cacheable, non-bufferable  */
+#define SYS_MMU_WT              0x008       /*!< Cacheable, write-through  */
+#define SYS_MMU_WB              0x00C       /*!< Cacheable, write-back  */
+#define SYS_MMU_CACHED          0x100       /*!< Write-back or write-through as passed to sysEnableCache()  */
+#define SYS_MMU_XN              0x200       /*!< Data only. ARM926EJ-S has no execute-never, the flag documents intent  */
+#define SYS_MMU_SDRAM_SIZE      0xFFFFFFFF  /*!< Region size: the SDRAM size found by sysGetSdramSizebyMB()  */
+
+/** \brief  Flat mapped memory region with its attributes
+ */
+typedef struct
+{
+    UINT32  u32Base;    /*!< Start address, 64 KB aligned */
+    UINT32  u32Size;    /*!< Size in bytes, multiple of 64 KB, or \ref SYS_MMU_SDRAM_SIZE. 0 ends the table */
+    UINT32  u32Attr;    /*!< \ref SYS_MMU_NC, \ref SYS_MMU_WT, \ref SYS_MMU_WB or \ref SYS_MMU_CACHED, optionally with \ref SYS_MMU_XN */
+} SYS_MMU_REGION_T;
+
+#define SYS_IRQ_NEST_MAX        8           /*!< Nesting depth tracked by the nested IRQ dispatcher  */
+
+/** \brief  Statistics of the nested IRQ dispatcher, see sysEnableNestedIrq()
+ */
+typedef struct
+{
+    UINT32  u32Count[64];       /*!< Entries per interrupt source */
+    UINT32  u32MaxTime[64];     /*!< Longest run per source in clock ticks, nested ISRs excluded. 0 without a clock */
+    UINT32  u32LevelMaxDepth[8];/*!< Deepest nesting seen while an ISR of the level was running */
+    UINT32  u32MaxDepth;        /*!< Deepest nesting seen */
+    UINT32  u32Inversion;       /*!< Nested ISRs whose level was not above all running ones. Must stay 0 */
+    UINT32  u32Spurious;        /*!< Entries without a pending source */
+} SYS_IRQ_STAT_T;
+
 
 /// @endcond HIDDEN_SYMBOLS
 
@@ -801,6 +845,10 @@ INT32   sysSetGlobalInterrupt (INT32 nIntState);
 INT32   sysSetInterruptPriorityLevel (IRQn_Type eIntNo, UINT32 uIntLevel);
 INT32   sysSetInterruptType (IRQn_Type eIntNo, UINT32 uIntSourceType);
 INT32   sysSetLocalInterrupt (INT32 nIntState);
+void    sysEnableNestedIrq (BOOL bEnable);
+void    sysSetIrqStatClock (UINT32 (*pfnClock)(void), UINT32 u32Mask);
+void    sysGetIrqStat (SYS_IRQ_STAT_T *pStat, BOOL bReset);
+PVOID   sysInstallFastISR (IRQn_Type eIntNo, PVOID pvFiqHandler);
 
 
 /* Define system library Cache functions */
@@ -810,9 +858,74 @@ void    sysFlushCache(INT32 nCacheType);
 BOOL    sysGetCacheState(void);
 INT32   sysGetSdramSizebyMB(void);
 void    sysInvalidCache(void);
+void    sysCleanDCacheRange(UINT32 u32Addr, UINT32 u32Size);
+void    sysInvalidateDCacheRange(UINT32 u32Addr, UINT32 u32Size);
+void    sysCleanInvalidateDCacheRange(UINT32 u32Addr, UINT32 u32Size);
+void    sysDrainWriteBuffer(void);
+INT32   sysLockFastCode(void);
+void    sysUnlockFastCode(void);
+UINT32  sysGetFastCodeSize(void);
+
+/* Define system library memory functions (memops.c). The checksums are the folded,
+   uninverted 16-bit one's complement sums lwIP expects from LWIP_CHKSUM and LWIP_CHKSUM_COPY. */
+void    sysMemCopy(void *pvDst, const void *pvSrc, UINT32 u32Len);
+void    sysMemSet(void *pvDst, INT32 i32Val, UINT32 u32Len);
+UINT16  sysChksum(const void *pvData, INT32 i32Len);
+UINT16  sysChksumCopy(void *pvDst, const void *pvSrc, UINT16 u16Len);
+
+/* Define system library profiling probes (prof.c). A probe times one code path against the
+   free-running ETIMER4 and keeps the count, total, min, max and a log2 histogram of the
+   durations in timer ticks. The SYS_PROF_xxx macros compile to nothing unless the project
+   defines SYS_PROF_ENABLE. */
+#define SYS_PROF_BINS           25          /*!< Histogram bins: 0 ticks, then [2^(n-1), 2^n) ticks for n = 1..24  */
+#define SYS_PROF_TICK_MASK      0xFFFFFF    /*!< ETIMER counters are 24 bits wide, longer spans wrap  */
+
+#ifndef SYS_PROF_CLOCK
+#define SYS_PROF_CLOCK()        inpw(REG_ETMR4_DR)  /*!< Tick source, a host build may supply its own  */
+#endif
+
+typedef struct sys_prof_t
+{
+    const char  *pcName;
+    UINT32      u32Start;                   /* Stamp of the last SYS_PROF_BEGIN() */
+    UINT32      u32Count;
+    UINT32      u32Min;
+    UINT32      u32Max;
+    UINT64      u64Total;
+    UINT32      au32Hist[SYS_PROF_BINS];
+    UINT32      u32Listed;                  /* Linked into the probe list by the first record */
+    struct sys_prof_t *psNext;
+} SYS_PROF_T;
+
+#ifdef SYS_PROF_ENABLE
+#define SYS_PROF_DEFINE(probe, name)    static SYS_PROF_T probe = { name };
+#define SYS_PROF_BEGIN(probe)           ((probe).u32Start = SYS_PROF_CLOCK())
+#define SYS_PROF_END(probe)             sysProfAdd(&(probe), SYS_PROF_CLOCK() - (probe).u32Start)
+#define SYS_PROF_STAMP(u32Var)          ((u32Var) = SYS_PROF_CLOCK())
+#define SYS_PROF_SINCE(probe, u32Var)   sysProfAdd(&(probe), SYS_PROF_CLOCK() - (u32Var))
+#else
+#define SYS_PROF_DEFINE(probe, name)
+#define SYS_PROF_BEGIN(probe)           ((void)0)
+#define SYS_PROF_END(probe)             ((void)0)
+#define SYS_PROF_STAMP(u32Var)          ((void)0)
+#define SYS_PROF_SINCE(probe, u32Var)   ((void)0)
+#endif
+
+void    sysProfInit(void);
+void    sysProfAdd(SYS_PROF_T *psProbe, UINT32 u32Ticks);
+UINT32  sysProfGetBin(UINT32 u32Ticks);
+UINT32  sysProfGetTickRate(void);
+void    sysProfReset(void);
+void    sysProfDump(void);
 
 UINT32 sysGetClock(CLK_Type clk);
 
+/* Memory map used by sysEnableCache(). Regions are applied in order, later ones override
+   earlier ones. Whole megabytes are mapped with 1 MB sections, the rest with 64 KB large
+   pages; memory not listed is non-cacheable. The library has a weak default (the first
+   128 MB write-back); an application defines its own table to replace it. */
+extern const SYS_MMU_REGION_T sysMMURegionTable[];
+
 typedef void (*sys_pvFunPtr)();   /* function pointer */
 extern sys_pvFunPtr sysIrqHandlerTable[];
 extern UINT32 volatile _sys_bIsAICInitial;
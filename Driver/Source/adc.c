@@ -232,7 +232,8 @@ void adcISR(void)
 
     if((isr & ADC_ISR_NACF) && (conf & ADC_CONF_NACEN))
     {
-        outpw(REG_ADC_ISR,ADC_ISR_NACF);
+        /* Clear both flags first, the callback may start the next conversion */
+        outpw(REG_ADC_ISR,ADC_ISR_NACF|(isr & ADC_ISR_MF));
         if(adcHandler.normal_callback!=NULL)
             adcHandler.normal_callback(inpw(REG_ADC_DATA), adcHandler.normal_userData);
         DbgPrintf("normal AD conversion complete\n");
@@ -240,7 +241,8 @@ void adcISR(void)
 
     if(isr & ADC_ISR_MF)
     {
-        outpw(REG_ADC_ISR,ADC_ISR_MF);
+        if(!((isr & ADC_ISR_NACF) && (conf & ADC_CONF_NACEN)))
+            outpw(REG_ADC_ISR,ADC_ISR_MF);
         mst_complete=1;
         DbgPrintf("menu complete\n");
     }
@@ -0,0 +1,402 @@
+/**************************************************************************//**
+ * @file     adcscan.c
+ * @brief    NUC980 continuous multi-channel ADC acquisition
+ *
+ * A scan list holds up to ADC_SCAN_SLOT_MAX conversions, any channel in any
+ * order, a channel listed twice is sampled twice per scan. An ETIMER in
+ * periodic mode starts a scan each tick, or with ADC_SCAN_FREE_RUN each scan
+ * starts as soon as the last one ends, the highest sustained rate.
+ *
+ * The ADC of the NUC980 has no PDMA request and no hardware trigger, so the
+ * conversions are chained by the ADC interrupt: the normal conversion
+ * callback of adc.c starts the conversion of the next slot first, so it runs
+ * while the result is stored, and then pushes the result into the ring of
+ * its channel. A timer tick that finds the last scan still converting is
+ * counted in u32Missed; a sample that finds its ring full is dropped and
+ * counted in u32Overruns of the channel.
+ *
+ * Each channel may decimate through a CIC filter of order 1 to 3, order 1
+ * being a moving average of u32Decim conversions. The integrators run in the
+ * interrupt at the conversion rate and the combs at the sample rate, in
+ * 32-bit wrapping arithmetic, which is exact while u32Decim^u32Order is at
+ * most 2^20.
+ *
+ * The rings have one producer, the interrupt, and one reader. The interrupt
+ * alone writes u32Head, after the sample; the reader alone writes u32Tail.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+#include "adc.h"
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup ADC_Driver ADC Driver
+  @{
+*/
+
+/// @cond HIDDEN_SYMBOLS
+
+/* The ADC has one conversion engine, so there is one scan */
+static ADC_SCAN_T *s_psScan;
+
+static const IRQn_Type s_aeTimerIrq[] = { IRQ_TIMER0, IRQ_TIMER1, IRQ_TIMER2, IRQ_TIMER3, IRQ_TIMER4, IRQ_TIMER5 };
+
+static __inline uint32_t scan_clock(ADC_SCAN_T *psScan)
+{
+    return psScan->pfnClock ? psScan->pfnClock() : 0;
+}
+
+/* Start the conversion of a slot */
+static __inline void scan_convert(ADC_SCAN_T *psScan, uint32_t u32Slot)
+{
+    psScan->u32Slot = u32Slot;
+    outpw(REG_ADC_CONF, psScan->au32Conf[u32Slot]);
+    outpw(REG_ADC_CTL, psScan->u32Ctl);
+}
+
+/* Filter a 12-bit result and store the sample it completes */
+static void scan_push(ADC_SCAN_CH_T *psCh, uint32_t u32Data)
+{
+    uint32_t u32Head, y, t, k;
+
+    psCh->u32Conversions++;
+    if (psCh->u32Decim > 1)
+    {
+        y = u32Data;
+        for (k = 0; k < psCh->u32Order; k++)
+            y = psCh->au32Int[k] += y;
+        if (++psCh->u32Phase < psCh->u32Decim)
+            return;
+        psCh->u32Phase = 0;
+        for (k = 0; k < psCh->u32Order; k++)
+        {
+            t = y;
+            y -= psCh->au32Comb[k];
+            psCh->au32Comb[k] = t;
+        }
+        /* Remove the gain and keep 4 fraction bits, rounded. The quotient and the remainder
+           are scaled apart, as y * 16 may not fit in 32 bits and the remainder times 32 does */
+        t = y / psCh->u32Gain;
+        u32Data = (t << 4) + (((y - t * psCh->u32Gain) << 5) + psCh->u32Gain) / (psCh->u32Gain << 1);
+    }
+    else
+        u32Data <<= 4;
+
+    u32Head = psCh->u32Head;
+    if (u32Head - psCh->u32Tail == psCh->u32Size)
+    {
+        psCh->u32Overruns++;
+        return;
+    }
+    psCh->pu16Buf[u32Head & (psCh->u32Size - 1)] = (uint16_t)u32Data;
+    psCh->u32Head = u32Head + 1;
+}
+
+/* Normal conversion callback of adcISR(), status is ADC_DATA */
+static INT32 scan_adc_callback(UINT32 status, UINT32 userData)
+{
+    ADC_SCAN_T *psScan = (ADC_SCAN_T *)userData;
+    uint32_t t0 = scan_clock(psScan), u32Slot = psScan->u32Slot;
+
+    /* Next conversion first, it runs while this result is filtered */
+    if (u32Slot + 1 < psScan->u32Slots)
+        scan_convert(psScan, u32Slot + 1);
+    else
+    {
+        psScan->u32Scans++;
+        if (psScan->u32Run && (psScan->u32Timer == ADC_SCAN_FREE_RUN))
+            scan_convert(psScan, 0);
+        else
+            psScan->u32Busy = 0;
+    }
+
+    scan_push(psScan->apsCh[u32Slot], status & 0xFFF);
+    psScan->u32Ticks += (scan_clock(psScan) - t0) & psScan->u32ClockMask;
+    return 0;
+}
+
+static void scan_timer_isr(void)
+{
+    ADC_SCAN_T *psScan = s_psScan;
+    uint32_t t0 = scan_clock(psScan);
+
+    ETIMER_ClearIntFlag(psScan->u32Timer);
+    if (psScan->u32Busy)
+        psScan->u32Missed++;
+    else
+    {
+        psScan->u32Busy = 1;
+        scan_convert(psScan, 0);
+    }
+    psScan->u32Ticks += (scan_clock(psScan) - t0) & psScan->u32ClockMask;
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/** @addtogroup ADC_EXPORTED_FUNCTIONS ADC Exported Functions
+  @{
+*/
+
+/**
+ * @brief       Empty a scan list
+ *
+ * @param[in]   psScan  Scan list
+ *
+ * @return      None
+ */
+void adcScanInit(ADC_SCAN_T *psScan)
+{
+    sysMemSet(psScan, 0, sizeof(ADC_SCAN_T));
+    psScan->u32Timer = ADC_SCAN_FREE_RUN;
+}
+
+/**
+ * @brief       Add a channel with its sample ring to a scan list
+ *
+ * @param[in]   psScan   Scan list
+ * @param[in]   psCh     Channel state
+ * @param[in]   channel  ADC input, 0 ~ 7 for the external inputs, 8 for Vref
+ * @param[in]   pu16Buf  Sample ring
+ * @param[in]   u32Size  Samples in pu16Buf, a power of 2
+ *
+ * @retval      0               Success
+ * @retval      ADC_ERR_ARGS    Invalid argument or the list is full
+ * @retval      ADC_ERR_BUSY    The scan is running
+ *
+ * @details     The channel takes the next slot of the scan, without decimation.
+ */
+int adcScanAddChannel(ADC_SCAN_T *psScan, ADC_SCAN_CH_T *psCh, int channel, uint16_t *pu16Buf, uint32_t u32Size)
+{
+    if ((u32Size == 0) || (u32Size & (u32Size - 1)))
+        return ADC_ERR_ARGS;
+
+    sysMemSet(psCh, 0, sizeof(ADC_SCAN_CH_T));
+    psCh->pu16Buf = pu16Buf;
+    psCh->u32Size = u32Size;
+    psCh->u32Decim = 1;
+    psCh->u32Order = 1;
+    return adcScanAddSlot(psScan, psCh, channel);
+}
+
+/**
+ * @brief       Sample a channel added by adcScanAddChannel() once more per scan
+ *
+ * @param[in]   psScan   Scan list
+ * @param[in]   psCh     Channel state
+ * @param[in]   channel  ADC input of the new slot, normally that of psCh
+ *
+ * @retval      0               Success
+ * @retval      ADC_ERR_ARGS    Invalid argument or the list is full
+ * @retval      ADC_ERR_BUSY    The scan is running
+ *
+ * @details     Spreading the slots of a channel over the list gives it evenly spaced
+ *              samples at a multiple of the scan rate.
+ */
+int adcScanAddSlot(ADC_SCAN_T *psScan, ADC_SCAN_CH_T *psCh, int channel)
+{
+    if (psScan->u32Run)
+        return ADC_ERR_BUSY;
+    if ((channel < 0) || (channel > 8) || (psScan->u32Slots >= ADC_SCAN_SLOT_MAX))
+        return ADC_ERR_ARGS;
+
+    psScan->apsCh[psScan->u32Slots] = psCh;
+    psScan->au32Conf[psScan->u32Slots] = (uint32_t)channel << ADC_CONF_CHSEL_Pos;
+    psScan->u32Slots++;
+    return Successful;
+}
+
+/**
+ * @brief       Set the decimation filter of a channel
+ *
+ * @param[in]   psCh      Channel state
+ * @param[in]   u32Decim  Conversions per sample, 1 ~ \ref ADC_SCAN_DECIM_MAX, 1 for no filter
+ * @param[in]   u32Order  CIC filter order, 1 ~ \ref ADC_SCAN_ORDER_MAX, 1 for a moving average
+ *
+ * @retval      0               Success
+ * @retval      ADC_ERR_ARGS    Invalid argument, or u32Decim^u32Order above 2^20
+ *
+ * @details     Call while the scan is stopped. The filter restarts empty, so the first
+ *              u32Order - 1 samples are still filling it. Samples keep the scale of the
+ *              undecimated ones, the 12-bit result times 16.
+ */
+int adcScanSetDecimation(ADC_SCAN_CH_T *psCh, uint32_t u32Decim, uint32_t u32Order)
+{
+    uint32_t u32Gain = 1, k;
+
+    if ((u32Decim == 0) || (u32Decim > ADC_SCAN_DECIM_MAX) || (u32Order == 0) || (u32Order > ADC_SCAN_ORDER_MAX))
+        return ADC_ERR_ARGS;
+    for (k = 0; k < u32Order; k++)
+        u32Gain *= u32Decim;
+    if (u32Gain > (1UL << 20))
+        return ADC_ERR_ARGS;
+
+    psCh->u32Decim = u32Decim;
+    psCh->u32Order = u32Order;
+    psCh->u32Gain = u32Gain;
+    psCh->u32Phase = 0;
+    for (k = 0; k < ADC_SCAN_ORDER_MAX; k++)
+    {
+        psCh->au32Int[k] = 0;
+        psCh->au32Comb[k] = 0;
+    }
+    return Successful;
+}
+
+/**
+ * @brief       Measure the time spent in the scan interrupts
+ *
+ * @param[in]   psScan    Scan list
+ * @param[in]   pfnClock  Free-running counter, ETIMER_GetCounter() of a continuous timer for
+ *                        example, NULL for none
+ * @param[in]   u32Mask   Valid bits of pfnClock(), 0xFFFFFF for an ETIMER
+ *
+ * @return      None
+ *
+ * @details     u32Ticks sums the time from the entry to the exit of the scan code in both
+ *              interrupts; the interrupt entry and adcISR() itself are not included.
+ */
+void adcScanSetClock(ADC_SCAN_T *psScan, uint32_t (*pfnClock)(void), uint32_t u32Mask)
+{
+    psScan->pfnClock = pfnClock;
+    psScan->u32ClockMask = u32Mask;
+}
+
+/**
+ * @brief       Start scanning
+ *
+ * @param[in]   psScan       Scan list
+ * @param[in]   u32Timer     ETIMER starting the scans, 0 ~ 5, with its engine clock enabled,
+ *                           or \ref ADC_SCAN_FREE_RUN
+ * @param[in]   u32ScanRate  Scans per second, ignored for \ref ADC_SCAN_FREE_RUN
+ *
+ * @retval      0               Success
+ * @retval      ADC_ERR_ARGS    Invalid argument or an empty list
+ * @retval      ADC_ERR_BUSY    A scan is running
+ *
+ * @details     The ADC must be opened by adcOpen() or adcOpen2(); the engine clock given there
+ *              sets the conversion time. Normal conversion is enabled with the AVDD33 reference
+ *              and the interrupt of the timer installed at the level of the ADC interrupt, so
+ *              the two never nest. adcIoctl(START_MST) may not be used while scanning.
+ */
+int adcScanStart(ADC_SCAN_T *psScan, uint32_t u32Timer, uint32_t u32ScanRate)
+{
+    uint32_t u32Conf, i;
+
+    if (s_psScan != NULL)
+        return ADC_ERR_BUSY;
+    if ((psScan->u32Slots == 0) ||
+            ((u32Timer != ADC_SCAN_FREE_RUN) && ((u32Timer >= sizeof(s_aeTimerIrq) / sizeof(s_aeTimerIrq[0])) || (u32ScanRate == 0))))
+        return ADC_ERR_ARGS;
+
+    adcIoctl(NAC_ON, (INT32)scan_adc_callback, (INT32)psScan);
+    u32Conf = inpw(REG_ADC_CONF) & ~ADC_CONF_CHSEL_Msk;
+    for (i = 0; i < psScan->u32Slots; i++)
+        psScan->au32Conf[i] = (psScan->au32Conf[i] & ADC_CONF_CHSEL_Msk) | u32Conf;
+    outpw(REG_ADC_IER, inpw(REG_ADC_IER) | ADC_IER_MIEN);
+    psScan->u32Ctl = inpw(REG_ADC_CTL) | ADC_CTL_MST;
+
+    psScan->u32Timer = u32Timer;
+    psScan->u32Busy = 0;
+    psScan->u32Run = 1;
+    s_psScan = psScan;
+
+    if (u32Timer == ADC_SCAN_FREE_RUN)
+    {
+        psScan->u32Busy = 1;
+        scan_convert(psScan, 0);
+        return Successful;
+    }
+
+    ETIMER_Open(u32Timer, ETIMER_PERIODIC_MODE, u32ScanRate);
+    ETIMER_EnableInt(u32Timer);
+    sysInstallISR(IRQ_LEVEL_7, s_aeTimerIrq[u32Timer], (PVOID)scan_timer_isr);
+    sysSetLocalInterrupt(ENABLE_IRQ);
+    sysEnableInterrupt(s_aeTimerIrq[u32Timer]);
+    ETIMER_Start(u32Timer);
+    return Successful;
+}
+
+/**
+ * @brief       Stop scanning
+ *
+ * @param[in]   psScan  Scan list
+ *
+ * @return      None
+ *
+ * @details     The scan converting is completed first. Samples already in the rings stay
+ *              readable.
+ */
+void adcScanStop(ADC_SCAN_T *psScan)
+{
+    if (s_psScan != psScan)
+        return;
+
+    psScan->u32Run = 0;
+    if (psScan->u32Timer != ADC_SCAN_FREE_RUN)
+    {
+        ETIMER_Stop(psScan->u32Timer);
+        ETIMER_DisableInt(psScan->u32Timer);
+        sysDisableInterrupt(s_aeTimerIrq[psScan->u32Timer]);
+    }
+    while (psScan->u32Busy);
+
+    adcIoctl(NAC_OFF, 0, 0);
+    s_psScan = NULL;
+}
+
+/**
+ * @brief       Samples waiting in the ring of a channel
+ *
+ * @param[in]   psCh  Channel state
+ *
+ * @return      Samples
+ */
+uint32_t adcScanCount(ADC_SCAN_CH_T *psCh)
+{
+    return psCh->u32Head - psCh->u32Tail;
+}
+
+/**
+ * @brief       Read samples of a channel, as many as there are
+ *
+ * @param[in]   psCh        Channel state
+ * @param[out]  pu16Dst     Samples, the 12-bit result times 16
+ * @param[in]   u32Samples  Samples to read
+ *
+ * @return      Samples read
+ *
+ * @details     Only one reader may call this per channel; it may run while the scan does.
+ */
+uint32_t adcScanRead(ADC_SCAN_CH_T *psCh, uint16_t *pu16Dst, uint32_t u32Samples)
+{
+    uint32_t u32Tail = psCh->u32Tail;
+    uint32_t u32Count = psCh->u32Head - u32Tail;
+    uint32_t u32Idx = u32Tail & (psCh->u32Size - 1), u32Part;
+
+    if (u32Samples > u32Count)
+        u32Samples = u32Count;
+    u32Part = psCh->u32Size - u32Idx;
+    if (u32Part > u32Samples)
+        u32Part = u32Samples;
+
+    if (u32Part)
+        sysMemCopy(pu16Dst, &psCh->pu16Buf[u32Idx], u32Part * 2);
+    if (u32Samples > u32Part)
+        sysMemCopy(pu16Dst + u32Part, psCh->pu16Buf, (u32Samples - u32Part) * 2);
+
+    psCh->u32Tail = u32Tail + u32Samples;
+    return u32Samples;
+}
+
+/*@}*/ /* end of group ADC_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group ADC_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
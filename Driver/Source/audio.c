@@ -0,0 +1,517 @@
+/**************************************************************************//**
+ * @file     audio.c
+ * @brief    NUC980 I2S audio pipeline: PCM FIFOs and period based DMA
+ *
+ * The play and record DMA buffers are split into 2, 4 or 8 periods, one DMA
+ * interrupt each (I2S_DMA_INT_HALF, _QUARTER or _EIGHTH). When the DMA leaves
+ * a play period the interrupt mixes every enabled stream into it with
+ * i2sPcmMix16(); when it leaves a record period the interrupt moves it into
+ * the record FIFO. The period to service is found from the DMA current
+ * address, so a late interrupt services every period the DMA has passed and
+ * is counted, instead of refilling the period that is playing.
+ *
+ * The FIFOs have one producer and one consumer. The producer alone writes
+ * u32Head, after the data; the consumer alone writes u32Tail, after it is
+ * done with the data. The ARM926EJ-S is a single in-order core, so either
+ * side can be the interrupt and no lock is taken.
+ *
+ * Streams are 16-bit stereo whatever the I2S data width; 24-bit data is
+ * converted in the interrupt.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+
+#include "nuc980.h"
+#include "sys.h"
+#include "i2s.h"
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup I2S_Driver I2S Driver
+  @{
+*/
+
+/// @cond HIDDEN_SYMBOLS
+
+/* The I2S has one play and one record DMA, so there is one pipeline */
+static I2S_PIPE_T *s_psPipe;
+
+static __inline uint32_t pipe_clock(I2S_PIPE_T *psPipe)
+{
+    return psPipe->pfnClock ? psPipe->pfnClock() : 0;
+}
+
+/* Period the DMA is working on */
+static uint32_t pipe_dma_period(I2S_PIPE_T *psPipe, uint32_t u32Cur, uint32_t *pu32Base)
+{
+    /* Either address may be the non-cacheable alias */
+    u32Cur = ((u32Cur - (uint32_t)pu32Base) & 0x7FFFFFFF) / psPipe->u32PeriodBytes;
+    return u32Cur & (psPipe->u32Periods - 1);
+}
+
+static uint32_t pipe_play_callback(uint32_t u32Sn)
+{
+    I2S_PIPE_T *psPipe = s_psPipe;
+    uint32_t t0 = pipe_clock(psPipe), u32Cur, u32Count = 0;
+
+    psPipe->u32Elapsed += (t0 - psPipe->u32LastTime) & psPipe->u32ClockMask;
+    psPipe->u32LastTime = t0;
+
+    /* Fill every period behind the DMA, normally the one it has just left */
+    u32Cur = pipe_dma_period(psPipe, inpw(REG_I2S_PDESC), psPipe->pu32Play);
+    while (psPipe->u32PlayNext != u32Cur)
+    {
+        i2sPipePlayPeriod(psPipe, psPipe->u32PlayNext);
+        psPipe->u32PlayNext = (psPipe->u32PlayNext + 1) & (psPipe->u32Periods - 1);
+        u32Count++;
+    }
+    if (u32Count != 1)
+        psPipe->u32PlayLate++;
+
+    psPipe->u32Ticks += (pipe_clock(psPipe) - t0) & psPipe->u32ClockMask;
+    return 0;
+}
+
+static uint32_t pipe_rec_callback(uint32_t u32Sn)
+{
+    I2S_PIPE_T *psPipe = s_psPipe;
+    uint32_t t0 = pipe_clock(psPipe), u32Cur, u32Count = 0;
+
+    u32Cur = pipe_dma_period(psPipe, inpw(REG_I2S_RDESC), psPipe->pu32Rec);
+    while (psPipe->u32RecNext != u32Cur)
+    {
+        i2sPipeRecPeriod(psPipe, psPipe->u32RecNext);
+        psPipe->u32RecNext = (psPipe->u32RecNext + 1) & (psPipe->u32Periods - 1);
+        u32Count++;
+    }
+    if (u32Count != 1)
+        psPipe->u32RecLate++;
+
+    psPipe->u32Ticks += (pipe_clock(psPipe) - t0) & psPipe->u32ClockMask;
+    return 0;
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/** @addtogroup ARM9_I2S_EXPORTED_FUNCTIONS I2S Exported Functions
+  @{
+*/
+
+/**
+ * @brief     Set up an empty FIFO
+ *
+ * @param[in]  psFifo: FIFO
+ *
+ * @param[in]  pu32Buf: Storage, one word per frame
+ *
+ * @param[in]  u32Size: Frames in pu32Buf, a power of 2
+ *
+ * @return    None
+ */
+void i2sFifoInit(I2S_FIFO_T *psFifo, uint32_t *pu32Buf, uint32_t u32Size)
+{
+    psFifo->pu32Buf = pu32Buf;
+    psFifo->u32Size = u32Size;
+    psFifo->u32Head = 0;
+    psFifo->u32Tail = 0;
+}
+
+/**
+ * @brief     Frames that can be read
+ *
+ * @param[in]  psFifo: FIFO
+ *
+ * @return    Frames
+ */
+uint32_t i2sFifoCount(I2S_FIFO_T *psFifo)
+{
+    return psFifo->u32Head - psFifo->u32Tail;
+}
+
+/**
+ * @brief     Frames that can be written
+ *
+ * @param[in]  psFifo: FIFO
+ *
+ * @return    Frames
+ */
+uint32_t i2sFifoSpace(I2S_FIFO_T *psFifo)
+{
+    return psFifo->u32Size - (psFifo->u32Head - psFifo->u32Tail);
+}
+
+/**
+ * @brief     Write frames, as many as fit
+ *
+ * @param[in]  psFifo: FIFO
+ *
+ * @param[in]  pu32Src: Frames
+ *
+ * @param[in]  u32Frames: Frames to write
+ *
+ * @return    Frames written
+ *
+ * @details   Only the producer of the FIFO may call this.
+ */
+uint32_t i2sFifoWrite(I2S_FIFO_T *psFifo, const uint32_t *pu32Src, uint32_t u32Frames)
+{
+    uint32_t u32Head = psFifo->u32Head;
+    uint32_t u32Space = psFifo->u32Size - (u32Head - psFifo->u32Tail);
+    uint32_t u32Idx = u32Head & (psFifo->u32Size - 1), u32Part;
+
+    if (u32Frames > u32Space)
+        u32Frames = u32Space;
+    u32Part = psFifo->u32Size - u32Idx;
+    if (u32Part > u32Frames)
+        u32Part = u32Frames;
+
+    if (u32Part)
+        sysMemCopy(&psFifo->pu32Buf[u32Idx], pu32Src, u32Part * 4);
+    if (u32Frames > u32Part)
+        sysMemCopy(psFifo->pu32Buf, pu32Src + u32Part, (u32Frames - u32Part) * 4);
+
+    psFifo->u32Head = u32Head + u32Frames;
+    return u32Frames;
+}
+
+/**
+ * @brief     Read frames, as many as there are
+ *
+ * @param[in]  psFifo: FIFO
+ *
+ * @param[out] pu32Dst: Frames
+ *
+ * @param[in]  u32Frames: Frames to read
+ *
+ * @return    Frames read
+ *
+ * @details   Only the consumer of the FIFO may call this.
+ */
+uint32_t i2sFifoRead(I2S_FIFO_T *psFifo, uint32_t *pu32Dst, uint32_t u32Frames)
+{
+    uint32_t u32Tail = psFifo->u32Tail;
+    uint32_t u32Count = psFifo->u32Head - u32Tail;
+    uint32_t u32Idx = u32Tail & (psFifo->u32Size - 1), u32Part;
+
+    if (u32Frames > u32Count)
+        u32Frames = u32Count;
+    u32Part = psFifo->u32Size - u32Idx;
+    if (u32Part > u32Frames)
+        u32Part = u32Frames;
+
+    if (u32Part)
+        sysMemCopy(pu32Dst, &psFifo->pu32Buf[u32Idx], u32Part * 4);
+    if (u32Frames > u32Part)
+        sysMemCopy(pu32Dst + u32Part, psFifo->pu32Buf, (u32Frames - u32Part) * 4);
+
+    psFifo->u32Tail = u32Tail + u32Frames;
+    return u32Frames;
+}
+
+/**
+ * @brief     Set up the audio pipeline on the DMA of an opened I2S
+ *
+ * @param[in]  psPipe: Pipeline
+ *
+ * @param[in]  u32Width: \ref I2S_BIT_WIDTH_16 or \ref I2S_BIT_WIDTH_24
+ *
+ * @param[in]  u32Periods: Periods per DMA buffer, 2, 4 or 8
+ *
+ * @param[in]  u32PeriodFrames: Stereo frames per period, a multiple of 8
+ *
+ * @param[in]  pu32Play: Play DMA buffer, 32-byte aligned, u32Periods * u32PeriodFrames frames
+ *                       of 4 bytes (16-bit) or 8 bytes (24-bit)
+ *
+ * @param[in]  pu32Rec: Record DMA buffer of the same size and alignment, NULL for none
+ *
+ * @param[in]  pi32Mix: Mix accumulator, 2 * u32PeriodFrames words
+ *
+ * @retval    0 Success
+ * @retval    I2S_ERR_IO Invalid argument
+ *
+ * @details   Sets the data width, the DMA buffers and interrupt selection and installs the
+ *            play and record call-back functions. The channel, format and clock settings are
+ *            left to the caller. The pipeline has no streams and no record FIFO yet.
+ */
+int32_t i2sPipeInit(I2S_PIPE_T *psPipe, uint32_t u32Width, uint32_t u32Periods, uint32_t u32PeriodFrames,
+                    uint32_t *pu32Play, uint32_t *pu32Rec, int32_t *pi32Mix)
+{
+    uint32_t u32Sel, u32Len;
+
+    if (u32Periods == 2)
+        u32Sel = I2S_DMA_INT_HALF;
+    else if (u32Periods == 4)
+        u32Sel = I2S_DMA_INT_QUARTER;
+    else if (u32Periods == 8)
+        u32Sel = I2S_DMA_INT_EIGHTH;
+    else
+        return I2S_ERR_IO;
+
+    if (((u32Width != I2S_BIT_WIDTH_16) && (u32Width != I2S_BIT_WIDTH_24)) ||
+            (u32PeriodFrames == 0) || (u32PeriodFrames & 7) || (pi32Mix == NULL) ||
+            (pu32Play == NULL) || ((uint32_t)pu32Play & 31) || ((uint32_t)pu32Rec & 31))
+        return I2S_ERR_IO;
+
+    psPipe->pu32Play = pu32Play;
+    psPipe->pu32Rec = pu32Rec;
+    psPipe->pi32Mix = pi32Mix;
+    psPipe->u32Width = u32Width;
+    psPipe->u32Periods = u32Periods;
+    psPipe->u32PeriodFrames = u32PeriodFrames;
+    psPipe->u32PeriodBytes = u32PeriodFrames * ((u32Width == I2S_BIT_WIDTH_16) ? 4 : 8);
+    psPipe->u32Streams = 0;
+    psPipe->psRecFifo = NULL;
+    psPipe->pfnClock = NULL;
+    psPipe->u32ClockMask = 0;
+    s_psPipe = psPipe;
+
+    u32Len = u32Periods * psPipe->u32PeriodBytes;
+    i2sIoctl(I2S_SELECT_BIT, u32Width, 0);
+    i2sIoctl(I2S_SET_PLAY_DMA_INT_SEL, u32Sel, 0);
+    i2sIoctl(I2S_SET_DMA_ADDRESS, I2S_PLAY, (uint32_t)pu32Play);
+    i2sIoctl(I2S_SET_DMA_LENGTH, I2S_PLAY, u32Len);
+    i2sIoctl(I2S_SET_I2S_CALLBACKFUN, I2S_PLAY, (uint32_t)pipe_play_callback);
+    if (pu32Rec != NULL)
+    {
+        /* Lines the CPU left dirty must not be written back over recorded data */
+        sysInvalidateDCacheRange((uint32_t)pu32Rec, u32Len);
+        i2sIoctl(I2S_SET_REC_DMA_INT_SEL, u32Sel, 0);
+        i2sIoctl(I2S_SET_DMA_ADDRESS, I2S_REC, (uint32_t)pu32Rec);
+        i2sIoctl(I2S_SET_DMA_LENGTH, I2S_REC, u32Len);
+        i2sIoctl(I2S_SET_I2S_CALLBACKFUN, I2S_REC, (uint32_t)pipe_rec_callback);
+    }
+    return 0;
+}
+
+/**
+ * @brief     Set the tick source of the CPU load statistics
+ *
+ * @param[in]  psPipe: Pipeline
+ *
+ * @param[in]  pfnClock: Function returning a free running count, called in interrupt context.
+ *                       NULL for none.
+ *
+ * @param[in]  u32Mask: Valid bits of the count, 0xFFFFFF for an ETIMER counter
+ *
+ * @return    None
+ *
+ * @details   A play period must be shorter than the count takes to wrap.
+ */
+void i2sPipeSetClock(I2S_PIPE_T *psPipe, uint32_t (*pfnClock)(void), uint32_t u32Mask)
+{
+    psPipe->pfnClock = pfnClock;
+    psPipe->u32ClockMask = pfnClock ? u32Mask : 0;
+}
+
+/**
+ * @brief     Add a play stream
+ *
+ * @param[in]  psPipe: Pipeline
+ *
+ * @param[in]  psStream: Stream, enabled at unity gain with an empty FIFO
+ *
+ * @param[in]  pu32Buf: FIFO storage, one word per frame
+ *
+ * @param[in]  u32Size: Frames in pu32Buf, a power of 2
+ *
+ * @retval    0 Success
+ * @retval    I2S_ERR_BUSY \ref I2S_PIPE_STREAM_MAX streams are mixed already
+ */
+int32_t i2sPipeAddStream(I2S_PIPE_T *psPipe, I2S_STREAM_T *psStream, uint32_t *pu32Buf, uint32_t u32Size)
+{
+    if (psPipe->u32Streams >= I2S_PIPE_STREAM_MAX)
+        return I2S_ERR_BUSY;
+
+    i2sFifoInit(&psStream->sFifo, pu32Buf, u32Size);
+    psStream->sGain.i32Gain = 0;
+    i2sPcmSetGain(&psStream->sGain, I2S_GAIN_UNITY, 0);
+    psStream->u32Enable = 1;
+    psStream->u32Frames = 0;
+    psStream->u32Underruns = 0;
+    psStream->u32Silence = 0;
+    psStream->u32Ticks = 0;
+
+    /* The entry is in place before the interrupt can count it */
+    psPipe->apsStream[psPipe->u32Streams] = psStream;
+    psPipe->u32Streams++;
+    return 0;
+}
+
+/**
+ * @brief     Set the FIFO recorded frames go to
+ *
+ * @param[in]  psPipe: Pipeline
+ *
+ * @param[in]  psFifo: FIFO, read by the application. NULL to drop recorded frames.
+ *
+ * @return    None
+ */
+void i2sPipeSetRecord(I2S_PIPE_T *psPipe, I2S_FIFO_T *psFifo)
+{
+    psPipe->psRecFifo = psFifo;
+}
+
+/**
+ * @brief     Start playing, and recording if there is a record buffer
+ *
+ * @param[in]  psPipe: Pipeline
+ *
+ * @return    None
+ *
+ * @details   The play buffer starts silent; streams are first mixed into the period the DMA
+ *            leaves first, so the play latency is u32Periods - 1 to u32Periods periods.
+ *            The statistics are cleared.
+ */
+void i2sPipeStart(I2S_PIPE_T *psPipe)
+{
+    uint32_t i, u32Len = psPipe->u32Periods * psPipe->u32PeriodBytes;
+
+    sysMemSet(psPipe->pu32Play, 0, u32Len);
+    sysCleanDCacheRange((uint32_t)psPipe->pu32Play, u32Len);
+
+    psPipe->u32PlayNext = psPipe->u32RecNext = 0;
+    psPipe->u32PlayPeriods = psPipe->u32RecPeriods = 0;
+    psPipe->u32PlayLate = psPipe->u32RecLate = 0;
+    psPipe->u32RecOverruns = psPipe->u32RecDropped = 0;
+    psPipe->u32Ticks = psPipe->u32Elapsed = 0;
+    for (i = 0; i < psPipe->u32Streams; i++)
+    {
+        psPipe->apsStream[i]->u32Frames = 0;
+        psPipe->apsStream[i]->u32Underruns = 0;
+        psPipe->apsStream[i]->u32Silence = 0;
+        psPipe->apsStream[i]->u32Ticks = 0;
+    }
+    psPipe->u32LastTime = pipe_clock(psPipe);
+
+    if (psPipe->pu32Rec != NULL)
+        i2sIoctl(I2S_SET_RECORD, I2S_START_REC, 0);
+    i2sIoctl(I2S_SET_PLAY, I2S_START_PLAY, 0);
+}
+
+/**
+ * @brief     Stop playing and recording
+ *
+ * @param[in]  psPipe: Pipeline
+ *
+ * @return    None
+ */
+void i2sPipeStop(I2S_PIPE_T *psPipe)
+{
+    i2sIoctl(I2S_SET_PLAY, I2S_STOP_PLAY, 0);
+    if (psPipe->pu32Rec != NULL)
+        i2sIoctl(I2S_SET_RECORD, I2S_STOP_REC, 0);
+}
+
+/**
+ * @brief     Mix the play streams into one period of the play DMA buffer
+ *
+ * @param[in]  psPipe: Pipeline
+ *
+ * @param[in]  u32Period: Period, 0 ~ u32Periods - 1
+ *
+ * @return    None
+ *
+ * @details   Called by the play interrupt. A stream with fewer frames than a period gets an
+ *            underrun and is padded with silence.
+ */
+void i2sPipePlayPeriod(I2S_PIPE_T *psPipe, uint32_t u32Period)
+{
+    uint32_t n = psPipe->u32PeriodFrames;
+    uint32_t i, t0, u32Take, u32Idx, u32Part;
+    void *pvDst = (uint8_t *)psPipe->pu32Play + u32Period * psPipe->u32PeriodBytes;
+    I2S_STREAM_T *psStream;
+    I2S_FIFO_T *psFifo;
+
+    sysMemSet(psPipe->pi32Mix, 0, n * 8);
+    for (i = 0; i < psPipe->u32Streams; i++)
+    {
+        psStream = psPipe->apsStream[i];
+        if (!psStream->u32Enable)
+            continue;
+        t0 = pipe_clock(psPipe);
+
+        /* Mix straight from the FIFO, in two parts where it wraps */
+        psFifo = &psStream->sFifo;
+        u32Take = psFifo->u32Head - psFifo->u32Tail;
+        if (u32Take >= n)
+            u32Take = n;
+        else
+        {
+            psStream->u32Underruns++;
+            psStream->u32Silence += n - u32Take;
+        }
+        u32Idx = psFifo->u32Tail & (psFifo->u32Size - 1);
+        u32Part = psFifo->u32Size - u32Idx;
+        if (u32Part > u32Take)
+            u32Part = u32Take;
+        i2sPcmMix16(psPipe->pi32Mix, &psFifo->pu32Buf[u32Idx], u32Part, &psStream->sGain);
+        i2sPcmMix16(psPipe->pi32Mix + 2 * u32Part, psFifo->pu32Buf, u32Take - u32Part, &psStream->sGain);
+        psFifo->u32Tail += u32Take;
+
+        psStream->u32Frames += u32Take;
+        psStream->u32Ticks += (pipe_clock(psPipe) - t0) & psPipe->u32ClockMask;
+    }
+
+    if (psPipe->u32Width == I2S_BIT_WIDTH_16)
+        i2sPcmOut16((uint32_t *)pvDst, psPipe->pi32Mix, n);
+    else
+        i2sPcmOut24((int32_t *)pvDst, psPipe->pi32Mix, n);
+    sysCleanDCacheRange((uint32_t)pvDst, psPipe->u32PeriodBytes);
+    psPipe->u32PlayPeriods++;
+}
+
+/**
+ * @brief     Move one period of the record DMA buffer into the record FIFO
+ *
+ * @param[in]  psPipe: Pipeline
+ *
+ * @param[in]  u32Period: Period, 0 ~ u32Periods - 1
+ *
+ * @return    None
+ *
+ * @details   Called by the record interrupt. Frames that do not fit in the FIFO are dropped.
+ */
+void i2sPipeRecPeriod(I2S_PIPE_T *psPipe, uint32_t u32Period)
+{
+    uint32_t n = psPipe->u32PeriodFrames;
+    uint8_t *pu8Src = (uint8_t *)psPipe->pu32Rec + u32Period * psPipe->u32PeriodBytes;
+    I2S_FIFO_T *psFifo = psPipe->psRecFifo;
+    uint32_t u32Head, u32Take, u32Idx, u32Part;
+
+    sysInvalidateDCacheRange((uint32_t)pu8Src, psPipe->u32PeriodBytes);
+    psPipe->u32RecPeriods++;
+    if (psFifo == NULL)
+        return;
+
+    if (psPipe->u32Width == I2S_BIT_WIDTH_16)
+        u32Take = i2sFifoWrite(psFifo, (uint32_t *)pu8Src, n);
+    else
+    {
+        /* Round to 16 bits straight into the FIFO */
+        u32Head = psFifo->u32Head;
+        u32Take = psFifo->u32Size - (u32Head - psFifo->u32Tail);
+        if (u32Take > n)
+            u32Take = n;
+        u32Idx = u32Head & (psFifo->u32Size - 1);
+        u32Part = psFifo->u32Size - u32Idx;
+        if (u32Part > u32Take)
+            u32Part = u32Take;
+        i2sPcm24To16(&psFifo->pu32Buf[u32Idx], (int32_t *)pu8Src, u32Part);
+        i2sPcm24To16(psFifo->pu32Buf, (int32_t *)pu8Src + 2 * u32Part, u32Take - u32Part);
+        psFifo->u32Head = u32Head + u32Take;
+    }
+    if (u32Take < n)
+    {
+        psPipe->u32RecOverruns++;
+        psPipe->u32RecDropped += n - u32Take;
+    }
+}
+
+/*@}*/ /* end of group ARM9_I2S_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group I2S_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
@@ -14,7 +14,15 @@
 BOOL volatile _sys_IsCacheOn = FALSE;
 INT32 volatile _sys_CacheMode;
 
-#define USING_SEACTION_TABLE
+/* MMU table, select one:
+ *  USING_REGION_TABLE     - 1 MB sections, and 64 KB large pages where a megabyte is split,
+ *                           built from sysMMURegionTable[] (default)
+ *  USING_SEACTION_TABLE   - fixed 1 MB sections from _mmuSectionTable.dat
+ *  USING_SMALL_PAGE_TABLE - 4 KB small pages for the first _CoarsePageSize MB of SDRAM
+ */
+#if !defined(USING_SEACTION_TABLE) && !defined(USING_SMALL_PAGE_TABLE)
+#define USING_REGION_TABLE
+#endif
 
 #define  _CoarsePageSize    64  //MB
 
@@ -25,7 +33,20 @@ typedef struct _coarse_table
     unsigned int page[256];
 } _CTable;
 
-#ifdef USING_SEACTION_TABLE
+#if defined(USING_REGION_TABLE)
+#define _MMU_COARSE_TABLES  8   // megabytes that can be split into 64 KB large pages
+
+#if defined (__GNUC__) && !(__CC_ARM)
+__attribute__((aligned(0x4000))) unsigned int _mmuSectionTable[4096];
+__attribute__((aligned(1024))) static _CTable _mmuCoarsePageTable[_MMU_COARSE_TABLES];
+#else
+__align(0x4000) unsigned int _mmuSectionTable[4096];
+__align(1024) static _CTable _mmuCoarsePageTable[_MMU_COARSE_TABLES];
+#endif
+static int _mmuCoarsePageUsed;
+static int _mmuTableMode;       // cache mode the table was built for
+static INT32 _mmuTableResult;
+#elif defined(USING_SEACTION_TABLE)
 #if defined (__GNUC__) && !(__CC_ARM)
 __attribute__((aligned(0x4000))) unsigned int _mmuSectionTable[4096] =
 #else
@@ -47,6 +68,9 @@ __align(1024) static _CTable _mmuCoarsePageTable_NonCache[_CoarsePageSize]; // S
 #endif
 static BOOL _IsInitMMUTable = FALSE;
 
+void sys_lock_icache_way3(UINT32 start, UINT32 end);
+static void sys_relock_icache(void);
+
 extern INT32 sysGetSdramSizebyMB(void);
 
 #if defined (__GNUC__) && !(__CC_ARM)
@@ -68,6 +92,105 @@ tci_loop
 }
 #endif
 
+#if defined (__GNUC__) && !(__CC_ARM)
+void sys_clean_dcache(void)
+{
+    asm volatile(
+    "tc_loop:  \n\t"
+    "MRC p15, #0, r15, c7, c10, #3  \n\t" // test and clean
+    "BNE tc_loop  \n\t"
+    );
+}
+#else
+__asm void sys_clean_dcache(void)
+{
+tc_loop
+    MRC p15, 0, r15, c7, c10, 3 // test and clean
+    BNE tc_loop
+    BX  lr
+}
+#endif
+
+/* Ranges of this size or larger are maintained with the whole-cache test loops,
+   which cost at most one pass over the 512 lines no matter how large the range is. */
+#ifndef SYS_DCACHE_RANGE_LIMIT
+#define SYS_DCACHE_RANGE_LIMIT  SYS_DCACHE_SIZE
+#endif
+
+static void sys_drain_write_buffer(void)
+{
+    int temp = 0;
+
+#if defined (__GNUC__) && !(__CC_ARM)
+    asm volatile
+    (
+        "MCR p15, #0, %0, c7, c10, #4 \n\t" /* drain write buffer */
+        :
+        : "r" (temp)
+        : "memory"
+    );
+#else
+    __asm
+    {
+        MCR p15, 0, temp, c7, c10, 4 /* drain write buffer */
+    }
+#endif
+}
+
+/* Clean D-cache lines by MVA from addr (line aligned) up to end */
+static void sys_clean_dcache_lines(UINT32 addr, UINT32 end)
+{
+    for (; addr < end; addr += SYS_DCACHE_LINE_SIZE)
+    {
+#if defined (__GNUC__) && !(__CC_ARM)
+        asm volatile("MCR p15, #0, %0, c7, c10, #1" : : "r" (addr) : "memory");
+#else
+        __asm
+        {
+            MCR p15, 0, addr, c7, c10, 1
+        }
+#endif
+    }
+}
+
+/* Invalidate D-cache lines by MVA from addr (line aligned) up to end */
+static void sys_invalidate_dcache_lines(UINT32 addr, UINT32 end)
+{
+    for (; addr < end; addr += SYS_DCACHE_LINE_SIZE)
+    {
+#if defined (__GNUC__) && !(__CC_ARM)
+        asm volatile("MCR p15, #0, %0, c7, c6, #1" : : "r" (addr) : "memory");
+#else
+        __asm
+        {
+            MCR p15, 0, addr, c7, c6, 1
+        }
+#endif
+    }
+}
+
+/* Clean and invalidate D-cache lines by MVA from addr (line aligned) up to end */
+static void sys_clean_invalidate_dcache_lines(UINT32 addr, UINT32 end)
+{
+    for (; addr < end; addr += SYS_DCACHE_LINE_SIZE)
+    {
+#if defined (__GNUC__) && !(__CC_ARM)
+        asm volatile("MCR p15, #0, %0, c7, c14, #1" : : "r" (addr) : "memory");
+#else
+        __asm
+        {
+            MCR p15, 0, addr, c7, c14, 1
+        }
+#endif
+    }
+}
+
+/* Nothing to maintain for the non-cacheable shadow at 0x80000000 or with the cache off */
+static BOOL sys_dcache_range_cached(UINT32 u32Addr, UINT32 u32Size)
+{
+    return (_sys_IsCacheOn && (u32Size != 0) && !(u32Addr & 0x80000000));
+}
+
 #if defined (__GNUC__) && !(__CC_ARM)
 void sysSetupCP15(unsigned int addr)
 {
@@ -100,7 +223,7 @@ __asm void sysSetupCP15(unsigned int addr)
     BX      lr
 }
 #endif
-#ifndef USING_SEACTION_TABLE
+#ifdef USING_SMALL_PAGE_TABLE
 unsigned int sysGetPhyPageAddr(unsigned int vaddr)
 {
     int table_num, page_num;
@@ -184,15 +307,147 @@ int sysInitPageTable(unsigned int vaddr, unsigned int phy_addr, int size, int ca
 } /* end sysInitPageTable */
 #endif
 
+#ifdef USING_REGION_TABLE
+/* Default memory map, the same as _mmuSectionTable.dat: the first 128 MB write-back
+   cacheable whatever the mode passed to sysEnableCache(), everything else including the
+   shadow at 0x80000000 non-cacheable. Define sysMMURegionTable[] in the application to
+   replace it, e.g. with SYS_MMU_SDRAM_SIZE and SYS_MMU_CACHED entries. */
+#if defined (__GNUC__) && !(__CC_ARM)
+__attribute__((weak)) const SYS_MMU_REGION_T sysMMURegionTable[] =
+#else
+__weak const SYS_MMU_REGION_T sysMMURegionTable[] =
+#endif
+{
+    { 0x00000000, 0x08000000, SYS_MMU_WB },
+    { 0, 0, 0 }
+};
+
+#define _MMU_SECTION    0xDF2   /* AP R/W, domain 15, 1 MB section */
+#define _MMU_COARSE     0x1F1   /* domain 15, coarse page table */
+#define _MMU_LARGE_PAGE 0xFF1   /* AP R/W for all four subpages, 64 KB large page */
+
+static UINT32 sys_mmu_cb(UINT32 u32Attr, int cache_mode)
+{
+    if (u32Attr & SYS_MMU_CACHED)
+    {
+        if (cache_mode == CACHE_WRITE_BACK)
+            return SYS_MMU_WB;
+        if (cache_mode == CACHE_WRITE_THROUGH)
+            return SYS_MMU_WT;
+        return SYS_MMU_NC;
+    }
+    return u32Attr & SYS_MMU_WB;
+}
+
+/* Map [u32Base, u32Base + u32Size) flat with C/B bits cb. Whole megabytes become sections;
+   a megabyte covered in part is split into 16 large pages that inherit its attributes. */
+static INT32 sys_mmu_map(UINT32 u32Base, UINT32 u32Size, UINT32 cb)
+{
+    UINT32 i, j, k;
+    _CTable *pt;
+
+    if ((u32Base | u32Size) & 0xFFFF)
+        return -1;
+
+    while (u32Size)
+    {
+        i = u32Base >> 20;
+        if (!(u32Base & 0xFFFFF) && (u32Size >= 0x100000))
+        {
+            _mmuSectionTable[i] = (u32Base & 0xFFF00000) | _MMU_SECTION | cb;
+            u32Base += 0x100000;
+            u32Size -= 0x100000;
+            continue;
+        }
+
+        if ((_mmuSectionTable[i] & 0x3) != 0x1)
+        {
+            if (_mmuCoarsePageUsed == _MMU_COARSE_TABLES)
+                return -1;
+            pt = &_mmuCoarsePageTable[_mmuCoarsePageUsed++];
+            for (j = 0; j < 256; j++)   /* each large page is repeated in 16 consecutive entries */
+                pt->page[j] = (i << 20) | ((j >> 4) << 16) | _MMU_LARGE_PAGE | (_mmuSectionTable[i] & SYS_MMU_WB);
+            _mmuSectionTable[i] = ((UINT32)pt & 0xFFFFFC00) | _MMU_COARSE;
+        }
+        pt = (_CTable *)(_mmuSectionTable[i] & 0xFFFFFC00);
+        j = (u32Base >> 12) & 0xF0;
+        for (k = 0; k < 16; k++)
+            pt->page[j + k] = (pt->page[j + k] & ~SYS_MMU_WB) | cb;
+        u32Base += 0x10000;
+        u32Size -= 0x10000;
+    }
+    return 0;
+}
+
+static void sys_invalidate_tlb(void)
+{
+    int temp = 0;
+
+#if defined (__GNUC__) && !(__CC_ARM)
+    asm volatile
+    (
+        "MCR p15, #0, %0, c8, c7, #0 \n\t" /* invalidate I and D TLB */
+        :
+        : "r" (temp)
+        : "memory"
+    );
+#else
+    __asm
+    {
+        MCR p15, 0, temp, c8, c7, 0 /* invalidate I and D TLB */
+    }
+#endif
+}
+
+static INT32 sys_mmu_build(int cache_mode)
+{
+    const SYS_MMU_REGION_T *pRegion;
+    UINT32 i, size;
+    INT32 ret = 0;
+
+    for (i = 0; i < 4096; i++)
+        _mmuSectionTable[i] = (i << 20) | _MMU_SECTION;
+    _mmuCoarsePageUsed = 0;
+
+    for (pRegion = sysMMURegionTable; pRegion->u32Size != 0; pRegion++)
+    {
+        size = pRegion->u32Size;
+        if (size == SYS_MMU_SDRAM_SIZE)
+            size = (UINT32)sysGetSdramSizebyMB() << 20;
+        if (sys_mmu_map(pRegion->u32Base, size, sys_mmu_cb(pRegion->u32Attr, cache_mode)) != 0)
+            ret = -1;
+    }
+
+    /* The table walk reads SDRAM, not the D-cache */
+    if (_sys_IsCacheOn)
+        sys_clean_dcache();
+    sys_drain_write_buffer();
+    sys_invalidate_tlb();
+    return ret;
+}
+#endif
+
 int sysInitMMUTable(int cache_mode)
 {
-#ifndef USING_SEACTION_TABLE
+    int ret = 0;
+#ifdef USING_SMALL_PAGE_TABLE
     unsigned volatile int temp;
     int i, size, ramsize;
+#endif
+#ifdef USING_REGION_TABLE
+    /* Built on the first call, and again only when the cache mode changes, as the mode
+       selects the C/B bits of SYS_MMU_CACHED regions. Regions that cannot be mapped are
+       left non-cacheable. */
+    if ((_IsInitMMUTable == FALSE) || (cache_mode != _mmuTableMode))
+    {
+        _mmuTableResult = sys_mmu_build(cache_mode);
+        _mmuTableMode = cache_mode;
+    }
+    ret = _mmuTableResult;
 #endif
     if (_IsInitMMUTable == FALSE)
     {
-#ifndef USING_SEACTION_TABLE
+#ifdef USING_SMALL_PAGE_TABLE
         ramsize = sysGetSdramSizebyMB();
 
         //flat mapping for 4GB, 4096 section table, each size is 1MB
@@ -262,7 +517,7 @@ int sysInitMMUTable(int cache_mode)
     //set CP15 registers
     sysSetupCP15((unsigned int)_mmuSectionTable);
 
-    return 0;
+    return ret;
 
 } /* end sysInitMMUTable */
 
@@ -293,6 +548,7 @@ void sysFlushCache(INT32 nCacheType)
             MCR p15, 0, temp, c7, c5, 0 /* invalidate I cache */
         }
 #endif
+        sys_relock_icache();
         break;
 
     case D_CACHE:
@@ -340,6 +596,7 @@ void sysFlushCache(INT32 nCacheType)
             MCR p15, 0, temp, c7, c10, 4 /* drain write buffer */
         }
 #endif
+        sys_relock_icache();
         break;
 
     default:
@@ -367,6 +624,7 @@ void sysInvalidCache()
         MCR p15, 0, temp, c7, c7, 0 /* invalidate I and D cache */
     }
 #endif
+    sys_relock_icache();
 }
 
 BOOL sysGetCacheState()
@@ -381,76 +639,104 @@ INT32 sysGetCacheMode()
 }
 
 
-INT32 _sysLockCode(UINT32 addr, INT32 size)
-{
-    int i, cnt, temp;
-
-#if defined (__GNUC__) && !(__CC_ARM)
-    asm volatile
-    (
-        /* use way3 to lock instructions */
-        "MRC p15, #0, %0, c9, c0, #1 \n\t"
-        "ORR %0, %0, #0x07 \n\t"
-        "MCR p15, #0, %0, c9, c0, #1 \n\t"
-        :"=r" (temp)
-        :"0" (temp)
-        :"memory"
-    );
-#else
-    __asm
-    {
-        /* use way3 to lock instructions */
-        MRC p15, 0, temp, c9, c0, 1 ;
-        ORR temp, temp, 0x07 ;
-        MCR p15, 0, temp, c9, c0, 1 ;
-    }
-#endif
-
-    if (size % 16)  cnt = (size/16) + 1;
-    else            cnt = size / 16;
-
-    for (i=0; i<cnt; i++)
-    {
+/* Bounds of .fastcode from GCC.ld or nuc980.sct. Weak, so images linked with
+   other scripts read an empty section. */
 #if defined (__GNUC__) && !(__CC_ARM)
-        asm volatile
-        (
-            "MCR p15, #0, r0, c7, c13, #1 \n\t"
-        );
+extern UINT8 __fastcode_start[] __attribute__((weak));
+extern UINT8 __fastcode_end[] __attribute__((weak));
+#define SYS_FASTCODE_BASE   ((UINT32)__fastcode_start)
+#define SYS_FASTCODE_LIMIT  ((UINT32)__fastcode_end)
 #else
-        __asm
-        {
-            MCR p15, 0, addr, c7, c13, 1;
-        }
+extern __weak UINT8 Image$$FAST_CODE$$Base[];
+extern __weak UINT8 Image$$FAST_CODE$$Limit[];
+#define SYS_FASTCODE_BASE   ((UINT32)Image$$FAST_CODE$$Base)
+#define SYS_FASTCODE_LIMIT  ((UINT32)Image$$FAST_CODE$$Limit)
 #endif
 
-        addr += 16;
-    }
+static UINT32 _sys_u32LockStart, _sys_u32LockEnd;   /* Range held in way 3, 0 when unlocked */
 
+/*
+ * Load the I-cache lines of [start, end) into way 3 and lock the way. The I-cache
+ * is invalidated first, otherwise lines already held in ways 0-2 would not be
+ * fetched again. While ways 0-2 are locked every fetch fills way 3, so this runs
+ * with IRQ and FIQ masked and is called through the non-cacheable alias: its own
+ * instructions are not cached and cannot take lines of the locked range.
+ */
 #if defined (__GNUC__) && !(__CC_ARM)
+void __attribute__ ((naked)) sys_lock_icache_way3(UINT32 start, UINT32 end)
+{
     asm volatile
     (
-        /* use way3 to lock instructions */
-        "MRC p15, #0, %0, c9, c0, #1 \n\t"
-        "BIC %0, %0, #0x07  \n\t"
-        "ORR %0, %0, #0x08 \n\t"
-        "MCR p15, #0, %0, c9, c0, #1 \n\t"
-        :"=r" (temp)
-        :"0"  (temp)
-        :"memory"
+        "mrs    r3, cpsr                    \n"
+        "orr    r2, r3, #0xC0               \n"
+        "msr    cpsr_c, r2                  \n"
+        "mov    r2, #0                      \n"
+        "mcr    p15, #0, r2, c7, c5, #0     \n"     /* invalidate I-cache */
+        "mrc    p15, #0, r2, c9, c0, #1     \n"
+        "bic    r2, r2, #0x0F               \n"
+        "orr    r2, r2, #0x07               \n"     /* ways 0-2 locked, fills go to way 3 */
+        "mcr    p15, #0, r2, c9, c0, #1     \n"
+        "1:                                 \n"
+        "mcr    p15, #0, r0, c7, c13, #1    \n"     /* prefetch I-cache line */
+        "add    r0, r0, #32                 \n"
+        "cmp    r0, r1                      \n"
+        "blo    1b                          \n"
+        "bic    r2, r2, #0x0F               \n"
+        "orr    r2, r2, #0x08               \n"     /* way 3 locked, ways 0-2 in use */
+        "mcr    p15, #0, r2, c9, c0, #1     \n"
+        "msr    cpsr_c, r3                  \n"
+        "bx     lr                          \n"
     );
+}
 #else
-    __asm
+__asm void sys_lock_icache_way3(UINT32 start, UINT32 end)
+{
+    MRS     r3, CPSR
+    ORR     r2, r3, #0xC0
+    MSR     CPSR_c, r2
+    MOV     r2, #0
+    MCR     p15, 0, r2, c7, c5, 0       ; invalidate I-cache
+    MRC     p15, 0, r2, c9, c0, 1
+    BIC     r2, r2, #0x0F
+    ORR     r2, r2, #0x07               ; ways 0-2 locked, fills go to way 3
+    MCR     p15, 0, r2, c9, c0, 1
+lock_loop
+    MCR     p15, 0, r0, c7, c13, 1      ; prefetch I-cache line
+    ADD     r0, r0, #32
+    CMP     r0, r1
+    BLO     lock_loop
+    BIC     r2, r2, #0x0F
+    ORR     r2, r2, #0x08               ; way 3 locked, ways 0-2 in use
+    MCR     p15, 0, r2, c9, c0, 1
+    MSR     CPSR_c, r3
+    BX      lr
+}
+#endif
+
+/* Fill way 3 again after the whole I-cache was invalidated */
+static void sys_relock_icache(void)
+{
+    void (*pfnLock)(UINT32, UINT32);
+
+    if (_sys_u32LockEnd != 0)
     {
-        /* use way3 to lock instructions */
-        MRC p15, 0, temp, c9, c0, 1 ;
-        BIC temp, temp, 0x07 ;
-        ORR temp, temp, 0x08 ;
-        MCR p15, 0, temp, c9, c0, 1 ;
+        pfnLock = (void (*)(UINT32, UINT32))((UINT32)sys_lock_icache_way3 | 0x80000000);
+        pfnLock(_sys_u32LockStart, _sys_u32LockEnd);
     }
-#endif
+}
 
-    return 0;
+INT32 _sysLockCode(UINT32 addr, INT32 size)
+{
+    UINT32 start = addr & ~(SYS_ICACHE_LINE_SIZE - 1);
+    UINT32 end = (addr + size + SYS_ICACHE_LINE_SIZE - 1) & ~(SYS_ICACHE_LINE_SIZE - 1);
 
+    if ((size <= 0) || (end - start > SYS_ICACHE_WAY_SIZE) || (addr & 0x80000000) || !_sys_IsCacheOn)
+        return Fail;
+
+    _sys_u32LockStart = start;
+    _sys_u32LockEnd = end;
+    sys_relock_icache();
+    return 0;
 }
 
 
@@ -458,6 +744,8 @@ INT32 _sysUnLockCode()
 {
     int temp;
 
+    _sys_u32LockEnd = 0;
+
     /* unlock I-cache way 3 */
 #if defined (__GNUC__) && !(__CC_ARM)
     asm volatile
@@ -542,8 +830,151 @@ void sysDisableCache(void)
         MCR p15, 0, temp, c1, c0, 0     /* write Control register */
     }
 #endif
+    _sysUnLockCode();
     _sys_IsCacheOn = FALSE;
     _sys_CacheMode = CACHE_DISABLE;
 
 }
 
+/**
+ *  @brief  system Cache - Write dirty D-cache lines of an address range back to memory
+ *
+ *  @param[in]  u32Addr     Start address of the range
+ *  @param[in]  u32Size     Size of the range in bytes
+ *
+ *  @return   None
+ *
+ *  @note   Call before a device reads the range by DMA. The lines stay valid in the cache.
+ *          Addresses in the non-cacheable area (bit 31 set) are ignored.
+ */
+void sysCleanDCacheRange(UINT32 u32Addr, UINT32 u32Size)
+{
+    if (!sys_dcache_range_cached(u32Addr, u32Size))
+        return;
+
+    if (_sys_CacheMode != CACHE_WRITE_THROUGH)
+    {
+        if (u32Size >= SYS_DCACHE_RANGE_LIMIT)
+            sys_clean_dcache();
+        else
+            sys_clean_dcache_lines(u32Addr & ~(SYS_DCACHE_LINE_SIZE - 1), u32Addr + u32Size);
+    }
+    sys_drain_write_buffer();
+}
+
+/**
+ *  @brief  system Cache - Discard the D-cache lines of an address range
+ *
+ *  @param[in]  u32Addr     Start address of the range
+ *  @param[in]  u32Size     Size of the range in bytes
+ *
+ *  @return   None
+ *
+ *  @note   Call before a device writes the range by DMA, and do not touch the range with the CPU
+ *          until the transfer is done. Lines only partly covered at an unaligned start or end are
+ *          cleaned as well, so data next to the range is not lost; the range itself must not hold
+ *          dirty data the device is not going to overwrite. Buffers aligned to
+ *          \ref SYS_DCACHE_LINE_SIZE avoid the partial lines.
+ *          Addresses in the non-cacheable area (bit 31 set) are ignored.
+ */
+void sysInvalidateDCacheRange(UINT32 u32Addr, UINT32 u32Size)
+{
+    UINT32 u32End;
+
+    if (!sys_dcache_range_cached(u32Addr, u32Size))
+        return;
+
+    if (u32Size >= SYS_DCACHE_RANGE_LIMIT)
+    {
+        sys_flush_and_clean_dcache();
+        sys_drain_write_buffer();
+        return;
+    }
+
+    u32End = u32Addr + u32Size;
+    if (u32Addr & (SYS_DCACHE_LINE_SIZE - 1))
+    {
+        u32Addr &= ~(SYS_DCACHE_LINE_SIZE - 1);
+        sys_clean_invalidate_dcache_lines(u32Addr, u32Addr + 1);
+        u32Addr += SYS_DCACHE_LINE_SIZE;
+    }
+    if ((u32End & (SYS_DCACHE_LINE_SIZE - 1)) && ((u32End & ~(SYS_DCACHE_LINE_SIZE - 1)) >= u32Addr))
+    {
+        u32End &= ~(SYS_DCACHE_LINE_SIZE - 1);
+        sys_clean_invalidate_dcache_lines(u32End, u32End + 1);
+    }
+    sys_invalidate_dcache_lines(u32Addr, u32End);
+    sys_drain_write_buffer();
+}
+
+/**
+ *  @brief  system Cache - Write back and discard the D-cache lines of an address range
+ *
+ *  @param[in]  u32Addr     Start address of the range
+ *  @param[in]  u32Size     Size of the range in bytes
+ *
+ *  @return   None
+ *
+ *  @note   Use for buffers a device both reads and writes, e.g. in-place transforms.
+ *          Addresses in the non-cacheable area (bit 31 set) are ignored.
+ */
+void sysCleanInvalidateDCacheRange(UINT32 u32Addr, UINT32 u32Size)
+{
+    if (!sys_dcache_range_cached(u32Addr, u32Size))
+        return;
+
+    if (u32Size >= SYS_DCACHE_RANGE_LIMIT)
+        sys_flush_and_clean_dcache();
+    else
+        sys_clean_invalidate_dcache_lines(u32Addr & ~(SYS_DCACHE_LINE_SIZE - 1), u32Addr + u32Size);
+    sys_drain_write_buffer();
+}
+
+/**
+ *  @brief  system Cache - Drain the write buffer
+ *
+ *  @return   None
+ *
+ *  @note   Call after writing through the non-cacheable area (bit 31 set) data a device
+ *          is going to read, e.g. DMA descriptors, before starting the device.
+ */
+void sysDrainWriteBuffer(void)
+{
+    sys_drain_write_buffer();
+}
+
+/**
+ *  @brief  system Cache - Lock the .fastcode section into I-cache way 3
+ *
+ *  @return   0 on success. 1 (Fail) when the cache is off, or the section is empty or
+ *            larger than \ref SYS_ICACHE_WAY_SIZE.
+ *
+ *  @note   Call after sysEnableCache(). Functions marked \ref SYS_FASTCODE then run
+ *          without I-cache misses; the other code shares ways 0-2. Whole I-cache
+ *          invalidations by sysFlushCache() and sysInvalidCache() reload the section,
+ *          sysDisableCache() unlocks it.
+ */
+INT32 sysLockFastCode(void)
+{
+    return _sysLockCode(SYS_FASTCODE_BASE, (INT32)sysGetFastCodeSize());
+}
+
+/**
+ *  @brief  system Cache - Return I-cache way 3 to normal use
+ *
+ *  @return   None
+ */
+void sysUnlockFastCode(void)
+{
+    _sysUnLockCode();
+}
+
+/**
+ *  @brief  system Cache - Size of the .fastcode section
+ *
+ *  @return   Size in bytes, 0 when the linker script has no .fastcode section
+ */
+UINT32 sysGetFastCodeSize(void)
+{
+    return SYS_FASTCODE_LIMIT - SYS_FASTCODE_BASE;
+}
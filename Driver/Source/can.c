@@ -235,6 +235,75 @@ static int can_update_spt(int sampl_pt, int tseg, int *tseg1, int *tseg2)
 
 /** @endcond HIDDEN_SYMBOLS */
 
+/**
+  * @brief Reserve or release message interface IF2.
+  * @param[in] tCAN The pointer to CAN module base address.
+  * @param[in] u32Reserve TRUE to reserve IF2, FALSE to release it.
+  * @retval TRUE Success
+  * @retval FALSE IF2 stayed in use
+  * @details While IF2 is reserved the functions of this driver use IF1 only, so the
+  *          owner of IF2, an interrupt handler for example, drives it without locking.
+  */
+int32_t CAN_ReserveIF(CAN_T *tCAN, uint32_t u32Reserve)
+{
+    int32_t rev = (int32_t)FALSE;
+    uint32_t u32CanNo;
+    uint32_t u32IntMask;
+    uint32_t u32Count;
+
+    if(tCAN == CAN0)
+        u32CanNo = 0ul;
+#if defined(CAN1)
+    else if(tCAN == CAN1)
+        u32CanNo = 1ul;
+#endif
+#if defined(CAN2)
+    else if(tCAN == CAN2)
+        u32CanNo = 2ul;
+#endif
+#if defined(CAN3)
+    else if(tCAN == CAN3)
+        u32CanNo = 3ul;
+#endif
+    else
+        return rev;
+
+    if(!u32Reserve)
+    {
+        ReleaseIF(tCAN, 1ul);
+        return (int32_t)TRUE;
+    }
+
+    for(u32Count = 0ul; u32Count < RETRY_COUNTS; u32Count++)
+    {
+        /* Disable CAN interrupt */
+        u32IntMask = tCAN->CON & (CAN_CON_IE_Msk | CAN_CON_SIE_Msk | CAN_CON_EIE_Msk);
+        tCAN->CON = tCAN->CON & ~(CAN_CON_IE_Msk | CAN_CON_SIE_Msk | CAN_CON_EIE_Msk);
+
+        if(((tCAN->IF[1ul].CREQ & CAN_IF_CREQ_BUSY_Msk) == 0ul) && (gu8LockCanIf[u32CanNo][1ul] == 0ul))
+        {
+            gu8LockCanIf[u32CanNo][1ul] = 1u;
+            rev = (int32_t)TRUE;
+        }
+        else
+        {
+        }
+
+        /* Enable CAN interrupt */
+        tCAN->CON |= u32IntMask;
+
+        if(rev)
+        {
+            break;
+        }
+        else
+        {
+        }
+    }
+
+    return rev;
+}
+
 /**
   * @brief Enter initialization mode
   * @param[in] tCAN The pointer to CAN module base address.
@@ -1150,7 +1219,13 @@ int32_t CAN_SetMultiRxMsg(CAN_T *tCAN, uint32_t u32MsgNum, uint32_t u32MsgCount,
     {
         u32TimeOutCount = 0ul;
 
-        u32MsgNum += (i - 1ul);
+        if(i > 1ul)
+        {
+            u32MsgNum++;
+        }
+        else
+        {
+        }
 
         if(i == u32MsgCount)
         {
@@ -0,0 +1,842 @@
+/**************************************************************************//**
+ * @file     canqueue.c
+ * @version  V1.00
+ * @brief    NUC980 series interrupt-driven CAN queue
+ *
+ * The first u32RxObjs message objects form one receive FIFO accepting every
+ * frame. The interrupt drains it, lowest object first, into a lock-free ring
+ * of timestamped frames, after an optional software ID filter: a bitmap of
+ * the 2048 standard IDs and a hash set of extended IDs, for ID sets the
+ * hardware masks cannot express. The next u32TxObjs objects send the frames
+ * of a transmit queue ordered by arbitration priority; the transmit
+ * interrupt loads the highest priority frames waiting into them, in
+ * ascending object order so that loaded frames keep their order.
+ *
+ * The queue owns IF2, reserved with CAN_ReserveIF(), so the interrupt never
+ * waits for an interface; the functions of can.c keep IF1. Tasks touch the
+ * transmit queue and the filter with the CAN interrupt masked in CON, as
+ * LockIF() does; the receive ring has one reader and needs no lock.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include "can.h"
+#include "sys.h"
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup CAN_Driver CAN Driver
+  @{
+*/
+
+/** @addtogroup CAN_EXPORTED_FUNCTIONS CAN Exported Functions
+  @{
+*/
+
+/** @cond HIDDEN_SYMBOLS */
+
+#define CAN_QUEUE_IF        1ul             /* IF2 */
+#define CAN_INT_MSK         (CAN_CON_IE_Msk | CAN_CON_SIE_Msk | CAN_CON_EIE_Msk)
+#define CAN_ERR_STATE_MSK   (CAN_STATUS_EWARN_Msk | CAN_STATUS_EPASS_Msk | CAN_STATUS_BOFF_Msk)
+#define CAN_EXT_USED        0x80000000ul    /* Marks a used entry of the extended ID set */
+
+static CAN_QUEUE_T *s_apsQueue[4];
+
+static const IRQn_Type s_aeCanIrq[4] = { IRQ_CAN0, IRQ_CAN1, IRQ_CAN2, IRQ_CAN3 };
+
+static uint32_t can_no(CAN_T *tCAN)
+{
+    if(tCAN == CAN0)
+        return 0ul;
+    else if(tCAN == CAN1)
+        return 1ul;
+    else if(tCAN == CAN2)
+        return 2ul;
+    else if(tCAN == CAN3)
+        return 3ul;
+    else
+        return 4ul;
+}
+
+static void can0_isr(void)
+{
+    CAN_QueueIRQHandler(s_apsQueue[0]);
+}
+
+static void can1_isr(void)
+{
+    CAN_QueueIRQHandler(s_apsQueue[1]);
+}
+
+static void can2_isr(void)
+{
+    CAN_QueueIRQHandler(s_apsQueue[2]);
+}
+
+static void can3_isr(void)
+{
+    CAN_QueueIRQHandler(s_apsQueue[3]);
+}
+
+static void (* const s_apfnIsr[4])(void) = { can0_isr, can1_isr, can2_isr, can3_isr };
+
+static __inline uint32_t can_clock(CAN_QUEUE_T *psQueue)
+{
+    return psQueue->pfnClock ? psQueue->pfnClock() : 0ul;
+}
+
+/* Mask the CAN interrupt as LockIF() does, returning the enables to restore */
+static __inline uint32_t can_lock(CAN_T *tCAN)
+{
+    uint32_t u32IntMask = tCAN->CON & CAN_INT_MSK;
+
+    tCAN->CON = tCAN->CON & ~CAN_INT_MSK;
+    return u32IntMask;
+}
+
+static __inline void can_unlock(CAN_T *tCAN, uint32_t u32IntMask)
+{
+    tCAN->CON |= u32IntMask;
+}
+
+/* Start a transfer between IF2 and a message object and wait for it */
+static __inline void can_transfer(CAN_T *tCAN, uint32_t u32Obj)
+{
+    tCAN->IF[CAN_QUEUE_IF].CREQ = 1ul + u32Obj;
+    while(tCAN->IF[CAN_QUEUE_IF].CREQ & CAN_IF_CREQ_BUSY_Msk)
+    {
+        /*Wait*/
+    }
+}
+
+/* Arbitration order: base ID, standard before extended, extended ID bits, data before remote */
+static uint32_t can_key(STR_CANMSG_T *pCanMsg)
+{
+    uint32_t u32Key;
+
+    if(pCanMsg->IdType == CAN_STD_ID)
+        u32Key = (pCanMsg->Id & 0x7FFul) << 20;
+    else
+        u32Key = (((pCanMsg->Id >> 18) & 0x7FFul) << 20) | (1ul << 19) | ((pCanMsg->Id & 0x3FFFFul) << 1);
+
+    return u32Key | (pCanMsg->FrameType == CAN_REMOTE_FRAME ? 1ul : 0ul);
+}
+
+/* Nominal bits of a frame with its interframe space, stuff bits not counted */
+static uint32_t can_bits(uint32_t u32IdType, uint32_t u32Bytes)
+{
+    return (u32IdType == CAN_STD_ID ? 47ul : 67ul) + 8ul * u32Bytes;
+}
+
+static __inline int32_t can_before(CAN_TXENTRY_T *psA, CAN_TXENTRY_T *psB)
+{
+    return (psA->u32Key < psB->u32Key) ||
+           ((psA->u32Key == psB->u32Key) && ((int32_t)(psA->u32Seq - psB->u32Seq) < 0));
+}
+
+static void can_heap_push(CAN_QUEUE_T *psQueue, STR_CANMSG_T *pCanMsg)
+{
+    CAN_TXENTRY_T *psHeap = psQueue->psTx;
+    CAN_TXENTRY_T sEntry;
+    uint32_t i = psQueue->u32TxCount++, p;
+
+    sEntry.sMsg = *pCanMsg;
+    sEntry.u32Key = can_key(pCanMsg);
+    sEntry.u32Seq = psQueue->u32TxSeq++;
+
+    while(i > 0ul)
+    {
+        p = (i - 1ul) >> 1;
+        if(!can_before(&sEntry, &psHeap[p]))
+            break;
+        psHeap[i] = psHeap[p];
+        i = p;
+    }
+    psHeap[i] = sEntry;
+}
+
+static void can_heap_pop(CAN_QUEUE_T *psQueue, CAN_TXENTRY_T *psEntry)
+{
+    CAN_TXENTRY_T *psHeap = psQueue->psTx;
+    uint32_t u32Count = --psQueue->u32TxCount, i = 0ul, c;
+
+    *psEntry = psHeap[0];
+    while((c = 2ul * i + 1ul) < u32Count)
+    {
+        if((c + 1ul < u32Count) && can_before(&psHeap[c + 1ul], &psHeap[c]))
+            c++;
+        if(!can_before(&psHeap[c], &psHeap[u32Count]))
+            break;
+        psHeap[i] = psHeap[c];
+        i = c;
+    }
+    psHeap[i] = psHeap[u32Count];
+}
+
+static __inline uint32_t can_hash(CAN_QUEUE_T *psQueue, uint32_t u32ID)
+{
+    uint32_t h = u32ID * 0x9E3779B1ul;
+
+    return (h ^ (h >> 16)) & (psQueue->u32ExtSize - 1ul);
+}
+
+/* Slot of an extended ID in the hash set, or u32ExtSize */
+static uint32_t can_ext_find(CAN_QUEUE_T *psQueue, uint32_t u32ID)
+{
+    uint32_t *pu32Set = psQueue->pu32ExtFilter, i;
+
+    if(psQueue->u32ExtSize == 0ul)
+        return 0ul;
+
+    for(i = can_hash(psQueue, u32ID); pu32Set[i]; i = (i + 1ul) & (psQueue->u32ExtSize - 1ul))
+    {
+        if(pu32Set[i] == (u32ID | CAN_EXT_USED))
+            return i;
+    }
+    return psQueue->u32ExtSize;
+}
+
+static __inline int32_t can_accept(CAN_QUEUE_T *psQueue, uint32_t u32IdType, uint32_t u32ID)
+{
+    if(u32IdType == CAN_STD_ID)
+        return (psQueue->au32StdFilter[u32ID >> 5] >> (u32ID & 31ul)) & 1ul;
+    else
+        return can_ext_find(psQueue, u32ID) != psQueue->u32ExtSize;
+}
+
+/* Load a frame into a transmit object and request its transmission */
+static void can_tx_load(CAN_T *tCAN, uint32_t u32Obj, STR_CANMSG_T *pCanMsg)
+{
+    CAN_IF_T *psIF = &tCAN->IF[CAN_QUEUE_IF];
+    uint32_t u32Dir = (pCanMsg->FrameType == CAN_REMOTE_FRAME) ? 0ul : CAN_IF_ARB2_DIR_Msk;
+
+    psIF->CMASK = CAN_IF_CMASK_WRRD_Msk | CAN_IF_CMASK_ARB_Msk | CAN_IF_CMASK_CONTROL_Msk |
+                  CAN_IF_CMASK_DATAA_Msk | CAN_IF_CMASK_DATAB_Msk;
+    if(pCanMsg->IdType == CAN_STD_ID)
+    {
+        psIF->ARB1 = 0ul;
+        psIF->ARB2 = ((pCanMsg->Id & 0x7FFul) << 2) | u32Dir | CAN_IF_ARB2_MSGVAL_Msk;
+    }
+    else
+    {
+        psIF->ARB1 = pCanMsg->Id & 0xFFFFul;
+        psIF->ARB2 = ((pCanMsg->Id & 0x1FFF0000ul) >> 16) | u32Dir | CAN_IF_ARB2_XTD_Msk | CAN_IF_ARB2_MSGVAL_Msk;
+    }
+    psIF->DAT_A1 = ((uint32_t)pCanMsg->Data[1] << 8) | pCanMsg->Data[0];
+    psIF->DAT_A2 = ((uint32_t)pCanMsg->Data[3] << 8) | pCanMsg->Data[2];
+    psIF->DAT_B1 = ((uint32_t)pCanMsg->Data[5] << 8) | pCanMsg->Data[4];
+    psIF->DAT_B2 = ((uint32_t)pCanMsg->Data[7] << 8) | pCanMsg->Data[6];
+    psIF->MCON = CAN_IF_MCON_NEWDAT_Msk | CAN_IF_MCON_TxRqst_Msk | CAN_IF_MCON_TXIE_Msk | CAN_IF_MCON_EOB_Msk |
+                 (pCanMsg->DLC & CAN_IF_MCON_DLC_Msk);
+    can_transfer(tCAN, u32Obj);
+}
+
+/*
+ * Load the highest priority frames waiting. The controller sends the lowest
+ * pending object first, so objects are loaded in ascending order and reused
+ * from the first only once all are sent: frames leave in the order loaded.
+ */
+static void can_tx_fill(CAN_QUEUE_T *psQueue)
+{
+    CAN_TXENTRY_T sEntry;
+    uint32_t n, u32Bytes;
+
+    while(psQueue->u32TxCount)
+    {
+        if(psQueue->u32TxNext == psQueue->u32TxObjs)
+        {
+            if(psQueue->u32TxFree != (1ul << psQueue->u32TxObjs) - 1ul)
+                break;
+            psQueue->u32TxNext = 0ul;
+        }
+        n = psQueue->u32TxNext++;
+        can_heap_pop(psQueue, &sEntry);
+
+        u32Bytes = sEntry.sMsg.FrameType == CAN_REMOTE_FRAME ? 0ul : (sEntry.sMsg.DLC > 8u ? 8ul : sEntry.sMsg.DLC);
+        psQueue->au8TxBits[n] = (uint8_t)can_bits(sEntry.sMsg.IdType, u32Bytes);
+        psQueue->u32TxFree &= ~(1ul << n);
+        can_tx_load(psQueue->tCAN, psQueue->u32RxObjs + n, &sEntry.sMsg);
+    }
+}
+
+static void can_clr_pending(CAN_T *tCAN, uint32_t u32Obj)
+{
+    tCAN->IF[CAN_QUEUE_IF].CMASK = CAN_IF_CMASK_CLRINTPND_Msk;
+    can_transfer(tCAN, u32Obj);
+}
+
+/* Configure a receive FIFO object accepting every frame */
+static void can_rx_setup(CAN_T *tCAN, uint32_t u32Obj, uint32_t u32Last)
+{
+    CAN_IF_T *psIF = &tCAN->IF[CAN_QUEUE_IF];
+
+    psIF->CMASK = CAN_IF_CMASK_WRRD_Msk | CAN_IF_CMASK_MASK_Msk | CAN_IF_CMASK_ARB_Msk | CAN_IF_CMASK_CONTROL_Msk;
+    psIF->MASK1 = 0ul;
+    psIF->MASK2 = 0ul;
+    psIF->ARB1 = 0ul;
+    psIF->ARB2 = CAN_IF_ARB2_MSGVAL_Msk;
+    psIF->MCON = CAN_IF_MCON_UMASK_Msk | CAN_IF_MCON_RXIE_Msk | (u32Last ? CAN_IF_MCON_EOB_Msk : 0ul);
+    can_transfer(tCAN, u32Obj);
+}
+
+static void can_invalidate(CAN_T *tCAN, uint32_t u32Obj)
+{
+    CAN_IF_T *psIF = &tCAN->IF[CAN_QUEUE_IF];
+
+    psIF->CMASK = CAN_IF_CMASK_WRRD_Msk | CAN_IF_CMASK_ARB_Msk | CAN_IF_CMASK_CONTROL_Msk;
+    psIF->ARB1 = 0ul;
+    psIF->ARB2 = 0ul;
+    psIF->MCON = 0ul;
+    can_transfer(tCAN, u32Obj);
+}
+
+/* Read a receive FIFO object, releasing it, and store the frame */
+static void can_rx_read(CAN_QUEUE_T *psQueue, uint32_t u32Obj)
+{
+    CAN_T *tCAN = psQueue->tCAN;
+    CAN_IF_T *psIF = &tCAN->IF[CAN_QUEUE_IF];
+    CAN_FRAME_T *psFrame;
+    uint32_t u32Mcon, u32Arb2, u32IdType, u32ID, u32Dlc, u32Head, u32Data;
+
+    psIF->CMASK = CAN_IF_CMASK_ARB_Msk | CAN_IF_CMASK_CONTROL_Msk | CAN_IF_CMASK_CLRINTPND_Msk |
+                  CAN_IF_CMASK_TXRQSTNEWDAT_Msk | CAN_IF_CMASK_DATAA_Msk | CAN_IF_CMASK_DATAB_Msk;
+    can_transfer(tCAN, u32Obj);
+
+    u32Mcon = psIF->MCON;
+    u32Arb2 = psIF->ARB2;
+    if(u32Arb2 & CAN_IF_ARB2_XTD_Msk)
+    {
+        u32IdType = CAN_EXT_ID;
+        u32ID = ((u32Arb2 & 0x1FFFul) << 16) | (psIF->ARB1 & 0xFFFFul);
+    }
+    else
+    {
+        u32IdType = CAN_STD_ID;
+        u32ID = (u32Arb2 & CAN_IF_ARB2_ID_Msk) >> 2;
+    }
+    u32Dlc = u32Mcon & CAN_IF_MCON_DLC_Msk;
+    psQueue->u32Bits += can_bits(u32IdType, u32Dlc > 8ul ? 8ul : u32Dlc);
+
+    if(u32Mcon & CAN_IF_MCON_MsgLst_Msk)
+    {
+        /* The FIFO was full and its last object overwritten */
+        psQueue->u32RxLost++;
+        psIF->CMASK = CAN_IF_CMASK_WRRD_Msk | CAN_IF_CMASK_CONTROL_Msk;
+        psIF->MCON = CAN_IF_MCON_UMASK_Msk | CAN_IF_MCON_RXIE_Msk |
+                     (u32Obj == psQueue->u32RxObjs - 1ul ? CAN_IF_MCON_EOB_Msk : 0ul);
+        can_transfer(tCAN, u32Obj);
+    }
+
+    if(psQueue->u32Filter && !can_accept(psQueue, u32IdType, u32ID))
+    {
+        psQueue->u32RxFiltered++;
+        return;
+    }
+
+    u32Head = psQueue->u32RxHead;
+    if(u32Head - psQueue->u32RxTail == psQueue->u32RxSize)
+    {
+        psQueue->u32RxOverruns++;
+        return;
+    }
+
+    psFrame = &psQueue->psRx[u32Head & (psQueue->u32RxSize - 1ul)];
+    psFrame->sMsg.IdType = u32IdType;
+    psFrame->sMsg.FrameType = CAN_DATA_FRAME;
+    psFrame->sMsg.Id = u32ID;
+    psFrame->sMsg.DLC = (uint8_t)u32Dlc;
+    u32Data = psIF->DAT_A1;
+    psFrame->sMsg.Data[0] = (uint8_t)u32Data;
+    psFrame->sMsg.Data[1] = (uint8_t)(u32Data >> 8);
+    u32Data = psIF->DAT_A2;
+    psFrame->sMsg.Data[2] = (uint8_t)u32Data;
+    psFrame->sMsg.Data[3] = (uint8_t)(u32Data >> 8);
+    u32Data = psIF->DAT_B1;
+    psFrame->sMsg.Data[4] = (uint8_t)u32Data;
+    psFrame->sMsg.Data[5] = (uint8_t)(u32Data >> 8);
+    u32Data = psIF->DAT_B2;
+    psFrame->sMsg.Data[6] = (uint8_t)u32Data;
+    psFrame->sMsg.Data[7] = (uint8_t)(u32Data >> 8);
+    psFrame->u32Time = can_clock(psQueue);
+
+    psQueue->u32RxFrames++;
+    psQueue->u32RxHead = u32Head + 1ul;
+}
+
+/* Drain the receive FIFO, lowest object first, returning the frames read */
+static uint32_t can_rx_drain(CAN_QUEUE_T *psQueue)
+{
+    CAN_T *tCAN = psQueue->tCAN;
+    uint32_t u32Mask = psQueue->u32RxObjs >= 32ul ? 0xFFFFFFFFul : (1ul << psQueue->u32RxObjs) - 1ul;
+    uint32_t u32New, u32Obj, u32Read = 0ul;
+
+    /* A frame arriving meanwhile takes the lowest free object, so rescan from the lowest */
+    while((u32New = (((tCAN->NDAT2 & 0xFFFFul) << 16) | (tCAN->NDAT1 & 0xFFFFul)) & u32Mask) != 0ul)
+    {
+        for(u32Obj = 0ul; !(u32New & 1ul); u32New >>= 1)
+            u32Obj++;
+        can_rx_read(psQueue, u32Obj);
+        u32Read++;
+    }
+    return u32Read;
+}
+
+static void can_status(CAN_QUEUE_T *psQueue)
+{
+    CAN_T *tCAN = psQueue->tCAN;
+    uint32_t u32Status = tCAN->STATUS;
+    uint32_t u32Lec = u32Status & CAN_STATUS_LEC_Msk;
+    uint32_t u32New = u32Status & ~psQueue->u32Status & CAN_ERR_STATE_MSK;
+
+    /* LEC 7 is never set by the controller, it marks the code as seen */
+    if((u32Lec != 0ul) && (u32Lec != 7ul))
+        psQueue->au32Lec[u32Lec]++;
+    tCAN->STATUS = 7ul << CAN_STATUS_LEC_Pos;
+
+    if(u32New & CAN_STATUS_EWARN_Msk)
+        psQueue->u32Warnings++;
+    if(u32New & CAN_STATUS_EPASS_Msk)
+        psQueue->u32Passive++;
+    if(u32New & CAN_STATUS_BOFF_Msk)
+        psQueue->u32BusOff++;
+    psQueue->u32Status = u32Status & CAN_ERR_STATE_MSK;
+
+    /* Bus-off sets INIT; clearing it starts the recovery of 128 x 11 recessive bits */
+    if((u32Status & CAN_STATUS_BOFF_Msk) && (tCAN->CON & CAN_CON_INIT_Msk))
+        tCAN->CON &= ~CAN_CON_INIT_Msk;
+}
+
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+  * @brief Start an interrupt-driven CAN queue.
+  *
+  * @param[in] psQueue The queue.
+  * @param[in] tCAN The pointer to CAN module base address, opened by CAN_Open() in normal mode.
+  * @param[in] u32RxObjs Message objects of the receive FIFO, objects 0 to u32RxObjs - 1.
+  * @param[in] u32TxObjs Message objects sending the transmit queue, the next ones. u32RxObjs + u32TxObjs
+  *                      may be up to \ref CAN_QUEUE_OBJS.
+  * @param[in] psRxBuf Receive ring.
+  * @param[in] u32RxSize Frames in psRxBuf, a power of 2.
+  * @param[in] psTxBuf Transmit queue.
+  * @param[in] u32TxSize Frames in psTxBuf. Without transmit objects the queue only receives and
+  *                      CAN_QueueSend() fails.
+  *
+  * @retval TRUE Success
+  * @retval FALSE Invalid argument, a queue already runs on tCAN, or IF2 stayed in use
+  *
+  * @details The interrupt of tCAN is installed at IRQ_LEVEL_1 with the module and error interrupts
+  *          enabled. Bus errors are counted on status interrupts only; CAN_EnableInt() with
+  *          \ref CAN_CON_SIE_Msk as well counts each of them, for an interrupt per frame.
+  *          Message objects beyond the queue stay free for the other functions of this driver.
+  */
+int32_t CAN_QueueOpen(CAN_QUEUE_T *psQueue, CAN_T *tCAN, uint32_t u32RxObjs, uint32_t u32TxObjs,
+                      CAN_FRAME_T *psRxBuf, uint32_t u32RxSize, CAN_TXENTRY_T *psTxBuf, uint32_t u32TxSize)
+{
+    uint32_t u32No = can_no(tCAN), i;
+
+    if((u32No >= 4ul) || (s_apsQueue[u32No] != NULL) || (u32RxObjs == 0ul) ||
+            (u32RxObjs + u32TxObjs > CAN_QUEUE_OBJS) || (u32RxSize == 0ul) || (u32RxSize & (u32RxSize - 1ul)) ||
+            (u32TxObjs && (u32TxSize == 0ul)))
+    {
+        return (int32_t)FALSE;
+    }
+    if(CAN_ReserveIF(tCAN, (uint32_t)TRUE) == (int32_t)FALSE)
+    {
+        return (int32_t)FALSE;
+    }
+
+    memset(psQueue, 0, sizeof(CAN_QUEUE_T));
+    psQueue->tCAN = tCAN;
+    psQueue->u32RxObjs = u32RxObjs;
+    psQueue->u32TxObjs = u32TxObjs;
+    psQueue->u32TxFree = (1ul << u32TxObjs) - 1ul;
+    psQueue->psRx = psRxBuf;
+    psQueue->u32RxSize = u32RxSize;
+    psQueue->psTx = psTxBuf;
+    psQueue->u32TxSize = u32TxObjs ? u32TxSize : 0ul;
+
+    CAN_DisableInt(tCAN, CAN_INT_MSK);
+    for(i = 0ul; i < u32RxObjs; i++)
+        can_rx_setup(tCAN, i, i == u32RxObjs - 1ul);
+    for(i = u32RxObjs; i < u32RxObjs + u32TxObjs; i++)
+        can_invalidate(tCAN, i);
+    tCAN->STATUS = 7ul << CAN_STATUS_LEC_Pos;
+
+    s_apsQueue[u32No] = psQueue;
+    sysInstallISR(IRQ_LEVEL_1, s_aeCanIrq[u32No], (PVOID)s_apfnIsr[u32No]);
+    sysSetLocalInterrupt(ENABLE_IRQ);
+    sysEnableInterrupt(s_aeCanIrq[u32No]);
+    CAN_EnableInt(tCAN, CAN_CON_IE_Msk | CAN_CON_EIE_Msk);
+
+    return (int32_t)TRUE;
+}
+
+/**
+  * @brief Stop a CAN queue.
+  *
+  * @param[in] psQueue The queue.
+  *
+  * @return None
+  *
+  * @details The message objects of the queue are invalidated, frames waiting to be sent are dropped
+  *          and IF2 is released. Frames in the receive ring stay readable.
+  */
+void CAN_QueueClose(CAN_QUEUE_T *psQueue)
+{
+    CAN_T *tCAN = psQueue->tCAN;
+    uint32_t u32No = can_no(tCAN), i;
+
+    if((u32No >= 4ul) || (s_apsQueue[u32No] != psQueue))
+        return;
+
+    CAN_DisableInt(tCAN, CAN_INT_MSK);
+    sysDisableInterrupt(s_aeCanIrq[u32No]);
+    for(i = 0ul; i < psQueue->u32RxObjs + psQueue->u32TxObjs; i++)
+        can_invalidate(tCAN, i);
+    psQueue->u32TxCount = 0ul;
+    psQueue->u32TxFree = (1ul << psQueue->u32TxObjs) - 1ul;
+    psQueue->u32TxNext = 0ul;
+
+    s_apsQueue[u32No] = NULL;
+    CAN_ReserveIF(tCAN, (uint32_t)FALSE);
+}
+
+/**
+  * @brief Interrupt handler of a CAN queue.
+  *
+  * @param[in] psQueue The queue.
+  *
+  * @return None
+  *
+  * @details Installed by CAN_QueueOpen(). Serves every pending interrupt: drains the receive FIFO,
+  *          refills the transmit objects and counts bus errors and error state changes.
+  */
+void CAN_QueueIRQHandler(CAN_QUEUE_T *psQueue)
+{
+    CAN_T *tCAN = psQueue->tCAN;
+    uint32_t t0 = can_clock(psQueue);
+    uint32_t u32IntId, u32Obj, n;
+
+    while((u32IntId = tCAN->IIDR & CAN_IIDR_IntId_Msk) != 0ul)
+    {
+        if(u32IntId > CAN_QUEUE_OBJS)
+        {
+            /* 0x8000, status interrupt, reading STATUS clears it */
+            can_status(psQueue);
+            continue;
+        }
+
+        u32Obj = u32IntId - 1ul;
+        if(u32Obj < psQueue->u32RxObjs)
+        {
+            if(can_rx_drain(psQueue) == 0ul)
+                can_clr_pending(tCAN, u32Obj);
+        }
+        else if(u32Obj < psQueue->u32RxObjs + psQueue->u32TxObjs)
+        {
+            n = u32Obj - psQueue->u32RxObjs;
+            can_clr_pending(tCAN, u32Obj);
+            if(!(psQueue->u32TxFree & (1ul << n)))
+            {
+                psQueue->u32TxFrames++;
+                psQueue->u32Bits += psQueue->au8TxBits[n];
+                psQueue->u32TxFree |= 1ul << n;
+            }
+            can_tx_fill(psQueue);
+        }
+        else
+        {
+            /* An object not of the queue */
+            can_clr_pending(tCAN, u32Obj);
+        }
+    }
+
+    psQueue->u32Ticks += (can_clock(psQueue) - t0) & psQueue->u32ClockMask;
+}
+
+/**
+  * @brief Queue a frame for transmission.
+  *
+  * @param[in] psQueue The queue.
+  * @param[in] pCanMsg The frame. FrameType \ref CAN_REMOTE_FRAME sends a remote frame.
+  *
+  * @retval TRUE The frame is queued.
+  * @retval FALSE The transmit queue is full.
+  *
+  * @details Frames leave in arbitration order, the lowest identifier first and, among equal ones,
+  *          in the order queued. Frames already loaded into the transmit objects are not overtaken,
+  *          so a frame may wait for up to u32TxObjs frames of lower priority; in exchange the bus
+  *          idles only once per u32TxObjs frames, while the interrupt reloads the objects.
+  */
+int32_t CAN_QueueSend(CAN_QUEUE_T *psQueue, STR_CANMSG_T *pCanMsg)
+{
+    int32_t rev = (int32_t)TRUE;
+    uint32_t u32IntMask;
+
+    u32IntMask = can_lock(psQueue->tCAN);
+    if(psQueue->u32TxCount == psQueue->u32TxSize)
+    {
+        psQueue->u32TxFull++;
+        rev = (int32_t)FALSE;
+    }
+    else
+    {
+        can_heap_push(psQueue, pCanMsg);
+        can_tx_fill(psQueue);
+    }
+    can_unlock(psQueue->tCAN, u32IntMask);
+
+    return rev;
+}
+
+/**
+  * @brief Take the oldest received frame.
+  *
+  * @param[in] psQueue The queue.
+  * @param[out] psFrame The frame and its time of reception.
+  *
+  * @retval TRUE A frame was taken.
+  * @retval FALSE The receive ring is empty.
+  *
+  * @details Only one reader may call this per queue; it needs no lock against the interrupt.
+  */
+int32_t CAN_QueueReceive(CAN_QUEUE_T *psQueue, CAN_FRAME_T *psFrame)
+{
+    uint32_t u32Tail = psQueue->u32RxTail;
+
+    if(psQueue->u32RxHead == u32Tail)
+        return (int32_t)FALSE;
+
+    *psFrame = psQueue->psRx[u32Tail & (psQueue->u32RxSize - 1ul)];
+    psQueue->u32RxTail = u32Tail + 1ul;
+
+    return (int32_t)TRUE;
+}
+
+/**
+  * @brief Frames waiting in the receive ring.
+  *
+  * @param[in] psQueue The queue.
+  *
+  * @return Frames
+  */
+uint32_t CAN_QueueRxCount(CAN_QUEUE_T *psQueue)
+{
+    return psQueue->u32RxHead - psQueue->u32RxTail;
+}
+
+/**
+  * @brief Frames not yet sent.
+  *
+  * @param[in] psQueue The queue.
+  *
+  * @return Frames in the transmit queue and in the transmit objects.
+  */
+uint32_t CAN_QueueTxCount(CAN_QUEUE_T *psQueue)
+{
+    uint32_t u32IntMask, u32Busy, u32Count;
+
+    u32IntMask = can_lock(psQueue->tCAN);
+    u32Busy = ~psQueue->u32TxFree & ((1ul << psQueue->u32TxObjs) - 1ul);
+    u32Count = psQueue->u32TxCount;
+    can_unlock(psQueue->tCAN, u32IntMask);
+
+    for(; u32Busy; u32Busy &= u32Busy - 1ul)
+        u32Count++;
+    return u32Count;
+}
+
+/**
+  * @brief Enable the software ID filter, empty.
+  *
+  * @param[in] psQueue The queue.
+  * @param[in] pu32ExtTable Storage of the extended ID set, NULL to reject every extended frame.
+  * @param[in] u32ExtSize Entries in pu32ExtTable, a power of 2. It holds up to 3/4 as many IDs.
+  *
+  * @return None
+  *
+  * @details Frames are rejected until their IDs are added by CAN_QueueAddId(). Standard IDs are
+  *          looked up in a bitmap, extended ones in a hash set, both in constant time.
+  */
+void CAN_QueueEnableFilter(CAN_QUEUE_T *psQueue, uint32_t *pu32ExtTable, uint32_t u32ExtSize)
+{
+    uint32_t u32IntMask;
+
+    u32IntMask = can_lock(psQueue->tCAN);
+    memset(psQueue->au32StdFilter, 0, sizeof(psQueue->au32StdFilter));
+    psQueue->pu32ExtFilter = pu32ExtTable;
+    psQueue->u32ExtSize = (pu32ExtTable != NULL) && u32ExtSize && !(u32ExtSize & (u32ExtSize - 1ul)) ? u32ExtSize : 0ul;
+    psQueue->u32ExtCount = 0ul;
+    if(psQueue->u32ExtSize)
+        memset(pu32ExtTable, 0, u32ExtSize * sizeof(uint32_t));
+    psQueue->u32Filter = 1ul;
+    can_unlock(psQueue->tCAN, u32IntMask);
+}
+
+/**
+  * @brief Disable the software ID filter, accepting every frame.
+  *
+  * @param[in] psQueue The queue.
+  *
+  * @return None
+  */
+void CAN_QueueDisableFilter(CAN_QUEUE_T *psQueue)
+{
+    psQueue->u32Filter = 0ul;
+}
+
+/**
+  * @brief Accept an ID in the software filter.
+  *
+  * @param[in] psQueue The queue.
+  * @param[in] u32IDType \ref CAN_STD_ID or \ref CAN_EXT_ID.
+  * @param[in] u32ID The identifier.
+  *
+  * @retval TRUE The ID is accepted.
+  * @retval FALSE The extended ID set is full or missing.
+  */
+int32_t CAN_QueueAddId(CAN_QUEUE_T *psQueue, uint32_t u32IDType, uint32_t u32ID)
+{
+    int32_t rev = (int32_t)TRUE;
+    uint32_t u32IntMask, i;
+
+    u32IntMask = can_lock(psQueue->tCAN);
+    if(u32IDType == CAN_STD_ID)
+    {
+        u32ID &= 0x7FFul;
+        psQueue->au32StdFilter[u32ID >> 5] |= 1ul << (u32ID & 31ul);
+    }
+    else if(can_ext_find(psQueue, u32ID & 0x1FFFFFFFul) != psQueue->u32ExtSize)
+    {
+        /* Present already */
+    }
+    else if(4ul * (psQueue->u32ExtCount + 1ul) > 3ul * psQueue->u32ExtSize)
+    {
+        rev = (int32_t)FALSE;
+    }
+    else
+    {
+        u32ID &= 0x1FFFFFFFul;
+        for(i = can_hash(psQueue, u32ID); psQueue->pu32ExtFilter[i]; i = (i + 1ul) & (psQueue->u32ExtSize - 1ul));
+        psQueue->pu32ExtFilter[i] = u32ID | CAN_EXT_USED;
+        psQueue->u32ExtCount++;
+    }
+    can_unlock(psQueue->tCAN, u32IntMask);
+
+    return rev;
+}
+
+/**
+  * @brief Reject an ID in the software filter.
+  *
+  * @param[in] psQueue The queue.
+  * @param[in] u32IDType \ref CAN_STD_ID or \ref CAN_EXT_ID.
+  * @param[in] u32ID The identifier.
+  *
+  * @retval TRUE The ID was accepted before.
+  * @retval FALSE The ID was not accepted.
+  */
+int32_t CAN_QueueRemoveId(CAN_QUEUE_T *psQueue, uint32_t u32IDType, uint32_t u32ID)
+{
+    int32_t rev = (int32_t)TRUE;
+    uint32_t *pu32Set = psQueue->pu32ExtFilter;
+    uint32_t u32Mask = psQueue->u32ExtSize - 1ul;
+    uint32_t u32IntMask, i, j, k;
+
+    u32IntMask = can_lock(psQueue->tCAN);
+    if(u32IDType == CAN_STD_ID)
+    {
+        u32ID &= 0x7FFul;
+        rev = (psQueue->au32StdFilter[u32ID >> 5] >> (u32ID & 31ul)) & 1ul;
+        psQueue->au32StdFilter[u32ID >> 5] &= ~(1ul << (u32ID & 31ul));
+    }
+    else if((i = can_ext_find(psQueue, u32ID & 0x1FFFFFFFul)) == psQueue->u32ExtSize)
+    {
+        rev = (int32_t)FALSE;
+    }
+    else
+    {
+        /* Shift back the entries of the probe run that may no longer be reached past slot i */
+        for(j = i; pu32Set[j = (j + 1ul) & u32Mask];)
+        {
+            k = can_hash(psQueue, pu32Set[j] & ~CAN_EXT_USED);
+            if((i <= j) ? ((i < k) && (k <= j)) : ((i < k) || (k <= j)))
+                continue;
+            pu32Set[i] = pu32Set[j];
+            i = j;
+        }
+        pu32Set[i] = 0ul;
+        psQueue->u32ExtCount--;
+    }
+    can_unlock(psQueue->tCAN, u32IntMask);
+
+    return rev;
+}
+
+/**
+  * @brief Set the clock of the timestamps, the bus load and the interrupt time.
+  *
+  * @param[in] psQueue The queue.
+  * @param[in] pfnClock Free-running counter, ETIMER_GetCounter() of a continuous timer for example,
+  *                     NULL for none.
+  * @param[in] u32Mask Valid bits of pfnClock(), 0xFFFFFF for an ETIMER.
+  * @param[in] u32Hz Rate of pfnClock().
+  *
+  * @return None
+  */
+void CAN_QueueSetClock(CAN_QUEUE_T *psQueue, uint32_t (*pfnClock)(void), uint32_t u32Mask, uint32_t u32Hz)
+{
+    uint32_t u32IntMask;
+
+    u32IntMask = can_lock(psQueue->tCAN);
+    psQueue->pfnClock = pfnClock;
+    psQueue->u32ClockMask = u32Mask;
+    psQueue->u32ClockHz = u32Hz;
+    psQueue->u32LoadTime = can_clock(psQueue);
+    psQueue->u32Bits = 0ul;
+    can_unlock(psQueue->tCAN, u32IntMask);
+}
+
+/**
+  * @brief Bus load since the last call.
+  *
+  * @param[in] psQueue The queue.
+  *
+  * @return Load in 0.01 %, 0 without a clock.
+  *
+  * @details The load counts the frames this node sent and received, those rejected by the software
+  *          filter included, at their nominal length without stuff bits, against the bit rate of
+  *          CAN_GetCANBitRate(). The calls must come within one period of the clock.
+  */
+uint32_t CAN_QueueBusLoad(CAN_QUEUE_T *psQueue)
+{
+    uint32_t u32IntMask, u32Now, u32Bits, u32Elapsed, u32Rate;
+
+    if(psQueue->pfnClock == NULL)
+        return 0ul;
+
+    u32IntMask = can_lock(psQueue->tCAN);
+    u32Now = can_clock(psQueue);
+    u32Bits = psQueue->u32Bits;
+    psQueue->u32Bits = 0ul;
+    can_unlock(psQueue->tCAN, u32IntMask);
+
+    u32Elapsed = (u32Now - psQueue->u32LoadTime) & psQueue->u32ClockMask;
+    psQueue->u32LoadTime = u32Now;
+    u32Rate = CAN_GetCANBitRate(psQueue->tCAN);
+    if((u32Elapsed == 0ul) || (u32Rate == 0ul))
+        return 0ul;
+
+    return (uint32_t)((uint64_t)u32Bits * 10000ull * psQueue->u32ClockHz / ((uint64_t)u32Rate * u32Elapsed));
+}
+
+/*@}*/ /* end of group CAN_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group CAN_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
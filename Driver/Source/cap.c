@@ -7,6 +7,7 @@
 *****************************************************************************/
 
 #include "nuc980.h"
+#include "sys.h"
 #include "cap.h"
 /** @addtogroup Standard_Driver Standard Driver
   @{
@@ -390,6 +391,296 @@ void CAP_DisableMotionDet(CAP_T * VCAP)
     VCAP->MD &= ~CAP_MD_MDEN_Msk;
 }
 
+/// @cond HIDDEN_SYMBOLS
+#define CAP_FQ_FREE     0       /* In the free ring */
+#define CAP_FQ_ACTIVE   1       /* Being captured */
+#define CAP_FQ_READY    2       /* In the ready ring */
+#define CAP_FQ_USER     3       /* Held by the consumer */
+
+#define CAP_INT_FLAGS   (CAP_INT_VINTF_Msk | CAP_INT_MEINTF_Msk | CAP_INT_ADDRMINTF_Msk | CAP_INT_MDINTF_Msk)
+
+static void CAP_FQ_PutFree(CAP_FQ_T *psQ, uint32_t u32Idx)
+{
+    psQ->au8Free[(psQ->u32FreeHead + psQ->u32FreeCnt++) % psQ->u32Num] = (uint8_t)u32Idx;
+    psQ->au8State[u32Idx] = CAP_FQ_FREE;
+}
+
+static uint32_t CAP_FQ_GetFree(CAP_FQ_T *psQ)
+{
+    uint32_t u32Idx = psQ->au8Free[psQ->u32FreeHead];
+
+    psQ->u32FreeHead = (psQ->u32FreeHead + 1) % psQ->u32Num;
+    psQ->u32FreeCnt--;
+    return u32Idx;
+}
+
+static uint32_t CAP_FQ_GetReady(CAP_FQ_T *psQ)
+{
+    uint32_t u32Idx = psQ->au8Ready[psQ->u32ReadyHead];
+
+    psQ->u32ReadyHead = (psQ->u32ReadyHead + 1) % psQ->u32Num;
+    psQ->u32ReadyCnt--;
+    return u32Idx;
+}
+
+/* Point the engine at a buffer from the next frame on */
+static void CAP_FQ_SetActive(CAP_FQ_T *psQ, uint32_t u32Idx)
+{
+    CAP_FRAME_T *psFrame = &psQ->asFrame[u32Idx];
+
+    psQ->u32Active = u32Idx;
+    psQ->au8State[u32Idx] = CAP_FQ_ACTIVE;
+    if (psQ->VCAP->CTL & CAP_CTL_PLNEN_Msk)
+    {
+        psQ->VCAP->YBA = psFrame->au32Addr[0];
+        psQ->VCAP->UBA = psFrame->au32Addr[1];
+        psQ->VCAP->VBA = psFrame->au32Addr[2];
+    }
+    else
+        psQ->VCAP->PKTBA0 = psFrame->au32Addr[0];
+    psQ->VCAP->CTL |= CAP_CTL_UPDATE_Msk;
+}
+
+static uint32_t CAP_FQ_Lock(void)
+{
+    uint32_t u32IBit = sysGetIBitState();
+
+    sysSetLocalInterrupt(DISABLE_IRQ);
+    return u32IBit;
+}
+
+static void CAP_FQ_Unlock(uint32_t u32IBit)
+{
+    if (u32IBit)
+        sysSetLocalInterrupt(ENABLE_IRQ);
+}
+/// @endcond HIDDEN_SYMBOLS
+
+/**
+ * @brief     Set up a frame queue over u32Num buffers
+ *
+ * @param[in]  psQ: Frame queue
+ *
+ * @param[in]  VCAP: The pointer of the specified CAP module, opened with \ref CAP_CTL_PKTEN or \ref CAP_CTL_PLNEN
+ *
+ * @param[in]  u32Base: Address of the first buffer, 32-byte aligned. The buffers follow each other,
+ *                      each of u32YLen + 2 * u32UVLen bytes rounded up to 32 bytes.
+ *
+ * @param[in]  u32Num: Number of buffers, 2 ~ \ref CAP_FQ_DEPTH_MAX
+ *
+ * @param[in]  u32YLen: Bytes of the packet frame, or of the Y plane
+ *
+ * @param[in]  u32UVLen: Bytes of each of the U and V planes, 0 for packet output
+ *
+ * @param[in]  u32Mode: What a frame end without a free buffer does. It could be
+ *                      - \ref CAP_FQ_DROP_NEW
+ *                      - \ref CAP_FQ_DROP_OLD
+ *
+ * @retval    0                 Success
+ * @retval    CAP_INVALID_BUF   Bad buffer count or alignment
+ *
+ * @details   All buffers start free. Cacheable buffers are invalidated here and whenever the
+ *            consumer queues them back; the ARM926 does not fetch lines speculatively, so the
+ *            consumer reads a dequeued frame from memory without further maintenance.
+ */
+int32_t CAP_FQ_Init(CAP_FQ_T *psQ, CAP_T *VCAP, uint32_t u32Base, uint32_t u32Num, uint32_t u32YLen, uint32_t u32UVLen, uint32_t u32Mode)
+{
+    uint32_t i, u32Stride;
+
+    if ((u32Num < 2) || (u32Num > CAP_FQ_DEPTH_MAX) || (u32Base & 31) || !u32YLen)
+        return CAP_INVALID_BUF;
+
+    psQ->VCAP = VCAP;
+    psQ->u32Num = u32Num;
+    psQ->u32Mode = u32Mode;
+    psQ->u32Size = u32YLen + 2 * u32UVLen;
+    psQ->pfnClock = 0;
+    psQ->u32FreeHead = psQ->u32FreeCnt = 0;
+    psQ->u32ReadyHead = psQ->u32ReadyCnt = 0;
+    psQ->u32Active = u32Num;
+    psQ->u32Seq = psQ->u32Dropped = 0;
+
+    u32Stride = (psQ->u32Size + 31) & ~31;
+    for (i = 0; i < u32Num; i++)
+    {
+        psQ->asFrame[i].u32Index = i;
+        psQ->asFrame[i].u32Seq = 0;
+        psQ->asFrame[i].u32Time = 0;
+        psQ->asFrame[i].au32Addr[0] = u32Base + i * u32Stride;
+        psQ->asFrame[i].au32Addr[1] = psQ->asFrame[i].au32Addr[0] + u32YLen;
+        psQ->asFrame[i].au32Addr[2] = psQ->asFrame[i].au32Addr[1] + u32UVLen;
+        CAP_FQ_PutFree(psQ, i);
+    }
+    sysInvalidateDCacheRange(u32Base, u32Num * u32Stride);
+    return 0;
+}
+
+/**
+ * @brief     Set the time stamp source of a frame queue
+ *
+ * @param[in]  psQ: Frame queue
+ *
+ * @param[in]  pfnClock: Function returning the current time, called in interrupt context. NULL for none.
+ *
+ * @return    None
+ */
+void CAP_FQ_SetClock(CAP_FQ_T *psQ, uint32_t (*pfnClock)(void))
+{
+    psQ->pfnClock = pfnClock;
+}
+
+/**
+ * @brief     Start capturing into the queue
+ *
+ * @param[in]  psQ: Frame queue
+ *
+ * @return    None
+ *
+ * @details   Takes the oldest free buffer, or the oldest ready frame if none is free, and starts
+ *            the engine. The frame end interrupt must be enabled with \ref CAP_INT_VIEN_Msk and
+ *            its handler must call CAP_FQ_IRQHandler().
+ */
+void CAP_FQ_Start(CAP_FQ_T *psQ)
+{
+    uint32_t u32IBit = CAP_FQ_Lock();
+
+    if (psQ->u32Active == psQ->u32Num)
+    {
+        if (psQ->u32FreeCnt)
+            CAP_FQ_SetActive(psQ, CAP_FQ_GetFree(psQ));
+        else if (psQ->u32ReadyCnt)
+            CAP_FQ_SetActive(psQ, CAP_FQ_GetReady(psQ));
+    }
+    CAP_FQ_Unlock(u32IBit);
+    if (psQ->u32Active != psQ->u32Num)
+        CAP_Start(psQ->VCAP);
+}
+
+/**
+ * @brief     Stop capturing into the queue
+ *
+ * @param[in]  psQ: Frame queue
+ *
+ * @return    None
+ *
+ * @details   Stops the engine now. The partly captured buffer goes back to the free ring,
+ *            ready frames stay queued.
+ */
+void CAP_FQ_Stop(CAP_FQ_T *psQ)
+{
+    uint32_t u32IBit;
+
+    CAP_Stop(psQ->VCAP, FALSE);
+    u32IBit = CAP_FQ_Lock();
+    if (psQ->u32Active != psQ->u32Num)
+    {
+        CAP_FQ_PutFree(psQ, psQ->u32Active);
+        psQ->u32Active = psQ->u32Num;
+    }
+    CAP_FQ_Unlock(u32IBit);
+}
+
+/**
+ * @brief     Frame end service of a frame queue
+ *
+ * @param[in]  psQ: Frame queue
+ *
+ * @retval    0   No frame end pending
+ * @retval    1   A frame ended and was queued or dropped
+ *
+ * @details   Call from the CAP interrupt handler. Clears the frame end flag only, other flags
+ *            are left to the caller. The finished buffer is stamped and queued as ready and
+ *            the engine is pointed at the next free buffer, which the engine takes at the next
+ *            frame start. Without a free buffer the frame is dropped as set by u32Mode.
+ */
+uint32_t CAP_FQ_IRQHandler(CAP_FQ_T *psQ)
+{
+    CAP_T *VCAP = psQ->VCAP;
+    CAP_FRAME_T *psFrame;
+    uint32_t u32Int = VCAP->INT;
+
+    if ((u32Int & (CAP_INT_VIEN_Msk | CAP_INT_VINTF_Msk)) != (CAP_INT_VIEN_Msk | CAP_INT_VINTF_Msk))
+        return 0;
+    /* Write-one-to-clear: leave the other flags pending */
+    VCAP->INT = (u32Int & ~CAP_INT_FLAGS) | CAP_INT_VINTF_Msk;
+
+    psQ->u32Seq++;
+    if (psQ->u32Active == psQ->u32Num)
+        return 1;
+
+    if (!psQ->u32FreeCnt && psQ->u32ReadyCnt && (psQ->u32Mode == CAP_FQ_DROP_OLD))
+    {
+        CAP_FQ_PutFree(psQ, CAP_FQ_GetReady(psQ));
+        psQ->u32Dropped++;
+    }
+    if (!psQ->u32FreeCnt)
+    {
+        /* The next frame overwrites this one */
+        psQ->u32Dropped++;
+        return 1;
+    }
+
+    psFrame = &psQ->asFrame[psQ->u32Active];
+    psFrame->u32Seq = psQ->u32Seq;
+    psFrame->u32Time = psQ->pfnClock ? psQ->pfnClock() : 0;
+    psQ->au8State[psQ->u32Active] = CAP_FQ_READY;
+    psQ->au8Ready[(psQ->u32ReadyHead + psQ->u32ReadyCnt++) % psQ->u32Num] = (uint8_t)psQ->u32Active;
+    CAP_FQ_SetActive(psQ, CAP_FQ_GetFree(psQ));
+    return 1;
+}
+
+/**
+ * @brief     Take the oldest captured frame
+ *
+ * @param[in]  psQ: Frame queue
+ *
+ * @return    The frame, or NULL if none is ready
+ *
+ * @details   The consumer owns the buffer until it gives it back with CAP_FQ_Queue(); the engine
+ *            does not write to it meanwhile. Call from thread context.
+ */
+CAP_FRAME_T *CAP_FQ_Dequeue(CAP_FQ_T *psQ)
+{
+    uint32_t u32Idx = psQ->u32Num;
+    uint32_t u32IBit = CAP_FQ_Lock();
+
+    if (psQ->u32ReadyCnt)
+    {
+        u32Idx = CAP_FQ_GetReady(psQ);
+        psQ->au8State[u32Idx] = CAP_FQ_USER;
+    }
+    CAP_FQ_Unlock(u32IBit);
+    return (u32Idx == psQ->u32Num) ? 0 : &psQ->asFrame[u32Idx];
+}
+
+/**
+ * @brief     Give a dequeued frame back to be captured into
+ *
+ * @param[in]  psQ: Frame queue
+ *
+ * @param[in]  psFrame: Frame returned by CAP_FQ_Dequeue()
+ *
+ * @retval    0                 Success
+ * @retval    CAP_INVALID_BUF   The frame is not held by the consumer
+ *
+ * @details   Discards cached lines of the buffer, including lines the consumer wrote. Call from
+ *            thread context.
+ */
+int32_t CAP_FQ_Queue(CAP_FQ_T *psQ, CAP_FRAME_T *psFrame)
+{
+    uint32_t u32Idx = psFrame - psQ->asFrame;
+    uint32_t u32IBit;
+
+    if ((u32Idx >= psQ->u32Num) || (psQ->au8State[u32Idx] != CAP_FQ_USER))
+        return CAP_INVALID_BUF;
+
+    sysInvalidateDCacheRange(psFrame->au32Addr[0], psQ->u32Size);
+    u32IBit = CAP_FQ_Lock();
+    CAP_FQ_PutFree(psQ, u32Idx);
+    CAP_FQ_Unlock(u32IBit);
+    return 0;
+}
+
 /*@}*/ /* end of group CAP_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group CAP_Driver */
@@ -10,6 +10,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "nuc980.h"
+#include "sys.h"
 #include "crypto.h"
 
 /** @cond HIDDEN_SYMBOLS */
@@ -43,6 +44,10 @@ static uint32_t g_AES_CTL;
 
 static char  hex_char_tbl[] = "0123456789abcdef";
 
+/* One ECC engine operation and one RSA exponentiation, start to done */
+SYS_PROF_DEFINE(s_sProfEcc, "crypto ecc")
+SYS_PROF_DEFINE(s_sProfRsa, "crypto rsa")
+
 static void dump_ecc_reg(char *str, uint32_t volatile regs[], int32_t count);
 static char get_Nth_nibble_char(uint32_t val32, uint32_t idx);
 static void Hex2Reg(char input[], uint32_t volatile reg[]);
@@ -209,12 +214,18 @@ void AES_SetInitVect(CRPT_T *crpt, uint32_t au32IV[])
   * @param[in]  u32DstAddr   AES DMA destination address
   * @param[in]  u32TransCnt  AES DMA transfer byte count
   * @return None
+  * @note   Source and destination may be cacheable. The source is cleaned and the destination
+  *         discarded from the D-cache here, so the data must be in place before this call and the
+  *         destination must not be accessed until the transfer is done.
   */
 void AES_SetDMATransfer(CRPT_T *crpt, uint32_t u32SrcAddr,
                         uint32_t u32DstAddr, uint32_t u32TransCnt)
 {
     uint32_t  reg_addr;
 
+    sysCleanDCacheRange(u32SrcAddr, u32TransCnt);
+    sysInvalidateDCacheRange(u32DstAddr, u32TransCnt);
+
     reg_addr = (uint32_t)&crpt->AES0_SADDR;
     outpw(reg_addr, u32SrcAddr);
 
@@ -276,9 +287,11 @@ void SHA_Start(CRPT_T *crpt, uint32_t u32DMAMode)
   * @param[in]  u32SrcAddr   SHA DMA source address
   * @param[in]  u32TransCnt  SHA DMA transfer byte count
   * @return None
+  * @note   The source may be cacheable; it is cleaned from the D-cache here.
   */
 void SHA_SetDMATransfer(CRPT_T *crpt, uint32_t u32SrcAddr, uint32_t u32TransCnt)
 {
+    sysCleanDCacheRange(u32SrcAddr, u32TransCnt);
     crpt->HMAC_SADDR = u32SrcAddr;
     crpt->HMAC_DMACNT = u32TransCnt;
 }
@@ -1275,6 +1288,7 @@ static void run_ecc_codec(CRPT_T *crpt, uint32_t mode)
     }
 
     g_ECC_done = g_ECCERR_done = 0UL;
+    SYS_PROF_BEGIN(s_sProfEcc);
     crpt->ECC_CTL |= ((uint32_t)pCurve->key_len << CRPT_ECC_CTL_CURVEM_Pos) | mode | CRPT_ECC_CTL_START_Msk;
     while ((g_ECC_done | g_ECCERR_done) == 0UL)
     {
@@ -1283,6 +1297,7 @@ static void run_ecc_codec(CRPT_T *crpt, uint32_t mode)
     while (crpt->ECC_STS & CRPT_ECC_STS_BUSY_Msk)
     {
     }
+    SYS_PROF_END(s_sProfEcc);
 }
 /** @endcond HIDDEN_SYMBOLS */
 
@@ -2607,8 +2622,10 @@ int32_t  RSA_GenerateSignature(CRPT_T *crpt, int rsa_len, char *n, char *d, char
     Hex2Reg(msg, (uint32_t *)&crpt->RSA_M[0]);
     Hex2Reg(C, (uint32_t *)&crpt->RSA_C[0]);
 
+    SYS_PROF_BEGIN(s_sProfRsa);
     CRPT->RSA_CTL = (rsa_len << CRPT_RSA_CTL_KEYLEN_Pos) | CRPT_RSA_CTL_START_Msk;
     while (CRPT->RSA_STS & CRPT_RSA_STS_BUSY_Msk) ;
+    SYS_PROF_END(s_sProfRsa);
 
     Reg2Hex(rsa_len/4, (uint32_t *)CRPT->RSA_M, sig);
     return 0;
@@ -2644,8 +2661,10 @@ int32_t  RSA_VerifySignature(CRPT_T *crpt, int rsa_len, char *n, char *e, char *
     Hex2Reg(sig, (uint32_t *)&crpt->RSA_M[0]);
     Hex2Reg(C, (uint32_t *)&crpt->RSA_C[0]);
 
+    SYS_PROF_BEGIN(s_sProfRsa);
     CRPT->RSA_CTL = (rsa_len << CRPT_RSA_CTL_KEYLEN_Pos) | CRPT_RSA_CTL_START_Msk;
     while (CRPT->RSA_STS & CRPT_RSA_STS_BUSY_Msk) ;
+    SYS_PROF_END(s_sProfRsa);
 
     Reg2Hex(rsa_len/4, (uint32_t *)CRPT->RSA_M, output);
 
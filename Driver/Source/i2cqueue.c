@@ -0,0 +1,612 @@
+/**************************************************************************//**
+ * @file     i2cqueue.c
+ * @version  V1.00
+ * @brief    NUC980 series interrupt-driven I2C master transaction queue
+ *
+ * Transactions are caller-owned descriptors linked into a queue. The I2C
+ * interrupt walks the head transaction through the master status codes one
+ * bus event at a time: messages joined by repeated STARTs, or a register
+ * table whose entries are written back to back as separate transactions.
+ * A finished transaction reports to its callback and the next one starts
+ * in the same interrupt, STOP and START issued together.
+ *
+ * A not acknowledged address or a lost arbitration is retried up to
+ * u32Retries times, which also polls an EEPROM busy with its write cycle.
+ * The time-out counter runs while a transaction is on the bus; when it
+ * expires, or on a bus error, the controller is reset, an optional board
+ * hook frees the bus, and the queue goes on with the next transaction.
+ *
+ * Tasks touch the queue with the I2C interrupt disabled in the AIC: CTL0
+ * cannot be masked safely by read-modify-write, since writing back a set
+ * SI clears it.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include "i2c.h"
+#include "sys.h"
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup I2C_Driver I2C Driver
+  @{
+*/
+
+/** @addtogroup I2C_EXPORTED_FUNCTIONS I2C Exported Functions
+  @{
+*/
+
+/** @cond HIDDEN_SYMBOLS */
+
+static I2C_QUEUE_T *s_apsQueue[4];
+
+static const IRQn_Type s_aeI2cIrq[4] = { IRQ_I2C0, IRQ_I2C1, IRQ_I2C2, IRQ_I2C3 };
+
+static uint32_t i2c_no(I2C_T *i2c)
+{
+    if(i2c == I2C0)
+        return 0;
+    else if(i2c == I2C1)
+        return 1;
+    else if(i2c == I2C2)
+        return 2;
+    else if(i2c == I2C3)
+        return 3;
+    else
+        return 4;
+}
+
+static void i2c0_isr(void)
+{
+    I2C_QueueIRQHandler(s_apsQueue[0]);
+}
+
+static void i2c1_isr(void)
+{
+    I2C_QueueIRQHandler(s_apsQueue[1]);
+}
+
+static void i2c2_isr(void)
+{
+    I2C_QueueIRQHandler(s_apsQueue[2]);
+}
+
+static void i2c3_isr(void)
+{
+    I2C_QueueIRQHandler(s_apsQueue[3]);
+}
+
+static void (* const s_apfnIsr[4])(void) = { i2c0_isr, i2c1_isr, i2c2_isr, i2c3_isr };
+
+static __inline void i2cq_lock(I2C_QUEUE_T *psQueue)
+{
+    sysDisableInterrupt(s_aeI2cIrq[i2c_no(psQueue->i2c)]);
+}
+
+static __inline void i2cq_unlock(I2C_QUEUE_T *psQueue)
+{
+    sysEnableInterrupt(s_aeI2cIrq[i2c_no(psQueue->i2c)]);
+}
+
+/* Reset the controller, let the board free the bus and restore the master setup */
+static void i2cq_recover(I2C_QUEUE_T *psQueue)
+{
+    I2C_T *i2c = psQueue->i2c;
+    uint32_t u32Div = i2c->CLKDIV;
+
+    I2C_Close(i2c);
+    if(psQueue->pfnRecover != NULL)
+        psQueue->pfnRecover(i2c);
+
+    i2c->CLKDIV = u32Div;
+    i2c->TOCTL = psQueue->u32TimeoutCtl;
+    i2c->CTL0 = I2C_CTL0_I2CEN_Msk | I2C_CTL0_INTEN_Msk;
+    psQueue->u32Recoveries++;
+}
+
+/* Put the first queued transaction on the bus */
+static void i2cq_start(I2C_QUEUE_T *psQueue)
+{
+    I2C_T *i2c = psQueue->i2c;
+
+    psQueue->psHead->i32Status = I2C_XFER_ACTIVE;
+
+    /* A STOP ending the previous transaction takes one bit time */
+    while(i2c->CTL0 & I2C_CTL0_STO_Msk);
+
+    i2c->TOCTL = psQueue->u32TimeoutCtl;
+    I2C_SET_CONTROL_REG(i2c, I2C_CTL_STA);
+}
+
+/*
+ * End the transaction on the bus and write u32Ctl to the controller, with a
+ * START for the next transaction: STOP and START together, or START alone
+ * after a controller reset. The callback runs first, the bus held meanwhile,
+ * so that a transaction it queues starts with the same write.
+ */
+static void i2cq_finish(I2C_QUEUE_T *psQueue, int32_t i32Status, uint32_t u32Ctl)
+{
+    I2C_T *i2c = psQueue->i2c;
+    I2C_XFER_T *psXfer = psQueue->psHead;
+
+    psQueue->psHead = psXfer->psNext;
+    if(psQueue->psHead == NULL)
+        psQueue->psTail = NULL;
+    psQueue->u32Xfers++;
+    if(i32Status < 0)
+        psQueue->u32Errors++;
+
+    psXfer->i32Status = i32Status;
+    if(psXfer->pfnDone != NULL)
+        psXfer->pfnDone(psXfer);
+
+    if(psQueue->psHead != NULL)
+    {
+        psQueue->psHead->i32Status = I2C_XFER_ACTIVE;
+        I2C_SET_CONTROL_REG(i2c, u32Ctl | I2C_CTL_STA);
+    }
+    else
+    {
+        i2c->TOCTL &= ~I2C_TOCTL_TOCEN_Msk;
+        if(u32Ctl != 0)
+            I2C_SET_CONTROL_REG(i2c, u32Ctl);
+    }
+}
+
+/* Start the transaction, or the current table entry, over */
+static __inline void i2cq_restart(I2C_XFER_T *psXfer)
+{
+    if(psXfer->psMsg != NULL)
+        psXfer->u32Done = 0;
+    psXfer->u32Pos = 0;
+}
+
+static void i2cq_error(I2C_QUEUE_T *psQueue, I2C_XFER_T *psXfer, uint32_t u32Status)
+{
+    switch(u32Status)
+    {
+    case 0x20u:                                         /* SLA+W NACK */
+    case 0x48u:                                         /* SLA+R NACK */
+        psQueue->u32Nacks++;
+        if(psXfer->u32Tries < psXfer->u32Retries)
+        {
+            psXfer->u32Tries++;
+            psQueue->u32Retries++;
+            i2cq_restart(psXfer);
+            I2C_SET_CONTROL_REG(psQueue->i2c, I2C_CTL_STO | I2C_CTL_STA | I2C_CTL_SI);
+        }
+        else
+        {
+            i2cq_finish(psQueue, I2C_XFER_ERR_NACK, I2C_CTL_STO_SI);
+        }
+        break;
+    case 0x30u:                                         /* Data NACK */
+        psQueue->u32Nacks++;
+        i2cq_finish(psQueue, I2C_XFER_ERR_NACK, I2C_CTL_STO_SI);
+        break;
+    case 0x38u:                                         /* Arbitration lost, the bus is released */
+        psQueue->u32ArbLost++;
+        if(psXfer->u32Tries < psXfer->u32Retries)
+        {
+            psXfer->u32Tries++;
+            psQueue->u32Retries++;
+            i2cq_restart(psXfer);
+            I2C_SET_CONTROL_REG(psQueue->i2c, I2C_CTL_STA_SI);
+        }
+        else
+        {
+            i2cq_finish(psQueue, I2C_XFER_ERR_ARB, I2C_CTL_SI);
+        }
+        break;
+    case 0x00u:                                         /* Bus error */
+    default:                                            /* Unknown status */
+        psQueue->u32BusErrors++;
+        i2cq_recover(psQueue);
+        i2cq_finish(psQueue, I2C_XFER_ERR_BUS, 0);
+        break;
+    }
+}
+
+/* One bus event of a transaction made of messages */
+static void i2cq_msg_event(I2C_QUEUE_T *psQueue, I2C_XFER_T *psXfer, uint32_t u32Status)
+{
+    I2C_T *i2c = psQueue->i2c;
+    I2C_MSG_T *psMsg = &psXfer->psMsg[psXfer->u32Done];
+    uint32_t u32Ctl = I2C_CTL_SI, u32Next = 0;
+
+    switch(u32Status)
+    {
+    case 0x08u:                                         /* START */
+    case 0x10u:                                         /* Repeated START */
+        I2C_SET_DATA(i2c, (uint8_t)((psMsg->u8Addr << 1) | (psMsg->u8Flags & I2C_MSG_READ)));
+        break;
+    case 0x18u:                                         /* SLA+W ACK */
+    case 0x28u:                                         /* Data ACK */
+        /* Messages flagged I2C_MSG_NOSTART carry on the same write */
+        while((psXfer->u32Pos == psMsg->u16Len) && (psXfer->u32Done + 1 < psXfer->u32Msgs) &&
+                (psMsg[1].u8Flags & I2C_MSG_NOSTART))
+        {
+            psXfer->u32Done++;
+            psXfer->u32Pos = 0;
+            psMsg++;
+        }
+        if(psXfer->u32Pos < psMsg->u16Len)
+            I2C_SET_DATA(i2c, psMsg->pu8Buf[psXfer->u32Pos++]);
+        else
+            u32Next = 1;
+        break;
+    case 0x40u:                                         /* SLA+R ACK, acknowledge all bytes but the last */
+        if(psMsg->u16Len > 1)
+            u32Ctl = I2C_CTL_SI_AA;
+        break;
+    case 0x50u:                                         /* Data received, ACK returned */
+        psMsg->pu8Buf[psXfer->u32Pos++] = (uint8_t)I2C_GET_DATA(i2c);
+        if(psMsg->u16Len - psXfer->u32Pos > 1)
+            u32Ctl = I2C_CTL_SI_AA;
+        break;
+    case 0x58u:                                         /* Last byte received, NACK returned */
+        psMsg->pu8Buf[psXfer->u32Pos++] = (uint8_t)I2C_GET_DATA(i2c);
+        u32Next = 1;
+        break;
+    default:
+        i2cq_error(psQueue, psXfer, u32Status);
+        return;
+    }
+
+    if(u32Next)
+    {
+        psXfer->u32Done++;
+        psXfer->u32Pos = 0;
+        if(psXfer->u32Done == psXfer->u32Msgs)
+        {
+            i2cq_finish(psQueue, I2C_XFER_OK, I2C_CTL_STO_SI);
+            return;
+        }
+        u32Ctl = I2C_CTL_STA_SI;                        /* Repeated START for the next message */
+    }
+    I2C_SET_CONTROL_REG(i2c, u32Ctl);
+}
+
+/* One bus event of a register table */
+static void i2cq_table_event(I2C_QUEUE_T *psQueue, I2C_XFER_T *psXfer, uint32_t u32Status)
+{
+    I2C_T *i2c = psQueue->i2c;
+    const I2C_REG_T *psReg = &psXfer->psRegs[psXfer->u32Done];
+    uint32_t u32Bytes = psXfer->u8RegBytes + psXfer->u8ValBytes;
+    uint32_t u32Pos = psXfer->u32Pos;
+
+    switch(u32Status)
+    {
+    case 0x08u:                                         /* START */
+        I2C_SET_DATA(i2c, (uint8_t)(psXfer->u8RegAddr << 1));
+        I2C_SET_CONTROL_REG(i2c, I2C_CTL_SI);
+        break;
+    case 0x18u:                                         /* SLA+W ACK */
+    case 0x28u:                                         /* Data ACK */
+        if(u32Pos < psXfer->u8RegBytes)
+        {
+            I2C_SET_DATA(i2c, (uint8_t)(psReg->u16Reg >> (8 * (psXfer->u8RegBytes - 1 - u32Pos))));
+            I2C_SET_CONTROL_REG(i2c, I2C_CTL_SI);
+        }
+        else if(u32Pos < u32Bytes)
+        {
+            I2C_SET_DATA(i2c, (uint8_t)(psReg->u16Val >> (8 * (u32Bytes - 1 - u32Pos))));
+            I2C_SET_CONTROL_REG(i2c, I2C_CTL_SI);
+        }
+        else
+        {
+            /* Entry written, STOP and START the next one; retries count per entry */
+            psXfer->u32Done++;
+            psXfer->u32Pos = 0;
+            psXfer->u32Tries = 0;
+            if(psXfer->u32Done == psXfer->u32Regs)
+                i2cq_finish(psQueue, I2C_XFER_OK, I2C_CTL_STO_SI);
+            else
+                I2C_SET_CONTROL_REG(i2c, I2C_CTL_STO | I2C_CTL_STA | I2C_CTL_SI);
+            return;
+        }
+        psXfer->u32Pos = u32Pos + 1;
+        break;
+    default:
+        i2cq_error(psQueue, psXfer, u32Status);
+        break;
+    }
+}
+
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+  * @brief      Start an I2C master transaction queue
+  *
+  * @param[in]  psQueue         The queue
+  * @param[in]  i2c             Specify I2C port, opened with I2C_Open()
+  * @param[in]  u8LongTimeout   Time-out counter divided by 4 (0/1)
+  *
+  * @retval     I2C_XFER_OK         The queue is ready
+  * @retval     I2C_XFER_ERR_PARAM  Unknown I2C port
+  *
+  * @details    The queue installs its interrupt handler and enables the I2C interrupt. The time-out
+  *             counter, four times longer with u8LongTimeout, runs while a transaction is on the bus.
+  */
+int32_t I2C_QueueOpen(I2C_QUEUE_T *psQueue, I2C_T *i2c, uint8_t u8LongTimeout)
+{
+    uint32_t u32No = i2c_no(i2c);
+
+    if(u32No >= 4)
+        return I2C_XFER_ERR_PARAM;
+
+    memset(psQueue, 0, sizeof(I2C_QUEUE_T));
+    psQueue->i2c = i2c;
+    psQueue->u32TimeoutCtl = I2C_TOCTL_TOCEN_Msk | (u8LongTimeout ? I2C_TOCTL_TOCDIV4_Msk : 0);
+
+    s_apsQueue[u32No] = psQueue;
+    sysInstallISR(IRQ_LEVEL_1, s_aeI2cIrq[u32No], (PVOID)s_apfnIsr[u32No]);
+    sysSetLocalInterrupt(ENABLE_IRQ);
+    I2C_EnableInt(i2c);
+    sysEnableInterrupt(s_aeI2cIrq[u32No]);
+
+    return I2C_XFER_OK;
+}
+
+/**
+  * @brief      Stop an I2C master transaction queue
+  *
+  * @param[in]  psQueue     The queue
+  *
+  * @return     None
+  *
+  * @details    A transaction on the bus is cut with a STOP. It and the queued transactions end with
+  *             I2C_XFER_ERR_ABORT, their callbacks called from the caller of this function.
+  */
+void I2C_QueueClose(I2C_QUEUE_T *psQueue)
+{
+    I2C_T *i2c = psQueue->i2c;
+    uint32_t u32No = i2c_no(i2c);
+    I2C_XFER_T *psXfer;
+
+    if((u32No >= 4) || (s_apsQueue[u32No] != psQueue))
+        return;
+
+    sysDisableInterrupt(s_aeI2cIrq[u32No]);
+    if(psQueue->psHead != NULL)
+        I2C_SET_CONTROL_REG(i2c, I2C_CTL_STO_SI);
+    i2c->TOCTL &= ~I2C_TOCTL_TOCEN_Msk;
+    i2c->CTL0 = i2c->CTL0 & ~(I2C_CTL0_SI_Msk | I2C_CTL0_INTEN_Msk);
+    s_apsQueue[u32No] = NULL;
+
+    while((psXfer = psQueue->psHead) != NULL)
+    {
+        psQueue->psHead = psXfer->psNext;
+        psXfer->i32Status = I2C_XFER_ERR_ABORT;
+        if(psXfer->pfnDone != NULL)
+            psXfer->pfnDone(psXfer);
+    }
+    psQueue->psTail = NULL;
+}
+
+/**
+  * @brief      Interrupt handler of an I2C master transaction queue
+  *
+  * @param[in]  psQueue     The queue
+  *
+  * @return     None
+  *
+  * @details    Installed by I2C_QueueOpen(). Serves one bus event of the transaction on the bus, or a
+  *             time-out: the controller is reset and the transaction ends with I2C_XFER_ERR_TIMEOUT.
+  */
+void I2C_QueueIRQHandler(I2C_QUEUE_T *psQueue)
+{
+    I2C_T *i2c = psQueue->i2c;
+    I2C_XFER_T *psXfer = psQueue->psHead;
+    uint32_t t0 = psQueue->pfnClock ? psQueue->pfnClock() : 0;
+
+    psQueue->u32InHandler = 1;
+    if(I2C_GET_TIMEOUT_FLAG(i2c))
+    {
+        I2C_ClearTimeoutFlag(i2c);
+        if(psXfer != NULL)
+        {
+            psQueue->u32Timeouts++;
+            i2cq_recover(psQueue);
+            i2cq_finish(psQueue, I2C_XFER_ERR_TIMEOUT, 0);
+        }
+    }
+    else if(i2c->CTL0 & I2C_CTL0_SI_Msk)
+    {
+        if(psXfer == NULL)
+            I2C_SET_CONTROL_REG(i2c, I2C_CTL_STO_SI);   /* No transaction, release the bus */
+        else if(psXfer->psMsg != NULL)
+            i2cq_msg_event(psQueue, psXfer, I2C_GET_STATUS(i2c));
+        else
+            i2cq_table_event(psQueue, psXfer, I2C_GET_STATUS(i2c));
+    }
+    psQueue->u32InHandler = 0;
+
+    if(psQueue->pfnClock)
+        psQueue->u32Ticks += (psQueue->pfnClock() - t0) & psQueue->u32ClockMask;
+}
+
+/**
+  * @brief      Queue an I2C transaction
+  *
+  * @param[in]  psQueue     The queue
+  * @param[in]  psXfer      Transaction set up by I2C_XferInit() or I2C_XferInitRegTable()
+  *
+  * @retval     I2C_XFER_OK         Queued, i32Status of psXfer tells when it is done
+  * @retval     I2C_XFER_ERR_PARAM  Invalid descriptor, not queued
+  *
+  * @details    The transaction starts at once on an idle queue. Callable from a pfnDone callback,
+  *             the transaction then starts as the one done ends.
+  */
+int32_t I2C_QueueSubmit(I2C_QUEUE_T *psQueue, I2C_XFER_T *psXfer)
+{
+    uint32_t i;
+
+    if(psXfer->psMsg != NULL)
+    {
+        if((psXfer->u32Msgs == 0) || (psXfer->psMsg[0].u8Flags & I2C_MSG_NOSTART))
+            return I2C_XFER_ERR_PARAM;
+        for(i = 0; i < psXfer->u32Msgs; i++)
+        {
+            I2C_MSG_T *psMsg = &psXfer->psMsg[i];
+
+            if((psMsg->u8Flags & I2C_MSG_READ) && (psMsg->u16Len == 0))
+                return I2C_XFER_ERR_PARAM;
+            if((psMsg->u8Flags & I2C_MSG_NOSTART) &&
+                    ((psMsg->u8Flags & I2C_MSG_READ) || (psMsg[-1].u8Flags & I2C_MSG_READ)))
+                return I2C_XFER_ERR_PARAM;
+        }
+    }
+    else if((psXfer->psRegs == NULL) || (psXfer->u32Regs == 0) ||
+            (psXfer->u8RegBytes < 1) || (psXfer->u8RegBytes > 2) ||
+            (psXfer->u8ValBytes < 1) || (psXfer->u8ValBytes > 2))
+    {
+        return I2C_XFER_ERR_PARAM;
+    }
+
+    psXfer->psNext = NULL;
+    psXfer->u32Done = 0;
+    psXfer->u32Pos = 0;
+    psXfer->u32Tries = 0;
+    psXfer->i32Status = I2C_XFER_QUEUED;
+
+    i2cq_lock(psQueue);
+    if(psQueue->psHead == NULL)
+    {
+        psQueue->psHead = psQueue->psTail = psXfer;
+        if(!psQueue->u32InHandler)
+            i2cq_start(psQueue);
+    }
+    else
+    {
+        psQueue->psTail->psNext = psXfer;
+        psQueue->psTail = psXfer;
+    }
+    i2cq_unlock(psQueue);
+
+    return I2C_XFER_OK;
+}
+
+/**
+  * @brief      Wait for an I2C transaction
+  *
+  * @param[in]  psXfer      A queued transaction
+  *
+  * @return     I2C_XFER_OK or the error it ended with
+  *
+  * @details    Spins until the transaction is done. Do not call it from a callback.
+  */
+int32_t I2C_QueueWait(I2C_XFER_T *psXfer)
+{
+    while(psXfer->i32Status > 0);
+    return psXfer->i32Status;
+}
+
+/**
+  * @brief      Count the transactions of an I2C queue
+  *
+  * @param[in]  psQueue     The queue
+  *
+  * @return     Transactions queued or on the bus
+  */
+uint32_t I2C_QueueCount(I2C_QUEUE_T *psQueue)
+{
+    I2C_XFER_T *psXfer;
+    uint32_t n = 0;
+
+    i2cq_lock(psQueue);
+    for(psXfer = psQueue->psHead; psXfer != NULL; psXfer = psXfer->psNext)
+        n++;
+    i2cq_unlock(psQueue);
+
+    return n;
+}
+
+/**
+  * @brief      Set the bus recovery hook of an I2C queue
+  *
+  * @param[in]  psQueue     The queue
+  * @param[in]  pfnRecover  Called with the controller reset and disabled, NULL for none
+  *
+  * @return     None
+  *
+  * @details    After a time-out or a bus error the controller is reset, which does not help when a
+  *             slave holds SDA low. The hook may switch SCL to GPIO and clock it until SDA is
+  *             released, then give the pins back to the controller. It runs in the interrupt.
+  */
+void I2C_QueueSetRecovery(I2C_QUEUE_T *psQueue, void (*pfnRecover)(I2C_T *i2c))
+{
+    psQueue->pfnRecover = pfnRecover;
+}
+
+/**
+  * @brief      Set the clock timing the interrupt handler of an I2C queue
+  *
+  * @param[in]  psQueue     The queue
+  * @param[in]  pfnClock    Free-running counter, NULL for none
+  * @param[in]  u32Mask     Valid bits of pfnClock()
+  *
+  * @return     None
+  *
+  * @details    The ticks spent in I2C_QueueIRQHandler() add up in u32Ticks of the queue.
+  */
+void I2C_QueueSetClock(I2C_QUEUE_T *psQueue, uint32_t (*pfnClock)(void), uint32_t u32Mask)
+{
+    psQueue->pfnClock = pfnClock;
+    psQueue->u32ClockMask = u32Mask;
+}
+
+/**
+  * @brief      Set up a transaction made of messages
+  *
+  * @param[out] psXfer      The transaction
+  * @param[in]  psMsg       Messages, joined on the bus by repeated STARTs
+  * @param[in]  u32Msgs     Messages in psMsg
+  *
+  * @return     None
+  *
+  * @details    A register read is a write of the register address followed by a read. The caller
+  *             may set u32Retries, pfnDone and pvParam afterwards.
+  */
+void I2C_XferInit(I2C_XFER_T *psXfer, I2C_MSG_T *psMsg, uint32_t u32Msgs)
+{
+    memset(psXfer, 0, sizeof(I2C_XFER_T));
+    psXfer->psMsg = psMsg;
+    psXfer->u32Msgs = u32Msgs;
+}
+
+/**
+  * @brief      Set up a register table write
+  *
+  * @param[out] psXfer      The transaction
+  * @param[in]  u8SlaveAddr 7-bit slave address
+  * @param[in]  psRegs      Register table
+  * @param[in]  u32Regs     Entries in psRegs
+  * @param[in]  u8RegBytes  Register bytes, 1 or 2
+  * @param[in]  u8ValBytes  Value bytes, 1 or 2
+  *
+  * @return     None
+  *
+  * @details    Every entry is written as one transaction, the next one started by the interrupt,
+  *             as sensor and codec initialisation tables are. u32Retries applies to each entry.
+  */
+void I2C_XferInitRegTable(I2C_XFER_T *psXfer, uint8_t u8SlaveAddr, const I2C_REG_T *psRegs, uint32_t u32Regs,
+                          uint8_t u8RegBytes, uint8_t u8ValBytes)
+{
+    memset(psXfer, 0, sizeof(I2C_XFER_T));
+    psXfer->psRegs = psRegs;
+    psXfer->u32Regs = u32Regs;
+    psXfer->u8RegAddr = u8SlaveAddr;
+    psXfer->u8RegBytes = u8RegBytes;
+    psXfer->u8ValBytes = u8ValBytes;
+}
+
+/*@}*/ /* end of group I2C_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group I2C_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
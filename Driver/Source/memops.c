@@ -0,0 +1,649 @@
+/**************************************************************************//**
+ * @file     memops.c
+ * @brief    NUC980 memory copy, memory fill and Internet checksum kernels
+ *
+ * The ARM926EJ-S moves eight registers per LDM/STM, so the bulk loops work on
+ * 32-byte blocks, one D-cache line each. The core has no usable preload (PLD
+ * is a NOP), so nothing is prefetched. A copy from a source that is not word
+ * aligned still uses word loads and merges them with shifts.
+ *
+ * The checksums return the same value as lwIP's lwip_standard_chksum() for
+ * any alignment and length. Define SYS_MEMOPS_PORTABLE to build the C
+ * reference versions instead of the assembler ones.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+
+#include "nuc980.h"
+#include "sys.h"
+
+/// @cond HIDDEN_SYMBOLS
+
+#if !defined(SYS_MEMOPS_PORTABLE) && (defined(__CC_ARM) || (defined(__GNUC__) && defined(__arm__)))
+#define SYS_MEMOPS_ASM
+#endif
+
+/* 32-bit one's complement sum of u32Len bytes, both word aligned and u32Len a multiple of 4 */
+UINT32 sys_chksum_words(const void *pvData, UINT32 u32Len);
+/* Same as sys_chksum_words(), storing the words to pvDst on the way */
+UINT32 sys_chksum_copy_words(void *pvDst, const void *pvSrc, UINT32 u32Len);
+
+#if defined(SYS_MEMOPS_ASM)
+
+#if defined (__GNUC__) && !(__CC_ARM)
+
+void __attribute__ ((naked)) sysMemCopy(void *pvDst, const void *pvSrc, UINT32 u32Len)
+{
+    asm volatile
+    (
+        "cmp    r2, #16                     \n"
+        "blo    8f                          \n"
+        "1:                                 \n"     /* align the destination */
+        "tst    r0, #3                      \n"
+        "beq    2f                          \n"
+        "ldrb   r3, [r1], #1                \n"
+        "strb   r3, [r0], #1                \n"
+        "sub    r2, r2, #1                  \n"
+        "b      1b                          \n"
+        "2:                                 \n"
+        "tst    r1, #3                      \n"
+        "bne    5f                          \n"
+        "stmfd  sp!, {r4-r10}               \n"     /* both aligned, 32 bytes per pass */
+        "subs   r2, r2, #32                 \n"
+        "blo    4f                          \n"
+        "3:                                 \n"
+        "ldmia  r1!, {r3-r10}               \n"
+        "stmia  r0!, {r3-r10}               \n"
+        "subs   r2, r2, #32                 \n"
+        "bhs    3b                          \n"
+        "4:                                 \n"
+        "ldmfd  sp!, {r4-r10}               \n"
+        "adds   r2, r2, #28                 \n"
+        "blo    7f                          \n"
+        "41:                                \n"
+        "ldr    r3, [r1], #4                \n"
+        "str    r3, [r0], #4                \n"
+        "subs   r2, r2, #4                  \n"
+        "bhs    41b                         \n"
+        "b      7f                          \n"
+        "5:                                 \n"     /* source off by 1-3 bytes, merge words */
+        "stmfd  sp!, {r4-r8, lr}            \n"
+        "and    r12, r1, #3                 \n"
+        "bic    r1, r1, #3                  \n"
+        "mov    r12, r12, lsl #3            \n"
+        "rsb    lr, r12, #32                \n"
+        "ldr    r3, [r1], #4                \n"
+        "mov    r3, r3, lsr r12             \n"
+        "subs   r2, r2, #16                 \n"
+        "blo    6f                          \n"
+        "51:                                \n"
+        "ldmia  r1!, {r5-r8}                \n"
+        "orr    r4, r3, r5, lsl lr          \n"
+        "mov    r5, r5, lsr r12             \n"
+        "orr    r5, r5, r6, lsl lr          \n"
+        "mov    r6, r6, lsr r12             \n"
+        "orr    r6, r6, r7, lsl lr          \n"
+        "mov    r7, r7, lsr r12             \n"
+        "orr    r7, r7, r8, lsl lr          \n"
+        "mov    r3, r8, lsr r12             \n"
+        "stmia  r0!, {r4-r7}                \n"
+        "subs   r2, r2, #16                 \n"
+        "bhs    51b                         \n"
+        "6:                                 \n"
+        "adds   r2, r2, #12                 \n"
+        "blo    62f                         \n"
+        "61:                                \n"
+        "ldr    r5, [r1], #4                \n"
+        "orr    r4, r3, r5, lsl lr          \n"
+        "mov    r3, r5, lsr r12             \n"
+        "str    r4, [r0], #4                \n"
+        "subs   r2, r2, #4                  \n"
+        "bhs    61b                         \n"
+        "62:                                \n"
+        "sub    r1, r1, #4                  \n"     /* back to the first byte not copied */
+        "add    r1, r1, r12, lsr #3         \n"
+        "ldmfd  sp!, {r4-r8, lr}            \n"
+        "7:                                 \n"
+        "add    r2, r2, #4                  \n"
+        "8:                                 \n"     /* up to 15 bytes left */
+        "subs   r2, r2, #1                  \n"
+        "blo    9f                          \n"
+        "ldrb   r3, [r1], #1                \n"
+        "strb   r3, [r0], #1                \n"
+        "b      8b                          \n"
+        "9:                                 \n"
+        "bx     lr                          \n"
+    );
+}
+
+void __attribute__ ((naked)) sysMemSet(void *pvDst, INT32 i32Val, UINT32 u32Len)
+{
+    asm volatile
+    (
+        "and    r1, r1, #0xFF               \n"
+        "orr    r1, r1, r1, lsl #8          \n"
+        "orr    r1, r1, r1, lsl #16         \n"
+        "cmp    r2, #16                     \n"
+        "blo    8f                          \n"
+        "1:                                 \n"     /* align the destination */
+        "tst    r0, #3                      \n"
+        "beq    2f                          \n"
+        "strb   r1, [r0], #1                \n"
+        "sub    r2, r2, #1                  \n"
+        "b      1b                          \n"
+        "2:                                 \n"
+        "stmfd  sp!, {r4-r8}                \n"
+        "mov    r3, r1                      \n"
+        "mov    r4, r1                      \n"
+        "mov    r5, r1                      \n"
+        "mov    r6, r1                      \n"
+        "mov    r7, r1                      \n"
+        "mov    r8, r1                      \n"
+        "mov    r12, r1                     \n"
+        "subs   r2, r2, #32                 \n"
+        "blo    4f                          \n"
+        "3:                                 \n"
+        "stmia  r0!, {r1, r3-r8, r12}       \n"
+        "subs   r2, r2, #32                 \n"
+        "bhs    3b                          \n"
+        "4:                                 \n"
+        "ldmfd  sp!, {r4-r8}                \n"
+        "adds   r2, r2, #28                 \n"
+        "blo    7f                          \n"
+        "5:                                 \n"
+        "str    r1, [r0], #4                \n"
+        "subs   r2, r2, #4                  \n"
+        "bhs    5b                          \n"
+        "7:                                 \n"
+        "add    r2, r2, #4                  \n"
+        "8:                                 \n"
+        "subs   r2, r2, #1                  \n"
+        "blo    9f                          \n"
+        "strb   r1, [r0], #1                \n"
+        "b      8b                          \n"
+        "9:                                 \n"
+        "bx     lr                          \n"
+    );
+}
+
+/* The block loops add the carry back twice: a block whose sum ends in 0xFFFFFFFF
+   with carry set would otherwise lose one. */
+UINT32 __attribute__ ((naked)) sys_chksum_words(const void *pvData, UINT32 u32Len)
+{
+    asm volatile
+    (
+        "stmfd  sp!, {r4-r9}                \n"
+        "mov    r12, #0                     \n"
+        "subs   r1, r1, #32                 \n"
+        "blo    2f                          \n"
+        "1:                                 \n"
+        "ldmia  r0!, {r2-r9}                \n"
+        "adds   r12, r12, r2                \n"
+        "adcs   r12, r12, r3                \n"
+        "adcs   r12, r12, r4                \n"
+        "adcs   r12, r12, r5                \n"
+        "adcs   r12, r12, r6                \n"
+        "adcs   r12, r12, r7                \n"
+        "adcs   r12, r12, r8                \n"
+        "adcs   r12, r12, r9                \n"
+        "adcs   r12, r12, #0                \n"
+        "adc    r12, r12, #0                \n"
+        "subs   r1, r1, #32                 \n"
+        "bhs    1b                          \n"
+        "2:                                 \n"
+        "adds   r1, r1, #28                 \n"
+        "blo    4f                          \n"
+        "3:                                 \n"
+        "ldr    r2, [r0], #4                \n"
+        "adds   r12, r12, r2                \n"
+        "adc    r12, r12, #0                \n"
+        "subs   r1, r1, #4                  \n"
+        "bhs    3b                          \n"
+        "4:                                 \n"
+        "mov    r0, r12                     \n"
+        "ldmfd  sp!, {r4-r9}                \n"
+        "bx     lr                          \n"
+    );
+}
+
+UINT32 __attribute__ ((naked)) sys_chksum_copy_words(void *pvDst, const void *pvSrc, UINT32 u32Len)
+{
+    asm volatile
+    (
+        "stmfd  sp!, {r4-r10}               \n"
+        "mov    r12, #0                     \n"
+        "subs   r2, r2, #32                 \n"
+        "blo    2f                          \n"
+        "1:                                 \n"
+        "ldmia  r1!, {r3-r10}               \n"
+        "stmia  r0!, {r3-r10}               \n"
+        "adds   r12, r12, r3                \n"
+        "adcs   r12, r12, r4                \n"
+        "adcs   r12, r12, r5                \n"
+        "adcs   r12, r12, r6                \n"
+        "adcs   r12, r12, r7                \n"
+        "adcs   r12, r12, r8                \n"
+        "adcs   r12, r12, r9                \n"
+        "adcs   r12, r12, r10               \n"
+        "adcs   r12, r12, #0                \n"
+        "adc    r12, r12, #0                \n"
+        "subs   r2, r2, #32                 \n"
+        "bhs    1b                          \n"
+        "2:                                 \n"
+        "adds   r2, r2, #28                 \n"
+        "blo    4f                          \n"
+        "3:                                 \n"
+        "ldr    r3, [r1], #4                \n"
+        "str    r3, [r0], #4                \n"
+        "adds   r12, r12, r3                \n"
+        "adc    r12, r12, #0                \n"
+        "subs   r2, r2, #4                  \n"
+        "bhs    3b                          \n"
+        "4:                                 \n"
+        "mov    r0, r12                     \n"
+        "ldmfd  sp!, {r4-r10}               \n"
+        "bx     lr                          \n"
+    );
+}
+
+#else
+
+__asm void sysMemCopy(void *pvDst, const void *pvSrc, UINT32 u32Len)
+{
+    PRESERVE8
+
+    CMP     r2, #16
+    BLO     mc_bytes
+mc_align                                ; align the destination
+    TST     r0, #3
+    BEQ     mc_aligned
+    LDRB    r3, [r1], #1
+    STRB    r3, [r0], #1
+    SUB     r2, r2, #1
+    B       mc_align
+mc_aligned
+    TST     r1, #3
+    BNE     mc_shift
+    STMFD   sp!, {r4-r10}               ; both aligned, 32 bytes per pass
+    SUBS    r2, r2, #32
+    BLO     mc_block_end
+mc_block
+    LDMIA   r1!, {r3-r10}
+    STMIA   r0!, {r3-r10}
+    SUBS    r2, r2, #32
+    BHS     mc_block
+mc_block_end
+    LDMFD   sp!, {r4-r10}
+    ADDS    r2, r2, #28
+    BLO     mc_tail
+mc_word
+    LDR     r3, [r1], #4
+    STR     r3, [r0], #4
+    SUBS    r2, r2, #4
+    BHS     mc_word
+    B       mc_tail
+mc_shift                                ; source off by 1-3 bytes, merge words
+    STMFD   sp!, {r4-r8, lr}
+    AND     r12, r1, #3
+    BIC     r1, r1, #3
+    MOV     r12, r12, LSL #3
+    RSB     lr, r12, #32
+    LDR     r3, [r1], #4
+    MOV     r3, r3, LSR r12
+    SUBS    r2, r2, #16
+    BLO     mc_shift_end
+mc_shift_block
+    LDMIA   r1!, {r5-r8}
+    ORR     r4, r3, r5, LSL lr
+    MOV     r5, r5, LSR r12
+    ORR     r5, r5, r6, LSL lr
+    MOV     r6, r6, LSR r12
+    ORR     r6, r6, r7, LSL lr
+    MOV     r7, r7, LSR r12
+    ORR     r7, r7, r8, LSL lr
+    MOV     r3, r8, LSR r12
+    STMIA   r0!, {r4-r7}
+    SUBS    r2, r2, #16
+    BHS     mc_shift_block
+mc_shift_end
+    ADDS    r2, r2, #12
+    BLO     mc_shift_done
+mc_shift_word
+    LDR     r5, [r1], #4
+    ORR     r4, r3, r5, LSL lr
+    MOV     r3, r5, LSR r12
+    STR     r4, [r0], #4
+    SUBS    r2, r2, #4
+    BHS     mc_shift_word
+mc_shift_done
+    SUB     r1, r1, #4                  ; back to the first byte not copied
+    ADD     r1, r1, r12, LSR #3
+    LDMFD   sp!, {r4-r8, lr}
+mc_tail
+    ADD     r2, r2, #4
+mc_bytes                                ; up to 15 bytes left
+    SUBS    r2, r2, #1
+    BXLO    lr
+    LDRB    r3, [r1], #1
+    STRB    r3, [r0], #1
+    B       mc_bytes
+}
+
+__asm void sysMemSet(void *pvDst, INT32 i32Val, UINT32 u32Len)
+{
+    PRESERVE8
+
+    AND     r1, r1, #0xFF
+    ORR     r1, r1, r1, LSL #8
+    ORR     r1, r1, r1, LSL #16
+    CMP     r2, #16
+    BLO     ms_bytes
+ms_align                                ; align the destination
+    TST     r0, #3
+    BEQ     ms_aligned
+    STRB    r1, [r0], #1
+    SUB     r2, r2, #1
+    B       ms_align
+ms_aligned
+    STMFD   sp!, {r4-r8}
+    MOV     r3, r1
+    MOV     r4, r1
+    MOV     r5, r1
+    MOV     r6, r1
+    MOV     r7, r1
+    MOV     r8, r1
+    MOV     r12, r1
+    SUBS    r2, r2, #32
+    BLO     ms_block_end
+ms_block
+    STMIA   r0!, {r1, r3-r8, r12}
+    SUBS    r2, r2, #32
+    BHS     ms_block
+ms_block_end
+    LDMFD   sp!, {r4-r8}
+    ADDS    r2, r2, #28
+    BLO     ms_tail
+ms_word
+    STR     r1, [r0], #4
+    SUBS    r2, r2, #4
+    BHS     ms_word
+ms_tail
+    ADD     r2, r2, #4
+ms_bytes
+    SUBS    r2, r2, #1
+    BXLO    lr
+    STRB    r1, [r0], #1
+    B       ms_bytes
+}
+
+/* The block loops add the carry back twice: a block whose sum ends in 0xFFFFFFFF
+   with carry set would otherwise lose one. */
+__asm UINT32 sys_chksum_words(const void *pvData, UINT32 u32Len)
+{
+    PRESERVE8
+
+    STMFD   sp!, {r4-r9}
+    MOV     r12, #0
+    SUBS    r1, r1, #32
+    BLO     cs_block_end
+cs_block
+    LDMIA   r0!, {r2-r9}
+    ADDS    r12, r12, r2
+    ADCS    r12, r12, r3
+    ADCS    r12, r12, r4
+    ADCS    r12, r12, r5
+    ADCS    r12, r12, r6
+    ADCS    r12, r12, r7
+    ADCS    r12, r12, r8
+    ADCS    r12, r12, r9
+    ADCS    r12, r12, #0
+    ADC     r12, r12, #0
+    SUBS    r1, r1, #32
+    BHS     cs_block
+cs_block_end
+    ADDS    r1, r1, #28
+    BLO     cs_done
+cs_word
+    LDR     r2, [r0], #4
+    ADDS    r12, r12, r2
+    ADC     r12, r12, #0
+    SUBS    r1, r1, #4
+    BHS     cs_word
+cs_done
+    MOV     r0, r12
+    LDMFD   sp!, {r4-r9}
+    BX      lr
+}
+
+__asm UINT32 sys_chksum_copy_words(void *pvDst, const void *pvSrc, UINT32 u32Len)
+{
+    PRESERVE8
+
+    STMFD   sp!, {r4-r10}
+    MOV     r12, #0
+    SUBS    r2, r2, #32
+    BLO     cc_block_end
+cc_block
+    LDMIA   r1!, {r3-r10}
+    STMIA   r0!, {r3-r10}
+    ADDS    r12, r12, r3
+    ADCS    r12, r12, r4
+    ADCS    r12, r12, r5
+    ADCS    r12, r12, r6
+    ADCS    r12, r12, r7
+    ADCS    r12, r12, r8
+    ADCS    r12, r12, r9
+    ADCS    r12, r12, r10
+    ADCS    r12, r12, #0
+    ADC     r12, r12, #0
+    SUBS    r2, r2, #32
+    BHS     cc_block
+cc_block_end
+    ADDS    r2, r2, #28
+    BLO     cc_done
+cc_word
+    LDR     r3, [r1], #4
+    STR     r3, [r0], #4
+    ADDS    r12, r12, r3
+    ADC     r12, r12, #0
+    SUBS    r2, r2, #4
+    BHS     cc_word
+cc_done
+    MOV     r0, r12
+    LDMFD   sp!, {r4-r10}
+    BX      lr
+}
+
+#endif
+
+#else   /* C reference versions */
+
+void sysMemCopy(void *pvDst, const void *pvSrc, UINT32 u32Len)
+{
+    UINT8 *pu8Dst = (UINT8 *)pvDst;
+    const UINT8 *pu8Src = (const UINT8 *)pvSrc;
+
+    if ((((UINT32)pu8Dst ^ (UINT32)pu8Src) & 3) == 0)
+    {
+        while ((u32Len > 0) && ((UINT32)pu8Dst & 3))
+        {
+            *pu8Dst++ = *pu8Src++;
+            u32Len--;
+        }
+        while (u32Len >= 4)
+        {
+            *(UINT32 *)pu8Dst = *(const UINT32 *)pu8Src;
+            pu8Dst += 4;
+            pu8Src += 4;
+            u32Len -= 4;
+        }
+    }
+    while (u32Len--)
+        *pu8Dst++ = *pu8Src++;
+}
+
+void sysMemSet(void *pvDst, INT32 i32Val, UINT32 u32Len)
+{
+    UINT8 *pu8Dst = (UINT8 *)pvDst;
+    UINT32 u32Fill = (i32Val & 0xFF) * 0x01010101UL;
+
+    while ((u32Len > 0) && ((UINT32)pu8Dst & 3))
+    {
+        *pu8Dst++ = (UINT8)u32Fill;
+        u32Len--;
+    }
+    while (u32Len >= 4)
+    {
+        *(UINT32 *)pu8Dst = u32Fill;
+        pu8Dst += 4;
+        u32Len -= 4;
+    }
+    while (u32Len--)
+        *pu8Dst++ = (UINT8)u32Fill;
+}
+
+UINT32 sys_chksum_words(const void *pvData, UINT32 u32Len)
+{
+    const UINT32 *pu32 = (const UINT32 *)pvData;
+    UINT32 u32Sum = 0, u32Word;
+
+    for (; u32Len >= 4; u32Len -= 4)
+    {
+        u32Word = *pu32++;
+        u32Sum += u32Word;
+        if (u32Sum < u32Word)
+            u32Sum++;
+    }
+    return u32Sum;
+}
+
+UINT32 sys_chksum_copy_words(void *pvDst, const void *pvSrc, UINT32 u32Len)
+{
+    sysMemCopy(pvDst, pvSrc, u32Len);
+    return sys_chksum_words(pvDst, u32Len);
+}
+
+#endif
+
+/* One's complement addition of two 32-bit sums */
+static UINT32 sys_add_carry(UINT32 u32Sum, UINT32 u32Add)
+{
+    u32Sum += u32Add;
+    return u32Sum + (u32Sum < u32Add);
+}
+
+/* Sum of up to 3 bytes after a word aligned block, in the lanes they take in a word */
+static UINT32 sys_chksum_tail(UINT32 u32Sum, const UINT8 *pu8Data, UINT32 u32Len)
+{
+    if (u32Len >= 2)
+    {
+        u32Sum = sys_add_carry(u32Sum, *(const UINT16 *)pu8Data);
+        pu8Data += 2;
+    }
+    if (u32Len & 1)
+        u32Sum = sys_add_carry(u32Sum, *pu8Data);
+    return u32Sum;
+}
+
+static UINT16 sys_chksum_fold(UINT32 u32Sum)
+{
+    u32Sum = (u32Sum >> 16) + (u32Sum & 0xFFFF);
+    u32Sum = (u32Sum >> 16) + (u32Sum & 0xFFFF);
+    return (UINT16)u32Sum;
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup SYS_Driver SYS Driver
+  @{
+*/
+
+/** @addtogroup SYS_EXPORTED_FUNCTIONS SYS Exported Functions
+  @{
+*/
+
+/**
+ *  @brief  Internet checksum, a drop-in for lwIP's LWIP_CHKSUM
+ *
+ *  @param[in]  pvData  Data, any alignment
+ *  @param[in]  i32Len  Number of bytes
+ *
+ *  @return Folded 16-bit one's complement sum, not inverted
+ */
+UINT16 sysChksum(const void *pvData, INT32 i32Len)
+{
+    const UINT8 *pu8Data = (const UINT8 *)pvData;
+    UINT32 u32Sum = 0, u32Words, u32Odd;
+
+    if (i32Len <= 0)
+        return 0;
+
+    /* An odd start puts every byte in the other lane, swapped back at the end */
+    u32Odd = (UINT32)pu8Data & 1;
+    if (u32Odd)
+    {
+        u32Sum = (UINT32)*pu8Data++ << 8;
+        i32Len--;
+    }
+    if (((UINT32)pu8Data & 2) && (i32Len >= 2))
+    {
+        u32Sum += *(const UINT16 *)pu8Data;
+        pu8Data += 2;
+        i32Len -= 2;
+    }
+
+    u32Words = (UINT32)i32Len & ~3UL;
+    if (u32Words)
+    {
+        u32Sum = sys_add_carry(u32Sum, sys_chksum_words(pu8Data, u32Words));
+        pu8Data += u32Words;
+    }
+    u32Sum = sys_chksum_tail(u32Sum, pu8Data, (UINT32)i32Len & 3);
+
+    u32Sum = sys_chksum_fold(u32Sum);
+    if (u32Odd)
+        u32Sum = ((u32Sum & 0xFF) << 8) | (u32Sum >> 8);
+    return (UINT16)u32Sum;
+}
+
+/**
+ *  @brief  Copy memory and return its Internet checksum, a drop-in for lwIP's LWIP_CHKSUM_COPY
+ *
+ *  @param[in]  pvDst   Destination, any alignment
+ *  @param[in]  pvSrc   Source, any alignment. Must not overlap the destination.
+ *  @param[in]  u16Len  Number of bytes
+ *
+ *  @return Checksum of the copied data, as sysChksum() returns it
+ *
+ *  @note   The copy and the sum share one pass when both buffers are word aligned.
+ */
+UINT16 sysChksumCopy(void *pvDst, const void *pvSrc, UINT16 u16Len)
+{
+    UINT32 u32Sum, u32Words;
+
+    if ((((UINT32)pvDst | (UINT32)pvSrc) & 3) != 0)
+    {
+        sysMemCopy(pvDst, pvSrc, u16Len);
+        return sysChksum(pvDst, u16Len);
+    }
+
+    u32Words = u16Len & ~3UL;
+    u32Sum = sys_chksum_copy_words(pvDst, pvSrc, u32Words);
+    if (u16Len & 3)
+    {
+        sysMemCopy((UINT8 *)pvDst + u32Words, (const UINT8 *)pvSrc + u32Words, u16Len & 3);
+        u32Sum = sys_chksum_tail(u32Sum, (const UINT8 *)pvDst + u32Words, u16Len & 3);
+    }
+    return sys_chksum_fold(u32Sum);
+}
+
+/*@}*/ /* end of group SYS_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group SYS_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
@@ -0,0 +1,313 @@
+/**************************************************************************//**
+ * @file     motion.c
+ * @brief    NUC980 motion analysis of the CAP motion detection output
+ *
+ * The motion detection block of CAP writes one entry per 8x8 or 16x16 block
+ * each detection frame: a byte holding the DIFF flag in bit 7 and the Y
+ * differential in bits 0-6, or the DIFF flag alone packed eight blocks per
+ * byte, first block in bit 0. CAP_MD_Process() reads that map once per frame:
+ *
+ * - Every block keeps a background level, a running average of its
+ *   differential. A block moves when its differential exceeds the level by
+ *   u32Margin, so blocks that always change (leaves, flicker, noise) stop
+ *   reporting once the level has caught up with them. Moving blocks are
+ *   learned 8 times slower so a lasting change fades into the background
+ *   over a few hundred frames. The first 4 << u32Learn frames only learn.
+ * - Runs of moving blocks are merged row by row into bounding boxes. Runs
+ *   and boxes u32Gap blocks apart or closer are joined.
+ * - The moving blocks in boxes of u32MinBlocks or more give the motion level
+ *   of the frame. An event starts after u32OnFrames frames at or above
+ *   u32OnBlocks and ends after u32OffFrames frames below u32OffBlocks.
+ *
+ * The cost is a few instructions per block plus a scan of at most 16 open
+ * boxes per run, roughly 20 to 30 cycles per block, well under 1 ms for an
+ * 80x60 map at 300 MHz.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+
+#include "nuc980.h"
+#include "sys.h"
+#include "cap.h"
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup CAP_Driver CAP Driver
+  @{
+*/
+
+/// @cond HIDDEN_SYMBOLS
+
+#define MD_WORK_MAX     (2 * CAP_MD_BOX_MAX)
+
+/* Differential of block i, 0 ~ 127 */
+static __inline uint32_t md_diff(const CAP_MD_T *psMd, const uint8_t *pu8Map, uint32_t i)
+{
+    if (psMd->u32Format)
+        return ((pu8Map[i >> 3] >> (i & 7)) & 1) ? 127 : 0;
+    return pu8Map[i] & 0x7F;
+}
+
+/* Boxes a and b are at most u32Gap blocks apart */
+static int md_near(const CAP_MD_T *psMd, const CAP_MD_BOX_T *a, const CAP_MD_BOX_T *b)
+{
+    uint32_t g = psMd->u32Gap + 1;
+
+    return (a->u16X <= b->u16X + b->u16W - 1 + g) && (b->u16X <= a->u16X + a->u16W - 1 + g) &&
+           (a->u16Y <= b->u16Y + b->u16H - 1 + g) && (b->u16Y <= a->u16Y + a->u16H - 1 + g);
+}
+
+/* Grow box a over box b */
+static void md_merge(CAP_MD_BOX_T *a, const CAP_MD_BOX_T *b)
+{
+    uint32_t x1 = a->u16X + a->u16W, y1 = a->u16Y + a->u16H;
+
+    if (b->u16X + b->u16W > x1)
+        x1 = b->u16X + b->u16W;
+    if (b->u16Y + b->u16H > y1)
+        y1 = b->u16Y + b->u16H;
+    if (b->u16X < a->u16X)
+        a->u16X = b->u16X;
+    if (b->u16Y < a->u16Y)
+        a->u16Y = b->u16Y;
+    a->u16W = (uint16_t)(x1 - a->u16X);
+    a->u16H = (uint16_t)(y1 - a->u16Y);
+    a->u16Blocks += b->u16Blocks;
+}
+
+/* Add the run of moving blocks x0 ~ x1 of row y to the open boxes */
+static uint32_t md_add_run(CAP_MD_T *psMd, uint32_t n, uint32_t y, uint32_t x0, uint32_t x1)
+{
+    CAP_MD_BOX_T run, *psBox = psMd->asWork;
+    uint32_t k, first = MD_WORK_MAX, best = 0, dist, bestdist = 0xFFFFFFFF;
+
+    run.u16X = (uint16_t)x0;
+    run.u16Y = (uint16_t)y;
+    run.u16W = (uint16_t)(x1 - x0 + 1);
+    run.u16H = 1;
+    run.u16Blocks = (uint16_t)(x1 - x0 + 1);
+
+    for (k = 0; k < n; k++)
+    {
+        if (!md_near(psMd, &psBox[k], &run))
+            continue;
+        if (first == MD_WORK_MAX)
+        {
+            first = k;
+            md_merge(&psBox[k], &run);
+        }
+        else
+        {
+            /* The run bridges two boxes */
+            md_merge(&psBox[first], &psBox[k]);
+            psBox[k--] = psBox[--n];
+        }
+    }
+    if (first != MD_WORK_MAX)
+        return n;
+
+    if (n < MD_WORK_MAX)
+    {
+        psBox[n] = run;
+        return n + 1;
+    }
+
+    /* No room: join the box closest in x */
+    for (k = 0; k < n; k++)
+    {
+        dist = (psBox[k].u16X > x1) ? psBox[k].u16X - x1 :
+               ((x0 > psBox[k].u16X + psBox[k].u16W) ? x0 - psBox[k].u16X - psBox[k].u16W : 0);
+        if (dist < bestdist)
+        {
+            bestdist = dist;
+            best = k;
+        }
+    }
+    md_merge(&psBox[best], &run);
+    return n;
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/** @addtogroup CAP_EXPORTED_FUNCTIONS CAP Exported Functions
+  @{
+*/
+
+/**
+ * @brief     Set up motion analysis of a motion detection map
+ *
+ * @param[in]  psMd: Motion analysis state
+ *
+ * @param[in]  u32Cols: Blocks per row, the captured width divided by the block size of CAP_EnableMotionDet()
+ *
+ * @param[in]  u32Rows: Block rows
+ *
+ * @param[in]  u32Format: u32Format given to CAP_EnableMotionDet()
+ *                        - FALSE : 1 bit DIFF + 7 bit Y differential per block
+ *                        - TRUE  : 1 bit DIFF per block
+ *
+ * @param[in]  pu16Work: Background levels, \ref CAP_MD_WORK_SIZE (u32Cols, u32Rows) entries
+ *
+ * @return    None
+ *
+ * @details   The first 4 << u32Learn frames given to CAP_MD_Process() only learn the background,
+ *            64 frames with the default u32Learn of 4.
+ */
+void CAP_MD_Init(CAP_MD_T *psMd, uint32_t u32Cols, uint32_t u32Rows, uint32_t u32Format, uint16_t *pu16Work)
+{
+    psMd->u32Cols = u32Cols;
+    psMd->u32Rows = u32Rows;
+    psMd->u32Format = u32Format;
+    psMd->u32Margin = 6;
+    psMd->u32Learn = 4;
+    psMd->u32Gap = 1;
+    psMd->u32MinBlocks = 2;
+    psMd->u32OnBlocks = 3;
+    psMd->u32OffBlocks = 1;
+    psMd->u32OnFrames = 2;
+    psMd->u32OffFrames = 10;
+    psMd->pu16Bg = pu16Work;
+    psMd->u32Frames = 0;
+    psMd->u32Motion = 0;
+    psMd->u32Count = 0;
+    psMd->u32Level = 0;
+    psMd->u32Boxes = 0;
+}
+
+/**
+ * @brief     Analyse one motion detection map
+ *
+ * @param[in]  psMd: Motion analysis state
+ *
+ * @param[in]  pu8Map: Map written by the engine to the u32DetAddr of CAP_EnableMotionDet()
+ *
+ * @return    \ref CAP_MD_EVT_START, \ref CAP_MD_EVT_END and \ref CAP_MD_EVT_MOTION bits
+ *
+ * @details   Call once per motion detection interrupt. The map is invalidated in the D-cache
+ *            before it is read. The boxes of the frame are left in asBox[0 ~ u32Boxes-1].
+ */
+uint32_t CAP_MD_Process(CAP_MD_T *psMd, const uint8_t *pu8Map)
+{
+    uint16_t *pu16Bg = psMd->pu16Bg;
+    CAP_MD_BOX_T *psBox = psMd->asWork, sTmp;
+    uint32_t u32Blocks = psMd->u32Cols * psMd->u32Rows;
+    uint32_t u32Fast = psMd->u32Learn, u32Slow = psMd->u32Learn + 3;
+    uint32_t x, y, i, k, n, d, u32Start, u32Merged, u32Evt = 0;
+    int32_t bg;
+
+    sysInvalidateDCacheRange((uint32_t)pu8Map, psMd->u32Format ? (u32Blocks + 7) >> 3 : u32Blocks);
+
+    if (psMd->u32Frames < (4UL << u32Fast))
+    {
+        /* Warm-up: every block learns at the fast rate, nothing is reported */
+        for (i = 0; i < u32Blocks; i++)
+        {
+            bg = pu16Bg[i];
+            d = md_diff(psMd, pu8Map, i) << 8;
+            pu16Bg[i] = (uint16_t)(psMd->u32Frames ? bg + (((int32_t)d - bg) >> u32Fast) : (int32_t)d);
+        }
+        psMd->u32Frames++;
+        psMd->u32Boxes = 0;
+        psMd->u32Level = 0;
+        return 0;
+    }
+    if (psMd->u32Frames != 0xFFFFFFFF)
+        psMd->u32Frames++;
+
+    /* Classify blocks, learn the background and merge runs into boxes */
+    n = 0;
+    for (y = 0, i = 0; y < psMd->u32Rows; y++)
+    {
+        u32Start = psMd->u32Cols;
+        for (x = 0; x < psMd->u32Cols; x++, i++)
+        {
+            d = md_diff(psMd, pu8Map, i);
+            bg = pu16Bg[i];
+            if (d > (uint32_t)(bg >> 8) + psMd->u32Margin)
+            {
+                pu16Bg[i] = (uint16_t)(bg + (((int32_t)(d << 8) - bg) >> u32Slow));
+                if (u32Start == psMd->u32Cols)
+                    u32Start = x;
+                continue;
+            }
+            pu16Bg[i] = (uint16_t)(bg + (((int32_t)(d << 8) - bg) >> u32Fast));
+            if (u32Start != psMd->u32Cols)
+            {
+                n = md_add_run(psMd, n, y, u32Start, x - 1);
+                u32Start = psMd->u32Cols;
+            }
+        }
+        if (u32Start != psMd->u32Cols)
+            n = md_add_run(psMd, n, y, u32Start, x - 1);
+    }
+
+    /* Boxes that grew into each other */
+    do
+    {
+        u32Merged = 0;
+        for (i = 0; i < n; i++)
+        {
+            for (k = i + 1; k < n; k++)
+            {
+                if (md_near(psMd, &psBox[i], &psBox[k]))
+                {
+                    md_merge(&psBox[i], &psBox[k]);
+                    psBox[k--] = psBox[--n];
+                    u32Merged = 1;
+                }
+            }
+        }
+    } while (u32Merged);
+
+    /* Largest boxes first */
+    for (i = 1; i < n; i++)
+    {
+        sTmp = psBox[i];
+        for (k = i; (k > 0) && (psBox[k - 1].u16Blocks < sTmp.u16Blocks); k--)
+            psBox[k] = psBox[k - 1];
+        psBox[k] = sTmp;
+    }
+    psMd->u32Boxes = 0;
+    psMd->u32Level = 0;
+    for (i = 0; (i < n) && (psMd->u32Boxes < CAP_MD_BOX_MAX) && (psBox[i].u16Blocks >= psMd->u32MinBlocks); i++)
+    {
+        psMd->asBox[psMd->u32Boxes++] = psBox[i];
+        psMd->u32Level += psBox[i].u16Blocks;
+    }
+
+    /* Events with hysteresis on level and duration */
+    if (!psMd->u32Motion)
+    {
+        if (psMd->u32Level < psMd->u32OnBlocks)
+            psMd->u32Count = 0;
+        else if (++psMd->u32Count >= psMd->u32OnFrames)
+        {
+            psMd->u32Motion = 1;
+            psMd->u32Count = 0;
+            u32Evt |= CAP_MD_EVT_START;
+        }
+    }
+    else
+    {
+        if (psMd->u32Level >= psMd->u32OffBlocks)
+            psMd->u32Count = 0;
+        else if (++psMd->u32Count >= psMd->u32OffFrames)
+        {
+            psMd->u32Motion = 0;
+            psMd->u32Count = 0;
+            u32Evt |= CAP_MD_EVT_END;
+        }
+    }
+    if (psMd->u32Motion)
+        u32Evt |= CAP_MD_EVT_MOTION;
+    return u32Evt;
+}
+
+/*@}*/ /* end of group CAP_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group CAP_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
@@ -0,0 +1,366 @@
+/**************************************************************************//**
+ * @file     pcmops.c
+ * @brief    NUC980 PCM mixing and sample format kernels for the I2S audio
+ *           pipeline
+ *
+ * Streams are 16-bit stereo, one word per frame with the left sample in bits
+ * 15:0. i2sPcmMix16() scales both samples of a frame by the top half of a
+ * Q31 gain with SMULTB/SMULTT and adds them into a Q31 accumulator per
+ * channel with QDADD, which doubles the Q30 product and saturates both steps.
+ * Any number of streams can be summed without overflow checks, and the
+ * rounding to 16 or 24 bits in i2sPcmOut16()/i2sPcmOut24() is one QADD.
+ *
+ * 24-bit samples are held sign-extended in 32-bit words, as the I2S DMA
+ * moves them with I2S_BIT_WIDTH_24. i2sPcmPack24()/i2sPcmUnpack24() convert
+ * them to and from 3-byte packed samples, four samples per three words when
+ * the packed side is word aligned.
+ *
+ * On GCC the DSP instructions are inline assembler, armcc has intrinsics for
+ * them. Other compilers, a host build for example, get C with the same
+ * results.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+
+#include "nuc980.h"
+#include "sys.h"
+#include "i2s.h"
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup I2S_Driver I2S Driver
+  @{
+*/
+
+/// @cond HIDDEN_SYMBOLS
+
+#if defined (__GNUC__) && defined(__arm__) && !(__CC_ARM)
+/* a + b, saturated */
+static __inline int32_t pcm_qadd(int32_t a, int32_t b)
+{
+    int32_t r;
+    __asm__("qadd %0, %1, %2" : "=r"(r) : "r"(a), "r"(b));
+    return r;
+}
+/* a + 2b, both steps saturated */
+static __inline int32_t pcm_qdadd(int32_t a, int32_t b)
+{
+    int32_t r;
+    __asm__("qdadd %0, %1, %2" : "=r"(r) : "r"(a), "r"(b));
+    return r;
+}
+/* 16 x 16 multiply of the top half of a by the bottom (B) or top (T) half of b */
+static __inline int32_t pcm_smultb(int32_t a, int32_t b)
+{
+    int32_t r;
+    __asm__("smultb %0, %1, %2" : "=r"(r) : "r"(a), "r"(b));
+    return r;
+}
+static __inline int32_t pcm_smultt(int32_t a, int32_t b)
+{
+    int32_t r;
+    __asm__("smultt %0, %1, %2" : "=r"(r) : "r"(a), "r"(b));
+    return r;
+}
+#else
+#if defined (__CC_ARM)
+#define pcm_qadd(a, b)          __qadd(a, b)
+#define pcm_qdadd(a, b)         __qdadd(a, b)
+#else
+static __inline int32_t pcm_qadd(int32_t a, int32_t b)
+{
+    int32_t r = (int32_t)((uint32_t)a + (uint32_t)b);
+
+    if (((a ^ r) & (b ^ r)) < 0)
+        r = (a < 0) ? (int32_t)0x80000000 : 0x7FFFFFFF;
+    return r;
+}
+#define pcm_qdadd(a, b)         pcm_qadd(a, pcm_qadd(b, b))
+#endif
+/* armcc turns these into SMULTB / SMULTT for the ARM926EJ-S */
+#define pcm_smultb(a, b)        (((int32_t)(a) >> 16) * (int16_t)(b))
+#define pcm_smultt(a, b)        (((int32_t)(a) >> 16) * ((int32_t)(b) >> 16))
+#endif
+
+#define PCM_ALIGNED(p)          (((uint32_t)(p) & 3) == 0)
+
+/// @endcond HIDDEN_SYMBOLS
+
+/** @addtogroup ARM9_I2S_EXPORTED_FUNCTIONS I2S Exported Functions
+  @{
+*/
+
+/**
+ * @brief     Set a gain, at once or with a linear ramp
+ *
+ * @param[in]  psGain: Gain
+ *
+ * @param[in]  u32Gain: New gain in Q15, 0 ~ \ref I2S_GAIN_UNITY
+ *
+ * @param[in]  u32RampFrames: Frames to reach the new gain in, 0 for at once
+ *
+ * @return    None
+ *
+ * @details   May be called while i2sPcmMix16() uses the gain from an interrupt.
+ */
+void i2sPcmSetGain(I2S_GAIN_T *psGain, uint32_t u32Gain, uint32_t u32RampFrames)
+{
+    int32_t i32Target;
+
+    if (u32Gain > I2S_GAIN_UNITY)
+        u32Gain = I2S_GAIN_UNITY;
+    i32Target = (int32_t)(u32Gain << 16);
+
+    /* Stop a running ramp first, so the mixer never sees a half updated one */
+    psGain->u32Ramp = 0;
+    psGain->i32Target = i32Target;
+    if (u32RampFrames == 0)
+    {
+        psGain->i32Gain = i32Target;
+        return;
+    }
+    psGain->i32Step = (i32Target - psGain->i32Gain) / (int32_t)u32RampFrames;
+    psGain->u32Ramp = u32RampFrames;
+}
+
+/**
+ * @brief     Add 16-bit stereo frames times a gain to a mix
+ *
+ * @param[in,out] pi32Acc: Mix, two Q31 words per frame, left first
+ *
+ * @param[in]  pu32Src: Frames, left sample in bits 15:0
+ *
+ * @param[in]  u32Frames: Frames to add
+ *
+ * @param[in,out] psGain: Gain, advanced by the frames of its ramp that are mixed
+ *
+ * @return    None
+ *
+ * @details   Each channel gets pi32Acc = sat(pi32Acc + sat(2 * sample * (gain >> 16))).
+ *            The gain applied to a frame of a ramp is the gain after the step of that frame.
+ */
+void i2sPcmMix16(int32_t *pi32Acc, const uint32_t *pu32Src, uint32_t u32Frames, I2S_GAIN_T *psGain)
+{
+    int32_t g = psGain->i32Gain;
+    int32_t s0, s1;
+
+    for (; u32Frames && psGain->u32Ramp; u32Frames--)
+    {
+        g = (--psGain->u32Ramp) ? g + psGain->i32Step : psGain->i32Target;
+        s0 = (int32_t)*pu32Src++;
+        pi32Acc[0] = pcm_qdadd(pi32Acc[0], pcm_smultb(g, s0));
+        pi32Acc[1] = pcm_qdadd(pi32Acc[1], pcm_smultt(g, s0));
+        pi32Acc += 2;
+    }
+    psGain->i32Gain = g;
+
+    /* A muted stream adds nothing */
+    if ((g >> 16) == 0)
+        return;
+
+    for (; u32Frames >= 2; u32Frames -= 2)
+    {
+        s0 = (int32_t)pu32Src[0];
+        s1 = (int32_t)pu32Src[1];
+        pi32Acc[0] = pcm_qdadd(pi32Acc[0], pcm_smultb(g, s0));
+        pi32Acc[1] = pcm_qdadd(pi32Acc[1], pcm_smultt(g, s0));
+        pi32Acc[2] = pcm_qdadd(pi32Acc[2], pcm_smultb(g, s1));
+        pi32Acc[3] = pcm_qdadd(pi32Acc[3], pcm_smultt(g, s1));
+        pu32Src += 2;
+        pi32Acc += 4;
+    }
+    if (u32Frames)
+    {
+        s0 = (int32_t)pu32Src[0];
+        pi32Acc[0] = pcm_qdadd(pi32Acc[0], pcm_smultb(g, s0));
+        pi32Acc[1] = pcm_qdadd(pi32Acc[1], pcm_smultt(g, s0));
+    }
+}
+
+/**
+ * @brief     Round a mix to 16-bit stereo frames
+ *
+ * @param[out] pu32Dst: Frames, left sample in bits 15:0
+ *
+ * @param[in]  pi32Acc: Mix, two Q31 words per frame
+ *
+ * @param[in]  u32Frames: Frames
+ *
+ * @return    None
+ */
+void i2sPcmOut16(uint32_t *pu32Dst, const int32_t *pi32Acc, uint32_t u32Frames)
+{
+    uint32_t l, r;
+
+    for (; u32Frames; u32Frames--)
+    {
+        l = (uint32_t)pcm_qadd(pi32Acc[0], 0x8000) >> 16;
+        r = (uint32_t)pcm_qadd(pi32Acc[1], 0x8000) & 0xFFFF0000;
+        *pu32Dst++ = l | r;
+        pi32Acc += 2;
+    }
+}
+
+/**
+ * @brief     Round a mix to 24-bit samples
+ *
+ * @param[out] pi32Dst: Samples, sign-extended, two words per frame
+ *
+ * @param[in]  pi32Acc: Mix, two Q31 words per frame
+ *
+ * @param[in]  u32Frames: Frames
+ *
+ * @return    None
+ */
+void i2sPcmOut24(int32_t *pi32Dst, const int32_t *pi32Acc, uint32_t u32Frames)
+{
+    for (; u32Frames; u32Frames--)
+    {
+        pi32Dst[0] = pcm_qadd(pi32Acc[0], 0x80) >> 8;
+        pi32Dst[1] = pcm_qadd(pi32Acc[1], 0x80) >> 8;
+        pi32Dst += 2;
+        pi32Acc += 2;
+    }
+}
+
+/**
+ * @brief     Widen 16-bit stereo frames to 24-bit samples
+ *
+ * @param[out] pi32Dst: Samples, sign-extended, two words per frame
+ *
+ * @param[in]  pu32Src: Frames, left sample in bits 15:0
+ *
+ * @param[in]  u32Frames: Frames
+ *
+ * @return    None
+ */
+void i2sPcm16To24(int32_t *pi32Dst, const uint32_t *pu32Src, uint32_t u32Frames)
+{
+    uint32_t s;
+
+    for (; u32Frames; u32Frames--)
+    {
+        s = *pu32Src++;
+        pi32Dst[0] = (int32_t)(s << 16) >> 8;
+        pi32Dst[1] = (int32_t)(s & 0xFFFF0000) >> 8;
+        pi32Dst += 2;
+    }
+}
+
+/**
+ * @brief     Round 24-bit samples to 16-bit stereo frames
+ *
+ * @param[out] pu32Dst: Frames, left sample in bits 15:0
+ *
+ * @param[in]  pi32Src: Samples in bits 23:0, two words per frame. Bits 31:24 are ignored.
+ *
+ * @param[in]  u32Frames: Frames
+ *
+ * @return    None
+ *
+ * @details   Rounds to nearest and saturates, so 0x7FFF80 and up give 0x7FFF.
+ */
+void i2sPcm24To16(uint32_t *pu32Dst, const int32_t *pi32Src, uint32_t u32Frames)
+{
+    uint32_t l, r;
+
+    for (; u32Frames; u32Frames--)
+    {
+        l = (uint32_t)pcm_qadd((int32_t)((uint32_t)pi32Src[0] << 8), 0x8000) >> 16;
+        r = (uint32_t)pcm_qadd((int32_t)((uint32_t)pi32Src[1] << 8), 0x8000) & 0xFFFF0000;
+        *pu32Dst++ = l | r;
+        pi32Src += 2;
+    }
+}
+
+/**
+ * @brief     Pack 24-bit samples into 3 bytes each
+ *
+ * @param[out] pu8Dst: Packed samples, least significant byte first
+ *
+ * @param[in]  pi32Src: Samples in bits 23:0
+ *
+ * @param[in]  u32Samples: Samples
+ *
+ * @return    None
+ */
+void i2sPcmPack24(uint8_t *pu8Dst, const int32_t *pi32Src, uint32_t u32Samples)
+{
+    uint32_t *pu32Dst, s0, s1, s2, s3;
+
+    if (PCM_ALIGNED(pu8Dst))
+    {
+        pu32Dst = (uint32_t *)pu8Dst;
+        for (; u32Samples >= 4; u32Samples -= 4)
+        {
+            s0 = (uint32_t)pi32Src[0];
+            s1 = (uint32_t)pi32Src[1];
+            s2 = (uint32_t)pi32Src[2];
+            s3 = (uint32_t)pi32Src[3];
+            pu32Dst[0] = (s0 & 0xFFFFFF) | (s1 << 24);
+            pu32Dst[1] = ((s1 >> 8) & 0xFFFF) | (s2 << 16);
+            pu32Dst[2] = ((s2 >> 16) & 0xFF) | (s3 << 8);
+            pu32Dst += 3;
+            pi32Src += 4;
+        }
+        pu8Dst = (uint8_t *)pu32Dst;
+    }
+    for (; u32Samples; u32Samples--)
+    {
+        s0 = (uint32_t)*pi32Src++;
+        pu8Dst[0] = (uint8_t)s0;
+        pu8Dst[1] = (uint8_t)(s0 >> 8);
+        pu8Dst[2] = (uint8_t)(s0 >> 16);
+        pu8Dst += 3;
+    }
+}
+
+/**
+ * @brief     Unpack 3-byte samples to sign-extended 24-bit samples
+ *
+ * @param[out] pi32Dst: Samples, sign-extended
+ *
+ * @param[in]  pu8Src: Packed samples, least significant byte first
+ *
+ * @param[in]  u32Samples: Samples
+ *
+ * @return    None
+ */
+void i2sPcmUnpack24(int32_t *pi32Dst, const uint8_t *pu8Src, uint32_t u32Samples)
+{
+    const uint32_t *pu32Src;
+    uint32_t w0, w1, w2;
+
+    if (PCM_ALIGNED(pu8Src))
+    {
+        pu32Src = (const uint32_t *)pu8Src;
+        for (; u32Samples >= 4; u32Samples -= 4)
+        {
+            w0 = pu32Src[0];
+            w1 = pu32Src[1];
+            w2 = pu32Src[2];
+            pi32Dst[0] = (int32_t)(w0 << 8) >> 8;
+            pi32Dst[1] = ((int32_t)(w1 << 16) >> 8) | (int32_t)(w0 >> 24);
+            pi32Dst[2] = ((int32_t)(w2 << 24) >> 8) | (int32_t)(w1 >> 16);
+            pi32Dst[3] = (int32_t)w2 >> 8;
+            pu32Src += 3;
+            pi32Dst += 4;
+        }
+        pu8Src = (const uint8_t *)pu32Src;
+    }
+    for (; u32Samples; u32Samples--)
+    {
+        w0 = pu8Src[0] | ((uint32_t)pu8Src[1] << 8) | ((uint32_t)pu8Src[2] << 16);
+        *pi32Dst++ = (int32_t)(w0 << 8) >> 8;
+        pu8Src += 3;
+    }
+}
+
+/*@}*/ /* end of group ARM9_I2S_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group I2S_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
@@ -5,11 +5,47 @@
  * SPDX-License-Identifier: Apache-2.0
  * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
 *****************************************************************************/
+#include <string.h>
 #include "nuc980.h"
+#include "sys.h"
 #include "pdma.h"
 
+/* Request source of each channel, one table per controller */
+#define PDMA_IDX(pdma)      (((pdma) == PDMA0) ? 0 : 1)
 
-static uint8_t u32ChSelect[PDMA_CH_MAX];
+static uint8_t u32ChSelect[2][PDMA_CH_MAX];
+
+/* Channel service. Descriptors come from one pool in a single 64 KB page, so a single
+   SCATBA value serves both controllers. The CPU writes them through the non-cacheable
+   alias and the PDMA reads them at their cached address. */
+#define PDMA_SVC_CTL_MSK    (PDMA_DSCT_CTL_TXTYPE_Msk | PDMA_DSCT_CTL_BURSIZE_Msk | PDMA_DSCT_CTL_SAINC_Msk | \
+                             PDMA_DSCT_CTL_DAINC_Msk | PDMA_DSCT_CTL_TXWIDTH_Msk)
+#define PDMA_DESC_UC(i)     ((DSCT_T *)((uint32_t)&s_asDescPool[(i)] | 0x80000000))
+#define PDMA_DESC_ADDR(i)   ((uint32_t)&s_asDescPool[(i)])
+
+typedef struct
+{
+    PDMA_CALLBACK_T pfnCallback;
+    void       *pvUserData;
+    uint32_t    au32Desc[2];        /* Pool descriptors owned by the running transfer */
+    PDMA_SG_T   asHalf[2];          /* Stream buffers */
+    uint32_t    au32HalfCtl[2];     /* Stream descriptor control words, reloaded after each buffer */
+    uint8_t     au8HalfDesc[2];     /* Stream descriptors */
+    uint8_t     u8Half;             /* Stream buffer the next completion belongs to */
+    uint8_t     u8Stream;
+    uint8_t     u8InUse;
+    volatile uint8_t u8Paused;      /* Paused after an abort, the descriptors are still owned */
+    volatile uint8_t u8Busy;
+} PDMA_SVC_CH_T;
+
+#if defined ( __GNUC__ ) && !(__CC_ARM)
+static DSCT_T s_asDescPool[PDMA_SVC_DESC_MAX] __attribute__((aligned(1024)));
+#else
+static __align(1024) DSCT_T s_asDescPool[PDMA_SVC_DESC_MAX];
+#endif
+static PDMA_SVC_CH_T s_asSvcCh[PDMA_SVC_CH_MAX];
+static uint32_t s_au32DescFree[2] = { 0xFFFFFFFFUL, 0xFFFFFFFFUL };
+static uint8_t s_au8SvcInit[2];
 
 /** @addtogroup Standard_Driver Standard Driver
   @{
@@ -44,7 +80,7 @@ void PDMA_Open(PDMA_T * pdma,uint32_t u32Mask)
         if((1 << i) & u32Mask)
         {
             pdma->DSCT[i].CTL = 0UL;
-            u32ChSelect[i] = PDMA_MEM;
+            u32ChSelect[PDMA_IDX(pdma)][i] = PDMA_MEM;
         }
     }
 
@@ -188,7 +224,7 @@ void PDMA_SetTransferAddr(PDMA_T * pdma,uint32_t u32Ch, uint32_t u32SrcAddr, uin
  */
 void PDMA_SetTransferMode(PDMA_T * pdma,uint32_t u32Ch, uint32_t u32Peripheral, uint32_t u32ScatterEn, uint32_t u32DescAddr)
 {
-    u32ChSelect[u32Ch] = u32Peripheral;
+    u32ChSelect[PDMA_IDX(pdma)][u32Ch] = u32Peripheral;
     switch(u32Ch)
     {
     case 0ul:
@@ -363,7 +399,7 @@ void PDMA_SetTimeOut(PDMA_T * pdma,uint32_t u32Ch, uint32_t u32OnOff, uint32_t u
  */
 void PDMA_Trigger(PDMA_T * pdma,uint32_t u32Ch)
 {
-    if(u32ChSelect[u32Ch] == PDMA_MEM)
+    if(u32ChSelect[PDMA_IDX(pdma)][u32Ch] == PDMA_MEM)
     {
         pdma->SWREQ = (1ul << u32Ch);
     }
@@ -436,6 +472,546 @@ void PDMA_DisableInt(PDMA_T * pdma,uint32_t u32Ch, uint32_t u32Mask)
     }
 }
 
+/// @cond HIDDEN_SYMBOLS
+
+static uint32_t PDMA_Lock(void)
+{
+    uint32_t u32IBit = sysGetIBitState();
+
+    sysSetLocalInterrupt(DISABLE_IRQ);
+    return u32IBit;
+}
+
+static void PDMA_Unlock(uint32_t u32IBit)
+{
+    if (u32IBit)
+        sysSetLocalInterrupt(ENABLE_IRQ);
+}
+
+/* Take u32Num pool descriptors, called with IRQ masked. Returns 0 when the pool is short. */
+static uint32_t PDMA_AllocDesc(uint32_t u32Num, uint8_t *pu8Idx, uint32_t *pu32Mask)
+{
+    uint32_t i, n = 0;
+
+    pu32Mask[0] = pu32Mask[1] = 0;
+    for (i = 0; (i < PDMA_SVC_DESC_MAX) && (n < u32Num); i++)
+    {
+        if (s_au32DescFree[i >> 5] & (1UL << (i & 31)))
+        {
+            pu32Mask[i >> 5] |= (1UL << (i & 31));
+            pu8Idx[n++] = (uint8_t)i;
+        }
+    }
+    if (n < u32Num)
+    {
+        pu32Mask[0] = pu32Mask[1] = 0;
+        return 0;
+    }
+    s_au32DescFree[0] &= ~pu32Mask[0];
+    s_au32DescFree[1] &= ~pu32Mask[1];
+    return n;
+}
+
+static void PDMA_FreeDesc(uint32_t *pu32Mask)
+{
+    uint32_t u32IBit = PDMA_Lock();
+
+    s_au32DescFree[0] |= pu32Mask[0];
+    s_au32DescFree[1] |= pu32Mask[1];
+    pu32Mask[0] = pu32Mask[1] = 0;
+    PDMA_Unlock(u32IBit);
+}
+
+/* Release the descriptors of a paused channel once its current transfer has completed, without
+   waiting for it. Returns 1 while the channel is still paused. */
+static uint32_t PDMA_ReleasePaused(int32_t i32Ch)
+{
+    PDMA_SVC_CH_T *psCh = &s_asSvcCh[i32Ch];
+    PDMA_T *pdma = PDMA_SVC_MODULE(i32Ch);
+    uint32_t u32Bit = (1UL << PDMA_SVC_CHANNEL(i32Ch));
+    uint32_t u32IBit, u32Paused;
+
+    u32IBit = PDMA_Lock();
+    if (psCh->u8Paused && !(pdma->TACTSTS & u32Bit))
+    {
+        pdma->TDSTS = u32Bit;
+        pdma->ABTSTS = u32Bit;
+        PDMA_FreeDesc(psCh->au32Desc);
+        psCh->u8Stream = 0;
+        psCh->u8Paused = 0;
+        psCh->u8Busy = 0;
+    }
+    u32Paused = psCh->u8Paused;
+    PDMA_Unlock(u32IBit);
+    return u32Paused;
+}
+
+/* Descriptors needed for a transfer list, 0 if a length is not a multiple of the width */
+static uint32_t PDMA_CountDesc(const PDMA_SG_T *psList, uint32_t u32Num, uint32_t u32Shift)
+{
+    uint32_t i, u32Cnt, n = 0;
+
+    for (i = 0; i < u32Num; i++)
+    {
+        u32Cnt = psList[i].u32Len >> u32Shift;
+        if ((u32Cnt == 0) || (psList[i].u32Len & ((1UL << u32Shift) - 1)))
+            return 0;
+        n += (u32Cnt + PDMA_SVC_TXCNT_MAX - 1) / PDMA_SVC_TXCNT_MAX;
+    }
+    return n;
+}
+
+/* Write back what the PDMA reads and drop the lines it is going to write.
+   Fixed addresses cover one transfer; peripheral registers are not cached and skipped by the cache functions. */
+static void PDMA_SyncBuffer(uint32_t u32Ctl, const PDMA_SG_T *psBuf)
+{
+    uint32_t u32Width = 1UL << ((u32Ctl & PDMA_DSCT_CTL_TXWIDTH_Msk) >> PDMA_DSCT_CTL_TXWIDTH_Pos);
+
+    sysCleanDCacheRange(psBuf->u32Src, ((u32Ctl & PDMA_DSCT_CTL_SAINC_Msk) == PDMA_SAR_FIX) ? u32Width : psBuf->u32Len);
+    sysInvalidateDCacheRange(psBuf->u32Dst, ((u32Ctl & PDMA_DSCT_CTL_DAINC_Msk) == PDMA_DAR_FIX) ? u32Width : psBuf->u32Len);
+}
+
+static void PDMA_StartChannel(int32_t i32Ch)
+{
+    PDMA_T *pdma = PDMA_SVC_MODULE(i32Ch);
+    uint32_t u32Ch = PDMA_SVC_CHANNEL(i32Ch);
+    uint32_t u32IBit;
+
+    s_asSvcCh[i32Ch].u8Busy = 1;
+    /* Descriptors written through the non-cacheable alias must reach memory before the PDMA fetches them */
+    sysDrainWriteBuffer();
+
+    u32IBit = PDMA_Lock();
+    pdma->TDSTS = (1UL << u32Ch);
+    pdma->INTEN |= (1UL << u32Ch);
+    pdma->CHCTL |= (1UL << u32Ch);
+    PDMA_Unlock(u32IBit);
+
+    PDMA_Trigger(pdma, u32Ch);
+}
+
+/* A stream buffer finished: re-arm its descriptor and hand the buffer to the owner */
+static void PDMA_StreamDone(int32_t i32Ch)
+{
+    PDMA_SVC_CH_T *psCh = &s_asSvcCh[i32Ch];
+    PDMA_SG_T *psBuf;
+    uint32_t u32Half = psCh->u8Half;
+    uint32_t u32Ctl = psCh->au32HalfCtl[u32Half];
+
+    psBuf = &psCh->asHalf[u32Half];
+    PDMA_DESC_UC(psCh->au8HalfDesc[u32Half])->CTL = u32Ctl;
+    psCh->u8Half ^= 1;
+
+    if ((u32Ctl & PDMA_DSCT_CTL_DAINC_Msk) != PDMA_DAR_FIX)
+        sysInvalidateDCacheRange(psBuf->u32Dst, psBuf->u32Len);
+    if (psCh->pfnCallback)
+        psCh->pfnCallback(i32Ch, PDMA_EVT_DONE | (u32Half ? PDMA_EVT_PONG : 0), psCh->pvUserData);
+    if ((u32Ctl & PDMA_DSCT_CTL_SAINC_Msk) != PDMA_SAR_FIX)
+        sysCleanDCacheRange(psBuf->u32Src, psBuf->u32Len);
+}
+
+static void PDMA_SvcIRQ(uint32_t u32Idx)
+{
+    PDMA_T *pdma = u32Idx ? PDMA1 : PDMA0;
+    PDMA_SVC_CH_T *psCh;
+    uint32_t u32Sts = pdma->INTSTS;
+    uint32_t u32Abort = 0, u32Done = 0, u32TimeOut, u32Ch, u32Bit;
+    int32_t i32Ch;
+
+    if (u32Sts & PDMA_INTSTS_ABTIF_Msk)
+    {
+        u32Abort = pdma->ABTSTS;
+        pdma->ABTSTS = u32Abort;
+    }
+    if (u32Sts & PDMA_INTSTS_TDIF_Msk)
+    {
+        u32Done = pdma->TDSTS;
+        pdma->TDSTS = u32Done;
+    }
+    u32TimeOut = (u32Sts & PDMA_INTSTS_REQTOFn_Msk) >> PDMA_INTSTS_REQTOF0_Pos;
+    if (u32TimeOut)
+        pdma->INTSTS = u32TimeOut << PDMA_INTSTS_REQTOF0_Pos;
+
+    for (u32Ch = 0; u32Ch < PDMA_CH_MAX; u32Ch++)
+    {
+        u32Bit = (1UL << u32Ch);
+        if (!((u32Abort | u32Done | u32TimeOut) & u32Bit))
+            continue;
+        i32Ch = (int32_t)(u32Idx * PDMA_CH_MAX + u32Ch);
+        psCh = &s_asSvcCh[i32Ch];
+        if (!psCh->u8InUse)
+            continue;
+
+        if (u32Abort & u32Bit)
+        {
+            /* Only pause here; the descriptors are released once the channel has stopped */
+            pdma->INTEN &= ~u32Bit;
+            pdma->PAUSE = u32Bit;
+            psCh->u8Paused = 1;
+            if (psCh->pfnCallback)
+                psCh->pfnCallback(i32Ch, PDMA_EVT_ABORT, psCh->pvUserData);
+            continue;
+        }
+        if (psCh->u8Paused)
+            continue;
+        if ((u32TimeOut & u32Bit) && psCh->pfnCallback)
+            psCh->pfnCallback(i32Ch, PDMA_EVT_TIMEOUT, psCh->pvUserData);
+        if (u32Done & u32Bit)
+        {
+            if (psCh->u8Stream)
+                PDMA_StreamDone(i32Ch);
+            else if ((pdma->DSCT[u32Ch].CTL & PDMA_DSCT_CTL_OPMODE_Msk) == PDMA_OP_STOP)
+            {
+                /* The last descriptor of the list finished */
+                PDMA_FreeDesc(psCh->au32Desc);
+                psCh->u8Busy = 0;
+                if (psCh->pfnCallback)
+                    psCh->pfnCallback(i32Ch, PDMA_EVT_DONE, psCh->pvUserData);
+            }
+        }
+    }
+
+    /* Channels paused by an abort, here or in an earlier interrupt */
+    for (u32Ch = 0; u32Ch < PDMA_CH_MAX; u32Ch++)
+    {
+        i32Ch = (int32_t)(u32Idx * PDMA_CH_MAX + u32Ch);
+        if (s_asSvcCh[i32Ch].u8Paused)
+            PDMA_ReleasePaused(i32Ch);
+    }
+}
+
+static void PDMA0_SvcIRQHandler(void)
+{
+    PDMA_SvcIRQ(0);
+}
+
+static void PDMA1_SvcIRQHandler(void)
+{
+    PDMA_SvcIRQ(1);
+}
+
+/* Clock, descriptor base and interrupt of a controller, on its first service channel */
+static void PDMA_SvcInit(uint32_t u32Idx)
+{
+    PDMA_T *pdma = u32Idx ? PDMA1 : PDMA0;
+
+    if (s_au8SvcInit[u32Idx])
+        return;
+    if (!s_au8SvcInit[u32Idx ^ 1])
+    {
+        /* Drop lines of the pool that may still be dirty from the C library start-up */
+        sysInvalidateDCacheRange((uint32_t)s_asDescPool, sizeof(s_asDescPool));
+    }
+    s_au8SvcInit[u32Idx] = 1;
+
+    outpw(REG_CLK_HCLKEN, inpw(REG_CLK_HCLKEN) | (0x1000 << u32Idx));  /* PDMA0 / PDMA1 clock */
+    pdma->SCATBA = (uint32_t)s_asDescPool & PDMA_SCATBA_SCATBA_Msk;
+    sysInstallISR(IRQ_LEVEL_1, u32Idx ? IRQ_PDMA1 : IRQ_PDMA0,
+                  u32Idx ? (PVOID)PDMA1_SvcIRQHandler : (PVOID)PDMA0_SvcIRQHandler);
+    sysEnableInterrupt(u32Idx ? IRQ_PDMA1 : IRQ_PDMA0);
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/**
+ * @brief       Request a PDMA channel
+ *
+ * @param[in]   u32Peripheral   Request source, \ref PDMA_MEM or a peripheral as for \ref PDMA_SetTransferMode
+ * @param[in]   pfnCallback     Completion callback, NULL to poll \ref PDMA_IsChannelBusy
+ * @param[in]   pvUserData      Passed to the callback
+ *
+ * @return      Channel number, or \ref PDMA_ERR_BUSY when all channels are taken
+ *
+ * @details     Takes a free channel of the controller with fewer channels in use, so concurrent
+ *              transfers spread over PDMA0 and PDMA1. The first channel of a controller enables
+ *              its clock and installs the service interrupt handler, so drivers sharing PDMA
+ *              through this service must not install their own PDMA0/PDMA1 handler.
+ */
+int32_t PDMA_RequestChannel(uint32_t u32Peripheral, PDMA_CALLBACK_T pfnCallback, void *pvUserData)
+{
+    PDMA_SVC_CH_T *psCh;
+    uint32_t au32Used[2] = { 0, 0 };
+    uint32_t u32IBit, u32Idx, i;
+    int32_t i32Ch = PDMA_ERR_BUSY;
+
+    u32IBit = PDMA_Lock();
+    for (i = 0; i < PDMA_SVC_CH_MAX; i++)
+        au32Used[i / PDMA_CH_MAX] += s_asSvcCh[i].u8InUse;
+    u32Idx = (au32Used[1] < au32Used[0]) ? 1 : 0;
+    for (i = 0; i < PDMA_SVC_CH_MAX; i++)
+    {
+        /* Preferred controller first, then the other one */
+        i32Ch = (int32_t)((i + u32Idx * PDMA_CH_MAX) % PDMA_SVC_CH_MAX);
+        if (!s_asSvcCh[i32Ch].u8InUse)
+            break;
+    }
+    if (i == PDMA_SVC_CH_MAX)
+    {
+        PDMA_Unlock(u32IBit);
+        return PDMA_ERR_BUSY;
+    }
+
+    psCh = &s_asSvcCh[i32Ch];
+    memset(psCh, 0, sizeof(PDMA_SVC_CH_T));
+    psCh->pfnCallback = pfnCallback;
+    psCh->pvUserData = pvUserData;
+    psCh->u8InUse = 1;
+
+    PDMA_SvcInit((uint32_t)i32Ch / PDMA_CH_MAX);
+    PDMA_SVC_MODULE(i32Ch)->DSCT[PDMA_SVC_CHANNEL(i32Ch)].CTL = 0;
+    PDMA_SetTransferMode(PDMA_SVC_MODULE(i32Ch), PDMA_SVC_CHANNEL(i32Ch), u32Peripheral, FALSE, 0);
+    PDMA_SVC_MODULE(i32Ch)->CHCTL |= (1UL << PDMA_SVC_CHANNEL(i32Ch));
+    PDMA_Unlock(u32IBit);
+
+    return i32Ch;
+}
+
+/**
+ * @brief       Release a PDMA channel
+ *
+ * @param[in]   i32Ch   Channel returned by \ref PDMA_RequestChannel
+ *
+ * @return      None
+ *
+ * @details     Stops a transfer still in progress and disables the channel.
+ */
+void PDMA_FreeChannel(int32_t i32Ch)
+{
+    uint32_t u32IBit;
+
+    if (((uint32_t)i32Ch >= PDMA_SVC_CH_MAX) || !s_asSvcCh[i32Ch].u8InUse)
+        return;
+
+    PDMA_StopChannel(i32Ch);
+    u32IBit = PDMA_Lock();
+    PDMA_SVC_MODULE(i32Ch)->CHCTL &= ~(1UL << PDMA_SVC_CHANNEL(i32Ch));
+    s_asSvcCh[i32Ch].u8InUse = 0;
+    s_asSvcCh[i32Ch].pfnCallback = NULL;
+    PDMA_Unlock(u32IBit);
+}
+
+/**
+ * @brief       Start a scatter-gather transfer list
+ *
+ * @param[in]   i32Ch       Channel returned by \ref PDMA_RequestChannel
+ * @param[in]   u32Ctl      Transfer attributes, an OR of
+ *                - \ref PDMA_WIDTH_8, \ref PDMA_WIDTH_16 or \ref PDMA_WIDTH_32
+ *                - \ref PDMA_SAR_INC or \ref PDMA_SAR_FIX
+ *                - \ref PDMA_DAR_INC or \ref PDMA_DAR_FIX
+ *                - \ref PDMA_REQ_SINGLE, or \ref PDMA_REQ_BURST with a PDMA_BURST_xxx size
+ * @param[in]   psList      Segments, copied into descriptors before the function returns
+ * @param[in]   u32Num      Number of segments
+ *
+ * @retval      PDMA_OK             Transfer started
+ * @retval      PDMA_ERR_ARG        Bad channel or segment length
+ * @retval      PDMA_ERR_BUSY       The channel has not finished its previous transfer
+ * @retval      PDMA_ERR_NO_DESC    Not enough free descriptors
+ *
+ * @details     Segments longer than \ref PDMA_SVC_TXCNT_MAX transfers are split. A list that fits one
+ *              descriptor runs in basic mode without the pool. Source ranges are written back and
+ *              destination ranges dropped from the D-cache before the start, so the CPU must not
+ *              touch them until the \ref PDMA_EVT_DONE callback. Memory requests are triggered
+ *              here; a peripheral starts the transfer when its PDMA enable is set afterwards.
+ */
+int32_t PDMA_SubmitSG(int32_t i32Ch, uint32_t u32Ctl, const PDMA_SG_T *psList, uint32_t u32Num)
+{
+    PDMA_T *pdma;
+    PDMA_SVC_CH_T *psCh;
+    DSCT_T *psDesc;
+    uint8_t au8Idx[PDMA_SVC_DESC_MAX];
+    uint32_t u32Shift, u32NumDesc, u32Ch, u32Cnt, u32Part, u32Off, u32IBit, i, n;
+
+    if (((uint32_t)i32Ch >= PDMA_SVC_CH_MAX) || !s_asSvcCh[i32Ch].u8InUse || (psList == NULL) || (u32Num == 0))
+        return PDMA_ERR_ARG;
+    psCh = &s_asSvcCh[i32Ch];
+    if (psCh->u8Paused)
+        PDMA_ReleasePaused(i32Ch);
+    if (psCh->u8Busy)
+        return PDMA_ERR_BUSY;
+
+    u32Ctl &= PDMA_SVC_CTL_MSK;
+    u32Shift = (u32Ctl & PDMA_DSCT_CTL_TXWIDTH_Msk) >> PDMA_DSCT_CTL_TXWIDTH_Pos;
+    u32NumDesc = PDMA_CountDesc(psList, u32Num, u32Shift);
+    if ((u32NumDesc == 0) || (u32NumDesc > PDMA_SVC_DESC_MAX))
+        return PDMA_ERR_ARG;
+
+    for (i = 0; i < u32Num; i++)
+        PDMA_SyncBuffer(u32Ctl, &psList[i]);
+
+    pdma = PDMA_SVC_MODULE(i32Ch);
+    u32Ch = PDMA_SVC_CHANNEL(i32Ch);
+    psCh->u8Stream = 0;
+
+    if (u32NumDesc == 1)
+    {
+        pdma->DSCT[u32Ch].SA = psList->u32Src;
+        pdma->DSCT[u32Ch].DA = psList->u32Dst;
+        pdma->DSCT[u32Ch].CTL = u32Ctl | (((psList->u32Len >> u32Shift) - 1UL) << PDMA_DSCT_CTL_TXCNT_Pos) | PDMA_OP_BASIC;
+        PDMA_StartChannel(i32Ch);
+        return PDMA_OK;
+    }
+
+    u32IBit = PDMA_Lock();
+    n = PDMA_AllocDesc(u32NumDesc, au8Idx, psCh->au32Desc);
+    PDMA_Unlock(u32IBit);
+    if (n == 0)
+        return PDMA_ERR_NO_DESC;
+
+    /* Only the last descriptor raises the transfer done interrupt */
+    n = 0;
+    for (i = 0; i < u32Num; i++)
+    {
+        u32Cnt = psList[i].u32Len >> u32Shift;
+        for (u32Off = 0; u32Cnt; u32Cnt -= u32Part)
+        {
+            u32Part = (u32Cnt > PDMA_SVC_TXCNT_MAX) ? PDMA_SVC_TXCNT_MAX : u32Cnt;
+            psDesc = PDMA_DESC_UC(au8Idx[n]);
+            psDesc->SA = psList[i].u32Src + (((u32Ctl & PDMA_DSCT_CTL_SAINC_Msk) == PDMA_SAR_FIX) ? 0 : u32Off);
+            psDesc->DA = psList[i].u32Dst + (((u32Ctl & PDMA_DSCT_CTL_DAINC_Msk) == PDMA_DAR_FIX) ? 0 : u32Off);
+            if (++n < u32NumDesc)
+            {
+                psDesc->CTL = u32Ctl | ((u32Part - 1UL) << PDMA_DSCT_CTL_TXCNT_Pos) | PDMA_TBINTDIS_DISABLE | PDMA_OP_SCATTER;
+                psDesc->NEXT = PDMA_DESC_ADDR(au8Idx[n]) - pdma->SCATBA;
+            }
+            else
+            {
+                psDesc->CTL = u32Ctl | ((u32Part - 1UL) << PDMA_DSCT_CTL_TXCNT_Pos) | PDMA_OP_BASIC;
+                psDesc->NEXT = 0;
+            }
+            u32Off += (u32Part << u32Shift);
+        }
+    }
+
+    pdma->DSCT[u32Ch].CTL = PDMA_OP_SCATTER;
+    pdma->DSCT[u32Ch].NEXT = PDMA_DESC_ADDR(au8Idx[0]) - pdma->SCATBA;
+    PDMA_StartChannel(i32Ch);
+    return PDMA_OK;
+}
+
+/**
+ * @brief       Start ping-pong streaming
+ *
+ * @param[in]   i32Ch       Channel returned by \ref PDMA_RequestChannel
+ * @param[in]   u32Ctl      Transfer attributes as for \ref PDMA_SubmitSG
+ * @param[in]   psPing      First buffer, at most \ref PDMA_SVC_TXCNT_MAX transfers
+ * @param[in]   psPong      Second buffer, at most \ref PDMA_SVC_TXCNT_MAX transfers
+ *
+ * @retval      PDMA_OK             Stream started
+ * @retval      PDMA_ERR_ARG        Bad channel or buffer length
+ * @retval      PDMA_ERR_BUSY       The channel has not finished its previous transfer
+ * @retval      PDMA_ERR_NO_DESC    Not enough free descriptors
+ *
+ * @details     Two descriptors linked in a ring move the buffers in turn until \ref PDMA_StopChannel.
+ *              The callback gets \ref PDMA_EVT_DONE for the first buffer and PDMA_EVT_DONE |
+ *              \ref PDMA_EVT_PONG for the second; the buffer it names may be used until the next
+ *              callback. Its destination is dropped from the D-cache before the callback and its
+ *              source written back after it, so the callback may read or refill it directly.
+ */
+int32_t PDMA_StartStream(int32_t i32Ch, uint32_t u32Ctl, const PDMA_SG_T *psPing, const PDMA_SG_T *psPong)
+{
+    PDMA_T *pdma;
+    PDMA_SVC_CH_T *psCh;
+    DSCT_T *psDesc;
+    uint8_t au8Idx[2];
+    uint32_t u32Shift, u32Ch, u32IBit, i;
+
+    if (((uint32_t)i32Ch >= PDMA_SVC_CH_MAX) || !s_asSvcCh[i32Ch].u8InUse || (psPing == NULL) || (psPong == NULL))
+        return PDMA_ERR_ARG;
+    psCh = &s_asSvcCh[i32Ch];
+    if (psCh->u8Paused)
+        PDMA_ReleasePaused(i32Ch);
+    if (psCh->u8Busy)
+        return PDMA_ERR_BUSY;
+
+    u32Ctl &= PDMA_SVC_CTL_MSK;
+    u32Shift = (u32Ctl & PDMA_DSCT_CTL_TXWIDTH_Msk) >> PDMA_DSCT_CTL_TXWIDTH_Pos;
+    if ((PDMA_CountDesc(psPing, 1, u32Shift) != 1) || (PDMA_CountDesc(psPong, 1, u32Shift) != 1))
+        return PDMA_ERR_ARG;
+
+    u32IBit = PDMA_Lock();
+    i = PDMA_AllocDesc(2, au8Idx, psCh->au32Desc);
+    PDMA_Unlock(u32IBit);
+    if (i == 0)
+        return PDMA_ERR_NO_DESC;
+
+    pdma = PDMA_SVC_MODULE(i32Ch);
+    u32Ch = PDMA_SVC_CHANNEL(i32Ch);
+    psCh->asHalf[0] = *psPing;
+    psCh->asHalf[1] = *psPong;
+    for (i = 0; i < 2; i++)
+    {
+        PDMA_SyncBuffer(u32Ctl, &psCh->asHalf[i]);
+        psCh->au8HalfDesc[i] = au8Idx[i];
+        psCh->au32HalfCtl[i] = u32Ctl | (((psCh->asHalf[i].u32Len >> u32Shift) - 1UL) << PDMA_DSCT_CTL_TXCNT_Pos) | PDMA_OP_SCATTER;
+        psDesc = PDMA_DESC_UC(au8Idx[i]);
+        psDesc->SA = psCh->asHalf[i].u32Src;
+        psDesc->DA = psCh->asHalf[i].u32Dst;
+        psDesc->CTL = psCh->au32HalfCtl[i];
+        psDesc->NEXT = PDMA_DESC_ADDR(au8Idx[i ^ 1]) - pdma->SCATBA;
+    }
+    psCh->u8Half = 0;
+    psCh->u8Stream = 1;
+
+    pdma->DSCT[u32Ch].CTL = PDMA_OP_SCATTER;
+    pdma->DSCT[u32Ch].NEXT = PDMA_DESC_ADDR(au8Idx[0]) - pdma->SCATBA;
+    PDMA_StartChannel(i32Ch);
+    return PDMA_OK;
+}
+
+/**
+ * @brief       Stop a channel
+ *
+ * @param[in]   i32Ch   Channel returned by \ref PDMA_RequestChannel
+ *
+ * @return      None
+ *
+ * @details     Ends a stream or abandons a transfer list without a callback. The channel stays
+ *              allocated and takes the next \ref PDMA_SubmitSG or \ref PDMA_StartStream.
+ *              Waits for the current transfer to complete, so do not call it from interrupt context.
+ */
+void PDMA_StopChannel(int32_t i32Ch)
+{
+    PDMA_T *pdma;
+    PDMA_SVC_CH_T *psCh;
+    uint32_t u32Bit, u32IBit;
+
+    if (((uint32_t)i32Ch >= PDMA_SVC_CH_MAX) || !s_asSvcCh[i32Ch].u8InUse)
+        return;
+    psCh = &s_asSvcCh[i32Ch];
+    pdma = PDMA_SVC_MODULE(i32Ch);
+    u32Bit = (1UL << PDMA_SVC_CHANNEL(i32Ch));
+
+    u32IBit = PDMA_Lock();
+    pdma->INTEN &= ~u32Bit;
+    pdma->PAUSE = u32Bit;
+    psCh->u8Paused = 1;
+    PDMA_Unlock(u32IBit);
+
+    /* The current transfer completes before the channel stops reading descriptors */
+    while (PDMA_ReleasePaused(i32Ch)) {}
+}
+
+/**
+ * @brief       Check whether a channel transfer is in progress
+ *
+ * @param[in]   i32Ch   Channel returned by \ref PDMA_RequestChannel
+ *
+ * @retval      0   Idle, the last transfer list finished
+ * @retval      1   Busy, streaming, or paused by an abort
+ *
+ * @details     Completion is taken from the PDMA interrupt, so IRQ must be enabled while polling.
+ *              A channel paused by \ref PDMA_EVT_ABORT turns idle once its current transfer has
+ *              completed and its descriptors are released, which this function also checks.
+ */
+uint32_t PDMA_IsChannelBusy(int32_t i32Ch)
+{
+    if ((uint32_t)i32Ch >= PDMA_SVC_CH_MAX)
+        return 0;
+    if (s_asSvcCh[i32Ch].u8Paused)
+        PDMA_ReleasePaused(i32Ch);
+    return s_asSvcCh[i32Ch].u8Busy;
+}
+
 /*@}*/ /* end of group PDMA_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group PDMA_Driver */
@@ -0,0 +1,528 @@
+/**************************************************************************//**
+ * @file     pixops.c
+ * @brief    NUC980 pixel format conversion, downscale and crop kernels for
+ *           CAP output
+ *
+ * The kernels read and write 32-bit words: a word of packet YUV422 holds two
+ * pixels (Y0 U Y1 V), a word of a plane four. Channels are worked on in
+ * 16-bit lanes of one register, and the colour matrix is applied with the
+ * ARMv5TE SMLAxy multiply-accumulates, which take a 16-bit half of the
+ * packed chroma or luma word directly, so nothing is unpacked. QADD
+ * saturates at 2^31 only and does not help clamping to 8 bits; the clamp
+ * is one compare and a conditional move.
+ *
+ * Rows that are not word aligned and the last pixels of a row go through the
+ * per-pixel code, which gives the same results. Define CAP_PIX_PORTABLE to
+ * build the per-pixel code only.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+
+#include "nuc980.h"
+#include "sys.h"
+#include "cap.h"
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup CAP_Driver CAP Driver
+  @{
+*/
+
+/// @cond HIDDEN_SYMBOLS
+
+/* BT.601 video range to full range RGB, 8-bit fractions:
+   R = (298 (Y-16) + 409 (V-128) + 128) >> 8
+   G = (298 (Y-16) - 100 (U-128) - 208 (V-128) + 128) >> 8
+   B = (298 (Y-16) + 516 (U-128) + 128) >> 8 */
+#define PIX_CY      298
+#define PIX_CRV     409
+#define PIX_CGU     (-100)
+#define PIX_CGV     (-208)
+#define PIX_CBU     516
+#define PIX_KR      (128 - 16 * PIX_CY - 128 * PIX_CRV)
+#define PIX_KG      (128 - 16 * PIX_CY - 128 * (PIX_CGU + PIX_CGV))
+#define PIX_KB      (128 - 16 * PIX_CY - 128 * PIX_CBU)
+
+#define PIX_ALIGNED(p)  (((uint32_t)(p) & 3) == 0)
+
+#if !defined(CAP_PIX_PORTABLE)
+#define PIX_WORDS
+#endif
+
+/* 16 x 16 + 32 multiply-accumulate on the bottom (B) or top (T) halves */
+#if defined (__GNUC__) && defined(__arm__) && !(__CC_ARM)
+static __inline int32_t pix_smlabb(int32_t a, int32_t b, int32_t c)
+{
+    int32_t r;
+    __asm__("smlabb %0, %1, %2, %3" : "=r"(r) : "r"(a), "r"(b), "r"(c));
+    return r;
+}
+static __inline int32_t pix_smlatb(int32_t a, int32_t b, int32_t c)
+{
+    int32_t r;
+    __asm__("smlatb %0, %1, %2, %3" : "=r"(r) : "r"(a), "r"(b), "r"(c));
+    return r;
+}
+#else
+/* armcc turns these into SMLABB / SMLATB for the ARM926EJ-S */
+#define pix_smlabb(a, b, c)     ((int32_t)(int16_t)(a) * (int16_t)(b) + (c))
+#define pix_smlatb(a, b, c)     (((int32_t)(a) >> 16) * (int16_t)(b) + (c))
+#endif
+
+static __inline uint32_t pix_clip(int32_t v)
+{
+    v >>= 8;
+    if ((uint32_t)v > 255)
+        v = (v < 0) ? 0 : 255;
+    return (uint32_t)v;
+}
+
+static __inline uint32_t pix_565(uint32_t r, uint32_t g, uint32_t b)
+{
+    return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+}
+
+/* One pixel pair of packet YUV422 to R, G and B, per-pixel code */
+static void pix_yuyv_rgb(const uint8_t *pu8Src, uint32_t *pu32Rgb)
+{
+    int32_t y0 = pu8Src[0], u = pu8Src[1], y1 = pu8Src[2], v = pu8Src[3];
+    int32_t r = PIX_CRV * v + PIX_KR, g = PIX_CGU * u + PIX_CGV * v + PIX_KG, b = PIX_CBU * u + PIX_KB;
+
+    pu32Rgb[0] = pix_clip(PIX_CY * y0 + r);
+    pu32Rgb[1] = pix_clip(PIX_CY * y0 + g);
+    pu32Rgb[2] = pix_clip(PIX_CY * y0 + b);
+    pu32Rgb[3] = pix_clip(PIX_CY * y1 + r);
+    pu32Rgb[4] = pix_clip(PIX_CY * y1 + g);
+    pu32Rgb[5] = pix_clip(PIX_CY * y1 + b);
+}
+
+/* Rounded average of four bytes */
+#define PIX_AVG4(a, b, c, d)    (((uint32_t)(a) + (b) + (c) + (d) + 2) >> 2)
+
+/* Sum of the two bytes of each 16-bit lane, four pixels of a plane to two lanes */
+#define PIX_HSUM(w)             (((w) & 0x00FF00FF) + (((w) >> 8) & 0x00FF00FF))
+
+/// @endcond HIDDEN_SYMBOLS
+
+/** @addtogroup CAP_EXPORTED_FUNCTIONS CAP Exported Functions
+  @{
+*/
+
+/**
+ * @brief     Convert packet YUV422 to RGB565
+ *
+ * @param[in]  pvSrc: Pixels in Y0 U Y1 V byte order, as CAP packet output of \ref CAP_PAR_OUTFMT_YUV422
+ *
+ * @param[out] pvDst: RGB565 pixels, 16 bits each
+ *
+ * @param[in]  u32Pixels: Number of pixels, even
+ *
+ * @return    None
+ *
+ * @details   BT.601 video range to full range RGB. Word aligned buffers are converted a pixel pair
+ *            per word.
+ */
+void CAP_PixYUYVToRGB565(const void *pvSrc, void *pvDst, uint32_t u32Pixels)
+{
+    const uint8_t *pu8Src = (const uint8_t *)pvSrc;
+    uint16_t *pu16Dst = (uint16_t *)pvDst;
+    uint32_t au32Rgb[6];
+
+#if defined(PIX_WORDS)
+    if (PIX_ALIGNED(pu8Src) && PIX_ALIGNED(pu16Dst))
+    {
+        const uint32_t *pu32Src = (const uint32_t *)pu8Src;
+        uint32_t *pu32Dst = (uint32_t *)pu16Dst;
+        uint32_t n;
+
+        for (n = u32Pixels >> 1; n; n--)
+        {
+            uint32_t w = *pu32Src++;
+            int32_t y = w & 0x00FF00FF;         /* Y0 | Y1 << 16 */
+            int32_t uv = (w >> 8) & 0x00FF00FF; /* U | V << 16 */
+            int32_t r = pix_smlatb(uv, PIX_CRV, PIX_KR);
+            int32_t g = pix_smlatb(uv, PIX_CGV, pix_smlabb(uv, PIX_CGU, PIX_KG));
+            int32_t b = pix_smlabb(uv, PIX_CBU, PIX_KB);
+
+            *pu32Dst++ = pix_565(pix_clip(pix_smlabb(y, PIX_CY, r)), pix_clip(pix_smlabb(y, PIX_CY, g)), pix_clip(pix_smlabb(y, PIX_CY, b)))
+                         | (pix_565(pix_clip(pix_smlatb(y, PIX_CY, r)), pix_clip(pix_smlatb(y, PIX_CY, g)), pix_clip(pix_smlatb(y, PIX_CY, b))) << 16);
+        }
+        return;
+    }
+#endif
+    for (; u32Pixels >= 2; u32Pixels -= 2, pu8Src += 4)
+    {
+        pix_yuyv_rgb(pu8Src, au32Rgb);
+        *pu16Dst++ = (uint16_t)pix_565(au32Rgb[0], au32Rgb[1], au32Rgb[2]);
+        *pu16Dst++ = (uint16_t)pix_565(au32Rgb[3], au32Rgb[4], au32Rgb[5]);
+    }
+}
+
+/**
+ * @brief     Convert packet YUV422 to RGB888
+ *
+ * @param[in]  pvSrc: Pixels in Y0 U Y1 V byte order
+ *
+ * @param[out] pvDst: 24-bit pixels in R, G, B byte order
+ *
+ * @param[in]  u32Pixels: Number of pixels, even
+ *
+ * @return    None
+ *
+ * @details   With word aligned buffers four pixels are written as three words.
+ */
+void CAP_PixYUYVToRGB888(const void *pvSrc, void *pvDst, uint32_t u32Pixels)
+{
+    const uint8_t *pu8Src = (const uint8_t *)pvSrc;
+    uint8_t *pu8Dst = (uint8_t *)pvDst;
+    uint32_t au32Rgb[6], i;
+
+#if defined(PIX_WORDS)
+    if (PIX_ALIGNED(pu8Src) && PIX_ALIGNED(pu8Dst))
+    {
+        const uint32_t *pu32Src = (const uint32_t *)pu8Src;
+        uint32_t *pu32Dst = (uint32_t *)pu8Dst;
+        uint32_t n, r0, g0, b0, r1, g1, b1, r2, g2, b2, r3, g3, b3;
+
+        for (n = u32Pixels >> 2; n; n--)
+        {
+            uint32_t w = *pu32Src++;
+            int32_t y = w & 0x00FF00FF;
+            int32_t uv = (w >> 8) & 0x00FF00FF;
+            int32_t r = pix_smlatb(uv, PIX_CRV, PIX_KR);
+            int32_t g = pix_smlatb(uv, PIX_CGV, pix_smlabb(uv, PIX_CGU, PIX_KG));
+            int32_t b = pix_smlabb(uv, PIX_CBU, PIX_KB);
+
+            r0 = pix_clip(pix_smlabb(y, PIX_CY, r));
+            g0 = pix_clip(pix_smlabb(y, PIX_CY, g));
+            b0 = pix_clip(pix_smlabb(y, PIX_CY, b));
+            r1 = pix_clip(pix_smlatb(y, PIX_CY, r));
+            g1 = pix_clip(pix_smlatb(y, PIX_CY, g));
+            b1 = pix_clip(pix_smlatb(y, PIX_CY, b));
+
+            w = *pu32Src++;
+            y = w & 0x00FF00FF;
+            uv = (w >> 8) & 0x00FF00FF;
+            r = pix_smlatb(uv, PIX_CRV, PIX_KR);
+            g = pix_smlatb(uv, PIX_CGV, pix_smlabb(uv, PIX_CGU, PIX_KG));
+            b = pix_smlabb(uv, PIX_CBU, PIX_KB);
+
+            r2 = pix_clip(pix_smlabb(y, PIX_CY, r));
+            g2 = pix_clip(pix_smlabb(y, PIX_CY, g));
+            b2 = pix_clip(pix_smlabb(y, PIX_CY, b));
+            r3 = pix_clip(pix_smlatb(y, PIX_CY, r));
+            g3 = pix_clip(pix_smlatb(y, PIX_CY, g));
+            b3 = pix_clip(pix_smlatb(y, PIX_CY, b));
+
+            *pu32Dst++ = r0 | (g0 << 8) | (b0 << 16) | (r1 << 24);
+            *pu32Dst++ = g1 | (b1 << 8) | (r2 << 16) | (g2 << 24);
+            *pu32Dst++ = b2 | (r3 << 8) | (g3 << 16) | (b3 << 24);
+        }
+        pu8Src = (const uint8_t *)pu32Src;
+        pu8Dst = (uint8_t *)pu32Dst;
+        u32Pixels &= 3;
+    }
+#endif
+    for (; u32Pixels >= 2; u32Pixels -= 2, pu8Src += 4)
+    {
+        pix_yuyv_rgb(pu8Src, au32Rgb);
+        for (i = 0; i < 6; i++)
+            *pu8Dst++ = (uint8_t)au32Rgb[i];
+    }
+}
+
+/**
+ * @brief     Extract the luma of packet YUV422 as 8-bit grayscale
+ *
+ * @param[in]  pvSrc: Pixels in Y0 U Y1 V byte order
+ *
+ * @param[out] pvDst: 8-bit pixels
+ *
+ * @param[in]  u32Pixels: Number of pixels, even
+ *
+ * @return    None
+ */
+void CAP_PixYUYVToGray(const void *pvSrc, void *pvDst, uint32_t u32Pixels)
+{
+    const uint8_t *pu8Src = (const uint8_t *)pvSrc;
+    uint8_t *pu8Dst = (uint8_t *)pvDst;
+
+#if defined(PIX_WORDS)
+    if (PIX_ALIGNED(pu8Src) && PIX_ALIGNED(pu8Dst))
+    {
+        const uint32_t *pu32Src = (const uint32_t *)pu8Src;
+        uint32_t *pu32Dst = (uint32_t *)pu8Dst;
+        uint32_t n, a, b;
+
+        for (n = u32Pixels >> 2; n; n--)
+        {
+            a = pu32Src[0] & 0x00FF00FF;
+            b = pu32Src[1] & 0x00FF00FF;
+            pu32Src += 2;
+            *pu32Dst++ = ((a | (a >> 8)) & 0xFFFF) | ((b | (b >> 8)) << 16);
+        }
+        pu8Src = (const uint8_t *)pu32Src;
+        pu8Dst = (uint8_t *)pu32Dst;
+        u32Pixels &= 3;
+    }
+#endif
+    for (; u32Pixels; u32Pixels--, pu8Src += 2)
+        *pu8Dst++ = pu8Src[0];
+}
+
+/**
+ * @brief     Interleave planar YUV to packet YUV422
+ *
+ * @param[in]  pu8Y: Y plane, u32Width bytes per row
+ *
+ * @param[in]  pu8U: U plane, u32Width / 2 bytes per row
+ *
+ * @param[in]  pu8V: V plane, u32Width / 2 bytes per row
+ *
+ * @param[out] pvDst: Pixels in Y0 U Y1 V byte order, u32Width * 2 bytes per row
+ *
+ * @param[in]  u32Width: Pixels per row, even
+ *
+ * @param[in]  u32Height: Rows
+ *
+ * @param[in]  u32Format: Layout of the chroma planes
+ *                      - \ref CAP_PAR_PLNFMT_YUV422 : one chroma row per row
+ *                      - \ref CAP_PAR_PLNFMT_YUV420 : one chroma row per two rows, repeated
+ *
+ * @return    None
+ *
+ * @details   The planes are those of CAP planar output with a stride of u32Width.
+ */
+void CAP_PixPlanarToYUYV(const uint8_t *pu8Y, const uint8_t *pu8U, const uint8_t *pu8V, void *pvDst,
+                         uint32_t u32Width, uint32_t u32Height, uint32_t u32Format)
+{
+    uint8_t *pu8Dst = (uint8_t *)pvDst;
+    const uint8_t *pu8Cu, *pu8Cv;
+    uint32_t u32Row, x;
+
+    for (u32Row = 0; u32Row < u32Height; u32Row++)
+    {
+        x = (u32Format == CAP_PAR_PLNFMT_YUV420) ? (u32Row >> 1) : u32Row;
+        pu8Cu = pu8U + x * (u32Width >> 1);
+        pu8Cv = pu8V + x * (u32Width >> 1);
+        x = 0;
+
+#if defined(PIX_WORDS)
+        if (PIX_ALIGNED(pu8Y) && PIX_ALIGNED(pu8Cu) && PIX_ALIGNED(pu8Cv) && PIX_ALIGNED(pu8Dst))
+        {
+            const uint32_t *pu32Y = (const uint32_t *)pu8Y;
+            const uint32_t *pu32U = (const uint32_t *)pu8Cu;
+            const uint32_t *pu32V = (const uint32_t *)pu8Cv;
+            uint32_t *pu32Dst = (uint32_t *)pu8Dst;
+            uint32_t y, u, v, ul, vl;
+
+            /* Eight pixels: two words of Y, one of U and one of V to four words */
+            for (; x + 8 <= u32Width; x += 8)
+            {
+                u = *pu32U++;
+                v = *pu32V++;
+                ul = (u & 0xFF) | ((u & 0xFF00) << 8);              /* U0 | U1 << 16 */
+                vl = (v & 0xFF) | ((v & 0xFF00) << 8);
+                y = *pu32Y++;
+                *pu32Dst++ = (y & 0xFF) | ((y & 0xFF00) << 8) | ((ul & 0xFF) << 8) | ((vl & 0xFF) << 24);
+                *pu32Dst++ = ((y >> 16) & 0xFF) | ((y >> 8) & 0xFF0000) | ((ul >> 8) & 0xFF00) | ((vl & 0xFF0000) << 8);
+                ul = ((u >> 16) & 0xFF) | ((u >> 8) & 0xFF0000);
+                vl = ((v >> 16) & 0xFF) | ((v >> 8) & 0xFF0000);
+                y = *pu32Y++;
+                *pu32Dst++ = (y & 0xFF) | ((y & 0xFF00) << 8) | ((ul & 0xFF) << 8) | ((vl & 0xFF) << 24);
+                *pu32Dst++ = ((y >> 16) & 0xFF) | ((y >> 8) & 0xFF0000) | ((ul >> 8) & 0xFF00) | ((vl & 0xFF0000) << 8);
+            }
+        }
+#endif
+        for (; x < u32Width; x += 2)
+        {
+            pu8Dst[x * 2] = pu8Y[x];
+            pu8Dst[x * 2 + 1] = pu8Cu[x >> 1];
+            pu8Dst[x * 2 + 2] = pu8Y[x + 1];
+            pu8Dst[x * 2 + 3] = pu8Cv[x >> 1];
+        }
+        pu8Y += u32Width;
+        pu8Dst += u32Width * 2;
+    }
+}
+
+/**
+ * @brief     Halve an 8-bit plane in both directions
+ *
+ * @param[in]  pu8Src: Source plane, a grayscale image or a Y, U or V plane
+ *
+ * @param[in]  u32SrcStride: Bytes per source row
+ *
+ * @param[out] pu8Dst: Destination plane of u32Width / 2 by u32Height / 2 pixels
+ *
+ * @param[in]  u32DstStride: Bytes per destination row
+ *
+ * @param[in]  u32Width: Source pixels per row, even
+ *
+ * @param[in]  u32Height: Source rows, even
+ *
+ * @return    None
+ *
+ * @details   Each output pixel is the rounded average of a 2x2 block. Word aligned rows are done
+ *            eight source pixels a pass with the pairs summed in 16-bit lanes.
+ */
+void CAP_PixDownscale2x(const uint8_t *pu8Src, uint32_t u32SrcStride, uint8_t *pu8Dst, uint32_t u32DstStride,
+                        uint32_t u32Width, uint32_t u32Height)
+{
+    const uint8_t *pu8Top, *pu8Bot;
+    uint8_t *pu8Out;
+    uint32_t u32Row, x;
+
+    for (u32Row = 0; u32Row + 2 <= u32Height; u32Row += 2)
+    {
+        pu8Top = pu8Src + u32Row * u32SrcStride;
+        pu8Bot = pu8Top + u32SrcStride;
+        pu8Out = pu8Dst + (u32Row >> 1) * u32DstStride;
+        x = 0;
+
+#if defined(PIX_WORDS)
+        if (PIX_ALIGNED(pu8Top) && PIX_ALIGNED(pu8Bot) && PIX_ALIGNED(pu8Out))
+        {
+            const uint32_t *pu32Top = (const uint32_t *)pu8Top;
+            const uint32_t *pu32Bot = (const uint32_t *)pu8Bot;
+            uint32_t *pu32Out = (uint32_t *)pu8Out;
+            uint32_t s0, s1;
+
+            for (; x + 8 <= u32Width; x += 8)
+            {
+                s0 = PIX_HSUM(pu32Top[0]) + PIX_HSUM(pu32Bot[0]) + 0x00020002;
+                s1 = PIX_HSUM(pu32Top[1]) + PIX_HSUM(pu32Bot[1]) + 0x00020002;
+                pu32Top += 2;
+                pu32Bot += 2;
+                s0 = (s0 >> 2) & 0x00FF00FF;
+                s1 = (s1 >> 2) & 0x00FF00FF;
+                *pu32Out++ = ((s0 | (s0 >> 8)) & 0xFFFF) | ((s1 | (s1 >> 8)) << 16);
+            }
+        }
+#endif
+        for (; x + 2 <= u32Width; x += 2)
+            pu8Out[x >> 1] = (uint8_t)PIX_AVG4(pu8Top[x], pu8Top[x + 1], pu8Bot[x], pu8Bot[x + 1]);
+    }
+}
+
+/**
+ * @brief     Halve packet YUV422 in both directions
+ *
+ * @param[in]  pvSrc: Source pixels in Y0 U Y1 V byte order
+ *
+ * @param[in]  u32SrcStride: Bytes per source row
+ *
+ * @param[out] pvDst: Destination of u32Width / 2 by u32Height / 2 pixels
+ *
+ * @param[in]  u32DstStride: Bytes per destination row
+ *
+ * @param[in]  u32Width: Source pixels per row, a multiple of 4
+ *
+ * @param[in]  u32Height: Source rows, even
+ *
+ * @return    None
+ *
+ * @details   Each output luma is the rounded average of a 2x2 block, each output chroma pair the
+ *            average of the two pairs of the block.
+ */
+void CAP_PixDownscaleYUYV2x(const void *pvSrc, uint32_t u32SrcStride, void *pvDst, uint32_t u32DstStride,
+                            uint32_t u32Width, uint32_t u32Height)
+{
+    const uint8_t *pu8Top, *pu8Bot;
+    uint8_t *pu8Out;
+    uint32_t u32Row, x;
+
+    for (u32Row = 0; u32Row + 2 <= u32Height; u32Row += 2)
+    {
+        pu8Top = (const uint8_t *)pvSrc + u32Row * u32SrcStride;
+        pu8Bot = pu8Top + u32SrcStride;
+        pu8Out = (uint8_t *)pvDst + (u32Row >> 1) * u32DstStride;
+        x = 0;
+
+#if defined(PIX_WORDS)
+        if (PIX_ALIGNED(pu8Top) && PIX_ALIGNED(pu8Bot) && PIX_ALIGNED(pu8Out))
+        {
+            const uint32_t *pu32Top = (const uint32_t *)pu8Top;
+            const uint32_t *pu32Bot = (const uint32_t *)pu8Bot;
+            uint32_t *pu32Out = (uint32_t *)pu8Out;
+            uint32_t a, c, ya, yc, uv;
+
+            /* Four pixels of two rows to two pixels */
+            for (; x + 4 <= u32Width; x += 4)
+            {
+                a = pu32Top[0];
+                c = pu32Bot[0];
+                ya = (a & 0x00FF00FF) + (c & 0x00FF00FF);               /* Y0 | Y1 << 16, both rows */
+                uv = ((a >> 8) & 0x00FF00FF) + ((c >> 8) & 0x00FF00FF); /* U | V << 16 */
+                a = pu32Top[1];
+                c = pu32Bot[1];
+                pu32Top += 2;
+                pu32Bot += 2;
+                yc = (a & 0x00FF00FF) + (c & 0x00FF00FF);
+                uv += ((a >> 8) & 0x00FF00FF) + ((c >> 8) & 0x00FF00FF) + 0x00020002;
+                ya = ((ya & 0xFFFF) + (ya >> 16) + 2) >> 2;
+                yc = ((yc & 0xFFFF) + (yc >> 16) + 2) >> 2;
+                *pu32Out++ = ya | (yc << 16) | (((uv >> 2) & 0x00FF00FF) << 8);
+            }
+        }
+#endif
+        for (; x + 4 <= u32Width; x += 4)
+        {
+            const uint8_t *t = pu8Top + x * 2, *b = pu8Bot + x * 2;
+            uint8_t *o = pu8Out + x;
+
+            o[0] = (uint8_t)PIX_AVG4(t[0], t[2], b[0], b[2]);
+            o[1] = (uint8_t)PIX_AVG4(t[1], t[5], b[1], b[5]);
+            o[2] = (uint8_t)PIX_AVG4(t[4], t[6], b[4], b[6]);
+            o[3] = (uint8_t)PIX_AVG4(t[3], t[7], b[3], b[7]);
+        }
+    }
+}
+
+/**
+ * @brief     Copy a rectangle out of an image
+ *
+ * @param[in]  pvSrc: Source image
+ *
+ * @param[in]  u32SrcStride: Bytes per source row
+ *
+ * @param[out] pvDst: Destination image
+ *
+ * @param[in]  u32DstStride: Bytes per destination row
+ *
+ * @param[in]  u32X: Left column of the rectangle, even for packet YUV422
+ *
+ * @param[in]  u32Y: Top row of the rectangle
+ *
+ * @param[in]  u32Width: Pixels per row of the rectangle
+ *
+ * @param[in]  u32Height: Rows of the rectangle
+ *
+ * @param[in]  u32Bpp: Bytes per pixel, 1 for a plane, 2 for packet YUV422 or RGB565, 3 for RGB888
+ *
+ * @return    None
+ *
+ * @details   Rows are copied with sysMemCopy().
+ */
+void CAP_PixCrop(const void *pvSrc, uint32_t u32SrcStride, void *pvDst, uint32_t u32DstStride,
+                 uint32_t u32X, uint32_t u32Y, uint32_t u32Width, uint32_t u32Height, uint32_t u32Bpp)
+{
+    const uint8_t *pu8Src = (const uint8_t *)pvSrc + u32Y * u32SrcStride + u32X * u32Bpp;
+    uint8_t *pu8Dst = (uint8_t *)pvDst;
+
+    for (; u32Height; u32Height--)
+    {
+        sysMemCopy(pu8Dst, pu8Src, u32Width * u32Bpp);
+        pu8Src += u32SrcStride;
+        pu8Dst += u32DstStride;
+    }
+}
+
+/*@}*/ /* end of group CAP_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group CAP_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
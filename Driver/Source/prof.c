@@ -0,0 +1,202 @@
+/**************************************************************************//**
+ * @file     prof.c
+ * @brief    NUC980 profiling probes for driver hot paths
+ *
+ * ETIMER4 runs free from PCLK01 with no prescaler, so one tick is two CPU
+ * cycles at the default 300/150 MHz clocks. Its counter is 24 bits wide: a
+ * span longer than 2^24 ticks (112 ms at 150 MHz) is recorded modulo that.
+ *
+ * A probe is a SYS_PROF_T declared with SYS_PROF_DEFINE() next to the code
+ * it times. It joins the list printed by sysProfDump() on its first record.
+ * SYS_PROF_BEGIN() keeps the start stamp in the probe, so one probe times
+ * one path at a time; paths that overlap keep their own stamp with
+ * SYS_PROF_STAMP() and close with SYS_PROF_SINCE().
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include "nuc980.h"
+#include "sys.h"
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup SYS_Driver SYS Driver
+  @{
+*/
+
+/** @addtogroup SYS_EXPORTED_FUNCTIONS SYS Exported Functions
+  @{
+*/
+
+/// @cond HIDDEN_SYMBOLS
+
+#if defined (__CC_ARM)
+#define SYS_PROF_CLZ(x)     __clz(x)
+#else
+#define SYS_PROF_CLZ(x)     __builtin_clz(x)
+#endif
+
+static SYS_PROF_T *_sys_psProfList = NULL;
+
+/* Ticks to CPU cycles, saturating instead of wrapping */
+static UINT32 sys_prof_cycles(UINT64 u64Ticks)
+{
+    UINT64 u64Cycles = u64Ticks * sysGetClock(SYS_CPU) * 1000000 / sysProfGetTickRate();
+
+    return (u64Cycles > 0xFFFFFFFF) ? 0xFFFFFFFF : (UINT32)u64Cycles;
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/**
+ *  @brief  system Profiling - Start the free-running ETIMER4 tick counter
+ *
+ *  @return   None
+ *
+ *  @note   ETIMER4 is taken over by the probes; do not use it elsewhere.
+ */
+void sysProfInit(void)
+{
+    // Enable ETIMER4 engine clock, counting PCLK01
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 12));
+    outpw(REG_CLK_DIVCTL8, (inpw(REG_CLK_DIVCTL8) & ~(0x3 << 24)) | (0x1 << 24));
+
+    outpw(REG_ETMR4_CTL, 0);
+    outpw(REG_ETMR4_PRECNT, 0);
+    outpw(REG_ETMR4_CMPR, SYS_PROF_TICK_MASK);
+    outpw(REG_ETMR4_CTL, (3 << 4) | 1);     /* Continuous mode, counting */
+}
+
+/**
+ *  @brief  system Profiling - Histogram bin of a duration
+ *
+ *  @param[in]  u32Ticks    Duration in timer ticks
+ *
+ *  @return   0 for 0 ticks, else n for 2^(n-1) <= u32Ticks < 2^n, at most SYS_PROF_BINS - 1
+ */
+UINT32 sysProfGetBin(UINT32 u32Ticks)
+{
+    UINT32 u32Bin;
+
+    if (u32Ticks == 0)
+        return 0;
+    u32Bin = 32 - SYS_PROF_CLZ(u32Ticks);
+    return (u32Bin < SYS_PROF_BINS) ? u32Bin : (SYS_PROF_BINS - 1);
+}
+
+/**
+ *  @brief  system Profiling - Record one duration
+ *
+ *  @param[in]  psProbe     Probe to update
+ *  @param[in]  u32Ticks    Duration in timer ticks, only the low 24 bits are used
+ *
+ *  @return   None
+ *
+ *  @note   Called by SYS_PROF_END() and SYS_PROF_SINCE(). Safe from interrupt handlers.
+ */
+void sysProfAdd(SYS_PROF_T *psProbe, UINT32 u32Ticks)
+{
+    UINT32 u32IBit = sysGetIBitState();
+
+    u32Ticks &= SYS_PROF_TICK_MASK;
+
+    sysSetLocalInterrupt(DISABLE_IRQ);
+    if (!psProbe->u32Listed)
+    {
+        psProbe->u32Listed = 1;
+        psProbe->psNext = _sys_psProfList;
+        _sys_psProfList = psProbe;
+    }
+    if ((psProbe->u32Count == 0) || (u32Ticks < psProbe->u32Min))
+        psProbe->u32Min = u32Ticks;
+    if (u32Ticks > psProbe->u32Max)
+        psProbe->u32Max = u32Ticks;
+    psProbe->u32Count++;
+    psProbe->u64Total += u32Ticks;
+    psProbe->au32Hist[sysProfGetBin(u32Ticks)]++;
+    if (u32IBit)
+        sysSetLocalInterrupt(ENABLE_IRQ);
+}
+
+/**
+ *  @brief  system Profiling - Tick rate of the probes
+ *
+ *  @return   Ticks per second
+ */
+UINT32 sysProfGetTickRate(void)
+{
+    return sysGetClock(SYS_PCLK01) * 1000000;
+}
+
+/**
+ *  @brief  system Profiling - Clear the statistics of every probe
+ *
+ *  @return   None
+ */
+void sysProfReset(void)
+{
+    SYS_PROF_T *psProbe;
+    UINT32 u32IBit = sysGetIBitState();
+    UINT32 i;
+
+    sysSetLocalInterrupt(DISABLE_IRQ);
+    for (psProbe = _sys_psProfList; psProbe != NULL; psProbe = psProbe->psNext)
+    {
+        psProbe->u32Count = psProbe->u32Min = psProbe->u32Max = 0;
+        psProbe->u64Total = 0;
+        for (i = 0; i < SYS_PROF_BINS; i++)
+            psProbe->au32Hist[i] = 0;
+    }
+    if (u32IBit)
+        sysSetLocalInterrupt(ENABLE_IRQ);
+}
+
+/**
+ *  @brief  system Profiling - Print every probe that has recorded, in CPU cycles
+ *
+ *  @return   None
+ *
+ *  @note   Each probe gets a second line with its histogram: "<n>:count" for the bins
+ *          that are not empty, bin n holding the durations from 2^(n-1) to 2^n - 1 ticks.
+ */
+void sysProfDump(void)
+{
+    SYS_PROF_T *psProbe, sProbe;
+    UINT32 u32IBit, i;
+
+    printf("%-16s %8s %10s %10s %10s %10s  (CPU cycles, tick = %d/%d)\n", "probe", "count",
+           "min", "avg", "max", "total/1000", sysGetClock(SYS_CPU), sysGetClock(SYS_PCLK01));
+    for (psProbe = _sys_psProfList; psProbe != NULL; psProbe = psProbe->psNext)
+    {
+        /* Take a consistent copy, the probe may be updated from an interrupt */
+        u32IBit = sysGetIBitState();
+        sysSetLocalInterrupt(DISABLE_IRQ);
+        sProbe = *psProbe;
+        if (u32IBit)
+            sysSetLocalInterrupt(ENABLE_IRQ);
+
+        if (sProbe.u32Count == 0)
+            continue;
+        printf("%-16s %8d %10d %10d %10d %10d\n", sProbe.pcName, sProbe.u32Count,
+               sys_prof_cycles(sProbe.u32Min), sys_prof_cycles(sProbe.u64Total / sProbe.u32Count),
+               sys_prof_cycles(sProbe.u32Max), sys_prof_cycles(sProbe.u64Total / 1000));
+        printf("%16s", "");
+        for (i = 0; i < SYS_PROF_BINS; i++)
+        {
+            if (sProbe.au32Hist[i])
+                printf(" %d:%d", i, sProbe.au32Hist[i]);
+        }
+        printf("\n");
+    }
+}
+
+/*@}*/ /* end of group SYS_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group SYS_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
@@ -0,0 +1,590 @@
+/**************************************************************************//**
+ * @file     resample.c
+ * @brief    NUC980 polyphase sample rate converter for 16-bit stereo audio
+ *
+ * Converts between any two sample rates, 44.1 kHz USB audio to a 48 kHz
+ * codec for example, and follows the drift between two clocks of the same
+ * nominal rate with a correction of a part per billion resolution.
+ *
+ * Each output frame is a windowed sinc FIR over u32Taps input frames. The
+ * filter is designed by i2sSrcInit() as I2S_SRC_PHASES + 1 phases, each a
+ * fractional delay of phase / I2S_SRC_PHASES frame; the position of an
+ * output selects two neighbouring phases and the two results are linearly
+ * interpolated, so the ratio is not limited to L / M and the position is
+ * kept to 2^-32 frame. The cut-off is set below the lower of the two Nyquist
+ * frequencies, so downsampling needs about u32Taps * u32InRate / u32OutRate
+ * taps for the same stop band.
+ *
+ * Frames are one word with the left sample in bits 15:0, as in I2S_FIFO_T.
+ * The inner loop loads two coefficients of each phase and two frames per
+ * step and does eight 16 x 16 multiply-accumulates with SMLABB, SMLABT,
+ * SMLATB and SMLATT, about 2 cycles per tap and channel. The two phases are
+ * blended with SMULWB and QDADD and rounded with QDADD.
+ *
+ * i2sSrcWriteFifo() resamples into a FIFO, from a UAC func_au_in callback
+ * into an I2S_STREAM_T for example; i2sSrcReadFifo() resamples out of one,
+ * from the record FIFO of the audio pipeline into a UAC func_au_out callback.
+ * i2sSrcTrack() adjusts the ratio from the level of that FIFO.
+ *
+ * On GCC the DSP instructions are inline assembler, armcc has intrinsics for
+ * them or maps the C expressions to them. Other compilers, a host build for
+ * example, get C with the same results.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+
+#include "nuc980.h"
+#include "sys.h"
+#include "i2s.h"
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup I2S_Driver I2S Driver
+  @{
+*/
+
+/// @cond HIDDEN_SYMBOLS
+
+#if defined (__GNUC__) && defined(__arm__) && !(__CC_ARM)
+/* a - b, saturated */
+static __inline int32_t src_qsub(int32_t a, int32_t b)
+{
+    int32_t r;
+    __asm__("qsub %0, %1, %2" : "=r"(r) : "r"(a), "r"(b));
+    return r;
+}
+/* a + 2b, both steps saturated */
+static __inline int32_t src_qdadd(int32_t a, int32_t b)
+{
+    int32_t r;
+    __asm__("qdadd %0, %1, %2" : "=r"(r) : "r"(a), "r"(b));
+    return r;
+}
+/* 32 x 16 multiply of a by the bottom half of b, bits 47:16 */
+static __inline int32_t src_smulwb(int32_t a, int32_t b)
+{
+    int32_t r;
+    __asm__("smulwb %0, %1, %2" : "=r"(r) : "r"(a), "r"(b));
+    return r;
+}
+/* acc + 16 x 16 multiply of the bottom (B) or top (T) halves of a and b */
+static __inline int32_t src_smlabb(int32_t a, int32_t b, int32_t acc)
+{
+    int32_t r;
+    __asm__("smlabb %0, %1, %2, %3" : "=r"(r) : "r"(a), "r"(b), "r"(acc));
+    return r;
+}
+static __inline int32_t src_smlabt(int32_t a, int32_t b, int32_t acc)
+{
+    int32_t r;
+    __asm__("smlabt %0, %1, %2, %3" : "=r"(r) : "r"(a), "r"(b), "r"(acc));
+    return r;
+}
+static __inline int32_t src_smlatb(int32_t a, int32_t b, int32_t acc)
+{
+    int32_t r;
+    __asm__("smlatb %0, %1, %2, %3" : "=r"(r) : "r"(a), "r"(b), "r"(acc));
+    return r;
+}
+static __inline int32_t src_smlatt(int32_t a, int32_t b, int32_t acc)
+{
+    int32_t r;
+    __asm__("smlatt %0, %1, %2, %3" : "=r"(r) : "r"(a), "r"(b), "r"(acc));
+    return r;
+}
+#else
+#if defined (__CC_ARM)
+#define src_qsub(a, b)          __qsub(a, b)
+#define src_qdadd(a, b)         __qdadd(a, b)
+#else
+static __inline int32_t src_qadd(int32_t a, int32_t b)
+{
+    int32_t r = (int32_t)((uint32_t)a + (uint32_t)b);
+
+    if (((a ^ r) & (b ^ r)) < 0)
+        r = (a < 0) ? (int32_t)0x80000000 : 0x7FFFFFFF;
+    return r;
+}
+static __inline int32_t src_qsub(int32_t a, int32_t b)
+{
+    int32_t r = (int32_t)((uint32_t)a - (uint32_t)b);
+
+    if (((a ^ b) & (a ^ r)) < 0)
+        r = (a < 0) ? (int32_t)0x80000000 : 0x7FFFFFFF;
+    return r;
+}
+#define src_qdadd(a, b)         src_qadd(a, src_qadd(b, b))
+#endif
+/* armcc turns these into SMULWB and SMLAxy for the ARM926EJ-S */
+#define src_smulwb(a, b)        ((int32_t)(((int64_t)(a) * (int16_t)(b)) >> 16))
+#define src_smlabb(a, b, acc)   ((acc) + (int16_t)(a) * (int16_t)(b))
+#define src_smlabt(a, b, acc)   ((acc) + (int16_t)(a) * ((int32_t)(b) >> 16))
+#define src_smlatb(a, b, acc)   ((acc) + ((int32_t)(a) >> 16) * (int16_t)(b))
+#define src_smlatt(a, b, acc)   ((acc) + ((int32_t)(a) >> 16) * ((int32_t)(b) >> 16))
+#endif
+
+#define SRC_PHASE_BITS      7       /* log2(I2S_SRC_PHASES) */
+#define SRC_PI              3.14159265358979323846
+#define SRC_KAISER_BETA     9.0     /* About 90 dB of stop band */
+#define SRC_TRACK_SMOOTH    6       /* Level error low-pass, 1/64 per i2sSrcTrack() */
+#define SRC_TRACK_KP        128     /* Drift correction per frame of level error, in 1/16 ppm */
+#define SRC_TRACK_KI        8       /* Integral term, in 1/2^14 ppm per frame and call */
+
+static double src_sin(double x)
+{
+    double x2, t, s;
+    int i;
+
+    x -= (int)(x / (2 * SRC_PI)) * (2 * SRC_PI);
+    if (x > SRC_PI)
+        x -= 2 * SRC_PI;
+    else if (x < -SRC_PI)
+        x += 2 * SRC_PI;
+    if (x > SRC_PI / 2)
+        x = SRC_PI - x;
+    else if (x < -SRC_PI / 2)
+        x = -SRC_PI - x;
+
+    x2 = x * x;
+    t = s = x;
+    for (i = 2; i < 20; i += 2)
+    {
+        t = -t * x2 / (i * (i + 1));
+        s += t;
+    }
+    return s;
+}
+
+static double src_sqrt(double x)
+{
+    double r = 1.0, last = 0.0;
+    int i;
+
+    if (x <= 0.0)
+        return 0.0;
+    for (i = 0; (i < 64) && (r != last); i++)
+    {
+        last = r;
+        r = 0.5 * (r + x / r);
+    }
+    return r;
+}
+
+/* Modified Bessel function of the first kind, order 0 */
+static double src_i0(double x)
+{
+    double t = 1.0, s = 1.0;
+    int k;
+
+    for (k = 1; (k < 64) && (t > s * 1e-12); k++)
+    {
+        t *= (x * x) / (4.0 * k * k);
+        s += t;
+    }
+    return s;
+}
+
+/*
+ * Windowed sinc with cut-off fc, in cycles per input frame, for each phase p,
+ * a delay of p / I2S_SRC_PHASES frame. Tap k of phase p is at
+ * t = k - (u32Taps / 2 - 1) - p / I2S_SRC_PHASES from the output. Each phase
+ * is scaled to a DC gain of exactly 1 in Q15.
+ */
+static void src_design(int16_t *pi16Coef, uint32_t u32Taps, double fc)
+{
+    float af[I2S_SRC_TAPS_MAX];
+    double half = u32Taps / 2.0, i0beta = src_i0(SRC_KAISER_BETA);
+    double t, u, h, sum;
+    uint32_t p, k, kMax;
+    int32_t c, i32Sum;
+
+    for (p = 0; p <= I2S_SRC_PHASES; p++)
+    {
+        sum = 0.0;
+        for (k = 0; k < u32Taps; k++)
+        {
+            t = (double)k - (half - 1.0) - (double)p / I2S_SRC_PHASES;
+            u = t / half;
+            if ((u <= -1.0) || (u >= 1.0))
+                h = 0.0;
+            else if (t == 0.0)
+                h = 2.0 * fc;
+            else
+                h = src_sin(2.0 * SRC_PI * fc * t) / (SRC_PI * t);
+            h *= src_i0(SRC_KAISER_BETA * src_sqrt(1.0 - u * u)) / i0beta;
+            af[k] = (float)h;
+            sum += h;
+        }
+
+        i32Sum = 0;
+        kMax = 0;
+        for (k = 0; k < u32Taps; k++)
+        {
+            h = af[k] * 32768.0 / sum;
+            c = (int32_t)(h < 0.0 ? h - 0.5 : h + 0.5);
+            pi16Coef[k] = (int16_t)c;
+            i32Sum += c;
+            if (c > pi16Coef[kMax])
+                kMax = k;
+        }
+        /* The rounding error goes to the largest tap */
+        pi16Coef[kMax] += (int16_t)(32768 - i32Sum);
+        pi16Coef += u32Taps;
+    }
+}
+
+/* One output frame from the u32Taps frames at pu32X */
+static uint32_t src_filter(const int16_t *pi16Coef, const uint32_t *pu32X, uint32_t u32Taps, uint32_t u32Frac)
+{
+    const int32_t *pi32C0 = (const int32_t *)(pi16Coef + (u32Frac >> (32 - SRC_PHASE_BITS)) * u32Taps);
+    const int32_t *pi32C1 = pi32C0 + (u32Taps >> 1);
+    int32_t i32Mu = (int32_t)((u32Frac >> (17 - SRC_PHASE_BITS)) & 0x7FFF);
+    int32_t l0 = 0, r0 = 0, l1 = 0, r1 = 0, c0, c1, x0, x1;
+    uint32_t k;
+
+    for (k = u32Taps >> 1; k; k--)
+    {
+        c0 = *pi32C0++;
+        c1 = *pi32C1++;
+        x0 = (int32_t)pu32X[0];
+        x1 = (int32_t)pu32X[1];
+        pu32X += 2;
+        l0 = src_smlabb(c0, x0, l0);
+        r0 = src_smlabt(c0, x0, r0);
+        l0 = src_smlatb(c0, x1, l0);
+        r0 = src_smlatt(c0, x1, r0);
+        l1 = src_smlabb(c1, x0, l1);
+        r1 = src_smlabt(c1, x0, r1);
+        l1 = src_smlatb(c1, x1, l1);
+        r1 = src_smlatt(c1, x1, r1);
+    }
+
+    /* Q30 sums of the two phases, blended by the position between them */
+    l0 = src_qdadd(l0, src_smulwb(src_qsub(l1, l0), i32Mu));
+    r0 = src_qdadd(r0, src_smulwb(src_qsub(r1, r0), i32Mu));
+    return ((uint32_t)src_qdadd(0x8000, l0) >> 16) | ((uint32_t)src_qdadd(0x8000, r0) & 0xFFFF0000);
+}
+
+/* Input frames to give i2sSrcProcess() for u32Frames more outputs */
+static uint32_t src_need(I2S_SRC_T *psSrc, uint32_t u32Frames)
+{
+    uint64_t u64End = ((uint64_t)psSrc->u32StepInt << 32) | psSrc->u32StepFrac;
+
+    /* One frame past the first tap of the last output, plus the taps */
+    u64End = u64End * u32Frames + psSrc->u32Frac;
+    u64End = (u64End >> 32) + psSrc->u32Pos + psSrc->u32Taps;
+    return (u64End > psSrc->u32HistCount) ? (uint32_t)(u64End - psSrc->u32HistCount) : 0;
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/** @addtogroup ARM9_I2S_EXPORTED_FUNCTIONS I2S Exported Functions
+  @{
+*/
+
+/**
+ * @brief     Set up a sample rate converter
+ *
+ * @param[in]  psSrc: Converter
+ *
+ * @param[in]  u32InRate: Input sample rate in Hz
+ *
+ * @param[in]  u32OutRate: Output sample rate in Hz
+ *
+ * @param[in]  u32Taps: Taps per phase, even, 4 ~ \ref I2S_SRC_TAPS_MAX. The stop band is about
+ *                      90 dB down from the lower Nyquist frequency; 32 taps pass up to 0.32 and
+ *                      64 up to 0.41 of the lower sample rate. Downsampling by N needs N times
+ *                      the taps for the same.
+ *
+ * @param[in]  pi16Coef: Filter, \ref I2S_SRC_COEF_SIZE (u32Taps) entries, word aligned
+ *
+ * @param[in]  pu32Hist: Input history, \ref I2S_SRC_HIST_SIZE (u32Taps) frames
+ *
+ * @retval    0 Success
+ * @retval    I2S_ERR_IO Invalid argument
+ *
+ * @details   The filter is designed here in floating point, tens of milliseconds on the
+ *            ARM926EJ-S, so call it before audio starts. Converters of the same rates
+ *            and taps may share pi16Coef. The output lags the input by u32Taps / 2 input frames.
+ */
+int32_t i2sSrcInit(I2S_SRC_T *psSrc, uint32_t u32InRate, uint32_t u32OutRate, uint32_t u32Taps,
+                   int16_t *pi16Coef, uint32_t *pu32Hist)
+{
+    double fc;
+
+    if ((u32InRate == 0) || (u32OutRate == 0) || (u32Taps < 4) || (u32Taps > I2S_SRC_TAPS_MAX) ||
+            (u32Taps & 1) || ((uint32_t)pi16Coef & 3) || (u32InRate / u32OutRate >= I2S_SRC_TAPS_MAX / 2))
+        return I2S_ERR_IO;
+
+    psSrc->pi16Coef = pi16Coef;
+    psSrc->pu32Hist = pu32Hist;
+    psSrc->u32Taps = u32Taps;
+    psSrc->u32HistSize = I2S_SRC_HIST_SIZE(u32Taps);
+    psSrc->u32InRate = u32InRate;
+    psSrc->u32OutRate = u32OutRate;
+
+    /* Pass band to the lower Nyquist frequency less half the transition band of the window */
+    fc = 0.5 - 2.8 / u32Taps;
+    if (u32OutRate < u32InRate)
+        fc = fc * u32OutRate / u32InRate;
+    src_design(pi16Coef, u32Taps, fc);
+
+    i2sSrcReset(psSrc);
+    return 0;
+}
+
+/**
+ * @brief     Forget the input history and the drift correction
+ *
+ * @param[in]  psSrc: Converter
+ *
+ * @return    None
+ *
+ * @details   The history restarts as u32Taps / 2 - 1 frames of silence, so the first output
+ *            is the first input frame.
+ */
+void i2sSrcReset(I2S_SRC_T *psSrc)
+{
+    psSrc->u32HistCount = psSrc->u32Taps / 2 - 1;
+    sysMemSet(psSrc->pu32Hist, 0, psSrc->u32HistCount * 4);
+    psSrc->u32Pos = 0;
+    psSrc->u32Frac = 0;
+    psSrc->i32Level = 0;
+    psSrc->i32Sum = 0;
+    i2sSrcSetDrift(psSrc, 0);
+}
+
+/**
+ * @brief     Set the drift correction
+ *
+ * @param[in]  psSrc: Converter
+ *
+ * @param[in]  i32Ppb: Parts per billion the input clock runs faster than u32InRate,
+ *                     -\ref I2S_SRC_DRIFT_MAX ~ \ref I2S_SRC_DRIFT_MAX
+ *
+ * @return    None
+ *
+ * @details   A faster input clock takes more input frames per output frame. May be called
+ *            between two i2sSrcProcess() calls.
+ */
+void i2sSrcSetDrift(I2S_SRC_T *psSrc, int32_t i32Ppb)
+{
+    uint64_t u64Step;
+
+    if (i32Ppb > I2S_SRC_DRIFT_MAX)
+        i32Ppb = I2S_SRC_DRIFT_MAX;
+    else if (i32Ppb < -I2S_SRC_DRIFT_MAX)
+        i32Ppb = -I2S_SRC_DRIFT_MAX;
+    psSrc->i32Ppb = i32Ppb;
+
+    /* Input frames per output frame in Q32, the nominal step is below 2^38 */
+    u64Step = ((uint64_t)psSrc->u32InRate << 32) / psSrc->u32OutRate;
+    u64Step = (uint64_t)((int64_t)u64Step + (int64_t)(u64Step >> 6) * i32Ppb / (1000000000 >> 6));
+    psSrc->u32StepInt = (uint32_t)(u64Step >> 32);
+    psSrc->u32StepFrac = (uint32_t)u64Step;
+}
+
+/**
+ * @brief     Adjust the drift correction from the level of the FIFO between two clocks
+ *
+ * @param[in]  psSrc: Converter
+ *
+ * @param[in]  u32Level: Frames in the FIFO the converter writes with i2sSrcWriteFifo() or
+ *                       reads with i2sSrcReadFifo()
+ *
+ * @param[in]  u32Target: Level to hold, about half the FIFO
+ *
+ * @return    The drift correction now applied, parts per billion
+ *
+ * @details   Call once per block the other clock moves, every USB frame or I2S period, before
+ *            the converter runs on it. Start once the FIFO has been filled to u32Target.
+ *            A level above target means the input side is ahead in both directions, so the
+ *            step grows. The level error is low-pass filtered and drives a proportional-
+ *            integral loop that settles in about ten seconds with no lasting offset. The
+ *            level moves in whole periods of the other side, so the correction wanders by
+ *            up to 8 ppm per frame of that period around the true drift, far below audible
+ *            pitch changes.
+ */
+int32_t i2sSrcTrack(I2S_SRC_T *psSrc, uint32_t u32Level, uint32_t u32Target)
+{
+    int32_t i32Err = ((int32_t)u32Level - (int32_t)u32Target) * 256;
+    int32_t i32Max = (int32_t)(((int64_t)I2S_SRC_DRIFT_MAX << 14) / (1000 * SRC_TRACK_KI));
+    int64_t i64Ppb;
+
+    psSrc->i32Level += (i32Err - psSrc->i32Level) >> SRC_TRACK_SMOOTH;
+    psSrc->i32Sum += psSrc->i32Level >> 8;
+    if (psSrc->i32Sum > i32Max)
+        psSrc->i32Sum = i32Max;
+    else if (psSrc->i32Sum < -i32Max)
+        psSrc->i32Sum = -i32Max;
+
+    i64Ppb = (int64_t)psSrc->i32Level * (SRC_TRACK_KP * 1000 / 16) / 256 +
+             (int64_t)psSrc->i32Sum * (SRC_TRACK_KI * 1000) / (1 << 14);
+    if (i64Ppb > I2S_SRC_DRIFT_MAX)
+        i64Ppb = I2S_SRC_DRIFT_MAX;
+    else if (i64Ppb < -I2S_SRC_DRIFT_MAX)
+        i64Ppb = -I2S_SRC_DRIFT_MAX;
+    i2sSrcSetDrift(psSrc, (int32_t)i64Ppb);
+    return psSrc->i32Ppb;
+}
+
+/**
+ * @brief     Convert frames
+ *
+ * @param[in]  psSrc: Converter
+ *
+ * @param[in]  pu32In: Input frames, left sample in bits 15:0
+ *
+ * @param[in,out] pu32InFrames: Input frames given, returns the frames taken
+ *
+ * @param[out] pu32Out: Output frames
+ *
+ * @param[in]  u32OutFrames: Most output frames to make
+ *
+ * @return    Output frames made
+ *
+ * @details   Stops when u32OutFrames are made or the input is used up. Input is only taken
+ *            as outputs need it, so frames not taken must be given again next time.
+ */
+uint32_t i2sSrcProcess(I2S_SRC_T *psSrc, const uint32_t *pu32In, uint32_t *pu32InFrames,
+                       uint32_t *pu32Out, uint32_t u32OutFrames)
+{
+    uint32_t *pu32Hist = psSrc->pu32Hist;
+    uint32_t u32Taps = psSrc->u32Taps;
+    uint32_t u32Pos = psSrc->u32Pos, u32Count = psSrc->u32HistCount, u32Frac = psSrc->u32Frac;
+    uint32_t u32In = *pu32InFrames, u32Used = 0, n = 0, k, u32Old;
+
+    while (n < u32OutFrames)
+    {
+        if (u32Pos + u32Taps > u32Count)
+        {
+            if (u32Used == u32In)
+                break;
+
+            /* Keep the frames still under the taps, drop the ones stepped over */
+            if (u32Pos < u32Count)
+            {
+                u32Count -= u32Pos;
+                for (k = 0; k < u32Count; k++)
+                    pu32Hist[k] = pu32Hist[u32Pos + k];
+                u32Pos = 0;
+            }
+            else
+            {
+                u32Pos -= u32Count;
+                u32Count = 0;
+                k = (u32Pos < u32In - u32Used) ? u32Pos : u32In - u32Used;
+                u32Used += k;
+                u32Pos -= k;
+            }
+
+            k = psSrc->u32HistSize - u32Count;
+            if (k > u32In - u32Used)
+                k = u32In - u32Used;
+            sysMemCopy(&pu32Hist[u32Count], &pu32In[u32Used], k * 4);
+            u32Count += k;
+            u32Used += k;
+            continue;
+        }
+
+        pu32Out[n++] = src_filter(psSrc->pi16Coef, &pu32Hist[u32Pos], u32Taps, u32Frac);
+        u32Old = u32Frac;
+        u32Frac += psSrc->u32StepFrac;
+        u32Pos += psSrc->u32StepInt + (u32Frac < u32Old);
+    }
+
+    psSrc->u32Pos = u32Pos;
+    psSrc->u32HistCount = u32Count;
+    psSrc->u32Frac = u32Frac;
+    *pu32InFrames = u32Used;
+    return n;
+}
+
+/**
+ * @brief     Convert frames into a FIFO, as many as fit
+ *
+ * @param[in]  psSrc: Converter
+ *
+ * @param[in]  psFifo: FIFO, of an I2S_STREAM_T for example
+ *
+ * @param[in]  pu32In: Input frames, a UAC func_au_in buffer for example
+ *
+ * @param[in]  u32Frames: Input frames
+ *
+ * @return    Input frames taken, less than u32Frames when the FIFO is full
+ *
+ * @details   Only the producer of the FIFO may call this.
+ */
+uint32_t i2sSrcWriteFifo(I2S_SRC_T *psSrc, I2S_FIFO_T *psFifo, const uint32_t *pu32In, uint32_t u32Frames)
+{
+    uint32_t u32Head = psFifo->u32Head, u32Used = 0, u32Idx, u32Part, u32Take, n;
+
+    while (u32Used < u32Frames)
+    {
+        u32Part = psFifo->u32Size - (u32Head - psFifo->u32Tail);
+        if (u32Part == 0)
+            break;
+        u32Idx = u32Head & (psFifo->u32Size - 1);
+        if (u32Part > psFifo->u32Size - u32Idx)
+            u32Part = psFifo->u32Size - u32Idx;
+
+        u32Take = u32Frames - u32Used;
+        n = i2sSrcProcess(psSrc, pu32In + u32Used, &u32Take, &psFifo->pu32Buf[u32Idx], u32Part);
+        u32Used += u32Take;
+        u32Head += n;
+        psFifo->u32Head = u32Head;
+        if (n < u32Part)
+            break;
+    }
+    return u32Used;
+}
+
+/**
+ * @brief     Convert frames out of a FIFO
+ *
+ * @param[in]  psSrc: Converter
+ *
+ * @param[in]  psFifo: FIFO, the record FIFO of the audio pipeline for example
+ *
+ * @param[out] pu32Out: Output frames, a UAC func_au_out buffer for example
+ *
+ * @param[in]  u32Frames: Output frames wanted
+ *
+ * @return    Output frames made, less than u32Frames when the FIFO runs empty
+ *
+ * @details   Only the consumer of the FIFO may call this.
+ */
+uint32_t i2sSrcReadFifo(I2S_SRC_T *psSrc, I2S_FIFO_T *psFifo, uint32_t *pu32Out, uint32_t u32Frames)
+{
+    uint32_t u32Tail = psFifo->u32Tail, u32Made = 0, u32Idx, u32Part, n;
+
+    while (u32Made < u32Frames)
+    {
+        u32Part = psFifo->u32Head - u32Tail;
+        if (u32Part == 0)
+            break;
+        u32Idx = u32Tail & (psFifo->u32Size - 1);
+        if (u32Part > psFifo->u32Size - u32Idx)
+            u32Part = psFifo->u32Size - u32Idx;
+
+        /* Take only the frames the outputs need, so the FIFO level stays a true measure */
+        n = src_need(psSrc, u32Frames - u32Made);
+        if (n > u32Part)
+            n = u32Part;
+        u32Made += i2sSrcProcess(psSrc, &psFifo->pu32Buf[u32Idx], &n, pu32Out + u32Made, u32Frames - u32Made);
+        u32Tail += n;
+        psFifo->u32Tail = u32Tail;
+        if ((n < u32Part) && (u32Made < u32Frames))
+            break;
+    }
+    return u32Made;
+}
+
+/*@}*/ /* end of group ARM9_I2S_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group I2S_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "nuc980.h"
+#include "sys.h"
 #include "sdh.h"
 
 /** @addtogroup Standard_Driver Standard Driver
@@ -46,6 +47,10 @@ static uint8_t _SDH_ucSDHCBuffer[512] __attribute__((aligned(32)));
 
 int SDH_ok = 0;
 
+/* Successful SDH_Read()/SDH_Write() calls, from card select to the end of the stop command */
+SYS_PROF_DEFINE(_SDH_sProfRead, "sdh read")
+SYS_PROF_DEFINE(_SDH_sProfWrite, "sdh write")
+
 SDH_INFO_T SD0,SD1;
 
 void SDH_CheckRB(SDH_T *sdh)
@@ -234,6 +239,9 @@ uint32_t SDH_SDCmdAndRspDataIn(SDH_T *sdh, uint32_t ucCmd, uint32_t uArg)
     volatile uint32_t buf;
     SDH_INFO_T *pSD;
 
+    /* Data-in commands always land in _SDH_ucSDHCBuffer */
+    sysInvalidateDCacheRange((uint32_t)_SDH_ucSDHCBuffer, sizeof(_SDH_ucSDHCBuffer));
+
     if (sdh == SDH0)
     {
         pSD = &SD0;
@@ -879,7 +887,8 @@ uint32_t SDH_Probe(SDH_T *sdh)
  *  @brief  This function use to read data from SD card.
  *
  *  @param[in]     sdh           Select SDH0 or SDH1.
- *  @param[out]    pu8BufAddr    The buffer to receive the data from SD card.
+ *  @param[out]    pu8BufAddr    The buffer to receive the data from SD card. It may be cacheable; the
+ *                               driver discards its D-cache lines before the transfer.
  *  @param[in]     u32StartSec   The start read sector address.
  *  @param[in]     u32SecCount   The the read sector number of data
  *
@@ -906,6 +915,7 @@ uint32_t SDH_Read(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_
         return SDH_SELECT_ERROR;
     }
 
+    SYS_PROF_BEGIN(_SDH_sProfRead);
     if ((status = SDH_SDCmdAndRsp(sdh, 7ul, pSD->RCA, 0ul)) != Successful)
     {
         return status;
@@ -922,6 +932,7 @@ uint32_t SDH_Read(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_
         sdh->CMDARG = u32StartSec * blksize;
     }
 
+    sysInvalidateDCacheRange((uint32_t)pu8BufAddr, u32SecCount * blksize);
     sdh->DMASA = (uint32_t)pu8BufAddr;
     loop = u32SecCount / 255ul;
     for (i=0ul; i<loop; i++)
@@ -1005,6 +1016,7 @@ uint32_t SDH_Read(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_
     {
     }
 
+    SYS_PROF_END(_SDH_sProfRead);
     return Successful;
 }
 
@@ -1013,7 +1025,8 @@ uint32_t SDH_Read(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_
  *  @brief  This function use to write data to SD card.
  *
  *  @param[in]    sdh           Select SDH0 or SDH1.
- *  @param[in]    pu8BufAddr    The buffer to send the data to SD card.
+ *  @param[in]    pu8BufAddr    The buffer to send the data to SD card. It may be cacheable; the
+ *                              driver cleans its D-cache lines before the transfer.
  *  @param[in]    u32StartSec   The start write sector address.
  *  @param[in]    u32SecCount   The the write sector number of data.
  *
@@ -1044,6 +1057,7 @@ uint32_t SDH_Write(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32
         return SDH_SELECT_ERROR;
     }
 
+    SYS_PROF_BEGIN(_SDH_sProfWrite);
     if ((status = SDH_SDCmdAndRsp(sdh, 7ul, pSD->RCA, 0ul)) != Successful)
     {
         return status;
@@ -1063,6 +1077,7 @@ uint32_t SDH_Write(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32
         sdh->CMDARG = u32StartSec * SDH_BLOCK_SIZE;  /* set start address for SD CMD */
     }
 
+    sysCleanDCacheRange((uint32_t)pu8BufAddr, u32SecCount * SDH_BLOCK_SIZE);
     sdh->DMASA = (uint32_t)pu8BufAddr;
     loop = u32SecCount / 255ul;   /* the maximum block count is 0xFF=255 for register SDCR[BLK_CNT] */
     for (i=0ul; i<loop; i++)
@@ -1138,6 +1153,7 @@ uint32_t SDH_Write(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32
     {
     }
 
+    SYS_PROF_END(_SDH_sProfWrite);
     return Successful;
 }
 
@@ -0,0 +1,787 @@
+/**************************************************************************//**
+ * @file     spinor.c
+ * @brief    NUC980 series SPI NOR flash driver source file
+ *
+ * Size, erase sizes, read opcode, quad enable method and 4-byte addressing
+ * come from the JEDEC SFDP tables of the flash (JESD216), so one driver serves
+ * any part that has them. The quad enable bit is set once by SPINOR_Open(),
+ * the WP#/HOLD# pins then stay data pins and never need switching.
+ *
+ * Data moves through the QSPI FIFO 32 bits at a time with byte reorder, which
+ * keeps memory byte order; long reads are drained by a pair of PDMA channels,
+ * one feeding clocks to TX and one emptying RX. Reads and programs outside the
+ * block of an erase started by SPINOR_EraseStart() suspend it and resume it.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include <string.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "qspi.h"
+#include "pdma.h"
+#include "spinor.h"
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup SPINOR_Driver SPINOR Driver
+  @{
+*/
+
+/** @addtogroup SPINOR_EXPORTED_FUNCTIONS SPINOR Exported Functions
+  @{
+*/
+
+/// @cond HIDDEN_SYMBOLS
+
+#define SPINOR_FIFO_DEPTH       8           /* Transfers in flight, no more than the RX FIFO holds */
+#define SPINOR_PDMA_CHUNK       0x10000     /* Bytes per PDMA transfer, one descriptor each */
+#define SPINOR_16MB             0x1000000
+
+#define SPINOR_OP_WREN          0x06
+#define SPINOR_OP_RDSR          0x05
+#define SPINOR_OP_RDSR2         0x35
+#define SPINOR_OP_WRSR          0x01
+#define SPINOR_OP_WRSR2         0x31
+#define SPINOR_OP_RDSR2_B7      0x3F
+#define SPINOR_OP_WRSR2_B7      0x3E
+#define SPINOR_OP_RDID          0x9F
+#define SPINOR_OP_RDSFDP        0x5A
+#define SPINOR_OP_EN4B          0xB7
+#define SPINOR_OP_FAST_READ     0x0B
+#define SPINOR_OP_PP            0x02
+#define SPINOR_OP_PP_4B         0x12
+
+#define SPINOR_SR_WIP           0x01
+
+#define SFDP_SIGNATURE          0x50444653  /* "SFDP" */
+#define SFDP_BFPT_ID            0xFF00      /* Basic flash parameter table */
+#define SFDP_4BAIT_ID           0xFF84      /* 4-byte address instruction table */
+#define SFDP_BFPT_DWORDS        16          /* JESD216B, later DWORDs are not used */
+
+/* What SFDP says about 4-byte addressing, applied once the read mode is settled */
+typedef struct
+{
+    uint32_t u32AddrMode;       /* BFPT DWORD 1 [18:17]: 0 3-byte, 1 3- or 4-byte, 2 4-byte only */
+    uint32_t u32Enter4B;        /* BFPT DWORD 16 [31:24]: bit 0 B7h, bit 1 06h then B7h */
+    uint32_t au32Bait[2];       /* 4-byte address instruction table, 0 if absent */
+} SPINOR_ADDR4_T;
+
+/* A fixed word for the TX PDMA channel, its value only clocks the flash */
+static uint32_t s_u32Fill;
+
+static void spinor_idle(QSPI_T *qspi)
+{
+    while (QSPI_IS_BUSY(qspi));
+}
+
+/* One transfer of u32Bits bits; the width only changes once the previous transfer is out */
+static void spinor_send(QSPI_T *qspi, uint32_t u32Data, uint32_t u32Bits)
+{
+    spinor_idle(qspi);
+    QSPI_SET_DATA_WIDTH(qspi, u32Bits);
+    QSPI_WRITE_TX(qspi, u32Data);
+}
+
+/* 32-bit transfers with byte reorder, so the first byte on the bus is the lowest in memory */
+static void spinor_word_mode(QSPI_T *qspi, uint32_t u32On)
+{
+    spinor_idle(qspi);
+    if (u32On)
+    {
+        QSPI_SET_DATA_WIDTH(qspi, 32);
+        QSPI_ENABLE_BYTE_REORDER(qspi);
+    }
+    else
+    {
+        QSPI_DISABLE_BYTE_REORDER(qspi);
+        QSPI_SET_DATA_WIDTH(qspi, 8);
+    }
+}
+
+/* Select the flash and send opcode, address and wait clocks; the data phase follows in 8-bit
+   transfers, on four lines unless u32Io is SPINOR_IO_111 */
+static void spinor_start(SPINOR_T *psNor, uint8_t u8Op, uint32_t u32Addr, uint32_t u32AddrLen,
+                         uint32_t u32Wait, uint32_t u32Io)
+{
+    QSPI_T *qspi = psNor->qspi;
+
+    QSPI_SET_SS_LOW(qspi);
+    spinor_send(qspi, u8Op, 8);
+    if (u32Io == SPINOR_IO_144)
+    {
+        spinor_idle(qspi);
+        QSPI_ENABLE_QUAD_OUTPUT_MODE(qspi);
+    }
+    if (u32AddrLen)
+        spinor_send(qspi, u32Addr, u32AddrLen * 8);
+    if (u32Wait)
+        spinor_send(qspi, 0, u32Wait * ((u32Io == SPINOR_IO_144) ? 4 : 1));
+    spinor_idle(qspi);
+    if (u32Io != SPINOR_IO_111)
+        QSPI_ENABLE_QUAD_INPUT_MODE(qspi);
+    QSPI_SET_DATA_WIDTH(qspi, 8);
+    QSPI_ClearRxFIFO(qspi);
+}
+
+static void spinor_end(QSPI_T *qspi)
+{
+    spinor_idle(qspi);
+    QSPI_SET_SS_HIGH(qspi);
+    QSPI_DISABLE_QUAD_MODE(qspi);
+    QSPI_ClearRxFIFO(qspi);
+}
+
+/* Clock in u32Cnt transfers of the current width, keeping TX fed while RX drains */
+static void spinor_rx(QSPI_T *qspi, void *pvBuf, uint32_t u32Cnt, uint32_t u32Word)
+{
+    uint8_t *pu8Buf = (uint8_t *)pvBuf;
+    uint32_t *pu32Buf = (uint32_t *)pvBuf;
+    uint32_t u32Tx = 0, u32Rx = 0;
+
+    while (u32Rx < u32Cnt)
+    {
+        if ((u32Tx < u32Cnt) && (u32Tx - u32Rx < SPINOR_FIFO_DEPTH) && !QSPI_GET_TX_FIFO_FULL_FLAG(qspi))
+        {
+            QSPI_WRITE_TX(qspi, 0);
+            u32Tx++;
+        }
+        if (!QSPI_GET_RX_FIFO_EMPTY_FLAG(qspi))
+        {
+            if (u32Word)
+                pu32Buf[u32Rx++] = QSPI_READ_RX(qspi);
+            else
+                pu8Buf[u32Rx++] = (uint8_t)QSPI_READ_RX(qspi);
+        }
+    }
+}
+
+/* Send u32Cnt transfers of the current width; what comes back is dropped by spinor_end() */
+static void spinor_tx(QSPI_T *qspi, const void *pvBuf, uint32_t u32Cnt, uint32_t u32Word)
+{
+    const uint8_t *pu8Buf = (const uint8_t *)pvBuf;
+    const uint32_t *pu32Buf = (const uint32_t *)pvBuf;
+    uint32_t i;
+
+    for (i = 0; i < u32Cnt; i++)
+    {
+        while (QSPI_GET_TX_FIFO_FULL_FLAG(qspi));
+        QSPI_WRITE_TX(qspi, u32Word ? pu32Buf[i] : pu8Buf[i]);
+    }
+}
+
+/* Read u32Len bytes, a multiple of 4, in word mode with PDMA. Returns the bytes done, less than
+   u32Len if the channels are missing or busy; completion comes from the PDMA interrupt. */
+static uint32_t spinor_rx_pdma(SPINOR_T *psNor, uint32_t *pu32Buf, uint32_t u32Len)
+{
+    QSPI_T *qspi = psNor->qspi;
+    PDMA_SG_T sTx, sRx;
+    uint32_t u32Part, u32Done;
+
+    if ((psNor->i32RxCh < 0) || (psNor->i32TxCh < 0) || !sysGetIBitState())
+        return 0;
+
+    for (u32Done = 0; u32Done < u32Len; u32Done += u32Part)
+    {
+        u32Part = u32Len - u32Done;
+        if (u32Part > SPINOR_PDMA_CHUNK)
+            u32Part = SPINOR_PDMA_CHUNK;
+
+        sRx.u32Src = (uint32_t)&qspi->RX;
+        sRx.u32Dst = (uint32_t)pu32Buf + u32Done;
+        sRx.u32Len = u32Part;
+        sTx.u32Src = (uint32_t)&s_u32Fill;
+        sTx.u32Dst = (uint32_t)&qspi->TX;
+        sTx.u32Len = u32Part;
+        if (PDMA_SubmitSG(psNor->i32RxCh, PDMA_WIDTH_32 | PDMA_SAR_FIX | PDMA_DAR_INC | PDMA_REQ_SINGLE, &sRx, 1) != PDMA_OK)
+            break;
+        if (PDMA_SubmitSG(psNor->i32TxCh, PDMA_WIDTH_32 | PDMA_SAR_FIX | PDMA_DAR_FIX | PDMA_REQ_SINGLE, &sTx, 1) != PDMA_OK)
+        {
+            PDMA_StopChannel(psNor->i32RxCh);
+            break;
+        }
+
+        QSPI_TRIGGER_RX_PDMA(qspi);
+        QSPI_TRIGGER_TX_PDMA(qspi);
+        while (PDMA_IsChannelBusy(psNor->i32RxCh) || PDMA_IsChannelBusy(psNor->i32TxCh));
+        QSPI_DISABLE_TX_PDMA(qspi);
+        QSPI_DISABLE_RX_PDMA(qspi);
+    }
+    return u32Done;
+}
+
+static uint8_t spinor_read_reg(SPINOR_T *psNor, uint8_t u8Op)
+{
+    uint8_t u8Val;
+
+    spinor_start(psNor, u8Op, 0, 0, 0, SPINOR_IO_111);
+    spinor_rx(psNor->qspi, &u8Val, 1, 0);
+    spinor_end(psNor->qspi);
+    return u8Val;
+}
+
+static void spinor_command(SPINOR_T *psNor, uint8_t u8Op)
+{
+    QSPI_SET_SS_LOW(psNor->qspi);
+    spinor_send(psNor->qspi, u8Op, 8);
+    spinor_end(psNor->qspi);
+}
+
+static void spinor_wait(SPINOR_T *psNor)
+{
+    while (spinor_read_reg(psNor, SPINOR_OP_RDSR) & SPINOR_SR_WIP);
+}
+
+static void spinor_write_reg(SPINOR_T *psNor, uint8_t u8Op, const uint8_t *pu8Val, uint32_t u32Len)
+{
+    spinor_command(psNor, SPINOR_OP_WREN);
+    spinor_start(psNor, u8Op, 0, 0, 0, SPINOR_IO_111);
+    spinor_tx(psNor->qspi, pu8Val, u32Len, 0);
+    spinor_end(psNor->qspi);
+    spinor_wait(psNor);
+}
+
+static void spinor_read_sfdp(SPINOR_T *psNor, uint32_t u32Addr, void *pvBuf, uint32_t u32Len)
+{
+    spinor_start(psNor, SPINOR_OP_RDSFDP, u32Addr, 3, 8, SPINOR_IO_111);
+    spinor_rx(psNor->qspi, pvBuf, u32Len, 0);
+    spinor_end(psNor->qspi);
+}
+
+/* Geometry and opcodes from the SFDP tables. Returns 0 if the flash has no usable BFPT. */
+static uint32_t spinor_sfdp(SPINOR_T *psNor, SPINOR_ADDR4_T *psAddr4)
+{
+    uint32_t au32Hdr[2], au32Param[2], au32Bfpt[SFDP_BFPT_DWORDS];
+    uint32_t u32Dwords = 0, u32Num, u32Len, u32Id, u32Val, u32Wait, i;
+
+    spinor_read_sfdp(psNor, 0, au32Hdr, sizeof(au32Hdr));
+    if (au32Hdr[0] != SFDP_SIGNATURE)
+        return 0;
+
+    /* Parameter headers: ID LSB, minor, major, length in DWORDs, 24-bit pointer, ID MSB */
+    u32Num = ((au32Hdr[1] >> 16) & 0xFF) + 1;
+    memset(au32Bfpt, 0, sizeof(au32Bfpt));
+    for (i = 0; i < u32Num; i++)
+    {
+        spinor_read_sfdp(psNor, 8 + i * 8, au32Param, sizeof(au32Param));
+        u32Id = (au32Param[0] & 0xFF) | ((au32Param[1] >> 16) & 0xFF00);
+        u32Len = au32Param[0] >> 24;
+        if ((u32Id == SFDP_BFPT_ID) && (((au32Param[0] >> 16) & 0xFF) == 1) && (u32Len > u32Dwords))
+        {
+            /* Later revisions of the BFPT are longer, keep the longest */
+            u32Dwords = (u32Len > SFDP_BFPT_DWORDS) ? SFDP_BFPT_DWORDS : u32Len;
+            spinor_read_sfdp(psNor, au32Param[1] & 0xFFFFFF, au32Bfpt, u32Dwords * 4);
+        }
+        else if ((u32Id == SFDP_4BAIT_ID) && (u32Len >= 2))
+        {
+            spinor_read_sfdp(psNor, au32Param[1] & 0xFFFFFF, psAddr4->au32Bait, sizeof(psAddr4->au32Bait));
+        }
+    }
+    if (u32Dwords < 9)
+        return 0;
+
+    /* DWORD 2: density in bits */
+    u32Val = au32Bfpt[1];
+    if (u32Val & 0x80000000)
+    {
+        u32Val &= 0x7FFFFFFF;
+        if ((u32Val < 3) || (u32Val > 34))
+            return 0;
+        psNor->u32Size = 1UL << (u32Val - 3);
+    }
+    else
+        psNor->u32Size = (u32Val >> 3) + 1;
+
+    /* DWORDs 8 and 9: up to four erase types, size as a power of two and opcode */
+    for (i = 0; i < SPINOR_ERASE_TYPES; i++)
+    {
+        u32Val = au32Bfpt[7 + i / 2] >> ((i & 1) * 16);
+        psNor->au32EraseSize[i] = ((u32Val & 0xFF) && ((u32Val & 0xFF) < 32)) ? (1UL << (u32Val & 0xFF)) : 0;
+        psNor->au8EraseOp[i] = (uint8_t)(u32Val >> 8);
+    }
+    if (!psNor->au32EraseSize[0] && ((au32Bfpt[0] & 0x3) == 0x1))
+    {
+        /* DWORD 1: uniform 4 KB erase */
+        psNor->au32EraseSize[0] = 0x1000;
+        psNor->au8EraseOp[0] = (uint8_t)(au32Bfpt[0] >> 8);
+    }
+
+    /* DWORDs 1 and 3: prefer 1-4-4 over 1-1-4 reads, if their wait clocks fit whole transfers */
+    u32Wait = (au32Bfpt[2] & 0x1F) + ((au32Bfpt[2] >> 5) & 0x7);
+    if ((au32Bfpt[0] & (1UL << 21)) && ((u32Wait == 0) || ((u32Wait >= 2) && (u32Wait <= 8))))
+    {
+        psNor->u8ReadOp = (uint8_t)(au32Bfpt[2] >> 8);
+        psNor->u8ReadIo = SPINOR_IO_144;
+        psNor->u8ReadWait = (uint8_t)u32Wait;
+    }
+    else
+    {
+        u32Wait = ((au32Bfpt[2] >> 16) & 0x1F) + ((au32Bfpt[2] >> 21) & 0x7);
+        if ((au32Bfpt[0] & (1UL << 22)) && ((u32Wait == 0) || ((u32Wait >= 8) && (u32Wait <= 32))))
+        {
+            psNor->u8ReadOp = (uint8_t)(au32Bfpt[2] >> 24);
+            psNor->u8ReadIo = SPINOR_IO_114;
+            psNor->u8ReadWait = (uint8_t)u32Wait;
+        }
+    }
+    psAddr4->u32AddrMode = (au32Bfpt[0] >> 17) & 0x3;
+
+    /* JESD216A and later: page size, suspend opcodes, quad enable method, 4-byte entry */
+    if ((u32Dwords >= 11) && ((au32Bfpt[10] >> 4) & 0xF))
+        psNor->u32PageSize = 1UL << ((au32Bfpt[10] >> 4) & 0xF);
+    if ((u32Dwords >= 13) && !(au32Bfpt[11] & 0x80000000))
+    {
+        psNor->u8SuspendOp = (uint8_t)(au32Bfpt[12] >> 24);
+        psNor->u8ResumeOp = (uint8_t)(au32Bfpt[12] >> 16);
+    }
+    if (u32Dwords >= 15)
+        psNor->u8Qer = (uint8_t)((au32Bfpt[14] >> 20) & 0x7);
+    if (u32Dwords >= 16)
+        psAddr4->u32Enter4B = au32Bfpt[15] >> 24;
+
+    psNor->u8Sfdp = 1;
+    return 1;
+}
+
+/* Set the quad enable bit the way SFDP says, unless it is set already. Returns 0 on failure. */
+static uint32_t spinor_quad_enable(SPINOR_T *psNor)
+{
+    uint8_t au8Sr[2];
+
+    switch (psNor->u8Qer)
+    {
+    case 2:     /* Bit 6 of status register 1 */
+        au8Sr[0] = spinor_read_reg(psNor, SPINOR_OP_RDSR);
+        if (!(au8Sr[0] & 0x40))
+        {
+            au8Sr[0] |= 0x40;
+            spinor_write_reg(psNor, SPINOR_OP_WRSR, au8Sr, 1);
+        }
+        return spinor_read_reg(psNor, SPINOR_OP_RDSR) & 0x40;
+
+    case 3:     /* Bit 7 of status register 2, with its own read and write opcodes */
+        au8Sr[0] = spinor_read_reg(psNor, SPINOR_OP_RDSR2_B7);
+        if (!(au8Sr[0] & 0x80))
+        {
+            au8Sr[0] |= 0x80;
+            spinor_write_reg(psNor, SPINOR_OP_WRSR2_B7, au8Sr, 1);
+        }
+        return spinor_read_reg(psNor, SPINOR_OP_RDSR2_B7) & 0x80;
+
+    case 6:     /* Bit 1 of status register 2, written alone */
+        au8Sr[0] = spinor_read_reg(psNor, SPINOR_OP_RDSR2);
+        if (!(au8Sr[0] & 0x02))
+        {
+            au8Sr[0] |= 0x02;
+            spinor_write_reg(psNor, SPINOR_OP_WRSR2, au8Sr, 1);
+        }
+        return spinor_read_reg(psNor, SPINOR_OP_RDSR2) & 0x02;
+
+    case 1:
+    case 4:
+    case 5:     /* Bit 1 of status register 2, written together with status register 1 */
+        au8Sr[1] = spinor_read_reg(psNor, SPINOR_OP_RDSR2);
+        if (!(au8Sr[1] & 0x02))
+        {
+            au8Sr[0] = spinor_read_reg(psNor, SPINOR_OP_RDSR);
+            au8Sr[1] |= 0x02;
+            spinor_write_reg(psNor, SPINOR_OP_WRSR, au8Sr, 2);
+        }
+        return spinor_read_reg(psNor, SPINOR_OP_RDSR2) & 0x02;
+
+    default:    /* No quad enable bit */
+        return 1;
+    }
+}
+
+/* Reach beyond 16 MB: 4-byte opcodes if the flash lists them all, else 4-byte address mode.
+   The 4-byte read opcodes replace the standard 0Bh, 6Bh and EBh only. */
+static void spinor_addr4(SPINOR_T *psNor, const SPINOR_ADDR4_T *psAddr4)
+{
+    static const uint8_t au8Bit[3] = { 1, 4, 5 };           /* 4BAIT bits of 0Ch, 6Ch and ECh */
+    static const uint8_t au8Op[3] = { 0x0C, 0x6C, 0xEC };
+    uint32_t u32Need, i;
+
+    if (psNor->u32Size <= SPINOR_16MB)
+        return;
+
+    if (psAddr4->u32AddrMode == 2)
+    {
+        psNor->u8AddrLen = 4;
+        return;
+    }
+
+    u32Need = (1UL << 6) | (1UL << au8Bit[psNor->u8ReadIo]);
+    if ((psAddr4->u32AddrMode == 1) && ((psAddr4->au32Bait[0] & u32Need) == u32Need) &&
+            ((psNor->u8ReadOp & 0x0F) == 0x0B))
+    {
+        psNor->u8ReadOp = au8Op[psNor->u8ReadIo];
+        psNor->u8ProgramOp = SPINOR_OP_PP_4B;
+        for (i = 0; i < SPINOR_ERASE_TYPES; i++)
+        {
+            if (psAddr4->au32Bait[0] & (1UL << (9 + i)))
+                psNor->au8EraseOp[i] = (uint8_t)(psAddr4->au32Bait[1] >> (i * 8));
+            else
+                psNor->au32EraseSize[i] = 0;
+        }
+        psNor->u8AddrLen = 4;
+        return;
+    }
+
+    if (psAddr4->u32Enter4B & 0x3)
+    {
+        if (!(psAddr4->u32Enter4B & 0x1))
+            spinor_command(psNor, SPINOR_OP_WREN);
+        spinor_command(psNor, SPINOR_OP_EN4B);
+        psNor->u8AddrLen = 4;
+        return;
+    }
+
+    /* No known way to send a 4-byte address */
+    psNor->u32Size = SPINOR_16MB;
+}
+
+/* Largest erase that starts at u32Addr and fits in u32Len, -1 if none */
+static int32_t spinor_erase_type(SPINOR_T *psNor, uint32_t u32Addr, uint32_t u32Len)
+{
+    uint32_t u32Size;
+    int32_t i, i32Type = -1;
+
+    for (i = 0; i < SPINOR_ERASE_TYPES; i++)
+    {
+        u32Size = psNor->au32EraseSize[i];
+        if (u32Size && (u32Size <= u32Len) && !(u32Addr & (u32Size - 1)) &&
+                ((i32Type < 0) || (u32Size > psNor->au32EraseSize[i32Type])))
+            i32Type = i;
+    }
+    return i32Type;
+}
+
+static uint32_t spinor_range_ok(SPINOR_T *psNor, uint32_t u32Addr, uint32_t u32Len)
+{
+    return (u32Addr < psNor->u32Size) && (u32Len <= psNor->u32Size - u32Addr);
+}
+
+/* Clear the way for an access to [u32Addr, u32Addr + u32Len) while an erase may be running.
+   Returns 1 if the erase was suspended and must be resumed, 0 if it has finished. */
+static uint32_t spinor_suspend(SPINOR_T *psNor, uint32_t u32Addr, uint32_t u32Len)
+{
+    if (!SPINOR_IsBusy(psNor))
+        return 0;
+
+    if (!psNor->u8SuspendOp ||
+            ((u32Addr < psNor->u32EraseAddr + psNor->u32EraseLen) && (psNor->u32EraseAddr < u32Addr + u32Len)))
+    {
+        /* The block being erased reads undefined until the erase ends */
+        while (SPINOR_IsBusy(psNor));
+        return 0;
+    }
+
+    spinor_command(psNor, psNor->u8SuspendOp);
+    spinor_wait(psNor);
+    return 1;
+}
+
+static void spinor_resume(SPINOR_T *psNor)
+{
+    uint32_t u32Mhz = sysGetClock(SYS_PCLK01) / ((psNor->qspi->CLKDIV & 0x1FF) + 1);
+    uint32_t u32Polls = SPINOR_RESUME_HOLD_US * u32Mhz / 16 + 1;
+
+    spinor_command(psNor, psNor->u8ResumeOp);
+
+    /* An erase suspended again too soon never finishes. Each status read takes 16 clocks. */
+    while (u32Polls--)
+        spinor_read_reg(psNor, SPINOR_OP_RDSR);
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/**
+  * @brief      Open a serial NOR flash on a QSPI port
+  * @param[out] psNor           Flash instance to fill in
+  * @param[in]  qspi            QSPI port, its pins already set, including D2/D3 for quad reads
+  * @param[in]  u32BusClock     QSPI bus clock in Hz
+  * @retval     SPINOR_OK       Flash ready
+  * @retval     SPINOR_ERR_ID   No flash answered
+  * @details    Waits for an erase or program left running, then reads the SFDP tables. Without
+  *             them the size comes from the JEDEC ID and reads use single-line fast read.
+  *             The quad enable bit is written only if it is not already set, so the status
+  *             register is not worn by every open. On QSPI0 two PDMA channels are requested
+  *             for long reads.
+  */
+int32_t SPINOR_Open(SPINOR_T *psNor, QSPI_T *qspi, uint32_t u32BusClock)
+{
+    SPINOR_ADDR4_T sAddr4;
+    uint32_t i;
+
+    memset(psNor, 0, sizeof(SPINOR_T));
+    memset(&sAddr4, 0, sizeof(sAddr4));
+    psNor->qspi = qspi;
+    psNor->i32TxCh = psNor->i32RxCh = -1;
+
+    QSPI_Open(qspi, QSPI_MASTER, QSPI_MODE_0, 8, u32BusClock);
+    QSPI_DisableAutoSS(qspi);
+    QSPI_SET_SS_HIGH(qspi);
+
+    /* A floating bus reads all ones */
+    if (spinor_read_reg(psNor, SPINOR_OP_RDSR) == 0xFF)
+        return SPINOR_ERR_ID;
+    spinor_wait(psNor);
+
+    spinor_start(psNor, SPINOR_OP_RDID, 0, 0, 0, SPINOR_IO_111);
+    spinor_rx(qspi, psNor->au8Id, 3, 0);
+    spinor_end(qspi);
+    if ((psNor->au8Id[0] == 0x00) || (psNor->au8Id[0] == 0xFF))
+        return SPINOR_ERR_ID;
+
+    psNor->u32PageSize = 256;
+    psNor->u8ReadOp = SPINOR_OP_FAST_READ;
+    psNor->u8ReadIo = SPINOR_IO_111;
+    psNor->u8ReadWait = 8;
+    psNor->u8ProgramOp = SPINOR_OP_PP;
+    psNor->u8AddrLen = 3;
+    sAddr4.u32Enter4B = 0x1;
+
+    if (!spinor_sfdp(psNor, &sAddr4))
+    {
+        /* Most vendors code the size as a power of two in the last ID byte */
+        psNor->u32Size = ((psNor->au8Id[2] >= 0x10) && (psNor->au8Id[2] < 0x20)) ? (1UL << psNor->au8Id[2]) : SPINOR_16MB;
+        psNor->au32EraseSize[0] = 0x1000;
+        psNor->au8EraseOp[0] = 0x20;
+        psNor->au32EraseSize[1] = 0x10000;
+        psNor->au8EraseOp[1] = 0xD8;
+    }
+
+    if ((psNor->u8ReadIo != SPINOR_IO_111) && !spinor_quad_enable(psNor))
+    {
+        psNor->u8ReadOp = SPINOR_OP_FAST_READ;
+        psNor->u8ReadIo = SPINOR_IO_111;
+        psNor->u8ReadWait = 8;
+    }
+    spinor_addr4(psNor, &sAddr4);
+
+    for (i = 0; i < SPINOR_ERASE_TYPES; i++)
+    {
+        if (psNor->au32EraseSize[i] && (!psNor->u32EraseSize || (psNor->au32EraseSize[i] < psNor->u32EraseSize)))
+            psNor->u32EraseSize = psNor->au32EraseSize[i];
+    }
+
+    if (qspi == QSPI0)
+    {
+        psNor->i32RxCh = PDMA_RequestChannel(PDMA_QSPI0_RX, NULL, NULL);
+        psNor->i32TxCh = PDMA_RequestChannel(PDMA_QSPI0_TX, NULL, NULL);
+        if ((psNor->i32RxCh < 0) || (psNor->i32TxCh < 0))
+            SPINOR_Close(psNor);
+    }
+    psNor->u32PdmaMin = SPINOR_PDMA_MIN;
+
+    return SPINOR_OK;
+}
+
+/**
+  * @brief      Release the PDMA channels of a flash
+  * @param[in]  psNor   Flash instance
+  * @return     None
+  * @details    An erase started by SPINOR_EraseStart() is waited for.
+  */
+void SPINOR_Close(SPINOR_T *psNor)
+{
+    while (SPINOR_IsBusy(psNor));
+    if (psNor->i32RxCh >= 0)
+        PDMA_FreeChannel(psNor->i32RxCh);
+    if (psNor->i32TxCh >= 0)
+        PDMA_FreeChannel(psNor->i32TxCh);
+    psNor->i32RxCh = psNor->i32TxCh = -1;
+}
+
+/**
+  * @brief      Read from the flash
+  * @param[in]  psNor   Flash instance
+  * @param[in]  u32Addr Flash address
+  * @param[out] pu8Buf  Destination, any alignment
+  * @param[in]  u32Len  Bytes to read
+  * @retval     SPINOR_OK       Done
+  * @retval     SPINOR_ERR_ARG  Range outside the flash
+  * @details    The bytes up to a word boundary of pu8Buf and the last odd bytes move one by one,
+  *             the rest in 32-bit transfers. At least SPINOR_T::u32PdmaMin of them go by PDMA,
+  *             which needs IRQ enabled; other code must not write the cache lines of pu8Buf
+  *             until the read returns. An erase elsewhere in the flash is suspended meanwhile.
+  */
+int32_t SPINOR_Read(SPINOR_T *psNor, uint32_t u32Addr, uint8_t *pu8Buf, uint32_t u32Len)
+{
+    QSPI_T *qspi = psNor->qspi;
+    uint32_t u32Suspended, u32Head, u32Body, u32Done;
+
+    if (u32Len == 0)
+        return SPINOR_OK;
+    if (!spinor_range_ok(psNor, u32Addr, u32Len))
+        return SPINOR_ERR_ARG;
+    u32Suspended = spinor_suspend(psNor, u32Addr, u32Len);
+
+    spinor_start(psNor, psNor->u8ReadOp, u32Addr, psNor->u8AddrLen, psNor->u8ReadWait, psNor->u8ReadIo);
+
+    u32Head = (4 - ((uint32_t)pu8Buf & 3)) & 3;
+    if (u32Head > u32Len)
+        u32Head = u32Len;
+    spinor_rx(qspi, pu8Buf, u32Head, 0);
+
+    u32Body = (u32Len - u32Head) & ~3UL;
+    if (u32Body)
+    {
+        spinor_word_mode(qspi, 1);
+        u32Done = (u32Body >= psNor->u32PdmaMin) ? spinor_rx_pdma(psNor, (uint32_t *)(pu8Buf + u32Head), u32Body) : 0;
+        spinor_rx(qspi, pu8Buf + u32Head + u32Done, (u32Body - u32Done) / 4, 1);
+        spinor_word_mode(qspi, 0);
+    }
+    spinor_rx(qspi, pu8Buf + u32Head + u32Body, u32Len - u32Head - u32Body, 0);
+
+    spinor_end(qspi);
+    if (u32Suspended)
+        spinor_resume(psNor);
+    return SPINOR_OK;
+}
+
+/**
+  * @brief      Program erased flash
+  * @param[in]  psNor   Flash instance
+  * @param[in]  u32Addr Flash address
+  * @param[in]  pu8Buf  Data, any alignment
+  * @param[in]  u32Len  Bytes to program, any length; pages are split as needed
+  * @retval     SPINOR_OK       Done
+  * @retval     SPINOR_ERR_ARG  Range outside the flash
+  * @details    An erase elsewhere in the flash is suspended until the last page is written.
+  */
+int32_t SPINOR_Program(SPINOR_T *psNor, uint32_t u32Addr, const uint8_t *pu8Buf, uint32_t u32Len)
+{
+    QSPI_T *qspi = psNor->qspi;
+    uint32_t u32Suspended, u32Part, u32Head, u32Body;
+
+    if (u32Len == 0)
+        return SPINOR_OK;
+    if (!spinor_range_ok(psNor, u32Addr, u32Len))
+        return SPINOR_ERR_ARG;
+    u32Suspended = spinor_suspend(psNor, u32Addr, u32Len);
+
+    for (; u32Len; u32Len -= u32Part)
+    {
+        u32Part = psNor->u32PageSize - (u32Addr & (psNor->u32PageSize - 1));
+        if (u32Part > u32Len)
+            u32Part = u32Len;
+
+        spinor_command(psNor, SPINOR_OP_WREN);
+        spinor_start(psNor, psNor->u8ProgramOp, u32Addr, psNor->u8AddrLen, 0, SPINOR_IO_111);
+
+        u32Head = (4 - ((uint32_t)pu8Buf & 3)) & 3;
+        if (u32Head > u32Part)
+            u32Head = u32Part;
+        spinor_tx(qspi, pu8Buf, u32Head, 0);
+        u32Body = (u32Part - u32Head) & ~3UL;
+        if (u32Body)
+        {
+            spinor_word_mode(qspi, 1);
+            spinor_tx(qspi, pu8Buf + u32Head, u32Body / 4, 1);
+            spinor_word_mode(qspi, 0);
+        }
+        spinor_tx(qspi, pu8Buf + u32Head + u32Body, u32Part - u32Head - u32Body, 0);
+
+        spinor_end(qspi);
+        spinor_wait(psNor);
+        u32Addr += u32Part;
+        pu8Buf += u32Part;
+    }
+
+    if (u32Suspended)
+        spinor_resume(psNor);
+    return SPINOR_OK;
+}
+
+/**
+  * @brief      Start one erase and return without waiting for it
+  * @param[in]  psNor   Flash instance
+  * @param[in]  u32Addr Block address, aligned to u32Len
+  * @param[in]  u32Len  One of SPINOR_T::au32EraseSize
+  * @retval     SPINOR_OK       Erase running, see SPINOR_IsBusy()
+  * @retval     SPINOR_ERR_ARG  No erase of that size and alignment
+  * @details    A previous erase is waited for first. SPINOR_Read() and SPINOR_Program() outside
+  *             the block suspend the erase if the flash supports it, inside it they wait.
+  */
+int32_t SPINOR_EraseStart(SPINOR_T *psNor, uint32_t u32Addr, uint32_t u32Len)
+{
+    int32_t i32Type;
+
+    if (!spinor_range_ok(psNor, u32Addr, u32Len))
+        return SPINOR_ERR_ARG;
+    i32Type = spinor_erase_type(psNor, u32Addr, u32Len);
+    if ((i32Type < 0) || (psNor->au32EraseSize[i32Type] != u32Len))
+        return SPINOR_ERR_ARG;
+
+    while (SPINOR_IsBusy(psNor));
+    spinor_command(psNor, SPINOR_OP_WREN);
+    spinor_start(psNor, psNor->au8EraseOp[i32Type], u32Addr, psNor->u8AddrLen, 0, SPINOR_IO_111);
+    spinor_end(psNor->qspi);
+
+    psNor->u32EraseAddr = u32Addr;
+    psNor->u32EraseLen = u32Len;
+    return SPINOR_OK;
+}
+
+/**
+  * @brief      Erase a range and wait for it
+  * @param[in]  psNor   Flash instance
+  * @param[in]  u32Addr Start address, aligned to SPINOR_T::u32EraseSize
+  * @param[in]  u32Len  Bytes to erase, a multiple of SPINOR_T::u32EraseSize
+  * @retval     SPINOR_OK       Done
+  * @retval     SPINOR_ERR_ARG  Range outside the flash or not aligned
+  * @details    Each step uses the largest erase size that fits the rest of the range.
+  */
+int32_t SPINOR_Erase(SPINOR_T *psNor, uint32_t u32Addr, uint32_t u32Len)
+{
+    int32_t i32Type;
+
+    if (!psNor->u32EraseSize || ((u32Addr | u32Len) & (psNor->u32EraseSize - 1)) ||
+            (u32Len && !spinor_range_ok(psNor, u32Addr, u32Len)))
+        return SPINOR_ERR_ARG;
+
+    while (u32Len)
+    {
+        i32Type = spinor_erase_type(psNor, u32Addr, u32Len);
+        SPINOR_EraseStart(psNor, u32Addr, psNor->au32EraseSize[i32Type]);
+        while (SPINOR_IsBusy(psNor));
+        u32Addr += psNor->au32EraseSize[i32Type];
+        u32Len -= psNor->au32EraseSize[i32Type];
+    }
+    return SPINOR_OK;
+}
+
+/**
+  * @brief      Check the erase started by SPINOR_EraseStart()
+  * @param[in]  psNor   Flash instance
+  * @retval     0       No erase running
+  * @retval     1       Erase still running
+  */
+uint32_t SPINOR_IsBusy(SPINOR_T *psNor)
+{
+    if (psNor->u32EraseLen && !(spinor_read_reg(psNor, SPINOR_OP_RDSR) & SPINOR_SR_WIP))
+        psNor->u32EraseLen = 0;
+    return psNor->u32EraseLen ? 1 : 0;
+}
+
+/**
+  * @brief      Read status register 1
+  * @param[in]  psNor   Flash instance
+  * @return     Status register 1, bit 0 is set while the flash is busy
+  */
+uint32_t SPINOR_ReadStatus(SPINOR_T *psNor)
+{
+    return spinor_read_reg(psNor, SPINOR_OP_RDSR);
+}
+
+/*@}*/ /* end of group SPINOR_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group SPINOR_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
@@ -6,6 +6,7 @@
  * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
  *****************************************************************************/
 #include <stdio.h>
+#include <string.h>
 #include "nuc980.h"
 #include "sys.h"
 
@@ -36,7 +37,7 @@ void SYS_FIQ_Shell(void);
 
 /* Interrupt Handler Table */
 //typedef void (*sys_pvFunPtr)();   /* function pointer */
-sys_pvFunPtr sysIrqHandlerTable[] = { 0,           /* 0 */
+SYS_FASTDATA sys_pvFunPtr sysIrqHandlerTable[] = { 0,           /* 0 */
                                       SYS_IRQ_Shell,   /* 1 */
                                       SYS_IRQ_Shell,   /* 2 */
                                       SYS_IRQ_Shell,   /* 3 */
@@ -102,7 +103,7 @@ sys_pvFunPtr sysIrqHandlerTable[] = { 0,           /* 0 */
                                       SYS_IRQ_Shell    /* 63 */
                                     };
 
-sys_pvFunPtr sysFiqHandlerTable[] = { 0,
+SYS_FASTDATA sys_pvFunPtr sysFiqHandlerTable[] = { 0,
                                       SYS_FIQ_Shell,   /* 1 */
                                       SYS_FIQ_Shell,   /* 2 */
                                       SYS_FIQ_Shell,   /* 3 */
@@ -168,11 +169,20 @@ sys_pvFunPtr sysFiqHandlerTable[] = { 0,
                                       SYS_FIQ_Shell    /* 63 */
                                     };
 
+/* Handler addresses loaded by the IRQ and FIQ entries of the vector table */
+#if defined (__GNUC__) && !(__CC_ARM)
+#define SYS_IRQ_VECTOR          0x34
+#define SYS_FIQ_VECTOR          0x38
+#else
+#define SYS_IRQ_VECTOR          0x38
+#define SYS_FIQ_VECTOR          0x3C
+#endif
+
 /* Interrupt Handler */
 #if defined (__GNUC__) && !(__CC_ARM)
-static void __attribute__ ((interrupt("IRQ"))) sysIrqHandler(void)
+static void SYS_FASTCODE __attribute__ ((interrupt("IRQ"))) sysIrqHandler(void)
 #else
-__irq void sysIrqHandler()
+SYS_FASTCODE __irq void sysIrqHandler()
 #endif
 {
     UINT32 volatile num;
@@ -184,19 +194,110 @@ __irq void sysIrqHandler()
 }
 
 #if defined (__GNUC__) && !(__CC_ARM)
-static void __attribute__ ((interrupt("FIQ"))) sysFiqHandler(void)
+static void SYS_FASTCODE __attribute__ ((interrupt("FIQ"))) sysFiqHandler(void)
 #else
-__irq void sysFiqHandler()
+SYS_FASTCODE __irq void sysFiqHandler()
 #endif
 {
     UINT32 volatile num;
 
     num = inpw(REG_AIC_FIQNUM);
     if (num != 0)
-        (*sysIrqHandlerTable[num])();
+        (*sysFiqHandlerTable[num])();
     outpw(REG_AIC_EOFS, 1);
 }
 
+/*
+ * Nested IRQ dispatch. Reading REG_AIC_IRQNUM raises the AIC priority to the
+ * level of the source, so only sources of a higher level (lower number) are
+ * signalled until REG_AIC_EOIS is written. The entry below saves the return
+ * state on the IRQ stack, runs the ISR in SYS mode with IRQ enabled and
+ * writes REG_AIC_EOIS back in IRQ mode. sysIrqEnter() and sysIrqLeave() run
+ * with IRQ disabled and keep the statistics.
+ */
+#include "sys_irqnest.h"
+
+static BOOL volatile _sys_bNestedIrq = FALSE;
+
+#if defined (__GNUC__) && !(__CC_ARM)
+#define _SYS_STR(x)     #x
+#define _SYS_XSTR(x)    _SYS_STR(x)
+
+static void SYS_FASTCODE __attribute__ ((naked)) sysNestedIrqHandler(void)
+{
+    asm volatile
+    (
+        "sub    lr, lr, #4                  \n"
+        "stmfd  sp!, {r0-r3, r12, lr}       \n"
+        "mrs    r0, spsr                    \n"
+        "stmfd  sp!, {r0, r1}               \n"     /* SPSR, and r1 keeps the IRQ stack 8-byte aligned */
+        "ldr    r1, =" _SYS_XSTR(REG_AIC_IRQNUM) "\n"
+        "ldr    r0, [r1]                    \n"
+        "bl     sysIrqEnter                 \n"
+        "mrs    r1, cpsr                    \n"     /* SYS mode, IRQ enabled */
+        "orr    r1, r1, #0x1F               \n"
+        "bic    r1, r1, #0x80               \n"
+        "msr    cpsr_c, r1                  \n"
+        "and    r1, sp, #4                  \n"
+        "sub    sp, sp, r1                  \n"
+        "stmfd  sp!, {r1, lr}               \n"
+        "cmp    r0, #0                      \n"
+        "blxne  r0                          \n"
+        "ldmfd  sp!, {r1, lr}               \n"
+        "add    sp, sp, r1                  \n"
+        "mrs    r1, cpsr                    \n"     /* IRQ mode, IRQ disabled */
+        "bic    r1, r1, #0x1F               \n"
+        "orr    r1, r1, #0x92               \n"
+        "msr    cpsr_c, r1                  \n"
+        "bl     sysIrqLeave                 \n"
+        "ldr    r1, =" _SYS_XSTR(REG_AIC_EOIS) "\n"
+        "mov    r0, #1                      \n"
+        "str    r0, [r1]                    \n"
+        "ldmfd  sp!, {r0, r1}               \n"
+        "msr    spsr_cxsf, r0               \n"
+        "ldmfd  sp!, {r0-r3, r12, pc}^      \n"
+        ".ltorg                             \n"
+    );
+}
+#else
+#pragma arm section code = ".fastcode"
+__asm void sysNestedIrqHandler(void)
+{
+    PRESERVE8
+
+    SUB     lr, lr, #4
+    STMFD   sp!, {r0-r3, r12, lr}
+    MRS     r0, SPSR
+    STMFD   sp!, {r0, r1}               ; SPSR, and r1 keeps the IRQ stack 8-byte aligned
+    LDR     r1, =REG_AIC_IRQNUM
+    LDR     r0, [r1]
+    BL      __cpp(sysIrqEnter)
+    MRS     r1, CPSR                    ; SYS mode, IRQ enabled
+    ORR     r1, r1, #0x1F
+    BIC     r1, r1, #0x80
+    MSR     CPSR_c, r1
+    AND     r1, sp, #4
+    SUB     sp, sp, r1
+    STMFD   sp!, {r1, lr}
+    CMP     r0, #0
+    BLXNE   r0
+    LDMFD   sp!, {r1, lr}
+    ADD     sp, sp, r1
+    MRS     r1, CPSR                    ; IRQ mode, IRQ disabled
+    BIC     r1, r1, #0x1F
+    ORR     r1, r1, #0x92
+    MSR     CPSR_c, r1
+    BL      __cpp(sysIrqLeave)
+    LDR     r1, =REG_AIC_EOIS
+    MOV     r0, #1
+    STR     r0, [r1]
+    LDMFD   sp!, {r0, r1}
+    MSR     SPSR_cxsf, r0
+    LDMFD   sp!, {r0-r3, r12, pc}^
+}
+#pragma arm section code
+#endif
+
 void SYS_IRQ_Shell(void)
 {
     printf("ISR not found! ISNR=%d\n", inpw(REG_AIC_IRQNUM));
@@ -209,15 +310,12 @@ void SYS_FIQ_Shell(void)
 
 void sysInitializeAIC()
 {
-#if defined (__GNUC__) && !(__CC_ARM)
-    *(unsigned int volatile *)0x34 = (unsigned int volatile)sysIrqHandler;
-
-    *(unsigned int volatile *)0x38 = (unsigned int volatile)sysFiqHandler;
-#else
-    *(unsigned int volatile *)0x38 = (unsigned int)sysIrqHandler;
+    if (_sys_bNestedIrq)
+        *(unsigned int volatile *)SYS_IRQ_VECTOR = (unsigned int)sysNestedIrqHandler;
+    else
+        *(unsigned int volatile *)SYS_IRQ_VECTOR = (unsigned int)sysIrqHandler;
 
-    *(unsigned int volatile *)0x3C = (unsigned int)sysFiqHandler;
-#endif
+    *(unsigned int volatile *)SYS_FIQ_VECTOR = (unsigned int)sysFiqHandler;
 }
 /// @endcond HIDDEN_SYMBOLS
 
@@ -386,6 +484,103 @@ PVOID sysInstallISR(INT32 nIntTypeLevel, IRQn_Type eIntNo, PVOID pvNewISR)
 }
 
 
+/**
+ *  @brief  system AIC - install a level 0 source on the FIQ vector
+ *
+ *  @param[in]  eIntNo  Interrupt number. \ref IRQn_Type
+ *  @param[in]  pvFiqHandler  FIQ handler entered straight from the vector, NULL restores the FIQ dispatcher
+ *
+ *  @return   old handler of the FIQ vector
+ *
+ *  @details  The source is set to \ref FIQ_LEVEL_0 and its handler replaces the FIQ dispatcher,
+ *            so it runs without the table lookup. The handler must be an FIQ handler
+ *            (__irq or __attribute__((interrupt("FIQ")))) that reads REG_AIC_FIQNUM on entry and
+ *            writes REG_AIC_EOFS before it returns. Other level 0 sources are not dispatched
+ *            while it is installed.
+ */
+PVOID sysInstallFastISR(IRQn_Type eIntNo, PVOID pvFiqHandler)
+{
+    PVOID   _mOldVect;
+
+    if ((eIntNo > SYS_MAX_INT_SOURCE) || (eIntNo < SYS_MIN_INT_SOURCE))
+        return NULL;
+
+    if (!_sys_bIsAICInitial)
+    {
+        sysInitializeAIC();
+        _sys_bIsAICInitial = TRUE;
+    }
+
+    sysSetInterruptPriorityLevel(eIntNo, FIQ_LEVEL_0);
+    if (pvFiqHandler == NULL)
+        pvFiqHandler = (PVOID)sysFiqHandler;
+    _mOldVect = *(PVOID volatile *)SYS_FIQ_VECTOR;
+    *(PVOID volatile *)SYS_FIQ_VECTOR = pvFiqHandler;
+    return _mOldVect;
+}
+
+
+/**
+ *  @brief  system AIC - select the nested IRQ dispatcher
+ *
+ *  @param[in]  bEnable  TRUE: ISRs run in SYS mode with IRQ enabled and are preempted by sources
+ *                       of a higher level. FALSE: ISRs run in IRQ mode with IRQ disabled (default).
+ *
+ *  @return   None
+ *
+ *  @details  Nested ISRs run on the stack of SYS mode, which must hold the deepest nesting.
+ *            The nested dispatcher also collects the statistics returned by sysGetIrqStat().
+ */
+void sysEnableNestedIrq(BOOL bEnable)
+{
+    _sys_bNestedIrq = bEnable;
+    if (!_sys_bIsAICInitial)
+    {
+        sysInitializeAIC();
+        _sys_bIsAICInitial = TRUE;
+    }
+    else if (bEnable)
+        *(unsigned int volatile *)SYS_IRQ_VECTOR = (unsigned int)sysNestedIrqHandler;
+    else
+        *(unsigned int volatile *)SYS_IRQ_VECTOR = (unsigned int)sysIrqHandler;
+}
+
+
+/**
+ *  @brief  system AIC - set the clock that times nested ISRs
+ *
+ *  @param[in]  pfnClock  Returns a free running count, NULL stops timing
+ *  @param[in]  u32Mask  Valid bits of the count, e.g. 0xFFFFFF for an ETIMER counter
+ *
+ *  @return   None
+ */
+void sysSetIrqStatClock(UINT32 (*pfnClock)(void), UINT32 u32Mask)
+{
+    _sys_u32IrqClockMask = u32Mask;
+    _sys_pfnIrqClock = pfnClock;
+}
+
+
+/**
+ *  @brief  system AIC - get statistics of the nested IRQ dispatcher
+ *
+ *  @param[out]  pStat  Statistics
+ *  @param[in]  bReset  TRUE clears the statistics after reading them
+ *
+ *  @return   None
+ */
+void sysGetIrqStat(SYS_IRQ_STAT_T *pStat, BOOL bReset)
+{
+    UINT32 u32IBit = sysGetIBitState();
+
+    sysSetLocalInterrupt(DISABLE_IRQ);
+    memcpy(pStat, &_sys_irqStat, sizeof(SYS_IRQ_STAT_T));
+    if (bReset)
+        memset(&_sys_irqStat, 0, sizeof(SYS_IRQ_STAT_T));
+    if (u32IBit)
+        sysSetLocalInterrupt(ENABLE_IRQ);
+}
+
 INT32 sysSetGlobalInterrupt(INT32 nIntState)
 {
     switch (nIntState)
@@ -443,11 +638,7 @@ INT32 sysSetInterruptPriorityLevel(IRQn_Type eIntNo, UINT32 uIntLevel)
  */
 INT32 sysSetLocalInterrupt(INT32 nIntState)
 {
-#if defined (__GNUC__) && !(__CC_ARM)
-
-# else
     INT32 temp;
-#endif
 
     switch (nIntState)
     {
@@ -455,11 +646,12 @@ INT32 sysSetLocalInterrupt(INT32 nIntState)
     case ENABLE_FIQ:
     case ENABLE_FIQ_IRQ:
 #if defined (__GNUC__) && !(__CC_ARM)
-    asm
+    asm volatile
         (
-            "mrs    r0, CPSR  \n"
-            "bic    r0, r0, #0x80  \n"
-            "msr    CPSR_c, r0  \n"
+            "mrs    %0, CPSR  \n"
+            "and    %0, %0, %1  \n"
+            "msr    CPSR_c, %0  \n"
+            :"=&r" (temp) : "r" (nIntState) : "memory"
         );
 #else
         __asm
@@ -475,11 +667,12 @@ INT32 sysSetLocalInterrupt(INT32 nIntState)
     case DISABLE_FIQ:
     case DISABLE_FIQ_IRQ:
 #if defined ( __GNUC__ ) && !(__CC_ARM)
-    asm
+    asm volatile
         (
-            "MRS    r0, CPSR  \n"
-            "ORR    r0, r0, #0x80  \n"
-            "MSR    CPSR_c, r0  \n"
+            "MRS    %0, CPSR  \n"
+            "ORR    %0, %0, %1  \n"
+            "MSR    CPSR_c, %0  \n"
+            :"=&r" (temp) : "r" (nIntState) : "memory"
         );
 #else
         __asm
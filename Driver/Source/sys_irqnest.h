@@ -0,0 +1,88 @@
+/**************************************************************************//**
+ * @file     sys_irqnest.h
+ * @brief    Bookkeeping of the nested IRQ dispatcher, included by sys.c
+ *
+ * Plain C without CPU mode switches, so that Test/Host/irqnest_test runs it
+ * against a model of the AIC.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+
+typedef struct
+{
+    UINT32  num;
+    UINT32  level;
+    UINT32  start;
+    UINT32  child;      /* Ticks spent in ISRs nested in this one */
+} SYS_IRQ_FRAME_T;
+
+static UINT32 (*_sys_pfnIrqClock)(void) = 0;
+static SYS_FASTDATA UINT32 _sys_u32IrqClockMask;
+static SYS_FASTDATA UINT32 _sys_u32IrqDepth;
+static SYS_FASTDATA UINT32 _sys_u32IrqLevelMask;    /* Bit n: an ISR of level n is running */
+static SYS_FASTDATA UINT8 _sys_au8IrqLevelActive[8];
+static SYS_FASTDATA SYS_IRQ_FRAME_T _sys_irqFrame[SYS_IRQ_NEST_MAX];
+static SYS_IRQ_STAT_T _sys_irqStat;
+
+sys_pvFunPtr sysIrqEnter(UINT32 num);
+void sysIrqLeave(void);
+
+SYS_FASTCODE sys_pvFunPtr sysIrqEnter(UINT32 num)
+{
+    SYS_IRQ_FRAME_T *f;
+    UINT32 depth, level, mask;
+
+    depth = ++_sys_u32IrqDepth;
+    if (depth > _sys_irqStat.u32MaxDepth)
+        _sys_irqStat.u32MaxDepth = depth;
+    if (depth > SYS_IRQ_NEST_MAX)
+        return (num != 0) ? sysIrqHandlerTable[num] : 0;
+
+    f = &_sys_irqFrame[depth - 1];
+    f->num = num;
+    f->child = 0;
+    if (num == 0)
+    {
+        _sys_irqStat.u32Spurious++;
+        return 0;
+    }
+
+    level = (inpw(REG_AIC_SRCCTL0 + ((num / 4) * 4)) >> ((num % 4) * 8)) & 0x7;
+    f->level = level;
+    if (_sys_u32IrqLevelMask & ((2 << level) - 1))
+        _sys_irqStat.u32Inversion++;
+    _sys_au8IrqLevelActive[level]++;
+    _sys_u32IrqLevelMask |= (1 << level);
+    for (mask = _sys_u32IrqLevelMask, level = 0; mask; mask >>= 1, level++)
+    {
+        if ((mask & 1) && (depth > _sys_irqStat.u32LevelMaxDepth[level]))
+            _sys_irqStat.u32LevelMaxDepth[level] = depth;
+    }
+    _sys_irqStat.u32Count[num]++;
+    if (_sys_pfnIrqClock)
+        f->start = _sys_pfnIrqClock();
+    return sysIrqHandlerTable[num];
+}
+
+SYS_FASTCODE void sysIrqLeave(void)
+{
+    SYS_IRQ_FRAME_T *f;
+    UINT32 depth, ticks;
+
+    depth = _sys_u32IrqDepth--;
+    if ((depth > SYS_IRQ_NEST_MAX) || (_sys_irqFrame[depth - 1].num == 0))
+        return;
+
+    f = &_sys_irqFrame[depth - 1];
+    if (--_sys_au8IrqLevelActive[f->level] == 0)
+        _sys_u32IrqLevelMask &= ~(1 << f->level);
+    if (_sys_pfnIrqClock)
+    {
+        ticks = (_sys_pfnIrqClock() - f->start) & _sys_u32IrqClockMask;
+        if (ticks - f->child > _sys_irqStat.u32MaxTime[f->num])
+            _sys_irqStat.u32MaxTime[f->num] = ticks - f->child;
+        if (depth > 1)
+            _sys_irqFrame[depth - 2].child += ticks;
+    }
+}
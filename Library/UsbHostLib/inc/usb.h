@@ -310,6 +310,9 @@ typedef struct utr_t
     void        *context;             /*!< point to deivce proprietary data area \hideinitializer */
     FUNC_UTR_T  func;                 /*!< tansfer done call-back function       \hideinitializer */
     struct utr_t  *next;              /* point to the next UTR of the same endpoint. \hideinitializer */
+#ifdef SYS_PROF_ENABLE
+    uint32_t    prof_start;           /*!< submit time of control/bulk transfers \hideinitializer */
+#endif
 } UTR_T;
 
 
@@ -24,6 +24,9 @@ static QH_T   *_H_qh;                       /* head of reclamation list
 static qTD_T  *_ghost_qtd;                  /* used as a terminator qTD                   */
 static QH_T *qh_remove_list;
 
+/* Control and bulk transfers, submit to completion call-back */
+SYS_PROF_DEFINE(s_sProfXfer, "ehci xfer")
+
 extern ISO_EP_T  *iso_ep_list;              /* list of activated isochronous pipes        */
 extern int ehci_iso_xfer(UTR_T *utr);       /* EHCI isochronous transfer function         */
 extern int ehci_quit_iso_xfer(UTR_T *utr, EP_INFO_T *ep);
@@ -959,6 +962,7 @@ static void scan_asynchronous_list()
             else
                 utr->ep->bToggle = 0;
 
+            SYS_PROF_SINCE(s_sProfXfer, utr->prof_start);
             utr->bIsTransferDone = 1;
             if (utr->func)
                 utr->func(utr);
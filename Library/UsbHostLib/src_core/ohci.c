@@ -37,6 +37,9 @@ ED_T  * _Ied[6];
 
 static ED_T  *ed_remove_list;
 
+/* Control and bulk transfers, submit to completion call-back */
+SYS_PROF_DEFINE(s_sProfXfer, "ohci xfer")
+
 static void add_to_ED_remove_list(ED_T *ed)
 {
     ED_T  *p;
@@ -1026,6 +1029,8 @@ td_out:
     /* If all TDs are done, call-back to requester. */
     if (utr->td_cnt == 0)
     {
+        if (((info & TD_TYPE_Msk) == TD_TYPE_CTRL) || ((info & TD_TYPE_Msk) == TD_TYPE_BULK))
+            SYS_PROF_SINCE(s_sProfXfer, utr->prof_start);
         utr->bIsTransferDone = 1;
         if (utr->func)
             utr->func(utr);
@@ -283,6 +283,7 @@ int usbh_ctrl_xfer(UDEV_T *udev, uint8_t bmRequestType, uint8_t bRequest, uint16
     utr->buff = buff;
     utr->data_len = wLength;
     utr->bIsTransferDone = 0;
+    SYS_PROF_STAMP(utr->prof_start);
     status = udev->hc_driver->ctrl_xfer(utr);
     if (status < 0)
     {
@@ -325,6 +326,7 @@ int usbh_ctrl_xfer(UDEV_T *udev, uint8_t bmRequestType, uint8_t bRequest, uint16
   */
 int usbh_bulk_xfer(UTR_T *utr)
 {
+    SYS_PROF_STAMP(utr->prof_start);
     return utr->udev->hc_driver->bulk_xfer(utr);
 }
 
@@ -0,0 +1,223 @@
+/**************************************************************************//**
+* @file     main.c
+* @brief    Continuous multi-channel ADC acquisition with adcscan.c: the
+*           conversion rate of a free-running scan of four channels and the
+*           CPU it costs, the highest timer-triggered scan rate sustained
+*           without missed scans or ring overruns, and the noise of Vref
+*           sampled raw and through a CIC decimation filter.
+*           Channels 0 ~ 2 may be left open.
+*
+* @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+#include "adc.h"
+
+#define RING_SAMPLES    1024
+#define SCAN_CHANNELS   4
+#define ENGINE_KHZ      4000        /* Fastest ADC engine clock */
+#define TRIGGER_TIMER   1           /* ETIMER0 is the free-running clock */
+#define TICKS_PER_SEC   12000000    /* ETIMER0 counts the 12 MHz crystal */
+
+static const int ai32Input[SCAN_CHANNELS] = { 0, 1, 2, 8 };
+
+static uint16_t au16Ring[SCAN_CHANNELS][RING_SAMPLES];
+static uint16_t au16Read[RING_SAMPLES];
+static ADC_SCAN_CH_T asCh[SCAN_CHANNELS];
+static ADC_SCAN_T sScan;
+
+static uint32_t clock_12m(void)
+{
+    return ETIMER_GetCounter(0);
+}
+
+static void scan_four(void)
+{
+    uint32_t i;
+
+    adcScanInit(&sScan);
+    for (i = 0; i < SCAN_CHANNELS; i++)
+        adcScanAddChannel(&sScan, &asCh[i], ai32Input[i], au16Ring[i], RING_SAMPLES);
+    adcScanSetClock(&sScan, clock_12m, 0xFFFFFF);
+}
+
+/* Read the rings for u32Ticks of ETIMER0, returning the loop passes made */
+static uint32_t drain(uint32_t u32Ticks)
+{
+    uint32_t t0 = ETIMER_GetCounter(0), t, u32Elapsed = 0, u32Loops = 0, i;
+
+    while (u32Elapsed < u32Ticks)
+    {
+        for (i = 0; i < sScan.u32Slots; i++)
+            adcScanRead(sScan.apsCh[i], au16Read, RING_SAMPLES);
+        t = ETIMER_GetCounter(0);
+        u32Elapsed += (t - t0) & 0xFFFFFF;
+        t0 = t;
+        u32Loops++;
+    }
+    return u32Loops;
+}
+
+static uint32_t overruns(void)
+{
+    uint32_t i, n = 0;
+
+    for (i = 0; i < SCAN_CHANNELS; i++)
+        n += asCh[i].u32Overruns;
+    return n;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Free-running throughput and load                                                                       */
+/*---------------------------------------------------------------------------------------------------------*/
+static uint32_t free_run(uint32_t cpu)
+{
+    uint32_t u32Idle, u32Busy, u32Load, u32Conv;
+
+    /* Reader loop passes in one second with the ADC stopped */
+    scan_four();
+    u32Idle = drain(TICKS_PER_SEC);
+
+    adcScanStart(&sScan, ADC_SCAN_FREE_RUN, 0);
+    u32Busy = drain(TICKS_PER_SEC);
+    adcScanStop(&sScan);
+
+    u32Conv = sScan.u32Scans * SCAN_CHANNELS;
+    u32Load = (uint32_t)((uint64_t)(u32Idle - u32Busy) * 10000 / u32Idle);
+    printf("Free run, %d channels at %d kHz engine clock, 1 s\n", SCAN_CHANNELS, ENGINE_KHZ);
+    printf("  conversions      %8d /s, %d scans/s\n", u32Conv, sScan.u32Scans);
+    printf("  ring overruns    %8d\n", overruns());
+    printf("  scan code        %8d cycles per conversion, %d.%02d%% CPU\n",
+           sScan.u32Ticks * (cpu / 12) / u32Conv, sScan.u32Ticks / 120000, sScan.u32Ticks / 1200 % 100);
+    printf("  interrupts total %8d cycles per conversion, %d.%02d%% CPU, from the reader loop slowdown\n",
+           (uint32_t)((uint64_t)u32Load * cpu * 100 / u32Conv), u32Load / 100, u32Load % 100);
+    return sScan.u32Scans;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Timer-triggered sweep                                                                                  */
+/*---------------------------------------------------------------------------------------------------------*/
+static void sweep(uint32_t u32FreeScans)
+{
+    static const uint32_t au32Percent[] = { 25, 50, 75, 85, 90, 95, 100, 110 };
+    uint32_t i, u32Rate, u32Best = 0;
+
+    /* ETIMER1 engine clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 9));
+
+    printf("\nTimer-triggered scans of %d channels, 1 s each\n", SCAN_CHANNELS);
+    printf("%9s %9s %12s %8s %9s  %s\n", "scans/s", "of free", "conversions", "missed", "overruns", "scan code CPU");
+    for (i = 0; i < sizeof(au32Percent) / sizeof(au32Percent[0]); i++)
+    {
+        u32Rate = u32FreeScans * au32Percent[i] / 100;
+        scan_four();
+        adcScanStart(&sScan, TRIGGER_TIMER, u32Rate);
+        drain(TICKS_PER_SEC);
+        adcScanStop(&sScan);
+
+        printf("%9d %8d%% %12d %8d %9d  %d.%02d%%\n", u32Rate, au32Percent[i], sScan.u32Scans * SCAN_CHANNELS,
+               sScan.u32Missed, overruns(), sScan.u32Ticks / 120000, sScan.u32Ticks / 1200 % 100);
+        if ((sScan.u32Missed == 0) && (overruns() == 0))
+            u32Best = u32Rate;
+    }
+    printf("Highest sustained: %d scans/s, %d conversions/s\n", u32Best, u32Best * SCAN_CHANNELS);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Decimation                                                                                             */
+/*---------------------------------------------------------------------------------------------------------*/
+static void stats(const char *pcName, ADC_SCAN_CH_T *psCh)
+{
+    uint32_t n, i;
+    double sum = 0, sum2 = 0, mean, var;
+
+    n = adcScanRead(psCh, au16Read, RING_SAMPLES);
+    for (i = 0; i < n; i++)
+    {
+        sum += au16Read[i];
+        sum2 += (double)au16Read[i] * au16Read[i];
+    }
+    mean = sum / n;
+    var = sum2 / n - mean * mean;
+    /* Samples are LSB times 16, print LSB to 1/100 */
+    printf("%-22s %5d %5d.%02d %5d.%02d\n", pcName, n, (int)(mean / 16), (int)(mean * 100 / 16) % 100,
+           (int)(sqrt(var > 0 ? var : 0) / 16), (int)(sqrt(var > 0 ? var : 0) * 100 / 16) % 100);
+}
+
+static void decimation(void)
+{
+    static const uint32_t au32Cfg[][2] = { { 16, 1 }, { 16, 3 }, { 64, 2 } };
+    uint32_t i;
+
+    printf("\nVref (channel 8) raw and decimated in one scan, up to %d samples each\n", RING_SAMPLES);
+    printf("%-22s %5s %8s %8s\n", "filter", "n", "mean LSB", "std LSB");
+    for (i = 0; i < sizeof(au32Cfg) / sizeof(au32Cfg[0]); i++)
+    {
+        char acName[24];
+
+        adcScanInit(&sScan);
+        adcScanAddChannel(&sScan, &asCh[0], 8, au16Ring[0], RING_SAMPLES);
+        adcScanAddChannel(&sScan, &asCh[1], 8, au16Ring[1], RING_SAMPLES);
+        adcScanSetDecimation(&asCh[1], au32Cfg[i][0], au32Cfg[i][1]);
+
+        /* Stop when the decimated ring is full, the raw one overran long before */
+        adcScanStart(&sScan, ADC_SCAN_FREE_RUN, 0);
+        while (adcScanCount(&asCh[1]) < RING_SAMPLES);
+        adcScanStop(&sScan);
+
+        if (i == 0)
+            stats("raw", &asCh[0]);
+        sprintf(acName, "R=%d N=%d", au32Cfg[i][0], au32Cfg[i][1]);
+        /* The first samples hold the filter start-up */
+        adcScanRead(&asCh[1], au16Read, au32Cfg[i][1]);
+        stats(acName, &asCh[1]);
+    }
+}
+
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);   // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+int main(void)
+{
+    uint32_t cpu, u32FreeScans;
+
+    *((volatile unsigned int *)REG_AIC_INTDIS0)=0xFFFFFFFF;  // disable all interrupt channel
+    *((volatile unsigned int *)REG_AIC_INTDIS1)=0xFFFFFFFF;  // disable all interrupt channel
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+    UART_Init();
+
+    // Enable ETIMER0 engine clock
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 8));
+
+    // Free running counter at full 12 MHz resolution
+    ETIMER_Open(0, ETIMER_CONTINUOUS_MODE, 1000000);
+    ETIMER_SET_PRESCALE_VALUE(0, 0);
+    ETIMER_SET_CMP_VALUE(0, 0xFFFFFF);
+    ETIMER_Start(0);
+
+    cpu = sysGetClock(SYS_CPU);
+    printf("\nADC scan, %d MHz CPU\n\n", cpu);
+    adcOpen2(ENGINE_KHZ);
+
+    u32FreeScans = free_run(cpu);
+    sweep(u32FreeScans);
+    decimation();
+
+    while(1);
+}
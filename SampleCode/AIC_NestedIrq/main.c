@@ -0,0 +1,142 @@
+/**************************************************************************//**
+* @file     main.c
+* @brief    Compare flat and nested IRQ dispatch on three ETIMER sources
+*
+*           ETIMER1 (level 3) runs a 2 ms ISR 100 times per second.
+*           ETIMER2 (level 1) interrupts 10000 times per second; its ISR records
+*           the interrupt latency. ETIMER3 is installed on the FIQ vector
+*           with sysInstallFastISR(). ETIMER0 is the 12 MHz free running clock
+*           that times the ISRs. Each phase runs one second, first with the
+*           flat dispatcher, then with the nested one.
+*
+* @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+******************************************************************************/
+#include <stdio.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+
+#define SLOW_ISR_TICKS      24000       /* 2 ms at 12 MHz */
+
+static UINT32 volatile slow_count, fast_count, fiq_count;
+static UINT32 volatile fast_latency;
+
+static UINT32 irq_clock(void)
+{
+    return ETIMER_GetCounter(0);
+}
+
+void ETMR1_IRQHandler(void)
+{
+    UINT32 t0 = ETIMER_GetCounter(0);
+
+    ETIMER_ClearIntFlag(1);
+    slow_count++;
+    while (((ETIMER_GetCounter(0) - t0) & 0xFFFFFF) < SLOW_ISR_TICKS);
+}
+
+void ETMR2_IRQHandler(void)
+{
+    UINT32 latency = ETIMER_GetCounter(2);  // Counts from the compare match at 12 MHz
+
+    ETIMER_ClearIntFlag(2);
+    if (latency > fast_latency)
+        fast_latency = latency;
+    fast_count++;
+}
+
+#if defined (__GNUC__) && !(__CC_ARM)
+static void __attribute__ ((interrupt("FIQ"))) ETMR3_FiqHandler(void)
+#else
+__irq void ETMR3_FiqHandler(void)
+#endif
+{
+    inpw(REG_AIC_FIQNUM);
+    ETIMER_ClearIntFlag(3);
+    fiq_count++;
+    outpw(REG_AIC_EOFS, 1);
+}
+
+/*-----------------------------------------------------------------------------*/
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);   // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+static void run_phase(BOOL bNested)
+{
+    SYS_IRQ_STAT_T st;
+    UINT32 t0;
+
+    sysEnableNestedIrq(bNested);
+    sysGetIrqStat(&st, TRUE);
+    slow_count = fast_count = fiq_count = fast_latency = 0;
+
+    t0 = ETIMER_GetCounter(0);
+    while (((ETIMER_GetCounter(0) - t0) & 0xFFFFFF) < 12000000);
+
+    sysGetIrqStat(&st, TRUE);
+    printf("\n%s dispatch\n", bNested ? "Nested" : "Flat");
+    printf("  ETIMER1 %d ISRs, ETIMER2 %d ISRs, FIQ %d\n", slow_count, fast_count, fiq_count);
+    printf("  ETIMER2 worst latency %d us\n", fast_latency / 12);
+    if (!bNested)
+        return;
+    printf("  ETIMER1 count %d, longest %d us\n", st.u32Count[IRQ_TIMER1], st.u32MaxTime[IRQ_TIMER1] / 12);
+    printf("  ETIMER2 count %d, longest %d us\n", st.u32Count[IRQ_TIMER2], st.u32MaxTime[IRQ_TIMER2] / 12);
+    printf("  deepest nesting %d, level 1: %d, level 3: %d\n",
+           st.u32MaxDepth, st.u32LevelMaxDepth[IRQ_LEVEL_1], st.u32LevelMaxDepth[IRQ_LEVEL_3]);
+    printf("  priority inversions %d, spurious %d\n", st.u32Inversion, st.u32Spurious);
+}
+
+int main(void)
+{
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+    UART_Init();
+
+    printf("\nNested IRQ dispatch sample, CPU %d MHz\n", sysGetClock(SYS_CPU));
+
+    // Enable ETIMER0~3 engine clock
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (0xF << 8));
+
+    // ETIMER0 free running at 12 MHz
+    ETIMER_Open(0, ETIMER_CONTINUOUS_MODE, 1000000);
+    ETIMER_SET_PRESCALE_VALUE(0, 0);
+    ETIMER_SET_CMP_VALUE(0, 0xFFFFFF);
+    ETIMER_Start(0);
+    sysSetIrqStatClock(irq_clock, 0xFFFFFF);
+
+    ETIMER_Open(1, ETIMER_PERIODIC_MODE, 100);
+    ETIMER_EnableInt(1);
+    sysInstallISR(IRQ_LEVEL_3, IRQ_TIMER1, (PVOID)ETMR1_IRQHandler);
+
+    ETIMER_Open(2, ETIMER_PERIODIC_MODE, 10000);
+    ETIMER_EnableInt(2);
+    sysInstallISR(IRQ_LEVEL_1, IRQ_TIMER2, (PVOID)ETMR2_IRQHandler);
+
+    ETIMER_Open(3, ETIMER_PERIODIC_MODE, 1000);
+    ETIMER_EnableInt(3);
+    sysInstallFastISR(IRQ_TIMER3, (PVOID)ETMR3_FiqHandler);
+
+    sysSetLocalInterrupt(ENABLE_FIQ_IRQ);
+    sysEnableInterrupt(IRQ_TIMER1);
+    sysEnableInterrupt(IRQ_TIMER2);
+    sysEnableInterrupt(IRQ_TIMER3);
+    ETIMER_Start(1);
+    ETIMER_Start(2);
+    ETIMER_Start(3);
+
+    run_phase(FALSE);
+    run_phase(TRUE);
+
+    while(1);
+}
@@ -0,0 +1,141 @@
+/**************************************************************************//**
+* @file     main.c
+* @brief    Measure timer interrupt entry latency while other code thrashes
+*           the I-cache, before and after sysLockFastCode() keeps the
+*           SYS_FASTCODE interrupt path in I-cache way 3.
+*
+* @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+******************************************************************************/
+#include <stdio.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+
+#define TICK_HZ         1000
+#define SAMPLES         2000
+#define THRASH_SIZE     (32 * 1024)     /* Twice the I-cache, every call refills it */
+
+#define ARM_NOP         0xE1A00000      /* mov r0, r0 */
+#define ARM_BX_LR       0xE12FFF1E      /* bx lr */
+
+typedef void (*PFN_THRASH)(void);
+
+#if defined (__GNUC__) && !(__CC_ARM)
+static __attribute__((aligned(32))) UINT32 au32Thrash[THRASH_SIZE / 4];
+#else
+static __align(32) UINT32 au32Thrash[THRASH_SIZE / 4];
+#endif
+
+/* Written by the interrupt, ETIMER1 ticks of the 12 MHz crystal */
+static SYS_FASTDATA volatile UINT32 s_u32Count;
+static SYS_FASTDATA volatile UINT32 s_u32Min;
+static SYS_FASTDATA volatile UINT32 s_u32Max;
+static SYS_FASTDATA volatile UINT32 s_u32Sum;
+
+/* ETIMER1 restarts from 0 on the compare match, so its counter is the time since the request */
+SYS_FASTCODE void ETMR1_IRQHandler(void)
+{
+    UINT32 u32Ticks = ETIMER_GetCounter(1);
+
+    ETIMER_ClearIntFlag(1);
+    if (s_u32Count < SAMPLES)
+    {
+        if (u32Ticks < s_u32Min)
+            s_u32Min = u32Ticks;
+        if (u32Ticks > s_u32Max)
+            s_u32Max = u32Ticks;
+        s_u32Sum += u32Ticks;
+        s_u32Count++;
+    }
+}
+
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);   // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+/* A straight run of NOPs as large as two I-caches, built in SDRAM */
+static void BuildThrash(void)
+{
+    UINT32 i;
+
+    for (i = 0; i < THRASH_SIZE / 4 - 1; i++)
+        au32Thrash[i] = ARM_NOP;
+    au32Thrash[i] = ARM_BX_LR;
+
+    /* Write the instructions out to SDRAM, then drop any stale I-cache lines */
+    sysCleanDCacheRange((UINT32)au32Thrash, THRASH_SIZE);
+    sysFlushCache(I_CACHE);
+}
+
+static void Measure(const char *pcName, INT32 i32Thrash)
+{
+    PFN_THRASH pfnThrash = (PFN_THRASH)au32Thrash;
+    UINT32 u32Mhz = sysGetClock(SYS_CPU);
+
+    s_u32Min = 0xFFFFFFFF;
+    s_u32Max = s_u32Sum = 0;
+    s_u32Count = 0;
+
+    ETIMER_Start(1);
+    while (s_u32Count < SAMPLES)
+    {
+        if (i32Thrash)
+            pfnThrash();
+    }
+    ETIMER_Stop(1);
+
+    /* Ticks of 1/12 us to CPU cycles */
+    printf("%-24s %8d %8d %8d\n", pcName, s_u32Min * u32Mhz / 12,
+           s_u32Sum / SAMPLES * u32Mhz / 12, s_u32Max * u32Mhz / 12);
+}
+
+int main(void)
+{
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+    UART_Init();
+
+    printf("\nTimer interrupt entry latency, %d samples, .fastcode %d bytes\n", SAMPLES, sysGetFastCodeSize());
+
+    BuildThrash();
+
+    // Enable ETIMER1 engine clock
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 9));
+
+    // Periodic interrupt, counter at full 12 MHz resolution
+    ETIMER_Open(1, ETIMER_PERIODIC_MODE, TICK_HZ);
+    ETIMER_SET_PRESCALE_VALUE(1, 0);
+    ETIMER_SET_CMP_VALUE(1, 12000000 / TICK_HZ);
+    ETIMER_EnableInt(1);
+    sysInstallISR(IRQ_LEVEL_1, IRQ_TIMER1, (PVOID)ETMR1_IRQHandler);
+    sysSetLocalInterrupt(ENABLE_IRQ);
+    sysEnableInterrupt(IRQ_TIMER1);
+
+    printf("%-24s %8s %8s %8s  (CPU cycles)\n", "", "min", "avg", "max");
+    Measure("idle, unlocked", 0);
+    Measure("thrashing, unlocked", 1);
+
+    if (sysLockFastCode() != Successful)
+    {
+        printf("sysLockFastCode FAILED, .fastcode must be 1 to %d bytes\n", SYS_ICACHE_WAY_SIZE);
+        while(1);
+    }
+    Measure("idle, locked", 0);
+    Measure("thrashing, locked", 1);
+
+    sysUnlockFastCode();
+    Measure("thrashing, unlocked", 1);
+
+    printf("test done...\n");
+    while(1);
+}
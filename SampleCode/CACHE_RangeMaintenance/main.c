@@ -0,0 +1,93 @@
+/**************************************************************************//**
+* @file     main.c
+* @brief    Compare D-cache range maintenance with whole-cache flush
+*
+* @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+
+#define MIN_SIZE    64
+#define MAX_SIZE    (64 * 1024)
+#define LOOPS       16
+
+#if defined (__GNUC__) && !(__CC_ARM)
+static __attribute__((aligned(32))) UINT8 buf[MAX_SIZE];
+#else
+static __align(32) UINT8 buf[MAX_SIZE];
+#endif
+
+static UINT32 cpu_mhz;
+
+static void flush_dcache(UINT32 u32Addr, UINT32 u32Size)
+{
+    sysFlushCache(D_CACHE);
+}
+
+/* Average CPU cycles of one call, with the whole buffer dirty in the D-cache beforehand */
+static UINT32 measure(void (*op)(UINT32, UINT32), UINT32 u32Size)
+{
+    UINT32 i, t0, t1, ticks = 0;
+
+    for (i = 0; i < LOOPS; i++)
+    {
+        memset(buf, i, u32Size);
+        t0 = ETIMER_GetCounter(0);
+        op((UINT32)buf, u32Size);
+        t1 = ETIMER_GetCounter(0);
+        ticks += (t1 - t0) & 0xFFFFFF;
+    }
+    // ETIMER0 counts the 12 MHz crystal
+    return ticks * cpu_mhz / 12 / LOOPS;
+}
+
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);   // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+int main(void)
+{
+    UINT32 size;
+
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+    UART_Init();
+
+    // Enable ETIMER0 engine clock
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 8));
+
+    // Free running counter at full 12 MHz resolution
+    ETIMER_Open(0, ETIMER_CONTINUOUS_MODE, 1000000);
+    ETIMER_SET_PRESCALE_VALUE(0, 0);
+    ETIMER_SET_CMP_VALUE(0, 0xFFFFFF);
+    ETIMER_Start(0);
+
+    cpu_mhz = sysGetClock(SYS_CPU);
+
+    printf("\nD-cache maintenance cost in CPU cycles (CPU %d MHz, buffer dirty, average of %d)\n", cpu_mhz, LOOPS);
+    printf("%8s %10s %12s %12s %10s\n", "bytes", "clean", "invalidate", "clean+inv", "flush");
+    for (size = MIN_SIZE; size <= MAX_SIZE; size <<= 1)
+    {
+        printf("%8d %10d %12d %12d %10d\n", size,
+               measure(sysCleanDCacheRange, size),
+               measure(sysInvalidateDCacheRange, size),
+               measure(sysCleanInvalidateDCacheRange, size),
+               measure(flush_dcache, size));
+    }
+    printf("Ranges from %d bytes on use the whole-cache loops.\n", SYS_DCACHE_SIZE);
+
+    while(1);
+}
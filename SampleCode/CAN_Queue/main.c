@@ -0,0 +1,305 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @brief    Exercise the interrupt-driven CAN queue of canqueue.c on CAN0 in
+ *           internal loop back mode, so no transceiver or second node is
+ *           needed: transmit priority order, frame order and loss under a
+ *           saturated 1 Mbit/s bus with the CPU cost of the interrupt, and
+ *           the software ID filter against a reference set.
+ *
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+#include "can.h"
+
+#define RX_OBJS         16
+#define TX_OBJS         4
+#define RX_FRAMES       256
+#define TX_FRAMES       256
+#define EXT_IDS         1024        /* Extended ID set storage, holds up to 768 IDs */
+#define BIT_RATE        1000000
+#define TICKS_PER_SEC   12000000    /* ETIMER0 counts the 12 MHz crystal */
+
+static CAN_FRAME_T asRx[RX_FRAMES];
+static CAN_TXENTRY_T asTx[TX_FRAMES];
+static uint32_t au32Ext[EXT_IDS];
+static CAN_QUEUE_T sQueue;
+
+static uint32_t clock_12m(void)
+{
+    return ETIMER_GetCounter(0);
+}
+
+static void set_frame(STR_CANMSG_T *pMsg, uint32_t u32IdType, uint32_t u32Id, uint32_t u32Seq)
+{
+    pMsg->FrameType = CAN_DATA_FRAME;
+    pMsg->IdType = u32IdType;
+    pMsg->Id = u32Id;
+    pMsg->DLC = 8;
+    pMsg->Data[0] = (uint8_t)u32Seq;
+    pMsg->Data[1] = (uint8_t)(u32Seq >> 8);
+    pMsg->Data[2] = (uint8_t)(u32Seq >> 16);
+    pMsg->Data[3] = (uint8_t)(u32Seq >> 24);
+    pMsg->Data[4] = 0x55;
+    pMsg->Data[5] = 0xAA;
+    pMsg->Data[6] = 0x0F;
+    pMsg->Data[7] = 0xF0;
+}
+
+static uint32_t get_seq(STR_CANMSG_T *pMsg)
+{
+    return pMsg->Data[0] | (pMsg->Data[1] << 8) | (pMsg->Data[2] << 16) | ((uint32_t)pMsg->Data[3] << 24);
+}
+
+/* Order of arbitration: base ID, standard before extended, then the extended ID bits */
+static uint32_t arb_key(STR_CANMSG_T *pMsg)
+{
+    if(pMsg->IdType == CAN_STD_ID)
+        return pMsg->Id << 19;
+    return ((pMsg->Id >> 18) << 19) | (1 << 18) | (pMsg->Id & 0x3FFFF);
+}
+
+/* Wait up to u32Ms for u32Frames frames, passing each to pfnCheck */
+static uint32_t collect(uint32_t u32Frames, uint32_t u32Ms, void (*pfnCheck)(CAN_FRAME_T *))
+{
+    CAN_FRAME_T sFrame;
+    uint32_t n = 0, t0 = ETIMER_GetCounter(0), t, u32Elapsed = 0;
+
+    while((n < u32Frames) && (u32Elapsed < u32Ms * (TICKS_PER_SEC / 1000)))
+    {
+        if(CAN_QueueReceive(&sQueue, &sFrame))
+        {
+            pfnCheck(&sFrame);
+            n++;
+        }
+        t = ETIMER_GetCounter(0);
+        u32Elapsed += (t - t0) & 0xFFFFFF;
+        t0 = t;
+    }
+    return n;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Priority order                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+static uint32_t u32PrioIndex, u32PrioErrors, u32PrevKey;
+
+static void check_priority(CAN_FRAME_T *psFrame)
+{
+    uint32_t u32Key = arb_key(&psFrame->sMsg);
+
+    /* The first TX_OBJS frames were loaded at once, the others leave in priority order */
+    if((u32PrioIndex > TX_OBJS) && (u32Key < u32PrevKey))
+        u32PrioErrors++;
+    u32PrevKey = u32Key;
+    u32PrioIndex++;
+}
+
+static void priority(void)
+{
+    STR_CANMSG_T sMsg;
+    uint32_t i, n;
+
+    /* Queue while the interrupt is off: only the transmit objects are loaded */
+    sysDisableInterrupt(IRQ_CAN0);
+    for(i = 0; i < 200; i++)
+    {
+        if(i & 1)
+            set_frame(&sMsg, CAN_EXT_ID, rand() & 0x1FFFFFFF, i);
+        else
+            set_frame(&sMsg, CAN_STD_ID, rand() & 0x7FF, i);
+        CAN_QueueSend(&sQueue, &sMsg);
+    }
+    u32PrioIndex = u32PrioErrors = 0;
+    sysEnableInterrupt(IRQ_CAN0);
+
+    n = collect(200, 1000, check_priority);
+    printf("Priority: %d random standard and extended IDs queued, %d received, %d out of arbitration order\n",
+           200, n, u32PrioErrors);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Saturated bus                                                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+static void throughput(uint32_t cpu)
+{
+    CAN_FRAME_T sFrame;
+    STR_CANMSG_T sMsg;
+    uint32_t u32Frames = 20000, u32Sent = 0, u32Got = 0, u32SeqErrors = 0;
+    uint32_t t0, t, u32Elapsed = 0, u32LoadSum = 0, u32LoadN = 0, u32Next = TICKS_PER_SEC / 2;
+    uint32_t u32Ticks0 = sQueue.u32Ticks, u32Lost0 = sQueue.u32RxLost, u32Over0 = sQueue.u32RxOverruns;
+
+    CAN_QueueBusLoad(&sQueue);
+    t0 = ETIMER_GetCounter(0);
+    while((u32Got < u32Frames) && (u32Elapsed < 10 * TICKS_PER_SEC))
+    {
+        /* One ID, so the frames must arrive in the order queued */
+        while(u32Sent < u32Frames)
+        {
+            set_frame(&sMsg, CAN_STD_ID, 0x123, u32Sent);
+            if(!CAN_QueueSend(&sQueue, &sMsg))
+                break;
+            u32Sent++;
+        }
+        while(CAN_QueueReceive(&sQueue, &sFrame))
+        {
+            if(get_seq(&sFrame.sMsg) != u32Got)
+                u32SeqErrors++;
+            u32Got = get_seq(&sFrame.sMsg) + 1;
+        }
+        t = ETIMER_GetCounter(0);
+        u32Elapsed += (t - t0) & 0xFFFFFF;
+        t0 = t;
+        if(u32Elapsed >= u32Next)
+        {
+            u32LoadSum += CAN_QueueBusLoad(&sQueue);
+            u32LoadN++;
+            u32Next += TICKS_PER_SEC / 2;
+        }
+    }
+
+    u32Ticks0 = sQueue.u32Ticks - u32Ticks0;
+    printf("Saturated: %d frames of 8 bytes in %d ms, %d frames/s, bus load %d.%02d%% without stuff bits\n",
+           u32Got, u32Elapsed / 12000, (uint32_t)((uint64_t)u32Got * TICKS_PER_SEC / u32Elapsed),
+           u32LoadN ? u32LoadSum / u32LoadN / 100 : 0, u32LoadN ? u32LoadSum / u32LoadN % 100 : 0);
+    printf("           %d sequence errors, %d lost in the FIFO, %d ring overruns\n",
+           u32SeqErrors, sQueue.u32RxLost - u32Lost0, sQueue.u32RxOverruns - u32Over0);
+    printf("           interrupt %d.%02d%% CPU, %d cycles per frame sent and received\n",
+           (uint32_t)((uint64_t)u32Ticks0 * 100 / u32Elapsed), (uint32_t)((uint64_t)u32Ticks0 * 10000 / u32Elapsed % 100),
+           (uint32_t)((uint64_t)u32Ticks0 * (cpu / 12) / u32Got));
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Software filter                                                                                        */
+/*---------------------------------------------------------------------------------------------------------*/
+static uint8_t au8Std[2048 / 8];
+static uint32_t au32ExtIds[500];
+static uint32_t u32FilterErrors;
+
+static int ext_listed(uint32_t u32Id)
+{
+    uint32_t i;
+
+    for(i = 0; i < sizeof(au32ExtIds) / sizeof(au32ExtIds[0]); i++)
+        if(au32ExtIds[i] == u32Id)
+            return 1;
+    return 0;
+}
+
+static void check_filter(CAN_FRAME_T *psFrame)
+{
+    uint32_t u32Id = psFrame->sMsg.Id;
+
+    if(psFrame->sMsg.IdType == CAN_STD_ID ? !(au8Std[u32Id >> 3] & (1 << (u32Id & 7))) : !ext_listed(u32Id))
+        u32FilterErrors++;
+}
+
+static void filter(void)
+{
+    STR_CANMSG_T sMsg;
+    uint32_t i, u32Id, u32Expect = 0, u32Sent = 0, n = 0, u32Filtered0 = sQueue.u32RxFiltered;
+
+    CAN_QueueEnableFilter(&sQueue, au32Ext, EXT_IDS);
+    memset(au8Std, 0, sizeof(au8Std));
+    for(i = 0; i < 2048; i += 7)
+    {
+        au8Std[i >> 3] |= 1 << (i & 7);
+        CAN_QueueAddId(&sQueue, CAN_STD_ID, i);
+    }
+    for(i = 0; i < sizeof(au32ExtIds) / sizeof(au32ExtIds[0]); i++)
+    {
+        au32ExtIds[i] = (rand() & 0x1FFFFFFF) | 1;
+        CAN_QueueAddId(&sQueue, CAN_EXT_ID, au32ExtIds[i]);
+    }
+
+    /* Standard IDs at random, extended ones half listed, half their unlisted neighbours */
+    u32FilterErrors = 0;
+    for(i = 0; i < 4000; i++)
+    {
+        if(i & 1)
+        {
+            u32Id = au32ExtIds[rand() % 500] & ~(rand() & 1);
+            set_frame(&sMsg, CAN_EXT_ID, u32Id, i);
+            u32Expect += ext_listed(u32Id);
+        }
+        else
+        {
+            u32Id = rand() & 0x7FF;
+            set_frame(&sMsg, CAN_STD_ID, u32Id, i);
+            u32Expect += (au8Std[u32Id >> 3] >> (u32Id & 7)) & 1;
+        }
+        while(!CAN_QueueSend(&sQueue, &sMsg))
+            n += collect(TX_FRAMES, 1, check_filter);
+        u32Sent++;
+    }
+    n += collect(u32Expect - n, 1000, check_filter);
+    CAN_QueueDisableFilter(&sQueue);
+
+    printf("Filter: %d frames sent, %d accepted of %d expected, %d rejected, %d accepted wrongly\n",
+           u32Sent, n, u32Expect, sQueue.u32RxFiltered - u32Filtered0, u32FilterErrors);
+}
+
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);   // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+int32_t main(void)
+{
+    uint32_t cpu, i;
+
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+    UART_Init();
+
+    // Enable ETIMER0 engine clock
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 8));
+
+    // Free running counter at full 12 MHz resolution
+    ETIMER_Open(0, ETIMER_CONTINUOUS_MODE, 1000000);
+    ETIMER_SET_PRESCALE_VALUE(0, 0);
+    ETIMER_SET_CMP_VALUE(0, 0xFFFFFF);
+    ETIMER_Start(0);
+
+    // Enable CAN0 clock, loop back needs no pins
+    outpw(REG_CLK_PCLKEN1, inpw(REG_CLK_PCLKEN1) | (1 << 8));
+    CAN_Open(CAN0, BIT_RATE, CAN_NORMAL_MODE);
+    CAN_EnterTestMode(CAN0, CAN_TEST_LBACK_Msk);
+
+    if(CAN_QueueOpen(&sQueue, CAN0, RX_OBJS, TX_OBJS, asRx, RX_FRAMES, asTx, TX_FRAMES) == FALSE)
+    {
+        printf("CAN_QueueOpen failed\n");
+        while(1);
+    }
+    CAN_QueueSetClock(&sQueue, clock_12m, 0xFFFFFF, TICKS_PER_SEC);
+
+    cpu = sysGetClock(SYS_CPU);
+    printf("\nCAN queue on CAN0 loop back at %d bit/s, %d MHz CPU\n", CAN_GetCANBitRate(CAN0), cpu);
+    printf("%d FIFO objects, %d transmit objects\n\n", RX_OBJS, TX_OBJS);
+
+    priority();
+    throughput(cpu);
+    filter();
+
+    printf("\nFrames: %d received, %d sent\n", sQueue.u32RxFrames, sQueue.u32TxFrames);
+    printf("Errors: warning %d, passive %d, bus-off %d, last error codes", sQueue.u32Warnings,
+           sQueue.u32Passive, sQueue.u32BusOff);
+    for(i = 1; i < 7; i++)
+        printf(" %d", sQueue.au32Lec[i]);
+    printf("\n");
+
+    CAN_QueueClose(&sQueue);
+    while(1);
+}
@@ -0,0 +1,262 @@
+/**************************************************************************//**
+* @file     main.c
+* @brief    Run the motion.c block motion analysis on synthetic scenes and
+*           report event accuracy, bounding box overlap and CPU time per
+*           frame for 40x30 and 80x60 maps in both map formats.
+*           No sensor is needed: a software model of the CAP motion
+*           detection engine turns synthetic block luma into the map.
+*
+* @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+#include "cap.h"
+
+#define BLOCK           8           /* 8x8 blocks */
+#define MAX_COLS        80
+#define MAX_ROWS        60
+#define FRAMES          240
+#define MD_THRESHOLD    8           /* DIFF flag threshold of the model */
+
+#if defined (__GNUC__) && !(__CC_ARM)
+static __attribute__((aligned(32))) uint8_t map[MAX_COLS * MAX_ROWS];
+#else
+static __align(32) uint8_t map[MAX_COLS * MAX_ROWS];
+#endif
+static uint16_t work[CAP_MD_WORK_SIZE(MAX_COLS, MAX_ROWS)];
+static int16_t prev[MAX_COLS * MAX_ROWS];
+static CAP_MD_T md;
+
+static const struct
+{
+    const char *name;
+    int32_t objStart, objEnd;       /* Frames an object crosses the view, 0 for none */
+    int32_t lightFrame;             /* Frame of a global lighting step, 0 for none */
+    int32_t flicker;                /* A blinking area through the whole scene */
+} scenes[] =
+{
+    { "Noise only",       0,   0,   0, 0 },
+    { "Object crossing",  90,  180, 0, 0 },
+    { "Lighting step",    0,   0,   120, 0 },
+    { "Flicker + object", 100, 200, 0, 1 },
+};
+
+static const struct
+{
+    uint32_t w, h;
+} sizes[] = { {320, 240}, {640, 480} };
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Synthetic scene at block level                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+static uint32_t seed;
+
+static int32_t noise(void)
+{
+    seed = seed * 1664525 + 1013904223;
+    return (int32_t)(seed >> 29) - 4;           /* -4 ~ 3 */
+}
+
+/* Object rectangle in pixels at frame f, returns 0 when out of view */
+static int obj_rect(int32_t s, uint32_t w, uint32_t h, int32_t f, int32_t *x, int32_t *y, int32_t *size)
+{
+    int32_t span = scenes[s].objEnd - scenes[s].objStart;
+
+    if (!scenes[s].objStart || (f < scenes[s].objStart) || (f > scenes[s].objEnd))
+        return 0;
+    *size = (int32_t)w / 8;
+    *x = -*size + ((int32_t)w + *size) * (f - scenes[s].objStart) / span;
+    *y = (int32_t)h / 3 + (f - scenes[s].objStart) / 4;
+    return (*x + *size > 0) && (*x < (int32_t)w);
+}
+
+/* Mean luma of block (bx, by) at frame f */
+static int32_t block_luma(int32_t s, uint32_t w, uint32_t h, uint32_t cols, uint32_t rows,
+                          int32_t f, uint32_t bx, uint32_t by)
+{
+    int32_t v = 60 + (int32_t)((bx * 3 + by * 2) % 100);
+    int32_t x, y, size, px, py, sum;
+
+    if (scenes[s].lightFrame && (f >= scenes[s].lightFrame))
+        v += 30;
+    if (scenes[s].flicker && (bx >= cols * 3 / 4) && (bx < cols * 3 / 4 + 4) &&
+            (by >= rows / 4) && (by < rows / 4 + 4) && (f & 1))
+        v += 40;
+    if (obj_rect(s, w, h, f, &x, &y, &size) &&
+            (x < (int32_t)(bx + 1) * BLOCK) && (x + size > (int32_t)bx * BLOCK) &&
+            (y < (int32_t)(by + 1) * BLOCK) && (y + size > (int32_t)by * BLOCK))
+    {
+        /* Object with a 6 pixel checker texture, so its inside changes as it moves */
+        sum = 0;
+        for (py = by * BLOCK; py < (int32_t)(by + 1) * BLOCK; py++)
+            for (px = bx * BLOCK; px < (int32_t)(bx + 1) * BLOCK; px++)
+                if ((px >= x) && (px < x + size) && (py >= y) && (py < y + size))
+                    sum += ((((px - x) / 6) + ((py - y) / 6)) & 1) ? 90 - v : 20 - v;
+        v += sum / (BLOCK * BLOCK);
+    }
+    return v + noise() / 2;
+}
+
+/* Model of the engine: Y differential of each block to the previous frame */
+static void md_model(int32_t s, uint32_t w, uint32_t h, int32_t f, uint32_t u32Format)
+{
+    uint32_t cols = w / BLOCK, rows = h / BLOCK;
+    uint32_t bx, by, i, d, n = cols * rows;
+    int32_t v;
+
+    if (u32Format)
+        memset(map, 0, (n + 7) / 8);
+    for (by = 0, i = 0; by < rows; by++)
+    {
+        for (bx = 0; bx < cols; bx++, i++)
+        {
+            v = block_luma(s, w, h, cols, rows, f, bx, by);
+            d = (uint32_t)(v > prev[i] ? v - prev[i] : prev[i] - v);
+            if (f == 0)
+                d = 0;
+            prev[i] = (int16_t)v;
+            if (d > 127)
+                d = 127;
+            if (u32Format)
+                map[i >> 3] |= (uint8_t)((d > MD_THRESHOLD) << (i & 7));
+            else
+                map[i] = (uint8_t)(((d > MD_THRESHOLD) << 7) | d);
+        }
+    }
+    /* The engine writes memory, not the D-cache */
+    sysCleanDCacheRange((uint32_t)map, sizeof(map));
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Run one scene                                                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+static uint32_t ticks, maxTicks, processed;
+
+static void run(int32_t s, uint32_t w, uint32_t h, uint32_t u32Format)
+{
+    uint32_t cols = w / BLOCK, rows = h / BLOCK;
+    uint32_t t0, t, evt, truth, fp = 0, fn = 0, events = 0, iouN = 0;
+    int32_t f, x, y, size, ow, start = -1, end = -1;
+    int32_t ix0, iy0, ix1, iy1, inter, uni, iouSum = 0;
+    CAP_MD_BOX_T *b;
+
+    seed = 12345;
+    CAP_MD_Init(&md, cols, rows, u32Format, work);
+    for (f = 0; f < FRAMES; f++)
+    {
+        md_model(s, w, h, f, u32Format);
+
+        t0 = ETIMER_GetCounter(0);
+        evt = CAP_MD_Process(&md, map);
+        t = (ETIMER_GetCounter(0) - t0) & 0xFFFFFF;
+        ticks += t;
+        if (t > maxTicks)
+            maxTicks = t;
+        processed++;
+
+        if (evt & CAP_MD_EVT_START)
+        {
+            events++;
+            if (start < 0)
+                start = f;
+        }
+        if (evt & CAP_MD_EVT_END)
+            end = f;
+
+        /* Frames within the start and end latency of the hysteresis are not scored */
+        truth = scenes[s].objStart && (f >= scenes[s].objStart) && (f <= scenes[s].objEnd);
+        if (scenes[s].objStart && (((f >= scenes[s].objStart) && (f < scenes[s].objStart + 8)) ||
+                                   ((f > scenes[s].objEnd) && (f <= scenes[s].objEnd + (int32_t)md.u32OffFrames + 2))))
+            continue;
+        if ((evt & CAP_MD_EVT_MOTION) && !truth)
+            fp++;
+        if (!(evt & CAP_MD_EVT_MOTION) && truth)
+            fn++;
+
+        /* Overlap of the largest box with the object */
+        if (obj_rect(s, w, h, f, &x, &y, &size))
+        {
+            /* Visible part of the object */
+            ix1 = x + size < (int32_t)w ? x + size : (int32_t)w;
+            x = x > 0 ? x : 0;
+            ow = ix1 - x;
+            iouN++;
+            if (!md.u32Boxes)
+                continue;
+            b = &md.asBox[0];
+            ix0 = b->u16X * BLOCK > x ? b->u16X * BLOCK : x;
+            iy0 = b->u16Y * BLOCK > y ? b->u16Y * BLOCK : y;
+            ix1 = (b->u16X + b->u16W) * BLOCK < x + ow ? (b->u16X + b->u16W) * BLOCK : x + ow;
+            iy1 = (b->u16Y + b->u16H) * BLOCK < y + size ? (b->u16Y + b->u16H) * BLOCK : y + size;
+            if ((ix1 <= ix0) || (iy1 <= iy0))
+                continue;
+            inter = (ix1 - ix0) * (iy1 - iy0);
+            uni = b->u16W * b->u16H * BLOCK * BLOCK + ow * size - inter;
+            iouSum += inter * 100 / uni;
+        }
+    }
+
+    printf("%5dx%-3d %-4s %-17s %6d %5d %5d", cols, rows, u32Format ? "bit" : "byte",
+           scenes[s].name, events, fp, fn);
+    if (scenes[s].objStart)
+        printf(" %+6d %+6d %4d%%\n", start < 0 ? 0 : start - scenes[s].objStart,
+               end < 0 ? 0 : end - scenes[s].objEnd, iouN ? iouSum / (int32_t)iouN : 0);
+    else
+        printf("\n");
+}
+
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);   // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+int main(void)
+{
+    uint32_t i, s, fmt, cpu;
+
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+    UART_Init();
+
+    // Enable ETIMER0 engine clock
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 8));
+
+    // Free running counter at full 12 MHz resolution
+    ETIMER_Open(0, ETIMER_CONTINUOUS_MODE, 1000000);
+    ETIMER_SET_PRESCALE_VALUE(0, 0);
+    ETIMER_SET_CMP_VALUE(0, 0xFFFFFF);
+    ETIMER_Start(0);
+
+    cpu = sysGetClock(SYS_CPU);
+    printf("\nBlock motion analysis, %d frames per scene\n", FRAMES);
+    printf("Latency is frames from the object entering/leaving to the start/end event\n");
+    printf("%-14s %-17s %6s %5s %5s %6s %6s %5s\n", "map", "scene", "events", "fp", "fn",
+           "start", "end", "IoU");
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        for (fmt = 0; fmt < 2; fmt++)
+        {
+            ticks = maxTicks = processed = 0;
+            for (s = 0; s < sizeof(scenes) / sizeof(scenes[0]); s++)
+                run(s, sizes[i].w, sizes[i].h, fmt);
+            printf("  CAP_MD_Process: %d cycles/frame average, %d max, %d.%02d%% of a 30 fps frame\n\n",
+                   ticks / processed * cpu / 12, maxTicks * cpu / 12,
+                   ticks / processed / 4000, ticks / processed / 40 % 100);
+        }
+    }
+
+    while(1);
+}
@@ -0,0 +1,331 @@
+/**************************************************************************//**
+* @file     main.c
+* @brief    Check the pixops.c conversion, downscale and crop kernels
+*           against per-pixel references for aligned and unaligned buffers,
+*           then measure their throughput on 160x120 to 640x480 frames.
+*           No sensor is needed, the frames are synthetic.
+*
+* @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+#include "cap.h"
+
+#define MAX_W           640
+#define MAX_H           480
+#define GUARD           0x5A
+
+#if defined (__GNUC__) && !(__CC_ARM)
+static __attribute__((aligned(32))) uint8_t src[MAX_W * MAX_H * 2 + 64];
+static __attribute__((aligned(32))) uint8_t out[MAX_W * MAX_H * 3 + 64];
+static __attribute__((aligned(32))) uint8_t ref[MAX_W * MAX_H * 3 + 64];
+#else
+static __align(32) uint8_t src[MAX_W * MAX_H * 2 + 64];
+static __align(32) uint8_t out[MAX_W * MAX_H * 3 + 64];
+static __align(32) uint8_t ref[MAX_W * MAX_H * 3 + 64];
+#endif
+
+static const struct
+{
+    uint32_t w, h;
+} sizes[] = { {160, 120}, {320, 240}, {640, 480} };
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Per-pixel references, written from the definitions                                                     */
+/*---------------------------------------------------------------------------------------------------------*/
+static uint8_t ref_clip(int32_t v)
+{
+    v >>= 8;
+    return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+static void ref_rgb(int32_t y, int32_t u, int32_t v, uint8_t *rgb)
+{
+    y -= 16;
+    u -= 128;
+    v -= 128;
+    rgb[0] = ref_clip(298 * y + 409 * v + 128);
+    rgb[1] = ref_clip(298 * y - 100 * u - 208 * v + 128);
+    rgb[2] = ref_clip(298 * y + 516 * u + 128);
+}
+
+static void ref_rgb565(const uint8_t *s, uint8_t *d, uint32_t n)
+{
+    uint8_t rgb[3];
+    uint16_t p;
+    uint32_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        ref_rgb(s[(i & ~1) * 2 + (i & 1) * 2], s[(i & ~1) * 2 + 1], s[(i & ~1) * 2 + 3], rgb);
+        p = (uint16_t)(((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3));
+        d[i * 2] = (uint8_t)p;
+        d[i * 2 + 1] = (uint8_t)(p >> 8);
+    }
+}
+
+static void ref_rgb888(const uint8_t *s, uint8_t *d, uint32_t n)
+{
+    uint32_t i;
+
+    for (i = 0; i < n; i++)
+        ref_rgb(s[(i & ~1) * 2 + (i & 1) * 2], s[(i & ~1) * 2 + 1], s[(i & ~1) * 2 + 3], &d[i * 3]);
+}
+
+static void ref_gray(const uint8_t *s, uint8_t *d, uint32_t n)
+{
+    uint32_t i;
+
+    for (i = 0; i < n; i++)
+        d[i] = s[i * 2];
+}
+
+static void ref_planar(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *d, uint32_t w, uint32_t h, uint32_t fmt)
+{
+    uint32_t i, j, c;
+
+    for (j = 0; j < h; j++)
+    {
+        c = (fmt == CAP_PAR_PLNFMT_YUV420) ? j / 2 : j;
+        for (i = 0; i < w; i++)
+        {
+            d[(j * w + i) * 2] = y[j * w + i];
+            d[(j * w + i) * 2 + 1] = (i & 1) ? v[c * (w / 2) + i / 2] : u[c * (w / 2) + i / 2];
+        }
+    }
+}
+
+static void ref_down(const uint8_t *s, uint32_t ss, uint8_t *d, uint32_t ds, uint32_t w, uint32_t h)
+{
+    uint32_t i, j;
+
+    for (j = 0; j < h / 2; j++)
+        for (i = 0; i < w / 2; i++)
+            d[j * ds + i] = (uint8_t)((s[2 * j * ss + 2 * i] + s[2 * j * ss + 2 * i + 1] +
+                                       s[(2 * j + 1) * ss + 2 * i] + s[(2 * j + 1) * ss + 2 * i + 1] + 2) >> 2);
+}
+
+static void ref_down_yuyv(const uint8_t *s, uint32_t ss, uint8_t *d, uint32_t ds, uint32_t w, uint32_t h)
+{
+    const uint8_t *t, *b;
+    uint32_t i, j, k;
+
+    for (j = 0; j < h / 2; j++)
+    {
+        for (i = 0; i < w / 2; i++)
+        {
+            /* Output pixel i comes from source pixels 2i and 2i+1 */
+            t = s + 2 * j * ss + 4 * i;
+            b = t + ss;
+            d[j * ds + 2 * i] = (uint8_t)((t[0] + t[2] + b[0] + b[2] + 2) >> 2);
+            /* Its chroma byte from the chroma of source pixel pairs 2k and 2k+1 */
+            k = (i & ~1) * 4 + ((i & 1) ? 3 : 1);
+            t = s + 2 * j * ss + k;
+            b = t + ss;
+            d[j * ds + 2 * i + 1] = (uint8_t)((t[0] + t[4] + b[0] + b[4] + 2) >> 2);
+        }
+    }
+}
+
+static void ref_crop(const uint8_t *s, uint32_t ss, uint8_t *d, uint32_t ds, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t bpp)
+{
+    uint32_t i, j;
+
+    for (j = 0; j < h; j++)
+        for (i = 0; i < w * bpp; i++)
+            d[j * ds + i] = s[(y + j) * ss + x * bpp + i];
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Bit-exactness                                                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+static void fill_src(uint32_t seed)
+{
+    uint32_t i;
+
+    for (i = 0; i < sizeof(src); i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        src[i] = (uint8_t)(seed >> 16);
+    }
+    /* Black, white and saturated corners of the colour space at the start */
+    for (i = 0; i < 256; i++)
+        src[i] = (i & 1) ? ((i & 2) ? 0 : 255) : ((i & 4) ? 0 : 255);
+}
+
+/* Output bytes [0, len) must match the reference and the byte behind them must be untouched */
+static uint32_t compare(const char *name, uint32_t w, uint32_t h, uint32_t sa, uint32_t da, uint32_t len)
+{
+    if (memcmp(&out[da], &ref[da], len) || (out[da + len] != GUARD))
+    {
+        printf("%-20s %3dx%-3d src+%d dst+%d FAILED\n", name, w, h, sa, da);
+        return 1;
+    }
+    return 0;
+}
+
+#define PREPARE(da, len)   do { memset(out, GUARD, (da) + (len) + 4); memset(ref, GUARD, (da) + (len) + 4); } while (0)
+
+static uint32_t check(void)
+{
+    /* Widths with and without tails for the word loops */
+    static const uint32_t widths[] = { 2, 6, 8, 14, 160, 162, 166, 640 };
+    uint32_t k, w, h, sa, da, n, fail = 0;
+    const uint8_t *y, *u, *v;
+
+    for (k = 0; k < sizeof(widths) / sizeof(widths[0]); k++)
+    {
+        w = widths[k];
+        h = 6;
+        n = w * h;
+        for (sa = 0; sa < 4; sa += 1)
+        {
+            for (da = 0; da < 4; da += 1)
+            {
+                PREPARE(da, n * 2);
+                CAP_PixYUYVToRGB565(&src[sa * 2], &out[da], n);
+                ref_rgb565(&src[sa * 2], &ref[da], n);
+                fail += compare("CAP_PixYUYVToRGB565", w, h, sa * 2, da, n * 2);
+
+                PREPARE(da, n * 3);
+                CAP_PixYUYVToRGB888(&src[sa * 2], &out[da], n);
+                ref_rgb888(&src[sa * 2], &ref[da], n);
+                fail += compare("CAP_PixYUYVToRGB888", w, h, sa * 2, da, n * 3);
+
+                PREPARE(da, n);
+                CAP_PixYUYVToGray(&src[sa * 2], &out[da], n);
+                ref_gray(&src[sa * 2], &ref[da], n);
+                fail += compare("CAP_PixYUYVToGray", w, h, sa * 2, da, n);
+
+                y = &src[sa];
+                u = y + n;
+                v = u + n / 2;
+                PREPARE(da, n * 2);
+                CAP_PixPlanarToYUYV(y, u, v, &out[da], w, h, CAP_PAR_PLNFMT_YUV422);
+                ref_planar(y, u, v, &ref[da], w, h, CAP_PAR_PLNFMT_YUV422);
+                fail += compare("CAP_PixPlanarToYUYV", w, h, sa, da, n * 2);
+
+                PREPARE(da, n * 2);
+                CAP_PixPlanarToYUYV(y, u, v, &out[da], w, h, CAP_PAR_PLNFMT_YUV420);
+                ref_planar(y, u, v, &ref[da], w, h, CAP_PAR_PLNFMT_YUV420);
+                fail += compare("CAP_PixPlanarToYUYV", w, h, sa, da, n * 2);
+
+                PREPARE(da, n / 4);
+                CAP_PixDownscale2x(&src[sa], w, &out[da], w / 2, w, h);
+                ref_down(&src[sa], w, &ref[da], w / 2, w, h);
+                fail += compare("CAP_PixDownscale2x", w, h, sa, da, n / 4);
+
+                if ((w & 3) == 0)
+                {
+                    PREPARE(da, n / 2);
+                    CAP_PixDownscaleYUYV2x(&src[sa * 2], w * 2, &out[da], w, w, h);
+                    ref_down_yuyv(&src[sa * 2], w * 2, &ref[da], w, w, h);
+                    fail += compare("CAP_PixDownscaleYUYV2x", w, h, sa * 2, da, n / 2);
+                }
+
+                PREPARE(da, (w / 2) * 3 * (h / 2));
+                CAP_PixCrop(&src[sa], w * 3, &out[da], (w / 2) * 3, w / 4, h / 4, w / 2, h / 2, 3);
+                ref_crop(&src[sa], w * 3, &ref[da], (w / 2) * 3, w / 4, h / 4, w / 2, h / 2, 3);
+                fail += compare("CAP_PixCrop", w, h, sa, da, (w / 2) * 3 * (h / 2));
+            }
+        }
+    }
+    return fail;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Throughput                                                                                             */
+/*---------------------------------------------------------------------------------------------------------*/
+/* Mpixel/s of one call on a 12 MHz counter, in units of 0.1 */
+#define MEASURE(result, pixels, call)                                   \
+    do {                                                                \
+        uint32_t _t0 = ETIMER_GetCounter(0), _ticks;                    \
+        call;                                                           \
+        _ticks = (ETIMER_GetCounter(0) - _t0) & 0xFFFFFF;               \
+        (result) = _ticks ? (uint32_t)((uint64_t)(pixels) * 120 / _ticks) : 0; \
+    } while (0)
+
+static void print_rate(const char *name, uint32_t w, uint32_t h, uint32_t t_ref, uint32_t t_pix)
+{
+    printf("%-22s %3dx%-3d %4d.%d %6d.%d\n", name, w, h, t_ref / 10, t_ref % 10, t_pix / 10, t_pix % 10);
+}
+
+static void bench(uint32_t w, uint32_t h)
+{
+    uint32_t n = w * h, t_ref, t_pix;
+    const uint8_t *y = src, *u = src + n, *v = u + n / 2;
+
+    MEASURE(t_ref, n, ref_rgb565(src, ref, n));
+    MEASURE(t_pix, n, CAP_PixYUYVToRGB565(src, out, n));
+    print_rate("YUV422 to RGB565", w, h, t_ref, t_pix);
+
+    MEASURE(t_ref, n, ref_rgb888(src, ref, n));
+    MEASURE(t_pix, n, CAP_PixYUYVToRGB888(src, out, n));
+    print_rate("YUV422 to RGB888", w, h, t_ref, t_pix);
+
+    MEASURE(t_ref, n, ref_gray(src, ref, n));
+    MEASURE(t_pix, n, CAP_PixYUYVToGray(src, out, n));
+    print_rate("YUV422 to gray", w, h, t_ref, t_pix);
+
+    MEASURE(t_ref, n, ref_planar(y, u, v, ref, w, h, CAP_PAR_PLNFMT_YUV420));
+    MEASURE(t_pix, n, CAP_PixPlanarToYUYV(y, u, v, out, w, h, CAP_PAR_PLNFMT_YUV420));
+    print_rate("planar 420 to YUV422", w, h, t_ref, t_pix);
+
+    MEASURE(t_ref, n, ref_down(src, w, ref, w / 2, w, h));
+    MEASURE(t_pix, n, CAP_PixDownscale2x(src, w, out, w / 2, w, h));
+    print_rate("plane 2x downscale", w, h, t_ref, t_pix);
+
+    MEASURE(t_ref, n, ref_down_yuyv(src, w * 2, ref, w, w, h));
+    MEASURE(t_pix, n, CAP_PixDownscaleYUYV2x(src, w * 2, out, w, w, h));
+    print_rate("YUV422 2x downscale", w, h, t_ref, t_pix);
+
+    MEASURE(t_ref, n / 4, ref_crop(src, w * 2, ref, w, w / 4, h / 4, w / 2, h / 2, 2));
+    MEASURE(t_pix, n / 4, CAP_PixCrop(src, w * 2, out, w, w / 4, h / 4, w / 2, h / 2, 2));
+    print_rate("YUV422 center crop", w, h, t_ref, t_pix);
+}
+
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);   // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+int main(void)
+{
+    uint32_t i;
+
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+    UART_Init();
+
+    // Enable ETIMER0 engine clock
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 8));
+
+    // Free running counter at full 12 MHz resolution
+    ETIMER_Open(0, ETIMER_CONTINUOUS_MODE, 1000000);
+    ETIMER_SET_PRESCALE_VALUE(0, 0);
+    ETIMER_SET_CMP_VALUE(0, 0xFFFFFF);
+    ETIMER_Start(0);
+
+    fill_src(1);
+    printf("\nChecking the pixel kernels against per-pixel references\n");
+    printf("%s\n", check() ? "Check FAILED" : "Check OK");
+
+    printf("\nMpixel/s (CPU %d MHz)\n", sysGetClock(SYS_CPU));
+    printf("%-22s %7s %6s %8s\n", "", "frame", "ref", "pixops");
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+        bench(sizes[i].w, sizes[i].h);
+
+    while(1);
+}
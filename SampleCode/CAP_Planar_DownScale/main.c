@@ -4,6 +4,8 @@
  *           followed by all the information for one chroma channel,
  *           and then the information for the other chroma channel)
  *           to store captured image from NT99141 sensor to DDR.
+ *           Frames go through a ring of buffers with the CAP frame
+ *           queue, so the consumer never reads a buffer being captured.
  *
  * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
  *
@@ -12,19 +14,32 @@
 #include "sensor.h"
 #include "sys.h"
 #include "cap.h"
+#include "etimer.h"
 #include <stdio.h>
 
 #define SENSOR_NT99141  0x1
 #define SENSOR_NT99050  0x2
 #define SENSOR_GC0308   0x3
 
-/*------------------------------------------------------------------------------------------*/
-/* To run CAP_InterruptHandler, when CAP frame end interrupt                                */
-/*------------------------------------------------------------------------------------------*/
-volatile uint32_t u32FramePass = 0;
-void CAP_InterruptHandler(void)
+#define SENSOR_IN_WIDTH             640
+#define SENSOR_IN_HEIGHT            480
+#define SYSTEM_WIDTH                160
+#define SYSTEM_HEIGHT               120
+#define FRAME_BUFFERS               3
+#define CAP_INT_FLAGS               (CAP_INT_VINTF_Msk | CAP_INT_MEINTF_Msk | CAP_INT_ADDRMINTF_Msk | CAP_INT_MDINTF_Msk)
+
+#if defined (__GNUC__) && !(__CC_ARM)
+uint8_t u8FrameBuffer[FRAME_BUFFERS][SYSTEM_WIDTH*SYSTEM_HEIGHT*2] __attribute__((aligned(32)));
+#else
+__align(32) uint8_t u8FrameBuffer[FRAME_BUFFERS][SYSTEM_WIDTH*SYSTEM_HEIGHT*2];
+#endif
+
+CAP_FQ_T sFrameQueue;
+
+/* ETIMER0 counts microseconds, frames are stamped with it */
+static uint32_t usec(void)
 {
-    u32FramePass++;
+    return ETIMER_GetCounter(0);
 }
 
 /*------------------------------------------------------------------------------------------*/
@@ -33,29 +48,26 @@ void CAP_InterruptHandler(void)
 void CAP1_IRQHandler(void)
 {
     uint32_t u32CapInt;
-    u32CapInt = CAP1->INT;
-    if( (u32CapInt & (CAP_INT_VIEN_Msk | CAP_INT_VINTF_Msk )) == (CAP_INT_VIEN_Msk | CAP_INT_VINTF_Msk))
-    {
-        CAP_InterruptHandler();
-        CAP1->INT |= CAP_INT_VINTF_Msk;        /* Clear Frame end interrupt */
+
+    /* Frame end: queue the captured buffer and switch the engine to a free one */
+    if (CAP_FQ_IRQHandler(&sFrameQueue))
         u32EscapeFrame = u32EscapeFrame+1;
-    }
 
+    u32CapInt = CAP1->INT;
     if((u32CapInt & (CAP_INT_ADDRMIEN_Msk|CAP_INT_ADDRMINTF_Msk)) == (CAP_INT_ADDRMIEN_Msk|CAP_INT_ADDRMINTF_Msk))
     {
-        CAP1->INT |= CAP_INT_ADDRMINTF_Msk; /* Clear Address match interrupt */
+        CAP1->INT = (u32CapInt & ~CAP_INT_FLAGS) | CAP_INT_ADDRMINTF_Msk; /* Clear Address match interrupt */
     }
 
     if ((u32CapInt & (CAP_INT_MEIEN_Msk|CAP_INT_MEINTF_Msk)) == (CAP_INT_MEIEN_Msk|CAP_INT_MEINTF_Msk))
     {
-        CAP1->INT |= CAP_INT_MEINTF_Msk;    /* Clear Memory error interrupt */
+        CAP1->INT = (u32CapInt & ~CAP_INT_FLAGS) | CAP_INT_MEINTF_Msk;    /* Clear Memory error interrupt */
     }
 
     if ((u32CapInt & (CAP_INT_MDIEN_Msk|CAP_INT_MDINTF_Msk)) == (CAP_INT_MDIEN_Msk|CAP_INT_MDINTF_Msk))
     {
-        CAP1->INT |= CAP_INT_MDINTF_Msk;    /* Clear Motion Detection interrupt */
+        CAP1->INT = (u32CapInt & ~CAP_INT_FLAGS) | CAP_INT_MDINTF_Msk;    /* Clear Motion Detection interrupt */
     }
-    CAP1->CTL = CAP1->CTL | CAP_CTL_UPDATE;
 }
 
 void CAP_SetFreq(CAP_T *CAP,uint32_t u32ModFreqKHz,uint32_t u32SensorFreq)
@@ -142,15 +154,15 @@ void UART_Init()
     outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
 }
 
-#define SENSOR_IN_WIDTH             640
-#define SENSOR_IN_HEIGHT            480
-#define SYSTEM_WIDTH                160
-#define SYSTEM_HEIGHT               120
-__align(32) uint8_t u8FrameBuffer[SYSTEM_WIDTH*SYSTEM_HEIGHT*2];
-
 void PlanarFormatDownScale(uint32_t SensorId)
 {
-    uint32_t u32Frame;
+    CAP_FRAME_T *psFrame;
+    uint32_t i, u32Sum, u32Last = 0;
+
+    /* Three buffers: one captured into, one ready, one held by the consumer */
+    CAP_FQ_Init(&sFrameQueue, CAP1, (uint32_t)u8FrameBuffer, FRAME_BUFFERS,
+                SYSTEM_WIDTH*SYSTEM_HEIGHT, SYSTEM_WIDTH*SYSTEM_HEIGHT/2, CAP_FQ_DROP_OLD);
+    CAP_FQ_SetClock(&sFrameQueue, usec);
 
     /* Enable External CAP Interrupt */
     CAP_EnableInt(CAP1,CAP_INT_VIEN_Msk);
@@ -164,28 +176,28 @@ void PlanarFormatDownScale(uint32_t SensorId)
     /* Set Cropping Window Vertical/Horizontal Starting Address and Cropping Window Size */
     CAP_SetCroppingWindow(CAP1,0,0,SENSOR_IN_HEIGHT,SENSOR_IN_WIDTH);
 
-    /* Set System Memory Packet Base Address Register */
-    CAP_SetPlanarBuf(CAP1,(uint32_t)u8FrameBuffer,
-                     (uint32_t)u8FrameBuffer+(SYSTEM_WIDTH*SYSTEM_HEIGHT),
-                     (uint32_t)u8FrameBuffer+(SYSTEM_WIDTH*SYSTEM_HEIGHT)+(SYSTEM_WIDTH*SYSTEM_HEIGHT/2));
-
-    /* Set Packet Scaling Vertical/Horizontal Factor Register */
-    CAP_SetPacketScaling(CAP1,SYSTEM_HEIGHT,SENSOR_IN_HEIGHT,SYSTEM_WIDTH,SENSOR_IN_WIDTH);
+    /* Set Planar Scaling Vertical/Horizontal Factor Register */
+    CAP_SetPlanarScaling(CAP1,SYSTEM_HEIGHT,SENSOR_IN_HEIGHT,SYSTEM_WIDTH,SENSOR_IN_WIDTH);
 
-    /* Set Packet Frame Output Pixel Stride Width */
-    CAP_SetPacketStride(CAP1,SYSTEM_WIDTH);
+    /* Set Planar Frame Output Pixel Stride Width */
+    CAP_SetPlanarStride(CAP1,SYSTEM_WIDTH);
 
-    /* Start Image Capture Interface  */
-    CAP_Start(CAP1);
+    /* Point the engine at the first buffer and start Image Capture Interface */
+    CAP_FQ_Start(&sFrameQueue);
 
-    u32Frame=u32FramePass;
     while(1)
     {
-        if(u32Frame!=u32FramePass)
-        {
-            u32Frame=u32FramePass;
-            printf("Get frame %3d\n",u32Frame);
-        }
+        psFrame = CAP_FQ_Dequeue(&sFrameQueue);
+        if(psFrame == NULL)
+            continue;
+
+        /* The buffer is ours until it is queued back, read it in place */
+        for(i = 0, u32Sum = 0; i < SYSTEM_WIDTH*SYSTEM_HEIGHT; i += 4)
+            u32Sum += *(uint32_t *)(psFrame->au32Addr[0] + i);
+        printf("Get frame %3d in buffer %d, %6d us, Y sum 0x%08x, dropped %d\n", psFrame->u32Seq, psFrame->u32Index,
+               (psFrame->u32Time - u32Last) & 0xFFFFFF, u32Sum, sFrameQueue.u32Dropped);
+        u32Last = psFrame->u32Time;
+        CAP_FQ_Queue(&sFrameQueue, psFrame);
     }
 
 }
@@ -207,6 +219,13 @@ int32_t main (void)
 
     printf("\nThis sample code demonstrate CAP packet down scale function\n");
 
+    // Enable ETIMER0 engine clock, free running counter at 1 MHz
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 8));
+    ETIMER_Open(0, ETIMER_CONTINUOUS_MODE, 1000000);
+    ETIMER_SET_PRESCALE_VALUE(0, 11);
+    ETIMER_SET_CMP_VALUE(0, 0xFFFFFF);
+    ETIMER_Start(0);
+
     sysInstallISR(IRQ_LEVEL_1, IRQ_CAP1, (PVOID)CAP1_IRQHandler);
     sysSetLocalInterrupt(ENABLE_IRQ);
     sysEnableInterrupt(IRQ_CAP1);
@@ -0,0 +1,313 @@
+/*-----------------------------------------------------------------------*/
+/* Low level disk I/O module skeleton for FatFs     (C)ChaN, 2013        */
+/*-----------------------------------------------------------------------*/
+/* If a working storage control module is available, it should be        */
+/* attached to the FatFs via a glue function rather than modifying it.   */
+/* This is an example of glue functions to attach various exsisting      */
+/* storage control module to the FatFs module with a defined API.        */
+/*-----------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nuc980.h"
+#include "sys.h"
+#include "sdh.h"
+#include "ff.h"
+#include "diskio.h"
+#include "ffcache.h"
+
+
+#define SD0_DRIVE       0        /* for SD0          */
+#define SD1_DRIVE       1        /* for SD1          */
+#define EMMC_DRIVE      2        /* for eMMC/NAND    */
+#define USBH_DRIVE_0    3        /* USB Mass Storage */
+#define USBH_DRIVE_1    4        /* USB Mass Storage */
+#define USBH_DRIVE_2    5        /* USB Mass Storage */
+#define USBH_DRIVE_3    6        /* USB Mass Storage */
+#define USBH_DRIVE_4    7        /* USB Mass Storage */
+
+#define FATFS_BOUNCE_SECTORS    32      /* Sectors moved per SDH command for cacheable buffers */
+
+#if defined (__GNUC__) && !(__CC_ARM)
+static __attribute__((aligned(32))) BYTE  fatfs_win_buff_pool[FATFS_BOUNCE_SECTORS * _MAX_SS] ;       /* FATFS window buffer is cacheable. Must not use it directly. */
+#else
+static __align(32) BYTE  fatfs_win_buff_pool[FATFS_BOUNCE_SECTORS * _MAX_SS] ;       /* FATFS window buffer is cacheable. Must not use it directly. */
+#endif
+BYTE  *fatfs_win_buff;
+
+/* Definitions of physical drive number for each media */
+
+#define DRV_SD0     0
+#define DRV_SD1     1
+
+static DRESULT sd_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count);
+static DRESULT sd_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count);
+
+static FFC_DEV  sd_dev = { sd_read, sd_write, 0, FATFS_BOUNCE_SECTORS };
+static BYTE     sd_attached;        /* Bit n set: drive n is attached to the sector cache */
+
+/* Attach the SD drive to the sector cache. Cached sectors of a previous card are dropped. */
+static void sd_attach(BYTE pdrv)
+{
+    /* The non-cacheable bounce pool doubles as the cache staging buffer */
+    sd_dev.stage = (BYTE *)((unsigned int)fatfs_win_buff_pool | 0x80000000);
+    ffc_attach(pdrv, &sd_dev, (pdrv == DRV_SD0) ? SD0.totalSectorN : SD1.totalSectorN);
+    sd_attached |= (1 << pdrv);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Initialize a Drive                                                    */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS disk_initialize (BYTE pdrv)       /* Physical drive number (0..) */
+{
+
+    switch (pdrv)
+    {
+    case DRV_SD0 :
+        if (SDH_GET_CARD_CAPACITY(SDH0) == 0)
+            return STA_NOINIT;
+        break;
+
+    case DRV_SD1 :
+        if (SDH_GET_CARD_CAPACITY(SDH1) == 0)
+            return STA_NOINIT;
+        break;
+
+    default:
+        return STA_NOINIT;
+    }
+    sd_attach(pdrv);
+    return RES_OK;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Get Disk Status                                                       */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS disk_status (BYTE pdrv)       /* Physical drive number (0..) */
+{
+
+    switch (pdrv)
+    {
+    case DRV_SD0 :
+        if (SDH_GET_CARD_CAPACITY(SDH0) == 0)
+            return STA_NOINIT;
+        break;
+
+    case DRV_SD1 :
+        if (SDH_GET_CARD_CAPACITY(SDH1) == 0)
+            return STA_NOINIT;
+        break;
+    }
+    return RES_OK;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Read Sector(s) from the card                                          */
+/*-----------------------------------------------------------------------*/
+
+static DRESULT sd_read (
+    BYTE pdrv,      /* Physical drive number (0..) */
+    BYTE *buff,     /* Data buffer to store read data */
+    DWORD sector,   /* Sector address (LBA) */
+    UINT count      /* Number of sectors to read */
+)
+{
+    DRESULT   ret;
+    outpw(REG_SDH_GCTL, SDH_GCTL_SDEN_Msk);
+    //printf("disk_read - drv:%d, sec:%d, cnt:%d, buff:0x%x\n", pdrv, sector, count, (UINT32)buff);
+
+    if (!((UINT32)buff & 0x80000000) && ((UINT32)buff & (SYS_DCACHE_LINE_SIZE - 1)))
+    {
+        /* Disk read buffer is cacheable and shares D-cache lines with other data. Use my non-cacheable to do disk read.
+           Line aligned buffers go straight to SDH, which maintains the D-cache for them. */
+        UINT    n;
+
+        //fatfs_win_buff = (BYTE *)((unsigned int)fatfs_win_buff_pool);
+        fatfs_win_buff = (BYTE *)((unsigned int)fatfs_win_buff_pool | 0x80000000);
+        ret = RES_OK;
+        while (count && (ret == RES_OK))
+        {
+            n = (count > FATFS_BOUNCE_SECTORS) ? FATFS_BOUNCE_SECTORS : count;
+            if (pdrv == DRV_SD0)
+                ret = (DRESULT) SDH_Read(SDH0, fatfs_win_buff, sector, n);
+            else if (pdrv == DRV_SD1)
+                ret = (DRESULT) SDH_Read(SDH1, fatfs_win_buff, sector, n);
+            else
+                return RES_ERROR;
+            sysMemCopy(buff, fatfs_win_buff, n * 512);
+            buff += n * 512;
+            sector += n;
+            count -= n;
+        }
+    }
+    else
+    {
+        if (pdrv == DRV_SD0)
+            ret = (DRESULT) SDH_Read(SDH0, buff, sector, count);
+        else if (pdrv == DRV_SD1)
+            ret = (DRESULT) SDH_Read(SDH1, buff, sector, count);
+        else
+            return RES_ERROR;
+    }
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Write Sector(s) to the card                                           */
+/*-----------------------------------------------------------------------*/
+
+static DRESULT sd_write (
+    BYTE pdrv,          /* Physical drive number (0..) */
+    const BYTE *buff,   /* Data to be written */
+    DWORD sector,       /* Sector address (LBA) */
+    UINT count          /* Number of sectors to write */
+)
+{
+    DRESULT   ret;
+
+    outpw(REG_SDH_GCTL, SDH_GCTL_SDEN_Msk);
+    //printf("disk_write - drv:%d, sec:%d, cnt:%d, buff:0x%x\n", pdrv, sector, count, (UINT32)buff);
+
+    if (!((UINT32)buff & 0x80000000) && ((UINT32)buff & (SYS_DCACHE_LINE_SIZE - 1)))
+    {
+        /* Disk write buffer is cacheable and shares D-cache lines with other data. Use my non-cacheable to do disk write.
+           Line aligned buffers go straight to SDH, which maintains the D-cache for them. */
+        UINT    n;
+
+        fatfs_win_buff = (BYTE *)((unsigned int)fatfs_win_buff_pool | 0x80000000);
+        ret = RES_OK;
+        while (count && (ret == RES_OK))
+        {
+            n = (count > FATFS_BOUNCE_SECTORS) ? FATFS_BOUNCE_SECTORS : count;
+            sysMemCopy(fatfs_win_buff, buff, n * 512);
+            if (pdrv == DRV_SD0)
+                ret = (DRESULT) SDH_Write(SDH0, fatfs_win_buff, sector, n);
+            else if (pdrv == DRV_SD1)
+                ret = (DRESULT) SDH_Write(SDH1, fatfs_win_buff, sector, n);
+            else
+                return RES_ERROR;
+            buff += n * 512;
+            sector += n;
+            count -= n;
+        }
+    }
+    else
+    {
+        if (pdrv == DRV_SD0)
+            ret = (DRESULT) SDH_Write(SDH0, (UINT8 *)buff, sector, count);
+        else if (pdrv == DRV_SD1)
+            ret = (DRESULT) SDH_Write(SDH1, (UINT8 *)buff, sector, count);
+        else
+            return RES_ERROR;
+    }
+    return ret;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Read Sector(s)                                                        */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_read (
+    BYTE pdrv,      /* Physical drive number (0..) */
+    BYTE *buff,     /* Data buffer to store read data */
+    DWORD sector,   /* Sector address (LBA) */
+    UINT count      /* Number of sectors to read (1..128) */
+)
+{
+    if ((pdrv > DRV_SD1) || (disk_status(pdrv) & STA_NOINIT))
+        return RES_NOTRDY;
+    if (!(sd_attached & (1 << pdrv)))
+        sd_attach(pdrv);
+    return ffc_read(pdrv, buff, sector, count);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Write Sector(s)                                                       */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_write (
+    BYTE pdrv,          /* Physical drive number (0..) */
+    const BYTE *buff,   /* Data to be written */
+    DWORD sector,       /* Sector address (LBA) */
+    UINT count          /* Number of sectors to write (1..128) */
+)
+{
+    if ((pdrv > DRV_SD1) || (disk_status(pdrv) & STA_NOINIT))
+        return RES_NOTRDY;
+    if (!(sd_attached & (1 << pdrv)))
+        sd_attach(pdrv);
+    return ffc_write(pdrv, buff, sector, count);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Miscellaneous Functions                                               */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_ioctl (
+    BYTE pdrv,      /* Physical drive number (0..) */
+    BYTE cmd,       /* Control code */
+    void *buff      /* Buffer to send/receive control data */
+)
+{
+
+    DRESULT res = RES_OK;
+
+    switch (pdrv)
+    {
+    case DRV_SD0 :
+        switch(cmd)
+        {
+        case CTRL_SYNC:
+            res = ffc_sync(pdrv);
+            break;
+        case GET_SECTOR_COUNT:
+            *(DWORD*)buff = SD0.totalSectorN;
+            break;
+        case GET_SECTOR_SIZE:
+            *(WORD*)buff = SD0.sectorSize;
+            break;
+
+        default:
+            res = RES_PARERR;
+            break;
+        }
+        break;
+
+    case DRV_SD1 :
+        switch(cmd)
+        {
+        case CTRL_SYNC:
+            res = ffc_sync(pdrv);
+            break;
+        case GET_SECTOR_COUNT:
+            *(DWORD*)buff = SD1.totalSectorN;
+            break;
+        case GET_SECTOR_SIZE:
+            *(WORD*)buff = SD1.sectorSize;
+            break;
+
+        default:
+            res = RES_PARERR;
+            break;
+        }
+        break;
+
+    default:
+        res = RES_PARERR;
+        break;
+
+    }
+    return res;
+}
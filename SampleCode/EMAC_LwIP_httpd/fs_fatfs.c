@@ -0,0 +1,398 @@
+/**************************************************************************//**
+ * @file     fs_fatfs.c
+ * @brief    lwIP httpd custom file system serving files from a FatFs volume
+ *
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "nuc980.h"
+#include "sys.h"
+#include "ff.h"
+#include "lwip/def.h"
+#include "lwip/sys.h"
+#include "lwip/apps/fs.h"
+#include "fs_fatfs.h"
+
+#define FSF_REQ_IDLE        0   /* No read in progress */
+#define FSF_REQ_PENDING     1   /* Read queued for fsf_poll() */
+#define FSF_REQ_BUSY        2   /* fsf_poll() is reading */
+#define FSF_REQ_DONE        3   /* Read finished, result not collected yet */
+
+typedef struct
+{
+    char    uri[FSF_NAME_LEN];  /* e.g. "/img/logo.gif" */
+    DWORD   size;
+    char    etag[32];           /* "ETag: \"<size>-<date><time>\"\r\n" */
+} FSF_ENTRY;
+
+typedef struct
+{
+    FIL             fil;
+    const FSF_ENTRY *ent;
+    volatile u8_t   used;       /* Allocated by fs_open_custom() */
+    volatile u8_t   closed;     /* Closed by httpd, freed by fsf_poll() */
+    volatile u8_t   req;        /* FSF_REQ_xxx */
+    volatile u8_t   ahead;      /* The read is a read-ahead nobody waits for */
+    u8_t            opened;     /* fil is open */
+    int             block;      /* Block read into, -1 while waiting for a free one */
+    int             len;        /* Bytes to read, bytes read or -1 on error */
+    int             ofs;        /* Bytes of the block copied by fs_read_async_custom() */
+    fs_wait_cb      cb;         /* Called when the read is finished */
+    void            *arg;
+} FSF_FILE;
+
+#if defined (__GNUC__) && !(__CC_ARM)
+static __attribute__((aligned(32))) BYTE  fsf_block_pool[FSF_BLOCKS][FSF_BLOCK_SIZE];
+#else
+static __align(32) BYTE  fsf_block_pool[FSF_BLOCKS][FSF_BLOCK_SIZE];
+#endif
+
+static FSF_ENTRY    fsf_index[FSF_MAX_ENTRIES];
+static int          fsf_entries;
+static FSF_FILE     fsf_files[FSF_MAX_OPEN];
+static u32_t        fsf_block_used;     /* Bit n set: block n is in use */
+static FSF_STAT     fsf_stat;
+
+
+/* Blocks are cacheable and line aligned: SDH DMA writes them directly and keeps
+   the D-cache coherent, lwIP checksums and copies them at cached speed */
+static char *fsf_block(int n)
+{
+    return (char *)fsf_block_pool[n];
+}
+
+static int fsf_block_alloc(int reserve)
+{
+    int     i, nfree = 0, n = -1;
+
+    for (i = 0; i < FSF_BLOCKS; i++)
+    {
+        if (!(fsf_block_used & (1UL << i)))
+        {
+            if (n < 0)
+                n = i;
+            nfree++;
+        }
+    }
+    if (nfree <= reserve)
+        return -1;
+    fsf_block_used |= (1UL << n);
+    return n;
+}
+
+static void fsf_block_free(int n)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    fsf_block_used &= ~(1UL << n);
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+
+/*---------------------------------------------------------------------------*/
+/* Index the web root                                                        */
+/*---------------------------------------------------------------------------*/
+
+static void fsf_scan(char *path, int len, int root_len)
+{
+    DIR     dir;
+    FILINFO fno;
+    int     n;
+
+    if (f_opendir(&dir, path) != FR_OK)
+        return;
+    while ((f_readdir(&dir, &fno) == FR_OK) && fno.fname[0])
+    {
+        if (fno.fname[0] == '.')
+            continue;
+        n = len + 1 + strlen(fno.fname);
+        if (n - root_len >= FSF_NAME_LEN)
+            continue;
+        path[len] = '/';
+        strcpy(&path[len + 1], fno.fname);
+        if (fno.fattrib & AM_DIR)
+        {
+            fsf_scan(path, n, root_len);
+        }
+        else if (fsf_entries < FSF_MAX_ENTRIES)
+        {
+            FSF_ENTRY *e = &fsf_index[fsf_entries++];
+
+            strcpy(e->uri, &path[root_len]);
+            e->size = fno.fsize;
+            sprintf(e->etag, "ETag: \"%lx-%04x%04x\"\r\n", (unsigned long)fno.fsize, fno.fdate, fno.ftime);
+        }
+        path[len] = 0;
+    }
+    f_closedir(&dir);
+}
+
+/**
+ *  @brief  Index the files below FSF_ROOT. The volume must be mounted.
+ *  @return Number of files found
+ */
+int fsf_mount(void)
+{
+    char    path[sizeof(FSF_ROOT) + FSF_NAME_LEN];
+
+    fsf_entries = 0;
+    strcpy(path, FSF_ROOT);
+    fsf_scan(path, strlen(path), strlen(path));
+    return fsf_entries;
+}
+
+
+/*---------------------------------------------------------------------------*/
+/* Read files in the main loop                                               */
+/*---------------------------------------------------------------------------*/
+
+static void fsf_read(FSF_FILE *f)
+{
+    char    path[sizeof(FSF_ROOT) + FSF_NAME_LEN];
+    UINT    br;
+
+    if (!f->opened)
+    {
+        strcpy(path, FSF_ROOT);
+        strcat(path, f->ent->uri);
+        if (f_open(&f->fil, path, FA_READ) != FR_OK)
+        {
+            f->len = -1;
+            return;
+        }
+        f->opened = 1;
+    }
+    fsf_stat.rdcmd++;
+    if ((f_read(&f->fil, fsf_block(f->block), f->len, &br) != FR_OK) || (br == 0))
+        f->len = -1;
+    else
+        f->len = br;
+}
+
+/**
+ *  @brief  Serve pending reads, read ahead and free closed files.
+ *          Call it from the main loop.
+ */
+void fsf_poll(void)
+{
+    FSF_FILE    *f;
+    int         i, n;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    for (i = 0; i < FSF_MAX_OPEN; i++)
+    {
+        f = &fsf_files[i];
+        if (!f->used)
+            continue;
+
+        SYS_ARCH_PROTECT(lev);
+        if (f->closed)
+        {
+            SYS_ARCH_UNPROTECT(lev);
+            if (f->opened)
+                f_close(&f->fil);
+            if ((f->req != FSF_REQ_IDLE) && (f->block >= 0))
+                fsf_block_free(f->block);
+            f->used = 0;
+            continue;
+        }
+        if ((f->req == FSF_REQ_IDLE) && f->opened && (f_tell(&f->fil) < f_size(&f->fil)))
+        {
+            /* Read the next block ahead, keep a few blocks for other connections */
+            n = fsf_block_alloc(2);
+            if (n >= 0)
+            {
+                f->block = n;
+                f->len = LWIP_MIN(FSF_BLOCK_SIZE, f_size(&f->fil) - f_tell(&f->fil));
+                f->cb = NULL;
+                f->ahead = 1;
+                f->req = FSF_REQ_PENDING;
+            }
+        }
+        if ((f->req == FSF_REQ_PENDING) && (f->block < 0))
+            f->block = fsf_block_alloc(0);
+        if ((f->req != FSF_REQ_PENDING) || (f->block < 0))
+        {
+            SYS_ARCH_UNPROTECT(lev);
+            continue;
+        }
+        f->req = FSF_REQ_BUSY;
+        SYS_ARCH_UNPROTECT(lev);
+
+        fsf_read(f);
+
+        /* Continue the connection unless httpd has closed the file meanwhile */
+        SYS_ARCH_PROTECT(lev);
+        f->req = FSF_REQ_DONE;
+        if (!f->closed && !f->ahead && (f->cb != NULL))
+            f->cb(f->arg);
+        SYS_ARCH_UNPROTECT(lev);
+    }
+}
+
+/**
+ *  @brief  Get statistics
+ *  @param[out] st      Statistics since the last reset
+ *  @param[in]  reset   Clear the counters
+ */
+void fsf_get_stat(FSF_STAT *st, int reset)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    *st = fsf_stat;
+    if (reset)
+        memset(&fsf_stat, 0, sizeof(fsf_stat));
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+
+/*---------------------------------------------------------------------------*/
+/* httpd custom file system, called from lwIP                                */
+/*---------------------------------------------------------------------------*/
+
+int fs_open_custom(struct fs_file *file, const char *name)
+{
+    FSF_FILE    *f;
+    int         i;
+
+    for (i = 0; i < fsf_entries; i++)
+    {
+        if (!lwip_stricmp(fsf_index[i].uri, name))
+            break;
+    }
+    if (i == fsf_entries)
+        return 0;
+
+    for (f = fsf_files; f < &fsf_files[FSF_MAX_OPEN]; f++)
+    {
+        if (!f->used)
+            break;
+    }
+    if (f == &fsf_files[FSF_MAX_OPEN])
+    {
+        fsf_stat.nofile++;
+        return 0;
+    }
+    memset(f, 0, sizeof(FSF_FILE));
+    f->ent = &fsf_index[i];
+    f->block = -1;
+    f->used = 1;
+    fsf_stat.open++;
+
+    file->data = NULL;
+    file->len = f->ent->size;
+    file->index = 0;
+    file->pextension = f;
+    file->flags = 0;            /* httpd adds the headers */
+    file->etag = f->ent->etag;
+    return 1;
+}
+
+void fs_close_custom(struct fs_file *file)
+{
+    FSF_FILE    *f = (FSF_FILE *)file->pextension;
+
+    f->closed = 1;
+}
+
+/* Queue a read for fsf_poll(). Without a free block it waits for one. */
+static int fsf_queue(FSF_FILE *f, int count, fs_wait_cb callback_fn, void *callback_arg)
+{
+    f->block = fsf_block_alloc(0);
+    f->len = LWIP_MIN(count, FSF_BLOCK_SIZE);
+    f->ofs = 0;
+    f->cb = callback_fn;
+    f->arg = callback_arg;
+    f->ahead = 0;
+    f->req = FSF_REQ_PENDING;
+    return FS_READ_DELAYED;
+}
+
+int fs_read_nocopy_async_custom(struct fs_file *file, const char **buffer, int count, fs_wait_cb callback_fn, void *callback_arg)
+{
+    FSF_FILE    *f = (FSF_FILE *)file->pextension;
+
+    if (f->req == FSF_REQ_DONE)
+    {
+        f->req = FSF_REQ_IDLE;
+        if (f->len <= 0)
+        {
+            fsf_block_used &= ~(1UL << f->block);
+            return FS_READ_EOF;
+        }
+        /* The block belongs to httpd until fs_release_nocopy_custom() */
+        *buffer = fsf_block(f->block);
+        file->index += f->len;
+        fsf_stat.lent += f->len;
+        return f->len;
+    }
+    if (f->req != FSF_REQ_IDLE)
+    {
+        /* A read-ahead is in progress: wait for it */
+        f->cb = callback_fn;
+        f->arg = callback_arg;
+        f->ahead = 0;
+        return FS_READ_DELAYED;
+    }
+    return fsf_queue(f, count, callback_fn, callback_arg);
+}
+
+void fs_release_nocopy_custom(const char *buffer)
+{
+    fsf_block_used &= ~(1UL << ((buffer - fsf_block(0)) / FSF_BLOCK_SIZE));
+}
+
+int fs_read_async_custom(struct fs_file *file, char *buffer, int count, fs_wait_cb callback_fn, void *callback_arg)
+{
+    FSF_FILE    *f = (FSF_FILE *)file->pextension;
+    int         n;
+
+    if (f->req == FSF_REQ_DONE)
+    {
+        if (f->len <= 0)
+        {
+            f->req = FSF_REQ_IDLE;
+            fsf_block_used &= ~(1UL << f->block);
+            return FS_READ_EOF;
+        }
+        n = LWIP_MIN(count, f->len - f->ofs);
+        memcpy(buffer, fsf_block(f->block) + f->ofs, n);
+        f->ofs += n;
+        if (f->ofs == f->len)
+        {
+            f->req = FSF_REQ_IDLE;
+            fsf_block_used &= ~(1UL << f->block);
+        }
+        file->index += n;
+        fsf_stat.copied += n;
+        return n;
+    }
+    if (f->req != FSF_REQ_IDLE)
+    {
+        f->cb = callback_fn;
+        f->arg = callback_arg;
+        f->ahead = 0;
+        return FS_READ_DELAYED;
+    }
+    return fsf_queue(f, count, callback_fn, callback_arg);
+}
+
+u8_t fs_canread_custom(struct fs_file *file)
+{
+    FSF_FILE    *f = (FSF_FILE *)file->pextension;
+
+    return (f->req == FSF_REQ_IDLE) || (f->req == FSF_REQ_DONE) || f->ahead;
+}
+
+u8_t fs_wait_read_custom(struct fs_file *file, fs_wait_cb callback_fn, void *callback_arg)
+{
+    FSF_FILE    *f = (FSF_FILE *)file->pextension;
+
+    f->cb = callback_fn;
+    f->arg = callback_arg;
+    return 1;
+}
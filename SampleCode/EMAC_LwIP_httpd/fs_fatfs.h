@@ -0,0 +1,50 @@
+/**************************************************************************//**
+ * @file     fs_fatfs.h
+ * @brief    lwIP httpd custom file system serving files from a FatFs volume
+ *
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __FS_FATFS_H__
+#define __FS_FATFS_H__
+
+#include "lwip/arch.h"
+
+/*
+ * Files below FSF_ROOT are indexed once by fsf_mount(). The index holds the
+ * size and a precomputed "ETag:" header line of every file, so fs_open()
+ * does no disk access and runs from the EMAC interrupt like the rest of lwIP.
+ *
+ * File data is read in the main loop by fsf_poll(): httpd asks for the next
+ * block, gets FS_READ_DELAYED and is called back when the block is read.
+ * Blocks are FSF_BLOCK_SIZE bytes at block aligned file offsets, so FatFs
+ * transfers them straight from the card into the block pool and httpd
+ * hands them to tcp_write() without copying. A block returns to
+ * the pool when the peer has acknowledged it. When httpd cannot lend a block
+ * (its send queue is full of lent blocks), the data is copied out of the
+ * block into the httpd buffer instead.
+ *
+ * FatFs is only called from fsf_poll(). Names on the card are 8.3 names and
+ * are matched without case.
+ */
+
+#define FSF_ROOT            "1:/www"    /* Web root on the SD card */
+#define FSF_BLOCK_SIZE      (16 * 512)  /* Bytes per lent block, multiple of the sector size */
+#define FSF_BLOCKS          16          /* Blocks in the pool */
+#define FSF_MAX_OPEN        8           /* Open files, one per connection */
+#define FSF_MAX_ENTRIES     64          /* Files in the index */
+#define FSF_NAME_LEN        48          /* Longest URI including the terminating NUL */
+
+typedef struct
+{
+    u32_t   open;       /* Files opened */
+    u32_t   lent;       /* Bytes lent to tcp_write() */
+    u32_t   copied;     /* Bytes read into httpd buffers */
+    u32_t   rdcmd;      /* f_read() calls */
+    u32_t   nofile;     /* Opens failed for lack of file objects */
+} FSF_STAT;
+
+int  fsf_mount(void);
+void fsf_poll(void);
+void fsf_get_stat(FSF_STAT *st, int reset);
+
+#endif /* __FS_FATFS_H__ */
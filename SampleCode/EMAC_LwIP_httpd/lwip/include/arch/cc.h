@@ -106,6 +106,4 @@ typedef u32_t sys_prot_t;
 
 
 #define LWIP_PROVIDE_ERRNO  1
-
-#define TCP_MSS                         1000
 #endif /* __CC_H__ */
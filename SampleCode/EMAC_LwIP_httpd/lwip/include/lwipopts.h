@@ -52,4 +52,31 @@
 // Needs 2 more for detect EMAC link status
 #define MEMP_NUM_SYS_TIMEOUT            2 + (LWIP_TCP + IP_REASSEMBLY + LWIP_ARP + (2*LWIP_DHCP) + LWIP_AUTOIP + LWIP_IGMP + LWIP_DNS + (PPP_SUPPORT*6*MEMP_NUM_PPP_PCB) + (LWIP_IPV6 ? (1 + LWIP_IPV6_REASS + LWIP_IPV6_MLD) : 0))
 
+// TCP sized for streaming files, up to 8 segments in flight per connection
+#define MEM_SIZE                        (32 * 1024)
+#define TCP_MSS                         1460
+#define TCP_WND                         (4 * TCP_MSS)
+#define TCP_SND_BUF                     (8 * TCP_MSS)
+#define TCP_SND_QUEUELEN                (4 * TCP_SND_BUF / TCP_MSS)
+#define MEMP_NUM_TCP_PCB                8
+#define MEMP_NUM_TCP_SEG                64
+#define MEMP_NUM_PBUF                   64
+
+// httpd serves files from the SD card (fs_fatfs.c), see fs_fatfs.h
+#define LWIP_HTTPD_CUSTOM_FILES         1
+#define LWIP_HTTPD_DYNAMIC_FILE_READ    1
+#define LWIP_HTTPD_FS_ASYNC_READ        1
+#define LWIP_HTTPD_FS_ZEROCOPY          1
+#define LWIP_HTTPD_DYNAMIC_HEADERS      1
+#define LWIP_HTTPD_ETAG                 1
+#define LWIP_HTTPD_SUPPORT_11_KEEPALIVE 1
+#define HTTPD_LIMIT_SENDING_TO_2MSS     0
+
+// Copies and checksums use the LDM/STM kernels of the SYS driver (memops.c).
+// Segment checksums are computed while tcp_write() copies the data.
+#define MEMCPY(dst,src,len)             sysMemCopy(dst,src,len)
+#define LWIP_CHKSUM                     sysChksum
+#define LWIP_CHECKSUM_ON_COPY           1
+#define LWIP_CHKSUM_COPY(dst,src,len)   sysChksumCopy(dst,src,len)
+
 #endif /* __LWIPOPTS_H__ */
@@ -73,7 +73,7 @@
 #define RX_DESCRIPTOR_NUM 4    // Max Number of Rx Frame Descriptors
 #define TX_DESCRIPTOR_NUM 4    // Max number of Tx Frame Descriptors
 
-#define PACKET_BUFFER_SIZE  1520
+#define PACKET_BUFFER_SIZE  1536    // Multiple of the 32-byte D-cache line
 
 #define CONFIG_PHY_ADDR     1
 
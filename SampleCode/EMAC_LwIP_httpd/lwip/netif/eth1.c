@@ -24,8 +24,8 @@ static struct eth_descriptor tx_desc[TX_DESCRIPTOR_NUM] __attribute__ ((aligned(
 
 static struct eth_descriptor volatile *cur_tx_desc_ptr, *cur_rx_desc_ptr, *fin_tx_desc_ptr;
 
-static u8_t rx_buf[RX_DESCRIPTOR_NUM][PACKET_BUFFER_SIZE];
-static u8_t tx_buf[TX_DESCRIPTOR_NUM][PACKET_BUFFER_SIZE];
+static u8_t rx_buf[RX_DESCRIPTOR_NUM][PACKET_BUFFER_SIZE] __attribute__ ((aligned(32)));
+static u8_t tx_buf[TX_DESCRIPTOR_NUM][PACKET_BUFFER_SIZE] __attribute__ ((aligned(32)));
 static int plugged = 0;
 
 extern void ethernetif_input1(u16_t len, u8_t *buf);
@@ -134,7 +134,7 @@ static void init_tx_desc(void)
     for(i = 0; i < TX_DESCRIPTOR_NUM; i++)
     {
         tx_desc[i].status1 = TXFD_PADEN | TXFD_CRCAPP | TXFD_INTEN;
-        tx_desc[i].buf = (unsigned char *)((UINT)(&tx_buf[i][0]) | 0x80000000);
+        tx_desc[i].buf = &tx_buf[i][0];    // Cacheable, cleaned in ETH1_trigger_tx()
         tx_desc[i].status2 = 0;
         tx_desc[i].next = (struct eth_descriptor *)((UINT)(&tx_desc[(i + 1) % TX_DESCRIPTOR_NUM]) | 0x80000000);
     }
@@ -152,7 +152,7 @@ static void init_rx_desc(void)
     for(i = 0; i < RX_DESCRIPTOR_NUM; i++)
     {
         rx_desc[i].status1 = OWNERSHIP_EMAC;
-        rx_desc[i].buf = (unsigned char *)((UINT)(&rx_buf[i][0]) | 0x80000000);
+        rx_desc[i].buf = &rx_buf[i][0];    // Cacheable, invalidated before it is read
         rx_desc[i].status2 = 0;
         rx_desc[i].next = (struct eth_descriptor *)((UINT)(&rx_desc[(i + 1) % RX_DESCRIPTOR_NUM]) | 0x80000000);
     }
@@ -203,6 +203,7 @@ void ETH1_RX_IRQHandler(void)
 
         if (status & RXFD_RXGD)
         {
+            sysInvalidateDCacheRange((UINT)cur_rx_desc_ptr->buf, status & 0xFFFF);
             ethernetif_input1(status & 0xFFFF, cur_rx_desc_ptr->buf);
         }
 
@@ -216,7 +217,7 @@ void ETH1_RX_IRQHandler(void)
 
 }
 
-void ETH1_TX_IRQHandler(void)
+SYS_FASTCODE void ETH1_TX_IRQHandler(void)
 {
     unsigned int cur_entry, status;
 
@@ -281,7 +282,10 @@ void ETH1_init(u8_t *mac_addr)
 
     init_tx_desc();
     init_rx_desc();
-    sysFlushCache(D_CACHE);
+    // Descriptors are used through the non-cacheable shadow from now on
+    sysCleanInvalidateDCacheRange((UINT)tx_desc, sizeof(tx_desc));
+    sysCleanInvalidateDCacheRange((UINT)rx_desc, sizeof(rx_desc));
+    sysInvalidateDCacheRange((UINT)rx_buf, sizeof(rx_buf));
     set_mac_addr(mac_addr);  // need to reconfigure hardware address 'cos we just RESET emc...
     reset_phy();
 
@@ -311,6 +315,7 @@ u8_t *ETH1_get_tx_buf(void)
 void ETH1_trigger_tx(u16_t length, struct pbuf *p)
 {
     struct eth_descriptor volatile *desc;
+    sysCleanDCacheRange((UINT)cur_tx_desc_ptr->buf, length);
     cur_tx_desc_ptr->status2 = (unsigned int)length;
     desc = cur_tx_desc_ptr->next;    // in case TX is transmitting and overwrite next pointer before we can update cur_tx_desc_ptr
     cur_tx_desc_ptr->status1 |= OWNERSHIP_EMAC;
@@ -66,6 +66,10 @@ struct netif *_netif1;
 /*__weak*/ extern u8_t my_mac_addr0[6];
 /*__weak*/ extern u8_t my_mac_addr1[6];
 
+/* Frame copies between pbufs and the descriptor buffers, both interfaces */
+SYS_PROF_DEFINE(s_sProfRx, "emac rx")
+SYS_PROF_DEFINE(s_sProfTx, "emac tx")
+
 /**
  * Helper struct to hold private data used to operate your ethernet interface.
  * Keeping the ethernet address of the MAC in this struct is not necessary
@@ -197,17 +201,19 @@ low_level_output0(struct netif *netif, struct pbuf *p)
     buf = ETH0_get_tx_buf();
     if(buf == NULL)
         return ERR_MEM;
+    SYS_PROF_BEGIN(s_sProfTx);
 #if ETH_PAD_SIZE
     pbuf_header(p, -ETH_PAD_SIZE); /* drop the padding word */
 #endif
 
     for(q = p; q != NULL; q = q->next)
     {
-        memcpy((u8_t*)&buf[len], q->payload, q->len);
+        MEMCPY(&buf[len], q->payload, q->len);
         len = len + q->len;
     }
 
     ETH0_trigger_tx(len, NULL);
+    SYS_PROF_END(s_sProfTx);
 
 
 #if ETH_PAD_SIZE
@@ -246,17 +252,19 @@ low_level_output1(struct netif *netif, struct pbuf *p)
     buf = ETH1_get_tx_buf();
     if(buf == NULL)
         return ERR_MEM;
+    SYS_PROF_BEGIN(s_sProfTx);
 #if ETH_PAD_SIZE
     pbuf_header(p, -ETH_PAD_SIZE); /* drop the padding word */
 #endif
 
     for(q = p; q != NULL; q = q->next)
     {
-        memcpy((u8_t*)&buf[len], q->payload, q->len);
+        MEMCPY(&buf[len], q->payload, q->len);
         len = len + q->len;
     }
 
     ETH1_trigger_tx(len, NULL);
+    SYS_PROF_END(s_sProfTx);
 
 
 #if ETH_PAD_SIZE
@@ -281,6 +289,7 @@ low_level_input(struct netif *netif, u16_t len, u8_t *buf)
 {
     struct pbuf *p, *q;
 
+    SYS_PROF_BEGIN(s_sProfRx);
 #if ETH_PAD_SIZE
     len += ETH_PAD_SIZE; /* allow room for Ethernet padding */
 #endif
@@ -301,7 +310,7 @@ low_level_input(struct netif *netif, u16_t len, u8_t *buf)
         * packet into the pbuf. */
         for(q = p; q != NULL; q = q->next)
         {
-            memcpy((u8_t*)q->payload, (u8_t*)&buf[len], q->len);
+            MEMCPY(q->payload, &buf[len], q->len);
             len = len + q->len;
         }
 
@@ -319,6 +328,7 @@ low_level_input(struct netif *netif, u16_t len, u8_t *buf)
         LINK_STATS_INC(link.drop);
     }
 
+    SYS_PROF_END(s_sProfRx);
     return p;
 }
 
@@ -20,6 +20,11 @@
 #include "lwip/tcpip.h"
 #include "lwip/netif.h"
 #include "lwip/timeouts.h"
+#include "lwip/sys.h"
+#include "lwip/apps/httpd.h"
+#include "lwip/apps/lwiperf.h"
+#include "sdh.h"
+#include "fs_fatfs.h"
 
 //#include "lwip/timers.h"
 
@@ -28,117 +33,9 @@
 #include "lwip/dhcp.h"
 #endif
 
-/* web page*/
-static CHAR idx[] =
-{
-    0x48, 0x54, 0x54, 0x50, 0x2f, 0x31, 0x2e, 0x30, 0x20, 0x32,
-    0x30, 0x30, 0x20, 0x4f, 0x4b, 0xd, 0xa, 0x53, 0x65, 0x72,
-    0x76, 0x65, 0x72, 0x3a, 0x20, 0x6c, 0x77, 0x49, 0x50, 0x2f,
-    0x70, 0x72, 0x65, 0x2d, 0x30, 0x2e, 0x36, 0x20, 0x28, 0x68,
-    0x74, 0x74, 0x70, 0x3a, 0x2f, 0x2f, 0x77, 0x77, 0x77, 0x2e,
-    0x73, 0x69, 0x63, 0x73, 0x2e, 0x73, 0x65, 0x2f, 0x7e, 0x61,
-    0x64, 0x61, 0x6d, 0x2f, 0x6c, 0x77, 0x69, 0x70, 0x2f, 0x29,
-    0xd, 0xa, 0x43, 0x6f, 0x6e, 0x74, 0x65, 0x6e, 0x74, 0x2d,
-    0x74, 0x79, 0x70, 0x65, 0x3a, 0x20, 0x74, 0x65, 0x78, 0x74,
-    0x2f, 0x68, 0x74, 0x6d, 0x6c, 0xd, 0xa, 0xd, 0xa, 0x3c,
-    0x48, 0x54, 0x4d, 0x4c, 0x3e, 0xd, 0xa, 0x3c, 0x42, 0x4f,
-    0x44, 0x59, 0x3e, 0xd, 0xa, 0x4e, 0x55, 0x43, 0x39, 0x38,
-    0x30, 0x20, 0x77, 0x65, 0x62, 0x20, 0x73, 0x65, 0x72, 0x76,
-    0x65, 0x72, 0x20, 0x64, 0x65, 0x6d, 0x6f, 0x20, 0x62, 0x61,
-    0x73, 0x65, 0x64, 0x20, 0x6f, 0x6e, 0x20, 0x6c, 0x77, 0x49,
-    0x50, 0xd, 0xa, 0x3c, 0x2f, 0x42, 0x4f, 0x44, 0x59, 0x3e,
-    0xd, 0xa, 0x3c, 0x2f, 0x48, 0x54, 0x4d, 0x4c, 0x3e, 0xd,
-    0xa
-};
-static CHAR err404[] =
-{
-    0x48, 0x54, 0x54, 0x50, 0x2f, 0x31, 0x2e, 0x30, 0x20, 0x34,
-    0x30, 0x34, 0x20, 0x46, 0x69, 0x6c, 0x65, 0x20, 0x6e, 0x6f,
-    0x74, 0x20, 0x66, 0x6f, 0x75, 0x6e, 0x64, 0xd, 0xa, 0x53,
-    0x65, 0x72, 0x76, 0x65, 0x72, 0x3a, 0x20, 0x6c, 0x77, 0x49,
-    0x50, 0x2f, 0x70, 0x72, 0x65, 0x2d, 0x30, 0x2e, 0x36, 0x20,
-    0x28, 0x68, 0x74, 0x74, 0x70, 0x3a, 0x2f, 0x2f, 0x77, 0x77,
-    0x77, 0x2e, 0x73, 0x69, 0x63, 0x73, 0x2e, 0x73, 0x65, 0x2f,
-    0x7e, 0x61, 0x64, 0x61, 0x6d, 0x2f, 0x6c, 0x77, 0x69, 0x70,
-    0x2f, 0x29, 0xd, 0xa, 0x43, 0x6f, 0x6e, 0x74, 0x65, 0x6e,
-    0x74, 0x2d, 0x74, 0x79, 0x70, 0x65, 0x3a, 0x20, 0x74, 0x65,
-    0x78, 0x74, 0x2f, 0x68, 0x74, 0x6d, 0x6c, 0xd, 0xa, 0xd,
-    0xa, 0x3c, 0x48, 0x54, 0x4d, 0x4c, 0x3e, 0xd, 0xa, 0x3c,
-    0x42, 0x4f, 0x44, 0x59, 0x3e, 0xd, 0xa, 0x45, 0x52, 0x52,
-    0x4f, 0x52, 0x20, 0x2d, 0x20, 0x46, 0x69, 0x6c, 0x65, 0x20,
-    0x6e, 0x6f, 0x74, 0x20, 0x66, 0x6f, 0x75, 0x6e, 0x64, 0xd,
-    0xa, 0x3c, 0x2f, 0x42, 0x4f, 0x44, 0x59, 0x3e, 0xd, 0xa,
-    0x3c, 0x2f, 0x48, 0x54, 0x4d, 0x4c, 0x3e, 0xd, 0xa
-};
-
 unsigned char my_mac_addr0[6] = {0x00, 0x00, 0x00, 0x55, 0x66, 0x77};
 unsigned char my_mac_addr1[6] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
 
-/* recv callback function */
-static err_t http_recv(void *arg, struct tcp_pcb *pcb, struct pbuf*p, err_t err)
-{
-    CHAR *rq;
-    /* If we got a NULL pbuf in p, the remote end has closed
-    the connection.*/
-    if (p != NULL)
-    {
-
-        /* The payload pointer in the pbuf contains the data
-        in the TCP segment.*/
-
-        rq = p->payload;
-        /* Get and response the request file.
-           To support other webpage, extent the if statement below
-           If the object is larger than single TCP payload, need to send reset
-           for the content in main loop and then close the pcb */
-        if ((strncmp(rq, "GET /index.htm", 14) == 0)||(strncmp(rq, "GET / ", 6) == 0))
-        {
-            /* Send the webpage to the remote host. A zero
-            in the last argument means that the data should
-            not be copied into internal buffers. */
-            tcp_recved(pcb, p->tot_len);
-            tcp_write(pcb, idx, sizeof(idx) -1, 0);
-            tcp_close(pcb);
-        }
-        else
-        {
-            // err 404
-            tcp_recved(pcb, p->tot_len);
-            tcp_write(pcb, err404, sizeof(err404) -1, 0);
-            tcp_close(pcb);
-        }
-        /* Free the pbuf. */
-        pbuf_free(p);
-    }
-
-    return(ERR_OK);
-}
-
-/*accept callback function */
-static err_t http_acpt(void *arg,struct tcp_pcb *pcb, err_t err)
-{
-    /* Setup the function http_recv() to be called when data arrives.*/
-    tcp_recv(pcb, http_recv);
-    return ERR_OK;
-}
-
-/*httpd initialization function.*/
-static void httpd_init(void)
-{
-    struct tcp_pcb *pcb, *pcb_listen;
-    /*Create a new TCP PCB.*/
-    pcb = tcp_new();
-    /*Bind the PCB to TCP port 80.*/
-    if (tcp_bind(pcb,NULL,80) != ERR_OK)
-        printf("bind error\n");
-    /*Change TCP state to LISTEN.*/
-    pcb_listen = tcp_listen(pcb);
-    /*Setup http_accet() function to be called
-    when a new connection arrives.*/
-    tcp_accept(pcb_listen, http_acpt);
-}
-
-
 ip4_addr_t gw0, ipaddr0, netmask0;
 struct netif netif0;
 ip4_addr_t gw1, ipaddr1, netmask1;
@@ -192,6 +89,107 @@ static void net_init(void)
 
 }
 
+unsigned int volatile gCardInit = 0;
+SYS_FASTCODE void SDH_IRQHandler(void)
+{
+    unsigned int volatile isr;
+
+    // FMI data abort interrupt
+    if (SDH1->GINTSTS & SDH_GINTSTS_DTAIF_Msk)
+    {
+        /* ResetAllEngine() */
+        SDH1->GCTL |= SDH_GCTL_GCTLRST_Msk;
+    }
+
+    //----- SD interrupt status
+    isr = SDH1->INTSTS;
+    if (isr & SDH_INTSTS_BLKDIF_Msk)
+    {
+        // block down
+        g_u8SDDataReadyFlag = TRUE;
+        SDH1->INTSTS = SDH_INTSTS_BLKDIF_Msk;
+    }
+
+    if (isr & SDH_INTSTS_CDIF_Msk)   // card detect
+    {
+        {
+            int volatile i;         // delay to make sure got updated value from REG_SDISR.
+            for (i=0; i<0x500; i++);
+            isr = SDH1->INTSTS;
+        }
+
+        if (isr & SDH_INTSTS_CDSTS_Msk)
+        {
+            printf("\n***** card remove !\n");
+            gCardInit = 0;
+            SDH_Close_Disk(SDH1);
+        }
+        else
+        {
+            printf("***** card insert !\n");
+            gCardInit = 1;
+        }
+        SDH1->INTSTS = SDH_INTSTS_CDIF_Msk;
+    }
+
+    // CRC error interrupt
+    if (isr & SDH_INTSTS_CRCIF_Msk)
+        SDH1->INTSTS = SDH_INTSTS_CRCIF_Msk;      // clear interrupt flag
+
+    if (isr & SDH_INTSTS_DITOIF_Msk)
+    {
+        printf("***** ISR: data in timeout !\n");
+        SDH1->INTSTS |= SDH_INTSTS_DITOIF_Msk;
+    }
+
+    // Response in timeout interrupt
+    if (isr & SDH_INTSTS_RTOIF_Msk)
+    {
+        printf("***** ISR: response in timeout !\n");
+        SDH1->INTSTS |= SDH_INTSTS_RTOIF_Msk;
+    }
+}
+
+/*---------------------------------------------------------*/
+/* User Provided RTC Function for FatFs module             */
+/*---------------------------------------------------------*/
+unsigned long get_fattime (void)
+{
+    return 0;
+}
+
+/* Mount the SD card and index the web root */
+static void sd_init(void)
+{
+    /* enable SDH */
+    outpw(REG_CLK_HCLKEN, inpw(REG_CLK_HCLKEN) | 0x40000000);
+
+    /* SD Port 0 -> PF0~6 */
+    outpw(REG_SYS_GPF_MFPL, (inpw(REG_SYS_GPF_MFPL)&0x0FFFFFFF) | 0x02222222);
+
+    sysInstallISR(IRQ_LEVEL_1, IRQ_SDH, (PVOID)SDH_IRQHandler);
+    sysSetLocalInterrupt(ENABLE_IRQ);
+    sysEnableInterrupt(IRQ_SDH);
+
+    SDH_Open_Disk(SDH1, CardDetect_From_GPIO);
+    printf("%d files in %s\n", fsf_mount(), FSF_ROOT);
+}
+
+/* Print requests/s and MB/s over the last period when there was traffic */
+static void put_http_stat(uint32_t ticks)
+{
+    FSF_STAT st;
+    uint32_t bytes;
+
+    fsf_get_stat(&st, 1);
+    if (st.open == 0)
+        return;
+    bytes = st.lent + st.copied;
+    printf("httpd: %d req/s, %d KB/s (%d%% zero-copy), %d reads, %d opens refused\n",
+           (int)(st.open * 100 / ticks), (int)(bytes / 1024 * 100 / ticks),
+           bytes ? (int)((unsigned long long)st.lent * 100 / bytes) : 0, (int)st.rdcmd, (int)st.nofile);
+}
+
 void UART_Init(void)
 {
     /* enable UART0 clock */
@@ -222,11 +220,26 @@ void TIMER_Init(void)
 }
 
 
+/* Print the result of a finished iperf session. The FreeRTOS_LwIP sample
+   runs the same server on the threaded stack for comparison. */
+static void iperf_report(void *arg, enum lwiperf_report_type report_type,
+                         const ip_addr_t *local_addr, u16_t local_port, const ip_addr_t *remote_addr, u16_t remote_port,
+                         u32_t bytes_transferred, u32_t ms_duration, u32_t bandwidth_kbitpsec)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(local_addr);
+    LWIP_UNUSED_ARG(local_port);
+    LWIP_UNUSED_ARG(remote_port);
+
+    printf("iperf %s: %d KB in %d ms, %d kbit/s (result %d)\n", ipaddr_ntoa(remote_addr),
+           (int)(bytes_transferred / 1024), (int)ms_duration, (int)bandwidth_kbitpsec, (int)report_type);
+}
+
 extern void chk_link0(void *arg);
 extern void chk_link1(void *arg);
 int main(void)
 {
-
+    uint32_t statTick = 0;
 
     sysDisableCache();
     sysFlushCache(I_D_CACHE);
@@ -235,13 +248,40 @@ int main(void)
 
     UART_Init();
     printf("lwIP httpd demo\n");
+    if (sysLockFastCode() != Successful)
+        printf("sysLockFastCode failed, interrupt paths are not locked in the I-cache\n");
     TIMER_Init();
 
+    sd_init();
     net_init();
     httpd_init();
+    lwiperf_start_tcp_server_default(iperf_report, NULL);   // iperf 2 server on port 5001
     sys_timeout(2000, chk_link0, NULL);
     sys_timeout(2000, chk_link1, NULL);
     while (1)
-        sys_check_timeouts();  // All network traffic is handled in interrupt handler
+    {
+        SYS_ARCH_DECL_PROTECT(lev);
+
+        // All network traffic is handled in interrupt handler, keep the timers out of it
+        SYS_ARCH_PROTECT(lev);
+        sys_check_timeouts();
+        SYS_ARCH_UNPROTECT(lev);
+
+        // Read the file blocks httpd is waiting for
+        fsf_poll();
+
+        if (gCardInit)
+        {
+            gCardInit = 0;
+            SDH_Open_Disk(SDH1, CardDetect_From_GPIO);
+            fsf_mount();
+        }
+
+        if (sysTick - statTick >= 1000)
+        {
+            put_http_stat(sysTick - statTick);
+            statTick = sysTick;
+        }
+    }
 }
 
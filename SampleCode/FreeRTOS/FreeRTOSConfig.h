@@ -44,15 +44,20 @@
 #define configUSE_PREEMPTION        1
 #define configUSE_IDLE_HOOK         0
 #define configUSE_TICK_HOOK         0
+#define configUSE_TICKLESS_IDLE     2   /* Sleep with TIMER5 set for the next wake time, see port.c */
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP   2
 #define configCPU_CLOCK_HZ          ( ( unsigned long ) 300000000 )
 #define configTICK_RATE_HZ          ( ( TickType_t ) 1000 )
 #define configMAX_PRIORITIES        ( 4 )
 #define configMINIMAL_STACK_SIZE    ( ( unsigned short ) 90 )
-#define configTOTAL_HEAP_SIZE       ( ( size_t ) 13 * 1024 )
+#define configTOTAL_HEAP_SIZE       ( ( size_t ) 32 * 1024 )
 #define configMAX_TASK_NAME_LEN     ( 8 )
-#define configUSE_TRACE_FACILITY    0
+#define configUSE_TRACE_FACILITY    1
+#define configGENERATE_RUN_TIME_STATS   1   /* TIMER5 timebase / 16, portRUN_TIME_HZ, see port.c */
+#define configUSE_STATS_FORMATTING_FUNCTIONS    1
 #define configUSE_16_BIT_TICKS      0
 #define configIDLE_SHOULD_YIELD     1
+#define configUSE_MUTEXES           1
 
 #define configQUEUE_REGISTRY_SIZE   0
 
@@ -74,4 +79,22 @@ to exclude the API function. */
 #define INCLUDE_pcTaskGetTaskName               1
 #define INCLUDE_xTaskGetSchedulerState          1
 
+/* Trace hooks. The kernel macros expand inside tasks.c and queue.c, the ISR
+hooks inside the port. Records go to the ring of trace.c. */
+#include "trace.h"
+
+#define traceTASK_SWITCHED_IN()     vTraceRecord( traceEV_TASK_SWITCH, 0, ( uint16_t ) pxCurrentTCB->uxTCBNumber )
+#define traceTASK_CREATE( pxNewTCB )    vTraceTaskCreate( ( pxNewTCB )->uxTCBNumber, ( pxNewTCB )->pcTaskName )
+#define traceISR_ENTER( ulIrq )     vTraceIsrEnter( ulIrq )
+#define traceISR_EXIT( ulIrq )      vTraceIsrExit( ulIrq )
+
+#define traceQUEUE_SEND( pxQueue )              vTraceRecord( traceEV_QUEUE_SEND, ( pxQueue )->ucQueueType, traceQUEUE_ID( pxQueue ) )
+#define traceQUEUE_RECEIVE( pxQueue )           vTraceRecord( traceEV_QUEUE_RECEIVE, ( pxQueue )->ucQueueType, traceQUEUE_ID( pxQueue ) )
+#define traceQUEUE_SEND_FROM_ISR( pxQueue )     vTraceRecord( traceEV_QUEUE_SEND_ISR, ( pxQueue )->ucQueueType, traceQUEUE_ID( pxQueue ) )
+#define traceQUEUE_RECEIVE_FROM_ISR( pxQueue )  vTraceRecord( traceEV_QUEUE_RECV_ISR, ( pxQueue )->ucQueueType, traceQUEUE_ID( pxQueue ) )
+#define traceBLOCKING_ON_QUEUE_SEND( pxQueue )  vTraceRecord( traceEV_QUEUE_BLOCK, ( pxQueue )->ucQueueType, traceQUEUE_ID( pxQueue ) )
+#define traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue )   vTraceRecord( traceEV_QUEUE_BLOCK, ( pxQueue )->ucQueueType, traceQUEUE_ID( pxQueue ) )
+#define traceQUEUE_SEND_FAILED( pxQueue )       vTraceRecord( traceEV_QUEUE_FAILED, ( pxQueue )->ucQueueType, traceQUEUE_ID( pxQueue ) )
+#define traceQUEUE_RECEIVE_FAILED( pxQueue )    vTraceRecord( traceEV_QUEUE_FAILED, ( pxQueue )->ucQueueType, traceQUEUE_ID( pxQueue ) )
+
 #endif /* FREERTOS_CONFIG_H */
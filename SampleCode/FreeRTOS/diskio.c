@@ -0,0 +1,297 @@
+/*-----------------------------------------------------------------------*/
+/* Low level disk I/O module skeleton for FatFs     (C)ChaN, 2013        */
+/*-----------------------------------------------------------------------*/
+/* If a working storage control module is available, it should be        */
+/* attached to the FatFs via a glue function rather than modifying it.   */
+/* This is an example of glue functions to attach various exsisting      */
+/* storage control module to the FatFs module with a defined API.        */
+/*-----------------------------------------------------------------------*/
+/* Thread-safe glue for FreeRTOS: FatFs locks each volume and the sector */
+/* cache locks each device. SD0 and SD1 share one device because the SDH */
+/* driver keeps common state for both ports. The RAM disk is a device of */
+/* its own and transfers in parallel with the SD card.                   */
+/*-----------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+
+#include "nuc980.h"
+#include "sys.h"
+#include "sdh.h"
+#include "ff.h"
+#include "diskio.h"
+#include "ffcache.h"
+
+#define DRV_SD0         0
+#define DRV_SD1         1
+#define DRV_RAM         2
+
+#define FATFS_BOUNCE_SECTORS    32      /* Sectors moved per SDH command for cacheable buffers */
+#define RAMDISK_SECTORS         2048    /* 1 MB RAM disk */
+#define RAMDISK_STAGE_SECTORS   8
+
+#if defined (__GNUC__) && !(__CC_ARM)
+static __attribute__((aligned(32))) BYTE  fatfs_win_buff_pool[FATFS_BOUNCE_SECTORS * _MAX_SS] ;       /* FATFS window buffer is cacheable. Must not use it directly. */
+static __attribute__((aligned(32))) BYTE  ramdisk[RAMDISK_SECTORS][_MAX_SS];
+static __attribute__((aligned(32))) BYTE  ramdisk_stage[RAMDISK_STAGE_SECTORS * _MAX_SS];
+#else
+static __align(32) BYTE  fatfs_win_buff_pool[FATFS_BOUNCE_SECTORS * _MAX_SS] ;       /* FATFS window buffer is cacheable. Must not use it directly. */
+static __align(32) BYTE  ramdisk[RAMDISK_SECTORS][_MAX_SS];
+static __align(32) BYTE  ramdisk_stage[RAMDISK_STAGE_SECTORS * _MAX_SS];
+#endif
+
+static DRESULT sd_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count);
+static DRESULT sd_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count);
+static DRESULT ram_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count);
+static DRESULT ram_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count);
+
+static FFC_DEV  sd_dev = { sd_read, sd_write, 0, FATFS_BOUNCE_SECTORS };
+static FFC_DEV  ram_dev = { ram_read, ram_write, ramdisk_stage, RAMDISK_STAGE_SECTORS };
+
+
+/*-----------------------------------------------------------------------*/
+/* Lay out an empty FAT12 volume on the RAM disk                         */
+/*-----------------------------------------------------------------------*/
+
+#define RAMDISK_FAT_SECTORS     6       /* (2003 clusters + 2) * 1.5 bytes */
+#define RAMDISK_ROOT_SECTORS    32      /* 512 root directory entries */
+
+static void ramdisk_format(void)
+{
+    static const BYTE bpb[] =
+    {
+        0xEB, 0x3C, 0x90, 'M', 'S', 'D', 'O', 'S', '5', '.', '0',
+        0x00, 0x02,                             /* 512 bytes per sector */
+        1,                                      /* 1 sector per cluster */
+        0x01, 0x00,                             /* 1 reserved sector */
+        2,                                      /* 2 FATs */
+        0x00, 0x02,                             /* 512 root directory entries */
+        RAMDISK_SECTORS & 0xFF, RAMDISK_SECTORS >> 8,
+        0xF8,                                   /* Fixed media */
+        RAMDISK_FAT_SECTORS, 0x00,
+        63, 0, 255, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0x80, 0, 0x29, 0x78, 0x56, 0x34, 0x12,
+        'R', 'A', 'M', 'D', 'I', 'S', 'K', ' ', ' ', ' ', ' ',
+        'F', 'A', 'T', '1', '2', ' ', ' ', ' '
+    };
+    int     i;
+
+    memset(ramdisk, 0, (1 + 2 * RAMDISK_FAT_SECTORS + RAMDISK_ROOT_SECTORS) * _MAX_SS);
+    memcpy(ramdisk[0], bpb, sizeof(bpb));
+    ramdisk[0][510] = 0x55;
+    ramdisk[0][511] = 0xAA;
+    for (i = 0; i < 2; i++)
+    {
+        ramdisk[1 + i * RAMDISK_FAT_SECTORS][0] = 0xF8;
+        ramdisk[1 + i * RAMDISK_FAT_SECTORS][1] = 0xFF;
+        ramdisk[1 + i * RAMDISK_FAT_SECTORS][2] = 0xFF;
+    }
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Initialize a Drive                                                    */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS disk_initialize (BYTE pdrv)       /* Physical drive number (0..) */
+{
+    switch (pdrv)
+    {
+    case DRV_SD0 :
+    case DRV_SD1 :
+        if (disk_status(pdrv) & STA_NOINIT)
+            return STA_NOINIT;
+        /* The non-cacheable bounce pool doubles as the cache staging buffer */
+        sd_dev.stage = (BYTE *)((unsigned int)fatfs_win_buff_pool | 0x80000000);
+        ffc_attach(pdrv, &sd_dev, (pdrv == DRV_SD0) ? SD0.totalSectorN : SD1.totalSectorN);
+        break;
+
+    case DRV_RAM :
+        if ((ramdisk[0][510] != 0x55) || (ramdisk[0][511] != 0xAA))
+            ramdisk_format();
+        ffc_attach(pdrv, &ram_dev, RAMDISK_SECTORS);
+        break;
+
+    default:
+        return STA_NOINIT;
+    }
+    return RES_OK;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Get Disk Status                                                       */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS disk_status (BYTE pdrv)       /* Physical drive number (0..) */
+{
+    switch (pdrv)
+    {
+    case DRV_SD0 :
+        if (SDH_GET_CARD_CAPACITY(SDH0) == 0)
+            return STA_NOINIT;
+        break;
+
+    case DRV_SD1 :
+        if (SDH_GET_CARD_CAPACITY(SDH1) == 0)
+            return STA_NOINIT;
+        break;
+
+    case DRV_RAM :
+        break;
+
+    default:
+        return STA_NOINIT;
+    }
+    return RES_OK;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* SD card device                                                        */
+/*-----------------------------------------------------------------------*/
+
+static DRESULT sd_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+    SDH_T   *sdh = (pdrv == DRV_SD0) ? SDH0 : SDH1;
+    BYTE    *bounce;
+    DRESULT ret;
+    UINT    n;
+
+    outpw(REG_SDH_GCTL, SDH_GCTL_SDEN_Msk);
+    /* SDH maintains the D-cache for line aligned buffers */
+    if (((UINT32)buff & 0x80000000) || !((UINT32)buff & (SYS_DCACHE_LINE_SIZE - 1)))
+        return (DRESULT) SDH_Read(sdh, buff, sector, count);
+
+    /* Disk read buffer is cacheable and shares D-cache lines with other data. Use my non-cacheable to do disk read. */
+    bounce = (BYTE *)((unsigned int)fatfs_win_buff_pool | 0x80000000);
+    ret = RES_OK;
+    while (count && (ret == RES_OK))
+    {
+        n = (count > FATFS_BOUNCE_SECTORS) ? FATFS_BOUNCE_SECTORS : count;
+        ret = (DRESULT) SDH_Read(sdh, bounce, sector, n);
+        sysMemCopy(buff, bounce, n * 512);
+        buff += n * 512;
+        sector += n;
+        count -= n;
+    }
+    return ret;
+}
+
+static DRESULT sd_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+    SDH_T   *sdh = (pdrv == DRV_SD0) ? SDH0 : SDH1;
+    BYTE    *bounce;
+    DRESULT ret;
+    UINT    n;
+
+    outpw(REG_SDH_GCTL, SDH_GCTL_SDEN_Msk);
+    /* SDH maintains the D-cache for line aligned buffers */
+    if (((UINT32)buff & 0x80000000) || !((UINT32)buff & (SYS_DCACHE_LINE_SIZE - 1)))
+        return (DRESULT) SDH_Write(sdh, (UINT8 *)buff, sector, count);
+
+    /* Disk write buffer is cacheable and shares D-cache lines with other data. Use my non-cacheable to do disk write. */
+    bounce = (BYTE *)((unsigned int)fatfs_win_buff_pool | 0x80000000);
+    ret = RES_OK;
+    while (count && (ret == RES_OK))
+    {
+        n = (count > FATFS_BOUNCE_SECTORS) ? FATFS_BOUNCE_SECTORS : count;
+        sysMemCopy(bounce, buff, n * 512);
+        ret = (DRESULT) SDH_Write(sdh, bounce, sector, n);
+        buff += n * 512;
+        sector += n;
+        count -= n;
+    }
+    return ret;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* RAM disk device                                                       */
+/*-----------------------------------------------------------------------*/
+
+static DRESULT ram_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+    if (sector + count > RAMDISK_SECTORS)
+        return RES_PARERR;
+    memcpy(buff, ramdisk[sector], count * _MAX_SS);
+    return RES_OK;
+}
+
+static DRESULT ram_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+    if (sector + count > RAMDISK_SECTORS)
+        return RES_PARERR;
+    memcpy(ramdisk[sector], buff, count * _MAX_SS);
+    return RES_OK;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Read Sector(s)                                                        */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_read (
+    BYTE pdrv,      /* Physical drive number (0..) */
+    BYTE *buff,     /* Data buffer to store read data */
+    DWORD sector,   /* Sector address (LBA) */
+    UINT count      /* Number of sectors to read (1..128) */
+)
+{
+    return ffc_read(pdrv, buff, sector, count);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Write Sector(s)                                                       */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_write (
+    BYTE pdrv,          /* Physical drive number (0..) */
+    const BYTE *buff,   /* Data to be written */
+    DWORD sector,       /* Sector address (LBA) */
+    UINT count          /* Number of sectors to write (1..128) */
+)
+{
+    return ffc_write(pdrv, buff, sector, count);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Miscellaneous Functions                                               */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_ioctl (
+    BYTE pdrv,      /* Physical drive number (0..) */
+    BYTE cmd,       /* Control code */
+    void *buff      /* Buffer to send/receive control data */
+)
+{
+    DRESULT res = RES_OK;
+
+    if (disk_status(pdrv) & STA_NOINIT)
+        return RES_NOTRDY;
+
+    switch(cmd)
+    {
+    case CTRL_SYNC:
+        res = ffc_sync(pdrv);
+        break;
+    case GET_SECTOR_COUNT:
+        if (pdrv == DRV_RAM)
+            *(DWORD*)buff = RAMDISK_SECTORS;
+        else
+            *(DWORD*)buff = (pdrv == DRV_SD0) ? SD0.totalSectorN : SD1.totalSectorN;
+        break;
+    case GET_SECTOR_SIZE:
+        *(WORD*)buff = _MAX_SS;
+        break;
+    case GET_BLOCK_SIZE:
+        *(DWORD*)buff = 1;
+        break;
+
+    default:
+        res = RES_PARERR;
+        break;
+    }
+    return res;
+}
@@ -0,0 +1,276 @@
+/*
+ * fs_stress.c - Concurrent FatFs access from several tasks and volumes
+ *
+ * Two tasks per volume keep writing, reading back and verifying their own
+ * file. FatFs locks each volume with its own mutex (FATFS_FREERTOS), so
+ * tasks on the RAM disk are not held up by tasks on the SD card, and the
+ * two tasks on one volume exercise the per-volume file lock table.
+ * vFsStressReport() prints the throughput of each volume.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "nuc980.h"
+#include "sys.h"
+#include "sdh.h"
+#include "ff.h"
+#include "diskio.h"
+#include "ffcache.h"
+#include "fs_stress.h"
+
+#define fsFILE_SIZE         ( 64 * 1024 )
+#define fsBLOCK_SIZE        ( 4 * 1024 )
+#define fsTASKS_PER_VOLUME  2
+#define fsSTACK_SIZE        ( configMINIMAL_STACK_SIZE * 4 )
+
+typedef struct
+{
+    const char *pcPath;         /* Logical drive, "1:" SD card on SDH1, "2:" RAM disk */
+    FATFS xFs;
+    volatile uint32_t ulBytes;  /* Bytes written and read back since the last report */
+    volatile uint32_t ulErrors;
+    volatile uint32_t ulLoops;
+    uint32_t ulLastLoops;
+} xFsVolume;
+
+static xFsVolume xVolumes[] =
+{
+    { "1:" },
+    { "2:" },
+};
+
+#define fsNUM_VOLUMES       ( sizeof( xVolumes ) / sizeof( xVolumes[0] ) )
+
+typedef struct
+{
+    xFsVolume *pxVolume;
+    BYTE ucId;
+    FIL xFile;
+    BYTE ucBuffer[ fsBLOCK_SIZE ];
+} xFsTask;
+
+static xFsTask xTasks[ fsNUM_VOLUMES * fsTASKS_PER_VOLUME ];
+
+unsigned int volatile gCardInit = 0;
+/*-----------------------------------------------------------*/
+
+SYS_FASTCODE void SDH_IRQHandler(void)
+{
+    unsigned int volatile isr;
+
+    // FMI data abort interrupt
+    if (SDH1->GINTSTS & SDH_GINTSTS_DTAIF_Msk)
+    {
+        /* ResetAllEngine() */
+        SDH1->GCTL |= SDH_GCTL_GCTLRST_Msk;
+    }
+
+    //----- SD interrupt status
+    isr = SDH1->INTSTS;
+    if (isr & SDH_INTSTS_BLKDIF_Msk)
+    {
+        // block down
+        g_u8SDDataReadyFlag = TRUE;
+        SDH1->INTSTS = SDH_INTSTS_BLKDIF_Msk;
+    }
+
+    if (isr & SDH_INTSTS_CDIF_Msk)   // card detect
+    {
+        {
+            int volatile i;
+            for (i=0; i<0x500; i++);  // delay to make sure got updated value from REG_SDISR.
+            isr = SDH1->INTSTS;
+        }
+
+        if (isr & SDH_INTSTS_CDSTS_Msk)
+        {
+            gCardInit = 0;
+            SDH_Close_Disk(SDH1);
+        }
+        else
+        {
+            gCardInit = 1;
+        }
+        SDH1->INTSTS = SDH_INTSTS_CDIF_Msk;
+    }
+
+    if (isr & SDH_INTSTS_CRCIF_Msk)
+        SDH1->INTSTS = SDH_INTSTS_CRCIF_Msk;
+    if (isr & SDH_INTSTS_DITOIF_Msk)
+        SDH1->INTSTS |= SDH_INTSTS_DITOIF_Msk;
+    if (isr & SDH_INTSTS_RTOIF_Msk)
+        SDH1->INTSTS |= SDH_INTSTS_RTOIF_Msk;
+}
+/*-----------------------------------------------------------*/
+
+unsigned long get_fattime (void)
+{
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvFill( BYTE *pucBuffer, BYTE ucId, uint32_t ulOffset )
+{
+    uint32_t i;
+
+    for( i = 0; i < fsBLOCK_SIZE; i += 4 )
+    {
+        *( uint32_t * )( pucBuffer + i ) = ( ( uint32_t ) ucId << 24 ) ^ ( ulOffset + i );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvCheck( const BYTE *pucBuffer, BYTE ucId, uint32_t ulOffset )
+{
+    uint32_t i;
+
+    for( i = 0; i < fsBLOCK_SIZE; i += 4 )
+    {
+        if( *( const uint32_t * )( pucBuffer + i ) != ( ( ( uint32_t ) ucId << 24 ) ^ ( ulOffset + i ) ) )
+        {
+            return pdFALSE;
+        }
+    }
+    return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvFsStressTask( void *pvParameters )
+{
+    xFsTask *pxTask = ( xFsTask * ) pvParameters;
+    xFsVolume *pxVolume = pxTask->pxVolume;
+    char cName[ 16 ];
+    uint32_t ulOffset;
+    UINT uxDone;
+    FRESULT xResult;
+
+    sprintf( cName, "%sstress%d.bin", pxVolume->pcPath, pxTask->ucId );
+
+    for( ;; )
+    {
+        /* Write the file */
+        xResult = f_open( &pxTask->xFile, cName, FA_CREATE_ALWAYS | FA_WRITE );
+        for( ulOffset = 0; ( xResult == FR_OK ) && ( ulOffset < fsFILE_SIZE ); ulOffset += fsBLOCK_SIZE )
+        {
+            prvFill( pxTask->ucBuffer, pxTask->ucId, ulOffset );
+            xResult = f_write( &pxTask->xFile, pxTask->ucBuffer, fsBLOCK_SIZE, &uxDone );
+            if( ( xResult == FR_OK ) && ( uxDone != fsBLOCK_SIZE ) )
+            {
+                xResult = FR_DENIED;
+            }
+        }
+        if( xResult == FR_OK )
+        {
+            xResult = f_close( &pxTask->xFile );
+        }
+
+        /* Read it back */
+        if( xResult == FR_OK )
+        {
+            xResult = f_open( &pxTask->xFile, cName, FA_OPEN_EXISTING | FA_READ );
+            for( ulOffset = 0; ( xResult == FR_OK ) && ( ulOffset < fsFILE_SIZE ); ulOffset += fsBLOCK_SIZE )
+            {
+                xResult = f_read( &pxTask->xFile, pxTask->ucBuffer, fsBLOCK_SIZE, &uxDone );
+                if( ( xResult == FR_OK ) && ( ( uxDone != fsBLOCK_SIZE ) || !prvCheck( pxTask->ucBuffer, pxTask->ucId, ulOffset ) ) )
+                {
+                    xResult = FR_INT_ERR;
+                }
+            }
+            if( xResult == FR_OK )
+            {
+                xResult = f_close( &pxTask->xFile );
+            }
+        }
+
+        taskENTER_CRITICAL();
+        if( xResult == FR_OK )
+        {
+            pxVolume->ulBytes += 2 * fsFILE_SIZE;
+            pxVolume->ulLoops++;
+        }
+        else
+        {
+            pxVolume->ulErrors++;
+        }
+        taskEXIT_CRITICAL();
+
+        if( xResult != FR_OK )
+        {
+            f_close( &pxTask->xFile );
+            vTaskDelay( 1000 / portTICK_RATE_MS );    /* No card, retry later */
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vStartFsStressTasks( UBaseType_t uxPriority )
+{
+    UBaseType_t v, t;
+    xFsTask *pxTask = xTasks;
+
+    /* Enable SDH and select the SD port 1 pins (PF0~6) */
+    outpw(REG_CLK_HCLKEN, inpw(REG_CLK_HCLKEN) | 0x40000000);
+    outpw(REG_SYS_GPF_MFPL, (inpw(REG_SYS_GPF_MFPL)&0x0FFFFFFF) | 0x02222222);
+    sysInstallISR(IRQ_LEVEL_1, IRQ_SDH, (PVOID)SDH_IRQHandler);
+    sysEnableInterrupt(IRQ_SDH);
+    SDH_Open_Disk(SDH1, CardDetect_From_GPIO);
+
+    ffc_init();
+
+    for( v = 0; v < fsNUM_VOLUMES; v++ )
+    {
+        f_mount( &xVolumes[ v ].xFs, xVolumes[ v ].pcPath, 0 );
+        for( t = 0; t < fsTASKS_PER_VOLUME; t++, pxTask++ )
+        {
+            pxTask->pxVolume = &xVolumes[ v ];
+            pxTask->ucId = ( BYTE ) ( pxTask - xTasks );
+            xTaskCreate( prvFsStressTask, "FsStres", fsSTACK_SIZE, pxTask, uxPriority, NULL );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xAreFsStressTasksStillRunning( void )
+{
+    BaseType_t xReturn = pdTRUE;
+    UBaseType_t v;
+
+    /* Every volume must have made progress without errors since the last call */
+    for( v = 0; v < fsNUM_VOLUMES; v++ )
+    {
+        if( ( xVolumes[ v ].ulErrors != 0 ) || ( xVolumes[ v ].ulLoops == xVolumes[ v ].ulLastLoops ) )
+        {
+            xReturn = pdFALSE;
+        }
+        xVolumes[ v ].ulLastLoops = xVolumes[ v ].ulLoops;
+    }
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vFsStressReport( TickType_t xPeriod )
+{
+    UBaseType_t v;
+    uint32_t ulBytes, ulErrors;
+    FFC_STAT xStat;
+
+    for( v = 0; v < fsNUM_VOLUMES; v++ )
+    {
+        taskENTER_CRITICAL();
+        ulBytes = xVolumes[ v ].ulBytes;
+        ulErrors = xVolumes[ v ].ulErrors;
+        xVolumes[ v ].ulBytes = 0;
+        xVolumes[ v ].ulErrors = 0;
+        taskEXIT_CRITICAL();
+
+        ffc_get_stat( ( BYTE ) ( xVolumes[ v ].pcPath[ 0 ] - '0' ), &xStat, 1 );
+        printf( "%s %d kB/s, %d errors, cache hit %d miss %d, %d/%d device rd/wr cmds\n", xVolumes[ v ].pcPath,
+                ( ulBytes / 1024 ) * 1000 / ( xPeriod * portTICK_RATE_MS ), ulErrors,
+                xStat.hit, xStat.miss, xStat.rdcmd, xStat.wrcmd );
+    }
+}
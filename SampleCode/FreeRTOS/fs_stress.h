@@ -0,0 +1,12 @@
+/*
+ * fs_stress.h - Concurrent FatFs access from several tasks and volumes
+ */
+
+#ifndef FS_STRESS_H
+#define FS_STRESS_H
+
+void vStartFsStressTasks( UBaseType_t uxPriority );
+BaseType_t xAreFsStressTasksStillRunning( void );
+void vFsStressReport( TickType_t xPeriod );
+
+#endif /* FS_STRESS_H */
@@ -49,6 +49,7 @@
 #include "QueueSet.h"
 #include "recmutex.h"
 #include "death.h"
+#include "fs_stress.h"
 
 /* Hardware and starter kit includes. */
 #include "nuc980.h"
@@ -62,8 +63,9 @@
 #define mainCREATOR_TASK_PRIORITY           ( tskIDLE_PRIORITY + 3UL )
 #define mainFLOP_TASK_PRIORITY              ( tskIDLE_PRIORITY )
 #define mainCHECK_TASK_PRIORITY             ( tskIDLE_PRIORITY + 3UL )
+#define mainFS_STRESS_PRIORITY              ( tskIDLE_PRIORITY + 1UL )
 
-#define mainCHECK_TASK_STACK_SIZE           ( configMINIMAL_STACK_SIZE )
+#define mainCHECK_TASK_STACK_SIZE           ( configMINIMAL_STACK_SIZE * 4 )
 
 /* The time between cycles of the 'check' task. */
 #define mainCHECK_DELAY                     ( ( portTickType ) 5000 / portTICK_RATE_MS )
@@ -93,6 +95,14 @@ information. */
 
 #define CHECK_TEST
 
+/* Set mainCREATE_FS_STRESS_TASKS to 1 to run concurrent FatFs access on the SD
+card (1:) and a RAM disk (2:). The check task reports throughput per volume. */
+#define mainCREATE_FS_STRESS_TASKS          1
+
+/* Set mainTRACE_DUMP_AFTER_CHECKS to a number of check periods to print the
+trace ring once for Test/Host/tracedec, or 0 to only print the statistics. */
+#define mainTRACE_DUMP_AFTER_CHECKS         3
+
 /*-----------------------------------------------------------*/
 
 /*
@@ -120,12 +130,17 @@ int main(void)
 
     vStartPolledQueueTasks( mainQUEUE_POLL_PRIORITY );
 
+#if mainCREATE_FS_STRESS_TASKS
+    vStartFsStressTasks( mainFS_STRESS_PRIORITY );
+#endif
+
     /* The following function will only create more tasks and timers if
     mainCREATE_SIMPLE_LED_FLASHER_DEMO_ONLY is set to 0 (at the top of this
     file).  See the comments at the top of this file for more information. */
     //prvOptionallyCreateComprehensveTestApplication();
 
     printf("FreeRTOS is starting ...\n");
+    vTraceStart();
 
     /* Start the scheduler. */
     vTaskStartScheduler();
@@ -156,6 +171,11 @@ static void prvSetupHardware( void )
     outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
     outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
 
+    if( sysLockFastCode() != Successful )
+    {
+        printf( "sysLockFastCode failed, interrupt paths are not locked in the I-cache\n" );
+    }
+
     sysSetLocalInterrupt(ENABLE_IRQ);
 }
 /*-----------------------------------------------------------*/
@@ -204,11 +224,31 @@ void vApplicationStackOverflowHook( xTaskHandle pxTask, signed char *pcTaskName
 }
 
 #ifdef CHECK_TEST
+/* Report the tickless idle wakeups per second and how far the tick count
+has drifted from the 12 MHz timebase since the check task started. */
+static void prvIdleReport( portTickType xStartTicks, uint64_t ullStartTime )
+{
+    static uint32_t ulLastSleeps = 0;
+    uint32_t ulSleeps, ulSuppressed;
+    int32_t lDriftUs;
+
+    vPortGetSleepStats( &ulSleeps, &ulSuppressed );
+    lDriftUs = (int32_t)( (uint64_t)( xTaskGetTickCount() - xStartTicks ) * ( 1000000 / configTICK_RATE_HZ ) -
+                          ( ullPortGetTimebase() - ullStartTime ) / ( portTIMEBASE_HZ / 1000000 ) );
+    printf( "Idle: %d wakeups/s, %d ticks suppressed, tick drift %d us\n",
+            (int)( ( ulSleeps - ulLastSleeps ) * configTICK_RATE_HZ / mainCHECK_DELAY ), (int)ulSuppressed, (int)lDriftUs );
+    ulLastSleeps = ulSleeps;
+}
+
 static void vCheckTask( void *pvParameters )
 {
-    portTickType xLastExecutionTime;
+    portTickType xLastExecutionTime, xStartTicks;
+    uint64_t ullStartTime;
+    uint32_t ulChecks = 0;
 
     xLastExecutionTime = xTaskGetTickCount();
+    xStartTicks = xLastExecutionTime;
+    ullStartTime = ullPortGetTimebase();
 
     printf("Check Task is running ...\n");
 
@@ -220,6 +260,19 @@ static void vCheckTask( void *pvParameters )
         {
             printf( "ERROR IN POLL Q\n" );
         }
+#if mainCREATE_FS_STRESS_TASKS
+        if( xAreFsStressTasksStillRunning() != pdTRUE )
+        {
+            printf( "ERROR IN FS STRESS\n" );
+        }
+        vFsStressReport( mainCHECK_DELAY );
+#endif
+        prvIdleReport( xStartTicks, ullStartTime );
+        vTraceReport();
+        if( ++ulChecks == mainTRACE_DUMP_AFTER_CHECKS )
+        {
+            vTraceDump();
+        }
     }
 }
 #endif
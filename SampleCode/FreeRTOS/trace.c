@@ -0,0 +1,240 @@
+/*
+ * trace.c - Binary trace ring for task switches, interrupts and queues
+ *
+ * The kernel trace macros in FreeRTOSConfig.h and the ISR hooks of the port
+ * write 8 byte records into a ring stamped with the run-time counter of the
+ * port, portRUN_TIME_HZ. The ring is a flight recorder: it keeps the last
+ * traceRING_RECORDS records and overwrites older ones. A writer reserves
+ * its slot with IRQ masked for a few instructions, which is the only way
+ * to serialise writers on ARMv5 (no LDREX/STREX). Nothing blocks.
+ *
+ * The same hooks keep log2 histograms of the run time of every interrupt
+ * source and of the tick interrupt latency, read from the TIMER5 compare.
+ * They count run-time counter periods; only the report converts to time.
+ *
+ * vTraceReport() prints per-task CPU usage and the histograms in us.
+ * vTraceDump() stops the ring and prints its records, one per line. Capture
+ * the UART output into a file and decode it on the host with
+ * Test/Host/tracedec, which prints per-task CPU usage and ISR histograms of
+ * the records and writes Chrome trace JSON ("chrome://tracing" or
+ * ui.perfetto.dev) with task and ISR slices and queue operations.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "nuc980.h"
+#include "sys.h"
+#include "trace.h"
+
+#define traceMAX_TASKS      32
+#define traceMAX_IRQ        64
+#define traceHIST_BINS      12      /* 0, 1, 2-3, 4-7 ... 512-1023, >= 1024 counter periods */
+
+#if defined ( __GNUC__ ) && !(__CC_ARM)
+static __inline uint32_t prvMaskIrq( void )
+{
+    uint32_t ulCpsr, ulTmp;
+
+    asm volatile ( "MRS %0, CPSR       \n"
+                   "ORR %1, %0, #0x80  \n"
+                   "MSR CPSR_c, %1     \n"
+                   : "=&r" ( ulCpsr ), "=r" ( ulTmp ) : : "memory" );
+    return ulCpsr;
+}
+
+static __inline void prvRestoreIrq( uint32_t ulCpsr )
+{
+    asm volatile ( "MSR CPSR_c, %0" : : "r" ( ulCpsr ) : "memory" );
+}
+#else
+#define prvMaskIrq()                __disable_irq()
+#define prvRestoreIrq( ulState )    do { if( ( ulState ) == 0 ) __enable_irq(); } while( 0 )
+#endif
+
+static xTraceRecord xRing[ traceRING_RECORDS ];
+static volatile uint32_t ulHead = 0;            /* Records written since vTraceStart() */
+static volatile uint32_t ulEnabled = 1;
+
+static char cTaskNames[ traceMAX_TASKS ][ configMAX_TASK_NAME_LEN ];
+
+static uint32_t ulIsrStart;
+static uint32_t ulIsrHist[ traceMAX_IRQ ][ traceHIST_BINS ];
+static uint32_t ulTickLatencyHist[ traceHIST_BINS ];
+/*-----------------------------------------------------------*/
+
+static uint32_t prvBin( uint32_t ulCount )
+{
+    uint32_t ulBin = 0;
+
+    while( ( ulCount != 0 ) && ( ulBin < traceHIST_BINS - 1 ) )
+    {
+        ulCount >>= 1;
+        ulBin++;
+    }
+    return ulBin;
+}
+
+/* Run-time counter periods to microseconds, for reports only */
+static uint32_t prvToUs( uint32_t ulCount )
+{
+    return ( uint32_t ) ( ( ( uint64_t ) ulCount * 1000000UL ) / portRUN_TIME_HZ );
+}
+/*-----------------------------------------------------------*/
+
+static void prvWrite( uint32_t ulTime, uint8_t ucEvent, uint8_t ucArg, uint16_t usId )
+{
+    xTraceRecord *pxRec;
+    uint32_t ulState;
+
+    ulState = prvMaskIrq();
+    pxRec = &xRing[ ulHead & ( traceRING_RECORDS - 1 ) ];
+    pxRec->ulTime = ulTime;
+    pxRec->ucEvent = ucEvent;
+    pxRec->ucArg = ucArg;
+    pxRec->usId = usId;
+    ulHead++;
+    prvRestoreIrq( ulState );
+}
+/*-----------------------------------------------------------*/
+
+void vTraceRecord( uint8_t ucEvent, uint8_t ucArg, uint16_t usId )
+{
+    if( ulEnabled != 0 )
+    {
+        prvWrite( ulPortGetRunTimeCounter(), ucEvent, ucArg, usId );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTraceTaskCreate( uint32_t ulNumber, const char *pcName )
+{
+    strncpy( cTaskNames[ ulNumber % traceMAX_TASKS ], pcName, configMAX_TASK_NAME_LEN - 1 );
+    vTraceRecord( traceEV_TASK_CREATE, 0, ( uint16_t ) ulNumber );
+}
+/*-----------------------------------------------------------*/
+
+/* Called by the port with IRQ disabled. ISRs do not nest in this port.
+The record of the tick interrupt carries its latency. */
+void vTraceIsrEnter( uint32_t ulIrq )
+{
+    uint32_t ulLatency = 0;
+
+    ulIsrStart = ulPortGetRunTimeCounter();
+    if( ulIrq == IRQ_TIMER5 )
+    {
+        ulLatency = ( ( inpw( REG_ETMR5_DR ) - inpw( REG_ETMR5_CMPR ) ) & portTIMEBASE_MASK ) >> portRUN_TIME_SHIFT;
+        ulTickLatencyHist[ prvBin( ulLatency ) ]++;
+    }
+    if( ulEnabled != 0 )
+    {
+        prvWrite( ulIsrStart, traceEV_ISR_ENTER, ( uint8_t ) ulIrq, ( uint16_t ) ( ( ulLatency > 0xFFFFUL ) ? 0xFFFFUL : ulLatency ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTraceIsrExit( uint32_t ulIrq )
+{
+    uint32_t ulNow = ulPortGetRunTimeCounter();
+
+    ulIsrHist[ ulIrq % traceMAX_IRQ ][ prvBin( ulNow - ulIsrStart ) ]++;
+    if( ulEnabled != 0 )
+    {
+        prvWrite( ulNow, traceEV_ISR_EXIT, ( uint8_t ) ulIrq, 0 );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTraceStart( void )
+{
+    ulHead = 0;
+    ulEnabled = 1;
+}
+/*-----------------------------------------------------------*/
+
+void vTraceStop( void )
+{
+    ulEnabled = 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrintHist( const char *pcName, const uint32_t *pulHist )
+{
+    uint32_t i;
+
+    printf( "%-10s", pcName );
+    for( i = 0; i < traceHIST_BINS; i++ )
+    {
+        printf( " %6d", ( int ) pulHist[ i ] );
+    }
+    printf( "\n" );
+}
+
+void vTraceReport( void )
+{
+    static TaskStatus_t xTasks[ traceMAX_TASKS ];
+    char cName[ 12 ];
+    uint32_t i, j, ulTotal, ulTasks;
+
+    ulTasks = uxTaskGetSystemState( xTasks, traceMAX_TASKS, &ulTotal );
+    printf( "Task          Time(us)        CPU\n" );
+    for( i = 0; i < ulTasks; i++ )
+    {
+        printf( "%-12s  %10u  %8u%%\n", xTasks[ i ].pcTaskName,
+                ( unsigned ) prvToUs( xTasks[ i ].ulRunTimeCounter ),
+                ( unsigned ) ( ulTotal ? ( uint64_t ) xTasks[ i ].ulRunTimeCounter * 100 / ulTotal : 0 ) );
+    }
+
+    printf( "%-10s", "Run (us)" );
+    for( j = 0; j < traceHIST_BINS - 1; j++ )
+    {
+        printf( " %6u", ( unsigned ) prvToUs( j ? 1UL << ( j - 1 ) : 0 ) );
+    }
+    printf( " %5u+\n", ( unsigned ) prvToUs( 1UL << ( traceHIST_BINS - 2 ) ) );
+    for( i = 0; i < traceMAX_IRQ; i++ )
+    {
+        for( j = 0; j < traceHIST_BINS; j++ )
+        {
+            if( ulIsrHist[ i ][ j ] != 0 )
+            {
+                sprintf( cName, "IRQ %d", ( int ) i );
+                prvPrintHist( cName, ulIsrHist[ i ] );
+                break;
+            }
+        }
+    }
+    prvPrintHist( "Tick lat.", ulTickLatencyHist );
+}
+/*-----------------------------------------------------------*/
+
+void vTraceDump( void )
+{
+    xTraceRecord xRec;
+    uint32_t ulFirst, ulLast, i;
+
+    vTraceStop();
+    ulLast = ulHead;
+    ulFirst = ( ulLast > traceRING_RECORDS ) ? ulLast - traceRING_RECORDS : 0;
+
+    printf( "\n--- trace dump begin ---\n" );
+    printf( "hz %u\ntick %d\n", ( unsigned ) portRUN_TIME_HZ, ( int ) IRQ_TIMER5 );
+    for( i = 0; i < traceMAX_TASKS; i++ )
+    {
+        if( cTaskNames[ i ][ 0 ] != '\0' )
+        {
+            printf( "task %u %s\n", ( unsigned ) i, cTaskNames[ i ] );
+        }
+    }
+    for( ; ulFirst != ulLast; ulFirst++ )
+    {
+        xRec = xRing[ ulFirst & ( traceRING_RECORDS - 1 ) ];
+        printf( "%08x %02x %02x %04x\n", ( unsigned ) xRec.ulTime, xRec.ucEvent, xRec.ucArg, xRec.usId );
+    }
+    printf( "--- trace dump end ---\n" );
+
+    vTraceStart();
+}
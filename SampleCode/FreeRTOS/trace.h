@@ -0,0 +1,47 @@
+/*
+ * trace.h - Binary trace ring for task switches, interrupts and queues
+ *
+ * Included by FreeRTOSConfig.h, so it must not include FreeRTOS headers.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+/* Records in the ring, a power of two. Each record is 8 bytes. */
+#define traceRING_RECORDS       4096
+
+/* Record types */
+#define traceEV_TASK_SWITCH     1   /* usId: task number */
+#define traceEV_TASK_CREATE     2   /* usId: task number */
+#define traceEV_ISR_ENTER       4   /* ucArg: interrupt number, usId: latency of the tick interrupt */
+#define traceEV_ISR_EXIT        5   /* ucArg: interrupt number */
+#define traceEV_QUEUE_SEND      6   /* usId: queue, ucArg: queue type (semaphores and mutexes are queues) */
+#define traceEV_QUEUE_RECEIVE   7
+#define traceEV_QUEUE_SEND_ISR  8
+#define traceEV_QUEUE_RECV_ISR  9
+#define traceEV_QUEUE_BLOCK     10  /* Task blocks on a full or empty queue */
+#define traceEV_QUEUE_FAILED    11  /* Send or receive timed out */
+
+typedef struct
+{
+    uint32_t ulTime;            /* Run-time counter of the port, portRUN_TIME_HZ */
+    uint8_t ucEvent;
+    uint8_t ucArg;
+    uint16_t usId;
+} xTraceRecord;
+
+void vTraceRecord( uint8_t ucEvent, uint8_t ucArg, uint16_t usId );
+void vTraceTaskCreate( uint32_t ulNumber, const char *pcName );
+void vTraceIsrEnter( uint32_t ulIrq );
+void vTraceIsrExit( uint32_t ulIrq );
+void vTraceStart( void );
+void vTraceStop( void );
+void vTraceReport( void );
+void vTraceDump( void );
+
+/* Queue handles are shortened to 16 bits for the record */
+#define traceQUEUE_ID( pxQueue )    ( ( uint16_t ) ( ( uint32_t ) ( pxQueue ) >> 3 ) )
+
+#endif /* TRACE_H */
@@ -0,0 +1,31 @@
+/**************************************************************************//**
+ * @file     sys_arch.h
+ * @brief    LwIP system architecture header for FreeRTOS
+ *
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __SYS_ARCH_H__
+#define __SYS_ARCH_H__
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+/* Semaphores, mutexes and mailboxes are FreeRTOS handles, NULL when invalid */
+typedef SemaphoreHandle_t   sys_sem_t;
+typedef SemaphoreHandle_t   sys_mutex_t;
+typedef QueueHandle_t       sys_mbox_t;
+typedef TaskHandle_t        sys_thread_t;
+
+#define SYS_MBOX_NULL       NULL
+#define SYS_SEM_NULL        NULL
+
+#define sys_sem_valid(sem)              (*(sem) != NULL)
+#define sys_sem_set_invalid(sem)        do { *(sem) = NULL; } while (0)
+#define sys_mutex_valid(mutex)          (*(mutex) != NULL)
+#define sys_mutex_set_invalid(mutex)    do { *(mutex) = NULL; } while (0)
+#define sys_mbox_valid(mbox)            (*(mbox) != NULL)
+#define sys_mbox_set_invalid(mbox)      do { *(mbox) = NULL; } while (0)
+
+#endif /* __SYS_ARCH_H__ */
@@ -0,0 +1,98 @@
+/**
+ * @file
+ *
+ * lwIP Options Configuration
+ */
+
+/*
+ * Copyright (c) 2001-2004 Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ * Author: Adam Dunkels <adam@sics.se>
+ *
+ */
+#ifndef __LWIPOPTS_H__
+#define __LWIPOPTS_H__
+
+/*
+ * Include user defined options first. Anything not defined in these files
+ * will be set to standard values. Override anything you dont like!
+ */
+
+// lwIP runs in its own thread (tcpip_thread) on FreeRTOS, see sys_arch.c
+#define NO_SYS                          0
+#define SYS_LIGHTWEIGHT_PROT            1
+#define MEM_ALIGNMENT                   4
+#define LWIP_STATS                      0
+#define LWIP_NETCONN                    1
+#define LWIP_SOCKET                     1
+#define LWIP_SO_RCVTIMEO                1
+#define LWIP_NETIF_API                  0
+
+// Applications call into the stack under the core lock instead of posting a
+// message to tcpip_thread. The EMAC RX task takes the lock once per burst of
+// frames and calls ethernet_input() directly, see ethernetif.c.
+#define LWIP_TCPIP_CORE_LOCKING         1
+#define LWIP_TCPIP_CORE_LOCKING_INPUT   1
+
+// Threads, priorities are FreeRTOS priorities (configMAX_PRIORITIES is 6)
+// and stack sizes are in bytes
+#define TCPIP_THREAD_NAME               "tcpip"
+#define TCPIP_THREAD_PRIO               4
+#define TCPIP_THREAD_STACKSIZE          2048
+#define TCPIP_MBOX_SIZE                 16
+#define DEFAULT_THREAD_PRIO             2
+#define DEFAULT_THREAD_STACKSIZE        2048
+#define DEFAULT_RAW_RECVMBOX_SIZE       8
+#define DEFAULT_UDP_RECVMBOX_SIZE       8
+#define DEFAULT_TCP_RECVMBOX_SIZE       16
+#define DEFAULT_ACCEPTMBOX_SIZE         4
+
+// Needs 1 more for detect EMAC link status
+#define MEMP_NUM_SYS_TIMEOUT            1 + (LWIP_TCP + IP_REASSEMBLY + LWIP_ARP + (2*LWIP_DHCP) + LWIP_AUTOIP + LWIP_IGMP + LWIP_DNS + (PPP_SUPPORT*6*MEMP_NUM_PPP_PCB) + (LWIP_IPV6 ? (1 + LWIP_IPV6_REASS + LWIP_IPV6_MLD) : 0))
+
+// TCP sized like the NO_SYS httpd sample, so lwiperf results compare
+#define MEM_SIZE                        (32 * 1024)
+#define TCP_MSS                         1460
+#define TCP_WND                         (4 * TCP_MSS)
+#define TCP_SND_BUF                     (8 * TCP_MSS)
+#define TCP_SND_QUEUELEN                (4 * TCP_SND_BUF / TCP_MSS)
+#define MEMP_NUM_TCP_PCB                8
+#define MEMP_NUM_TCP_SEG                64
+#define MEMP_NUM_PBUF                   64
+#define PBUF_POOL_SIZE                  32
+#define MEMP_NUM_NETCONN                8
+#define MEMP_NUM_NETBUF                 8
+
+// Copies and checksums use the LDM/STM kernels of the SYS driver (memops.c).
+// Segment checksums are computed while tcp_write() copies the data.
+#define MEMCPY(dst,src,len)             sysMemCopy(dst,src,len)
+#define LWIP_CHKSUM                     sysChksum
+#define LWIP_CHECKSUM_ON_COPY           1
+#define LWIP_CHKSUM_COPY(dst,src,len)   sysChksumCopy(dst,src,len)
+
+#endif /* __LWIPOPTS_H__ */
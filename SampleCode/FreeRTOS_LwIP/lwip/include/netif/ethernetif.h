@@ -0,0 +1,26 @@
+/**************************************************************************//**
+ * @file     ethernetif.h
+ * @brief    Ethernet interface header
+ *
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __ETHERNETIF_H__
+#define __ETHERNETIF_H__
+
+
+#include "lwip/err.h"
+#include "lwip/netif.h"
+
+typedef struct
+{
+    u32_t   rx_irq;     /* RX interrupts */
+    u32_t   rx_frames;  /* Frames passed to lwIP */
+    u32_t   rx_locks;   /* Core locks taken by the RX task */
+    u32_t   rx_drop;    /* Frames dropped for lack of pbufs */
+    u32_t   tx_wait;    /* Waits for a free TX descriptor */
+} ETHIF_STAT;
+
+err_t ethernetif_init(struct netif *netif);
+void ethernetif_get_stat(ETHIF_STAT *st, int reset);
+
+#endif
@@ -0,0 +1,223 @@
+/**************************************************************************//**
+ * @file     ethernetif.c
+ * @brief    EMAC0 network interface for lwIP running on FreeRTOS
+ *
+ * The RX interrupt only wakes the RX task. The task copies every frame in
+ * the descriptor ring into a pool pbuf and returns the descriptor, then
+ * takes the lwIP core lock once and hands the whole burst to
+ * ethernet_input(). Frames do not go through the tcpip_thread mailbox.
+ *
+ * Output runs under the core lock. When all TX descriptors are busy it
+ * waits for the TX interrupt instead of dropping the frame.
+ *
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <string.h>
+
+#include "lwip/opt.h"
+#include "lwip/def.h"
+#include "lwip/mem.h"
+#include "lwip/pbuf.h"
+#include "lwip/sys.h"
+#include "lwip/tcpip.h"
+#include "lwip/stats.h"
+#include "lwip/snmp.h"
+#include "netif/etharp.h"
+#include "netif/eth.h"
+#include "netif/ethernetif.h"
+
+/* Define those to better describe your network interface. */
+#define IFNAME0 'e'
+#define IFNAME1 '0'
+
+#define ETH_RX_TASK_PRIO        (TCPIP_THREAD_PRIO + 1)
+#define ETH_RX_TASK_STACK       1024        /* Bytes */
+#define ETH_RX_BURST            8           /* Frames passed to lwIP per core lock */
+#define ETH_TX_WAIT_MS          10          /* Longest wait for a free TX descriptor */
+
+extern u8_t my_mac_addr0[6];
+
+static struct netif *_netif0;
+static TaskHandle_t rx_task;
+static SemaphoreHandle_t tx_sem;
+static ETHIF_STAT stat;
+
+/* Per frame: RX copy into a pool pbuf, TX copy into a descriptor buffer */
+SYS_PROF_DEFINE(s_sProfRx, "emac rx")
+SYS_PROF_DEFINE(s_sProfTx, "emac tx")
+
+
+/* Called by ETH0_RX_IRQHandler() with the RX interrupt masked */
+void ethernetif_rx_irq0(void)
+{
+    BaseType_t woken = pdFALSE;
+
+    stat.rx_irq++;
+    if (rx_task != NULL)
+        vTaskNotifyGiveFromISR(rx_task, &woken);
+    portEXIT_SWITCHING_ISR(woken);
+}
+
+/* Called by ETH0_TX_IRQHandler() when descriptors are released */
+void ethernetif_tx_irq0(void)
+{
+    BaseType_t woken = pdFALSE;
+
+    if (tx_sem != NULL)
+        xSemaphoreGiveFromISR(tx_sem, &woken);
+    portEXIT_SWITCHING_ISR(woken);
+}
+
+/**
+ * Copy the frames waiting in the RX ring into pbufs and pass them to lwIP,
+ * ETH_RX_BURST frames per core lock.
+ */
+static void ethernetif_rx_task(void *arg)
+{
+    struct pbuf *burst[ETH_RX_BURST];
+    struct pbuf *p, *q;
+    u8_t    *buf;
+    int     len, n, i;
+
+    LWIP_UNUSED_ARG(arg);
+
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        do
+        {
+            for (n = 0; n < ETH_RX_BURST; n++)
+            {
+                len = ETH0_get_rx_frame(&buf);
+                if (len < 0)
+                    break;
+
+                SYS_PROF_BEGIN(s_sProfRx);
+                p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
+                if (p != NULL)
+                {
+                    for (q = p; q != NULL; q = q->next)
+                    {
+                        MEMCPY(q->payload, buf, q->len);
+                        buf += q->len;
+                    }
+                    LINK_STATS_INC(link.recv);
+                }
+                else
+                {
+                    LINK_STATS_INC(link.memerr);
+                    LINK_STATS_INC(link.drop);
+                    stat.rx_drop++;
+                }
+                ETH0_release_rx_frame();
+                SYS_PROF_END(s_sProfRx);
+                burst[n] = p;
+            }
+
+            if (n)
+            {
+                LOCK_TCPIP_CORE();
+                for (i = 0; i < n; i++)
+                {
+                    if ((burst[i] != NULL) && (ethernet_input(burst[i], _netif0) != ERR_OK))
+                        pbuf_free(burst[i]);
+                }
+                UNLOCK_TCPIP_CORE();
+                stat.rx_frames += n;
+                stat.rx_locks++;
+            }
+        }
+        while (n == ETH_RX_BURST);
+
+        /* Ring is empty. A frame arriving from here on raises the interrupt. */
+        ETH0_enable_rx_irq();
+    }
+}
+
+/**
+ * Transmit a frame, called by lwIP with the core locked.
+ */
+static err_t low_level_output0(struct netif *netif, struct pbuf *p)
+{
+    struct pbuf *q;
+    u8_t *buf;
+    u16_t len = 0;
+
+    LWIP_UNUSED_ARG(netif);
+
+    while ((buf = ETH0_get_tx_buf()) == NULL)
+    {
+        stat.tx_wait++;
+        if (xSemaphoreTake(tx_sem, ETH_TX_WAIT_MS / portTICK_PERIOD_MS) != pdTRUE)
+        {
+            LINK_STATS_INC(link.memerr);
+            return ERR_MEM;
+        }
+    }
+
+    SYS_PROF_BEGIN(s_sProfTx);
+    for (q = p; q != NULL; q = q->next)
+    {
+        MEMCPY(&buf[len], q->payload, q->len);
+        len = len + q->len;
+    }
+
+    ETH0_trigger_tx(len, NULL);
+    SYS_PROF_END(s_sProfTx);
+    LINK_STATS_INC(link.xmit);
+
+    return ERR_OK;
+}
+
+void ethernetif_get_stat(ETHIF_STAT *st, int reset)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    *st = stat;
+    if (reset)
+        memset(&stat, 0, sizeof(stat));
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+/**
+ * Set up EMAC0 and start the RX task. Pass to netif_add() with tcpip_input()
+ * as the input function.
+ */
+err_t ethernetif_init(struct netif *netif)
+{
+    LWIP_ASSERT("netif != NULL", (netif != NULL));
+
+    _netif0 = netif;
+
+#if LWIP_NETIF_HOSTNAME
+    /* Initialize interface hostname */
+    netif->hostname = "nvt";
+#endif /* LWIP_NETIF_HOSTNAME */
+
+    NETIF_INIT_SNMP(netif, snmp_ifType_ethernet_csmacd, 100000000);
+
+    netif->name[0] = IFNAME0;
+    netif->name[1] = IFNAME1;
+    netif->output = etharp_output;
+    netif->linkoutput = low_level_output0;
+
+    netif->hwaddr_len = ETHARP_HWADDR_LEN;
+    memcpy(netif->hwaddr, my_mac_addr0, ETHARP_HWADDR_LEN);
+    netif->mtu = 1500;
+    netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_LINK_UP;
+#if LWIP_IGMP
+    netif->flags |= NETIF_FLAG_IGMP;
+#endif
+
+    tx_sem = xSemaphoreCreateBinary();
+    if (tx_sem == NULL)
+        return ERR_MEM;
+    rx_task = sys_thread_new("eth0rx", ethernetif_rx_task, NULL, ETH_RX_TASK_STACK, ETH_RX_TASK_PRIO);
+    if (rx_task == NULL)
+        return ERR_MEM;
+
+    ETH0_init(netif->hwaddr);
+
+    return ERR_OK;
+}
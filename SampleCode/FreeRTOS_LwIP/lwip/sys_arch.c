@@ -0,0 +1,206 @@
+/**************************************************************************//**
+ * @file     sys_arch.c
+ * @brief    LwIP system architecture file for FreeRTOS
+ *
+ * Semaphores and mutexes are FreeRTOS semaphores, mailboxes are queues of
+ * pointers and threads are tasks. Timeouts are in milliseconds, 0 means
+ * wait forever. sys_arch_protect() masks IRQ like the NO_SYS port, so it
+ * nests and is also safe from interrupt handlers.
+ *
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include "nuc980.h"
+#include "sys.h"
+#include "lwip/opt.h"
+#include "lwip/sys.h"
+#include "lwip/err.h"
+
+#define SYS_MBOX_DEFAULT_SIZE   16      /* Entries of a mailbox created with size 0 */
+
+/* errno of the socket API. Shared by all tasks, read it before the next call. */
+int errno;
+
+static TickType_t ms_to_ticks(u32_t timeout)
+{
+    TickType_t ticks;
+
+    if (timeout == 0)
+        return portMAX_DELAY;
+    ticks = timeout / portTICK_PERIOD_MS;
+    return ticks ? ticks : 1;
+}
+
+static u32_t elapsed_ms(TickType_t start)
+{
+    return (u32_t)(xTaskGetTickCount() - start) * portTICK_PERIOD_MS;
+}
+
+void sys_init(void)
+{
+}
+
+u32_t sys_now(void)
+{
+    return (u32_t)xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+sys_prot_t sys_arch_protect(void)
+{
+    int _old, _new;
+#if defined ( __GNUC__ ) && !(__CC_ARM)
+
+    asm volatile (" mrs %0, cpsr" : "=r" (_old) :  );
+    _new = _old | 0x80;
+    asm volatile (" msr cpsr, %0":  :"r" (_new));
+
+#else
+    __asm
+    {
+        MRS    _old, CPSR
+        ORR    _new, _old, DISABLE_FIQ_IRQ
+        MSR    CPSR_c, _new
+    }
+#endif
+    return(_old);
+}
+
+void sys_arch_unprotect(sys_prot_t pval)
+{
+#if defined ( __GNUC__ ) && !(__CC_ARM)
+
+    asm volatile (" msr cpsr, %0":  :"r" (pval));
+
+#else
+    __asm
+    {
+        MSR    CPSR_c, pval
+    }
+#endif
+    return;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Semaphores                                                                */
+/*---------------------------------------------------------------------------*/
+
+err_t sys_sem_new(sys_sem_t *sem, u8_t count)
+{
+    *sem = xSemaphoreCreateBinary();
+    if (*sem == NULL)
+        return ERR_MEM;
+    if (count)
+        xSemaphoreGive(*sem);
+    return ERR_OK;
+}
+
+void sys_sem_signal(sys_sem_t *sem)
+{
+    xSemaphoreGive(*sem);
+}
+
+u32_t sys_arch_sem_wait(sys_sem_t *sem, u32_t timeout)
+{
+    TickType_t start = xTaskGetTickCount();
+
+    if (xSemaphoreTake(*sem, ms_to_ticks(timeout)) != pdTRUE)
+        return SYS_ARCH_TIMEOUT;
+    return elapsed_ms(start);
+}
+
+void sys_sem_free(sys_sem_t *sem)
+{
+    vSemaphoreDelete(*sem);
+    *sem = NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Mutexes, with priority inheritance. LOCK_TCPIP_CORE() uses one of these.  */
+/*---------------------------------------------------------------------------*/
+
+err_t sys_mutex_new(sys_mutex_t *mutex)
+{
+    *mutex = xSemaphoreCreateMutex();
+    return (*mutex == NULL) ? ERR_MEM : ERR_OK;
+}
+
+void sys_mutex_lock(sys_mutex_t *mutex)
+{
+    xSemaphoreTake(*mutex, portMAX_DELAY);
+}
+
+void sys_mutex_unlock(sys_mutex_t *mutex)
+{
+    xSemaphoreGive(*mutex);
+}
+
+void sys_mutex_free(sys_mutex_t *mutex)
+{
+    vSemaphoreDelete(*mutex);
+    *mutex = NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Mailboxes                                                                 */
+/*---------------------------------------------------------------------------*/
+
+err_t sys_mbox_new(sys_mbox_t *mbox, int size)
+{
+    *mbox = xQueueCreate(size ? size : SYS_MBOX_DEFAULT_SIZE, sizeof(void *));
+    return (*mbox == NULL) ? ERR_MEM : ERR_OK;
+}
+
+void sys_mbox_post(sys_mbox_t *mbox, void *msg)
+{
+    xQueueSendToBack(*mbox, &msg, portMAX_DELAY);
+}
+
+err_t sys_mbox_trypost(sys_mbox_t *mbox, void *msg)
+{
+    return (xQueueSendToBack(*mbox, &msg, 0) == pdTRUE) ? ERR_OK : ERR_MEM;
+}
+
+u32_t sys_arch_mbox_fetch(sys_mbox_t *mbox, void **msg, u32_t timeout)
+{
+    TickType_t start = xTaskGetTickCount();
+    void    *dummy;
+
+    if (xQueueReceive(*mbox, msg ? msg : &dummy, ms_to_ticks(timeout)) != pdTRUE)
+    {
+        if (msg)
+            *msg = NULL;
+        return SYS_ARCH_TIMEOUT;
+    }
+    return elapsed_ms(start);
+}
+
+u32_t sys_arch_mbox_tryfetch(sys_mbox_t *mbox, void **msg)
+{
+    void    *dummy;
+
+    if (xQueueReceive(*mbox, msg ? msg : &dummy, 0) != pdTRUE)
+        return SYS_MBOX_EMPTY;
+    return 0;
+}
+
+void sys_mbox_free(sys_mbox_t *mbox)
+{
+    vQueueDelete(*mbox);
+    *mbox = NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Threads                                                                   */
+/*---------------------------------------------------------------------------*/
+
+/* stacksize is in bytes, prio is a FreeRTOS priority */
+sys_thread_t sys_thread_new(const char *name, lwip_thread_fn thread, void *arg, int stacksize, int prio)
+{
+    TaskHandle_t handle;
+
+    if (xTaskCreate(thread, name, stacksize / sizeof(StackType_t), arg, prio, &handle) != pdPASS)
+    {
+        LWIP_ASSERT("sys_thread_new: out of memory", 0);
+        return NULL;
+    }
+    return handle;
+}
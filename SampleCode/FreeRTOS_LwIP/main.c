@@ -0,0 +1,224 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @brief    LwIP on FreeRTOS with the netconn and socket APIs
+ *
+ * lwIP runs in tcpip_thread. EMAC0 frames are read by an RX task and passed
+ * to the stack under the core lock (see lwip/netif/ethernetif.c).
+ * Services on 192.168.0.227:
+ *   - lwiperf (iperf 2) TCP server on port 5001, raw API.
+ *     Measure throughput with "iperf -c 192.168.0.227 -t 10". The
+ *     EMAC_LwIP_httpd sample runs the same server on the NO_SYS stack.
+ *   - TCP echo on port 7, a task using the netconn API.
+ *   - UDP echo on port 7, a task using the socket API. Send small datagrams
+ *     one at a time to measure round trip latency.
+ *
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "nuc980.h"
+#include "sys.h"
+#include "netif/ethernetif.h"
+#include "lwip/tcpip.h"
+#include "lwip/netif.h"
+#include "lwip/timeouts.h"
+#include "lwip/api.h"
+#include "lwip/tcp.h"
+#include "lwip/sockets.h"
+#include "lwip/apps/lwiperf.h"
+
+#define ECHO_PORT           7
+#define ECHO_TASK_PRIO      2
+#define ECHO_TASK_STACK     2048        /* Bytes */
+#define STAT_PERIOD_MS      5000
+
+unsigned char my_mac_addr0[6] = {0x00, 0x00, 0x00, 0x55, 0x66, 0x77};
+
+static struct netif netif0;
+
+extern void chk_link0(void *arg);
+extern void vPortYieldProcessor(void);
+
+/* Print the result of a finished iperf session */
+static void iperf_report(void *arg, enum lwiperf_report_type report_type,
+                         const ip_addr_t *local_addr, u16_t local_port, const ip_addr_t *remote_addr, u16_t remote_port,
+                         u32_t bytes_transferred, u32_t ms_duration, u32_t bandwidth_kbitpsec)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(local_addr);
+    LWIP_UNUSED_ARG(local_port);
+    LWIP_UNUSED_ARG(remote_port);
+
+    printf("iperf %s: %d KB in %d ms, %d kbit/s (result %d)\n", ipaddr_ntoa(remote_addr),
+           (int)(bytes_transferred / 1024), (int)ms_duration, (int)bandwidth_kbitpsec, (int)report_type);
+}
+
+/* Runs in tcpip_thread once the stack is up */
+static void net_init(void *arg)
+{
+    ip4_addr_t gw, ipaddr, netmask;
+
+    IP4_ADDR(&gw, 192, 168, 0, 1);
+    IP4_ADDR(&ipaddr, 192, 168, 0, 227);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+
+    netif_add(&netif0, &ipaddr, &netmask, &gw, NULL, ethernetif_init, tcpip_input);
+    netif_set_default(&netif0);
+    netif_set_up(&netif0);
+
+    lwiperf_start_tcp_server_default(iperf_report, NULL);
+    sys_timeout(2000, chk_link0, NULL);
+
+    sys_sem_signal((sys_sem_t *)arg);
+}
+
+/* TCP echo, one connection at a time, netconn API */
+static void tcp_echo_task(void *arg)
+{
+    struct netconn *listener, *conn;
+    struct netbuf *nb;
+    void    *data;
+    u16_t   len;
+
+    LWIP_UNUSED_ARG(arg);
+
+    listener = netconn_new(NETCONN_TCP);
+    netconn_bind(listener, IP_ADDR_ANY, ECHO_PORT);
+    netconn_listen(listener);
+
+    while (1)
+    {
+        if (netconn_accept(listener, &conn) != ERR_OK)
+            continue;
+        /* Raw API calls from a task need the core lock */
+        LOCK_TCPIP_CORE();
+        tcp_nagle_disable(conn->pcb.tcp);
+        UNLOCK_TCPIP_CORE();
+
+        while (netconn_recv(conn, &nb) == ERR_OK)
+        {
+            do
+            {
+                netbuf_data(nb, &data, &len);
+                netconn_write(conn, data, len, NETCONN_COPY);
+            }
+            while (netbuf_next(nb) >= 0);
+            netbuf_delete(nb);
+        }
+        netconn_close(conn);
+        netconn_delete(conn);
+    }
+}
+
+/* UDP echo, socket API */
+static void udp_echo_task(void *arg)
+{
+    static char buf[1472];
+    struct sockaddr_in addr;
+    socklen_t addrlen;
+    int     s, len;
+
+    LWIP_UNUSED_ARG(arg);
+
+    s = socket(AF_INET, SOCK_DGRAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(ECHO_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    bind(s, (struct sockaddr *)&addr, sizeof(addr));
+
+    while (1)
+    {
+        addrlen = sizeof(addr);
+        len = recvfrom(s, buf, sizeof(buf), 0, (struct sockaddr *)&addr, &addrlen);
+        if (len > 0)
+            sendto(s, buf, len, 0, (struct sockaddr *)&addr, addrlen);
+    }
+}
+
+/* Bring up the stack, start the services and report the RX path */
+static void main_task(void *arg)
+{
+    sys_sem_t   done;
+    ETHIF_STAT  st;
+
+    LWIP_UNUSED_ARG(arg);
+
+    sys_sem_new(&done, 0);
+    tcpip_init(net_init, &done);
+    sys_sem_wait(&done);
+    sys_sem_free(&done);
+    printf("lwIP is up, %s\n", ip4addr_ntoa(netif_ip4_addr(&netif0)));
+
+    sys_thread_new("tcpecho", tcp_echo_task, NULL, ECHO_TASK_STACK, ECHO_TASK_PRIO);
+    sys_thread_new("udpecho", udp_echo_task, NULL, ECHO_TASK_STACK, ECHO_TASK_PRIO);
+
+    while (1)
+    {
+        vTaskDelay(STAT_PERIOD_MS / portTICK_PERIOD_MS);
+        ethernetif_get_stat(&st, 1);
+        if (st.rx_frames == 0)
+            continue;
+        printf("eth0: %d frames/s, %d frames per interrupt, %d per core lock, %d dropped, %d TX waits\n",
+               (int)(st.rx_frames * 1000 / STAT_PERIOD_MS), (int)(st.rx_frames / (st.rx_irq ? st.rx_irq : 1)),
+               (int)(st.rx_frames / (st.rx_locks ? st.rx_locks : 1)), (int)st.rx_drop, (int)st.tx_wait);
+    }
+}
+
+static void prvSetupHardware(void)
+{
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);   // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+
+    if (sysLockFastCode() != Successful)
+        printf("sysLockFastCode failed, interrupt paths are not locked in the I-cache\n");
+
+    sysSetLocalInterrupt(ENABLE_IRQ);
+}
+
+int main(void)
+{
+    sysInstallExceptionHandler(SYS_SWI, vPortYieldProcessor);
+    prvSetupHardware();
+
+    printf("lwIP on FreeRTOS\n");
+    xTaskCreate(main_task, "main", 2048 / sizeof(StackType_t), NULL, ECHO_TASK_PRIO + 1, NULL);
+
+    vTaskStartScheduler();
+
+    /* Only reached when there is not enough heap for the idle task */
+    for( ;; );
+}
+
+void vApplicationMallocFailedHook( void )
+{
+    printf("Out of FreeRTOS heap\n");
+    taskDISABLE_INTERRUPTS();
+    for( ;; );
+}
+
+void vApplicationStackOverflowHook( TaskHandle_t pxTask, char *pcTaskName )
+{
+    ( void ) pxTask;
+
+    printf("Stack overflow in %s\n", pcTaskName);
+    taskDISABLE_INTERRUPTS();
+    for( ;; );
+}
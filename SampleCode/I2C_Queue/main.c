@@ -0,0 +1,303 @@
+/**************************************************************************//**
+* @file     main.c
+* @brief    Interrupt-driven I2C transactions with i2cqueue.c against the
+*           blocking helpers of i2c.c, on a 24LC64 EEPROM at I2C0 (SDA:GPA0,
+*           SCL:GPA1): 1 KB written page by page and read back, then a
+*           64-entry register table, as a sensor or codec is initialised.
+*           Write cycles are polled with retries on the not acknowledged
+*           address. Overwrites EEPROM 0x0000 ~ 0x043F.
+*
+* @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+#include "gpio.h"
+#include "i2c.h"
+
+#define EEPROM_ADDR     0x50
+#define ABSENT_ADDR     0x18
+#define BUS_CLOCK       100000
+#define PAGE_SIZE       32
+#define PAGES           32
+#define READ_SIZE       256
+#define TABLE_REG       0x0400
+#define TABLE_SIZE      64
+#define POLL_RETRIES    200         /* One try takes 0.1 ms at 100 kHz, a write cycle up to 5 ms */
+#define TICKS_PER_SEC   12000000    /* ETIMER0 counts the 12 MHz crystal */
+
+static uint8_t au8Tx[PAGES * PAGE_SIZE];
+static uint8_t au8Rx[PAGES * PAGE_SIZE];
+static uint8_t au8Addr[PAGES][2];
+static uint8_t au8ReadAddr[PAGES * PAGE_SIZE / READ_SIZE][2];
+static I2C_MSG_T asPageMsg[PAGES][2];
+static I2C_MSG_T asReadMsg[PAGES * PAGE_SIZE / READ_SIZE][2];
+static I2C_XFER_T asPage[PAGES];
+static I2C_XFER_T asRead[PAGES * PAGE_SIZE / READ_SIZE];
+static I2C_REG_T asTable[TABLE_SIZE];
+static I2C_QUEUE_T sQueue;
+static volatile uint32_t u32Callbacks;
+
+static uint32_t clock_12m(void)
+{
+    return ETIMER_GetCounter(0);
+}
+
+static uint32_t elapsed_us(uint32_t t0)
+{
+    return ((ETIMER_GetCounter(0) - t0) & 0xFFFFFF) / 12;
+}
+
+static void delay_us(uint32_t u32Us)
+{
+    uint32_t t0 = ETIMER_GetCounter(0);
+
+    while (elapsed_us(t0) < u32Us);
+}
+
+/* Clock SCL by GPIO until a slave stuck in a read lets SDA go, then send a STOP */
+static void bus_clear(I2C_T *i2c)
+{
+    int i;
+
+    outpw(REG_SYS_GPA_MFPL, inpw(REG_SYS_GPA_MFPL) & 0xffffff00);
+    GPIO_SetMode(PA, BIT0, GPIO_MODE_INPUT);
+    GPIO_SetMode(PA, BIT1, GPIO_MODE_OPEN_DRAIN);
+    for (i = 0; (i < 9) && (PA0 == 0); i++)
+    {
+        PA1 = 0;
+        delay_us(5);
+        PA1 = 1;
+        delay_us(5);
+    }
+    GPIO_SetMode(PA, BIT0, GPIO_MODE_OPEN_DRAIN);
+    PA0 = 0;
+    delay_us(5);
+    PA0 = 1;
+    outpw(REG_SYS_GPA_MFPL, (inpw(REG_SYS_GPA_MFPL) & 0xffffff00) | 0x33);
+}
+
+static void count_done(I2C_XFER_T *psXfer)
+{
+    u32Callbacks++;
+}
+
+static int32_t compare(const char *pcName, uint8_t *pu8Expect, uint32_t u32Len)
+{
+    uint32_t i;
+
+    for (i = 0; i < u32Len; i++)
+    {
+        if (au8Rx[i] != pu8Expect[i])
+        {
+            printf("%s: byte %d read 0x%02X, expected 0x%02X\n", pcName, i, au8Rx[i], pu8Expect[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void report(const char *pcName, uint32_t u32Us, uint32_t u32Ticks)
+{
+    printf("  %-28s %8d us, CPU %3d.%02d%%\n", pcName, u32Us,
+           u32Ticks == 0xFFFFFFFF ? 100 : u32Ticks / 12 * 100 / u32Us,
+           u32Ticks == 0xFFFFFFFF ? 0 : u32Ticks / 12 * 10000 / u32Us % 100);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Blocking helpers of i2c.c                                                                              */
+/*---------------------------------------------------------------------------------------------------------*/
+static void blocking(void)
+{
+    uint32_t i, t0, u32Us;
+
+    printf("Blocking, i2c.c\n");
+
+    /* A page write is refused while the previous one is programmed */
+    t0 = ETIMER_GetCounter(0);
+    for (i = 0; i < PAGES; i++)
+        while (I2C_WriteMultiBytesTwoRegs(I2C0, EEPROM_ADDR, i * PAGE_SIZE, &au8Tx[i * PAGE_SIZE], PAGE_SIZE) != PAGE_SIZE);
+    u32Us = elapsed_us(t0);
+    report("1 KB page writes", u32Us, 0xFFFFFFFF);
+
+    memset(au8Rx, 0, sizeof(au8Rx));
+    t0 = ETIMER_GetCounter(0);
+    for (i = 0; i < PAGES * PAGE_SIZE / READ_SIZE; i++)
+        while (I2C_ReadMultiBytesTwoRegs(I2C0, EEPROM_ADDR, i * READ_SIZE, &au8Rx[i * READ_SIZE], READ_SIZE) != READ_SIZE);
+    u32Us = elapsed_us(t0);
+    report("1 KB read back", u32Us, 0xFFFFFFFF);
+    compare("blocking read", au8Tx, PAGES * PAGE_SIZE);
+
+    t0 = ETIMER_GetCounter(0);
+    for (i = 0; i < TABLE_SIZE; i++)
+        while (I2C_WriteByteTwoRegs(I2C0, EEPROM_ADDR, asTable[i].u16Reg, (uint8_t)(asTable[i].u16Val ^ 0xFF)) != 0);
+    u32Us = elapsed_us(t0);
+    report("64-entry register table", u32Us, 0xFFFFFFFF);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Interrupt-driven queue                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static void queued(void)
+{
+    static uint8_t au8Expect[TABLE_SIZE];
+    I2C_XFER_T sTable, sAbsent;
+    I2C_MSG_T sAbsentMsg;
+    uint32_t i, t0, u32Us, u32Ticks, u32Loops;
+    int32_t i32Status;
+
+    printf("\nQueued, i2cqueue.c\n");
+
+    /* Every page is a 2-byte address and the data sent on without a START */
+    for (i = 0; i < PAGES; i++)
+    {
+        au8Addr[i][0] = (uint8_t)((i * PAGE_SIZE) >> 8);
+        au8Addr[i][1] = (uint8_t)(i * PAGE_SIZE);
+        asPageMsg[i][0].u8Addr = EEPROM_ADDR;
+        asPageMsg[i][0].u8Flags = 0;
+        asPageMsg[i][0].u16Len = 2;
+        asPageMsg[i][0].pu8Buf = au8Addr[i];
+        asPageMsg[i][1].u8Addr = EEPROM_ADDR;
+        asPageMsg[i][1].u8Flags = I2C_MSG_NOSTART;
+        asPageMsg[i][1].u16Len = PAGE_SIZE;
+        asPageMsg[i][1].pu8Buf = &au8Tx[i * PAGE_SIZE];
+        I2C_XferInit(&asPage[i], asPageMsg[i], 2);
+        asPage[i].u32Retries = POLL_RETRIES;
+        asPage[i].pfnDone = count_done;
+    }
+
+    /* Every read is the address written, then a repeated START */
+    for (i = 0; i < PAGES * PAGE_SIZE / READ_SIZE; i++)
+    {
+        au8ReadAddr[i][0] = (uint8_t)((i * READ_SIZE) >> 8);
+        au8ReadAddr[i][1] = (uint8_t)(i * READ_SIZE);
+        asReadMsg[i][0].u8Addr = EEPROM_ADDR;
+        asReadMsg[i][0].u8Flags = 0;
+        asReadMsg[i][0].u16Len = 2;
+        asReadMsg[i][0].pu8Buf = au8ReadAddr[i];
+        asReadMsg[i][1].u8Addr = EEPROM_ADDR;
+        asReadMsg[i][1].u8Flags = I2C_MSG_READ;
+        asReadMsg[i][1].u16Len = READ_SIZE;
+        asReadMsg[i][1].pu8Buf = &au8Rx[i * READ_SIZE];
+        I2C_XferInit(&asRead[i], asReadMsg[i], 2);
+        asRead[i].u32Retries = POLL_RETRIES;
+        asRead[i].pfnDone = count_done;
+    }
+
+    /* Queue the writes and reads at once, the CPU counts loop passes meanwhile */
+    memset(au8Rx, 0, sizeof(au8Rx));
+    u32Callbacks = 0;
+    u32Loops = 0;
+    sQueue.u32Ticks = 0;
+    t0 = ETIMER_GetCounter(0);
+    for (i = 0; i < PAGES; i++)
+        I2C_QueueSubmit(&sQueue, &asPage[i]);
+    for (i = 0; i < PAGES * PAGE_SIZE / READ_SIZE; i++)
+        I2C_QueueSubmit(&sQueue, &asRead[i]);
+    while (asRead[PAGES * PAGE_SIZE / READ_SIZE - 1].i32Status > 0)
+        u32Loops++;
+    u32Us = elapsed_us(t0);
+    u32Ticks = sQueue.u32Ticks;
+    report("1 KB page writes + read back", u32Us, u32Ticks);
+    printf("  %d transactions, %d callbacks, %d main loop passes meanwhile\n",
+           PAGES + PAGES * PAGE_SIZE / READ_SIZE, u32Callbacks, u32Loops);
+    for (i = 0; i < PAGES; i++)
+        if (asPage[i].i32Status != I2C_XFER_OK)
+            printf("  page %d: status %d\n", i, asPage[i].i32Status);
+    compare("queued read", au8Tx, PAGES * PAGE_SIZE);
+
+    /* Register table, one write cycle per entry */
+    I2C_XferInitRegTable(&sTable, EEPROM_ADDR, asTable, TABLE_SIZE, 2, 1);
+    sTable.u32Retries = POLL_RETRIES;
+    sQueue.u32Ticks = 0;
+    t0 = ETIMER_GetCounter(0);
+    I2C_QueueSubmit(&sQueue, &sTable);
+    i32Status = I2C_QueueWait(&sTable);
+    u32Us = elapsed_us(t0);
+    report("64-entry register table", u32Us, sQueue.u32Ticks);
+    printf("  status %d, %d entries written\n", i32Status, sTable.u32Done);
+
+    while (I2C_ReadMultiBytesTwoRegs(I2C0, EEPROM_ADDR, TABLE_REG, au8Rx, TABLE_SIZE) != TABLE_SIZE);
+    for (i = 0; i < TABLE_SIZE; i++)
+        au8Expect[i] = (uint8_t)asTable[i].u16Val;
+    compare("register table", au8Expect, TABLE_SIZE);
+
+    /* A missing slave ends with I2C_XFER_ERR_NACK once the retries are spent */
+    sAbsentMsg.u8Addr = ABSENT_ADDR;
+    sAbsentMsg.u8Flags = I2C_MSG_READ;
+    sAbsentMsg.u16Len = 1;
+    sAbsentMsg.pu8Buf = au8Rx;
+    I2C_XferInit(&sAbsent, &sAbsentMsg, 1);
+    sAbsent.u32Retries = 3;
+    I2C_QueueSubmit(&sQueue, &sAbsent);
+    printf("  slave 0x%02X: status %d, expected %d\n", ABSENT_ADDR, I2C_QueueWait(&sAbsent), I2C_XFER_ERR_NACK);
+}
+
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);   // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+int main(void)
+{
+    uint32_t i;
+
+    *((volatile unsigned int *)REG_AIC_INTDIS0)=0xFFFFFFFF;  // disable all interrupt channel
+    *((volatile unsigned int *)REG_AIC_INTDIS1)=0xFFFFFFFF;  // disable all interrupt channel
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+    UART_Init();
+
+    // Enable ETIMER0 engine clock
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 8));
+
+    // Free running counter at full 12 MHz resolution
+    ETIMER_Open(0, ETIMER_CONTINUOUS_MODE, 1000000);
+    ETIMER_SET_PRESCALE_VALUE(0, 0);
+    ETIMER_SET_CMP_VALUE(0, 0xFFFFFF);
+    ETIMER_Start(0);
+
+    outpw(REG_CLK_HCLKEN, inpw(REG_CLK_HCLKEN) | (1 << 11)); // Enable GPIO engine clock, for bus_clear()
+    outpw(REG_CLK_PCLKEN1, inpw(REG_CLK_PCLKEN1) | (0x1 << 0)); // Enable I2C0 engine clock
+
+    /* SDA:GPA0, SCL:GPA1 */
+    outpw(REG_SYS_GPA_MFPL, (inpw(REG_SYS_GPA_MFPL) & 0xffffff00) | 0x33);  // I2C0 multi-function
+    I2C_Open(I2C0, BUS_CLOCK);
+
+    printf("\nI2C queue on I2C0 at %d Hz, 24LC64 at 0x%02X, %d MHz CPU\n\n",
+           I2C_GetBusClockFreq(I2C0), EEPROM_ADDR, sysGetClock(SYS_CPU));
+
+    for (i = 0; i < PAGES * PAGE_SIZE; i++)
+        au8Tx[i] = (uint8_t)(i * 7 + 3);
+    for (i = 0; i < TABLE_SIZE; i++)
+    {
+        asTable[i].u16Reg = TABLE_REG + i;
+        asTable[i].u16Val = (uint8_t)(i * 13 + 1);
+    }
+
+    blocking();
+
+    I2C_QueueOpen(&sQueue, I2C0, 1);
+    I2C_QueueSetClock(&sQueue, clock_12m, 0xFFFFFF);
+    I2C_QueueSetRecovery(&sQueue, bus_clear);
+    queued();
+
+    printf("\nQueue: %d transactions, %d errors, %d NACKs, %d retries, %d arbitrations lost\n",
+           sQueue.u32Xfers, sQueue.u32Errors, sQueue.u32Nacks, sQueue.u32Retries, sQueue.u32ArbLost);
+    printf("       %d time-outs, %d bus errors, %d controller resets\n",
+           sQueue.u32Timeouts, sQueue.u32BusErrors, sQueue.u32Recoveries);
+    I2C_QueueClose(&sQueue);
+
+    while(1);
+}
@@ -0,0 +1,533 @@
+/**************************************************************************//**
+* @file     main.c
+* @brief    Check the pcmops.c kernels and the audio.c FIFO against
+*           per-sample references and measure the kernels, then run the
+*           I2S audio pipeline on the NAU8822 codec: microphone loopback
+*           and a tone with volume ramps mixed into one output, with
+*           underrun and CPU load statistics each second.
+*
+* @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+#include "i2c.h"
+#include "i2s.h"
+
+#define PERIODS         4           /* 2, 4 or 8 DMA interrupts per buffer */
+#define PERIOD_FRAMES   256         /* 16 ms at 16 kHz */
+#define FIFO_FRAMES     2048
+#define TEST_FRAMES     256
+#define RATE            16000
+
+#if defined (__GNUC__) && !(__CC_ARM)
+static __attribute__((aligned(32))) uint32_t u32PlayBuf[PERIODS * PERIOD_FRAMES];
+static __attribute__((aligned(32))) uint32_t u32RecBuf[PERIODS * PERIOD_FRAMES];
+static __attribute__((aligned(32))) uint8_t au8Out[3 * TEST_FRAMES + 16];
+static __attribute__((aligned(32))) uint8_t au8Ref[3 * TEST_FRAMES + 16];
+#else
+static __align(32) uint32_t u32PlayBuf[PERIODS * PERIOD_FRAMES];
+static __align(32) uint32_t u32RecBuf[PERIODS * PERIOD_FRAMES];
+static __align(32) uint8_t au8Out[3 * TEST_FRAMES + 16];
+static __align(32) uint8_t au8Ref[3 * TEST_FRAMES + 16];
+#endif
+static int32_t i32Mix[2 * PERIOD_FRAMES];
+static uint32_t au32RecFifo[FIFO_FRAMES], au32LoopFifo[FIFO_FRAMES], au32ToneFifo[FIFO_FRAMES];
+static I2S_PIPE_T sPipe;
+static I2S_FIFO_T sRec;
+static I2S_STREAM_T sLoop, sTone;
+
+static uint32_t au32Src[TEST_FRAMES + 8];
+static int32_t ai32Acc[2 * TEST_FRAMES + 8], ai32Ref[2 * TEST_FRAMES + 8];
+
+static const int16_t ai16Sine[32] =
+{
+    0, 1561, 3061, 4445, 5657, 6652, 7391, 7846, 8000, 7846, 7391, 6652, 5657, 4445, 3061, 1561,
+    0, -1561, -3061, -4445, -5657, -6652, -7391, -7846, -8000, -7846, -7391, -6652, -5657, -4445, -3061, -1561
+};
+
+static uint32_t seed = 1;
+
+static uint32_t rnd(void)
+{
+    seed = seed * 1664525 + 1013904223;
+    return seed;
+}
+
+/* Full-scale samples more often than chance, to reach saturation */
+static uint32_t rnd_frame(void)
+{
+    static const uint32_t edge[4] = { 0x7FFF7FFF, 0x80008000, 0x80007FFF, 0x00000000 };
+    uint32_t r = rnd();
+
+    return ((r & 0x30000) == 0) ? edge[(r >> 8) & 3] : rnd();
+}
+
+static uint32_t clock_ticks(void)
+{
+    return ETIMER_GetCounter(0);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Per-sample references, written from the definitions with 64-bit arithmetic                            */
+/*---------------------------------------------------------------------------------------------------------*/
+static int32_t ref_sat(int64_t v)
+{
+    return (int32_t)(v > 0x7FFFFFFF ? 0x7FFFFFFF : (v < -(int64_t)0x80000000 ? -(int64_t)0x80000000 : v));
+}
+
+static void ref_mix(int32_t *acc, const uint32_t *src, uint32_t n, I2S_GAIN_T *g)
+{
+    int64_t p;
+    uint32_t i, c;
+
+    for (i = 0; i < n; i++)
+    {
+        if (g->u32Ramp)
+        {
+            g->u32Ramp--;
+            g->i32Gain = g->u32Ramp ? g->i32Gain + g->i32Step : g->i32Target;
+        }
+        for (c = 0; c < 2; c++)
+        {
+            p = (int64_t)(g->i32Gain / 65536) * (int16_t)(src[i] >> (16 * c));
+            acc[2 * i + c] = ref_sat((int64_t)acc[2 * i + c] + ref_sat(2 * p));
+        }
+    }
+}
+
+static int32_t ref_round(int32_t v, uint32_t bits)
+{
+    /* Round to nearest, saturate to a signed result of 'bits' bits */
+    int64_t r = ((int64_t)v + ((int64_t)1 << (31 - bits))) >> (32 - bits);
+    int64_t max = ((int64_t)1 << (bits - 1)) - 1;
+
+    return (int32_t)(r > max ? max : r);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Bit-exact checks                                                                                       */
+/*---------------------------------------------------------------------------------------------------------*/
+static int check_mix(void)
+{
+    I2S_GAIN_T g, gr;
+    uint32_t pass, s, i, n, cut, ramp;
+
+    for (pass = 0; pass < 200; pass++)
+    {
+        n = rnd() % (TEST_FRAMES + 1);
+        for (i = 0; i < 2 * n; i++)
+            ai32Acc[i] = ai32Ref[i] = (pass & 1) ? (int32_t)rnd() : 0;
+
+        /* Up to 4 streams summed, each with its own gain and ramp */
+        for (s = 0; s < 1 + (pass & 3); s++)
+        {
+            for (i = 0; i < n; i++)
+                au32Src[i] = rnd_frame();
+            g.i32Gain = (int32_t)((rnd() % (I2S_GAIN_UNITY + 1)) << 16);
+            ramp = (rnd() & 1) ? rnd() % (2 * TEST_FRAMES) : 0;
+            i2sPcmSetGain(&g, rnd() % (I2S_GAIN_UNITY + 1), ramp);
+            gr = g;
+
+            /* Split the call to check the ramp carries over */
+            cut = n ? rnd() % (n + 1) : 0;
+            i2sPcmMix16(ai32Acc, au32Src, cut, &g);
+            i2sPcmMix16(ai32Acc + 2 * cut, au32Src + cut, n - cut, &g);
+            ref_mix(ai32Ref, au32Src, n, &gr);
+
+            if (memcmp(ai32Acc, ai32Ref, n * 8) || (g.i32Gain != gr.i32Gain) || (g.u32Ramp != gr.u32Ramp))
+            {
+                printf("  i2sPcmMix16 pass %d stream %d frames %d ramp %d: mismatch\n", pass, s, n, ramp);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int check_convert(void)
+{
+    uint32_t pass, i, n, l, r;
+    uint32_t *pu32Out = (uint32_t *)au8Out, *pu32Ref = (uint32_t *)au8Ref;
+    int32_t *pi32Out = (int32_t *)au8Out;
+
+    for (pass = 0; pass < 50; pass++)
+    {
+        n = rnd() % (TEST_FRAMES / 2 + 1);
+        for (i = 0; i < 2 * n; i++)
+            ai32Acc[i] = ((rnd() & 7) == 0) ? (int32_t)(0x7FFFFF00 + (rnd() & 0xFF)) : (int32_t)rnd();
+
+        i2sPcmOut16(pu32Out, ai32Acc, n);
+        for (i = 0; i < n; i++)
+        {
+            l = (uint32_t)ref_round(ai32Acc[2 * i], 16) & 0xFFFF;
+            r = (uint32_t)ref_round(ai32Acc[2 * i + 1], 16) << 16;
+            if (pu32Out[i] != (l | r))
+            {
+                printf("  i2sPcmOut16 frame %d: %08x, expected %08x\n", i, pu32Out[i], l | r);
+                return 1;
+            }
+        }
+
+        i2sPcmOut24(pi32Out, ai32Acc, n);
+        for (i = 0; i < 2 * n; i++)
+            if (pi32Out[i] != ref_round(ai32Acc[i], 24))
+            {
+                printf("  i2sPcmOut24 sample %d: %08x, expected %08x\n", i, pi32Out[i], ref_round(ai32Acc[i], 24));
+                return 1;
+            }
+
+        /* 24 to 16 bits, with junk in bits 31:24 */
+        i2sPcm24To16(pu32Out, ai32Acc, n);
+        for (i = 0; i < n; i++)
+        {
+            l = (uint32_t)ref_round((int32_t)((uint32_t)ai32Acc[2 * i] << 8), 16) & 0xFFFF;
+            r = (uint32_t)ref_round((int32_t)((uint32_t)ai32Acc[2 * i + 1] << 8), 16) << 16;
+            if (pu32Out[i] != (l | r))
+            {
+                printf("  i2sPcm24To16 frame %d: %08x, expected %08x\n", i, pu32Out[i], l | r);
+                return 1;
+            }
+        }
+
+        for (i = 0; i < n; i++)
+            pu32Ref[i] = rnd_frame();
+        i2sPcm16To24(ai32Acc, pu32Ref, n);
+        for (i = 0; i < n; i++)
+            if ((ai32Acc[2 * i] != (int16_t)pu32Ref[i] * 256) || (ai32Acc[2 * i + 1] != (int16_t)(pu32Ref[i] >> 16) * 256))
+            {
+                printf("  i2sPcm16To24 frame %d: mismatch\n", i);
+                return 1;
+            }
+    }
+    return 0;
+}
+
+static int check_pack(void)
+{
+    uint32_t off, n, i;
+    int32_t v;
+
+    for (off = 0; off < 4; off++)
+    {
+        for (n = 0; n < 14; n++)
+        {
+            for (i = 0; i < n; i++)
+                ai32Acc[i] = (int32_t)(rnd() << 8) >> 8;
+
+            memset(au8Out, 0x5A, sizeof(au8Out));
+            memset(au8Ref, 0x5A, sizeof(au8Ref));
+            i2sPcmPack24(au8Out + off, ai32Acc, n);
+            for (i = 0; i < n; i++)
+            {
+                au8Ref[off + 3 * i] = (uint8_t)ai32Acc[i];
+                au8Ref[off + 3 * i + 1] = (uint8_t)(ai32Acc[i] >> 8);
+                au8Ref[off + 3 * i + 2] = (uint8_t)(ai32Acc[i] >> 16);
+            }
+            if (memcmp(au8Out, au8Ref, 3 * n + 8))
+            {
+                printf("  i2sPcmPack24 offset %d samples %d: mismatch\n", off, n);
+                return 1;
+            }
+
+            ai32Ref[n] = 0x12345678;
+            i2sPcmUnpack24(ai32Ref, au8Ref + off, n);
+            for (i = 0; i < n; i++)
+            {
+                v = au8Ref[off + 3 * i] | (au8Ref[off + 3 * i + 1] << 8) | (au8Ref[off + 3 * i + 2] << 16);
+                v = (v & 0x800000) ? v - 0x1000000 : v;
+                if (ai32Ref[i] != v)
+                {
+                    printf("  i2sPcmUnpack24 offset %d sample %d: %08x, expected %08x\n", off, i, ai32Ref[i], v);
+                    return 1;
+                }
+            }
+            if (ai32Ref[n] != 0x12345678)
+            {
+                printf("  i2sPcmUnpack24 offset %d samples %d: wrote past the end\n", off, n);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int check_fifo(void)
+{
+    I2S_FIFO_T sFifo;
+    uint32_t wr = 0, rd = 0, pass, n, got, i;
+
+    /* Sequence numbers through many wraps of a 64 frame FIFO */
+    i2sFifoInit(&sFifo, au32RecFifo, 64);
+    for (pass = 0; pass < 2000; pass++)
+    {
+        n = rnd() % 80;
+        for (i = 0; i < n; i++)
+            au32Src[i] = wr + i;
+        got = i2sFifoWrite(&sFifo, au32Src, n);
+        if (got != (n < 64 - (wr - rd) ? n : 64 - (wr - rd)))
+        {
+            printf("  i2sFifoWrite wrote %d of %d with %d free\n", got, n, 64 - (wr - rd));
+            return 1;
+        }
+        wr += got;
+
+        n = rnd() % 80;
+        got = i2sFifoRead(&sFifo, au32Src, n);
+        for (i = 0; i < got; i++)
+            if (au32Src[i] != rd + i)
+            {
+                printf("  i2sFifoRead frame %d: %d, expected %d\n", i, au32Src[i], rd + i);
+                return 1;
+            }
+        rd += got;
+        if ((i2sFifoCount(&sFifo) != wr - rd) || (i2sFifoSpace(&sFifo) != 64 - (wr - rd)))
+        {
+            printf("  i2sFifoCount/Space wrong\n");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Kernel speed, CPU cycles per frame                                                                     */
+/*---------------------------------------------------------------------------------------------------------*/
+static void bench(void)
+{
+    static const char *name[] =
+    {
+        "i2sPcmMix16", "i2sPcmMix16, ramping", "i2sPcmOut16", "i2sPcm24To16",
+        "i2sPcmPack24, per sample", "i2sPcmUnpack24, per sample"
+    };
+    uint32_t cpu = sysGetClock(SYS_CPU), i, t, k;
+    I2S_GAIN_T g;
+
+    for (i = 0; i < TEST_FRAMES; i++)
+        au32Src[i] = rnd();
+    memset(ai32Acc, 0, sizeof(ai32Acc));
+    printf("\nCycles per stereo frame (CPU %d MHz, %d frames)\n", cpu, TEST_FRAMES);
+
+    for (k = 0; k < sizeof(name) / sizeof(name[0]); k++)
+    {
+        g.i32Gain = 0;
+        i2sPcmSetGain(&g, I2S_GAIN_UNITY / 2, 0);
+        if (k == 1)
+            i2sPcmSetGain(&g, I2S_GAIN_UNITY, TEST_FRAMES);
+
+        t = ETIMER_GetCounter(0);
+        switch (k)
+        {
+        case 0:
+        case 1:
+            i2sPcmMix16(ai32Acc, au32Src, TEST_FRAMES, &g);
+            break;
+        case 2:
+            i2sPcmOut16((uint32_t *)au8Out, ai32Acc, TEST_FRAMES);
+            break;
+        case 3:
+            i2sPcm24To16((uint32_t *)au8Out, ai32Acc, TEST_FRAMES);
+            break;
+        case 4:
+            i2sPcmPack24(au8Out, ai32Acc, TEST_FRAMES);
+            break;
+        default:
+            i2sPcmUnpack24(ai32Ref, au8Out, TEST_FRAMES);
+            break;
+        }
+        t = (ETIMER_GetCounter(0) - t) & 0xFFFFFF;
+        t = t * cpu * 100 / 12 / TEST_FRAMES;
+        printf("  %-28s %3d.%02d\n", name[k], t / 100, t % 100);
+    }
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Codec                                                                                                  */
+/*---------------------------------------------------------------------------------------------------------*/
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);   // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+void Delay(int count)
+{
+    volatile uint32_t i;
+    for (i = 0; i < count ; i++);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Write 9-bit data to 7-bit address register of NAU8822 with I2C0                                        */
+/*---------------------------------------------------------------------------------------------------------*/
+void I2C_WriteNAU8822(uint8_t u8addr, uint16_t u16data)
+{
+    I2C_START(I2C0);
+    I2C_WAIT_READY(I2C0);
+
+    I2C_SET_DATA(I2C0, 0x1A<<1);
+    I2C_SET_CONTROL_REG(I2C0, I2C_CTL_SI);
+    I2C_WAIT_READY(I2C0);
+
+    I2C_SET_DATA(I2C0, (uint8_t)((u8addr << 1) | (u16data >> 8)));
+    I2C_SET_CONTROL_REG(I2C0, I2C_CTL_SI);
+    I2C_WAIT_READY(I2C0);
+
+    I2C_SET_DATA(I2C0, (uint8_t)(u16data & 0x00FF));
+    I2C_SET_CONTROL_REG(I2C0, I2C_CTL_SI);
+    I2C_WAIT_READY(I2C0);
+
+    I2C_STOP(I2C0);
+}
+
+void NAU8822_Setup()
+{
+    printf("\nConfigure NAU8822 ...");
+
+    I2C_WriteNAU8822(0,  0x000);   /* Reset all registers */
+    Delay(0x200);
+
+    I2C_WriteNAU8822(1,  0x03F);
+    I2C_WriteNAU8822(2,  0x1BF);   /* Enable L/R Headphone, ADC Mix/Boost, ADC */
+    I2C_WriteNAU8822(3,  0x07F);   /* Enable L/R main mixer, DAC */
+    I2C_WriteNAU8822(4,  0x010);   /* 16-bit word length, I2S format, Stereo */
+    I2C_WriteNAU8822(5,  0x000);   /* Companding control and loop back mode (all disable) */
+    Delay(0x200);
+    I2C_WriteNAU8822(10, 0x008);   /* DAC soft mute is disabled, DAC oversampling rate is 128x */
+    I2C_WriteNAU8822(14, 0x108);   /* ADC HP filter is disabled, ADC oversampling rate is 128x */
+    I2C_WriteNAU8822(15, 0x1EF);   /* ADC left digital volume control */
+    I2C_WriteNAU8822(16, 0x1EF);   /* ADC right digital volume control */
+    I2C_WriteNAU8822(44, 0x033);   /* LMICN/LMICP is connected to PGA */
+    I2C_WriteNAU8822(49, 0x042);
+    I2C_WriteNAU8822(50, 0x001);   /* Left DAC connected to LMIX */
+    I2C_WriteNAU8822(51, 0x001);   /* Right DAC connected to RMIX */
+
+    printf("[OK]\n");
+}
+
+void I2C0_Init(void)
+{
+    outpw(REG_CLK_PCLKEN1, inpw(REG_CLK_PCLKEN1) | (0x1 << 0)); // Enable I2C0 engine clock
+
+    /* Open I2C0 and set clock to 100k */
+    I2C_Open(I2C0, 100000);
+
+    /* SDA:GPA0, SCL:GPA1 */
+    outpw(REG_SYS_GPA_MFPL, (inpw(REG_SYS_GPA_MFPL) & 0xffffff00) | 0x33);  // I2C0 multi-function
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Pipeline                                                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+static void print_percent(const char *name, uint32_t u32Ticks)
+{
+    uint32_t p = sPipe.u32Elapsed ? (uint32_t)((uint64_t)u32Ticks * 10000 / sPipe.u32Elapsed) : 0;
+
+    printf("  %-5s %2d.%02d%%", name, p / 100, p % 100);
+}
+
+static void print_stream(const char *name, I2S_STREAM_T *psStream)
+{
+    print_percent(name, psStream->u32Ticks);
+    printf("  frames %8d  underruns %4d (%d frames)\n", psStream->u32Frames, psStream->u32Underruns, psStream->u32Silence);
+}
+
+int main(void)
+{
+    uint32_t au32Chunk[PERIOD_FRAMES];
+    uint32_t i, n, u32Phase = 0, u32Report = 0, u32Ramp = 0;
+
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+    UART_Init();
+
+    // Enable ETIMER0 engine clock
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 8));
+
+    // Free running counter at full 12 MHz resolution
+    ETIMER_Open(0, ETIMER_CONTINUOUS_MODE, 1000000);
+    ETIMER_SET_PRESCALE_VALUE(0, 0);
+    ETIMER_SET_CMP_VALUE(0, 0xFFFFFF);
+    ETIMER_Start(0);
+
+    printf("\nChecking the PCM kernels and FIFO against per-sample references\n");
+    printf("%s\n", (check_mix() | check_convert() | check_pack() | check_fifo()) ? "Check FAILED" : "Check OK");
+    bench();
+
+    I2C0_Init();
+
+    /* Configure multi function pins to I2S A2~A6 */
+    outpw(REG_SYS_GPA_MFPL, (inpw(REG_SYS_GPA_MFPL) & ~0x0FFFFF00) | 0x02222200);
+
+    i2sInit();
+    if (i2sOpen() != 0)
+        return 0;
+    i2sIoctl(I2S_SELECT_BLOCK, I2S_BLOCK_I2S, 0);
+    i2sIoctl(I2S_SET_CHANNEL, I2S_PLAY, I2S_CHANNEL_P_I2S_TWO);
+    i2sIoctl(I2S_SET_CHANNEL, I2S_REC, I2S_CHANNEL_R_I2S_TWO);
+    i2sIoctl(I2S_SET_I2S_FORMAT, I2S_FORMAT_I2S, 0);
+
+    //APLL is 98.4MHz, select APLL as I2S source and divider is (7+1)
+    outpw(REG_CLK_APLLCON, 0xC0008028);
+    outpw(REG_CLK_DIVCTL1, (inpw(REG_CLK_DIVCTL1) & ~0x001f0000) | (0x2 << 19) | (0x7 << 24));
+    i2sSetSampleRate(12300000, RATE, 16, 2);
+    i2sIoctl(I2S_SET_MODE, I2S_MODE_MASTER, 0);
+
+    if (i2sPipeInit(&sPipe, I2S_BIT_WIDTH_16, PERIODS, PERIOD_FRAMES, u32PlayBuf, u32RecBuf, i32Mix) != 0)
+        return 0;
+    i2sPipeSetClock(&sPipe, clock_ticks, 0xFFFFFF);
+    i2sFifoInit(&sRec, au32RecFifo, FIFO_FRAMES);
+    i2sPipeSetRecord(&sPipe, &sRec);
+    i2sPipeAddStream(&sPipe, &sLoop, au32LoopFifo, FIFO_FRAMES);
+    i2sPipeAddStream(&sPipe, &sTone, au32ToneFifo, FIFO_FRAMES);
+    i2sPcmSetGain(&sTone.sGain, 0, 0);
+
+    NAU8822_Setup();
+
+    printf("\n%d Hz, %d periods of %d frames, microphone loopback + 500 Hz tone fading in and out\n",
+           RATE, PERIODS, PERIOD_FRAMES);
+    i2sPipeStart(&sPipe);
+
+    while (1)
+    {
+        /* Loopback: record FIFO to the first stream */
+        n = i2sFifoSpace(&sLoop.sFifo);
+        n = i2sFifoRead(&sRec, au32Chunk, n < PERIOD_FRAMES ? n : PERIOD_FRAMES);
+        i2sFifoWrite(&sLoop.sFifo, au32Chunk, n);
+
+        /* Tone: keep two periods queued */
+        while (i2sFifoCount(&sTone.sFifo) < 2 * PERIOD_FRAMES)
+        {
+            for (i = 0; i < PERIOD_FRAMES; i++, u32Phase++)
+                au32Chunk[i] = (uint32_t)(uint16_t)ai16Sine[u32Phase & 31] * 0x10001;
+            i2sFifoWrite(&sTone.sFifo, au32Chunk, PERIOD_FRAMES);
+        }
+
+        /* Fade the tone in and out over 250 ms every 2 s */
+        if (sPipe.u32PlayPeriods - u32Ramp >= 2 * RATE / PERIOD_FRAMES)
+        {
+            u32Ramp = sPipe.u32PlayPeriods;
+            i2sPcmSetGain(&sTone.sGain, sTone.sGain.i32Target ? 0 : I2S_GAIN_UNITY / 2, RATE / 4);
+        }
+
+        if (sPipe.u32PlayPeriods - u32Report >= RATE / PERIOD_FRAMES)
+        {
+            u32Report = sPipe.u32PlayPeriods;
+            printf("\nperiods %d, late play %d rec %d, record overruns %d (%d frames)\n", sPipe.u32PlayPeriods,
+                   sPipe.u32PlayLate, sPipe.u32RecLate, sPipe.u32RecOverruns, sPipe.u32RecDropped);
+            print_percent("all", sPipe.u32Ticks);
+            printf("  (interrupts, CPU time of the whole pipeline)\n");
+            print_stream("loop", &sLoop);
+            print_stream("tone", &sTone);
+        }
+    }
+}
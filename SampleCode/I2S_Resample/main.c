@@ -0,0 +1,325 @@
+/**************************************************************************//**
+* @file     main.c
+* @brief    Measure the resample.c sample rate converter: THD+N of two
+*           tones and CPU load per channel for the usual USB audio and I2S
+*           rate pairs, then run the UAC microphone and speaker bridges of
+*           the converter against simulated USB and I2S clocks that drift
+*           apart, reporting the drift correction and FIFO levels.
+*           No codec or USB device is needed.
+*
+* @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+#include "i2s.h"
+
+#define IN_MAX          48000       /* One second at the highest input rate */
+#define OUT_MAX         (48000 + 64)
+#define AMPLITUDE       29204       /* -1 dBFS */
+#define FIFO_FRAMES     1024
+#define FIFO_TARGET     512
+#define PERIOD_FRAMES   48          /* 1 ms I2S period at 48 kHz */
+#define BRIDGE_SECONDS  60
+
+#if defined (__GNUC__) && !(__CC_ARM)
+static __attribute__((aligned(32))) int16_t i16Coef[I2S_SRC_COEF_SIZE(I2S_SRC_TAPS_MAX)];
+#else
+static __align(32) int16_t i16Coef[I2S_SRC_COEF_SIZE(I2S_SRC_TAPS_MAX)];
+#endif
+static uint32_t au32Hist[I2S_SRC_HIST_SIZE(I2S_SRC_TAPS_MAX)];
+static uint32_t au32In[IN_MAX], au32Out[OUT_MAX];
+static I2S_SRC_T sSrc;
+
+static const struct
+{
+    uint32_t u32In, u32Out, u32Taps;
+    int32_t i32Ppb;
+} tests[] =
+{
+    { 44100, 48000, 32,  0 },       /* USB microphone to the codec */
+    { 48000, 44100, 36,  0 },       /* Codec to a USB speaker */
+    { 44100, 48000, 64,  0 },
+    { 16000, 48000, 32,  0 },       /* Speech device to the codec */
+    { 48000, 16000, 96,  0 },
+    { 48000, 48000, 32,  100000 },  /* Same rate, 100 ppm of drift */
+};
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Test signal and THD+N                                                                                  */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/* Sine of f cycles per sample into the left (0) or right (1) sample of each frame */
+static void gen_tone(uint32_t *pu32Buf, uint32_t n, double f, int ch)
+{
+    double c = cos(2 * 3.14159265358979323846 * f), s = sin(2 * 3.14159265358979323846 * f);
+    double x = 1.0, y = 0.0, t;
+    uint32_t i, v;
+
+    for (i = 0; i < n; i++)
+    {
+        v = (uint16_t)(int16_t)(y * AMPLITUDE + (y < 0 ? -0.5 : 0.5));
+        pu32Buf[i] = ch ? (pu32Buf[i] & 0xFFFF) | (v << 16) : (pu32Buf[i] & 0xFFFF0000) | v;
+        /* Rotate by one sample */
+        t = x * c - y * s;
+        y = x * s + y * c;
+        x = t;
+    }
+}
+
+/*
+ * Noise and distortion to signal ratio in 0.1 dB: a least squares fit of
+ * a sin + b cos + dc at f cycles per sample is the signal, the rest the
+ * noise and distortion.
+ */
+static int32_t thdn(const uint32_t *pu32Buf, uint32_t n, double f, int ch)
+{
+    double c = cos(2 * 3.14159265358979323846 * f), s = sin(2 * 3.14159265358979323846 * f);
+    double x = 1.0, y = 0.0, t, v, fit, a, b, dc, det;
+    double ss = 0, cc = 0, sc = 0, s1 = 0, c1 = 0, vs = 0, vc = 0, v1 = 0, ps = 0, pn = 0;
+    uint32_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        v = (int16_t)(ch ? pu32Buf[i] >> 16 : pu32Buf[i]);
+        ss += y * y;
+        cc += x * x;
+        sc += y * x;
+        s1 += y;
+        c1 += x;
+        vs += v * y;
+        vc += v * x;
+        v1 += v;
+        t = x * c - y * s;
+        y = x * s + y * c;
+        x = t;
+    }
+
+    /* Normal equations, solved by Cramer's rule */
+    det = ss * (cc * n - c1 * c1) - sc * (sc * n - c1 * s1) + s1 * (sc * c1 - cc * s1);
+    a = (vs * (cc * n - c1 * c1) - sc * (vc * n - c1 * v1) + s1 * (vc * c1 - cc * v1)) / det;
+    b = (ss * (vc * n - v1 * c1) - vs * (sc * n - c1 * s1) + s1 * (sc * v1 - vc * s1)) / det;
+    dc = (ss * (cc * v1 - c1 * vc) - sc * (sc * v1 - c1 * vs) + s1 * (sc * vc - cc * vs)) / det;
+
+    x = 1.0;
+    y = 0.0;
+    for (i = 0; i < n; i++)
+    {
+        v = (int16_t)(ch ? pu32Buf[i] >> 16 : pu32Buf[i]);
+        fit = a * y + b * x + dc;
+        ps += (fit - dc) * (fit - dc);
+        pn += (v - fit) * (v - fit);
+        t = x * c - y * s;
+        y = x * s + y * c;
+        x = t;
+    }
+    return (int32_t)(100.0 * log10(pn / ps) - 0.5);
+}
+
+static void print_db(int32_t i32Db)
+{
+    printf(" %4d.%d dB", i32Db / 10, (i32Db < 0 ? -i32Db : i32Db) % 10);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Quality and load                                                                                       */
+/*---------------------------------------------------------------------------------------------------------*/
+static void run(uint32_t k, uint32_t cpu)
+{
+    uint32_t u32InRate = tests[k].u32In, u32OutRate = tests[k].u32Out, u32Taps = tests[k].u32Taps;
+    uint32_t u32Low = u32InRate < u32OutRate ? u32InRate : u32OutRate;
+    uint32_t t0, u32Init, u32Ticks = 0, u32Used = 0, u32Made = 0, u32Acc = 0, n, u32Block;
+    double fl = 997.0, fr = u32Low * 0.2, scale = 1.0 + tests[k].i32Ppb * 1e-9;
+
+    gen_tone(au32In, u32InRate, fl / u32InRate, 0);
+    gen_tone(au32In, u32InRate, fr / u32InRate, 1);
+
+    t0 = ETIMER_GetCounter(0);
+    i2sSrcInit(&sSrc, u32InRate, u32OutRate, u32Taps, i16Coef, au32Hist);
+    u32Init = (ETIMER_GetCounter(0) - t0) & 0xFFFFFF;
+    i2sSrcSetDrift(&sSrc, tests[k].i32Ppb);
+
+    /* One second of input in the 1 ms blocks of USB audio */
+    while (u32Used < u32InRate)
+    {
+        u32Acc += u32InRate;
+        u32Block = u32Acc / 1000;
+        u32Acc %= 1000;
+        if (u32Block > u32InRate - u32Used)
+            u32Block = u32InRate - u32Used;
+
+        t0 = ETIMER_GetCounter(0);
+        n = u32Block;
+        u32Made += i2sSrcProcess(&sSrc, &au32In[u32Used], &n, &au32Out[u32Made], OUT_MAX - u32Made);
+        u32Ticks += (ETIMER_GetCounter(0) - t0) & 0xFFFFFF;
+        u32Used += n;
+    }
+
+    /* The first u32Taps outputs hold the start-up transient */
+    printf("%5d -> %5d %3d %+5d  %5d Hz", u32InRate, u32OutRate, u32Taps, tests[k].i32Ppb / 1000, (int)fl);
+    print_db(thdn(&au32Out[u32Taps], u32Made - 2 * u32Taps, fl * scale / u32OutRate, 0));
+    printf("  %5d Hz", (int)fr);
+    print_db(thdn(&au32Out[u32Taps], u32Made - 2 * u32Taps, fr * scale / u32OutRate, 1));
+
+    /* u32Ticks at 12 MHz for one second of audio */
+    printf("  %4d  %d.%02d%%  %d.%02d%%  %d ms\n", u32Ticks * (cpu / 12) / u32Made,
+           u32Ticks / 120000, u32Ticks / 1200 % 100, u32Ticks / 240000, u32Ticks / 2400 % 100,
+           u32Init / 12000);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  UAC bridges                                                                                            */
+/*---------------------------------------------------------------------------------------------------------*/
+static uint32_t au32Fifo[FIFO_FRAMES];
+static I2S_FIFO_T sFifo;                /* sFifo of the play I2S_STREAM_T, or the pipeline record FIFO */
+static uint32_t u32Overruns, u32Underruns, u32Started;
+
+/* Body of a UAC func_au_in callback: microphone frames into the I2S play stream */
+static int mic_in(uint8_t *data, int len)
+{
+    uint32_t n = (uint32_t)len / 4;
+
+    if (u32Started)
+        i2sSrcTrack(&sSrc, i2sFifoCount(&sFifo), FIFO_TARGET);
+    if (i2sSrcWriteFifo(&sSrc, &sFifo, (uint32_t *)data, n) < n)
+        u32Overruns++;
+    return 0;
+}
+
+/* Body of a UAC func_au_out callback: I2S record frames to the speaker */
+static int spk_out(uint8_t *data, int len)
+{
+    uint32_t n = (uint32_t)len / 4, u32Made = 0;
+
+    if (u32Started)
+    {
+        i2sSrcTrack(&sSrc, i2sFifoCount(&sFifo), FIFO_TARGET);
+        u32Made = i2sSrcReadFifo(&sSrc, &sFifo, (uint32_t *)data, n);
+        if (u32Made < n)
+            u32Underruns++;
+    }
+    memset(data + u32Made * 4, 0, (n - u32Made) * 4);
+    return len;
+}
+
+/*
+ * Virtual time in 1 ms steps. The USB side moves 44.1 frames per ms on
+ * average, the I2S side one PERIOD_FRAMES period per ms, each with its own
+ * clock error. The I2S side starts once the FIFO is half full.
+ */
+static void bridge(int speaker, int32_t i32UsbPpm, int32_t i32I2sPpm)
+{
+    uint32_t au32Usb[64], au32Period[PERIOD_FRAMES];
+    uint32_t ms, n, u32Min = FIFO_FRAMES, u32Max = 0, u32Level;
+    double usb = 0.0, i2s = 0.0, sum = 0.0;
+    int32_t i32Min = 0x7FFFFFFF, i32Max = -0x7FFFFFFF;
+
+    i2sSrcInit(&sSrc, speaker ? 48000 : 44100, speaker ? 44100 : 48000, 32, i16Coef, au32Hist);
+    i2sFifoInit(&sFifo, au32Fifo, FIFO_FRAMES);
+    gen_tone(au32Usb, 64, 997.0 / 44100, 0);
+    gen_tone(au32Usb, 64, 997.0 / 44100, 1);
+    u32Overruns = u32Underruns = u32Started = 0;
+
+    for (ms = 0; ms < BRIDGE_SECONDS * 1000; ms++)
+    {
+        usb += 44.1 * (1.0 + i32UsbPpm * 1e-6);
+        n = (uint32_t)usb;
+        usb -= n;
+
+        if (!speaker)
+        {
+            mic_in((uint8_t *)au32Usb, n * 4);
+            if (!u32Started && (i2sFifoCount(&sFifo) >= FIFO_TARGET))
+                u32Started = 1;
+        }
+        else
+            spk_out((uint8_t *)au32Usb, n * 4);
+
+        /* The I2S period interrupt */
+        i2s += 1.0 + i32I2sPpm * 1e-6;
+        while (i2s >= 1.0)
+        {
+            i2s -= 1.0;
+            if (!speaker && u32Started && (i2sFifoRead(&sFifo, au32Period, PERIOD_FRAMES) < PERIOD_FRAMES))
+                u32Underruns++;
+            if (speaker)
+            {
+                if (i2sFifoWrite(&sFifo, au32Period, PERIOD_FRAMES) < PERIOD_FRAMES)
+                    u32Overruns++;
+                if (i2sFifoCount(&sFifo) >= FIFO_TARGET)
+                    u32Started = 1;
+            }
+        }
+
+        if (ms >= BRIDGE_SECONDS * 1000 / 2)
+        {
+            u32Level = i2sFifoCount(&sFifo);
+            if (u32Level < u32Min)
+                u32Min = u32Level;
+            if (u32Level > u32Max)
+                u32Max = u32Level;
+            if (sSrc.i32Ppb < i32Min)
+                i32Min = sSrc.i32Ppb;
+            if (sSrc.i32Ppb > i32Max)
+                i32Max = sSrc.i32Ppb;
+            sum += sSrc.i32Ppb;
+        }
+    }
+
+    printf("%-8s %+5d %+5d  %+5d ppm  %+5d ~ %+5d ppm  %4d ~ %4d  %8d %9d\n",
+           speaker ? "speaker" : "mic", i32UsbPpm, i32I2sPpm, (int32_t)(sum / (BRIDGE_SECONDS * 500) / 1000),
+           i32Min / 1000, i32Max / 1000, u32Min, u32Max, u32Overruns, u32Underruns);
+}
+
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);   // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+int main(void)
+{
+    uint32_t i, cpu;
+
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+    UART_Init();
+
+    // Enable ETIMER0 engine clock
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 8));
+
+    // Free running counter at full 12 MHz resolution
+    ETIMER_Open(0, ETIMER_CONTINUOUS_MODE, 1000000);
+    ETIMER_SET_PRESCALE_VALUE(0, 0);
+    ETIMER_SET_CMP_VALUE(0, 0xFFFFFF);
+    ETIMER_Start(0);
+
+    cpu = sysGetClock(SYS_CPU);
+    printf("\nSample rate converter, one second of -1 dBFS tones per conversion\n");
+    printf("THD+N is noise and distortion to signal; CPU load is of a %d MHz CPU\n", cpu);
+    printf("%-14s %3s %5s  %-17s  %-17s  %4s  %-6s %-6s %s\n", "rates", "tap", "ppm", "left THD+N",
+           "right THD+N", "cyc/", "CPU", "CPU/ch", "init");
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+        run(i, cpu);
+
+    printf("\nUAC bridges over %d s, statistics of the last half\n", BRIDGE_SECONDS);
+    printf("%-8s %5s %5s  %9s  %-17s  %-11s  %8s %9s\n", "bridge", "usb", "i2s", "mean",
+           "correction", "FIFO level", "overruns", "underruns");
+    bridge(0, 120, 0);
+    bridge(0, -250, 30);
+    bridge(1, 0, -80);
+    bridge(1, 200, 150);
+
+    while(1);
+}
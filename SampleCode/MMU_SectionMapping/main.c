@@ -0,0 +1,124 @@
+/**************************************************************************//**
+* @file     main.c
+* @brief    Measure the effect of the MMU mapping granularity on SDRAM access
+*
+*           By default cache.c maps SDRAM with 1 MB sections from sysMMURegionTable[].
+*           Add USING_SMALL_PAGE_TABLE to the C preprocessor symbols of the project
+*           and rebuild to measure the 4 KB small page mapping for comparison.
+*           The test buffers are at 4 MB to 24 MB of SDRAM, above the program.
+*
+* @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+
+#define TEST_BASE       0x00400000
+#define COPY_SIZE       (4 * 1024 * 1024)
+#define SWEEP_SIZE      (16 * 1024 * 1024)
+#define SWEEP_STRIDE    4096
+#define TLB_ENTRIES     64
+
+/* SDRAM cached, plus a 256 KB non-cacheable window at 30 MB for DMA descriptors.
+   The window splits its megabyte into 64 KB large pages. */
+const SYS_MMU_REGION_T sysMMURegionTable[] =
+{
+    { 0x00000000, SYS_MMU_SDRAM_SIZE, SYS_MMU_CACHED },
+    { 0x01E00000, 0x40000, SYS_MMU_NC | SYS_MMU_XN },
+    { 0, 0, 0 }
+};
+
+extern unsigned int _mmuSectionTable[4096];
+
+static UINT32 cpu_mhz;
+
+static UINT32 timer_ticks(UINT32 t0)
+{
+    return (ETIMER_GetCounter(0) - t0) & 0xFFFFFF;
+}
+
+static void show_mapping(void)
+{
+    UINT32 i, sections = 0, split = 0, sdram = sysGetSdramSizebyMB();
+
+    for (i = 0; i < sdram; i++)
+    {
+        if ((_mmuSectionTable[i] & 0x3) == 0x2)
+            sections++;
+        else
+            split++;
+    }
+    printf("SDRAM %d MB: %d MB mapped by sections, %d MB by page tables\n", sdram, sections, split);
+}
+
+/* MB/s of memcpy between two cacheable buffers */
+static UINT32 copy_speed(void)
+{
+    UINT32 t0, ticks;
+
+    memset((void *)TEST_BASE, 0x5A, COPY_SIZE);
+    t0 = ETIMER_GetCounter(0);
+    memcpy((void *)(TEST_BASE + COPY_SIZE), (void *)TEST_BASE, COPY_SIZE);
+    ticks = timer_ticks(t0);
+    return (UINT32)((unsigned long long)COPY_SIZE * 12000000 / ticks / (1024 * 1024));  // ETIMER0 counts 12 MHz
+}
+
+/* CPU cycles per load when every load touches a new 4 KB page */
+static UINT32 sweep_cycles(void)
+{
+    UINT32 volatile sum = 0;
+    UINT32 addr, t0, ticks;
+
+    sysFlushCache(D_CACHE);
+    t0 = ETIMER_GetCounter(0);
+    for (addr = TEST_BASE; addr < TEST_BASE + SWEEP_SIZE; addr += SWEEP_STRIDE)
+        sum += *(UINT32 volatile *)addr;
+    ticks = timer_ticks(t0);
+    return ticks * cpu_mhz / 12 / (SWEEP_SIZE / SWEEP_STRIDE);
+}
+
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);   // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+int main(void)
+{
+    UINT32 pages;
+
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+    UART_Init();
+
+    // Enable ETIMER0 engine clock, free running at 12 MHz
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 8));
+    ETIMER_Open(0, ETIMER_CONTINUOUS_MODE, 1000000);
+    ETIMER_SET_PRESCALE_VALUE(0, 0);
+    ETIMER_SET_CMP_VALUE(0, 0xFFFFFF);
+    ETIMER_Start(0);
+
+    cpu_mhz = sysGetClock(SYS_CPU);
+    printf("\nMMU mapping benchmark, CPU %d MHz\n", cpu_mhz);
+    show_mapping();
+
+    // The ARM926EJ-S has no TLB miss counter. A sweep needs one TLB entry per
+    // mapping unit it crosses; above 64 entries every load misses.
+    pages = ((_mmuSectionTable[TEST_BASE >> 20] & 0x3) == 0x2) ? (SWEEP_SIZE >> 20) : (SWEEP_SIZE / 4096);
+    printf("Page sweep over %d MB: %d TLB entries needed, about %d misses per pass\n",
+           SWEEP_SIZE >> 20, pages, (pages > TLB_ENTRIES) ? (SWEEP_SIZE / SWEEP_STRIDE) : pages);
+    printf("Page sweep: %d CPU cycles per load\n", sweep_cycles());
+    printf("memcpy %d KB: %d MB/s\n", COPY_SIZE / 1024, copy_speed());
+
+    while(1);
+}
@@ -0,0 +1,228 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @brief    Share PDMA0/PDMA1 through the PDMA channel service: channel allocation,
+ *           scatter-gather lists, completion callbacks and ping-pong streaming.
+ *
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "pdma.h"
+
+#define GATHER_LEN0         100
+#define GATHER_LEN1         70000       /* Longer than one descriptor, split by the service */
+#define GATHER_LEN2         4096
+#define GATHER_LEN          (GATHER_LEN0 + GATHER_LEN1 + GATHER_LEN2)
+#define COPY_LEN            32768
+#define STREAM_LEN          16384       /* Long enough for the callback to keep up with memory speed */
+#define STREAM_COUNT        50
+#define WAIT_LOOPS          10000000
+
+static uint8_t au8Src[GATHER_LEN] __attribute__((aligned(32)));
+static uint8_t au8Dst[GATHER_LEN] __attribute__((aligned(32)));
+static uint32_t au32CopySrc[2][COPY_LEN / 4] __attribute__((aligned(32)));
+static uint32_t au32CopyDst[2][COPY_LEN / 4] __attribute__((aligned(32)));
+static uint32_t au32Ping[STREAM_LEN / 4] __attribute__((aligned(32)));
+static uint32_t au32Pong[STREAM_LEN / 4] __attribute__((aligned(32)));
+static uint32_t au32StreamDst[2][STREAM_LEN / 4] __attribute__((aligned(32)));
+
+static volatile uint32_t s_u32Done;
+static volatile uint32_t s_u32Error;
+static volatile uint32_t s_u32StreamCount;
+static uint32_t s_au32Stamp[2];
+
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);   // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+/* One-shot transfers: count completions, the user data is the bit to set */
+static void TransferDone(int32_t i32Ch, uint32_t u32Event, void *pvUserData)
+{
+    if (u32Event & (PDMA_EVT_ABORT | PDMA_EVT_TIMEOUT))
+        s_u32Error |= (uint32_t)pvUserData;
+    if (u32Event & PDMA_EVT_DONE)
+        s_u32Done |= (uint32_t)pvUserData;
+}
+
+/* Stream: check the buffer just copied, then stamp its source for the next round */
+static void StreamDone(int32_t i32Ch, uint32_t u32Event, void *pvUserData)
+{
+    uint32_t u32Half = (u32Event & PDMA_EVT_PONG) ? 1 : 0;
+    uint32_t *pu32Src = u32Half ? au32Pong : au32Ping;
+
+    if ((au32StreamDst[u32Half][0] != s_au32Stamp[u32Half]) ||
+        (au32StreamDst[u32Half][STREAM_LEN / 4 - 1] != s_au32Stamp[u32Half]))
+        s_u32Error |= 4;
+    if (((s_u32StreamCount & 1) != u32Half) || (u32Event & PDMA_EVT_ABORT))
+        s_u32Error |= 4;
+
+    s_au32Stamp[u32Half] = s_u32StreamCount + 2;
+    pu32Src[0] = pu32Src[STREAM_LEN / 4 - 1] = s_au32Stamp[u32Half];
+    /* TestStream() stops the stream, PDMA_StopChannel() waits and is not for the callback */
+    s_u32StreamCount++;
+}
+
+static int32_t WaitFlags(volatile uint32_t *pu32Flags, uint32_t u32Mask)
+{
+    uint32_t i;
+
+    for (i = 0; i < WAIT_LOOPS; i++)
+        if ((*pu32Flags & u32Mask) == u32Mask)
+            return 0;
+    return -1;
+}
+
+/* Every channel of both controllers can be taken, and is handed out again after release */
+static void TestAllocation(void)
+{
+    int32_t ai32Ch[PDMA_SVC_CH_MAX + 1];
+    uint32_t i, au32Count[2] = { 0, 0 };
+
+    for (i = 0; i <= PDMA_SVC_CH_MAX; i++)
+    {
+        ai32Ch[i] = PDMA_RequestChannel(PDMA_MEM, NULL, NULL);
+        if (ai32Ch[i] >= 0)
+            au32Count[ai32Ch[i] / PDMA_CH_MAX]++;
+    }
+    printf("Allocation: PDMA0 %d, PDMA1 %d channels, extra request %s\n", au32Count[0], au32Count[1],
+           (ai32Ch[PDMA_SVC_CH_MAX] == PDMA_ERR_BUSY) ? "refused" : "FAILED");
+    for (i = 0; i <= PDMA_SVC_CH_MAX; i++)
+        PDMA_FreeChannel(ai32Ch[i]);
+}
+
+/* Gather three segments, one of them split, into one buffer */
+static void TestGather(void)
+{
+    PDMA_SG_T asList[3];
+    uint32_t i;
+    int32_t i32Ch;
+
+    for (i = 0; i < GATHER_LEN; i++)
+        au8Src[i] = (uint8_t)(i * 7 + (i >> 8));
+    memset(au8Dst, 0, GATHER_LEN);
+
+    /* Segments are taken from the source in reverse order */
+    asList[0].u32Src = (uint32_t)&au8Src[GATHER_LEN1 + GATHER_LEN2];
+    asList[0].u32Dst = (uint32_t)&au8Dst[0];
+    asList[0].u32Len = GATHER_LEN0;
+    asList[1].u32Src = (uint32_t)&au8Src[GATHER_LEN2];
+    asList[1].u32Dst = (uint32_t)&au8Dst[GATHER_LEN0];
+    asList[1].u32Len = GATHER_LEN1;
+    asList[2].u32Src = (uint32_t)&au8Src[0];
+    asList[2].u32Dst = (uint32_t)&au8Dst[GATHER_LEN0 + GATHER_LEN1];
+    asList[2].u32Len = GATHER_LEN2;
+
+    s_u32Done = s_u32Error = 0;
+    i32Ch = PDMA_RequestChannel(PDMA_MEM, TransferDone, (void *)1);
+    if (PDMA_SubmitSG(i32Ch, PDMA_WIDTH_8 | PDMA_SAR_INC | PDMA_DAR_INC | PDMA_REQ_BURST | PDMA_BURST_128, asList, 3) != PDMA_OK)
+    {
+        printf("Gather: submit FAILED\n");
+        PDMA_FreeChannel(i32Ch);
+        return;
+    }
+    if ((WaitFlags(&s_u32Done, 1) != 0) || s_u32Error ||
+        memcmp(&au8Dst[0], &au8Src[GATHER_LEN1 + GATHER_LEN2], GATHER_LEN0) ||
+        memcmp(&au8Dst[GATHER_LEN0], &au8Src[GATHER_LEN2], GATHER_LEN1) ||
+        memcmp(&au8Dst[GATHER_LEN0 + GATHER_LEN1], &au8Src[0], GATHER_LEN2))
+        printf("Gather: %d bytes in 3 segments FAILED\n", GATHER_LEN);
+    else
+        printf("Gather: %d bytes in 3 segments OK\n", GATHER_LEN);
+    PDMA_FreeChannel(i32Ch);
+}
+
+/* Two copies at the same time, one on each controller */
+static void TestConcurrent(void)
+{
+    PDMA_SG_T sCopy;
+    int32_t ai32Ch[2];
+    uint32_t i, j;
+
+    s_u32Done = s_u32Error = 0;
+    for (i = 0; i < 2; i++)
+    {
+        for (j = 0; j < COPY_LEN / 4; j++)
+            au32CopySrc[i][j] = (i << 24) ^ (j * 0x01010101);
+        memset(au32CopyDst[i], 0, COPY_LEN);
+        ai32Ch[i] = PDMA_RequestChannel(PDMA_MEM, TransferDone, (void *)(1 << i));
+    }
+    for (i = 0; i < 2; i++)
+    {
+        sCopy.u32Src = (uint32_t)au32CopySrc[i];
+        sCopy.u32Dst = (uint32_t)au32CopyDst[i];
+        sCopy.u32Len = COPY_LEN;
+        PDMA_SubmitSG(ai32Ch[i], PDMA_WIDTH_32 | PDMA_SAR_INC | PDMA_DAR_INC | PDMA_REQ_BURST | PDMA_BURST_128, &sCopy, 1);
+    }
+    if ((WaitFlags(&s_u32Done, 3) != 0) || s_u32Error ||
+        memcmp(au32CopyDst[0], au32CopySrc[0], COPY_LEN) || memcmp(au32CopyDst[1], au32CopySrc[1], COPY_LEN))
+        printf("Concurrent: channels %d and %d FAILED\n", ai32Ch[0], ai32Ch[1]);
+    else
+        printf("Concurrent: channels %d and %d OK\n", ai32Ch[0], ai32Ch[1]);
+    PDMA_FreeChannel(ai32Ch[0]);
+    PDMA_FreeChannel(ai32Ch[1]);
+}
+
+/* Ping-pong stream, each callback checks one buffer and stamps its source */
+static void TestStream(void)
+{
+    PDMA_SG_T sPing, sPong;
+    uint32_t i;
+    int32_t i32Ch;
+
+    for (i = 0; i < STREAM_LEN / 4; i++)
+    {
+        au32Ping[i] = 0;
+        au32Pong[i] = 1;
+    }
+    s_au32Stamp[0] = 0;
+    s_au32Stamp[1] = 1;
+    sPing.u32Src = (uint32_t)au32Ping;
+    sPing.u32Dst = (uint32_t)au32StreamDst[0];
+    sPing.u32Len = STREAM_LEN;
+    sPong.u32Src = (uint32_t)au32Pong;
+    sPong.u32Dst = (uint32_t)au32StreamDst[1];
+    sPong.u32Len = STREAM_LEN;
+
+    s_u32StreamCount = s_u32Error = 0;
+    i32Ch = PDMA_RequestChannel(PDMA_MEM, StreamDone, NULL);
+    PDMA_StartStream(i32Ch, PDMA_WIDTH_32 | PDMA_SAR_INC | PDMA_DAR_INC | PDMA_REQ_BURST | PDMA_BURST_128, &sPing, &sPong);
+
+    for (i = 0; (i < WAIT_LOOPS) && (s_u32StreamCount < STREAM_COUNT); i++) {}
+    PDMA_FreeChannel(i32Ch);
+    printf("Stream: %d of %d buffers %s\n", s_u32StreamCount, STREAM_COUNT,
+           ((s_u32StreamCount >= STREAM_COUNT) && !s_u32Error) ? "OK" : "FAILED");
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* MAIN function                                                                                           */
+/*---------------------------------------------------------------------------------------------------------*/
+int main(void)
+{
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+    UART_Init();
+    sysSetLocalInterrupt(ENABLE_IRQ);
+
+    printf("+-----------------------------------------------------------------------+ \n");
+    printf("|    PDMA Channel Service Sample Code                                   | \n");
+    printf("+-----------------------------------------------------------------------+ \n");
+
+    TestAllocation();
+    TestGather();
+    TestConcurrent();
+    TestStream();
+
+    printf("test done...\n");
+    while(1);
+}
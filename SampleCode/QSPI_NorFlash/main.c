@@ -0,0 +1,304 @@
+/**************************************************************************//**
+* @file     main.c
+* @brief    Open a QSPI NOR flash through its SFDP tables with the spinor
+*           driver, check reads of every alignment with and without PDMA and
+*           reads during a suspended erase, then measure read, program and
+*           erase speed against the byte-by-byte loop of QSPI_QuadMode_Flash.
+*
+* @note     The last TEST_AREA bytes of the flash are erased and rewritten.
+*
+* @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+#include "qspi.h"
+#include "spinor.h"
+
+#define BUS_CLOCK       50000000
+#define TEST_AREA       (128 * 1024)    /* At the end of the flash, erased by the test */
+#define CHECK_LEN       600             /* Reads of every length up to this one are checked */
+#define BENCH_LEN       (256 * 1024)
+#define SECTOR          512
+
+#if defined (__GNUC__) && !(__CC_ARM)
+static __attribute__((aligned(32))) uint8_t s_au8Ref[TEST_AREA];
+static __attribute__((aligned(32))) uint8_t s_au8Buf[BENCH_LEN + 64];
+#else
+static __align(32) uint8_t s_au8Ref[TEST_AREA];
+static __align(32) uint8_t s_au8Buf[BENCH_LEN + 64];
+#endif
+
+static SPINOR_T s_sNor;
+static uint32_t s_u32Base;
+
+/* ETIMER0 counts microseconds */
+static uint32_t usec(void)
+{
+    return ETIMER_GetCounter(0);
+}
+
+static uint32_t since(uint32_t u32Start)
+{
+    return (usec() - u32Start) & 0xFFFFFF;
+}
+
+/* Bytes over microseconds, printed in MB/s with two decimals */
+static void print_rate(const char *pcName, uint32_t u32Bytes, uint32_t u32Us)
+{
+    uint32_t u32Rate = u32Us ? (u32Bytes * 100 / u32Us) : 0;
+
+    printf("%-32s %8d bytes %8d us %4d.%02d MB/s\n", pcName, u32Bytes, u32Us, u32Rate / 100, u32Rate % 100);
+}
+
+/* The loop of QSPI_QuadMode_Flash: one QSPI_WRITE_TX / QSPI_IS_BUSY / QSPI_READ_RX per byte */
+static void byte_loop_read(uint32_t u32Addr, uint8_t *pu8Buf, uint32_t u32Len)
+{
+    QSPI_T *qspi = s_sNor.qspi;
+    uint32_t i;
+
+    QSPI_SET_SS_LOW(qspi);
+    QSPI_WRITE_TX(qspi, (s_sNor.u8ReadOp & 0x04) ? 0x0C : 0x0B);     /* 4-byte opcode set if 0Ch/6Ch/ECh */
+    for (i = s_sNor.u8AddrLen; i > 0; i--)
+        QSPI_WRITE_TX(qspi, (u32Addr >> ((i - 1) * 8)) & 0xFF);
+    QSPI_WRITE_TX(qspi, 0x00);
+    while(QSPI_IS_BUSY(qspi));
+    QSPI_ClearRxFIFO(qspi);
+
+    for (i = 0; i < u32Len; i++)
+    {
+        QSPI_WRITE_TX(qspi, 0x00);
+        while(QSPI_IS_BUSY(qspi));
+        pu8Buf[i] = QSPI_READ_RX(qspi);
+    }
+    QSPI_SET_SS_HIGH(qspi);
+}
+
+static void fill_ref(uint32_t u32Seed)
+{
+    uint32_t i;
+
+    for (i = 0; i < TEST_AREA; i++)
+    {
+        u32Seed = u32Seed * 1103515245 + 12345;
+        s_au8Ref[i] = (uint8_t)(u32Seed >> 16);
+    }
+}
+
+static uint32_t check_erased(uint32_t u32Off, uint32_t u32Len)
+{
+    uint32_t i;
+
+    SPINOR_Read(&s_sNor, s_u32Base + u32Off, s_au8Buf, u32Len);
+    for (i = 0; i < u32Len; i++)
+    {
+        if (s_au8Buf[i] != 0xFF)
+            return 1;
+    }
+    return 0;
+}
+
+/* Every buffer alignment, flash offset and length, by CPU and by PDMA */
+static uint32_t check_reads(void)
+{
+    uint32_t u32Pdma, u32Align, u32Len, u32Off, fail = 0;
+
+    for (u32Pdma = 0; u32Pdma < 2; u32Pdma++)
+    {
+        s_sNor.u32PdmaMin = u32Pdma ? 4 : 0xFFFFFFFF;
+        for (u32Align = 0; u32Align < 4; u32Align++)
+        {
+            for (u32Len = 1; u32Len <= CHECK_LEN; u32Len += (u32Len < 64) ? 1 : 37)
+            {
+                u32Off = (u32Len * 97 + u32Align) % (TEST_AREA - CHECK_LEN);
+                memset(s_au8Buf, 0x5A, u32Len + 8);
+                SPINOR_Read(&s_sNor, s_u32Base + u32Off, &s_au8Buf[u32Align], u32Len);
+                if (memcmp(&s_au8Buf[u32Align], &s_au8Ref[u32Off], u32Len) || (s_au8Buf[u32Align + u32Len] != 0x5A) ||
+                    (u32Align && (s_au8Buf[u32Align - 1] != 0x5A)))
+                {
+                    printf("Read %s buf+%d flash+0x%x len %d FAILED\n", u32Pdma ? "PDMA" : "CPU ", u32Align, u32Off, u32Len);
+                    fail++;
+                }
+            }
+        }
+    }
+    s_sNor.u32PdmaMin = SPINOR_PDMA_MIN;
+
+    /* The whole area in one read */
+    SPINOR_Read(&s_sNor, s_u32Base, s_au8Buf, TEST_AREA);
+    if (memcmp(s_au8Buf, s_au8Ref, TEST_AREA))
+    {
+        printf("Read %d bytes FAILED\n", TEST_AREA);
+        fail++;
+    }
+    return fail;
+}
+
+static uint32_t check(void)
+{
+    uint32_t u32Half = TEST_AREA / 2, u32Reads = 0, u32Off, i, fail = 0;
+
+    printf("Erase and program the last %d KB ...\n", TEST_AREA / 1024);
+    fill_ref(1);
+    if ((SPINOR_Erase(&s_sNor, s_u32Base, TEST_AREA) != SPINOR_OK) || check_erased(0, TEST_AREA))
+    {
+        printf("Erase FAILED\n");
+        return 1;
+    }
+
+    /* Odd pieces, so programs start and end inside pages and at every source alignment */
+    for (u32Off = 0, i = 1; u32Off < TEST_AREA; u32Off += i, i = (i * 7 + 3) % 700 + 1)
+    {
+        if (i > TEST_AREA - u32Off)
+            i = TEST_AREA - u32Off;
+        SPINOR_Program(&s_sNor, s_u32Base + u32Off, &s_au8Ref[u32Off], i);
+    }
+    fail += check_reads();
+
+    /* Read the first half while the second half is being erased */
+    if (SPINOR_EraseStart(&s_sNor, s_u32Base + u32Half, u32Half) != SPINOR_OK)
+    {
+        printf("No erase size of %d KB, suspend not checked\n", u32Half / 1024);
+        return fail;
+    }
+    while (SPINOR_IsBusy(&s_sNor))
+    {
+        u32Off = (u32Reads * 4099) % (u32Half - SECTOR);
+        SPINOR_Read(&s_sNor, s_u32Base + u32Off, s_au8Buf, SECTOR);
+        if (memcmp(s_au8Buf, &s_au8Ref[u32Off], SECTOR))
+        {
+            printf("Read during erase flash+0x%x FAILED\n", u32Off);
+            fail++;
+        }
+        u32Reads++;
+    }
+    if (check_erased(u32Half, u32Half))
+    {
+        printf("Erase during reads FAILED\n");
+        fail++;
+    }
+    SPINOR_Read(&s_sNor, s_u32Base, s_au8Buf, u32Half);
+    if (memcmp(s_au8Buf, s_au8Ref, u32Half))
+    {
+        printf("Data next to the erase FAILED\n");
+        fail++;
+    }
+    printf("%d sector reads during the erase %s\n", u32Reads, s_sNor.u8SuspendOp ? "(suspended)" : "(waited for it)");
+
+    return fail;
+}
+
+static void bench(void)
+{
+    uint32_t u32Len = (s_sNor.u32Size < BENCH_LEN) ? s_sNor.u32Size : BENCH_LEN;
+    uint32_t u32Start, u32Off;
+
+    printf("\nQSPI bus %d MHz\n", BUS_CLOCK / 1000000);
+
+    u32Start = usec();
+    byte_loop_read(0, s_au8Buf, u32Len);
+    print_rate("read, byte loop 1-1-1", u32Len, since(u32Start));
+
+    s_sNor.u32PdmaMin = 0xFFFFFFFF;
+    u32Start = usec();
+    SPINOR_Read(&s_sNor, 0, s_au8Buf, u32Len);
+    print_rate("read, 32-bit FIFO by CPU", u32Len, since(u32Start));
+
+    u32Start = usec();
+    for (u32Off = 0; u32Off < u32Len; u32Off += SECTOR)
+        SPINOR_Read(&s_sNor, u32Off, &s_au8Buf[u32Off], SECTOR);
+    print_rate("read, 512-byte sectors by CPU", u32Len, since(u32Start));
+
+    s_sNor.u32PdmaMin = SPINOR_PDMA_MIN;
+    u32Start = usec();
+    SPINOR_Read(&s_sNor, 0, s_au8Buf, u32Len);
+    print_rate("read, 32-bit FIFO by PDMA", u32Len, since(u32Start));
+
+    u32Start = usec();
+    for (u32Off = 0; u32Off < u32Len; u32Off += SECTOR)
+        SPINOR_Read(&s_sNor, u32Off, &s_au8Buf[u32Off], SECTOR);
+    print_rate("read, 512-byte sectors by PDMA", u32Len, since(u32Start));
+
+    u32Start = usec();
+    SPINOR_Read(&s_sNor, 1, &s_au8Buf[3], u32Len - 4);
+    print_rate("read, unaligned by PDMA", u32Len - 4, since(u32Start));
+
+    u32Start = usec();
+    SPINOR_Erase(&s_sNor, s_u32Base, TEST_AREA);
+    print_rate("erase", TEST_AREA, since(u32Start));
+
+    u32Start = usec();
+    SPINOR_Program(&s_sNor, s_u32Base, s_au8Ref, TEST_AREA);
+    print_rate("program", TEST_AREA, since(u32Start));
+}
+
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);   // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+int main(void)
+{
+    uint32_t i;
+
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+    UART_Init();
+
+    /* PDMA completion comes from its interrupt */
+    sysSetLocalInterrupt(ENABLE_IRQ);
+
+    /* enable GPIO and QSPI0 clock */
+    outpw(REG_CLK_HCLKEN, inpw(REG_CLK_HCLKEN) | 0x800);
+    outpw(REG_CLK_PCLKEN1, inpw(REG_CLK_PCLKEN1) | 0x10);
+
+    /* QSPI0 SS, CLK, D0, D1, D2 and D3 on PD2..PD7; with QE set D2/D3 never go back to WP#/HOLD# */
+    outpw(REG_SYS_GPD_MFPL, (inpw(REG_SYS_GPD_MFPL) & ~0xFFFFFF00) | 0x11111100);
+
+    // Enable ETIMER0 engine clock, free running counter at 1 MHz
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 8));
+    ETIMER_Open(0, ETIMER_CONTINUOUS_MODE, 1000000);
+    ETIMER_SET_PRESCALE_VALUE(0, 11);
+    ETIMER_SET_CMP_VALUE(0, 0xFFFFFF);
+    ETIMER_Start(0);
+
+    printf("\n+------------------------------------------------------------------------+\n");
+    printf("|                    NUC980 QSPI NOR Flash Sample Code                   |\n");
+    printf("+------------------------------------------------------------------------+\n");
+
+    if (SPINOR_Open(&s_sNor, QSPI0, BUS_CLOCK) != SPINOR_OK)
+    {
+        printf("No flash found\n");
+        while(1);
+    }
+    printf("ID %02X %02X %02X, %s, %d KB, page %d bytes, %d-byte address\n", s_sNor.au8Id[0], s_sNor.au8Id[1],
+           s_sNor.au8Id[2], s_sNor.u8Sfdp ? "SFDP" : "no SFDP", s_sNor.u32Size / 1024, s_sNor.u32PageSize, s_sNor.u8AddrLen);
+    printf("Read %02Xh %s, %d wait clocks; suspend %02Xh resume %02Xh; erase", s_sNor.u8ReadOp,
+           (s_sNor.u8ReadIo == SPINOR_IO_144) ? "1-4-4" : (s_sNor.u8ReadIo == SPINOR_IO_114) ? "1-1-4" : "1-1-1",
+           s_sNor.u8ReadWait, s_sNor.u8SuspendOp, s_sNor.u8ResumeOp);
+    for (i = 0; i < SPINOR_ERASE_TYPES; i++)
+    {
+        if (s_sNor.au32EraseSize[i])
+            printf(" %dK/%02Xh", s_sNor.au32EraseSize[i] / 1024, s_sNor.au8EraseOp[i]);
+    }
+    printf("\nPDMA channels RX %d TX %d\n\n", s_sNor.i32RxCh, s_sNor.i32TxCh);
+
+    s_u32Base = s_sNor.u32Size - TEST_AREA;
+    printf("%s\n", check() ? "Check FAILED" : "Check OK");
+
+    bench();
+
+    printf("test done...\n");
+    while(1);
+}
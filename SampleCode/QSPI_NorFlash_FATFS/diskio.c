@@ -0,0 +1,137 @@
+/*-----------------------------------------------------------------------*/
+/* Low level disk I/O module skeleton for FatFs     (C)ChaN, 2013        */
+/*-----------------------------------------------------------------------*/
+/* If a working storage control module is available, it should be        */
+/* attached to the FatFs via a glue function rather than modifying it.   */
+/* This is an example of glue functions to attach various exsisting      */
+/* storage control module to the FatFs module with a defined API.        */
+/*-----------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+
+#include "nuc980.h"
+#include "sys.h"
+#include "spinor.h"
+#include "ff.h"
+#include "diskio.h"
+#include "ffnor.h"
+
+
+#define DRV_NOR             8           /* "NOR" of _VOLUME_STRS */
+#define NOR_WORK_SIZE       FNOR_WORK_SIZE(512, FNOR_BLK_MAX)  /* A 32 MB region of 64 KB blocks */
+
+static DWORD    nor_work[NOR_WORK_SIZE];   /* Sector map and block table */
+static FNOR_DEV nor_dev;
+FNOR            nor_vol;                /* Translation layer of the drive, main.c reads its statistics */
+
+static int nor_read(void *ctx, DWORD addr, BYTE *buff, UINT len)
+{
+    return SPINOR_Read((SPINOR_T *)ctx, addr, buff, len);
+}
+
+static int nor_program(void *ctx, DWORD addr, const BYTE *buff, UINT len)
+{
+    return SPINOR_Program((SPINOR_T *)ctx, addr, buff, len);
+}
+
+static int nor_erase(void *ctx, DWORD addr, DWORD len)
+{
+    return SPINOR_Erase((SPINOR_T *)ctx, addr, len);
+}
+
+/* Put the translation layer on u32Size bytes of the flash from u32Base and rebuild its map.
+   The erase block is the largest erase size of the flash up to 64 KB. */
+DRESULT nor_disk_attach(SPINOR_T *psNor, uint32_t u32Base, uint32_t u32Size)
+{
+    uint32_t i, u32Blk = 0;
+
+    for (i = 0; i < SPINOR_ERASE_TYPES; i++)
+    {
+        if ((psNor->au32EraseSize[i] <= FNOR_BLK_MAX) && (psNor->au32EraseSize[i] > u32Blk))
+            u32Blk = psNor->au32EraseSize[i];
+    }
+    if (!u32Blk || (u32Base % u32Blk) || (FNOR_WORK_SIZE(u32Size / u32Blk, u32Blk) > NOR_WORK_SIZE))
+        return RES_PARERR;
+
+    nor_dev.read = nor_read;
+    nor_dev.program = nor_program;
+    nor_dev.erase = nor_erase;
+    nor_dev.ctx = psNor;
+    nor_dev.base = u32Base;
+    nor_dev.nblk = u32Size / u32Blk;
+    nor_dev.blksz = u32Blk;
+    return fnor_mount(&nor_vol, &nor_dev, nor_work);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Initialize a Drive                                                    */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS disk_initialize (BYTE pdrv)       /* Physical drive number (0..) */
+{
+    return disk_status(pdrv);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Get Disk Status                                                       */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS disk_status (BYTE pdrv)       /* Physical drive number (0..) */
+{
+    if ((pdrv != DRV_NOR) || !nor_vol.dev)
+        return STA_NOINIT;
+    return 0;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Read Sector(s)                                                        */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_read (
+    BYTE pdrv,      /* Physical drive number (0..) */
+    BYTE *buff,     /* Data buffer to store read data */
+    DWORD sector,   /* Sector address (LBA) */
+    UINT count      /* Number of sectors to read (1..128) */
+)
+{
+    if (disk_status(pdrv) & STA_NOINIT)
+        return RES_NOTRDY;
+    return fnor_read(&nor_vol, buff, sector, count);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Write Sector(s)                                                       */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_write (
+    BYTE pdrv,          /* Physical drive number (0..) */
+    const BYTE *buff,   /* Data to be written */
+    DWORD sector,       /* Sector address (LBA) */
+    UINT count          /* Number of sectors to write (1..128) */
+)
+{
+    if (disk_status(pdrv) & STA_NOINIT)
+        return RES_NOTRDY;
+    return fnor_write(&nor_vol, buff, sector, count);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Miscellaneous Functions                                               */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_ioctl (
+    BYTE pdrv,      /* Physical drive number (0..) */
+    BYTE cmd,       /* Control code */
+    void *buff      /* Buffer to send/receive control data */
+)
+{
+    if (disk_status(pdrv) & STA_NOINIT)
+        return RES_NOTRDY;
+    /* CTRL_SYNC, GET_SECTOR_COUNT, GET_SECTOR_SIZE, GET_BLOCK_SIZE and CTRL_TRIM */
+    return fnor_ioctl(&nor_vol, cmd, buff);
+}
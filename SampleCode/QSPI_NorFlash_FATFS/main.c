@@ -0,0 +1,285 @@
+/**************************************************************************//**
+* @file     main.c
+* @brief    Put FatFs on a QSPI NOR flash through the ffnor translation layer.
+*           Measure single-sector write IOPS and erase counts of the layer
+*           against a read-erase-write of the erase block, check the sectors
+*           after a remount, then format the drive and write a log file with
+*           f_sync() after every record.
+*
+* @note     The flash from NOR_FTL_BASE is reformatted. The last 64 KB are
+*           used for the read-erase-write comparison.
+*
+* @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+#include "qspi.h"
+#include "spinor.h"
+#include "ff.h"
+#include "diskio.h"
+#include "ffnor.h"
+
+#define BUS_CLOCK       50000000
+#define NOR_FTL_BASE    (2 * 1024 * 1024)   /* Keeps the boot image */
+#define NOR_FTL_MAX     (8 * 1024 * 1024)
+#define NOR_SCRATCH     (64 * 1024)         /* At the end of the flash */
+#define SECTOR          512
+#define HOT_SECTORS     2048                /* Small writes land in the first 1 MB of the drive */
+#define RMW_WRITES      20
+#define FTL_WRITES      2000
+#define LOG_RECORDS     500
+
+extern FNOR nor_vol;
+extern DRESULT nor_disk_attach(SPINOR_T *psNor, uint32_t u32Base, uint32_t u32Size);
+
+#if defined (__GNUC__) && !(__CC_ARM)
+static __attribute__((aligned(32))) uint8_t s_au8Blk[64 * 1024];
+static __attribute__((aligned(32))) uint8_t s_au8Sec[SECTOR];
+#else
+static __align(32) uint8_t s_au8Blk[64 * 1024];
+static __align(32) uint8_t s_au8Sec[SECTOR];
+#endif
+
+static SPINOR_T s_sNor;
+static uint16_t s_au16Ver[HOT_SECTORS];     /* Last version written to each hot sector */
+static uint32_t s_u32Seed = 1;
+static FATFS s_sFs;
+static FIL s_sFile;
+
+/* ETIMER0 counts microseconds */
+static uint32_t usec(void)
+{
+    return ETIMER_GetCounter(0);
+}
+
+static uint32_t since(uint32_t u32Start)
+{
+    return (usec() - u32Start) & 0xFFFFFF;
+}
+
+static uint32_t rand32(void)
+{
+    s_u32Seed = s_u32Seed * 1103515245 + 12345;
+    return s_u32Seed >> 8;
+}
+
+static void print_iops(const char *pcName, uint32_t u32Ops, uint32_t u32Us)
+{
+    printf("%-36s %6d writes %10d us %6d IOPS\n", pcName, u32Ops, u32Us, u32Us ? (uint32_t)((uint64_t)u32Ops * 1000000 / u32Us) : 0);
+}
+
+static void print_stat(void)
+{
+    FNOR_STAT sStat;
+
+    fnor_get_stat(&nor_vol, &sStat, 1);
+    printf("  %d host sectors (%d merged), %d slots programmed, %d copied, %d erases, %d trimmed, erase count %d..%d\n",
+           sStat.wrsect, sStat.merged, sStat.prog, sStat.gccopy, sStat.erase, sStat.trim, sStat.ecmin, sStat.ecmax);
+}
+
+static void fill_sector(uint8_t *pu8Buf, uint32_t u32Sector, uint32_t u32Ver)
+{
+    uint32_t i;
+
+    for (i = 0; i < SECTOR; i += 4)
+        *(uint32_t *)&pu8Buf[i] = (u32Sector << 16) ^ u32Ver ^ (i * 0x01010101);
+}
+
+/* What FatFs on the raw flash would do for each sector write: read, erase and program the erase block */
+static void bench_rmw(uint32_t u32Base)
+{
+    uint32_t u32Blk = s_sNor.u32EraseSize, u32Start, u32Us = 0, u32Addr, i;
+
+    for (i = 0; i < RMW_WRITES; i++)
+    {
+        u32Addr = u32Base + (rand32() % (NOR_SCRATCH / SECTOR)) * SECTOR;
+        u32Start = usec();
+        SPINOR_Read(&s_sNor, u32Addr & ~(u32Blk - 1), s_au8Blk, u32Blk);
+        fill_sector(&s_au8Blk[u32Addr & (u32Blk - 1)], i, i);
+        SPINOR_Erase(&s_sNor, u32Addr & ~(u32Blk - 1), u32Blk);
+        SPINOR_Program(&s_sNor, u32Addr & ~(u32Blk - 1), s_au8Blk, u32Blk);
+        u32Us += since(u32Start);
+    }
+    printf("read-erase-write of a %d KB block:\n", u32Blk / 1024);
+    print_iops("  1 sector, then sync", RMW_WRITES, u32Us);
+}
+
+/* Single-sector writes to random hot sectors, synced every u32Sync writes */
+static void bench_ftl(uint32_t u32Sync)
+{
+    uint32_t u32Start, u32Us = 0, u32Sector, i;
+    char acName[40];
+
+    for (i = 0; i < FTL_WRITES; i++)
+    {
+        u32Sector = rand32() % HOT_SECTORS;
+        fill_sector(s_au8Sec, u32Sector, ++s_au16Ver[u32Sector]);
+        u32Start = usec();
+        disk_write(8, s_au8Sec, u32Sector, 1);
+        if ((i + 1) % u32Sync == 0)
+            disk_ioctl(8, CTRL_SYNC, 0);
+        u32Us += since(u32Start);
+    }
+    sprintf(acName, "  1 sector, sync every %d", u32Sync);
+    print_iops(acName, FTL_WRITES, u32Us);
+    print_stat();
+}
+
+static uint32_t check_hot(void)
+{
+    uint32_t i, fail = 0;
+
+    for (i = 0; i < HOT_SECTORS; i++)
+    {
+        if (!s_au16Ver[i])
+            continue;
+        fill_sector(s_au8Blk, i, s_au16Ver[i]);
+        if ((disk_read(8, s_au8Sec, i, 1) != RES_OK) || memcmp(s_au8Sec, s_au8Blk, SECTOR))
+        {
+            printf("Sector %d FAILED\n", i);
+            fail++;
+        }
+    }
+    return fail;
+}
+
+/* Append LOG_RECORDS records of one sector with f_sync() after each, then read them back */
+static uint32_t check_log(void)
+{
+    uint32_t u32Start, u32Us = 0, i, fail = 0;
+    UINT n;
+    DWORD u32Free;
+    FATFS *psFs;
+
+    if ((f_open(&s_sFile, "8:/log.bin", FA_CREATE_ALWAYS | FA_WRITE) != FR_OK))
+        return 1;
+    for (i = 0; i < LOG_RECORDS; i++)
+    {
+        fill_sector(s_au8Sec, i, 0x5A5A);
+        u32Start = usec();
+        if ((f_write(&s_sFile, s_au8Sec, SECTOR, &n) != FR_OK) || (n != SECTOR) || (f_sync(&s_sFile) != FR_OK))
+            fail++;
+        u32Us += since(u32Start);
+    }
+    f_close(&s_sFile);
+    print_iops("  512-byte record, f_sync", LOG_RECORDS, u32Us);
+    print_stat();
+
+    if (f_open(&s_sFile, "8:/log.bin", FA_READ) != FR_OK)
+        return fail + 1;
+    for (i = 0; i < LOG_RECORDS; i++)
+    {
+        fill_sector(s_au8Blk, i, 0x5A5A);
+        if ((f_read(&s_sFile, s_au8Sec, SECTOR, &n) != FR_OK) || (n != SECTOR) || memcmp(s_au8Sec, s_au8Blk, SECTOR))
+            fail++;
+    }
+    f_close(&s_sFile);
+
+    /* Removing the file trims its clusters */
+    f_unlink("8:/log.bin");
+    disk_ioctl(8, CTRL_SYNC, 0);
+    f_getfree("8:", &u32Free, &psFs);
+    printf("  file removed, %d KB free\n", u32Free * psFs->csize * SECTOR / 1024);
+    print_stat();
+    return fail;
+}
+
+/* This is a real time clock service to be called from     */
+/* FatFs module. Any valid time must be returned even if   */
+/* the system does not support an RTC.                     */
+unsigned long get_fattime (void)
+{
+    return 0;
+}
+
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);   // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+int main(void)
+{
+    uint32_t u32Size, fail = 0;
+    DWORD u32Sectors;
+
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+    UART_Init();
+
+    /* PDMA completion comes from its interrupt */
+    sysSetLocalInterrupt(ENABLE_IRQ);
+
+    /* enable GPIO and QSPI0 clock */
+    outpw(REG_CLK_HCLKEN, inpw(REG_CLK_HCLKEN) | 0x800);
+    outpw(REG_CLK_PCLKEN1, inpw(REG_CLK_PCLKEN1) | 0x10);
+
+    /* QSPI0 SS, CLK, D0, D1, D2 and D3 on PD2..PD7 */
+    outpw(REG_SYS_GPD_MFPL, (inpw(REG_SYS_GPD_MFPL) & ~0xFFFFFF00) | 0x11111100);
+
+    // Enable ETIMER0 engine clock, free running counter at 1 MHz
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 8));
+    ETIMER_Open(0, ETIMER_CONTINUOUS_MODE, 1000000);
+    ETIMER_SET_PRESCALE_VALUE(0, 11);
+    ETIMER_SET_CMP_VALUE(0, 0xFFFFFF);
+    ETIMER_Start(0);
+
+    printf("\n+------------------------------------------------------------------------+\n");
+    printf("|               NUC980 FatFs on QSPI NOR Flash Sample Code               |\n");
+    printf("+------------------------------------------------------------------------+\n");
+
+    if ((SPINOR_Open(&s_sNor, QSPI0, BUS_CLOCK) != SPINOR_OK) || (s_sNor.u32Size < NOR_FTL_BASE + 2 * 1024 * 1024))
+    {
+        printf("No flash of 4 MB or more found\n");
+        while(1);
+    }
+    u32Size = s_sNor.u32Size - NOR_SCRATCH - NOR_FTL_BASE;
+    if (u32Size > NOR_FTL_MAX)
+        u32Size = NOR_FTL_MAX;
+
+    bench_rmw(s_sNor.u32Size - NOR_SCRATCH);
+
+    if (nor_disk_attach(&s_sNor, NOR_FTL_BASE, u32Size) != RES_OK)
+    {
+        printf("Mount of the translation layer FAILED\n");
+        while(1);
+    }
+    disk_ioctl(8, GET_SECTOR_COUNT, &u32Sectors);
+    printf("\nDrive of %d KB at flash+0x%x, %d sectors per %d KB block\n", u32Sectors / 2, NOR_FTL_BASE,
+           nor_vol.nslot, nor_vol.dev->blksz / 1024);
+    print_stat();
+
+    printf("translation layer:\n");
+    bench_ftl(1);
+    bench_ftl(8);
+
+    /* Rebuild the map from the flash as after a power cycle */
+    nor_disk_attach(&s_sNor, NOR_FTL_BASE, u32Size);
+    fail += check_hot();
+    printf("Sectors after remount %s\n", fail ? "FAILED" : "OK");
+
+    printf("\nFatFs:\n");
+    f_mount(&s_sFs, "8:", 0);
+    if ((f_mkfs("8:", 1, 0) != FR_OK) || (f_mount(&s_sFs, "8:", 1) != FR_OK))
+    {
+        printf("Format FAILED\n");
+        while(1);
+    }
+    print_stat();
+    fail += check_log();
+
+    printf("%s\n", fail ? "Check FAILED" : "Check OK");
+    printf("test done...\n");
+    while(1);
+}
@@ -11,9 +11,11 @@
 #include <string.h>
 
 #include "nuc980.h"
+#include "sys.h"
 #include "sdh.h"
 #include "ff.h"
 #include "diskio.h"
+#include "ffcache.h"
 
 
 #define SD0_DRIVE       0        /* for SD0          */
@@ -25,10 +27,12 @@
 #define USBH_DRIVE_3    6        /* USB Mass Storage */
 #define USBH_DRIVE_4    7        /* USB Mass Storage */
 
+#define FATFS_BOUNCE_SECTORS    32      /* Sectors moved per SDH command for cacheable buffers */
+
 #if defined (__GNUC__) && !(__CC_ARM)
-static __attribute__((aligned(32))) BYTE  fatfs_win_buff_pool[_MAX_SS] ;       /* FATFS window buffer is cacheable. Must not use it directly. */
+static __attribute__((aligned(32))) BYTE  fatfs_win_buff_pool[FATFS_BOUNCE_SECTORS * _MAX_SS] ;       /* FATFS window buffer is cacheable. Must not use it directly. */
 #else
-static __align(32) BYTE  fatfs_win_buff_pool[_MAX_SS] ;       /* FATFS window buffer is cacheable. Must not use it directly. */
+static __align(32) BYTE  fatfs_win_buff_pool[FATFS_BOUNCE_SECTORS * _MAX_SS] ;       /* FATFS window buffer is cacheable. Must not use it directly. */
 #endif
 BYTE  *fatfs_win_buff;
 
@@ -37,6 +41,21 @@ BYTE  *fatfs_win_buff;
 #define DRV_SD0     0
 #define DRV_SD1     1
 
+static DRESULT sd_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count);
+static DRESULT sd_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count);
+
+static FFC_DEV  sd_dev = { sd_read, sd_write, 0, FATFS_BOUNCE_SECTORS };
+static BYTE     sd_attached;        /* Bit n set: drive n is attached to the sector cache */
+
+/* Attach the SD drive to the sector cache. Cached sectors of a previous card are dropped. */
+static void sd_attach(BYTE pdrv)
+{
+    /* The non-cacheable bounce pool doubles as the cache staging buffer */
+    sd_dev.stage = (BYTE *)((unsigned int)fatfs_win_buff_pool | 0x80000000);
+    ffc_attach(pdrv, &sd_dev, (pdrv == DRV_SD0) ? SD0.totalSectorN : SD1.totalSectorN);
+    sd_attached |= (1 << pdrv);
+}
+
 
 /*-----------------------------------------------------------------------*/
 /* Initialize a Drive                                                    */
@@ -56,7 +75,11 @@ DSTATUS disk_initialize (BYTE pdrv)       /* Physical drive number (0..) */
         if (SDH_GET_CARD_CAPACITY(SDH1) == 0)
             return STA_NOINIT;
         break;
+
+    default:
+        return STA_NOINIT;
     }
+    sd_attach(pdrv);
     return RES_OK;
 }
 
@@ -86,36 +109,43 @@ DSTATUS disk_status (BYTE pdrv)       /* Physical drive number (0..) */
 
 
 /*-----------------------------------------------------------------------*/
-/* Read Sector(s)                                                        */
+/* Read Sector(s) from the card                                          */
 /*-----------------------------------------------------------------------*/
 
-DRESULT disk_read (
+static DRESULT sd_read (
     BYTE pdrv,      /* Physical drive number (0..) */
     BYTE *buff,     /* Data buffer to store read data */
     DWORD sector,   /* Sector address (LBA) */
-    UINT count      /* Number of sectors to read (1..128) */
+    UINT count      /* Number of sectors to read */
 )
 {
     DRESULT   ret;
     outpw(REG_SDH_GCTL, SDH_GCTL_SDEN_Msk);
     //printf("disk_read - drv:%d, sec:%d, cnt:%d, buff:0x%x\n", pdrv, sector, count, (UINT32)buff);
 
-    if (!((UINT32)buff & 0x80000000))
+    if (!((UINT32)buff & 0x80000000) && ((UINT32)buff & (SYS_DCACHE_LINE_SIZE - 1)))
     {
-        /* Disk read buffer is not non-cacheable buffer. Use my non-cacheable to do disk read. */
-        if (count * 512 > _MAX_SS)
-            return RES_ERROR;
-
+        /* Disk read buffer is cacheable and shares D-cache lines with other data. Use my non-cacheable to do disk read.
+           Line aligned buffers go straight to SDH, which maintains the D-cache for them. */
+        UINT    n;
 
         //fatfs_win_buff = (BYTE *)((unsigned int)fatfs_win_buff_pool);
         fatfs_win_buff = (BYTE *)((unsigned int)fatfs_win_buff_pool | 0x80000000);
-        if (pdrv == DRV_SD0)
-            ret = (DRESULT) SDH_Read(SDH0, fatfs_win_buff, sector, count);
-        else if (pdrv == DRV_SD1)
-            ret = (DRESULT) SDH_Read(SDH1, fatfs_win_buff, sector, count);
-        else
-            return RES_ERROR;
-        memcpy(buff, fatfs_win_buff, count * 512);
+        ret = RES_OK;
+        while (count && (ret == RES_OK))
+        {
+            n = (count > FATFS_BOUNCE_SECTORS) ? FATFS_BOUNCE_SECTORS : count;
+            if (pdrv == DRV_SD0)
+                ret = (DRESULT) SDH_Read(SDH0, fatfs_win_buff, sector, n);
+            else if (pdrv == DRV_SD1)
+                ret = (DRESULT) SDH_Read(SDH1, fatfs_win_buff, sector, n);
+            else
+                return RES_ERROR;
+            sysMemCopy(buff, fatfs_win_buff, n * 512);
+            buff += n * 512;
+            sector += n;
+            count -= n;
+        }
     }
     else
     {
@@ -132,14 +162,14 @@ DRESULT disk_read (
 
 
 /*-----------------------------------------------------------------------*/
-/* Write Sector(s)                                                       */
+/* Write Sector(s) to the card                                           */
 /*-----------------------------------------------------------------------*/
 
-DRESULT disk_write (
+static DRESULT sd_write (
     BYTE pdrv,          /* Physical drive number (0..) */
     const BYTE *buff,   /* Data to be written */
     DWORD sector,       /* Sector address (LBA) */
-    UINT count          /* Number of sectors to write (1..128) */
+    UINT count          /* Number of sectors to write */
 )
 {
     DRESULT   ret;
@@ -147,20 +177,28 @@ DRESULT disk_write (
     outpw(REG_SDH_GCTL, SDH_GCTL_SDEN_Msk);
     //printf("disk_write - drv:%d, sec:%d, cnt:%d, buff:0x%x\n", pdrv, sector, count, (UINT32)buff);
 
-    if (!((UINT32)buff & 0x80000000))
+    if (!((UINT32)buff & 0x80000000) && ((UINT32)buff & (SYS_DCACHE_LINE_SIZE - 1)))
     {
-        /* Disk write buffer is not non-cacheable buffer. Use my non-cacheable to do disk write. */
-        if (count * 512 > _MAX_SS)
-            return RES_ERROR;
+        /* Disk write buffer is cacheable and shares D-cache lines with other data. Use my non-cacheable to do disk write.
+           Line aligned buffers go straight to SDH, which maintains the D-cache for them. */
+        UINT    n;
 
         fatfs_win_buff = (BYTE *)((unsigned int)fatfs_win_buff_pool | 0x80000000);
-        memcpy(fatfs_win_buff, buff, count * 512);
-        if (pdrv == DRV_SD0)
-            ret = (DRESULT) SDH_Write(SDH0, fatfs_win_buff, sector, count);
-        else if (pdrv == DRV_SD1)
-            ret = (DRESULT) SDH_Write(SDH1, fatfs_win_buff, sector, count);
-        else
-            return RES_ERROR;
+        ret = RES_OK;
+        while (count && (ret == RES_OK))
+        {
+            n = (count > FATFS_BOUNCE_SECTORS) ? FATFS_BOUNCE_SECTORS : count;
+            sysMemCopy(fatfs_win_buff, buff, n * 512);
+            if (pdrv == DRV_SD0)
+                ret = (DRESULT) SDH_Write(SDH0, fatfs_win_buff, sector, n);
+            else if (pdrv == DRV_SD1)
+                ret = (DRESULT) SDH_Write(SDH1, fatfs_win_buff, sector, n);
+            else
+                return RES_ERROR;
+            buff += n * 512;
+            sector += n;
+            count -= n;
+        }
     }
     else
     {
@@ -175,6 +213,44 @@ DRESULT disk_write (
 }
 
 
+/*-----------------------------------------------------------------------*/
+/* Read Sector(s)                                                        */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_read (
+    BYTE pdrv,      /* Physical drive number (0..) */
+    BYTE *buff,     /* Data buffer to store read data */
+    DWORD sector,   /* Sector address (LBA) */
+    UINT count      /* Number of sectors to read (1..128) */
+)
+{
+    if ((pdrv > DRV_SD1) || (disk_status(pdrv) & STA_NOINIT))
+        return RES_NOTRDY;
+    if (!(sd_attached & (1 << pdrv)))
+        sd_attach(pdrv);
+    return ffc_read(pdrv, buff, sector, count);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Write Sector(s)                                                       */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_write (
+    BYTE pdrv,          /* Physical drive number (0..) */
+    const BYTE *buff,   /* Data to be written */
+    DWORD sector,       /* Sector address (LBA) */
+    UINT count          /* Number of sectors to write (1..128) */
+)
+{
+    if ((pdrv > DRV_SD1) || (disk_status(pdrv) & STA_NOINIT))
+        return RES_NOTRDY;
+    if (!(sd_attached & (1 << pdrv)))
+        sd_attach(pdrv);
+    return ffc_write(pdrv, buff, sector, count);
+}
+
+
 /*-----------------------------------------------------------------------*/
 /* Miscellaneous Functions                                               */
 /*-----------------------------------------------------------------------*/
@@ -194,6 +270,7 @@ DRESULT disk_ioctl (
         switch(cmd)
         {
         case CTRL_SYNC:
+            res = ffc_sync(pdrv);
             break;
         case GET_SECTOR_COUNT:
             *(DWORD*)buff = SD0.totalSectorN;
@@ -212,6 +289,7 @@ DRESULT disk_ioctl (
         switch(cmd)
         {
         case CTRL_SYNC:
+            res = ffc_sync(pdrv);
             break;
         case GET_SECTOR_COUNT:
             *(DWORD*)buff = SD1.totalSectorN;
@@ -10,7 +10,10 @@
 #include "nuc980.h"
 #include "sys.h"
 #include "sdh.h"
+#include "etimer.h"
 #include "ff.h"
+#include "ffstream.h"
+#include "ffcache.h"
 #include "diskio.h"
 
 
@@ -34,15 +37,36 @@ __align(32) BYTE Buff_Pool[BUFF_SIZE] ;       /* Working buffer */
 
 BYTE  *Buff;
 
+static volatile uint32_t _timer_ms;
+
+void ETMR0_IRQHandler(void)
+{
+    _timer_ms++;
+    ETIMER_ClearIntFlag(0);
+}
+
+/* Restart the 1 kHz measurement timer */
 void timer_init()
 {
-    printf("timer_init() To do...\n");
+    static int bInit = 0;
+
+    if (!bInit)
+    {
+        bInit = 1;
+        outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 8));   /* ETIMER0 engine clock */
+        ETIMER_Open(0, ETIMER_PERIODIC_MODE, 1000);
+        ETIMER_EnableInt(0);
+        sysInstallISR(IRQ_LEVEL_1, IRQ_TIMER0, (PVOID)ETMR0_IRQHandler);
+        sysEnableInterrupt(IRQ_TIMER0);
+        ETIMER_Start(0);
+    }
+    _timer_ms = 0;
 }
 
+/* Milliseconds since timer_init() */
 uint32_t get_timer_value()
 {
-    printf("get_timer_value() To do...\n");
-    return 1;
+    return _timer_ms;
 }
 BYTE SDH_Drv; // select SD0
 
@@ -269,7 +293,7 @@ void get_line (char *buff, int len)
 }
 
 unsigned int volatile gCardInit = 0;
-void SDH_IRQHandler(void)
+SYS_FASTCODE void SDH_IRQHandler(void)
 {
     unsigned int volatile isr;
     unsigned int volatile ier;
@@ -391,6 +415,52 @@ void UART_Init()
 }
 
 static FIL file1, file2;        /* File objects */
+static FFSTREAM stream1;        /* Stream object with the cluster link map attached */
+
+/*---------------------------------------------------------*/
+/* Show and clear the sector cache statistics of a drive   */
+/*---------------------------------------------------------*/
+static void put_cache_stat(BYTE pdrv)
+{
+    FFC_STAT st;
+
+    ffc_get_stat(pdrv, &st, 1);
+    printf("cache: hit %d, miss %d, read-ahead %d sectors\n", st.hit, st.miss, st.ahead);
+    printf("device: %d read cmds, %d write cmds, %d sectors written\n", st.rdcmd, st.wrcmd, st.wrsect);
+}
+
+/*---------------------------------------------------------*/
+/* Random seek + sector read latency on an open file       */
+/*---------------------------------------------------------*/
+static void seek_bench(const char *name, FIL *fp, UINT count)
+{
+    uint32_t seed = 1, t;
+    FSIZE_t ofs, size = fp->obj.objsize;
+    FRESULT res = FR_OK;
+    UINT i, n;
+
+    if (size < 512)
+    {
+        printf("%s: file too small\n", name);
+        return;
+    }
+    timer_init();
+    for (i = 0; i < count; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        ofs = ((seed >> 8) % (size / 512)) * 512;
+        res = f_lseek(fp, ofs);
+        if (res == FR_OK)
+            res = f_read(fp, Buff, 512, &n);
+        if (res != FR_OK)
+            break;
+    }
+    t = get_timer_value();
+    if (res != FR_OK)
+        put_rc(res);
+    else
+        printf("%s: %d seeks, %d us/seek\n", name, count, (t * 1000) / count);
+}
 
 /*----------------------------------------------------------------------------
   MAIN function
@@ -419,10 +489,13 @@ int32_t main(void)
     sysDisableCache();
     sysFlushCache(I_D_CACHE);
     sysEnableCache(CACHE_WRITE_BACK);
+    if (sysLockFastCode() != Successful)
+        printf("sysLockFastCode failed, interrupt paths are not locked in the I-cache\n");
 
     Buff = (BYTE *)((UINT32)&Buff_Pool[0] | 0x80000000);   /* use non-cache buffer */
 
     SYS_Init();
+    sysProfInit();
 
     sysInstallISR(IRQ_LEVEL_1, IRQ_SDH, (PVOID)SDH_IRQHandler);
     /* enable CPSR I bit */
@@ -438,6 +511,7 @@ int32_t main(void)
         if (gCardInit) {
             gCardInit = 0;
             SDH_Open_Disk(SDH1, CardDetect_From_GPIO);
+            disk_initialize(SDH_Drv);   /* Drop cached sectors of the previous card */
         }
 
         if(!(SDH_CardDetection(SDH1)))
@@ -478,6 +552,15 @@ int32_t main(void)
                     put_dump(buf, ofs, 16);
                 break;
 
+            case 's' :  /* ds - Show and clear sector cache statistics */
+                put_cache_stat(SDH_Drv);
+                break;
+
+            case 'p' :  /* dp - Show and clear driver probe statistics */
+                sysProfDump();
+                sysProfReset();
+                break;
+
             }
             break;
 
@@ -690,9 +773,9 @@ int32_t main(void)
                     p2 += s2;
                     if (cnt != s2) break;
                 }
-                p1 = get_timer_value()/1000;
+                p1 = get_timer_value();
                 if (p1)
-                    printf("%d bytes read with %d kB/sec.\n", p2, ((p2 * 100) / p1)/1024);
+                    printf("%d bytes read with %d kB/sec.\n", p2, ((p2 / 1024) * 1000) / p1);
                 break;
 
             case 'w' :  /* fw <len> <val> - write file */
@@ -721,9 +804,88 @@ int32_t main(void)
                     p2 += s2;
                     if (cnt != s2) break;
                 }
-                p1 = get_timer_value()/1000;
+                p1 = get_timer_value();
                 if (p1)
-                    printf("%d bytes written with %d kB/sec.\n", p2, ((p2 * 100) / p1)/1024);
+                    printf("%d bytes written with %d kB/sec.\n", p2, ((p2 / 1024) * 1000) / p1);
+                break;
+
+            case 'O' :  /* fO <mode> <file> - Open a file as a stream */
+                if (!xatoi(&ptr, &p1)) break;
+                while (*ptr == ' ') ptr++;
+                put_rc(ffs_open(&stream1, ptr, (BYTE)p1));
+                printf("%s seek mode\n", ffs_is_fast(&stream1) ? "fast" : "normal");
+                break;
+
+            case 'P' :  /* fP <size> <file> - Create a recording stream with a contiguous pre-allocation */
+                if (!xatoi(&ptr, &p1)) break;
+                while (*ptr == ' ') ptr++;
+                put_rc(ffs_create(&stream1, ptr, (FSIZE_t)p1));
+                printf("%s seek mode\n", ffs_is_fast(&stream1) ? "fast" : "normal");
+                break;
+
+            case 'C' :  /* fC - Close the stream */
+                put_rc(ffs_close(&stream1));
+                break;
+
+            case 'E' :  /* fE <ofs> - Move stream pointer in fast seek */
+                if (!xatoi(&ptr, &p1)) break;
+                res = ffs_seek(&stream1, p1);
+                put_rc(res);
+                if (res == FR_OK)
+                    printf("fptr=%d(0x%lX)\n", stream1.fil.fptr, stream1.fil.fptr);
+                break;
+
+            case 'R' :  /* fR <len> - Read the stream */
+                if (!xatoi(&ptr, &p1)) break;
+                p2 = 0;
+                timer_init();
+                while (p1)
+                {
+                    cnt = ((UINT)p1 >= blen) ? blen : p1;
+                    p1 -= cnt;
+                    res = ffs_read(&stream1, Buff, cnt, &s2);
+                    if (res != FR_OK)
+                    {
+                        put_rc(res);
+                        break;
+                    }
+                    p2 += s2;
+                    if (cnt != s2) break;
+                }
+                p1 = get_timer_value();
+                if (p1)
+                    printf("%d bytes read with %d kB/sec.\n", p2, ((p2 / 1024) * 1000) / p1);
+                break;
+
+            case 'W' :  /* fW <len> <val> - Write the stream */
+                if (!xatoi(&ptr, &p1) || !xatoi(&ptr, &p2)) break;
+                memset(Buff, (BYTE)p2, blen);
+                p2 = 0;
+                timer_init();
+                while (p1)
+                {
+                    cnt = ((UINT)p1 >= blen) ? blen : p1;
+                    p1 -= cnt;
+                    res = ffs_write(&stream1, Buff, cnt, &s2);
+                    if (res != FR_OK)
+                    {
+                        put_rc(res);
+                        break;
+                    }
+                    p2 += s2;
+                    if (cnt != s2) break;
+                }
+                p1 = get_timer_value();
+                if (p1)
+                    printf("%d bytes written with %d kB/sec.\n", p2, ((p2 / 1024) * 1000) / p1);
+                break;
+
+            case 'B' :  /* fB <count> - Random seek benchmark, file (normal) vs. stream (fast) */
+                if (!xatoi(&ptr, &p1) || p1 <= 0) break;
+                if (file1.obj.fs)
+                    seek_bench("normal", &file1, p1);
+                if (stream1.fil.obj.fs)
+                    seek_bench("stream", &stream1.fil, p1);
                 break;
 
             case 'n' :  /* fn <old_name> <new_name> - Change file/dir name */
@@ -788,6 +950,7 @@ int32_t main(void)
                 }
                 printf("Copying...");
                 p1 = 0;
+                timer_init();
                 for (;;)
                 {
                     res = f_read(&file1, Buff, BUFF_SIZE, &s1);
@@ -796,9 +959,44 @@ int32_t main(void)
                     p1 += s2;
                     if (res || s2 < s1) break;   /* error or disk full */
                 }
-                printf("\n%d bytes copied.\n", p1);
                 f_close(&file1);
                 f_close(&file2);
+                p2 = get_timer_value();
+                printf("\n%d bytes copied in %d ms.\n", p1, p2);
+                put_cache_stat(SDH_Drv);
+                break;
+
+            case 'L' :  /* fL <records> <size> <sync> <file> - Logging workload, f_sync every <sync> records */
+                if (!xatoi(&ptr, &p1) || !xatoi(&ptr, &p2) || !xatoi(&ptr, &p3)) break;
+                while (*ptr == ' ') ptr++;
+                if ((UINT)p2 > blen || p3 <= 0) break;
+                res = f_open(&file2, ptr, FA_OPEN_ALWAYS | FA_WRITE);
+                if (res == FR_OK)
+                    res = f_lseek(&file2, f_size(&file2));
+                if (res)
+                {
+                    put_rc(res);
+                    break;
+                }
+                memset(Buff, 'L', p2);
+                put_cache_stat(SDH_Drv);    /* Clear counters */
+                timer_init();
+                for (cnt = 1; (long)cnt <= p1; cnt++)
+                {
+                    res = f_write(&file2, Buff, p2, &s2);
+                    if (res || (long)s2 < p2) break;
+                    if ((cnt % p3) == 0)
+                    {
+                        res = f_sync(&file2);
+                        if (res) break;
+                    }
+                }
+                f_close(&file2);
+                p3 = get_timer_value();
+                if (res)
+                    put_rc(res);
+                printf("%d records logged in %d ms.\n", cnt - 1, p3);
+                put_cache_stat(SDH_Drv);
                 break;
 #if _FS_RPATH
             case 'g' :  /* fg <path> - Change current directory */
@@ -832,7 +1030,8 @@ int32_t main(void)
             printf(
                 _T("n: - Change default drive (SD drive is 0~1)\n")
                 _T("dd [<lba>] - Dump sector\n")
-                //_T("ds <pd#> - Show disk status\n")
+                _T("ds - Show and clear sector cache statistics\n")
+                _T("dp - Show and clear driver probe statistics\n")
                 _T("\n")
                 _T("bd <ofs> - Dump working buffer\n")
                 _T("be <ofs> [<data>] ... - Edit working buffer\n")
@@ -845,7 +1044,13 @@ int32_t main(void)
                 _T("fo <mode> <file> - Open a file\n")
                 _T("fc - Close the file\n")
                 _T("fe <ofs> - Move fp in normal seek\n")
-                //_T("fE <ofs> - Move fp in fast seek or Create link table\n")
+                _T("fO <mode> <file> - Open a file as a stream (cluster link map attached)\n")
+                _T("fP <size> <file> - Create a recording stream pre-allocated contiguously\n")
+                _T("fC - Close the stream\n")
+                _T("fE <ofs> - Move the stream pointer in fast seek\n")
+                _T("fR <len> - Read the stream\n")
+                _T("fW <len> <val> - Write to the stream\n")
+                _T("fB <count> - Random seek benchmark on the file and the stream\n")
                 _T("fd <len> - Read and dump the file\n")
                 _T("fr <len> - Read the file\n")
                 _T("fw <len> <val> - Write to the file\n")
@@ -856,6 +1061,7 @@ int32_t main(void)
                 _T("fa <atrr> <mask> <object name> - Change object attribute\n")
                 _T("ft <year> <month> <day> <hour> <min> <sec> <object name> - Change timestamp of an object\n")
                 _T("fx <src file> <dst file> - Copy a file\n")
+                _T("fL <records> <size> <sync> <file> - Append records, f_sync every <sync> records\n")
                 _T("fg <path> - Change current directory\n")
                 _T("fj <ld#> - Change current drive. For example: <fj 4:>\n")
                 _T("fm <ld#> <rule> <cluster size> - Create file system\n")
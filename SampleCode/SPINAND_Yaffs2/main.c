@@ -8,6 +8,7 @@
  * @note
  * Copyright (C) 2019 Nuvoton Technology Corp. All rights reserved.
 *****************************************************************************/
+#include <stdlib.h>
 #include <string.h>
 
 #include "nuc980.h"
@@ -16,6 +17,9 @@
 #include "yaffs_glue.h"
 
 extern void spinand_init(void);
+extern int32_t ReadPage(int32_t nPBlockAddr, int32_t nPageNo, uint8_t *buff);
+extern int32_t WritePage(int32_t nPBlockAddr, int32_t nPageNo, uint8_t *buff);
+extern int32_t EraseBlock(int32_t page);
 unsigned char read_buf[1024];
 /*******************************************************************************/
 volatile uint32_t _timer_tick;
@@ -83,6 +87,65 @@ void FMI_Init(void)
 
 static char CommandLine[256];
 
+#define BENCH_PAGE_SIZE     2048
+#define BENCH_SPARE_SIZE    64
+#define BENCH_PAGES         64      /* pages per block */
+#define BENCH_LOOPS         8
+
+static uint8_t bench_buf[BENCH_PAGE_SIZE + BENCH_SPARE_SIZE] __attribute__((aligned(32)));
+
+static void print_rate(char *name, uint32_t bytes, uint32_t ticks)
+{
+    uint32_t kbps;
+
+    if (ticks == 0)
+        ticks = 1;
+    kbps = (bytes / 1024) * 100 / ticks;    /* get_ticks() runs at 100 Hz */
+    printf("%s: %d KB in %d ms, %d.%02d MB/s\n", name, bytes / 1024, ticks * 10, kbps / 1024, (kbps % 1024) * 100 / 1024);
+}
+
+/*----------------------------------------------*/
+/* Erase, program and read back one block       */
+/*----------------------------------------------*/
+void spinand_bench(int block)
+{
+    uint32_t t0, t_prog = 0, t_read = 0;
+    int loop, page, i, err = 0;
+
+    printf("Benchmark block %d, all data in this block will be lost!\n", block);
+
+    for (loop = 0; loop < BENCH_LOOPS; loop++) {
+        EraseBlock(block * BENCH_PAGES);
+
+        t0 = get_ticks();
+        for (page = 0; page < BENCH_PAGES; page++) {
+            for (i = 0; i < BENCH_PAGE_SIZE; i++)
+                bench_buf[i] = (uint8_t)(i + page + loop);
+            WritePage(block, page, bench_buf);
+        }
+        t_prog += get_ticks() - t0;
+
+        t0 = get_ticks();
+        for (page = 0; page < BENCH_PAGES; page++)
+            ReadPage(block, page, bench_buf);
+        t_read += get_ticks() - t0;
+
+        /* Verify the last page only, to keep the compare out of the timed loop */
+        for (i = 0; i < BENCH_PAGE_SIZE; i++) {
+            if (bench_buf[i] != (uint8_t)(i + BENCH_PAGES - 1 + loop)) {
+                err++;
+                break;
+            }
+        }
+    }
+    EraseBlock(block * BENCH_PAGES);
+
+    print_rate("Program", BENCH_LOOPS * BENCH_PAGES * BENCH_PAGE_SIZE, t_prog);
+    print_rate("Read   ", BENCH_LOOPS * BENCH_PAGES * BENCH_PAGE_SIZE, t_read);
+    if (err)
+        printf("Verify failed in %d loops!\n", err);
+}
+
 /*----------------------------------------------*/
 /* Get a line from the input                    */
 /*----------------------------------------------*/
@@ -196,6 +259,14 @@ int main(void)
                 printf("\n");
             }
             break;
+        case 'b' :  /* bench */
+            if (*ptr == 'e') {
+                while ((*ptr != ' ') && (*ptr != 0)) ptr++;
+                while (*ptr == ' ') ptr++;
+                spinand_bench(atoi(ptr));
+            }
+            break;
+
         case '?':       /* Show usage */
             printf("ls    <path>     - Show a directory. ex: ls user/test ('user' is mount point).\n");
             printf("rd    <file name> - Read a file. ex: rd user/test.bin ('user' is mount point).\n");
@@ -203,6 +274,7 @@ int main(void)
             printf("rm    <file name> - Delete a file. ex: rm user/test.bin ('user' is mount point).\n");
             printf("mkdir <dir name> - Create a directory. ex: mkdir user/test ('user' is mount point).\n");
             printf("rmdir <dir name> - Create a directory. ex: mkdir user/test ('user' is mount point).\n");
+            printf("bench <block>    - Erase/program/read speed test. ex: bench 1000 (destroys that block).\n");
             printf("\n");
         }
     }
@@ -16,7 +16,9 @@
 #include <linux/mtd/concat.h>
 #include "yaffs_malloc.h"
 #include "nuc980.h"
+#include "sys.h"
 #include "qspi.h"
+#include "pdma.h"
 #include "gpio.h"
 #include "nand.h"
 
@@ -61,6 +63,29 @@ void spinand_init(void);
 
 #define DIRTY_FUNCTION
 
+/* SPI NAND command set used by the quad data path */
+#define SPINAND_CMD_READ_QUAD_OUT   0x6B    /* Fast Read Quad Output: 1-1-4 */
+#define SPINAND_CMD_READ_QUAD_IO    0xEB    /* Fast Read Quad I/O: 1-4-4 */
+#define SPINAND_CMD_PROG_LOAD_QUAD  0x32    /* Quad Program Data Load: 1-1-4 */
+
+/* Select the cache read command, SPINAND_CMD_READ_QUAD_OUT or SPINAND_CMD_READ_QUAD_IO */
+#ifndef SPINAND_READ_CMD
+#define SPINAND_READ_CMD            SPINAND_CMD_READ_QUAD_IO
+#endif
+
+#define SPINAND_PDMA_MIN_LEN        32      /* Shorter data phases are cheaper by PIO */
+
+#define SPINAND_POLL_DELAY_MIN      16      /* Busy poll back-off, in delay loop counts */
+#define SPINAND_POLL_DELAY_MAX      1024
+#define SPINAND_POLL_TIMEOUT        0x400000 /* Total back-off in delay loop counts, > tBERS max */
+
+/* Clocked out by the TX channel while the data phase is an input */
+static uint32_t s_u32DummyTx = 0;
+
+/* PDMA service channels of the quad data phases, -1 runs them by PIO */
+static int32_t s_i32PdmaTx = -1;
+static int32_t s_i32PdmaRx = -1;
+
 static void SPI_CS_LOW(void)
 {
     // /CS: active
@@ -80,25 +105,135 @@ static uint8_t SPIin(uint8_t DI)
     return (QSPI_READ_RX(QSPI0) & 0xff);
 }
 
-static void SPINAND_ReadyBusyCheck(void)
+/* Push a short command sequence through the TX FIFO and drop the returned bytes */
+static void SPIout(const uint8_t *cmd, uint32_t len)
 {
-    uint8_t SR = 0xFF;
-    while((SR & 0x1) != 0x00) {
+    uint32_t i;
+
+    for(i = 0; i < len; i++) {
+        while(QSPI_GET_TX_FIFO_FULL_FLAG(QSPI0));
+        QSPI_WRITE_TX(QSPI0, cmd[i]);
+    }
+    while(QSPI_IS_BUSY(QSPI0));
+    QSPI_ClearRxFIFO(QSPI0);
+}
+
+static void SPINAND_QuadPinEnable(void)
+{
+    /* PD6/PD7 from /WP,/HOLD GPIO to QSPI0_MOSI1/QSPI0_MISO1 */
+    outpw(REG_SYS_GPD_MFPL, (inpw(REG_SYS_GPD_MFPL) & ~0xFF000000) | 0x11000000);
+}
+
+static void SPINAND_QuadPinDisable(void)
+{
+    QSPI_DISABLE_QUAD_MODE(QSPI0);
+    outpw(REG_SYS_GPD_MFPL, (inpw(REG_SYS_GPD_MFPL) & ~0xFF000000));
+}
+
+static void SPINAND_SetWordMode(int32_t enable)
+{
+    QSPI_DISABLE(QSPI0);
+    while (QSPI0->STATUS & QSPI_STATUS_QSPIENSTS_Msk) {}
+
+    if (enable) {
+        QSPI_SET_DATA_WIDTH(QSPI0, 32);
+        QSPI_ENABLE_BYTE_REORDER(QSPI0);
+    } else {
+        QSPI_DISABLE_BYTE_REORDER(QSPI0);
+        QSPI_SET_DATA_WIDTH(QSPI0, 8);
+    }
+
+    QSPI0->FIFOCTL |= (QSPI_FIFOCTL_RXRST_Msk | QSPI_FIFOCTL_TXRST_Msk);
+    while (QSPI0->STATUS & QSPI_STATUS_TXRXRST_Msk) {}
+
+    QSPI_ENABLE(QSPI0);
+    while (!(QSPI0->STATUS & QSPI_STATUS_QSPIENSTS_Msk)) {}
+}
+
+/*
+ * Move the word-aligned part of a data phase with PDMA, 32 bits per FIFO entry.
+ * buff must be word aligned; returns the number of bytes transferred.
+ * In read direction the TX channel feeds dummy words to generate the bus clock.
+ * QSPI only supports the PDMA single request type. The PDMA service keeps the
+ * D-cache coherent for the buffer.
+ */
+static uint32_t SPINAND_PdmaTransfer(uint8_t *buff, uint32_t len, int32_t is_read)
+{
+    PDMA_SG_T tx, rx;
+    uint32_t count = len >> 2;
+
+    if ((s_i32PdmaTx < 0) || (count == 0) || ((uint32_t)buff & 3) || (len < SPINAND_PDMA_MIN_LEN))
+        return 0;
+
+    tx.u32Dst = (uint32_t)&QSPI0->TX;
+    tx.u32Len = count << 2;
+
+    SPINAND_SetWordMode(1);
+
+    if (is_read) {
+        rx.u32Src = (uint32_t)&QSPI0->RX;
+        rx.u32Dst = (uint32_t)buff;
+        rx.u32Len = count << 2;
+        tx.u32Src = (uint32_t)&s_u32DummyTx;
+        if (PDMA_SubmitSG(s_i32PdmaRx, PDMA_WIDTH_32 | PDMA_REQ_SINGLE | PDMA_SAR_FIX | PDMA_DAR_INC, &rx, 1) != PDMA_OK) {
+            SPINAND_SetWordMode(0);
+            return 0;
+        }
+        PDMA_SubmitSG(s_i32PdmaTx, PDMA_WIDTH_32 | PDMA_REQ_SINGLE | PDMA_SAR_FIX | PDMA_DAR_FIX, &tx, 1);
+        QSPI0->PDMACTL |= (QSPI_PDMACTL_RXPDMAEN_Msk | QSPI_PDMACTL_TXPDMAEN_Msk);
+    } else {
+        tx.u32Src = (uint32_t)buff;
+        PDMA_SubmitSG(s_i32PdmaTx, PDMA_WIDTH_32 | PDMA_REQ_SINGLE | PDMA_SAR_INC | PDMA_DAR_FIX, &tx, 1);
+        QSPI_TRIGGER_TX_PDMA(QSPI0);
+    }
+
+    /* Completion comes from the PDMA interrupt */
+    while (PDMA_IsChannelBusy(s_i32PdmaTx) || PDMA_IsChannelBusy(s_i32PdmaRx)) {}
+
+    /* The last word is still shifting out after its PDMA request completed */
+    while(QSPI_IS_BUSY(QSPI0));
+    QSPI0->PDMACTL = 0;
+    SPINAND_SetWordMode(0);
+
+    return (count << 2);
+}
+
+static int32_t SPINAND_ReadyBusyCheck(void)
+{
+    uint32_t delay = SPINAND_POLL_DELAY_MIN;
+    uint32_t spent = 0;
+    uint32_t volatile i;
+    uint8_t SR;
+
+    /*
+     * Back off between Get Feature polls so that long program/erase
+     * cycles do not keep the bus saturated with status reads.
+     */
+    for (;;) {
         SPI_CS_LOW();
         SPIin(0x0F);
         SPIin(0xC0);
         SR = SPIin(0x00);
         SPI_CS_HIGH();
+        if ((SR & 0x1) == 0x00)
+            return 0;
+
+        if (spent > SPINAND_POLL_TIMEOUT)
+            return -1;
+
+        for (i = 0; i < delay; i++);
+        spent += delay;
+        if (delay < SPINAND_POLL_DELAY_MAX)
+            delay <<= 1;
     }
-    return;
 }
 
-static void SPINAND_Reset(void)
+static int32_t SPINAND_Reset(void)
 {
     SPI_CS_LOW();
     SPIin(0xFF);
     SPI_CS_HIGH();
-    SPINAND_ReadyBusyCheck();
+    return SPINAND_ReadyBusyCheck();
 }
 
 static uint32_t SPINAND_ReadID(void)
@@ -116,83 +251,46 @@ static uint32_t SPINAND_ReadID(void)
     return JEDECID;
 }
 
-static void SPINAND_PageDataRead(uint8_t PA_H, uint8_t PA_L)
+static int32_t SPINAND_PageDataRead(uint8_t PA_H, uint8_t PA_L)
 {
+    uint8_t cmd[4] = { 0x13, 0x00, PA_H, PA_L };    // command, dummy, page address
+
     SPI_CS_LOW();
-    SPIin(0x13); //
-    SPIin(0x00); // dummy
-    SPIin(PA_H); // Page address
-    SPIin(PA_L); // Page address
+    SPIout(cmd, sizeof(cmd));
     SPI_CS_HIGH();
-    SPINAND_ReadyBusyCheck(); // Need to wait for the data transfer.
-    return;
+    return SPINAND_ReadyBusyCheck(); // Need to wait for the data transfer.
 }
 
-#define PDMA_BA         0xB0008000
-#define REG_PDMA_DSCT0_CTL      (PDMA_BA+0x000)
-#define REG_PDMA_DSCT0_SA       (PDMA_BA+0x004)
-#define REG_PDMA_DSCT0_DA       (PDMA_BA+0x008)
-#define REG_PDMA_CHCTL          (PDMA_BA+0x400)
-#define REG_PDMA_TDSTS          (PDMA_BA+0x424)
-#define REG_PDMA_REQSEL0_3      (PDMA_BA+0x480)
-#define TXCNT_Pos               (16)
-#define TXWIDTH_32              (0x2000)
-#define SRC_FIXED               (0x300)
-#define TBINTDIS                (0x80)
-#define TX_SINGLE               (0x4)
-#define MODE_BASIC              (0x1)
-
 static void SPINAND_NormalRead(uint8_t addh, uint8_t addl, uint8_t* buff, uint32_t len)
 {
-    uint32_t i = 0;
+    uint32_t i;
+
     SPI_CS_LOW();
-    SPIin(0x03);
-    SPIin(addh);
-    SPIin(addl);
-    SPIin(0x00); // dummy
-    if (len > 100) {
-        uint32_t count;
-        QSPI0->CTL &= ~1; //Disable SPIEN
-        while (QSPI0->STATUS & 0x8000) {} //SPIENSTS
-
-        QSPI0->CTL &= ~0x1F00; //Data Width = 32 bit
-        QSPI0->CTL &= ~0xF0; //Suspend interval = 0
-        QSPI0->CTL |= 0x80000; //Byte reorder
-
-        QSPI0->FIFOCTL |= 3; //TX/RX reset
-        while (QSPI0->STATUS & 0x800000);
-
-        QSPI0->CTL |= 0x1; //Enable SPIEN
-        while (!(QSPI0->STATUS & 0x8000)) {} //SPIENSTS
-
-        outpw(REG_CLK_HCLKEN, (inpw(REG_CLK_HCLKEN) | 0x1000)); /* enable PDMA0 clock */
-        /* initial PDMA channel 0 */
-
-        outpw(REG_PDMA_CHCTL, 0x1);
-        outpw(REG_PDMA_REQSEL0_3,21);  /* QSPI0 RX */
-
-        count = (len + 3) >> 2;
-        /* set PDMA */
-        outpw(REG_PDMA_DSCT0_SA, REG_QSPI0_RX);
-        outpw(REG_PDMA_DSCT0_DA, (unsigned int) buff);
-        outpw(REG_PDMA_DSCT0_CTL, ((count-1)<<TXCNT_Pos)|TXWIDTH_32|SRC_FIXED|TBINTDIS|TX_SINGLE|MODE_BASIC);
-        QSPI0->PDMACTL |= 0x2;
-        while(1) {
-            if (inpw(REG_PDMA_TDSTS) & 0x1) {
-                outpw(REG_PDMA_TDSTS, 0x1);
-                break;
-            }
-        }
-        QSPI0->CTL &= ~(0x80000); //Disable Byte reorder
-        QSPI0->CTL = (QSPI0->CTL & ~0x1F00)| (0x800); //Data length 8 bit
-        QSPI0->PDMACTL = 0; // disable RX
-        outpw(REG_CLK_HCLKEN, (inpw(REG_CLK_HCLKEN) & ~0x1000)); /* disable PDMA0 clock */
-    } else {
-        for( i = 0; i < len; i++) {
-            *(buff+i) = SPIin(0x00);
-        }
+    SPINAND_QuadPinEnable();
+#if (SPINAND_READ_CMD == SPINAND_CMD_READ_QUAD_IO)
+    {
+        uint8_t addr[4] = { addh, addl, 0x00, 0x00 };   // column address, 4 dummy clocks
+
+        SPIin(SPINAND_CMD_READ_QUAD_IO);
+        QSPI_ENABLE_QUAD_OUTPUT_MODE(QSPI0);
+        SPIout(addr, sizeof(addr));
     }
+#else
+    {
+        uint8_t cmd[4] = { SPINAND_CMD_READ_QUAD_OUT, addh, addl, 0x00 };  // column address, dummy
+
+        SPIout(cmd, sizeof(cmd));
+    }
+#endif
+    QSPI_ENABLE_QUAD_INPUT_MODE(QSPI0);
+
+    i = SPINAND_PdmaTransfer(buff, len, 1);
+    for( ; i < len; i++) {
+        *(buff+i) = SPIin(0x00);
+    }
+
     SPI_CS_HIGH();
+    SPINAND_QuadPinDisable();
     return;
 }
 
@@ -228,26 +326,24 @@ static uint8_t SPINAND_ReadStatusRegister(uint8_t sr_sel)
     return SR;
 }
 
-static void SPINAND_WriteStatusRegister1(uint8_t SR1)
+static int32_t SPINAND_WriteStatusRegister1(uint8_t SR1)
 {
     SPI_CS_LOW();
     SPIin(0x1F);
     SPIin(0xA0);
     SPIin(SR1);
     SPI_CS_HIGH();
-    SPINAND_ReadyBusyCheck();
-    return;
+    return SPINAND_ReadyBusyCheck();
 }
 
-static void SPINAND_WriteStatusRegister2(uint8_t SR2)
+static int32_t SPINAND_WriteStatusRegister2(uint8_t SR2)
 {
     SPI_CS_LOW();
     SPIin(0x1F);
     SPIin(0xB0);
     SPIin(SR2);
     SPI_CS_HIGH();
-    SPINAND_ReadyBusyCheck();
-    return;
+    return SPINAND_ReadyBusyCheck();
 }
 
 static uint8_t SPINAND_CheckEmbeddedECCFlag(void)
@@ -262,8 +358,7 @@ int32_t EnableHWECC(void)
     uint8_t SR;
     SR = SPINAND_ReadStatusRegister(2); 	// Read status register 2
     SR |= 0x10;										// Enable ECC-E bit
-    SPINAND_WriteStatusRegister2(SR);
-    return 0;
+    return SPINAND_WriteStatusRegister2(SR);
 }
 
 int32_t DisableHWECC(void)
@@ -271,17 +366,15 @@ int32_t DisableHWECC(void)
     uint8_t SR;
     SR = SPINAND_ReadStatusRegister(2); 	// Read status register 2
     SR &= 0xEF;									// Disable ECC-E bit
-    SPINAND_WriteStatusRegister2(SR);
-    return 0;
+    return SPINAND_WriteStatusRegister2(SR);
 }
 
-static void SPINAND_Unprotect(void)
+static int32_t SPINAND_Unprotect(void)
 {
     uint8_t SR;
-    SR = SPINAND_ReadStatusRegister(1); 	// Read status register 2
-    SR &= 0x83;										// Enable ECC-E bit
-    SPINAND_WriteStatusRegister1(SR);
-    return;
+    SR = SPINAND_ReadStatusRegister(1); 	// Read status register 1
+    SR &= 0x81;										// Clear BP[3:0], TB and WP-E; /WP and /HOLD become IO2/IO3
+    return SPINAND_WriteStatusRegister1(SR);
 }
 
 int32_t ReadPage(int32_t nPBlockAddr, int32_t nPageNo, uint8_t *buff)
@@ -291,7 +384,8 @@ int32_t ReadPage(int32_t nPBlockAddr, int32_t nPageNo, uint8_t *buff)
 
     //printf("ReadPage : nPBlockAddr = %d, nPageNo = %d\n",nPBlockAddr, nPageNo);
 
-    SPINAND_PageDataRead(page/0x100, page%0x100);		// Read verify
+    if (SPINAND_PageDataRead(page/0x100, page%0x100) != 0)		// Read verify
+        return Read_error;
     SPINAND_NormalRead(0, 0, buff, Page_size);
     EPR_status = SPINAND_CheckEmbeddedECCFlag();
     if((EPR_status != 0x00) && (EPR_status != 0x01)) {
@@ -305,25 +399,33 @@ int32_t ReadPage(int32_t nPBlockAddr, int32_t nPageNo, uint8_t *buff)
 
 static void SPINAND_LoadPageProgramData(uint8_t addh, uint8_t addl, uint8_t* program_buffer, uint32_t count)
 {
-    uint32_t i = 0;
+    uint32_t i;
+    uint8_t cmd[3] = { SPINAND_CMD_PROG_LOAD_QUAD, addh, addl };
 
     SPI_CS_LOW();
     SPIin(0x06);
     SPI_CS_HIGH();
 
     SPI_CS_LOW();
-    SPIin(0x02);
-    SPIin(addh);
-    SPIin(addl);
-    for(i = 0; i < count; i++) {
-        SPIin(*(program_buffer+i));
+    SPIout(cmd, sizeof(cmd));
+    SPINAND_QuadPinEnable();
+    QSPI_ENABLE_QUAD_OUTPUT_MODE(QSPI0);
+
+    i = SPINAND_PdmaTransfer(program_buffer, count, 0);
+    for( ; i < count; i++) {
+        while(QSPI_GET_TX_FIFO_FULL_FLAG(QSPI0));
+        QSPI_WRITE_TX(QSPI0, *(program_buffer+i));
     }
+    while(QSPI_IS_BUSY(QSPI0));
+    QSPI_ClearRxFIFO(QSPI0);
+
     SPI_CS_HIGH();
+    SPINAND_QuadPinDisable();
 
     return;
 }
 
-static void SPINAND_ProgramExcute(uint8_t addh, uint8_t addl)
+static int32_t SPINAND_ProgramExcute(uint8_t addh, uint8_t addl)
 {
 
     SPI_CS_LOW();
@@ -332,9 +434,7 @@ static void SPINAND_ProgramExcute(uint8_t addh, uint8_t addl)
     SPIin(addh);
     SPIin(addl);
     SPI_CS_HIGH();
-    SPINAND_ReadyBusyCheck();
-
-    return;
+    return SPINAND_ReadyBusyCheck();
 }
 
 static uint8_t SPINAND_CheckProgramEraseFailFlag(void)
@@ -359,7 +459,8 @@ int32_t WritePage(int32_t nPBlockAddr, int32_t nPageNo, uint8_t *buff)
 #else
     SPINAND_LoadPageProgramData(0, 0, buff, Page_size);
 #endif
-    SPINAND_ProgramExcute(page/0x100, page%0x100);
+    if (SPINAND_ProgramExcute(page/0x100, page%0x100) != 0)
+        return -1; // Busy timeout
     if(SPINAND_CheckProgramEraseFailFlag() != 0)
         return -1; // Program failed
 
@@ -370,13 +471,15 @@ static uint8_t SPINAND_CheckBadBlock(uint32_t page_address)
 {
     uint8_t read_buf;
 
-    SPINAND_PageDataRead(page_address/0x100, page_address%0x100);   // Read the first page of a block
+    if (SPINAND_PageDataRead(page_address/0x100, page_address%0x100) != 0)   // Read the first page of a block
+        return 1;
 
     SPINAND_NormalRead(0x8, 0x0, &read_buf, 1);		// Read bad block mark at 0x800
     if(read_buf != 0xFF) {
         return 1;
     }
-    SPINAND_PageDataRead((page_address+1)/0x100, (page_address+1)%0x100);   // Read the second page of a block
+    if (SPINAND_PageDataRead((page_address+1)/0x100, (page_address+1)%0x100) != 0)   // Read the second page of a block
+        return 1;
 
     SPINAND_NormalRead(0x8, 0x0, &read_buf, 1);	// Read bad block mark at 0x800
     if(read_buf != 0xFF) {
@@ -391,7 +494,8 @@ int32_t MarkBadBlock(int32_t page)
 
     /* Write a non 0xFF value to the first byte of spare area of page 0 */
     SPINAND_LoadPageProgramData(0x8, 0, &bad_marker, 1);
-    SPINAND_ProgramExcute(page/0x100, page%0x100);
+    if (SPINAND_ProgramExcute(page/0x100, page%0x100) != 0)
+        return -1; // Busy timeout
     if(SPINAND_CheckProgramEraseFailFlag() != 0)
         return -1; // Program failed
 
@@ -406,7 +510,8 @@ int32_t IsDirtyPage(int32_t page)
 
     //printf("IsDirtyPage:\n");
 
-    SPINAND_PageDataRead(page/0x100, page%0x100);		// Read verify
+    if (SPINAND_PageDataRead(page/0x100, page%0x100) != 0)		// Read verify
+        return TRUE;
     SPINAND_NormalRead(8, 4, (uint8_t *)&c0, 1);
     //printf("c0 [%x)]\n",c0);
     if (c0 != 0xFF)
@@ -440,7 +545,7 @@ int32_t IsValidBlock(int32_t page)
     return TRUE;
 }
 
-static void SPINAND_BlockErase(uint8_t PA_H, uint8_t PA_L)
+static int32_t SPINAND_BlockErase(uint8_t PA_H, uint8_t PA_L)
 {
 
     SPI_CS_LOW();
@@ -454,7 +559,7 @@ static void SPINAND_BlockErase(uint8_t PA_H, uint8_t PA_L)
     SPIin(PA_L);
     SPI_CS_HIGH();
 
-    SPINAND_ReadyBusyCheck();
+    return SPINAND_ReadyBusyCheck();
 }
 
 int32_t EraseBlock(int32_t page)
@@ -466,7 +571,8 @@ int32_t EraseBlock(int32_t page)
 
     PA_H = (page >> 8) & 0xff;
     PA_L = page & 0xff;
-    SPINAND_BlockErase(PA_H, PA_L);
+    if (SPINAND_BlockErase(PA_H, PA_L) != 0)
+        return -1; // Busy timeout
 
     if ((status = SPINAND_CheckProgramEraseFailFlag()) != 0) {
         printf("erase status: %02x\n", status);
@@ -584,9 +690,22 @@ int board_spinand_init(struct nand_chip *spinand)
     QSPI0->CTL = 0x805;
     while (!(QSPI0->STATUS & (1<<15))) {}
 
-    SPINAND_Reset();
+    /* PDMA channels for the quad data phases, shared with other drivers through the PDMA service */
+    if (s_i32PdmaTx < 0) {
+        s_i32PdmaTx = PDMA_RequestChannel(PDMA_QSPI0_TX, NULL, NULL);
+        s_i32PdmaRx = PDMA_RequestChannel(PDMA_QSPI0_RX, NULL, NULL);
+        if ((s_i32PdmaTx < 0) || (s_i32PdmaRx < 0)) {
+            PDMA_FreeChannel(s_i32PdmaTx);
+            PDMA_FreeChannel(s_i32PdmaRx);
+            s_i32PdmaTx = s_i32PdmaRx = -1;
+        }
+    }
+
+    if (SPINAND_Reset() != 0)
+        return -1;
     printf("ID = 0x%x\n",SPINAND_ReadID());
-    SPINAND_Unprotect();
+    if (SPINAND_Unprotect() != 0)
+        return -1;
     /* Detect SPI NAND chips */
     /* first scan to find the device and get the page size */
 //    if (nand_scan_ident(mtd, 1, NULL)) {
@@ -624,7 +743,8 @@ static int spinand_erase(struct mtd_info *mtd, struct erase_info *instr)
         blockcnt++;
     for (i=0; i<blockcnt; i++) {
         page = off/mtd->writesize;
-        EraseBlock(page);
+        if (EraseBlock(page) != 0)
+            return -EIO;
         off += mtd->erasesize;
     }
 
@@ -644,7 +764,8 @@ static int spinand_read(struct mtd_info *mtd, loff_t from, size_t len,
     page = from/mtd->writesize;
     for (i=0; i<pagecnt; i++) {
         //printf("page %d\n",page);
-        ReadPage(0, page, buf);
+        if (ReadPage(0, page, buf) != 0)
+            return -EIO;
         buf += mtd->writesize;
         page++;
     }
@@ -660,7 +781,8 @@ static int spinand_read_oob(struct mtd_info *mtd, loff_t from,
     //printf("[spinand_read_oob] databuf 0x%x, oobbuf 0x%x, ooboffs 0x%x, ooblen 0x%x\n",(unsigned int)ops->datbuf,(unsigned int)ops->oobbuf,ops->ooboffs,ops->ooblen);
 
     page = from/mtd->writesize;
-    ReadPage(0, page, ops->datbuf);
+    if (ReadPage(0, page, ops->datbuf) != 0)
+        return -EIO;
 
     return 0;
 }
@@ -674,7 +796,8 @@ static int spinand_write_oob(struct mtd_info *mtd, loff_t to,
     //printf("[spinand_write_oob] databuf 0x%x, oobbuf 0x%x, ooboffs 0x%x, ooblen 0x%x\n",(unsigned int)ops->datbuf,(unsigned int)ops->oobbuf,ops->ooboffs,ops->ooblen);
 
     page = to/mtd->writesize;
-    WritePage(0, page, (uint8_t*)ops->datbuf);
+    if (WritePage(0, page, (uint8_t*)ops->datbuf) != 0)
+        return -EIO;
 
     return 0;
 }
@@ -691,7 +814,8 @@ static int spinand_write(struct mtd_info *mtd, loff_t to, size_t len,
         blockcnt++;
     for (i=0; i<blockcnt; i++) {
         page = to/mtd->writesize;
-        EraseBlock(page);
+        if (EraseBlock(page) != 0)
+            return -EIO;
         to += mtd->erasesize;
     }
 
@@ -699,7 +823,8 @@ static int spinand_write(struct mtd_info *mtd, loff_t to, size_t len,
     if (len%mtd->writesize)
         pagecnt++;
     for (i=0; i<pagecnt; i++) {
-        WritePage(0, page, (uint8_t*)buf);
+        if (WritePage(0, page, (uint8_t*)buf) != 0)
+            return -EIO;
         buf += mtd->writesize;
         page++;
     }
@@ -726,7 +851,8 @@ static int spinand_block_markbad(struct mtd_info *mtd, loff_t ofs)
 {
     //printf("spinand_block_markbad offset 0x%x\n",(unsigned int)ofs);
 
-    MarkBadBlock(ofs/mtd->writesize);
+    if (MarkBadBlock(ofs/mtd->writesize) != 0)
+        return -EIO;
 
     return 0;
 }
@@ -0,0 +1,212 @@
+/**************************************************************************//**
+* @file     main.c
+* @brief    Check the memops.c copy, fill and checksum kernels against byte
+*           references for every alignment, then compare their speed with
+*           the C library and the lwIP checksum.
+*
+* @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+
+#define CHECK_LEN       300         /* Every length up to this one is checked */
+#define BUF_SIZE        (8 * 1024)
+#define GUARD           0x5A
+#define LOOPS           64
+
+#if defined (__GNUC__) && !(__CC_ARM)
+static __attribute__((aligned(32))) UINT8 src[BUF_SIZE + 64];
+static __attribute__((aligned(32))) UINT8 dst[BUF_SIZE + 64];
+#else
+static __align(32) UINT8 src[BUF_SIZE + 64];
+static __align(32) UINT8 dst[BUF_SIZE + 64];
+#endif
+
+static UINT32 cpu_mhz;
+
+/* lwip_standard_chksum(), algorithm 2 of lwIP's inet_chksum.c */
+static UINT16 ref_chksum(const void *dataptr, INT32 len)
+{
+    const UINT8 *pb = (const UINT8 *)dataptr;
+    const UINT16 *ps;
+    UINT16 t = 0;
+    UINT32 sum = 0;
+    INT32 odd = ((UINT32)pb & 1);
+
+    if (odd && len > 0)
+    {
+        ((UINT8 *)&t)[1] = *pb++;
+        len--;
+    }
+    ps = (const UINT16 *)pb;
+    while (len > 1)
+    {
+        sum += *ps++;
+        len -= 2;
+    }
+    if (len > 0)
+        ((UINT8 *)&t)[0] = *(const UINT8 *)ps;
+    sum += t;
+    sum = (sum >> 16) + (sum & 0xFFFF);
+    sum = (sum >> 16) + (sum & 0xFFFF);
+    if (odd)
+        sum = ((sum & 0xFF) << 8) | ((sum & 0xFF00) >> 8);
+    return (UINT16)sum;
+}
+
+/* The bytes around dst[off, off + len) must still hold the guard value */
+static INT32 guard_ok(UINT32 off, UINT32 len)
+{
+    return (off == 0 || dst[off - 1] == GUARD) && (dst[off + len] == GUARD);
+}
+
+static void fill_src(UINT32 seed, UINT32 all_ones)
+{
+    UINT32 i;
+
+    for (i = 0; i < sizeof(src); i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        src[i] = all_ones ? 0xFF : (UINT8)(seed >> 16);
+    }
+}
+
+static UINT32 check(void)
+{
+    UINT32 sa, da, len, pass, i, fail = 0;
+    UINT16 sum;
+
+    /* Random data, then all ones to exercise every carry */
+    for (pass = 0; pass < 2; pass++)
+    {
+        fill_src(pass + 1, pass);
+        for (sa = 0; sa < 4; sa++)
+        {
+            for (len = 0; len <= CHECK_LEN; len++)
+            {
+                if (sysChksum(&src[sa], len) != ref_chksum(&src[sa], len))
+                {
+                    printf("sysChksum      src+%d len %d FAILED\n", sa, len);
+                    fail++;
+                }
+                for (da = 0; da < 4; da++)
+                {
+                    memset(dst, GUARD, len + 8);
+                    sysMemCopy(&dst[da], &src[sa], len);
+                    if (memcmp(&dst[da], &src[sa], len) || !guard_ok(da, len))
+                    {
+                        printf("sysMemCopy     src+%d dst+%d len %d FAILED\n", sa, da, len);
+                        fail++;
+                    }
+
+                    memset(dst, GUARD, len + 8);
+                    sum = sysChksumCopy(&dst[da], &src[sa], (UINT16)len);
+                    if ((sum != ref_chksum(&src[sa], len)) || memcmp(&dst[da], &src[sa], len) || !guard_ok(da, len))
+                    {
+                        printf("sysChksumCopy  src+%d dst+%d len %d FAILED\n", sa, da, len);
+                        fail++;
+                    }
+
+                    if (sa == 0)
+                    {
+                        memset(dst, GUARD, len + 8);
+                        sysMemSet(&dst[da], 0x1A7, len);
+                        for (i = 0; (i < len) && (dst[da + i] == 0xA7); i++);
+                        if ((i != len) || !guard_ok(da, len))
+                        {
+                            printf("sysMemSet      dst+%d len %d FAILED\n", da, len);
+                            fail++;
+                        }
+                    }
+                }
+            }
+        }
+        if (sysChksum(src, BUF_SIZE) != ref_chksum(src, BUF_SIZE))
+        {
+            printf("sysChksum      len %d FAILED\n", BUF_SIZE);
+            fail++;
+        }
+    }
+    return fail;
+}
+
+/* CPU cycles of one call, ETIMER0 counts the 12 MHz crystal */
+#define MEASURE(result, call)                                   \
+    do {                                                        \
+        UINT32 _i, _t0, _ticks = 0;                             \
+        for (_i = 0; _i < LOOPS; _i++)                          \
+        {                                                       \
+            _t0 = ETIMER_GetCounter(0);                         \
+            call;                                               \
+            _ticks += (ETIMER_GetCounter(0) - _t0) & 0xFFFFFF;  \
+        }                                                       \
+        (result) = _ticks * cpu_mhz / 12 / LOOPS;               \
+    } while (0)
+
+static void bench(const char *name, UINT32 sa, UINT32 da, UINT32 len)
+{
+    UINT32 t_lib, t_ops, t_ref, t_sum;
+
+    MEASURE(t_lib, memcpy(&dst[da], &src[sa], len));
+    MEASURE(t_ops, sysMemCopy(&dst[da], &src[sa], len));
+    MEASURE(t_ref, ref_chksum(&src[sa], len));
+    MEASURE(t_sum, sysChksum(&src[sa], len));
+    printf("%-14s %5d %2d %2d %8d %10d %8d %10d\n", name, len, sa, da, t_lib, t_ops, t_ref, t_sum);
+}
+
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);   // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+int main(void)
+{
+    UINT32 t_lib, t_ops;
+
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+    UART_Init();
+
+    // Enable ETIMER0 engine clock
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 8));
+
+    // Free running counter at full 12 MHz resolution
+    ETIMER_Open(0, ETIMER_CONTINUOUS_MODE, 1000000);
+    ETIMER_SET_PRESCALE_VALUE(0, 0);
+    ETIMER_SET_CMP_VALUE(0, 0xFFFFFF);
+    ETIMER_Start(0);
+
+    cpu_mhz = sysGetClock(SYS_CPU);
+
+    printf("\nChecking copy, fill and checksum for every alignment up to %d bytes\n", CHECK_LEN);
+    printf("%s\n", check() ? "Check FAILED" : "Check OK");
+
+    fill_src(1, 0);
+    printf("\nCPU cycles per call (CPU %d MHz, average of %d)\n", cpu_mhz, LOOPS);
+    printf("%-14s %5s %2s %2s %8s %10s %8s %10s\n", "", "bytes", "sa", "da", "memcpy", "sysMemCopy", "lwIP sum", "sysChksum");
+    bench("TCP header", 0, 0, 20);
+    bench("frame, aligned", 0, 0, 1514);
+    bench("frame, +2", 2, 0, 1514);         /* IP header behind the 14-byte Ethernet header */
+    bench("frame, +1", 1, 0, 1514);
+    bench("sector", 0, 0, 512);
+    bench("sector, +1", 1, 3, 512);
+    bench("block", 0, 0, BUF_SIZE);
+
+    MEASURE(t_lib, memset(dst, 0, BUF_SIZE));
+    MEASURE(t_ops, sysMemSet(dst, 0, BUF_SIZE));
+    printf("\nFill %d bytes: memset %d, sysMemSet %d\n", BUF_SIZE, t_lib, t_ops);
+
+    while(1);
+}
@@ -0,0 +1,133 @@
+/**************************************************************************//**
+* @file     main.c
+* @brief    Check the statistics and log2 histogram of the profiling probes
+*           against known durations, then time copies with SYS_PROF_BEGIN()
+*           and SYS_PROF_END() and print them with sysProfDump().
+*
+* @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "nuc980.h"
+#include "sys.h"
+
+#ifndef SYS_PROF_ENABLE
+#error "The project must define SYS_PROF_ENABLE"
+#endif
+
+#define CHECK_MAX       1000        /* Durations 0..CHECK_MAX ticks are recorded once each */
+#define BUF_SIZE        (16 * 1024)
+#define LOOPS           200
+
+#if defined (__GNUC__) && !(__CC_ARM)
+static __attribute__((aligned(32))) UINT8 src[BUF_SIZE];
+static __attribute__((aligned(32))) UINT8 dst[BUF_SIZE];
+#else
+static __align(32) UINT8 src[BUF_SIZE];
+static __align(32) UINT8 dst[BUF_SIZE];
+#endif
+
+SYS_PROF_DEFINE(s_sCheck, "check")
+SYS_PROF_DEFINE(s_sMemcpy, "memcpy 16K")
+SYS_PROF_DEFINE(s_sMemCopy, "sysMemCopy 16K")
+SYS_PROF_DEFINE(s_sSmall, "memcpy 64")
+
+/* Bin of a duration, the slow way */
+static UINT32 ref_bin(UINT32 u32Ticks)
+{
+    UINT32 u32Bin = 0;
+
+    while (u32Ticks)
+    {
+        u32Ticks >>= 1;
+        u32Bin++;
+    }
+    return (u32Bin < SYS_PROF_BINS) ? u32Bin : (SYS_PROF_BINS - 1);
+}
+
+static UINT32 check(void)
+{
+    UINT32 au32Hist[SYS_PROF_BINS];
+    UINT32 i, fail = 0;
+
+    for (i = 0; i < 32; i++)
+    {
+        if (sysProfGetBin(1u << i) != ref_bin(1u << i) || sysProfGetBin((1u << i) - 1) != ref_bin((1u << i) - 1))
+        {
+            printf("sysProfGetBin  2^%d FAILED\n", i);
+            fail++;
+        }
+    }
+
+    memset(au32Hist, 0, sizeof(au32Hist));
+    for (i = 0; i <= CHECK_MAX; i++)
+    {
+        sysProfAdd(&s_sCheck, i);
+        au32Hist[ref_bin(i)]++;
+    }
+    if ((s_sCheck.u32Count != CHECK_MAX + 1) || (s_sCheck.u32Min != 0) || (s_sCheck.u32Max != CHECK_MAX) ||
+        (s_sCheck.u64Total != (UINT64)CHECK_MAX * (CHECK_MAX + 1) / 2) ||
+        memcmp(s_sCheck.au32Hist, au32Hist, sizeof(au32Hist)))
+    {
+        printf("sysProfAdd     statistics FAILED\n");
+        fail++;
+    }
+
+    /* A span across the 24-bit counter wrap, as SYS_PROF_END() would see it */
+    sysProfReset();
+    sysProfAdd(&s_sCheck, 0x10 - 0xFFFFF0);
+    if ((s_sCheck.u32Count != 1) || (s_sCheck.u32Min != 0x20) || (s_sCheck.au32Hist[6] != 1))
+    {
+        printf("sysProfAdd     counter wrap FAILED\n");
+        fail++;
+    }
+    sysProfReset();
+    return fail;
+}
+
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);   // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+int main(void)
+{
+    UINT32 i;
+
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+    UART_Init();
+    sysProfInit();
+
+    printf("\nChecking probe statistics and histogram bins\n");
+    printf("%s\n", check() ? "Check FAILED" : "Check OK");
+
+    printf("\nProbe tick rate %d Hz\n", sysProfGetTickRate());
+    for (i = 0; i < LOOPS; i++)
+    {
+        SYS_PROF_BEGIN(s_sMemcpy);
+        memcpy(dst, src, BUF_SIZE);
+        SYS_PROF_END(s_sMemcpy);
+
+        SYS_PROF_BEGIN(s_sMemCopy);
+        sysMemCopy(dst, src, BUF_SIZE);
+        SYS_PROF_END(s_sMemCopy);
+
+        SYS_PROF_BEGIN(s_sSmall);
+        memcpy(&dst[i], &src[i * 3], 64);
+        SYS_PROF_END(s_sSmall);
+    }
+    sysProfDump();
+
+    printf("test done...\n");
+    while(1);
+}
@@ -12,6 +12,7 @@
 /*!<Includes */
 #include <string.h>
 #include "nuc980.h"
+#include "sys.h"
 #include "usbd.h"
 #include "massstorage.h"
 
@@ -1074,6 +1075,11 @@ void MSC_ActiveDMA(uint32_t u32Addr, uint32_t u32Len)
     /* Enable BUS interrupt */
     USBD_ENABLE_BUS_INT(USBD_BUSINTEN_DMADONEIEN_Msk|USBD_BUSINTEN_RESUMEIEN_Msk|USBD_BUSINTEN_SUSPENDIEN_Msk|USBD_BUSINTEN_RSTIEN_Msk|USBD_BUSINTEN_VBUSDETIEN_Msk);
 
+    /* Bulk IN (DMA read) sends the buffer, bulk OUT fills it */
+    if (USBD->DMACTL & USBD_DMACTL_DMARD_Msk)
+        sysCleanDCacheRange(u32Addr, u32Len);
+    else
+        sysInvalidateDCacheRange(u32Addr, u32Len);
     USBD_SET_DMA_ADDR(u32Addr);
     USBD_SET_DMA_LEN(u32Len);
     g_usbd_DmaDone = 0;
@@ -149,6 +149,8 @@ int32_t main(void)
     sysFlushCache(I_D_CACHE);
     sysEnableCache(CACHE_WRITE_BACK);
     UART_Init();
+    if (sysLockFastCode() != Successful)
+        printf("sysLockFastCode failed, interrupt paths are not locked in the I-cache\n");
 
     SYS_UnlockReg();
     outpw(REG_CLK_HCLKEN, inpw(REG_CLK_HCLKEN) | (1<<18));      /* enable USB Host clock   */
@@ -15,6 +15,7 @@
 #include "usbh_lib.h"
 #include "ff.h"
 #include "diskio.h"
+#include "ffcache.h"
 
 #define SD0_DRIVE       0        /* for SD0          */
 #define SD1_DRIVE       1        /* for SD1          */
@@ -26,9 +27,44 @@
 #define USBH_DRIVE_4    7        /* USB Mass Storage */
 
 
-static BYTE  fatfs_win_buff_pool[_MAX_SS] __attribute__((aligned(32)));       /* FATFS window buffer is cacheable. Must not use it directly. */
+#define FATFS_BOUNCE_SECTORS    16      /* Sectors moved per UMAS command for cacheable buffers */
+
+static BYTE  fatfs_win_buff_pool[FATFS_BOUNCE_SECTORS * _MAX_SS] __attribute__((aligned(32)));       /* FATFS window buffer is cacheable. Must not use it directly. */
 BYTE  *fatfs_win_buff;
 
+static DRESULT umas_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count);
+static DRESULT umas_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count);
+
+static FFC_DEV  umas_dev = { umas_read, umas_write, 0, FATFS_BOUNCE_SECTORS };
+static DWORD    umas_attached;      /* Bit n set: drive n is attached to the sector cache */
+
+/* Attach the USB disk to the sector cache. Cached sectors of a previous disk are dropped. */
+static void umas_attach(BYTE pdrv)
+{
+    DWORD   nsect;
+
+    if (usbh_umas_ioctl(pdrv, GET_SECTOR_COUNT, &nsect) != UMAS_OK)
+        nsect = 0;
+    /* The non-cacheable bounce pool doubles as the cache staging buffer */
+    umas_dev.stage = (BYTE *)((unsigned int)fatfs_win_buff_pool | 0x80000000);
+    ffc_attach(pdrv, &umas_dev, nsect);
+    umas_attached |= (1 << pdrv);
+}
+
+static DRESULT umas_result(int ret)
+{
+    if (ret == UMAS_OK)
+        return RES_OK;
+
+    if (ret == UMAS_ERR_NO_DEVICE)
+        return RES_NOTRDY;
+
+    if (ret == UMAS_ERR_IO)
+        return RES_ERROR;
+
+    return (DRESULT) ret;
+}
+
 
 /*-----------------------------------------------------------------------*/
 /* Initialize a Drive                                                    */
@@ -39,6 +75,7 @@ DSTATUS disk_initialize (BYTE pdrv)       /* Physical drive number (0..) */
     usbh_pooling_hubs();
     if (usbh_umas_disk_status(pdrv) == UMAS_ERR_NO_DEVICE)
         return STA_NODISK;
+    umas_attach(pdrv);
     return RES_OK;
 }
 
@@ -57,92 +94,113 @@ DSTATUS disk_status (BYTE pdrv)       /* Physical drive number (0..) */
 
 
 /*-----------------------------------------------------------------------*/
-/* Read Sector(s)                                                        */
+/* Read Sector(s) from the USB disk                                      */
 /*-----------------------------------------------------------------------*/
-DRESULT disk_read (
+static DRESULT umas_read (
     BYTE pdrv,      /* Physical drive number (0..) */
     BYTE *buff,     /* Data buffer to store read data */
     DWORD sector,   /* Sector address (LBA) */
-    UINT count      /* Number of sectors to read (1..128) */
+    UINT count      /* Number of sectors to read */
 )
 {
     int       ret;
-    int       sec_size;
+    UINT      n;
 
     //printf("disk_read - drv:%d, sec:%d, cnt:%d, buff:0x%x\n", pdrv, sector, count, (UINT32)buff);
 
     if (!((UINT32)buff & 0x80000000))
     {
         /* Disk read buffer is not non-cacheable buffer. Use my non-cacheable to do disk read. */
-        sec_size = 512; // usbh_umas_disk_sector_size(pdrv);
-        if (count * sec_size > _MAX_SS)
-            return RES_ERROR;
-
         fatfs_win_buff = (BYTE *)((unsigned int)fatfs_win_buff_pool | 0x80000000);
-        ret = (DRESULT) usbh_umas_read(pdrv, sector, count, fatfs_win_buff);
-        memcpy(buff, fatfs_win_buff, count * sec_size);
+        ret = UMAS_OK;
+        while (count && (ret == UMAS_OK))
+        {
+            n = (count > FATFS_BOUNCE_SECTORS) ? FATFS_BOUNCE_SECTORS : count;
+            ret = usbh_umas_read(pdrv, sector, n, fatfs_win_buff);
+            sysMemCopy(buff, fatfs_win_buff, n * 512);
+            buff += n * 512;
+            sector += n;
+            count -= n;
+        }
     }
     else
     {
         ret = usbh_umas_read(pdrv, sector, count, buff);
     }
-
-    if (ret == UMAS_OK)
-        return RES_OK;
-
-    if (ret == UMAS_ERR_NO_DEVICE)
-        return RES_NOTRDY;
-
-    if (ret == UMAS_ERR_IO)
-        return RES_ERROR;
-
-    return (DRESULT) ret;
+    return umas_result(ret);
 }
 
 
-
 /*-----------------------------------------------------------------------*/
-/* Write Sector(s)                                                       */
+/* Write Sector(s) to the USB disk                                       */
 /*-----------------------------------------------------------------------*/
 
-DRESULT disk_write (
+static DRESULT umas_write (
     BYTE pdrv,          /* Physical drive number (0..) */
     const BYTE *buff,   /* Data to be written */
     DWORD sector,       /* Sector address (LBA) */
-    UINT count          /* Number of sectors to write (1..128) */
+    UINT count          /* Number of sectors to write */
 )
 {
     int       ret;
-    int       sec_size;
+    UINT      n;
 
     //printf("disk_write - drv:%d, sec:%d, cnt:%d, buff:0x%x\n", pdrv, sector, count, (UINT32)buff);
 
     if (!((UINT32)buff & 0x80000000))
     {
         /* Disk write buffer is not non-cacheable buffer. Use my non-cacheable to do disk write. */
-        sec_size = 512;  //usbh_umas_disk_sector_size(pdrv);
-        if (count * sec_size > _MAX_SS)
-            return RES_ERROR;
-
         fatfs_win_buff = (BYTE *)((unsigned int)fatfs_win_buff_pool | 0x80000000);
-        memcpy(fatfs_win_buff, buff, count * sec_size);
-        ret = usbh_umas_write(pdrv, sector, count, fatfs_win_buff);
+        ret = UMAS_OK;
+        while (count && (ret == UMAS_OK))
+        {
+            n = (count > FATFS_BOUNCE_SECTORS) ? FATFS_BOUNCE_SECTORS : count;
+            sysMemCopy(fatfs_win_buff, buff, n * 512);
+            ret = usbh_umas_write(pdrv, sector, n, fatfs_win_buff);
+            buff += n * 512;
+            sector += n;
+            count -= n;
+        }
     }
     else
     {
         ret = usbh_umas_write(pdrv, sector, count, (UINT8 *)buff);
     }
+    return umas_result(ret);
+}
 
-    if (ret == UMAS_OK)
-        return RES_OK;
 
-    if (ret == UMAS_ERR_NO_DEVICE)
-        return RES_NOTRDY;
+/*-----------------------------------------------------------------------*/
+/* Read Sector(s)                                                        */
+/*-----------------------------------------------------------------------*/
+DRESULT disk_read (
+    BYTE pdrv,      /* Physical drive number (0..) */
+    BYTE *buff,     /* Data buffer to store read data */
+    DWORD sector,   /* Sector address (LBA) */
+    UINT count      /* Number of sectors to read (1..128) */
+)
+{
+    if (!(umas_attached & (1 << pdrv)))
+        umas_attach(pdrv);
+    return ffc_read(pdrv, buff, sector, count);
+}
 
-    if (ret == UMAS_ERR_IO)
-        return RES_ERROR;
 
-    return (DRESULT) ret;
+
+/*-----------------------------------------------------------------------*/
+/* Write Sector(s)                                                       */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_write (
+    BYTE pdrv,          /* Physical drive number (0..) */
+    const BYTE *buff,   /* Data to be written */
+    DWORD sector,       /* Sector address (LBA) */
+    UINT count          /* Number of sectors to write (1..128) */
+)
+{
+    if (!(umas_attached & (1 << pdrv)))
+        umas_attach(pdrv);
+    return ffc_write(pdrv, buff, sector, count);
 }
 
 
@@ -158,6 +216,9 @@ DRESULT disk_ioctl (
 {
     int  ret;
 
+    if (cmd == CTRL_SYNC)
+        return ffc_sync(pdrv);
+
     ret = usbh_umas_ioctl(pdrv, cmd, buff);
 
     if (ret == UMAS_OK)
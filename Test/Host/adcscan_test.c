@@ -0,0 +1,244 @@
+/*
+ * Host check of the ADC scan and its CIC decimation, Driver/Source/adcscan.c.
+ *
+ * Register accesses go to a small register file, so the conversion callback
+ * runs as the ADC interrupt would run it.
+ *
+ * - Every order and rate the driver accepts, on random and full scale
+ *   input, against a direct convolution with the CIC impulse response:
+ *   each sample is that sum times 16 / u32Decim^u32Order, rounded.
+ * - The rates and orders adcScanSetDecimation() must refuse.
+ * - A scan list with a channel in two slots: conversions are chained slot
+ *   by slot on the channel each slot selects, the scan restarts in free
+ *   run, results reach the ring of their channel, a full ring counts
+ *   overruns and adcScanRead() wraps around the ring.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nuc980.h"
+
+/* Registers of the host: REG_ADC_CONF and REG_ADC_CTL as written, the rest reads 0 */
+static uint32_t RegConf, RegCtl, Starts;
+
+static void host_outpw(uintptr_t port, uint32_t value)
+{
+    if (port == REG_ADC_CONF)
+        RegConf = value;
+    else if (port == REG_ADC_CTL)
+    {
+        RegCtl = value;
+        Starts++;
+    }
+}
+
+static uint32_t host_inpw(uintptr_t port)
+{
+    return port == REG_ADC_CONF ? RegConf : 0;
+}
+
+#undef outpw
+#undef inpw
+#define outpw(port, value)  host_outpw((uintptr_t)(port), (uint32_t)(value))
+#define inpw(port)          host_inpw((uintptr_t)(port))
+
+#include "adcscan.c"
+
+static int Errors;
+
+#define CHECK(c, ...)   do { if (!(c)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); Errors++; } } while (0)
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Driver functions adcscan.c calls                                                                        */
+/*---------------------------------------------------------------------------------------------------------*/
+
+void sysMemSet(void *pvDst, INT32 i32Val, UINT32 u32Len)
+{
+    memset(pvDst, i32Val, u32Len);
+}
+
+void sysMemCopy(void *pvDst, const void *pvSrc, UINT32 u32Len)
+{
+    memcpy(pvDst, pvSrc, u32Len);
+}
+
+int adcIoctl(ADC_CMD cmd, int arg1, int arg2)
+{
+    (void)cmd; (void)arg1; (void)arg2;
+    return 0;
+}
+
+UINT ETIMER_Open(UINT timer, UINT u32Mode, UINT u32Freq)
+{
+    (void)timer; (void)u32Mode;
+    return u32Freq;
+}
+
+PVOID sysInstallISR(INT32 nIntTypeLevel, IRQn_Type eIntNo, PVOID pvNewISR)
+{
+    (void)nIntTypeLevel; (void)eIntNo;
+    return pvNewISR;
+}
+
+INT32 sysSetLocalInterrupt(INT32 nIntState)
+{
+    (void)nIntState;
+    return 0;
+}
+
+INT32 sysEnableInterrupt(IRQn_Type eIntNo)
+{
+    (void)eIntNo;
+    return 0;
+}
+
+INT32 sysDisableInterrupt(IRQn_Type eIntNo)
+{
+    (void)eIntNo;
+    return 0;
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Tests                                                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#define NIN     4096
+
+static void test_cic(void)
+{
+    static uint16_t au16Ring[NIN / 2];
+    static uint64_t au64H[3 * ADC_SCAN_DECIM_MAX];
+    static uint32_t au32X[NIN];
+    ADC_SCAN_CH_T sCh;
+    uint32_t u32Decim, u32Order, u32Gain, u32Len, u32Ref, n, i, k, pass;
+    uint16_t u16Out;
+    uint64_t y;
+    unsigned seed = 1;
+
+    for (u32Order = 1; u32Order <= ADC_SCAN_ORDER_MAX; u32Order++)
+    {
+        for (u32Decim = 2; u32Decim <= ADC_SCAN_DECIM_MAX; u32Decim++)
+        {
+            for (u32Gain = 1, k = 0; k < u32Order; k++)
+                u32Gain *= u32Decim;
+            if (u32Gain > (1UL << 20))
+                break;
+
+            /* Impulse response, u32Order boxcars of u32Decim convolved */
+            memset(au64H, 0, sizeof(au64H));
+            au64H[0] = 1;
+            for (u32Len = 1, k = 0; k < u32Order; k++)
+            {
+                u32Len += u32Decim - 1;
+                for (i = u32Len; i-- > 0; )
+                {
+                    for (y = 0, n = 0; n < u32Decim && n <= i; n++)
+                        y += au64H[i - n];
+                    au64H[i] = y;
+                }
+            }
+
+            for (pass = 0; pass < 2; pass++)
+            {
+                for (i = 0; i < NIN; i++)
+                    au32X[i] = pass ? 4095 : (uint32_t)rand_r(&seed) & 0xFFF;
+
+                adcScanAddChannel(&(ADC_SCAN_T){ 0 }, &sCh, 0, au16Ring, NIN / 2);
+                CHECK(adcScanSetDecimation(&sCh, u32Decim, u32Order) == 0, "rate %u order %u refused", u32Decim, u32Order);
+                for (i = 0; i < NIN; i++)
+                    scan_push(&sCh, au32X[i]);
+
+                CHECK(adcScanCount(&sCh) == NIN / u32Decim, "%u samples from %u conversions at rate %u", adcScanCount(&sCh), NIN, u32Decim);
+                for (n = 0; adcScanRead(&sCh, &u16Out, 1) && !Errors; n++)
+                {
+                    /* Sample n ends at conversion (n + 1) * u32Decim - 1, earlier conversions are 0 */
+                    for (y = 0, k = 0; k < u32Len && k <= (n + 1) * u32Decim - 1; k++)
+                        y += au64H[k] * au32X[(n + 1) * u32Decim - 1 - k];
+                    u32Ref = (uint32_t)((y * 32 + u32Gain) / (2 * u32Gain));
+                    CHECK(u16Out == u32Ref, "rate %u order %u sample %u is %u, %u expected", u32Decim, u32Order, n, u16Out, u32Ref);
+                }
+                if (Errors)
+                    return;
+            }
+        }
+    }
+    printf("CIC decimation: %s\n", Errors ? "FAIL" : "ok");
+}
+
+static void test_args(void)
+{
+    ADC_SCAN_CH_T sCh;
+
+    memset(&sCh, 0, sizeof(sCh));
+    CHECK(adcScanSetDecimation(&sCh, 0, 1) == ADC_ERR_ARGS, "rate 0");
+    CHECK(adcScanSetDecimation(&sCh, ADC_SCAN_DECIM_MAX + 1, 1) == ADC_ERR_ARGS, "rate above ADC_SCAN_DECIM_MAX");
+    CHECK(adcScanSetDecimation(&sCh, 4, 0) == ADC_ERR_ARGS, "order 0");
+    CHECK(adcScanSetDecimation(&sCh, 4, ADC_SCAN_ORDER_MAX + 1) == ADC_ERR_ARGS, "order above ADC_SCAN_ORDER_MAX");
+    CHECK(adcScanSetDecimation(&sCh, 102, 3) == ADC_ERR_ARGS, "gain above 2^20");
+    CHECK(adcScanSetDecimation(&sCh, 101, 3) == 0, "gain below 2^20");
+    CHECK(adcScanSetDecimation(&sCh, 256, 2) == 0, "gain of 2^16");
+    printf("decimation arguments: %s\n", Errors ? "FAIL" : "ok");
+}
+
+static void test_scan(void)
+{
+    static const int aiChannel[] = { 3, 8, 3 };
+    static ADC_SCAN_T sScan;    /* adcIoctl() passes it as a 32-bit word */
+    static ADC_SCAN_CH_T sA, sB;
+    uint16_t au16A[8], au16B[4], au16Out[8];
+    uint32_t u32Data = 0, u32Scan, u32Slot, u32ReadA = 0, i;
+
+    adcScanInit(&sScan);
+    CHECK(adcScanAddChannel(&sScan, &sA, 3, au16A, 8) == 0, "add channel 3");
+    CHECK(adcScanAddChannel(&sScan, &sB, 8, au16B, 4) == 0, "add Vref");
+    CHECK(adcScanAddSlot(&sScan, &sA, 3) == 0, "second slot of channel 3");
+    CHECK(adcScanAddChannel(&sScan, &sB, 8, au16B, 3) == ADC_ERR_ARGS, "ring of 3 accepted");
+    CHECK(adcScanAddSlot(&sScan, &sA, 9) == ADC_ERR_ARGS, "channel 9 accepted");
+
+    Starts = 0;
+    CHECK(adcScanStart(&sScan, ADC_SCAN_FREE_RUN, 0) == 0, "start");
+    CHECK(adcScanStart(&sScan, ADC_SCAN_FREE_RUN, 0) == ADC_ERR_BUSY, "second start");
+    CHECK(adcScanAddSlot(&sScan, &sA, 3) == ADC_ERR_BUSY, "slot added while running");
+
+    /* Six scans; the ring of channel 3 takes two samples a scan and is read every other scan */
+    for (u32Scan = 0; u32Scan < 6; u32Scan++)
+    {
+        for (u32Slot = 0; u32Slot < 3; u32Slot++)
+        {
+            CHECK(Starts == u32Scan * 3 + u32Slot + 1 && (RegCtl & ADC_CTL_MST), "conversion %u not started", u32Scan * 3 + u32Slot);
+            CHECK(((RegConf & ADC_CONF_CHSEL_Msk) >> ADC_CONF_CHSEL_Pos) == (uint32_t)aiChannel[u32Slot],
+                  "slot %u converts channel %u", u32Slot, (RegConf & ADC_CONF_CHSEL_Msk) >> ADC_CONF_CHSEL_Pos);
+            scan_adc_callback(u32Data++, (UINT32)(uintptr_t)&sScan);
+        }
+        CHECK(sScan.u32Scans == u32Scan + 1 && sScan.u32Busy, "scan %u not restarted", u32Scan);
+        if (u32Scan % 2)
+        {
+            CHECK(adcScanRead(&sA, au16Out, 8) == 4, "channel 3 holds %u samples", adcScanCount(&sA));
+            for (i = 0; i < 4; i++, u32ReadA++)
+                CHECK(au16Out[i] == ((u32ReadA / 2 * 3 + u32ReadA % 2 * 2) << 4), "channel 3 sample %u is %u", u32ReadA, au16Out[i]);
+        }
+    }
+    CHECK(sA.u32Conversions == 12 && sA.u32Overruns == 0, "channel 3: %u conversions, %u overruns", sA.u32Conversions, sA.u32Overruns);
+    CHECK(sB.u32Conversions == 6 && sB.u32Overruns == 2, "Vref: %u conversions, %u overruns", sB.u32Conversions, sB.u32Overruns);
+    CHECK(adcScanRead(&sB, au16Out, 8) == 4 && au16Out[0] == (1 << 4) && au16Out[3] == (10 << 4), "Vref ring");
+
+    sScan.u32Run = 0;
+    for (u32Slot = 0; u32Slot < 3; u32Slot++)
+        scan_adc_callback(u32Data++, (UINT32)(uintptr_t)&sScan);
+    CHECK(!sScan.u32Busy && Starts == 21, "scan did not stop");
+    adcScanStop(&sScan);
+    printf("scan list and rings: %s\n", Errors ? "FAIL" : "ok");
+}
+
+int main(void)
+{
+    test_args();
+    test_scan();
+    test_cic();
+
+    printf("adcscan: %s\n", Errors ? "FAIL" : "PASS");
+    return Errors != 0;
+}
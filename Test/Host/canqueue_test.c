@@ -0,0 +1,494 @@
+/*
+ * Host check of the CAN queue, Driver/Source/canqueue.c.
+ *
+ * The register blocks of CAN0 to CAN3 are host memory mapped at their
+ * addresses. The message RAM is not simulated: a transfer through IF2
+ * completes at once, so the test reads back what the driver wrote into IF2
+ * for a frame to send and writes into IF2 the frame the driver reads.
+ *
+ * - The arbitration key sorts frames as the bus arbitrates them.
+ * - The transmit heap, against a linear search for the lowest key and
+ *   sequence, across the wrap of the sequence counter.
+ * - Frames leave the transmit object in that order, as the transmit
+ *   interrupt refills it, and a full queue refuses frames.
+ * - The software filter, standard and extended IDs added and removed at
+ *   random against a reference set, with the extended set run up to its
+ *   3/4 load, and the frames CAN_QueueReceive() returns through it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "canqueue.c"
+
+static int Errors;
+
+#define CHECK(c, ...)   do { if (!(c)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); Errors++; } } while (0)
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Driver functions canqueue.c calls                                                                       */
+/*---------------------------------------------------------------------------------------------------------*/
+
+int32_t CAN_ReserveIF(CAN_T *tCAN, uint32_t u32Reserve)
+{
+    (void)tCAN; (void)u32Reserve;
+    return (int32_t)TRUE;
+}
+
+void CAN_EnableInt(CAN_T *tCAN, uint32_t u32Mask)
+{
+    tCAN->CON |= u32Mask;
+}
+
+void CAN_DisableInt(CAN_T *tCAN, uint32_t u32Mask)
+{
+    tCAN->CON &= ~u32Mask;
+}
+
+uint32_t CAN_GetCANBitRate(CAN_T *tCAN)
+{
+    (void)tCAN;
+    return 500000;
+}
+
+PVOID sysInstallISR(INT32 nIntTypeLevel, IRQn_Type eIntNo, PVOID pvNewISR)
+{
+    (void)nIntTypeLevel; (void)eIntNo;
+    return pvNewISR;
+}
+
+INT32 sysSetLocalInterrupt(INT32 nIntState)
+{
+    (void)nIntState;
+    return 0;
+}
+
+INT32 sysEnableInterrupt(IRQn_Type eIntNo)
+{
+    (void)eIntNo;
+    return 0;
+}
+
+INT32 sysDisableInterrupt(IRQn_Type eIntNo)
+{
+    (void)eIntNo;
+    return 0;
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Frames                                                                                                  */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static unsigned Seed = 1;
+
+static uint32_t rnd(uint32_t n)
+{
+    return (uint32_t)rand_r(&Seed) % n;
+}
+
+static void random_msg(STR_CANMSG_T *pMsg, uint32_t u32Ids)
+{
+    uint32_t i;
+
+    memset(pMsg, 0, sizeof(*pMsg));
+    pMsg->IdType = rnd(2) ? CAN_EXT_ID : CAN_STD_ID;
+    pMsg->FrameType = rnd(4) ? CAN_DATA_FRAME : CAN_REMOTE_FRAME;
+    /* Few IDs, for frames of equal keys */
+    pMsg->Id = (uint32_t)((uint64_t)rnd(u32Ids) * (pMsg->IdType == CAN_STD_ID ? 0x7FFul : 0x1FFFFFFFul) / u32Ids);
+    pMsg->DLC = (uint8_t)rnd(9);
+    for (i = 0; i < 8; i++)
+        pMsg->Data[i] = (uint8_t)rnd(256);
+}
+
+/* The frame in IF2, as the message object loaded from it would send it */
+static void if_frame(CAN_T *tCAN, STR_CANMSG_T *pMsg)
+{
+    CAN_IF_T *psIF = &tCAN->IF[CAN_QUEUE_IF];
+
+    memset(pMsg, 0, sizeof(*pMsg));
+    if (psIF->ARB2 & CAN_IF_ARB2_XTD_Msk)
+    {
+        pMsg->IdType = CAN_EXT_ID;
+        pMsg->Id = ((psIF->ARB2 & 0x1FFFul) << 16) | (psIF->ARB1 & 0xFFFFul);
+    }
+    else
+    {
+        pMsg->IdType = CAN_STD_ID;
+        pMsg->Id = (psIF->ARB2 & CAN_IF_ARB2_ID_Msk) >> 2;
+    }
+    pMsg->FrameType = (psIF->ARB2 & CAN_IF_ARB2_DIR_Msk) ? CAN_DATA_FRAME : CAN_REMOTE_FRAME;
+    pMsg->DLC = (uint8_t)(psIF->MCON & CAN_IF_MCON_DLC_Msk);
+    pMsg->Data[0] = (uint8_t)psIF->DAT_A1;
+    pMsg->Data[1] = (uint8_t)(psIF->DAT_A1 >> 8);
+    pMsg->Data[2] = (uint8_t)psIF->DAT_A2;
+    pMsg->Data[3] = (uint8_t)(psIF->DAT_A2 >> 8);
+    pMsg->Data[4] = (uint8_t)psIF->DAT_B1;
+    pMsg->Data[5] = (uint8_t)(psIF->DAT_B1 >> 8);
+    pMsg->Data[6] = (uint8_t)psIF->DAT_B2;
+    pMsg->Data[7] = (uint8_t)(psIF->DAT_B2 >> 8);
+}
+
+/* Put a received frame into IF2, as a transfer from a receive object would */
+static void if_receive(CAN_T *tCAN, STR_CANMSG_T *pMsg)
+{
+    CAN_IF_T *psIF = &tCAN->IF[CAN_QUEUE_IF];
+
+    if (pMsg->IdType == CAN_STD_ID)
+    {
+        psIF->ARB1 = 0;
+        psIF->ARB2 = CAN_IF_ARB2_MSGVAL_Msk | ((pMsg->Id & 0x7FFul) << 2);
+    }
+    else
+    {
+        psIF->ARB1 = pMsg->Id & 0xFFFFul;
+        psIF->ARB2 = CAN_IF_ARB2_MSGVAL_Msk | CAN_IF_ARB2_XTD_Msk | ((pMsg->Id >> 16) & 0x1FFFul);
+    }
+    psIF->MCON = CAN_IF_MCON_UMASK_Msk | CAN_IF_MCON_RXIE_Msk | pMsg->DLC;
+    psIF->DAT_A1 = ((uint32_t)pMsg->Data[1] << 8) | pMsg->Data[0];
+    psIF->DAT_A2 = ((uint32_t)pMsg->Data[3] << 8) | pMsg->Data[2];
+    psIF->DAT_B1 = ((uint32_t)pMsg->Data[5] << 8) | pMsg->Data[4];
+    psIF->DAT_B2 = ((uint32_t)pMsg->Data[7] << 8) | pMsg->Data[6];
+}
+
+static int same_msg(STR_CANMSG_T *pA, STR_CANMSG_T *pB)
+{
+    return pA->IdType == pB->IdType && pA->Id == pB->Id && pA->FrameType == pB->FrameType &&
+           pA->DLC == pB->DLC && (pA->FrameType == CAN_REMOTE_FRAME || !memcmp(pA->Data, pB->Data, 8));
+}
+
+/* Transmit interrupt of object n, as CAN_QueueIRQHandler() serves it */
+static void tx_done(CAN_QUEUE_T *psQueue, uint32_t n)
+{
+    psQueue->u32TxFree |= 1ul << n;
+    psQueue->u32TxFrames++;
+    can_tx_fill(psQueue);
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Tests                                                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/* Bits of the arbitration field, dominant 0 first: ID, RTR or SRR, IDE, extended ID, RTR */
+static uint64_t arbitration(STR_CANMSG_T *pMsg)
+{
+    uint64_t u64Rtr = pMsg->FrameType == CAN_REMOTE_FRAME;
+
+    if (pMsg->IdType == CAN_STD_ID)
+        return ((uint64_t)pMsg->Id << 21) | (u64Rtr << 20);
+    return ((uint64_t)(pMsg->Id >> 18) << 21) | (1ull << 20) | (1ull << 19) | ((uint64_t)(pMsg->Id & 0x3FFFFul) << 1) | u64Rtr;
+}
+
+static void test_key(void)
+{
+    STR_CANMSG_T sA, sB;
+    uint64_t u64A, u64B;
+    uint32_t u32KeyA, u32KeyB, i;
+
+    for (i = 0; i < 1000000 && !Errors; i++)
+    {
+        random_msg(&sA, i % 2 ? 8 : 0x800);
+        random_msg(&sB, i % 2 ? 8 : 0x800);
+        if (i % 3 == 0)
+            sB.Id = sB.IdType == sA.IdType ? sA.Id : sB.IdType == CAN_EXT_ID ? sA.Id << 18 : sA.Id >> 18;
+        u64A = arbitration(&sA);
+        u64B = arbitration(&sB);
+        u32KeyA = can_key(&sA);
+        u32KeyB = can_key(&sB);
+        CHECK((u64A < u64B) == (u32KeyA < u32KeyB) && (u64A == u64B) == (u32KeyA == u32KeyB),
+              "%s %s %#x key %#x against %s %s %#x key %#x",
+              sA.IdType ? "ext" : "std", sA.FrameType ? "data" : "remote", sA.Id, u32KeyA,
+              sB.IdType ? "ext" : "std", sB.FrameType ? "data" : "remote", sB.Id, u32KeyB);
+    }
+    printf("arbitration key: %s\n", Errors ? "FAIL" : "ok");
+}
+
+#define NHEAP   64
+
+static void test_heap(void)
+{
+    static CAN_TXENTRY_T asHeap[NHEAP], asRef[NHEAP];
+    static CAN_QUEUE_T sQueue;
+    CAN_TXENTRY_T sEntry;
+    STR_CANMSG_T sMsg;
+    uint32_t u32Ref = 0, i, k, n;
+
+    memset(&sQueue, 0, sizeof(sQueue));
+    sQueue.psTx = asHeap;
+    sQueue.u32TxSize = NHEAP;
+    sQueue.u32TxSeq = 0xFFFFFFC0ul;
+
+    for (n = 0; n < 2000000 && !Errors; n++)
+    {
+        /* Fill and drain in turns, so the heap runs both full and empty; the
+           sequence wraps while it first fills, among many equal keys */
+        if (u32Ref < NHEAP && (u32Ref == 0 || rnd(64) < (n / 20000 % 2 ? 24 : 40)))
+        {
+            random_msg(&sMsg, 4);
+            asRef[u32Ref].sMsg = sMsg;
+            asRef[u32Ref].u32Key = can_key(&sMsg);
+            asRef[u32Ref++].u32Seq = sQueue.u32TxSeq;
+            can_heap_push(&sQueue, &sMsg);
+        }
+        else
+        {
+            for (k = 0, i = 1; i < u32Ref; i++)
+            {
+                if (asRef[i].u32Key < asRef[k].u32Key ||
+                        (asRef[i].u32Key == asRef[k].u32Key && (int32_t)(asRef[i].u32Seq - asRef[k].u32Seq) < 0))
+                    k = i;
+            }
+            can_heap_pop(&sQueue, &sEntry);
+            CHECK(sEntry.u32Key == asRef[k].u32Key && sEntry.u32Seq == asRef[k].u32Seq && same_msg(&sEntry.sMsg, &asRef[k].sMsg),
+                  "op %u: popped key %#x seq %#x, key %#x seq %#x expected", n, sEntry.u32Key, sEntry.u32Seq, asRef[k].u32Key, asRef[k].u32Seq);
+            asRef[k] = asRef[--u32Ref];
+        }
+        CHECK(sQueue.u32TxCount == u32Ref, "op %u: %u entries, %u expected", n, sQueue.u32TxCount, u32Ref);
+    }
+    CHECK(sQueue.u32TxSeq < 0xFFFFFFC0ul, "sequence did not wrap");
+    printf("transmit heap: %s\n", Errors ? "FAIL" : "ok");
+}
+
+#define NTX     16
+
+static void test_send(void)
+{
+    static CAN_FRAME_T asRx[4];
+    static CAN_TXENTRY_T asTx[NTX];
+    static CAN_QUEUE_T sQueue;
+    static STR_CANMSG_T asWait[NTX + 1];
+    STR_CANMSG_T sMsg, sSent, sLoaded;
+    uint32_t u32Wait = 0, u32Busy = 0, u32Full = 0, u32Sent = 0, i, k, n;
+
+    CHECK(CAN_QueueOpen(&sQueue, CAN0, 4, 1, asRx, 4, asTx, NTX), "open");
+
+    for (n = 0; n < 200000 && !Errors; n++)
+    {
+        if (rnd(2))
+        {
+            random_msg(&sMsg, 6);
+            if (u32Wait == NTX)
+            {
+                CHECK(!CAN_QueueSend(&sQueue, &sMsg) && sQueue.u32TxFull == ++u32Full, "op %u: full queue took a frame", n);
+                continue;
+            }
+            CHECK(CAN_QueueSend(&sQueue, &sMsg), "op %u: frame refused with %u waiting", n, u32Wait);
+            if (u32Busy)
+            {
+                asWait[u32Wait++] = sMsg;
+                continue;
+            }
+            /* The object is free, the frame is loaded at once */
+            sLoaded = sMsg;
+            u32Busy = 1;
+        }
+        else if (u32Busy)
+        {
+            if_frame(CAN0, &sSent);
+            CHECK(same_msg(&sSent, &sLoaded) && CAN0->IF[CAN_QUEUE_IF].CREQ == 1 + 4,
+                  "op %u: object %u sends %#x, %#x expected", n, CAN0->IF[CAN_QUEUE_IF].CREQ - 1, sSent.Id, sLoaded.Id);
+            u32Sent++;
+            tx_done(&sQueue, 0);
+            u32Busy = 0;
+            if (u32Wait)
+            {
+                /* The lowest key, the oldest of equal keys */
+                for (k = 0, i = 1; i < u32Wait; i++)
+                    if (can_key(&asWait[i]) < can_key(&asWait[k]))
+                        k = i;
+                sLoaded = asWait[k];
+                memmove(&asWait[k], &asWait[k + 1], (u32Wait - k - 1) * sizeof(asWait[0]));
+                u32Wait--;
+                u32Busy = 1;
+            }
+        }
+        CHECK(CAN_QueueTxCount(&sQueue) == u32Wait + u32Busy, "op %u: %u frames unsent, %u expected", n, CAN_QueueTxCount(&sQueue), u32Wait + u32Busy);
+        CHECK((sQueue.tCAN->CON & CAN_INT_MSK) == (CAN_CON_IE_Msk | CAN_CON_EIE_Msk), "op %u: interrupts left masked", n);
+    }
+    CHECK(sQueue.u32TxFrames == u32Sent && u32Full > 0, "%u frames sent, %u counted, %u refused", u32Sent, sQueue.u32TxFrames, u32Full);
+    CAN_QueueClose(&sQueue);
+
+    /* Three objects are loaded in ascending order, and reloaded only once all are sent */
+    CHECK(CAN_QueueOpen(&sQueue, CAN0, 4, 3, asRx, 4, asTx, NTX), "reopen");
+    for (i = 0; i < 5; i++)
+    {
+        random_msg(&sMsg, 0x800);
+        CAN_QueueSend(&sQueue, &sMsg);
+    }
+    CHECK(sQueue.u32TxFree == 0 && sQueue.u32TxNext == 3 && sQueue.u32TxCount == 2, "three objects not loaded");
+    tx_done(&sQueue, 0);
+    CHECK(sQueue.u32TxFree == 1 && sQueue.u32TxCount == 2, "object 0 reloaded before objects 1 and 2 are sent");
+    tx_done(&sQueue, 1);
+    tx_done(&sQueue, 2);
+    CHECK(sQueue.u32TxFree == 4 && sQueue.u32TxNext == 2 && sQueue.u32TxCount == 0 && CAN0->IF[CAN_QUEUE_IF].CREQ == 1 + 4 + 1,
+          "objects 0 and 1 not reloaded");
+    CHECK(CAN_QueueTxCount(&sQueue) == 2, "%u frames unsent", CAN_QueueTxCount(&sQueue));
+    CAN_QueueClose(&sQueue);
+    printf("transmit order: %s\n", Errors ? "FAIL" : "ok");
+}
+
+#define NEXT    64
+#define NPOOL   400
+
+static void test_filter(void)
+{
+    static CAN_FRAME_T asRx[8];
+    static CAN_QUEUE_T sQueue;
+    static uint32_t au32Ext[NEXT], au32Pool[NPOOL];
+    static uint8_t au8Std[2048], au8Ext[NPOOL];
+    CAN_FRAME_T sFrame;
+    STR_CANMSG_T sMsg;
+    uint32_t u32Count = 0, u32Frames = 0, u32Filtered = 0, u32Full = 0, u32ID, u32Take, i, k, n;
+    int32_t i32Rev;
+
+    for (i = 0; i < NPOOL; i++)
+    {
+        /* Distinct extended IDs, a few of them also the standard IDs of the pool */
+        do
+        {
+            au32Pool[i] = i % 16 ? (uint32_t)rand_r(&Seed) & 0x1FFFFFFFul : rnd(2048);
+            for (k = 0; k < i && au32Pool[k] != au32Pool[i]; k++);
+        }
+        while (k < i);
+    }
+
+    CHECK(CAN_QueueOpen(&sQueue, CAN1, 4, 0, asRx, 8, NULL, 0), "open");
+    random_msg(&sMsg, 8);
+    CHECK(!CAN_QueueSend(&sQueue, &sMsg) && sQueue.u32TxCount == 0, "receive-only queue took a frame");
+
+    /* Without the filter every frame is taken */
+    for (i = 0; i < 8; i++)
+    {
+        random_msg(&sMsg, 0x800);
+        sMsg.FrameType = CAN_DATA_FRAME;
+        if_receive(CAN1, &sMsg);
+        can_rx_read(&sQueue, 0);
+        CHECK(CAN_QueueReceive(&sQueue, &sFrame) && same_msg(&sFrame.sMsg, &sMsg), "frame %u not received", i);
+        u32Frames++;
+    }
+
+    CAN_QueueEnableFilter(&sQueue, au32Ext, NEXT);
+    for (n = 0; n < 400000 && !Errors; n++)
+    {
+        k = rnd(NPOOL);
+        switch (rnd(4))
+        {
+        case 0:     /* Add an extended ID, the bits above the 29 of the ID ignored */
+            i32Rev = CAN_QueueAddId(&sQueue, CAN_EXT_ID, au32Pool[k] | (rnd(8) << 29));
+            if (!au8Ext[k] && 4 * (u32Count + 1) > 3 * NEXT)
+            {
+                CHECK(!i32Rev, "op %u: ID %u of %u added past 3/4 of the set", n, u32Count + 1, NEXT);
+                u32Full++;
+                break;
+            }
+            CHECK(i32Rev, "op %u: ID %#x refused with %u IDs", n, au32Pool[k], u32Count);
+            u32Count += !au8Ext[k];
+            au8Ext[k] = 1;
+            break;
+
+        case 1:     /* Remove an extended ID, more often when the set runs full */
+            if (u32Count < 3 * NEXT / 4 && rnd(2))
+                break;
+            CHECK(CAN_QueueRemoveId(&sQueue, CAN_EXT_ID, au32Pool[k]) == au8Ext[k], "op %u: removing ID %#x", n, au32Pool[k]);
+            u32Count -= au8Ext[k];
+            au8Ext[k] = 0;
+            break;
+
+        case 2:     /* Add or remove a standard ID */
+            u32ID = rnd(2048);
+            if (rnd(2))
+            {
+                CHECK(CAN_QueueAddId(&sQueue, CAN_STD_ID, u32ID), "op %u: standard ID %#x refused", n, u32ID);
+                au8Std[u32ID] = 1;
+            }
+            else
+            {
+                CHECK(CAN_QueueRemoveId(&sQueue, CAN_STD_ID, u32ID) == au8Std[u32ID], "op %u: removing standard ID %#x", n, u32ID);
+                au8Std[u32ID] = 0;
+            }
+            break;
+
+        default:    /* Receive a frame of the pool */
+            random_msg(&sMsg, 8);
+            sMsg.FrameType = CAN_DATA_FRAME;
+            sMsg.Id = sMsg.IdType == CAN_STD_ID ? au32Pool[k] & 0x7FFul : au32Pool[k];
+            u32Take = sMsg.IdType == CAN_STD_ID ? au8Std[sMsg.Id] : au8Ext[k];
+            if_receive(CAN1, &sMsg);
+            can_rx_read(&sQueue, rnd(4));
+            u32Frames += u32Take;
+            u32Filtered += !u32Take;
+            CHECK(sQueue.u32RxFrames == u32Frames && sQueue.u32RxFiltered == u32Filtered,
+                  "op %u: %s ID %#x %s", n, sMsg.IdType ? "extended" : "standard", sMsg.Id, u32Take ? "rejected" : "taken");
+            if (u32Take)
+                CHECK(CAN_QueueReceive(&sQueue, &sFrame) && same_msg(&sFrame.sMsg, &sMsg), "op %u: frame not stored", n);
+            break;
+        }
+
+        CHECK(sQueue.u32ExtCount == u32Count, "op %u: %u extended IDs, %u expected", n, sQueue.u32ExtCount, u32Count);
+        if (n % 64 == 0)
+        {
+            for (i = 0; i < NPOOL; i++)
+                CHECK(can_accept(&sQueue, CAN_EXT_ID, au32Pool[i]) == au8Ext[i], "op %u: extended ID %#x %s", n, au32Pool[i], au8Ext[i] ? "lost" : "found");
+            for (i = 0; i < 2048; i++)
+                CHECK(can_accept(&sQueue, CAN_STD_ID, i) == au8Std[i], "op %u: standard ID %#x", n, i);
+        }
+    }
+    CHECK(u32Full > 0, "extended set never ran full");
+
+    /* Disabled, every frame is taken again; enabled again, the filter is empty */
+    CAN_QueueDisableFilter(&sQueue);
+    sMsg.IdType = CAN_EXT_ID;
+    sMsg.Id = 0x1ABCDEF;
+    if_receive(CAN1, &sMsg);
+    can_rx_read(&sQueue, 0);
+    CHECK(CAN_QueueReceive(&sQueue, &sFrame) && sFrame.sMsg.Id == 0x1ABCDEF, "disabled filter rejected a frame");
+    CAN_QueueEnableFilter(&sQueue, NULL, 0);
+    CHECK(!CAN_QueueAddId(&sQueue, CAN_EXT_ID, 0x1ABCDEF) && !CAN_QueueRemoveId(&sQueue, CAN_EXT_ID, 0x1ABCDEF),
+          "extended ID set without storage");
+    for (i = 0; i < 2048; i++)
+        CHECK(!can_accept(&sQueue, CAN_STD_ID, i), "standard ID %#x kept", i);
+    CAN_QueueClose(&sQueue);
+    printf("software filter: %s\n", Errors ? "FAIL" : "ok");
+}
+
+static void test_open(void)
+{
+    static CAN_FRAME_T asRx[8];
+    static CAN_TXENTRY_T asTx[4];
+    static CAN_QUEUE_T sQueue, sOther;
+    static CAN_T sNotCan;
+
+    CHECK(!CAN_QueueOpen(&sQueue, &sNotCan, 4, 4, asRx, 8, asTx, 4), "unknown controller");
+    CHECK(!CAN_QueueOpen(&sQueue, CAN2, 0, 4, asRx, 8, asTx, 4), "no receive object");
+    CHECK(!CAN_QueueOpen(&sQueue, CAN2, 30, 3, asRx, 8, asTx, 4), "33 objects");
+    CHECK(!CAN_QueueOpen(&sQueue, CAN2, 4, 4, asRx, 6, asTx, 4), "ring of 6");
+    CHECK(!CAN_QueueOpen(&sQueue, CAN2, 4, 4, asRx, 8, asTx, 0), "transmit objects without a queue");
+    CHECK(CAN_QueueOpen(&sQueue, CAN2, 28, 4, asRx, 8, asTx, 4), "32 objects");
+    CHECK(!CAN_QueueOpen(&sOther, CAN2, 4, 4, asRx, 8, asTx, 4), "second queue on a controller");
+    CAN_QueueClose(&sQueue);
+    CHECK(CAN_QueueOpen(&sOther, CAN2, 4, 4, asRx, 8, asTx, 4), "open after close");
+    CAN_QueueClose(&sOther);
+    printf("open arguments: %s\n", Errors ? "FAIL" : "ok");
+}
+
+int main(void)
+{
+    /* The register blocks of CAN0 to CAN3 */
+    if (mmap((void *)CAN0, 4 * 0x1000, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) != (void *)CAN0)
+    {
+        perror("mmap");
+        return 1;
+    }
+
+    test_open();
+    test_key();
+    test_heap();
+    test_send();
+    test_filter();
+
+    printf("canqueue: %s\n", Errors ? "FAIL" : "PASS");
+    return Errors != 0;
+}
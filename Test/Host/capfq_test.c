@@ -0,0 +1,340 @@
+/*
+ * Host check of the CAP frame queue, Driver/Source/cap.c.
+ *
+ * The CAP register block is host memory. The test raises frame ends by
+ * setting VINTF while the engine is enabled, as VSYNC does, and runs the
+ * queue against a reference that follows the frame numbers through the free
+ * and ready rings.
+ *
+ * - CAP_FQ_Init() refuses bad counts, alignment and sizes, lays the buffers
+ *   out on 32 bytes and invalidates them.
+ * - Random frame ends, dequeues, requeues, stops and starts on 2 to 8
+ *   buffers, packet and planar, with CAP_FQ_DROP_NEW and CAP_FQ_DROP_OLD.
+ *   After every step each buffer is in exactly one place, the engine points
+ *   at the active one, and every frame is taken, ready or dropped. Frames
+ *   come out with the number and time stamp the reference expects.
+ * - The frame end handler clears only VINTF and ignores a masked frame end.
+ * - CAP_FQ_Queue() refuses a frame the consumer does not hold.
+ * - Every call leaves the I-bit as it found it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cap.c"
+
+static int Errors;
+
+#define CHECK(c, ...)   do { if (!(c)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); Errors++; } } while (0)
+
+#define BASE    0x00100000
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Driver functions cap.c calls                                                                            */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static BOOL IBit = TRUE;
+static uint32_t Disables;
+static uint32_t InvAddr, InvSize;
+
+BOOL sysGetIBitState(void)
+{
+    return IBit;
+}
+
+INT32 sysSetLocalInterrupt(INT32 nIntState)
+{
+    IBit = (nIntState == ENABLE_IRQ);
+    Disables += !IBit;
+    return 0;
+}
+
+void sysInvalidateDCacheRange(UINT32 u32Addr, UINT32 u32Size)
+{
+    InvAddr = u32Addr;
+    InvSize = u32Size;
+}
+
+static uint32_t Now;
+
+static uint32_t clock_now(void)
+{
+    return Now;
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Reference                                                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static unsigned Seed = 1;
+
+static uint32_t rnd(uint32_t n)
+{
+    return (uint32_t)rand_r(&Seed) % n;
+}
+
+static CAP_T Cap;
+
+/* The frames the queue should hold: numbers and stamps of the ready ones, oldest first */
+static struct
+{
+    uint32_t u32Free, u32Active, u32Seq, u32Dropped;
+    uint32_t u32ReadyCnt, au32Seq[CAP_FQ_DEPTH_MAX], au32Time[CAP_FQ_DEPTH_MAX];
+} Ref;
+
+static void ref_pop(void)
+{
+    Ref.u32ReadyCnt--;
+    memmove(Ref.au32Seq, Ref.au32Seq + 1, Ref.u32ReadyCnt * sizeof(uint32_t));
+    memmove(Ref.au32Time, Ref.au32Time + 1, Ref.u32ReadyCnt * sizeof(uint32_t));
+}
+
+static void ref_frame_end(uint32_t u32Mode)
+{
+    Ref.u32Seq++;
+    if (!Ref.u32Free && Ref.u32ReadyCnt && (u32Mode == CAP_FQ_DROP_OLD))
+    {
+        ref_pop();
+        Ref.u32Free++;
+        Ref.u32Dropped++;
+    }
+    if (!Ref.u32Free)
+    {
+        Ref.u32Dropped++;
+        return;
+    }
+    Ref.au32Seq[Ref.u32ReadyCnt] = Ref.u32Seq;
+    Ref.au32Time[Ref.u32ReadyCnt++] = Now;
+    Ref.u32Free--;
+}
+
+/* Run one call with the I-bit in a random state, it must come back as it was and be masked meanwhile */
+#define LOCKED(call)    do { BOOL b = rnd(2); IBit = b; Disables = 0; call; \
+                             CHECK(IBit == b && Disables > 0, "%s: I-bit %d, was %d, %u masks", #call, IBit, b, Disables); } while (0)
+
+/* Every buffer in exactly one place, the engine on the active one, every frame accounted for */
+static void check_queue(CAP_FQ_T *psQ, CAP_FRAME_T **apsHeld, uint32_t u32Held, uint32_t u32Taken, const char *pcStep)
+{
+    uint8_t au8Seen[CAP_FQ_DEPTH_MAX];
+    uint32_t i, j;
+
+    memset(au8Seen, 0, sizeof(au8Seen));
+    for (i = 0; i < psQ->u32FreeCnt; i++)
+    {
+        j = psQ->au8Free[(psQ->u32FreeHead + i) % psQ->u32Num];
+        au8Seen[j]++;
+        CHECK(psQ->au8State[j] == CAP_FQ_FREE, "%s: free buffer %u in state %u", pcStep, j, psQ->au8State[j]);
+    }
+    for (i = 0; i < psQ->u32ReadyCnt; i++)
+    {
+        j = psQ->au8Ready[(psQ->u32ReadyHead + i) % psQ->u32Num];
+        au8Seen[j]++;
+        CHECK(psQ->au8State[j] == CAP_FQ_READY, "%s: ready buffer %u in state %u", pcStep, j, psQ->au8State[j]);
+    }
+    for (i = 0; i < u32Held; i++)
+    {
+        au8Seen[apsHeld[i]->u32Index]++;
+        CHECK(psQ->au8State[apsHeld[i]->u32Index] == CAP_FQ_USER, "%s: held buffer %u in state %u", pcStep,
+              apsHeld[i]->u32Index, psQ->au8State[apsHeld[i]->u32Index]);
+    }
+    if (psQ->u32Active != psQ->u32Num)
+    {
+        au8Seen[psQ->u32Active]++;
+        CHECK(psQ->au8State[psQ->u32Active] == CAP_FQ_ACTIVE, "%s: active buffer in state %u", pcStep, psQ->au8State[psQ->u32Active]);
+        if (Cap.CTL & CAP_CTL_PLNEN)
+            CHECK(Cap.YBA == psQ->asFrame[psQ->u32Active].au32Addr[0] && Cap.UBA == psQ->asFrame[psQ->u32Active].au32Addr[1] &&
+                  Cap.VBA == psQ->asFrame[psQ->u32Active].au32Addr[2], "%s: engine not on buffer %u", pcStep, psQ->u32Active);
+        else
+            CHECK(Cap.PKTBA0 == psQ->asFrame[psQ->u32Active].au32Addr[0], "%s: engine not on buffer %u", pcStep, psQ->u32Active);
+    }
+    for (i = 0, j = 0; i < psQ->u32Num; i++)
+        j += (au8Seen[i] != 1);
+    CHECK(j == 0, "%s: %u buffers lost or in two places", pcStep, j);
+    CHECK((psQ->u32Active != psQ->u32Num) == Ref.u32Active && (Cap.CTL & CAP_CTL_CAPEN) == (Ref.u32Active ? CAP_CTL_CAPEN : 0),
+          "%s: active %u, CTL 0x%x", pcStep, psQ->u32Active, Cap.CTL);
+    CHECK(psQ->u32FreeCnt == Ref.u32Free && psQ->u32ReadyCnt == Ref.u32ReadyCnt && psQ->u32Dropped == Ref.u32Dropped,
+          "%s: %u free, %u ready, %u dropped, expected %u %u %u", pcStep, psQ->u32FreeCnt, psQ->u32ReadyCnt, psQ->u32Dropped,
+          Ref.u32Free, Ref.u32ReadyCnt, Ref.u32Dropped);
+    CHECK(psQ->u32Seq == u32Taken + psQ->u32ReadyCnt + psQ->u32Dropped, "%s: %u frames, %u taken, %u ready, %u dropped",
+          pcStep, psQ->u32Seq, u32Taken, psQ->u32ReadyCnt, psQ->u32Dropped);
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Tests                                                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static void test_init(void)
+{
+    CAP_FQ_T sQ;
+    uint32_t i;
+    int e = Errors;
+
+    CHECK(CAP_FQ_Init(&sQ, &Cap, BASE, 1, 100, 0, CAP_FQ_DROP_NEW) == CAP_INVALID_BUF, "one buffer");
+    CHECK(CAP_FQ_Init(&sQ, &Cap, BASE, CAP_FQ_DEPTH_MAX + 1, 100, 0, CAP_FQ_DROP_NEW) == CAP_INVALID_BUF, "%lu buffers", CAP_FQ_DEPTH_MAX + 1);
+    CHECK(CAP_FQ_Init(&sQ, &Cap, BASE + 16, 2, 100, 0, CAP_FQ_DROP_NEW) == CAP_INVALID_BUF, "buffers on 16 bytes");
+    CHECK(CAP_FQ_Init(&sQ, &Cap, BASE, 2, 0, 0, CAP_FQ_DROP_NEW) == CAP_INVALID_BUF, "empty frame");
+
+    /* 1000 + 2 * 260 bytes, 1536 apart */
+    InvAddr = InvSize = 0;
+    CHECK(CAP_FQ_Init(&sQ, &Cap, BASE, CAP_FQ_DEPTH_MAX, 1000, 260, CAP_FQ_DROP_NEW) == 0, "8 planar buffers refused");
+    CHECK(InvAddr == BASE && InvSize == CAP_FQ_DEPTH_MAX * 1536, "invalidated %u bytes at 0x%x", InvSize, InvAddr);
+    CHECK(sQ.u32Size == 1520 && sQ.u32FreeCnt == CAP_FQ_DEPTH_MAX && sQ.u32ReadyCnt == 0 && sQ.u32Active == CAP_FQ_DEPTH_MAX,
+          "size %u, %u free, %u ready, active %u", sQ.u32Size, sQ.u32FreeCnt, sQ.u32ReadyCnt, sQ.u32Active);
+    for (i = 0; i < CAP_FQ_DEPTH_MAX; i++)
+    {
+        CHECK(sQ.asFrame[i].u32Index == i && sQ.asFrame[i].au32Addr[0] == BASE + i * 1536 &&
+              sQ.asFrame[i].au32Addr[1] == BASE + i * 1536 + 1000 && sQ.asFrame[i].au32Addr[2] == BASE + i * 1536 + 1260,
+              "buffer %u at 0x%x 0x%x 0x%x", i, sQ.asFrame[i].au32Addr[0], sQ.asFrame[i].au32Addr[1], sQ.asFrame[i].au32Addr[2]);
+        CHECK(sQ.au8State[i] == CAP_FQ_FREE && sQ.au8Free[i] == i, "buffer %u not free in order", i);
+    }
+    CHECK(CAP_FQ_Dequeue(&sQ) == NULL, "frame before any capture");
+    printf("set-up: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+static void test_irq(void)
+{
+    CAP_FQ_T sQ;
+    int e = Errors;
+
+    memset(&Cap, 0, sizeof(Cap));
+    Cap.CTL = CAP_CTL_PKTEN;
+    CAP_FQ_Init(&sQ, &Cap, BASE, 2, 64, 0, CAP_FQ_DROP_NEW);
+    CAP_FQ_Start(&sQ);
+    CHECK(Cap.PKTBA0 == BASE && (Cap.CTL & (CAP_CTL_UPDATE_Msk | CAP_CTL_CAPEN)) == (CAP_CTL_UPDATE_Msk | CAP_CTL_CAPEN),
+          "packet engine at 0x%x, CTL 0x%x", Cap.PKTBA0, Cap.CTL);
+
+    /* A frame end with VIEN clear, or no frame end, is not ours */
+    Cap.INT = CAP_INT_VINTF_Msk | CAP_INT_MDINTF_Msk;
+    CHECK(CAP_FQ_IRQHandler(&sQ) == 0 && Cap.INT == (CAP_INT_VINTF_Msk | CAP_INT_MDINTF_Msk) && sQ.u32Seq == 0, "masked frame end taken");
+    Cap.INT = CAP_INT_VIEN_Msk | CAP_INT_MDINTF_Msk;
+    CHECK(CAP_FQ_IRQHandler(&sQ) == 0 && Cap.INT == (CAP_INT_VIEN_Msk | CAP_INT_MDINTF_Msk) && sQ.u32Seq == 0, "no frame end taken");
+
+    /* The write clears VINTF only: the other flags are written back as 0 */
+    Cap.INT = CAP_INT_VIEN_Msk | CAP_INT_VINTF_Msk | CAP_INT_MDINTF_Msk;
+    Cap.CTL &= ~CAP_CTL_UPDATE_Msk;
+    CHECK(CAP_FQ_IRQHandler(&sQ) == 1 && Cap.INT == (CAP_INT_VIEN_Msk | CAP_INT_VINTF_Msk), "INT written 0x%x", Cap.INT);
+    CHECK(Cap.PKTBA0 == BASE + 64 && (Cap.CTL & CAP_CTL_UPDATE_Msk), "engine at 0x%x, CTL 0x%x", Cap.PKTBA0, Cap.CTL);
+
+    /* Without a clock the frame is stamped 0 */
+    CHECK(sQ.u32ReadyCnt == 1 && sQ.asFrame[0].u32Seq == 1 && sQ.asFrame[0].u32Time == 0, "first frame %u at %u",
+          sQ.asFrame[0].u32Seq, sQ.asFrame[0].u32Time);
+    printf("frame end handler: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+static void test_random(void)
+{
+    CAP_FQ_T sQ;
+    CAP_FRAME_T *apsHeld[CAP_FQ_DEPTH_MAX], *psFrame, sStray;
+    uint32_t u32Round, u32Mode, u32Num, u32Held, u32Taken, n, i;
+    char acStep[64];
+    int e = Errors;
+
+    for (u32Round = 0; (u32Round < 200) && (Errors == e); u32Round++)
+    {
+        u32Mode = u32Round & 1 ? CAP_FQ_DROP_OLD : CAP_FQ_DROP_NEW;
+        u32Num = 2 + rnd(CAP_FQ_DEPTH_MAX - 1);
+        memset(&Cap, 0, sizeof(Cap));
+        Cap.CTL = rnd(2) ? CAP_CTL_PLNEN : CAP_CTL_PKTEN;
+        Cap.INT = CAP_INT_VIEN_Msk;
+        CAP_FQ_Init(&sQ, &Cap, BASE, u32Num, 1024, (Cap.CTL & CAP_CTL_PLNEN) ? 256 : 0, u32Mode);
+        CAP_FQ_SetClock(&sQ, clock_now);
+        memset(&Ref, 0, sizeof(Ref));
+        Ref.u32Free = u32Num;
+        u32Held = u32Taken = 0;
+
+        for (n = 0; (n < 5000) && (Errors == e); n++)
+        {
+            Now += 1 + rnd(1000);
+            switch (rnd(16))
+            {
+            case 0:
+            case 1:
+            case 2:
+            case 3:
+            case 4:
+            case 5:
+                /* VSYNC, only while the engine runs */
+                if (!(Cap.CTL & CAP_CTL_CAPEN))
+                    continue;
+                Cap.INT = CAP_INT_VIEN_Msk | CAP_INT_VINTF_Msk | CAP_INT_MDINTF_Msk;
+                Cap.CTL &= ~CAP_CTL_UPDATE_Msk;
+                i = sQ.u32FreeCnt;
+                CHECK(CAP_FQ_IRQHandler(&sQ) == 1 && Cap.INT == (CAP_INT_VIEN_Msk | CAP_INT_VINTF_Msk), "frame end, INT 0x%x", Cap.INT);
+                Cap.INT = CAP_INT_VIEN_Msk;
+                ref_frame_end(u32Mode);
+                CHECK(!!(Cap.CTL & CAP_CTL_UPDATE_Msk) == (i || ((u32Mode == CAP_FQ_DROP_OLD) && sQ.u32ReadyCnt)),
+                      "frame end with %u free, CTL 0x%x", i, Cap.CTL);
+                sprintf(acStep, "round %u step %u frame end", u32Round, n);
+                break;
+            case 6:
+            case 7:
+            case 8:
+            case 9:
+                LOCKED(psFrame = CAP_FQ_Dequeue(&sQ));
+                CHECK(!psFrame == !Ref.u32ReadyCnt, "dequeue %p with %u ready", (void *)psFrame, Ref.u32ReadyCnt);
+                if (psFrame && Ref.u32ReadyCnt)
+                {
+                    CHECK(psFrame->u32Seq == Ref.au32Seq[0] && psFrame->u32Time == Ref.au32Time[0], "frame %u at %u, expected %u at %u",
+                          psFrame->u32Seq, psFrame->u32Time, Ref.au32Seq[0], Ref.au32Time[0]);
+                    ref_pop();
+                    apsHeld[u32Held++] = psFrame;
+                    u32Taken++;
+                }
+                sprintf(acStep, "round %u step %u dequeue", u32Round, n);
+                break;
+            case 10:
+            case 11:
+            case 12:
+            case 13:
+                if (!u32Held)
+                    continue;
+                i = rnd(u32Held);
+                InvAddr = InvSize = 0;
+                LOCKED(CHECK(CAP_FQ_Queue(&sQ, apsHeld[i]) == 0, "requeue of buffer %u", apsHeld[i]->u32Index));
+                CHECK(InvAddr == apsHeld[i]->au32Addr[0] && InvSize == sQ.u32Size, "invalidated %u bytes at 0x%x", InvSize, InvAddr);
+                CHECK(CAP_FQ_Queue(&sQ, apsHeld[i]) == CAP_INVALID_BUF, "buffer %u queued twice", apsHeld[i]->u32Index);
+                apsHeld[i] = apsHeld[--u32Held];
+                Ref.u32Free++;
+                sprintf(acStep, "round %u step %u queue", u32Round, n);
+                break;
+            case 14:
+                LOCKED(CAP_FQ_Stop(&sQ));
+                if (Ref.u32Active)
+                    Ref.u32Free++;
+                Ref.u32Active = 0;
+                sprintf(acStep, "round %u step %u stop", u32Round, n);
+                break;
+            default:
+                /* A stopped queue always has the buffer it was capturing into free */
+                LOCKED(CAP_FQ_Start(&sQ));
+                if (!Ref.u32Active)
+                {
+                    Ref.u32Free--;
+                    Ref.u32Active = 1;
+                }
+                sprintf(acStep, "round %u step %u start", u32Round, n);
+                break;
+            }
+            check_queue(&sQ, apsHeld, u32Held, u32Taken, acStep);
+        }
+
+        /* Frames from elsewhere are refused */
+        sStray = sQ.asFrame[0];
+        CHECK(CAP_FQ_Queue(&sQ, &sStray) == CAP_INVALID_BUF, "a copy of a frame queued");
+        CHECK(CAP_FQ_Queue(&sQ, &sQ.asFrame[u32Num]) == CAP_INVALID_BUF || u32Num == CAP_FQ_DEPTH_MAX, "unused buffer queued");
+    }
+    printf("random capture: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+int main(void)
+{
+    test_init();
+    test_irq();
+    test_random();
+
+    printf("capfq: %s\n", Errors ? "FAIL" : "PASS");
+    return Errors != 0;
+}
@@ -0,0 +1,316 @@
+/*
+ * Host check of the FatFs sector cache, ThirdParty/FatFs/src/ffcache.c.
+ *
+ * The cache is built at the thread-safe configuration with POSIX mutexes
+ * as sync objects, and included so its pool can be inspected.
+ *
+ * - One drive, random reads, writes and syncs against a reference image.
+ *   After every request the LRU list, hash chains, dirty counts and pool
+ *   contents are checked.
+ * - Read-ahead, hit and write-back coalescing counters.
+ * - Three tasks on three drives, two of them on one shared device. Data is
+ *   checked against per-drive images. No device runs two commands at once,
+ *   no task holds the pool lock during a device command, and commands of
+ *   the two devices do overlap.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "ffcache.c"
+
+#define NSECT       256     /* Sectors per drive */
+#define NDRV        3       /* Drives 0 and 1 share device 0, drive 2 is on device 1 */
+#define NSTAGE      MAX_RUN
+
+struct host_sem {
+    pthread_mutex_t m;
+    pthread_t       owner;
+    int             held;
+};
+
+typedef struct {
+    FFC_DEV         dev;
+    volatile int    busy;
+    BYTE            stage[NSTAGE][SS];
+} HOSTDEV;
+
+static BYTE Media[NDRV][NSECT][SS];     /* Device contents */
+static BYTE Image[NDRV][NSECT][SS];     /* Data each drive must read back */
+static HOSTDEV Dev[2];
+static const int DevOf[NDRV] = { 0, 0, 1 };
+static volatile int InIo, Overlap;
+static int DelayUs;
+static int Errors;
+
+#define CHECK(c, ...)   do { if (!(c)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); Errors++; } } while (0)
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Sync objects                                                                                            */
+/*---------------------------------------------------------------------------------------------------------*/
+
+int ff_cre_syncobj(BYTE vol, _SYNC_t *sobj)
+{
+    (void)vol;
+    *sobj = calloc(1, sizeof(struct host_sem));
+    pthread_mutex_init(&(*sobj)->m, NULL);
+    return 1;
+}
+
+int ff_req_grant(_SYNC_t sobj)
+{
+    pthread_mutex_lock(&sobj->m);
+    __atomic_store_n(&sobj->owner, pthread_self(), __ATOMIC_RELAXED);
+    __atomic_store_n(&sobj->held, 1, __ATOMIC_RELAXED);
+    return 1;
+}
+
+void ff_rel_grant(_SYNC_t sobj)
+{
+    __atomic_store_n(&sobj->held, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&sobj->m);
+}
+
+int ff_del_syncobj(_SYNC_t sobj)
+{
+    pthread_mutex_destroy(&sobj->m);
+    free(sobj);
+    return 1;
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* RAM devices                                                                                             */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static int owned(_SYNC_t sobj)
+{
+    return __atomic_load_n(&sobj->held, __ATOMIC_RELAXED)
+        && pthread_equal(__atomic_load_n(&sobj->owner, __ATOMIC_RELAXED), pthread_self());
+}
+
+static DRESULT dev_io(BYTE pdrv, BYTE *rd, const BYTE *wr, DWORD sector, UINT count)
+{
+    HOSTDEV *d = &Dev[DevOf[pdrv]];
+
+    if (sector + count > NSECT) return RES_PARERR;
+    CHECK(!owned(PoolLock), "pool lock held during a device command");
+    CHECK(owned(d->dev.sobj), "device command without the device lock");
+    CHECK(__sync_fetch_and_add(&d->busy, 1) == 0, "device %d runs two commands", DevOf[pdrv]);
+    if (__sync_fetch_and_add(&InIo, 1)) __sync_fetch_and_add(&Overlap, 1);
+    if (DelayUs) usleep(DelayUs);
+    if (rd) memcpy(rd, Media[pdrv][sector], count * SS);
+    else memcpy(Media[pdrv][sector], wr, count * SS);
+    __sync_fetch_and_sub(&InIo, 1);
+    __sync_fetch_and_sub(&d->busy, 1);
+    return RES_OK;
+}
+
+static DRESULT dev_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+    return dev_io(pdrv, buff, 0, sector, count);
+}
+
+static DRESULT dev_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+    return dev_io(pdrv, 0, buff, sector, count);
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Pool invariants, single task only                                                                       */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static void check_pool(void)
+{
+    UINT n, valid, chained, dirty, drvdirty[NDRV] = { 0 };
+    WORD i, p;
+
+    for (n = 0, p = NIL, i = Head; i != NIL && n <= _FFC_SECTORS; p = i, i = Ent[i].next, n++)
+        CHECK(Ent[i].prev == p, "LRU link of entry %u", i);
+    CHECK(n == _FFC_SECTORS && p == Tail, "LRU list holds %u entries", n);
+
+    for (valid = dirty = i = 0; i < _FFC_SECTORS; i++)
+    {
+        CHECK(!(Ent[i].flag & EF_BUSY), "entry %u left busy", i);
+        if (!(Ent[i].flag & EF_VALID)) continue;
+        valid++;
+        CHECK(lookup(Ent[i].pdrv, Ent[i].sect) == i, "entry %u not found by its sector", i);
+        CHECK(memcmp(Pool[i], Image[Ent[i].pdrv][Ent[i].sect], SS) == 0, "entry %u data", i);
+        if (Ent[i].flag & EF_DIRTY)
+        {
+            dirty++;
+            drvdirty[Ent[i].pdrv]++;
+        }
+        else
+        {
+            CHECK(memcmp(Pool[i], Media[Ent[i].pdrv][Ent[i].sect], SS) == 0, "clean entry %u differs from the device", i);
+        }
+    }
+    for (chained = i = 0; i < _FFC_SECTORS; i++)
+        for (p = Hash[i]; p != NIL && chained <= _FFC_SECTORS; p = Ent[p].hnext) chained++;
+    CHECK(chained == valid, "%u entries chained, %u valid", chained, valid);
+    CHECK(dirty == NDirty && dirty <= MAX_DIRTY, "%u dirty entries, NDirty %u", dirty, NDirty);
+    for (n = 0; n < NDRV; n++)
+        CHECK(drvdirty[n] == Drive[n].ndirty, "drive %u has %u dirty entries, counted %u", n, drvdirty[n], Drive[n].ndirty);
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Random requests on one drive                                                                            */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static void fill(BYTE *p, UINT count, unsigned *seed)
+{
+    UINT k;
+
+    for (k = 0; k < count * SS; k++) p[k] = (BYTE)rand_r(seed);
+}
+
+static void run_drive(BYTE pdrv, UINT ops, unsigned seed, int check)
+{
+    static const UINT sizes[] = { 1, 1, 1, 2, 3, 4, 7, 8, 9, 16, 24 };
+    BYTE buff[24 * SS];
+    UINT op, count;
+    DWORD sector;
+    DRESULT res;
+
+    for (op = 0; op < ops; op++)
+    {
+        count = sizes[rand_r(&seed) % (sizeof(sizes) / sizeof(sizes[0]))];
+        sector = rand_r(&seed) % 4 ? (DWORD)(rand_r(&seed) % 48) : (DWORD)(rand_r(&seed) % (NSECT - count));
+        if (sector + count > NSECT) sector = NSECT - count;
+        switch (rand_r(&seed) % 20)
+        {
+        case 0:
+            res = ffc_sync(pdrv);
+            CHECK(res == RES_OK, "sync %d", res);
+            CHECK(memcmp(Media[pdrv], Image[pdrv], sizeof(Media[pdrv])) == 0, "drive %u differs after sync", pdrv);
+            break;
+        case 1: case 2: case 3: case 4: case 5: case 6: case 7: case 8:
+            fill(buff, count, &seed);
+            memcpy(Image[pdrv][sector], buff, count * SS);
+            res = ffc_write(pdrv, buff, sector, count);
+            CHECK(res == RES_OK, "write %d", res);
+            break;
+        default:
+            res = ffc_read(pdrv, buff, sector, count);
+            CHECK(res == RES_OK, "read %d", res);
+            CHECK(memcmp(buff, Image[pdrv][sector], count * SS) == 0, "drive %u read of %lu+%u", pdrv, (unsigned long)sector, count);
+            break;
+        }
+        if (check) check_pool();
+        if (Errors > 10) return;
+    }
+}
+
+static void *task(void *arg)
+{
+    BYTE pdrv = (BYTE)(size_t)arg;
+
+    run_drive(pdrv, 20000, 1000 + pdrv, 0);
+    CHECK(ffc_sync(pdrv) == RES_OK, "final sync");
+    return 0;
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Tests                                                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static void attach_all(void)
+{
+    BYTE pdrv;
+
+    for (pdrv = 0; pdrv < NDRV; pdrv++)
+    {
+        memcpy(Image[pdrv], Media[pdrv], sizeof(Media[pdrv]));
+        ffc_attach(pdrv, &Dev[DevOf[pdrv]].dev, NSECT);
+    }
+}
+
+static void test_single(void)
+{
+    run_drive(0, 20000, 1, 1);
+    run_drive(2, 5000, 2, 1);
+    CHECK(ffc_sync(0) == RES_OK && ffc_sync(2) == RES_OK, "sync");
+    CHECK(memcmp(Media, Image, sizeof(Media)) == 0, "media differ after sync");
+    check_pool();
+    printf("single drive: %s\n", Errors ? "FAIL" : "ok");
+}
+
+static void test_counters(void)
+{
+    BYTE buff[8 * SS];
+    FFC_STAT st;
+    DWORD s;
+
+    attach_all();
+    ffc_get_stat(0, &st, 1);
+    for (s = 0; s < 64; s++) ffc_read(0, buff, s, 1);
+    ffc_get_stat(0, &st, 1);
+    CHECK(st.miss + st.ahead == 64 && st.ahead >= 48 && st.rdcmd <= 8, "sequential read: miss %lu ahead %lu cmds %lu",
+          (unsigned long)st.miss, (unsigned long)st.ahead, (unsigned long)st.rdcmd);
+
+    ffc_read(0, buff, 200, 1);
+    ffc_read(0, buff, 200, 1);
+    ffc_get_stat(0, &st, 1);
+    CHECK(st.hit == 1 && st.miss == 1, "re-read: hit %lu miss %lu", (unsigned long)st.hit, (unsigned long)st.miss);
+
+    for (s = 17; s >= 10; s--)
+    {
+        memset(buff, (int)s, SS);
+        memcpy(Image[0][s], buff, SS);
+        ffc_write(0, buff, s, 1);
+    }
+    ffc_get_stat(0, &st, 1);
+    CHECK(st.wrcmd == 0, "write-behind issued %lu commands", (unsigned long)st.wrcmd);
+    ffc_sync(0);
+    ffc_get_stat(0, &st, 1);
+    CHECK(st.wrcmd == 1 && st.wrsect == 8, "write-back: %lu commands, %lu sectors", (unsigned long)st.wrcmd, (unsigned long)st.wrsect);
+    check_pool();
+    printf("counters: %s\n", Errors ? "FAIL" : "ok");
+}
+
+static void test_tasks(void)
+{
+    pthread_t th[NDRV];
+    size_t t;
+
+    attach_all();
+    DelayUs = 20;
+    for (t = 0; t < NDRV; t++) pthread_create(&th[t], 0, task, (void *)t);
+    for (t = 0; t < NDRV; t++) pthread_join(th[t], 0);
+    DelayUs = 0;
+    CHECK(memcmp(Media, Image, sizeof(Media)) == 0, "media differ after the tasks");
+    CHECK(Overlap > 0, "device commands never overlapped");
+    check_pool();
+    printf("three tasks, two devices: %s (%d overlapping commands)\n", Errors ? "FAIL" : "ok", Overlap);
+}
+
+int main(void)
+{
+    unsigned seed = 7;
+    BYTE d;
+
+    for (d = 0; d < NDRV; d++) fill(Media[d][0], NSECT, &seed);
+    for (d = 0; d < 2; d++)
+    {
+        Dev[d].dev.read = dev_read;
+        Dev[d].dev.write = dev_write;
+        Dev[d].dev.stage = Dev[d].stage[0];
+        Dev[d].dev.nstage = NSTAGE;
+    }
+    ffc_init();
+    attach_all();
+
+    test_single();
+    test_counters();
+    test_tasks();
+
+    printf("ffcache: %s\n", Errors ? "FAIL" : "PASS");
+    return Errors != 0;
+}
@@ -0,0 +1,384 @@
+/*
+ * Host check of the NOR flash translation layer, ThirdParty/FatFs/src/ffnor.c.
+ *
+ * The flash is simulated in RAM: programming can only clear bits, and a
+ * program that would set one fails the test. Sector data carries a version
+ * number, so a read tells which write it came from.
+ *
+ * - Random writes, reads, syncs and trims with remounts, and the map and
+ *   block table checked against the flash after every request.
+ * - Power cuts at random points of a program or erase, the last one torn
+ *   halfway. Between requests, a mount of a copy of the flash reads back
+ *   every programmed sector as the volume does. After the remount every
+ *   sector reads back its version of the last sync or a later one.
+ * - Wear levelling: a few hot sectors rewritten over a full drive of cold
+ *   ones keep the erase counts within reach of the wear gap, and the blocks
+ *   of cold data are erased too.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ffnor.c"
+
+#define BLKSZ       4096
+#define NBLK        64
+#define MAXSECT     (NBLK * FNOR_SLOTS(BLKSZ))
+
+static BYTE Flash[NBLK * BLKSZ];
+static DWORD Erases[NBLK];
+static long CutAfter = -1;      /* Device operations left before the power fails (-1:never) */
+static int Dead;
+static int Exact;               /* No power cut since the format, erase counts are known */
+
+static FNOR Vol;
+static FNOR_DEV Dev;
+static DWORD Work[FNOR_WORK_SIZE(NBLK, BLKSZ)];
+
+static BYTE Copy[NBLK * BLKSZ];  /* Flash contents as a power cut would leave them */
+static FNOR CopyVol;
+static FNOR_DEV CopyDev;
+static DWORD CopyWork[FNOR_WORK_SIZE(NBLK, BLKSZ)];
+
+static DWORD Cur[MAXSECT];      /* Version of the last write (0:never written) */
+static DWORD Synced[MAXSECT];   /* Version at the last sync */
+static DWORD Top[MAXSECT];      /* Newest version ever written */
+static BYTE Trimmed[MAXSECT];   /* Trimmed since the last synced write, older data may come back */
+static DWORD Version;
+static int Errors;
+
+#define CHECK(c, ...)   do { if (!(c)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); Errors++; } } while (0)
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Simulated flash                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static int power(void)
+{
+    if (Dead) return 0;
+    if (CutAfter > 0 && --CutAfter == 0) Dead = 1;
+    return 1;
+}
+
+static int nor_read(void *ctx, DWORD addr, BYTE *buff, UINT len)
+{
+    (void)ctx;
+    CHECK(addr + len <= sizeof(Flash), "read past the region");
+    memcpy(buff, Flash + addr, len);
+    return 0;
+}
+
+static int nor_program(void *ctx, DWORD addr, const BYTE *buff, UINT len)
+{
+    UINT i;
+
+    (void)ctx;
+    CHECK(addr / BLKSZ == (addr + len - 1) / BLKSZ, "program crosses a block");
+    if (!power()) return 1;
+    if (Dead) len /= 2;         /* Torn */
+    for (i = 0; i < len; i++)
+    {
+        CHECK((Flash[addr + i] & buff[i]) == buff[i], "program sets bits at %lx", (unsigned long)(addr + i));
+        Flash[addr + i] &= buff[i];
+    }
+    return Dead;
+}
+
+static int nor_erase(void *ctx, DWORD addr, DWORD len)
+{
+    (void)ctx;
+    CHECK(addr % BLKSZ == 0 && len == BLKSZ, "erase of %lx+%lx", (unsigned long)addr, (unsigned long)len);
+    if (!power()) return 1;
+    memset(Flash + addr, 0xFF, Dead ? len / 3 : len);
+    Erases[addr / BLKSZ]++;
+    return Dead;
+}
+
+
+static int copy_read(void *ctx, DWORD addr, BYTE *buff, UINT len)
+{
+    (void)ctx;
+    memcpy(buff, Copy + addr, len);
+    return 0;
+}
+
+static int copy_program(void *ctx, DWORD addr, const BYTE *buff, UINT len)
+{
+    (void)ctx;
+    while (len--) Copy[addr++] &= *buff++;
+    return 0;
+}
+
+static int copy_erase(void *ctx, DWORD addr, DWORD len)
+{
+    (void)ctx;
+    memset(Copy + addr, 0xFF, len);
+    return 0;
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Sector data and checks                                                                                  */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static void make_sector(BYTE *p, DWORD lsn, DWORD ver)
+{
+    unsigned x = (unsigned)(lsn * 7919 + ver);
+    UINT i;
+
+    st_dword(p, ver);
+    st_dword(p + 4, lsn);
+    for (i = 8; i < SS; i++)
+    {
+        x = x * 1103515245 + 12345;
+        p[i] = (BYTE)(x >> 16);
+    }
+}
+
+static DWORD sector_version(const BYTE *p, DWORD lsn)  /* Version of a sector, NONE if it is not one */
+{
+    BYTE ref[SS];
+    UINT i;
+
+    for (i = 0; i < SS && p[i] == 0xFF; i++) ;
+    if (i == SS) return 0;
+    make_sector(ref, lsn, ld_dword(p));
+    return memcmp(p, ref, SS) ? NONE : ld_dword(p);
+}
+
+static void check_volume(void)
+{
+    DWORD b, i, p, nfree = 0, valid[NBLK] = { 0 };
+
+    for (i = 0; i < Vol.nsect; i++)
+    {
+        if ((p = Vol.map[i]) == NONE) continue;
+        CHECK(p / Vol.nslot < NBLK && Vol.blk[p / Vol.nslot].state >= BS_OPEN, "sector %lu maps to a free block", (unsigned long)i);
+        valid[p / Vol.nslot]++;
+    }
+    for (b = 0; b < NBLK; b++)
+    {
+        CHECK(valid[b] == Vol.blk[b].valid, "block %lu counts %u live sectors, map has %lu", (unsigned long)b, Vol.blk[b].valid, (unsigned long)valid[b]);
+        if (Vol.blk[b].state <= BS_DIRTY) nfree++;
+        if (Vol.blk[b].state == BS_FREE) CHECK(is_blank(&Vol, b, FNOR_HDR_SIZE, BLKSZ - FNOR_HDR_SIZE), "free block %lu not blank", (unsigned long)b);
+        CHECK(!Exact || Vol.blk[b].ec == Erases[b], "block %lu erase count %lu, erased %lu times", (unsigned long)b, (unsigned long)Vol.blk[b].ec, (unsigned long)Erases[b]);
+    }
+    CHECK(nfree == Vol.nfree, "%lu free blocks, counted %lu", (unsigned long)nfree, (unsigned long)Vol.nfree);
+}
+
+static void check_durable(void)    /* A power cut now keeps every programmed sector */
+{
+    BYTE b1[SS], b2[SS];
+    DWORD i;
+
+    memcpy(Copy, Flash, sizeof(Copy));
+    CHECK(fnor_mount(&CopyVol, &CopyDev, CopyWork) == RES_OK, "mount of a copy");
+    for (i = 0; i < Vol.nsect && !Errors; i++)
+    {
+        if (Vol.map[i] == NONE || find_held(&Vol, i) < Vol.nw) continue;   /* Trimmed or not programmed yet */
+        fnor_read(&Vol, b1, i, 1);
+        fnor_read(&CopyVol, b2, i, 1);
+        CHECK(memcmp(b1, b2, SS) == 0, "sector %lu reads version %lu, a remount would give %lu", (unsigned long)i,
+              (unsigned long)ld_dword(b1), (unsigned long)ld_dword(b2));
+    }
+}
+
+static void remount(int cut)
+{
+    BYTE buff[SS];
+    DWORD i, v;
+
+    Dead = 0;
+    CutAfter = -1;
+    memset(&Vol, 0xA5, sizeof(Vol));
+    CHECK(fnor_mount(&Vol, &Dev, Work) == RES_OK, "mount");
+    check_volume();
+    for (i = 0; i < Vol.nsect; i++)
+    {
+        CHECK(fnor_read(&Vol, buff, i, 1) == RES_OK, "read");
+        v = sector_version(buff, i);
+        if (cut)
+            CHECK(v != NONE && ((v >= Synced[i] && v <= Cur[i]) || (Trimmed[i] && v <= Top[i])),
+                  "sector %lu reads version %ld after a power cut, synced %lu last %lu", (unsigned long)i, (long)v, (unsigned long)Synced[i], (unsigned long)Cur[i]);
+        else
+            CHECK(v == Cur[i] || (Trimmed[i] && v != NONE && v <= Top[i]), "sector %lu reads version %ld, wrote %lu", (unsigned long)i, (long)v, (unsigned long)Cur[i]);
+        if (v != NONE) Cur[i] = Synced[i] = v;
+    }
+}
+
+static void format(void)
+{
+    memset(Flash, 0xFF, sizeof(Flash));
+    memset(Erases, 0, sizeof(Erases));
+    memset(Cur, 0, sizeof(Cur));
+    memset(Synced, 0, sizeof(Synced));
+    memset(Top, 0, sizeof(Top));
+    memset(Trimmed, 0, sizeof(Trimmed));
+    Exact = 1;
+    remount(0);
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Requests                                                                                                */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static DRESULT do_write(DWORD lsn, UINT count)
+{
+    static BYTE buff[16 * SS];
+    UINT k;
+
+    for (k = 0; k < count; k++)
+    {
+        Cur[lsn + k] = Top[lsn + k] = ++Version;
+        make_sector(buff + k * SS, lsn + k, Version);
+    }
+    return fnor_write(&Vol, buff, lsn, count);
+}
+
+static DRESULT do_sync(void)
+{
+    DRESULT res = fnor_ioctl(&Vol, CTRL_SYNC, 0);
+    DWORD i;
+
+    if (res == RES_OK)
+    {
+        for (i = 0; i < Vol.nsect; i++)
+        {
+            if (Cur[i] && Cur[i] != Synced[i]) Trimmed[i] = 0;
+            Synced[i] = Cur[i];
+        }
+    }
+    return res;
+}
+
+static int random_ops(unsigned *seed, long ops, int cut)
+{
+    BYTE buff[16 * SS];
+    DWORD lsn, range[2], i;
+    UINT count, k;
+    DRESULT res;
+    long op;
+
+    for (op = 0; op < ops && !Errors; op++)
+    {
+        count = 1 + rand_r(seed) % (rand_r(seed) % 4 ? 2U : 16U);
+        lsn = rand_r(seed) % 3 ? (DWORD)(rand_r(seed) % 40) : rand_r(seed) % Vol.nsect;
+        if (lsn + count > Vol.nsect) lsn = Vol.nsect - count;
+        switch (rand_r(seed) % 16)
+        {
+        case 0:
+            res = do_sync();
+            break;
+        case 1:
+            range[0] = lsn;
+            range[1] = lsn + count - 1;
+            for (i = range[0]; i <= range[1]; i++) Trimmed[i] = 1;   /* Even if it fails */
+            res = fnor_ioctl(&Vol, CTRL_TRIM, range);
+            for (i = range[0]; res == RES_OK && i <= range[1]; i++) Cur[i] = 0;
+            break;
+        case 2: case 3: case 4: case 5: case 6: case 7: case 8: case 9:
+            res = do_write(lsn, count);
+            break;
+        default:
+            res = fnor_read(&Vol, buff, lsn, count);
+            for (k = 0; res == RES_OK && k < count; k++)
+                CHECK(sector_version(buff + k * SS, lsn + k) == Cur[lsn + k], "sector %lu reads version %ld, wrote %lu",
+                      (unsigned long)(lsn + k), (long)sector_version(buff + k * SS, lsn + k), (unsigned long)Cur[lsn + k]);
+            break;
+        }
+        if (res != RES_OK)
+        {
+            CHECK(cut && Dead, "request failed with %d", res);
+            return 1;
+        }
+        if (!cut) check_volume();
+        else check_durable();
+    }
+    return 0;
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Tests                                                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static void test_random(void)
+{
+    unsigned seed = 1;
+    int round;
+
+    format();
+    for (round = 0; round < 40 && !Errors; round++)
+    {
+        random_ops(&seed, 2000, 0);
+        CHECK(do_sync() == RES_OK, "sync");
+        remount(0);
+    }
+    printf("random requests and remounts: %s\n", Errors ? "FAIL" : "ok");
+}
+
+static void test_power_cut(void)
+{
+    unsigned seed = 2;
+    int round, cuts = 0;
+
+    format();
+    Exact = 0;
+    for (round = 0; round < 400 && !Errors; round++)
+    {
+        CutAfter = 1 + rand_r(&seed) % 300;
+        if (random_ops(&seed, 100000, 1)) cuts++;
+        remount(1);
+    }
+    CHECK(cuts > 300, "only %d power cuts hit a request", cuts);
+    printf("power cuts: %s (%d)\n", Errors ? "FAIL" : "ok", cuts);
+}
+
+static void test_wear(void)
+{
+    FNOR_STAT st;
+    unsigned seed = 3;
+    DWORD lsn;
+    long n;
+
+    format();
+    for (lsn = 0; lsn < Vol.nsect; lsn++) do_write(lsn, 1);
+    do_sync();
+    for (n = 0; n < 400000 && !Errors; n++)
+    {
+        CHECK(do_write(rand_r(&seed) % 8, 1) == RES_OK, "hot write");
+        if (n % 64 == 0) do_sync();
+    }
+    do_sync();
+    fnor_get_stat(&Vol, &st, 0);
+    CHECK(st.ecmax - st.ecmin <= 2 * _FNOR_WEAR_GAP, "erase counts %lu..%lu", (unsigned long)st.ecmin, (unsigned long)st.ecmax);
+    CHECK(st.ecmin > 0, "blocks of cold data never erased");
+    remount(0);
+    fnor_get_stat(&Vol, &st, 0);
+    CHECK(st.ecmax - st.ecmin <= 2 * _FNOR_WEAR_GAP, "erase counts after a remount %lu..%lu", (unsigned long)st.ecmin, (unsigned long)st.ecmax);
+    printf("wear levelling: %s (erase counts %lu..%lu, gap %d)\n", Errors ? "FAIL" : "ok",
+           (unsigned long)st.ecmin, (unsigned long)st.ecmax, _FNOR_WEAR_GAP);
+}
+
+int main(void)
+{
+    Dev.read = nor_read;
+    Dev.program = nor_program;
+    Dev.erase = nor_erase;
+    Dev.base = 0;
+    Dev.nblk = NBLK;
+    Dev.blksz = BLKSZ;
+    CopyDev = Dev;
+    CopyDev.read = copy_read;
+    CopyDev.program = copy_program;
+    CopyDev.erase = copy_erase;
+
+    test_random();
+    test_power_cut();
+    test_wear();
+
+    printf("ffnor: %s\n", Errors ? "FAIL" : "PASS");
+    return Errors != 0;
+}
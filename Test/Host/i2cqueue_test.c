@@ -0,0 +1,816 @@
+/*
+ * Host check of the I2C transaction queue, Driver/Source/i2cqueue.c.
+ *
+ * The register blocks of I2C0 to I2C3 are host memory mapped at their
+ * addresses, and the queue runs on I2C1. I2C_SET_CONTROL_REG() hands each
+ * control write to a model of the master controller and the bus: it takes
+ * STA, STO, SI and AA as the controller does, moves DAT between the
+ * controller and the slaves, and raises the next master status in STATUS0
+ * with SI set, calling the interrupt handler the queue installed. The
+ * status codes are 0x08 and 0x10 for a START, 0x18/0x20 and 0x40/0x48 for
+ * an acknowledged or refused address, 0x28/0x30 for written data, 0x50/0x58
+ * for read data, 0x38 for a lost arbitration and 0x00 for a bus error.
+ *
+ * Slave 0x50 is an EEPROM with a one-byte address pointer, slave 0x3C a
+ * sensor that takes anything. The bus is logged as "S", "Sr" and "P" for
+ * START, repeated START and STOP, "E" for a bus error and "X" for a
+ * controller reset, and each byte in hex, followed by "N" when not
+ * acknowledged or by "L" when arbitration was lost on it.
+ *
+ * - Descriptors I2C_QueueSubmit() refuses.
+ * - A register read, a zero-length write and messages merged by
+ *   I2C_MSG_NOSTART.
+ * - A not acknowledged address retried, a lost arbitration retried, and the
+ *   errors once the retries run out; a not acknowledged data byte is not
+ *   retried.
+ * - A refused read address in the middle of a transaction starts it over
+ *   from message 0.
+ * - Register tables, each entry with its own retries.
+ * - Callbacks that submit to the queue, after the transaction that just
+ *   emptied it, or behind one the task queued.
+ * - A bus error and a time-out reset the controller and the next
+ *   transaction starts, a bus event with nothing queued ends with a STOP,
+ *   and I2C_QueueClose() aborts the rest.
+ * - Random reads, writes and tables against the EEPROM, with random refused
+ *   addresses and lost arbitrations, against a reference copy.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <sys/mman.h>
+
+#include "i2c.h"
+#include "sys.h"
+
+static void host_ctl(I2C_T *i2c, uint32_t u32Ctl);
+
+#undef I2C_SET_CONTROL_REG
+#define I2C_SET_CONTROL_REG(i2c, u8Ctrl)    host_ctl((i2c), (u8Ctrl))
+
+#include "i2cqueue.c"
+
+static int Errors;
+
+#define CHECK(c, ...)   do { if (!(c)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); Errors++; } } while (0)
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Driver functions i2cqueue.c calls                                                                       */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static PVOID Isr[64];
+static uint8_t Masked[64];
+
+PVOID sysInstallISR(INT32 nIntTypeLevel, IRQn_Type eIntNo, PVOID pvNewISR)
+{
+    (void)nIntTypeLevel;
+    Isr[eIntNo] = pvNewISR;
+    return 0;
+}
+
+INT32 sysSetLocalInterrupt(INT32 nIntState)
+{
+    (void)nIntState;
+    return 0;
+}
+
+INT32 sysEnableInterrupt(IRQn_Type eIntNo)
+{
+    Masked[eIntNo] = 0;
+    return 0;
+}
+
+INT32 sysDisableInterrupt(IRQn_Type eIntNo)
+{
+    Masked[eIntNo] = 1;
+    return 0;
+}
+
+static void bus_reset(void);
+
+void I2C_Close(I2C_T *i2c)
+{
+    i2c->CTL0 = 0;
+    i2c->CLKDIV = 0;
+    i2c->TOCTL = 0;
+    bus_reset();
+}
+
+void I2C_EnableInt(I2C_T *i2c)
+{
+    i2c->CTL0 |= I2C_CTL0_INTEN_Msk;
+}
+
+void I2C_ClearTimeoutFlag(I2C_T *i2c)
+{
+    i2c->TOCTL &= ~I2C_TOCTL_TOIF_Msk;
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Controller, bus and slaves                                                                              */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#define BUS_FREE    0       /* No START, or arbitration lost */
+#define BUS_START   1       /* START sent, the address is next */
+#define BUS_TX      2       /* Writing to the slave */
+#define BUS_RX      3       /* Reading from the slave */
+#define BUS_WAIT    4       /* Refused or last byte read, STOP or START is next */
+
+static I2C_QUEUE_T Queue;
+
+static uint32_t State;
+static uint32_t Pending, PendingCtl;
+
+/* Address phases from now on that are refused or lose arbitration, bit 0 first */
+static uint32_t NackMask, ArbMask;
+/* Data byte from now on that is refused, bus step that fails with a bus error or stalls, 1 first */
+static uint32_t DataNack, ErrorIn, StallIn;
+
+static struct
+{
+    uint8_t  u8Addr;
+    uint8_t  u8Ptr;
+    uint8_t  u8First;
+    uint8_t  au8Mem[256];
+} Slave[2], *Addressed;
+
+static char Log[4096];
+static uint32_t LogLen;
+
+static void log_add(const char *pcFmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, pcFmt);
+    if (LogLen < sizeof(Log))
+        LogLen += vsnprintf(Log + LogLen, sizeof(Log) - LogLen, pcFmt, ap);
+    va_end(ap);
+}
+
+static const char *log_get(void)
+{
+    return LogLen ? Log + 1 : "";
+}
+
+static void log_clear(void)
+{
+    LogLen = 0;
+    Log[0] = '\0';
+}
+
+static void bus_reset(void)
+{
+    State = BUS_FREE;
+    Addressed = NULL;
+    Pending = 0;
+    log_add(" X");
+}
+
+static void bus_event(uint32_t u32Status)
+{
+    I2C1->STATUS0 = u32Status;
+    I2C1->CTL0 |= I2C_CTL0_SI_Msk;
+    ((void (*)(void))Isr[IRQ_I2C1])();
+    CHECK(!(I2C1->CTL0 & I2C_CTL0_SI_Msk), "status 0x%02x left SI set, bus: %s", u32Status, log_get());
+}
+
+/* The controller acting on one control write */
+static void bus_step(uint32_t u32Ctl)
+{
+    uint32_t u32Byte, i;
+
+    if (u32Ctl & I2C_CTL_STO)
+    {
+        CHECK(State != BUS_FREE, "STOP on a free bus: %s", log_get());
+        log_add(" P");
+        State = BUS_FREE;
+        Addressed = NULL;
+    }
+    if (u32Ctl & I2C_CTL_STA)
+    {
+        log_add(State == BUS_FREE ? " S" : " Sr");
+        u32Byte = (State == BUS_FREE) ? 0x08 : 0x10;
+        State = BUS_START;
+        bus_event(u32Byte);
+        return;
+    }
+    if ((u32Ctl & I2C_CTL_STO) || (State == BUS_FREE))
+        return;
+
+    if (StallIn && (--StallIn == 0))
+        return;
+    if (ErrorIn && (--ErrorIn == 0))
+    {
+        log_add(" E");
+        State = BUS_FREE;
+        bus_event(0x00);
+        return;
+    }
+
+    u32Byte = I2C1->DAT & 0xFF;
+    switch (State)
+    {
+    case BUS_START:
+        if (ArbMask & 1)
+        {
+            NackMask >>= 1;
+            ArbMask >>= 1;
+            log_add(" %02xL", u32Byte);
+            State = BUS_FREE;
+            bus_event(0x38);
+            return;
+        }
+        for (i = 0, Addressed = NULL; i < 2; i++)
+            if (Slave[i].u8Addr == (u32Byte >> 1))
+                Addressed = &Slave[i];
+        if ((NackMask & 1) || (Addressed == NULL))
+        {
+            NackMask >>= 1;
+            ArbMask >>= 1;
+            log_add(" %02xN", u32Byte);
+            State = BUS_WAIT;
+            bus_event((u32Byte & 1) ? 0x48 : 0x20);
+            return;
+        }
+        NackMask >>= 1;
+        ArbMask >>= 1;
+        log_add(" %02x", u32Byte);
+        Addressed->u8First = 1;
+        State = (u32Byte & 1) ? BUS_RX : BUS_TX;
+        bus_event((u32Byte & 1) ? 0x40 : 0x18);
+        break;
+    case BUS_TX:
+        if (DataNack && (--DataNack == 0))
+        {
+            log_add(" %02xN", u32Byte);
+            State = BUS_WAIT;
+            bus_event(0x30);
+            return;
+        }
+        log_add(" %02x", u32Byte);
+        if (Addressed->u8First)
+            Addressed->u8Ptr = (uint8_t)u32Byte;
+        else
+            Addressed->au8Mem[Addressed->u8Ptr++] = (uint8_t)u32Byte;
+        Addressed->u8First = 0;
+        bus_event(0x28);
+        break;
+    case BUS_RX:
+        I2C1->DAT = Addressed->au8Mem[Addressed->u8Ptr++];
+        log_add((u32Ctl & I2C_CTL_AA) ? " %02x" : " %02xN", I2C1->DAT);
+        if (!(u32Ctl & I2C_CTL_AA))
+            State = BUS_WAIT;
+        bus_event((u32Ctl & I2C_CTL_AA) ? 0x50 : 0x58);
+        break;
+    default:
+        CHECK(0, "SI alone after a refusal or the last byte: %s", log_get());
+        break;
+    }
+}
+
+/* The driver's I2C_SET_CONTROL_REG() */
+static void host_ctl(I2C_T *i2c, uint32_t u32Ctl)
+{
+    CHECK(i2c == I2C1, "control write to another controller");
+    CHECK((u32Ctl & I2C_CTL_SI) || !(i2c->CTL0 & I2C_CTL0_SI_Msk), "control 0x%02x leaves SI set: %s", u32Ctl, log_get());
+    CHECK(!Pending, "control 0x%02x written over 0x%02x: %s", u32Ctl, PendingCtl, log_get());
+    i2c->CTL0 = (i2c->CTL0 & ~0x3c) | (u32Ctl & I2C_CTL_AA);
+    Pending = 1;
+    PendingCtl = u32Ctl;
+}
+
+/* Let the bus run until the controller waits for nothing */
+static void bus_run(void)
+{
+    uint32_t n;
+
+    for (n = 0; Pending; n++)
+    {
+        if (n == 100000)
+        {
+            CHECK(0, "bus never idle: %s", log_get());
+            break;
+        }
+        Pending = 0;
+        bus_step(PendingCtl);
+    }
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Tests                                                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static unsigned Seed = 1;
+
+static uint32_t rnd(uint32_t n)
+{
+    return (uint32_t)rand_r(&Seed) % n;
+}
+
+static I2C_XFER_T *Done[16];
+static uint32_t DoneCnt;
+
+static void note_done(I2C_XFER_T *psXfer)
+{
+    if (DoneCnt < 16)
+        Done[DoneCnt] = psXfer;
+    DoneCnt++;
+}
+
+/* Submit, run the bus and compare the log */
+static int32_t run(I2C_XFER_T *psXfer, const char *pcExpect)
+{
+    log_clear();
+    CHECK(I2C_QueueSubmit(&Queue, psXfer) == I2C_XFER_OK, "submit refused");
+    CHECK(!Masked[IRQ_I2C1], "I2C interrupt left masked");
+    bus_run();
+    CHECK(psXfer->i32Status <= 0, "status %d after the bus stopped", psXfer->i32Status);
+    if (pcExpect != NULL)
+        CHECK(strcmp(log_get(), pcExpect) == 0, "bus\n  %s\nexpected\n  %s", log_get(), pcExpect);
+    CHECK(Queue.psHead == NULL && Queue.psTail == NULL && !(I2C1->TOCTL & I2C_TOCTL_TOCEN_Msk), "queue not idle");
+    return psXfer->i32Status;
+}
+
+static void test_open(void)
+{
+    I2C_QUEUE_T sOther;
+    I2C_XFER_T sXfer;
+    I2C_MSG_T asMsg[3];
+    I2C_REG_T sReg = { 1, 2 };
+    uint8_t au8Buf[4];
+    int e = Errors;
+
+    CHECK(I2C_QueueOpen(&sOther, (I2C_T *)0xB0084000, 0) == I2C_XFER_ERR_PARAM, "queue on no controller");
+    I2C1->CTL0 = I2C_CTL0_I2CEN_Msk;
+    I2C1->CLKDIV = 0x3B;
+    CHECK(I2C_QueueOpen(&Queue, I2C1, 1) == I2C_XFER_OK, "open refused");
+    CHECK(Isr[IRQ_I2C1] != NULL && !Masked[IRQ_I2C1] && (I2C1->CTL0 & I2C_CTL0_INTEN_Msk), "interrupt not set up");
+    CHECK(Queue.u32TimeoutCtl == (I2C_TOCTL_TOCEN_Msk | I2C_TOCTL_TOCDIV4_Msk), "TOCTL 0x%x", Queue.u32TimeoutCtl);
+
+    memset(asMsg, 0, sizeof(asMsg));
+    asMsg[0].u8Addr = asMsg[1].u8Addr = asMsg[2].u8Addr = 0x50;
+    asMsg[0].pu8Buf = asMsg[1].pu8Buf = asMsg[2].pu8Buf = au8Buf;
+    asMsg[0].u16Len = asMsg[1].u16Len = asMsg[2].u16Len = 1;
+    I2C_XferInit(&sXfer, asMsg, 0);
+    CHECK(I2C_QueueSubmit(&Queue, &sXfer) == I2C_XFER_ERR_PARAM, "no message");
+    I2C_XferInit(&sXfer, asMsg, 2);
+    asMsg[0].u8Flags = I2C_MSG_NOSTART;
+    CHECK(I2C_QueueSubmit(&Queue, &sXfer) == I2C_XFER_ERR_PARAM, "NOSTART first");
+    asMsg[0].u8Flags = 0;
+    asMsg[1].u8Flags = I2C_MSG_READ;
+    asMsg[1].u16Len = 0;
+    CHECK(I2C_QueueSubmit(&Queue, &sXfer) == I2C_XFER_ERR_PARAM, "empty read");
+    asMsg[1].u16Len = 1;
+    asMsg[1].u8Flags = I2C_MSG_READ | I2C_MSG_NOSTART;
+    CHECK(I2C_QueueSubmit(&Queue, &sXfer) == I2C_XFER_ERR_PARAM, "NOSTART read");
+    asMsg[1].u8Flags = I2C_MSG_READ;
+    asMsg[2].u8Flags = I2C_MSG_NOSTART;
+    I2C_XferInit(&sXfer, asMsg, 3);
+    CHECK(I2C_QueueSubmit(&Queue, &sXfer) == I2C_XFER_ERR_PARAM, "NOSTART after a read");
+    I2C_XferInitRegTable(&sXfer, 0x3C, &sReg, 1, 3, 1);
+    CHECK(I2C_QueueSubmit(&Queue, &sXfer) == I2C_XFER_ERR_PARAM, "3 register bytes");
+    I2C_XferInitRegTable(&sXfer, 0x3C, &sReg, 1, 1, 0);
+    CHECK(I2C_QueueSubmit(&Queue, &sXfer) == I2C_XFER_ERR_PARAM, "no value bytes");
+    I2C_XferInitRegTable(&sXfer, 0x3C, &sReg, 0, 1, 1);
+    CHECK(I2C_QueueSubmit(&Queue, &sXfer) == I2C_XFER_ERR_PARAM, "empty table");
+    CHECK(!Pending && Queue.psHead == NULL, "refused descriptor queued");
+    printf("open and parameters: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+static void test_messages(void)
+{
+    I2C_XFER_T sXfer;
+    I2C_MSG_T asMsg[5];
+    uint8_t au8Ptr[1] = { 0x10 }, au8Data[4] = { 1, 2, 3, 4 }, au8In[4];
+    int e = Errors;
+
+    memcpy(Slave[0].au8Mem + 0x10, "\x11\x22\x33", 3);
+
+    /* Register read: write the pointer, repeated START, read with the last byte not acknowledged */
+    memset(asMsg, 0, sizeof(asMsg));
+    asMsg[0].u8Addr = 0x50;
+    asMsg[0].u16Len = 1;
+    asMsg[0].pu8Buf = au8Ptr;
+    asMsg[1].u8Addr = 0x50;
+    asMsg[1].u8Flags = I2C_MSG_READ;
+    asMsg[1].u16Len = 3;
+    asMsg[1].pu8Buf = au8In;
+    I2C_XferInit(&sXfer, asMsg, 2);
+    CHECK(run(&sXfer, "S a0 10 Sr a1 11 22 33N P") == I2C_XFER_OK && sXfer.u32Done == 2, "register read");
+    CHECK(memcmp(au8In, "\x11\x22\x33", 3) == 0, "read %02x %02x %02x", au8In[0], au8In[1], au8In[2]);
+
+    /* One byte read: SLA+R acknowledged with AA clear */
+    asMsg[1].u16Len = 1;
+    CHECK(run(&sXfer, "S a0 10 Sr a1 11N P") == I2C_XFER_OK, "one byte read");
+
+    /* A zero-length write only addresses the slave */
+    asMsg[0].u16Len = 0;
+    I2C_XferInit(&sXfer, asMsg, 1);
+    CHECK(run(&sXfer, "S a0 P") == I2C_XFER_OK, "address probe");
+
+    /* NOSTART messages carry on the same write, empty ones included */
+    asMsg[0].u16Len = 1;
+    au8Ptr[0] = 0x20;
+    asMsg[1].u8Flags = I2C_MSG_NOSTART;
+    asMsg[1].u16Len = 2;
+    asMsg[1].pu8Buf = au8Data;
+    asMsg[2] = asMsg[1];
+    asMsg[2].u16Len = 0;
+    asMsg[3] = asMsg[1];
+    asMsg[3].u16Len = 1;
+    asMsg[3].pu8Buf = au8Data + 2;
+    asMsg[4].u8Addr = 0x50;
+    asMsg[4].u8Flags = I2C_MSG_READ;
+    asMsg[4].u16Len = 2;
+    asMsg[4].pu8Buf = au8In;
+    I2C_XferInit(&sXfer, asMsg, 5);
+    CHECK(run(&sXfer, "S a0 20 01 02 03 Sr a1 00 00N P") == I2C_XFER_OK && sXfer.u32Done == 5, "NOSTART merge");
+    CHECK(memcmp(Slave[0].au8Mem + 0x20, "\x01\x02\x03", 3) == 0, "EEPROM not written");
+
+    /* An empty first message merged with the next */
+    asMsg[0].u16Len = 0;
+    au8Data[0] = 0x30;
+    au8Data[1] = 0x09;
+    I2C_XferInit(&sXfer, asMsg, 2);
+    CHECK(run(&sXfer, "S a0 30 09 P") == I2C_XFER_OK && Slave[0].au8Mem[0x30] == 9, "empty message merged");
+
+    /* A NOSTART write ending the transaction after a read's repeated START */
+    asMsg[0].u16Len = 1;
+    au8Ptr[0] = 0x10;
+    asMsg[1] = asMsg[4];
+    asMsg[1].u16Len = 1;
+    asMsg[2].u8Addr = 0x3C;
+    asMsg[2].u8Flags = 0;
+    asMsg[2].u16Len = 2;
+    asMsg[2].pu8Buf = au8Data;
+    asMsg[3].u8Addr = 0x3C;
+    asMsg[3].u8Flags = I2C_MSG_NOSTART;
+    asMsg[3].u16Len = 1;
+    asMsg[3].pu8Buf = au8Data + 3;
+    I2C_XferInit(&sXfer, asMsg, 4);
+    CHECK(run(&sXfer, "S a0 10 Sr a1 11N Sr 78 30 09 04 P") == I2C_XFER_OK, "read then merged write");
+    printf("messages: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+static void test_retry(void)
+{
+    I2C_XFER_T sXfer;
+    I2C_MSG_T asMsg[3];
+    uint8_t au8Out[3] = { 0x40, 0x55, 0x66 }, au8In[2];
+    uint32_t u32Nacks = Queue.u32Nacks, u32Arb = Queue.u32ArbLost, u32Retries = Queue.u32Retries;
+    int e = Errors;
+
+    memset(asMsg, 0, sizeof(asMsg));
+    asMsg[0].u8Addr = 0x50;
+    asMsg[0].u16Len = 1;
+    asMsg[0].pu8Buf = au8Out;
+    I2C_XferInit(&sXfer, asMsg, 1);
+
+    /* An EEPROM busy with its write cycle refuses its address twice */
+    sXfer.u32Retries = 2;
+    NackMask = 3;
+    CHECK(run(&sXfer, "S a0N P S a0N P S a0 40 P") == I2C_XFER_OK && sXfer.u32Tries == 2, "address retried");
+    sXfer.u32Retries = 1;
+    NackMask = 3;
+    CHECK(run(&sXfer, "S a0N P S a0N P") == I2C_XFER_ERR_NACK && sXfer.u32Done == 0, "retries not bounded");
+    asMsg[0].u8Addr = 0x51;
+    sXfer.u32Retries = 0;
+    CHECK(run(&sXfer, "S a2N P") == I2C_XFER_ERR_NACK, "no slave");
+    asMsg[0].u8Addr = 0x50;
+
+    /* Arbitration lost: the bus is released, START again without a STOP */
+    sXfer.u32Retries = 1;
+    ArbMask = 1;
+    CHECK(run(&sXfer, "S a0L S a0 40 P") == I2C_XFER_OK, "arbitration retried");
+    ArbMask = 3;
+    CHECK(run(&sXfer, "S a0L S a0L") == I2C_XFER_ERR_ARB, "arbitration lost twice");
+    CHECK(Queue.u32Nacks - u32Nacks == 5 && Queue.u32ArbLost - u32Arb == 3 && Queue.u32Retries - u32Retries == 5,
+          "%u NACKs, %u arbitrations, %u retries", Queue.u32Nacks - u32Nacks, Queue.u32ArbLost - u32Arb, Queue.u32Retries - u32Retries);
+
+    /* Refused data ends the transaction, there is no telling what the slave took */
+    asMsg[0].u16Len = 3;
+    DataNack = 2;
+    CHECK(run(&sXfer, "S a0 40 55N P") == I2C_XFER_ERR_NACK && sXfer.u32Tries == 0, "data NACK retried");
+
+    /* Refused SLA+R of the second message: STOP, and the transaction starts over from message 0 */
+    memcpy(Slave[0].au8Mem + 0x40, "\x5A\xA5", 2);
+    asMsg[0].u16Len = 1;
+    asMsg[1].u8Addr = 0x50;
+    asMsg[1].u8Flags = I2C_MSG_READ;
+    asMsg[1].u16Len = 2;
+    asMsg[1].pu8Buf = au8In;
+    I2C_XferInit(&sXfer, asMsg, 2);
+    sXfer.u32Retries = 1;
+    NackMask = 2;
+    CHECK(run(&sXfer, "S a0 40 Sr a1N P S a0 40 Sr a1 5a a5N P") == I2C_XFER_OK && sXfer.u32Done == 2, "0x48 restart");
+    CHECK(au8In[0] == 0x5A && au8In[1] == 0xA5, "read %02x %02x after the restart", au8In[0], au8In[1]);
+
+    /* The same with bytes already read: they are read again */
+    asMsg[2].u8Addr = 0x3C;
+    asMsg[2].u16Len = 1;
+    asMsg[2].pu8Buf = au8Out + 1;
+    I2C_XferInit(&sXfer, asMsg, 3);
+    sXfer.u32Retries = 1;
+    NackMask = 4;
+    memset(au8In, 0, sizeof(au8In));
+    CHECK(run(&sXfer, "S a0 40 Sr a1 5a a5N Sr 78N P S a0 40 Sr a1 5a a5N Sr 78 55 P") == I2C_XFER_OK && sXfer.u32Done == 3,
+          "third message refused");
+    NackMask = 0x12;
+    CHECK(run(&sXfer, "S a0 40 Sr a1N P S a0 40 Sr a1 5a a5N Sr 78N P") == I2C_XFER_ERR_NACK && sXfer.u32Done == 2,
+          "retries shared by the messages");
+    printf("retries: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+static void test_table(void)
+{
+    static const I2C_REG_T asReg[3] = { { 0x3012, 0x45 }, { 0x3013, 0x46 }, { 0x3014, 0x47 } };
+    static const I2C_REG_T asWide[2] = { { 0x05, 0xBEEF }, { 0x06, 0x0102 } };
+    I2C_XFER_T sXfer;
+    int e = Errors;
+
+    I2C_XferInitRegTable(&sXfer, 0x3C, asReg, 3, 2, 1);
+    CHECK(run(&sXfer, "S 78 30 12 45 P S 78 30 13 46 P S 78 30 14 47 P") == I2C_XFER_OK && sXfer.u32Done == 3, "table");
+
+    /* One retry for each entry */
+    sXfer.u32Retries = 1;
+    NackMask = 0x5;
+    CHECK(run(&sXfer, "S 78N P S 78 30 12 45 P S 78N P S 78 30 13 46 P S 78 30 14 47 P") == I2C_XFER_OK, "retry per entry");
+    NackMask = 0xD;
+    CHECK(run(&sXfer, "S 78N P S 78 30 12 45 P S 78N P S 78N P") == I2C_XFER_ERR_NACK && sXfer.u32Done == 1,
+          "entry 1 tried %u times", sXfer.u32Tries + 1);
+    ArbMask = 0x2;
+    NackMask = 0x1;
+    CHECK(run(&sXfer, "S 78N P S 78L") == I2C_XFER_ERR_ARB && sXfer.u32Done == 0, "retries of one entry shared");
+
+    I2C_XferInitRegTable(&sXfer, 0x3C, asWide, 2, 1, 2);
+    CHECK(run(&sXfer, "S 78 05 be ef P S 78 06 01 02 P") == I2C_XFER_OK, "16-bit values");
+    I2C_XferInitRegTable(&sXfer, 0x50, asWide, 2, 1, 1);
+    CHECK(run(&sXfer, "S a0 05 ef P S a0 06 02 P") == I2C_XFER_OK && Slave[0].au8Mem[5] == 0xEF && Slave[0].au8Mem[6] == 0x02,
+          "8-bit values");
+    printf("register tables: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+static I2C_XFER_T Chain[4];
+
+/* Submit the transaction in pvParam from the callback */
+static void chain_done(I2C_XFER_T *psXfer)
+{
+    note_done(psXfer);
+    CHECK(Queue.u32InHandler, "callback outside the interrupt");
+    if (psXfer->pvParam != NULL)
+        CHECK(I2C_QueueSubmit(&Queue, (I2C_XFER_T *)psXfer->pvParam) == I2C_XFER_OK, "submit from a callback refused");
+}
+
+static void test_callback(void)
+{
+    I2C_MSG_T asMsg[4];
+    uint8_t au8Out[4][2] = { { 0x60, 1 }, { 0x61, 2 }, { 0x62, 3 }, { 0x63, 4 } };
+    uint32_t i;
+    int e = Errors;
+
+    memset(asMsg, 0, sizeof(asMsg));
+    for (i = 0; i < 4; i++)
+    {
+        asMsg[i].u8Addr = 0x50;
+        asMsg[i].u16Len = 2;
+        asMsg[i].pu8Buf = au8Out[i];
+        I2C_XferInit(&Chain[i], &asMsg[i], 1);
+        Chain[i].pfnDone = chain_done;
+    }
+
+    /* Each callback submits the next one to the queue its transaction just emptied */
+    Chain[0].pvParam = &Chain[1];
+    Chain[1].pvParam = &Chain[2];
+    DoneCnt = 0;
+    CHECK(run(&Chain[0], "S a0 60 01 P S a0 61 02 P S a0 62 03 P") == I2C_XFER_OK, "chain");
+    CHECK(DoneCnt == 3 && Done[0] == &Chain[0] && Done[1] == &Chain[1] && Done[2] == &Chain[2], "%u callbacks", DoneCnt);
+    CHECK(Chain[1].i32Status == I2C_XFER_OK && Chain[2].i32Status == I2C_XFER_OK, "chained transactions %d %d",
+          Chain[1].i32Status, Chain[2].i32Status);
+
+    /* A callback submitting behind a transaction the task queued */
+    Chain[1].pvParam = NULL;
+    Chain[2].pvParam = NULL;
+    DoneCnt = 0;
+    log_clear();
+    CHECK(I2C_QueueSubmit(&Queue, &Chain[0]) == I2C_XFER_OK && I2C_QueueSubmit(&Queue, &Chain[2]) == I2C_XFER_OK, "submit");
+    CHECK(I2C_QueueCount(&Queue) == 2 && Chain[0].i32Status == I2C_XFER_ACTIVE && Chain[2].i32Status == I2C_XFER_QUEUED,
+          "%u queued, status %d %d", I2C_QueueCount(&Queue), Chain[0].i32Status, Chain[2].i32Status);
+    bus_run();
+    CHECK(strcmp(log_get(), "S a0 60 01 P S a0 62 03 P S a0 61 02 P") == 0, "bus %s", log_get());
+    CHECK(DoneCnt == 3 && Done[0] == &Chain[0] && Done[1] == &Chain[2] && Done[2] == &Chain[1], "callback order");
+    CHECK(I2C_QueueCount(&Queue) == 0 && !(I2C1->TOCTL & I2C_TOCTL_TOCEN_Msk), "queue not idle");
+
+    /* A failed transaction's callback submits the next one */
+    Chain[3].pvParam = &Chain[1];
+    Chain[3].u32Retries = 0;
+    NackMask = 1;
+    DoneCnt = 0;
+    CHECK(run(&Chain[3], "S a0N P S a0 61 02 P") == I2C_XFER_ERR_NACK && Chain[1].i32Status == I2C_XFER_OK, "submit after an error");
+    printf("callbacks: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+static uint32_t Recovered;
+
+static void recover(I2C_T *i2c)
+{
+    CHECK(i2c == I2C1 && !(i2c->CTL0 & I2C_CTL0_I2CEN_Msk), "recovery with the controller on");
+    Recovered++;
+}
+
+static void test_errors(void)
+{
+    I2C_XFER_T asXfer[3];
+    I2C_MSG_T sMsg;
+    uint8_t au8Out[3] = { 0x70, 7, 8 };
+    uint32_t i;
+    int e = Errors;
+
+    memset(&sMsg, 0, sizeof(sMsg));
+    sMsg.u8Addr = 0x50;
+    sMsg.u16Len = 3;
+    sMsg.pu8Buf = au8Out;
+    for (i = 0; i < 3; i++)
+    {
+        I2C_XferInit(&asXfer[i], &sMsg, 1);
+        asXfer[i].pfnDone = note_done;
+    }
+    I2C_QueueSetRecovery(&Queue, recover);
+
+    /* Bus error on the second byte: reset, and the next transaction starts on the free bus */
+    I2C1->CLKDIV = 0x3B;
+    ErrorIn = 3;
+    DoneCnt = 0;
+    log_clear();
+    I2C_QueueSubmit(&Queue, &asXfer[0]);
+    I2C_QueueSubmit(&Queue, &asXfer[1]);
+    bus_run();
+    CHECK(strcmp(log_get(), "S a0 70 E X S a0 70 07 08 P") == 0, "bus %s", log_get());
+    CHECK(asXfer[0].i32Status == I2C_XFER_ERR_BUS && asXfer[1].i32Status == I2C_XFER_OK && DoneCnt == 2, "status %d %d",
+          asXfer[0].i32Status, asXfer[1].i32Status);
+    CHECK(Recovered == 1 && Queue.u32Recoveries == 1 && Queue.u32BusErrors == 1 && I2C1->CLKDIV == 0x3B &&
+          (I2C1->CTL0 & (I2C_CTL0_I2CEN_Msk | I2C_CTL0_INTEN_Msk)) == (I2C_CTL0_I2CEN_Msk | I2C_CTL0_INTEN_Msk), "controller not restored");
+
+    /* A slave holding the bus: the time-out ends the transaction */
+    StallIn = 2;
+    log_clear();
+    I2C_QueueSubmit(&Queue, &asXfer[0]);
+    I2C_QueueSubmit(&Queue, &asXfer[1]);
+    bus_run();
+    CHECK(asXfer[0].i32Status == I2C_XFER_ACTIVE && (I2C1->TOCTL & I2C_TOCTL_TOCEN_Msk), "stalled transaction %d", asXfer[0].i32Status);
+    I2C1->TOCTL |= I2C_TOCTL_TOIF_Msk;
+    ((void (*)(void))Isr[IRQ_I2C1])();
+    CHECK(!(I2C1->TOCTL & I2C_TOCTL_TOIF_Msk), "time-out flag not cleared");
+    bus_run();
+    CHECK(strcmp(log_get(), "S a0 X S a0 70 07 08 P") == 0, "bus %s", log_get());
+    CHECK(asXfer[0].i32Status == I2C_XFER_ERR_TIMEOUT && asXfer[1].i32Status == I2C_XFER_OK && Queue.u32Timeouts == 1 &&
+          Recovered == 2, "time-out status %d %d", asXfer[0].i32Status, asXfer[1].i32Status);
+
+    /* A late time-out with nothing queued is only cleared */
+    I2C1->TOCTL |= I2C_TOCTL_TOIF_Msk;
+    ((void (*)(void))Isr[IRQ_I2C1])();
+    CHECK(Recovered == 2 && !Pending && !(I2C1->TOCTL & I2C_TOCTL_TOIF_Msk), "idle time-out");
+
+    /* A bus event with nothing queued releases the bus */
+    log_clear();
+    State = BUS_WAIT;
+    bus_event(0x30);
+    bus_run();
+    CHECK(strcmp(log_get(), "P") == 0, "bus %s", log_get());
+
+    /* Close with one transaction on the bus and two queued */
+    StallIn = 3;
+    DoneCnt = 0;
+    log_clear();
+    for (i = 0; i < 3; i++)
+        I2C_QueueSubmit(&Queue, &asXfer[i]);
+    bus_run();
+    I2C_QueueClose(&Queue);
+    bus_run();
+    CHECK(strcmp(log_get(), "S a0 70 P") == 0, "bus %s", log_get());
+    CHECK(DoneCnt == 3 && asXfer[0].i32Status == I2C_XFER_ERR_ABORT && asXfer[2].i32Status == I2C_XFER_ERR_ABORT &&
+          Queue.psHead == NULL && !(I2C1->CTL0 & I2C_CTL0_INTEN_Msk) && Masked[IRQ_I2C1], "close");
+
+    I2C_QueueOpen(&Queue, I2C1, 0);
+    I2C_QueueSetRecovery(&Queue, NULL);
+    printf("bus errors and time-outs: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+static void test_random(void)
+{
+    uint8_t au8Ref[256], au8Out[8], au8In[8];
+    I2C_REG_T asReg[4];
+    I2C_MSG_T asMsg[3];
+    I2C_XFER_T sXfer;
+    uint32_t n, i, u32Len, u32Ptr, u32Fails, u32Arb;
+    int32_t i32Expect;
+    int e = Errors;
+
+    memcpy(au8Ref, Slave[0].au8Mem, sizeof(au8Ref));
+    for (n = 0; (n < 20000) && (Errors == e); n++)
+    {
+        u32Ptr = rnd(256);
+        u32Len = 1 + rnd(6);
+        memset(asMsg, 0, sizeof(asMsg));
+        asMsg[0].u8Addr = asMsg[1].u8Addr = 0x50;
+        asMsg[0].pu8Buf = au8Out;
+        au8Out[0] = (uint8_t)u32Ptr;
+        switch (rnd(3))
+        {
+        case 0:
+            /* Pointer and data, maybe split by NOSTART */
+            for (i = 1; i <= u32Len; i++)
+                au8Out[i] = (uint8_t)rnd(256);
+            asMsg[0].u16Len = 1 + u32Len;
+            i = rnd(2 + u32Len);
+            if (i < 1 + u32Len)
+            {
+                asMsg[0].u16Len = i;
+                asMsg[1].u8Flags = I2C_MSG_NOSTART;
+                asMsg[1].u16Len = 1 + u32Len - i;
+                asMsg[1].pu8Buf = au8Out + i;
+            }
+            I2C_XferInit(&sXfer, asMsg, asMsg[1].u16Len ? 2 : 1);
+            break;
+        case 1:
+            asMsg[0].u16Len = 1;
+            asMsg[1].u8Flags = I2C_MSG_READ;
+            asMsg[1].u16Len = u32Len;
+            asMsg[1].pu8Buf = au8In;
+            I2C_XferInit(&sXfer, asMsg, 2);
+            break;
+        default:
+            u32Len = 1 + rnd(4);
+            for (i = 0; i < u32Len; i++)
+            {
+                asReg[i].u16Reg = (uint16_t)rnd(256);
+                asReg[i].u16Val = (uint16_t)rnd(256);
+            }
+            I2C_XferInitRegTable(&sXfer, 0x50, asReg, u32Len, 1, 1);
+            break;
+        }
+
+        /* The first tries refused or lost, all on the first address of the transaction */
+        sXfer.u32Retries = rnd(4);
+        u32Fails = rnd(5);
+        u32Arb = rnd(1u << u32Fails);
+        NackMask = ((1u << u32Fails) - 1) & ~u32Arb;
+        ArbMask = u32Arb;
+        if (u32Fails <= sXfer.u32Retries)
+            i32Expect = I2C_XFER_OK;
+        else
+            i32Expect = (u32Arb >> sXfer.u32Retries) & 1 ? I2C_XFER_ERR_ARB : I2C_XFER_ERR_NACK;
+
+        CHECK(run(&sXfer, NULL) == i32Expect, "%s: status %d, expected %d, bus %s", sXfer.psMsg ? "messages" : "table",
+              sXfer.i32Status, i32Expect, log_get());
+        CHECK((i32Expect != I2C_XFER_OK) || (NackMask == 0 && ArbMask == 0), "failures left: %s", log_get());
+        NackMask = ArbMask = 0;
+        if (i32Expect != I2C_XFER_OK)
+        {
+            CHECK(sXfer.u32Done == 0, "%u done", sXfer.u32Done);
+        }
+        else if (sXfer.psMsg == NULL)
+        {
+            for (i = 0; i < u32Len; i++)
+                au8Ref[asReg[i].u16Reg] = (uint8_t)asReg[i].u16Val;
+        }
+        else if (asMsg[1].u8Flags & I2C_MSG_READ)
+        {
+            for (i = 0; i < u32Len; i++)
+                CHECK(au8In[i] == au8Ref[(u32Ptr + i) & 0xFF], "read 0x%02x at 0x%02x, expected 0x%02x", au8In[i],
+                      (u32Ptr + i) & 0xFF, au8Ref[(u32Ptr + i) & 0xFF]);
+        }
+        else
+        {
+            for (i = 0; i < u32Len; i++)
+                au8Ref[(u32Ptr + i) & 0xFF] = au8Out[1 + i];
+        }
+        CHECK(memcmp(au8Ref, Slave[0].au8Mem, sizeof(au8Ref)) == 0, "EEPROM differs after %s", log_get());
+    }
+    printf("random transactions: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+int main(void)
+{
+    /* The register blocks of I2C0 to I2C3 */
+    if (mmap((void *)I2C0, 4 * 0x1000, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) != (void *)I2C0)
+    {
+        perror("mmap");
+        return 1;
+    }
+    Slave[0].u8Addr = 0x50;
+    Slave[1].u8Addr = 0x3C;
+
+    test_open();
+    test_messages();
+    test_retry();
+    test_table();
+    test_callback();
+    test_errors();
+    test_random();
+
+    printf("i2cqueue: %s\n", Errors ? "FAIL" : "PASS");
+    return Errors != 0;
+}
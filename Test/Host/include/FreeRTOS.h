@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for the FreeRTOS headers that ffconf.h includes when
+ * FATFS_FREERTOS is defined. The test defines struct host_sem and the
+ * ff_xxx_syncobj/grant functions on top of POSIX mutexes.
+ */
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+typedef struct host_sem *SemaphoreHandle_t;
+
+#define pdMS_TO_TICKS(ms)   (ms)
+
+#endif
@@ -0,0 +1,391 @@
+/*
+ * Host check of the nested IRQ bookkeeping, Driver/Source/sys_irqnest.h.
+ *
+ * A model of the AIC stands in for the entry code of sys.c: a source is
+ * taken when its level is above the level of every running ISR, sysIrqEnter()
+ * and sysIrqLeave() run around the ISR as the entry calls them, and the end
+ * of the ISR drops the AIC priority again. Time is a 24-bit counter the
+ * model advances tick by tick, so the exclusive run of each ISR is known.
+ *
+ * - Random arrivals on sources of random levels: per-source counts, the
+ *   longest exclusive run per source across the wrap of the counter, the
+ *   deepest nesting overall and per level, against the model, with no
+ *   inversion counted.
+ * - Spurious entries, alone and inside a running ISR.
+ * - An AIC that wrongly lets equal levels nest, deeper than SYS_IRQ_NEST_MAX:
+ *   the inversions are counted, also while one ISR of a level is left, and
+ *   the bookkeeping is clean afterwards.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nuc980.h"
+#include "sys.h"
+
+/* Source control registers of the AIC, the rest reads 0 */
+static uint32_t SrcCtl[16];
+
+static uint32_t host_inpw(uintptr_t port)
+{
+    if ((port >= REG_AIC_SRCCTL0) && (port < REG_AIC_SRCCTL0 + sizeof(SrcCtl)))
+        return SrcCtl[(port - REG_AIC_SRCCTL0) / 4];
+    return 0;
+}
+
+#undef inpw
+#define inpw(port)          host_inpw((uintptr_t)(port))
+
+#define SRC_NUM     64
+sys_pvFunPtr sysIrqHandlerTable[SRC_NUM];
+
+#include "sys_irqnest.h"
+
+static int Errors;
+
+#define CHECK(c, ...)   do { if (!(c)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); Errors++; } } while (0)
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* AIC model                                                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#define CLOCK_MASK  0xFFFFFF
+
+static unsigned Seed = 1;
+
+static uint32_t rnd(uint32_t n)
+{
+    return (uint32_t)rand_r(&Seed) % n;
+}
+
+static uint32_t Clock;              /* Free running, read through the 24-bit mask */
+static uint32_t Duration[SRC_NUM];  /* Longest exclusive run of each ISR in ticks */
+static int RandomRuns;              /* Each run takes 1 to Duration[] ticks */
+static uint64_t Pending;
+static int SameLevelNests;          /* The AIC does not mask the level of the running ISR */
+
+/* Running ISRs, innermost last, as the model sees them, and the ticks each one runs */
+static uint32_t Stack[32];
+static uint32_t Ticks[32];
+static uint32_t Depth;
+
+/* What sysGetIrqStat() must report */
+static SYS_IRQ_STAT_T Ref;
+
+/* Arrivals: source Arrival[i].num becomes pending at tick Arrival[i].at */
+static struct { uint32_t at, num; } Arrival[4096];
+static uint32_t Arrivals, NextArrival, Now;
+
+static uint32_t irq_clock(void)
+{
+    return Clock & CLOCK_MASK;
+}
+
+static uint32_t src_level(uint32_t num)
+{
+    return (SrcCtl[num / 4] >> ((num % 4) * 8)) & 0x7;
+}
+
+static void set_level(uint32_t num, uint32_t level)
+{
+    SrcCtl[num / 4] = (SrcCtl[num / 4] & ~(0x7u << ((num % 4) * 8))) | (level << ((num % 4) * 8));
+}
+
+/* The level the AIC signals above, 8 when no ISR runs */
+static uint32_t aic_priority(void)
+{
+    uint32_t i, level = 8;
+
+    for (i = 0; i < Depth; i++)
+        if ((Stack[i] != 0) && (src_level(Stack[i]) < level))
+            level = src_level(Stack[i]);
+    return level;
+}
+
+/* The source REG_AIC_IRQNUM returns, 0 when none can be taken */
+static uint32_t aic_irqnum(void)
+{
+    uint32_t num, best = 0, prio = aic_priority();
+
+    for (num = 1; num < SRC_NUM; num++)
+    {
+        if (!(Pending & (1ull << num)))
+            continue;
+        if ((src_level(num) < prio) || (SameLevelNests && (src_level(num) <= prio)))
+        {
+            if ((best == 0) || (src_level(num) < src_level(best)))
+                best = num;
+        }
+    }
+    return best;
+}
+
+/* One pass of the nested entry: IRQNUM, sysIrqEnter(), the ISR with IRQ enabled, sysIrqLeave(), EOIS */
+static void take(uint32_t num)
+{
+    sys_pvFunPtr pfn;
+    uint32_t i, mask;
+
+    Pending &= ~(1ull << num);
+    Ticks[Depth] = (RandomRuns && num) ? 1 + rnd(Duration[num]) : Duration[num];
+    Stack[Depth++] = num;
+    if (Depth > Ref.u32MaxDepth)
+        Ref.u32MaxDepth = Depth;
+    if (num == 0)
+        Ref.u32Spurious++;
+    else if (Depth <= SYS_IRQ_NEST_MAX)
+    {
+        Ref.u32Count[num]++;
+        for (mask = 0, i = 0; i < Depth; i++)
+            if (Stack[i] != 0)
+                mask |= 1 << src_level(Stack[i]);
+        for (i = 0; i < 8; i++)
+            if ((mask & (1 << i)) && (Depth > Ref.u32LevelMaxDepth[i]))
+                Ref.u32LevelMaxDepth[i] = Depth;
+        if (!SameLevelNests && (Ticks[Depth - 1] > Ref.u32MaxTime[num]))
+            Ref.u32MaxTime[num] = Ticks[Depth - 1];
+    }
+
+    pfn = sysIrqEnter(num);
+    CHECK(pfn == (num ? sysIrqHandlerTable[num] : 0), "handler of source %u", num);
+    if (pfn)
+        pfn();
+    sysIrqLeave();
+    Depth--;
+}
+
+static void dispatch(void)
+{
+    uint32_t num;
+
+    while ((num = aic_irqnum()) != 0)
+        take(num);
+}
+
+/* The running ISR, or the idle loop, spends n ticks; arrivals preempt it */
+static void run(uint32_t n)
+{
+    while (n--)
+    {
+        Clock++;
+        Now++;
+        while ((NextArrival < Arrivals) && (Arrival[NextArrival].at <= Now))
+            Pending |= 1ull << Arrival[NextArrival++].num;
+        dispatch();
+    }
+}
+
+static void isr(void)
+{
+    run(Ticks[Depth - 1]);
+}
+
+static void aic_reset(uint32_t u32Clock)
+{
+    memset(&Ref, 0, sizeof(Ref));
+    memset(SrcCtl, 0, sizeof(SrcCtl));
+    Pending = 0;
+    Depth = 0;
+    Arrivals = NextArrival = Now = 0;
+    SameLevelNests = 0;
+    RandomRuns = 0;
+    Clock = u32Clock;
+    memset(&_sys_irqStat, 0, sizeof(_sys_irqStat));
+    /* As sysSetIrqStatClock() sets them */
+    _sys_pfnIrqClock = irq_clock;
+    _sys_u32IrqClockMask = CLOCK_MASK;
+}
+
+static int bookkeeping_idle(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < 8; i++)
+        if (_sys_au8IrqLevelActive[i] != 0)
+            return 0;
+    return (_sys_u32IrqDepth == 0) && (_sys_u32IrqLevelMask == 0);
+}
+
+static int stat_matches(const char *name)
+{
+    uint32_t i;
+    int ok = 1;
+
+    for (i = 0; i < SRC_NUM; i++)
+    {
+        if (_sys_irqStat.u32Count[i] != Ref.u32Count[i])
+        {
+            CHECK(0, "%s: source %u entered %u times, expected %u", name, i, _sys_irqStat.u32Count[i], Ref.u32Count[i]);
+            ok = 0;
+        }
+        if (_sys_irqStat.u32MaxTime[i] != Ref.u32MaxTime[i])
+        {
+            CHECK(0, "%s: source %u ran %u ticks, expected %u", name, i, _sys_irqStat.u32MaxTime[i], Ref.u32MaxTime[i]);
+            ok = 0;
+        }
+    }
+    for (i = 0; i < 8; i++)
+    {
+        if (_sys_irqStat.u32LevelMaxDepth[i] != Ref.u32LevelMaxDepth[i])
+        {
+            CHECK(0, "%s: level %u depth %u, expected %u", name, i, _sys_irqStat.u32LevelMaxDepth[i], Ref.u32LevelMaxDepth[i]);
+            ok = 0;
+        }
+    }
+    if ((_sys_irqStat.u32MaxDepth != Ref.u32MaxDepth) || (_sys_irqStat.u32Spurious != Ref.u32Spurious))
+    {
+        CHECK(0, "%s: depth %u spurious %u, expected %u and %u", name, _sys_irqStat.u32MaxDepth, _sys_irqStat.u32Spurious,
+              Ref.u32MaxDepth, Ref.u32Spurious);
+        ok = 0;
+    }
+    return ok;
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Tests                                                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static void test_random(void)
+{
+    uint32_t round, num, t, depth = 0;
+    int ok = 1;
+
+    for (num = 0; num < SRC_NUM; num++)
+        sysIrqHandlerTable[num] = isr;
+
+    for (round = 0; round < 200; round++)
+    {
+        /* Start just before the wrap of the counter in every other round */
+        aic_reset((round & 1) ? CLOCK_MASK - rnd(2000) : rnd(0x1000000));
+        for (num = 1; num < SRC_NUM; num++)
+        {
+            set_level(num, 1 + rnd(7));
+            Duration[num] = 1 + rnd(round & 2 ? 200 : 20);
+        }
+        RandomRuns = 1;
+        for (t = 0; Arrivals < sizeof(Arrival) / sizeof(Arrival[0]); Arrivals++)
+        {
+            t += rnd(30);
+            Arrival[Arrivals].at = t;
+            Arrival[Arrivals].num = 1 + rnd(16 + rnd(SRC_NUM - 17));
+        }
+        while ((NextArrival < Arrivals) || Pending)
+            run(1);
+
+        ok &= stat_matches("random");
+        CHECK(_sys_irqStat.u32Inversion == 0, "random: %u inversions", _sys_irqStat.u32Inversion);
+        CHECK(bookkeeping_idle(), "random: bookkeeping left busy");
+        if (!ok)
+            break;
+        if (Ref.u32MaxDepth > depth)
+            depth = Ref.u32MaxDepth;
+    }
+    CHECK(depth >= 5, "random: nested only %u deep", depth);
+    printf("random nesting: %s\n", Errors ? "FAIL" : "ok");
+}
+
+static void test_spurious(void)
+{
+    int e = Errors;
+
+    aic_reset(CLOCK_MASK - 10);
+    set_level(5, 3);
+
+    take(0);
+    CHECK(_sys_irqStat.u32Spurious == 1 && bookkeeping_idle(), "spurious entry when idle");
+
+    /* A spurious entry in the middle of source 5 costs it nothing */
+    sysIrqHandlerTable[5] = isr;
+    Stack[Depth++] = 5;
+    CHECK(sysIrqEnter(5) == isr, "handler of source 5");
+    Clock += 10;
+    take(0);
+    Clock += 10;
+    sysIrqLeave();
+    Depth--;
+    CHECK(_sys_irqStat.u32MaxTime[5] == 20 && _sys_irqStat.u32Spurious == 2, "source 5 around a spurious entry: %u ticks",
+          _sys_irqStat.u32MaxTime[5]);
+    CHECK(_sys_irqStat.u32LevelMaxDepth[3] == 1 && bookkeeping_idle(), "spurious entry in source 5");
+    printf("spurious entries: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+static void test_overflow(void)
+{
+    uint32_t i, num;
+    int e = Errors;
+
+    /* Twelve sources of level 4 nest on an AIC that wrongly lets equal levels in */
+    aic_reset(CLOCK_MASK - 100);
+    SameLevelNests = 1;
+    for (num = 1; num <= 12; num++)
+    {
+        set_level(num, 4);
+        Duration[num] = 5;
+        sysIrqHandlerTable[num] = isr;
+        Arrival[Arrivals].at = num;
+        Arrival[Arrivals++].num = num;
+    }
+    while ((NextArrival < Arrivals) || Pending)
+        run(1);
+
+    CHECK(_sys_irqStat.u32MaxDepth == 12, "depth %u", _sys_irqStat.u32MaxDepth);
+    CHECK(_sys_irqStat.u32Inversion == SYS_IRQ_NEST_MAX - 1, "%u inversions", _sys_irqStat.u32Inversion);
+    CHECK(_sys_irqStat.u32LevelMaxDepth[4] == SYS_IRQ_NEST_MAX, "level 4 depth %u", _sys_irqStat.u32LevelMaxDepth[4]);
+    for (num = 1; num <= 12; num++)
+        CHECK(_sys_irqStat.u32Count[num] == (num <= SYS_IRQ_NEST_MAX), "source %u entered %u times", num, _sys_irqStat.u32Count[num]);
+    CHECK(bookkeeping_idle(), "bookkeeping left busy after the overflow");
+
+    /* A correct AIC afterwards: level 2 in level 6, timed exactly */
+    SameLevelNests = 0;
+    memset(&_sys_irqStat, 0, sizeof(_sys_irqStat));
+    memset(&Ref, 0, sizeof(Ref));
+    set_level(20, 6);
+    set_level(21, 2);
+    Duration[20] = 30;
+    Duration[21] = 7;
+    sysIrqHandlerTable[20] = isr;
+    sysIrqHandlerTable[21] = isr;
+    Arrival[Arrivals].at = Now + 1;
+    Arrival[Arrivals++].num = 20;
+    Arrival[Arrivals].at = Now + 10;
+    Arrival[Arrivals++].num = 21;
+    for (i = 0; i < 50; i++)
+        run(1);
+    CHECK(_sys_irqStat.u32MaxTime[20] == 30 && _sys_irqStat.u32MaxTime[21] == 7, "after the overflow: %u and %u ticks",
+          _sys_irqStat.u32MaxTime[20], _sys_irqStat.u32MaxTime[21]);
+    CHECK(_sys_irqStat.u32LevelMaxDepth[6] == 2 && _sys_irqStat.u32LevelMaxDepth[2] == 2, "after the overflow: depths");
+    CHECK(_sys_irqStat.u32Inversion == 0 && bookkeeping_idle(), "after the overflow: bookkeeping");
+
+    /* Level 4 stays running while one of two level 4 ISRs is left */
+    SameLevelNests = 1;
+    set_level(30, 4);
+    set_level(31, 4);
+    set_level(32, 4);
+    Duration[30] = 20;
+    Duration[31] = 2;
+    Duration[32] = 2;
+    sysIrqHandlerTable[30] = sysIrqHandlerTable[31] = sysIrqHandlerTable[32] = isr;
+    Arrival[Arrivals].at = Now + 1;
+    Arrival[Arrivals++].num = 30;
+    Arrival[Arrivals].at = Now + 2;
+    Arrival[Arrivals++].num = 31;
+    Arrival[Arrivals].at = Now + 8;
+    Arrival[Arrivals++].num = 32;
+    for (i = 0; i < 30; i++)
+        run(1);
+    CHECK(_sys_irqStat.u32Inversion == 2, "%u inversions in a running level", _sys_irqStat.u32Inversion);
+    CHECK(bookkeeping_idle(), "bookkeeping left busy by equal levels");
+    printf("nesting overflow: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+int main(void)
+{
+    test_random();
+    test_spurious();
+    test_overflow();
+
+    printf("irqnest: %s\n", Errors ? "FAIL" : "PASS");
+    return Errors != 0;
+}
@@ -0,0 +1,635 @@
+/*
+ * Host check of the PDMA channel service, Driver/Source/pdma.c.
+ *
+ * The register blocks of PDMA0, PDMA1 and the clock controller are host
+ * memory mapped at their addresses, and the page of the descriptor pool is
+ * mapped a second time at its non-cacheable alias. A model of the
+ * controller runs a channel one descriptor at a time: it loads the
+ * descriptor at SCATBA + NEXT, copies the data, clears the operation mode of
+ * a finished descriptor and raises the transfer done flag unless the table
+ * interrupt is disabled. It presents the done and abort flags to the
+ * service interrupt handler and clears them after it, as they are write-1
+ * to clear.
+ *
+ * - Descriptor pool allocation: lists submitted on many channels until the
+ *   pool runs out, against a count of the free descriptors.
+ * - Random lists split into descriptors of at most 65536 transfers, every
+ *   NEXT an offset from SCATBA to a descriptor of the pool, and the data
+ *   the model moved with them.
+ * - Completion only when the channel has stopped, and ping-pong streams
+ *   re-arming their descriptors.
+ * - A bus error pauses the channel in the interrupt, without waiting for
+ *   it, and its descriptors are released on a later interrupt or by
+ *   PDMA_IsChannelBusy() once the channel is no longer active.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "pdma.c"
+
+static int Errors;
+
+#define CHECK(c, ...)   do { if (!(c)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); Errors++; } } while (0)
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Driver functions pdma.c calls                                                                           */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static BOOL IBit = TRUE;
+static PVOID Isr[2];
+static uint32_t Drains;
+
+BOOL sysGetIBitState(void)
+{
+    return IBit;
+}
+
+INT32 sysSetLocalInterrupt(INT32 nIntState)
+{
+    IBit = (nIntState == ENABLE_IRQ);
+    return 0;
+}
+
+PVOID sysInstallISR(INT32 nIntTypeLevel, IRQn_Type eIntNo, PVOID pvNewISR)
+{
+    (void)nIntTypeLevel;
+    Isr[eIntNo == IRQ_PDMA1] = pvNewISR;
+    return NULL;
+}
+
+INT32 sysEnableInterrupt(IRQn_Type eIntNo)
+{
+    (void)eIntNo;
+    return 0;
+}
+
+void sysCleanDCacheRange(UINT32 u32Addr, UINT32 u32Size)
+{
+    (void)u32Addr; (void)u32Size;
+}
+
+void sysInvalidateDCacheRange(UINT32 u32Addr, UINT32 u32Size)
+{
+    (void)u32Addr; (void)u32Size;
+}
+
+void sysDrainWriteBuffer(void)
+{
+    Drains++;
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Model of the controller                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static unsigned Seed = 1;
+
+static uint32_t rnd(uint32_t n)
+{
+    return (uint32_t)rand_r(&Seed) % n;
+}
+
+/* Flags the model raised and the handler has not seen yet */
+static uint32_t Done[2], Abort[2];
+static int Move = 1;
+
+/* The transfer active flags, read-only to the driver */
+#define TACTSTS(pdma)   (*(volatile uint32_t *)&(pdma)->TACTSTS)
+
+static PDMA_T *pdma_of(int32_t i32Ch)
+{
+    return PDMA_SVC_MODULE(i32Ch);
+}
+
+/* Run one descriptor of a channel. Returns 0 once the channel has stopped. */
+static int pdma_step(int32_t i32Ch)
+{
+    PDMA_T *pdma = pdma_of(i32Ch);
+    uint32_t u32Ch = PDMA_SVC_CHANNEL(i32Ch), u32Bit = 1UL << u32Ch;
+    DSCT_T *psReg = &pdma->DSCT[u32Ch], *psDesc = NULL;
+    uint32_t u32Width, u32Cnt, u32Sa, u32Da, i;
+
+    if ((psReg->CTL & PDMA_DSCT_CTL_OPMODE_Msk) == PDMA_OP_SCATTER)
+    {
+        psDesc = (DSCT_T *)(uintptr_t)(pdma->SCATBA + psReg->NEXT);
+        if ((psDesc < &s_asDescPool[0]) || (psDesc >= &s_asDescPool[PDMA_SVC_DESC_MAX]) ||
+                ((uintptr_t)psDesc - (uintptr_t)s_asDescPool) % sizeof(DSCT_T))
+        {
+            CHECK(0, "channel %d: NEXT 0x%x from SCATBA 0x%x is not a pool descriptor", i32Ch, psReg->NEXT, pdma->SCATBA);
+            psReg->CTL = PDMA_OP_STOP;
+            TACTSTS(pdma) &= ~u32Bit;
+            return 0;
+        }
+        *psReg = *psDesc;
+        CHECK((psReg->CTL & PDMA_DSCT_CTL_OPMODE_Msk) != PDMA_OP_STOP, "channel %d: descriptor %d not armed", i32Ch,
+              (int)(psDesc - s_asDescPool));
+    }
+    if ((psReg->CTL & PDMA_DSCT_CTL_OPMODE_Msk) == PDMA_OP_STOP)
+    {
+        TACTSTS(pdma) &= ~u32Bit;
+        return 0;
+    }
+
+    u32Width = 1UL << ((psReg->CTL & PDMA_DSCT_CTL_TXWIDTH_Msk) >> PDMA_DSCT_CTL_TXWIDTH_Pos);
+    u32Cnt = ((psReg->CTL & PDMA_DSCT_CTL_TXCNT_Msk) >> PDMA_DSCT_CTL_TXCNT_Pos) + 1;
+    u32Sa = psReg->SA;
+    u32Da = psReg->DA;
+    for (i = 0; Move && (i < u32Cnt); i++)
+    {
+        memcpy((void *)(uintptr_t)u32Da, (void *)(uintptr_t)u32Sa, u32Width);
+        if ((psReg->CTL & PDMA_DSCT_CTL_SAINC_Msk) != PDMA_SAR_FIX)
+            u32Sa += u32Width;
+        if ((psReg->CTL & PDMA_DSCT_CTL_DAINC_Msk) != PDMA_DAR_FIX)
+            u32Da += u32Width;
+    }
+
+    /* A finished descriptor is written back without its operation mode */
+    if (psDesc)
+        psDesc->CTL &= ~PDMA_DSCT_CTL_OPMODE_Msk;
+    if (!(psReg->CTL & PDMA_DSCT_CTL_TBINTDIS_Msk))
+        Done[pdma == PDMA1] |= u32Bit;
+    if ((psReg->CTL & PDMA_DSCT_CTL_OPMODE_Msk) == PDMA_OP_BASIC)
+    {
+        psReg->CTL &= ~PDMA_DSCT_CTL_OPMODE_Msk;
+        TACTSTS(pdma) &= ~u32Bit;
+        return 0;
+    }
+    return 1;
+}
+
+/* Present the raised flags of a controller to its interrupt handler */
+static void pdma_irq(uint32_t u32Idx)
+{
+    PDMA_T *pdma = u32Idx ? PDMA1 : PDMA0;
+
+    if (!((Done[u32Idx] | Abort[u32Idx]) & pdma->INTEN))
+        return;
+    pdma->INTSTS = (Done[u32Idx] ? PDMA_INTSTS_TDIF_Msk : 0) | (Abort[u32Idx] ? PDMA_INTSTS_ABTIF_Msk : 0);
+    pdma->TDSTS = Done[u32Idx];
+    pdma->ABTSTS = Abort[u32Idx];
+    Done[u32Idx] = Abort[u32Idx] = 0;
+
+    IBit = FALSE;
+    ((void (*)(void))Isr[u32Idx])();
+    CHECK(!IBit, "the handler enabled IRQ");
+    IBit = TRUE;
+
+    pdma->INTSTS = pdma->TDSTS = pdma->ABTSTS = 0;
+}
+
+/* Start of a channel: the service enabled and triggered it */
+static int pdma_started(int32_t i32Ch)
+{
+    PDMA_T *pdma = pdma_of(i32Ch);
+    uint32_t u32Bit = 1UL << PDMA_SVC_CHANNEL(i32Ch);
+
+    if (!(pdma->SWREQ & u32Bit) || !(pdma->CHCTL & u32Bit) || !(pdma->INTEN & u32Bit))
+        return 0;
+    pdma->SWREQ &= ~u32Bit;
+    TACTSTS(pdma) |= u32Bit;
+    return 1;
+}
+
+static void pdma_run(int32_t i32Ch)
+{
+    while (pdma_step(i32Ch)) {}
+    pdma_irq(pdma_of(i32Ch) == PDMA1);
+}
+
+static uint32_t free_desc(void)
+{
+    return (uint32_t)(__builtin_popcount(s_au32DescFree[0]) + __builtin_popcount(s_au32DescFree[1]));
+}
+
+/* Callback events of every channel */
+static uint32_t Events[PDMA_SVC_CH_MAX][4];
+static uint32_t LastEvent[PDMA_SVC_CH_MAX];
+
+static void callback(int32_t i32Ch, uint32_t u32Event, void *pvUserData)
+{
+    CHECK(pvUserData == &Events[i32Ch], "channel %d: user data", i32Ch);
+    LastEvent[i32Ch] = u32Event;
+    if (u32Event & PDMA_EVT_DONE)
+        Events[i32Ch][(u32Event & PDMA_EVT_PONG) ? 3 : 0]++;
+    if (u32Event & PDMA_EVT_ABORT)
+        Events[i32Ch][1]++;
+    if (u32Event & PDMA_EVT_TIMEOUT)
+        Events[i32Ch][2]++;
+}
+
+static uint8_t Src[4 << 20] __attribute__((aligned(64)));
+static uint8_t Dst[4 << 20] __attribute__((aligned(64)));
+
+static int32_t ChList[PDMA_SVC_CH_MAX];
+
+static void request_all(void)
+{
+    uint32_t i;
+
+    memset(Events, 0, sizeof(Events));
+    for (i = 0; i < PDMA_SVC_CH_MAX; i++)
+    {
+        ChList[i] = PDMA_RequestChannel(PDMA_MEM, callback, NULL);
+        CHECK(ChList[i] >= 0, "channel %u not granted", i);
+        s_asSvcCh[ChList[i]].pvUserData = &Events[ChList[i]];
+    }
+    CHECK(PDMA_RequestChannel(PDMA_MEM, callback, NULL) == PDMA_ERR_BUSY, "a 21st channel was granted");
+    CHECK(IBit, "IRQ left disabled");
+}
+
+static void free_all(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < PDMA_SVC_CH_MAX; i++)
+        PDMA_FreeChannel(ChList[i]);
+    CHECK(free_desc() == PDMA_SVC_DESC_MAX, "%u descriptors free after freeing the channels", free_desc());
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Tests                                                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static void test_pool(void)
+{
+    PDMA_SG_T asList[8];
+    uint32_t u32Used, u32Round, u32Want, u32Num, i, j, k;
+    uint32_t au32Owned[2];
+    int32_t i32Ret;
+    int e = Errors;
+
+    /* The data is not checked here */
+    Move = 0;
+    request_all();
+    CHECK(PDMA0->SCATBA == ((uint32_t)(uintptr_t)s_asDescPool & 0xFFFF0000u) && PDMA1->SCATBA == PDMA0->SCATBA, "SCATBA 0x%x 0x%x",
+          PDMA0->SCATBA, PDMA1->SCATBA);
+    for (u32Round = 0; u32Round < 200; u32Round++)
+    {
+        /* Lists of 2 to 8 descriptors on random channels until the pool runs out */
+        u32Used = 0;
+        au32Owned[0] = au32Owned[1] = 0;
+        for (i = 0; i < PDMA_SVC_CH_MAX; i++)
+        {
+            u32Num = 1 + rnd(4);
+            u32Want = 0;
+            for (j = 0; j < u32Num; j++)
+            {
+                k = 1 + rnd(2);
+                asList[j].u32Src = (uint32_t)(uintptr_t)&Src[j << 18];
+                asList[j].u32Dst = (uint32_t)(uintptr_t)&Dst[(i << 18) % sizeof(Dst)];
+                asList[j].u32Len = (k - 1) * PDMA_SVC_TXCNT_MAX + 1 + rnd(PDMA_SVC_TXCNT_MAX);
+                u32Want += k;
+            }
+            if (u32Want == 1)
+            {
+                asList[0].u32Len += PDMA_SVC_TXCNT_MAX;
+                u32Want = 2;
+            }
+            i32Ret = PDMA_SubmitSG(ChList[i], PDMA_WIDTH_8 | PDMA_SAR_FIX | PDMA_DAR_FIX, asList, u32Num);
+            if (u32Used + u32Want > PDMA_SVC_DESC_MAX)
+            {
+                CHECK(i32Ret == PDMA_ERR_NO_DESC, "round %u: %u descriptors taken with %u in use, returned %d", u32Round, u32Want, u32Used, i32Ret);
+                CHECK(!PDMA_IsChannelBusy(ChList[i]), "round %u: channel busy after a refused list", u32Round);
+                break;
+            }
+            CHECK(i32Ret == PDMA_OK, "round %u: %u descriptors refused with %u in use, returned %d", u32Round, u32Want, u32Used, i32Ret);
+            CHECK(pdma_started(ChList[i]), "round %u: channel %d not started", u32Round, ChList[i]);
+            CHECK(PDMA_SubmitSG(ChList[i], PDMA_WIDTH_8, asList, 1) == PDMA_ERR_BUSY, "round %u: list taken by a busy channel", u32Round);
+            u32Used += u32Want;
+            k = s_asSvcCh[ChList[i]].au32Desc[0];
+            j = s_asSvcCh[ChList[i]].au32Desc[1];
+            CHECK(!(au32Owned[0] & k) && !(au32Owned[1] & j) && (uint32_t)(__builtin_popcount(k) + __builtin_popcount(j)) == u32Want,
+                  "round %u: descriptors of channel %d shared or miscounted", u32Round, ChList[i]);
+            au32Owned[0] |= k;
+            au32Owned[1] |= j;
+            CHECK(free_desc() == PDMA_SVC_DESC_MAX - u32Used, "round %u: %u descriptors free with %u in use", u32Round, free_desc(), u32Used);
+        }
+        CHECK(IBit, "IRQ left disabled");
+
+        /* Complete them in a random order */
+        for (j = 0; j < i; j++)
+        {
+            k = j + rnd(i - j);
+            i32Ret = ChList[k];
+            ChList[k] = ChList[j];
+            ChList[j] = i32Ret;
+            pdma_run(ChList[j]);
+            CHECK(!PDMA_IsChannelBusy(ChList[j]), "round %u: channel %d busy after its list", u32Round, ChList[j]);
+        }
+        CHECK(free_desc() == PDMA_SVC_DESC_MAX, "round %u: %u descriptors free after the lists", u32Round, free_desc());
+        if (Errors != e)
+            break;
+    }
+    for (i = 0; i < PDMA_SVC_CH_MAX; i++)
+        CHECK(Events[i][1] == 0 && Events[i][3] == 0, "channel %u: unexpected events", i);
+    free_all();
+    Move = 1;
+    printf("descriptor pool: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+static void test_split(void)
+{
+    static const uint32_t au32Width[3] = { PDMA_WIDTH_8, PDMA_WIDTH_16, PDMA_WIDTH_32 };
+    PDMA_SG_T asList[6];
+    uint32_t u32Round, u32Num, u32Ctl, u32Shift, u32Want, u32Off, u32Cnt, i, j;
+    uint32_t au32Seen[2];
+    DSCT_T *psDesc;
+    PDMA_T *pdma;
+    int32_t i32Ch;
+    int e = Errors;
+
+    request_all();
+    for (i = 0; i < sizeof(Src); i++)
+        Src[i] = (uint8_t)(i * 7 + (i >> 11));
+    for (u32Round = 0; u32Round < 100; u32Round++)
+    {
+        i32Ch = ChList[rnd(PDMA_SVC_CH_MAX)];
+        pdma = pdma_of(i32Ch);
+        u32Shift = rnd(3);
+        u32Ctl = au32Width[u32Shift] | (rnd(2) ? PDMA_REQ_SINGLE : PDMA_REQ_BURST);
+        u32Num = 1 + rnd(6);
+        u32Want = 0;
+        u32Off = 0;
+        for (i = 0; i < u32Num; i++)
+        {
+            /* Mostly around the 65536-transfer split */
+            u32Cnt = rnd(3) ? 1 + rnd(3 * PDMA_SVC_TXCNT_MAX >> u32Shift) : PDMA_SVC_TXCNT_MAX * (1 + rnd(2)) + rnd(3) - 1;
+            if (u32Off + (u32Cnt << u32Shift) > sizeof(Dst) / 2)
+                u32Cnt = 1;
+            asList[i].u32Src = (uint32_t)(uintptr_t)&Src[rnd(sizeof(Src) / 2) & ~((1u << u32Shift) - 1)];
+            asList[i].u32Dst = (uint32_t)(uintptr_t)&Dst[u32Off];
+            asList[i].u32Len = u32Cnt << u32Shift;
+            u32Off += asList[i].u32Len;
+            u32Want += (u32Cnt + PDMA_SVC_TXCNT_MAX - 1) / PDMA_SVC_TXCNT_MAX;
+        }
+        if (u32Want > PDMA_SVC_DESC_MAX)
+            continue;
+        memset(Dst, 0, u32Off);
+
+        Drains = 0;
+        CHECK(PDMA_SubmitSG(i32Ch, u32Ctl, asList, u32Num) == PDMA_OK, "round %u: list refused", u32Round);
+        CHECK(pdma_started(i32Ch) && Drains > 0, "round %u: channel not started after a write buffer drain", u32Round);
+        CHECK(free_desc() == PDMA_SVC_DESC_MAX - (u32Want > 1 ? u32Want : 0), "round %u: %u descriptors for a list of %u",
+              u32Round, (uint32_t)PDMA_SVC_DESC_MAX - free_desc(), u32Want);
+
+        /* Walk the chain as the controller will */
+        if (u32Want > 1)
+        {
+            au32Seen[0] = au32Seen[1] = 0;
+            psDesc = &pdma->DSCT[PDMA_SVC_CHANNEL(i32Ch)];
+            for (j = 0; j < u32Want; j++)
+            {
+                CHECK((psDesc->NEXT & 0xF) == 0 && psDesc->NEXT < 0x10000, "round %u: NEXT 0x%x", u32Round, psDesc->NEXT);
+                psDesc = (DSCT_T *)(uintptr_t)(pdma->SCATBA + psDesc->NEXT);
+                i = (uint32_t)(psDesc - s_asDescPool);
+                CHECK(i < PDMA_SVC_DESC_MAX && !(au32Seen[i >> 5] & (1UL << (i & 31))), "round %u: descriptor %u outside the pool or twice", u32Round, i);
+                if (i >= PDMA_SVC_DESC_MAX)
+                    break;
+                au32Seen[i >> 5] |= 1UL << (i & 31);
+                CHECK((psDesc->CTL & PDMA_DSCT_CTL_OPMODE_Msk) == (j + 1 < u32Want ? PDMA_OP_SCATTER : PDMA_OP_BASIC) &&
+                      !(psDesc->CTL & PDMA_DSCT_CTL_TBINTDIS_Msk) == (j + 1 == u32Want),
+                      "round %u: descriptor %u of %u, CTL 0x%08x", u32Round, j, u32Want, psDesc->CTL);
+            }
+            CHECK(au32Seen[0] == s_asSvcCh[i32Ch].au32Desc[0] && au32Seen[1] == s_asSvcCh[i32Ch].au32Desc[1],
+                  "round %u: chain and owned descriptors differ", u32Round);
+        }
+
+        memset(Events[i32Ch], 0, sizeof(Events[i32Ch]));
+        pdma_run(i32Ch);
+        CHECK(Events[i32Ch][0] == 1 && LastEvent[i32Ch] == PDMA_EVT_DONE, "round %u: %u done callbacks", u32Round, Events[i32Ch][0]);
+        CHECK(free_desc() == PDMA_SVC_DESC_MAX, "round %u: descriptors not released", u32Round);
+        for (i = 0; i < u32Num; i++)
+            CHECK(memcmp((void *)(uintptr_t)asList[i].u32Dst, (void *)(uintptr_t)asList[i].u32Src, asList[i].u32Len) == 0,
+                  "round %u: segment %u of %u (%u bytes) moved wrongly", u32Round, i, u32Num, asList[i].u32Len);
+        if (Errors != e)
+            break;
+    }
+
+    /* Lengths that are not a multiple of the width, and a list too long for the pool */
+    asList[0].u32Len = 6;
+    CHECK(PDMA_SubmitSG(ChList[0], PDMA_WIDTH_32, asList, 1) == PDMA_ERR_ARG, "6 bytes in words accepted");
+    asList[0].u32Len = 0;
+    CHECK(PDMA_SubmitSG(ChList[0], PDMA_WIDTH_8, asList, 1) == PDMA_ERR_ARG, "an empty segment accepted");
+    asList[0].u32Len = (PDMA_SVC_DESC_MAX + 1) * PDMA_SVC_TXCNT_MAX;
+    CHECK(PDMA_SubmitSG(ChList[0], PDMA_WIDTH_8 | PDMA_SAR_FIX | PDMA_DAR_FIX, asList, 1) == PDMA_ERR_ARG, "65 descriptors accepted");
+    CHECK(!PDMA_IsChannelBusy(ChList[0]) && free_desc() == PDMA_SVC_DESC_MAX, "a refused list kept the channel");
+
+    free_all();
+    printf("list splitting: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+static void test_done(void)
+{
+    PDMA_SG_T asList[2], sPing, sPong;
+    uint32_t u32Round, i;
+    int32_t i32Ch;
+    int e = Errors;
+
+    request_all();
+
+    /* A done flag while the channel still runs its list is not the end of it */
+    i32Ch = ChList[3];
+    for (i = 0; i < 2; i++)
+    {
+        asList[i].u32Src = (uint32_t)(uintptr_t)&Src[i << 12];
+        asList[i].u32Dst = (uint32_t)(uintptr_t)&Dst[i << 12];
+        asList[i].u32Len = 4096;
+    }
+    CHECK(PDMA_SubmitSG(i32Ch, PDMA_WIDTH_32, asList, 2) == PDMA_OK && pdma_started(i32Ch), "list refused");
+    CHECK(pdma_step(i32Ch), "list ended after its first descriptor");
+    Done[pdma_of(i32Ch) == PDMA1] |= 1UL << PDMA_SVC_CHANNEL(i32Ch);
+    pdma_irq(pdma_of(i32Ch) == PDMA1);
+    CHECK(Events[i32Ch][0] == 0 && PDMA_IsChannelBusy(i32Ch) && free_desc() == PDMA_SVC_DESC_MAX - 2, "list completed by its first descriptor");
+    pdma_run(i32Ch);
+    CHECK(Events[i32Ch][0] == 1 && !PDMA_IsChannelBusy(i32Ch) && free_desc() == PDMA_SVC_DESC_MAX, "list not completed once stopped");
+
+    /* A single descriptor runs in basic mode without the pool */
+    CHECK(PDMA_SubmitSG(i32Ch, PDMA_WIDTH_32, asList, 1) == PDMA_OK && pdma_started(i32Ch), "list refused");
+    CHECK(free_desc() == PDMA_SVC_DESC_MAX && (pdma_of(i32Ch)->DSCT[PDMA_SVC_CHANNEL(i32Ch)].CTL & PDMA_DSCT_CTL_OPMODE_Msk) == PDMA_OP_BASIC,
+          "single segment not in basic mode");
+    pdma_run(i32Ch);
+    CHECK(Events[i32Ch][0] == 2 && !PDMA_IsChannelBusy(i32Ch), "basic transfer not completed");
+
+    /* A ping-pong stream on another channel of the same controller, buffers alternating */
+    i32Ch = ChList[5];
+    sPing.u32Src = (uint32_t)(uintptr_t)&Src[0];
+    sPing.u32Dst = (uint32_t)(uintptr_t)&Dst[0];
+    sPing.u32Len = 1024;
+    sPong.u32Src = (uint32_t)(uintptr_t)&Src[8192];
+    sPong.u32Dst = (uint32_t)(uintptr_t)&Dst[8192];
+    sPong.u32Len = 512;
+    CHECK(PDMA_StartStream(i32Ch, PDMA_WIDTH_16, &sPing, &sPong) == PDMA_OK && pdma_started(i32Ch), "stream refused");
+    for (u32Round = 0; u32Round < 100; u32Round++)
+    {
+        CHECK(pdma_step(i32Ch), "round %u: stream stopped", u32Round);
+        pdma_irq(pdma_of(i32Ch) == PDMA1);
+        CHECK(LastEvent[i32Ch] == (PDMA_EVT_DONE | ((u32Round & 1) ? PDMA_EVT_PONG : 0)), "round %u: event 0x%x", u32Round, LastEvent[i32Ch]);
+        CHECK(PDMA_IsChannelBusy(i32Ch), "round %u: stream not busy", u32Round);
+        if (Errors != e)
+            break;
+    }
+    CHECK(Events[i32Ch][0] == 50 && Events[i32Ch][3] == 50, "%u ping and %u pong buffers", Events[i32Ch][0], Events[i32Ch][3]);
+    /* The model finishes the current buffer at once */
+    TACTSTS(pdma_of(i32Ch)) &= ~(1UL << PDMA_SVC_CHANNEL(i32Ch));
+    PDMA_StopChannel(i32Ch);
+    CHECK(!PDMA_IsChannelBusy(i32Ch) && free_desc() == PDMA_SVC_DESC_MAX && pdma_of(i32Ch)->PAUSE == (1UL << PDMA_SVC_CHANNEL(i32Ch)),
+          "stream not stopped");
+    CHECK(IBit, "IRQ left disabled");
+
+    free_all();
+    printf("completion: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+/* Another requested channel of the same controller */
+static int32_t other_channel(int32_t i32Ch)
+{
+    uint32_t i;
+
+    for (i = 0; i < PDMA_SVC_CH_MAX; i++)
+        if ((ChList[i] != i32Ch) && (pdma_of(ChList[i]) == pdma_of(i32Ch)))
+            break;
+    return ChList[i];
+}
+
+static void test_abort(void)
+{
+    PDMA_SG_T asList[3];
+    PDMA_T *pdma;
+    uint32_t u32Bit, u32Idx, i;
+    int32_t i32Ch, i32Other;
+    int e = Errors;
+
+    request_all();
+    for (i = 0; i < 3; i++)
+    {
+        asList[i].u32Src = (uint32_t)(uintptr_t)&Src[i << 12];
+        asList[i].u32Dst = (uint32_t)(uintptr_t)&Dst[i << 12];
+        asList[i].u32Len = 4096;
+    }
+
+    for (i = 0; i < 2; i++)
+    {
+        i32Ch = ChList[2 * i];
+        pdma = pdma_of(i32Ch);
+        u32Idx = (pdma == PDMA1);
+        u32Bit = 1UL << PDMA_SVC_CHANNEL(i32Ch);
+        i32Other = other_channel(i32Ch);
+
+        memset(Events[i32Ch], 0, sizeof(Events[i32Ch]));
+        CHECK(PDMA_SubmitSG(i32Ch, PDMA_WIDTH_8, asList, 3) == PDMA_OK && pdma_started(i32Ch), "list refused");
+        pdma_step(i32Ch);
+
+        /* Bus error while the channel is still active: the handler returns at once */
+        pdma->PAUSE = 0;
+        Abort[u32Idx] |= u32Bit;
+        pdma_irq(u32Idx);
+        CHECK(Events[i32Ch][1] == 1 && LastEvent[i32Ch] == PDMA_EVT_ABORT, "%u abort callbacks", Events[i32Ch][1]);
+        CHECK(pdma->PAUSE == u32Bit && !(pdma->INTEN & u32Bit), "channel not paused");
+        CHECK(free_desc() == PDMA_SVC_DESC_MAX - 3 && PDMA_IsChannelBusy(i32Ch), "descriptors released while the channel is active");
+        CHECK(PDMA_SubmitSG(i32Ch, PDMA_WIDTH_8, asList, 1) == PDMA_ERR_BUSY, "list taken by a paused channel");
+
+        /* A late done flag of the aborted channel is not a completion */
+        Done[u32Idx] |= u32Bit;
+        CHECK(PDMA_SubmitSG(i32Other, PDMA_WIDTH_8, asList, 1) == PDMA_OK && pdma_started(i32Other), "other channel refused");
+        pdma_run(i32Other);
+        CHECK(Events[i32Ch][0] == 0 && PDMA_IsChannelBusy(i32Ch), "aborted channel completed");
+
+        TACTSTS(pdma) &= ~u32Bit;
+        if (i == 0)
+        {
+            /* Released on the next interrupt of the controller */
+            CHECK(PDMA_SubmitSG(i32Other, PDMA_WIDTH_8, asList, 1) == PDMA_OK && pdma_started(i32Other), "other channel refused");
+            CHECK(s_asSvcCh[i32Ch].u8Paused, "released before the interrupt");
+            pdma_run(i32Other);
+            CHECK(!s_asSvcCh[i32Ch].u8Paused && free_desc() == PDMA_SVC_DESC_MAX, "not released by the next interrupt");
+        }
+        else
+        {
+            /* Released by polling from thread context */
+            CHECK(!PDMA_IsChannelBusy(i32Ch) && free_desc() == PDMA_SVC_DESC_MAX, "not released by PDMA_IsChannelBusy()");
+        }
+        CHECK(IBit, "IRQ left disabled");
+
+        /* The channel takes the next list */
+        CHECK(PDMA_SubmitSG(i32Ch, PDMA_WIDTH_8, asList, 3) == PDMA_OK && pdma_started(i32Ch), "list refused after the abort");
+        pdma_run(i32Ch);
+        CHECK(Events[i32Ch][0] == 1 && !PDMA_IsChannelBusy(i32Ch) && free_desc() == PDMA_SVC_DESC_MAX, "list after the abort not completed");
+    }
+
+    /* The done flag of the list ended by the error comes with a later interrupt */
+    i32Ch = ChList[9];
+    pdma = pdma_of(i32Ch);
+    u32Idx = (pdma == PDMA1);
+    u32Bit = 1UL << PDMA_SVC_CHANNEL(i32Ch);
+    memset(Events[i32Ch], 0, sizeof(Events[i32Ch]));
+    CHECK(PDMA_SubmitSG(i32Ch, PDMA_WIDTH_8, asList, 3) == PDMA_OK && pdma_started(i32Ch), "list refused");
+    pdma_step(i32Ch);
+    Abort[u32Idx] |= u32Bit;
+    pdma_irq(u32Idx);
+    while (pdma_step(i32Ch)) {}
+    i32Other = other_channel(i32Ch);
+    CHECK(PDMA_SubmitSG(i32Other, PDMA_WIDTH_8, asList, 1) == PDMA_OK && pdma_started(i32Other), "other channel refused");
+    pdma_run(i32Other);
+    CHECK(Events[i32Ch][0] == 0 && Events[i32Ch][1] == 1, "%u done callbacks after the abort", Events[i32Ch][0]);
+    CHECK(!PDMA_IsChannelBusy(i32Ch) && free_desc() == PDMA_SVC_DESC_MAX, "not released once stopped");
+
+    /* A bus error after the last transfer releases the descriptors in the same interrupt */
+    i32Ch = ChList[7];
+    pdma = pdma_of(i32Ch);
+    u32Bit = 1UL << PDMA_SVC_CHANNEL(i32Ch);
+    CHECK(PDMA_SubmitSG(i32Ch, PDMA_WIDTH_8, asList, 2) == PDMA_OK && pdma_started(i32Ch), "list refused");
+    TACTSTS(pdma) &= ~u32Bit;
+    Abort[pdma == PDMA1] |= u32Bit;
+    pdma_irq(pdma == PDMA1);
+    CHECK(Events[i32Ch][1] == 1 && !s_asSvcCh[i32Ch].u8Paused && free_desc() == PDMA_SVC_DESC_MAX, "idle aborted channel not released");
+
+    free_all();
+    printf("abort: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+/* Map the page of the descriptor pool a second time at its non-cacheable alias */
+static int map_pool_alias(void)
+{
+    uintptr_t uPage = (uintptr_t)s_asDescPool & ~(uintptr_t)0xFFF;
+    size_t uLen = (((uintptr_t)&s_asDescPool[PDMA_SVC_DESC_MAX] - uPage) + 0xFFF) & ~(size_t)0xFFF;
+    void *pvCopy = malloc(uLen);
+    int fd = memfd_create("pdmapool", 0);
+
+    if ((fd < 0) || !pvCopy || (ftruncate(fd, (off_t)uLen) != 0))
+        return -1;
+    memcpy(pvCopy, (void *)uPage, uLen);
+    if ((mmap((void *)uPage, uLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != (void *)uPage) ||
+            (mmap((void *)(uPage | 0x80000000u), uLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0) !=
+             (void *)(uPage | 0x80000000u)))
+        return -1;
+    memcpy((void *)uPage, pvCopy, uLen);
+    free(pvCopy);
+    close(fd);
+    return 0;
+}
+
+int main(void)
+{
+    /* The clock controller up to PDMA1 */
+    if ((mmap((void *)0xB0000000, 0xA000, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) != (void *)0xB0000000) ||
+            (map_pool_alias() != 0))
+    {
+        perror("mmap");
+        return 1;
+    }
+
+    test_pool();
+    test_split();
+    test_done();
+    test_abort();
+
+    printf("pdmasvc: %s\n", Errors ? "FAIL" : "PASS");
+    return Errors != 0;
+}
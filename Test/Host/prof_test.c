@@ -0,0 +1,348 @@
+/*
+ * Host check of the profiling probes, Driver/Source/prof.c.
+ *
+ * SYS_PROF_CLOCK() reads a fake 24-bit counter the test advances, as
+ * ETIMER4 counts, and the ETIMER4 and clock registers are host variables.
+ *
+ * - sysProfInit() sets ETIMER4 free running over the 24 bits.
+ * - sysProfGetBin() at every power of two and its neighbours, and at random
+ *   durations, against a reference.
+ * - SYS_PROF_BEGIN/END and SYS_PROF_STAMP/SINCE across the wrap of the
+ *   counter, and spans longer than 2^24 ticks recorded modulo that.
+ * - sysProfAdd() count, min, max, total and histogram of random durations
+ *   on interleaved probes against a reference, the probe list, and
+ *   sysProfReset().
+ * - The conversion to CPU cycles and the lines of sysProfDump().
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <stdint.h>
+
+/* The ETIMER4 counter: the test advances Ticks, the probes see its low 24 bits */
+static uint32_t Ticks;
+
+static uint32_t fake_clock(void)
+{
+    return Ticks & 0xFFFFFF;
+}
+
+#define SYS_PROF_ENABLE
+#define SYS_PROF_CLOCK()    fake_clock()
+
+#include "nuc980.h"
+#include "sys.h"
+
+/* Registers sysProfInit() writes, the rest reads 0 */
+static struct
+{
+    uintptr_t   uPort;
+    uint32_t    u32Value;
+} Regs[8];
+
+static uint32_t *host_reg(uintptr_t port)
+{
+    uint32_t i;
+
+    for (i = 0; (i < sizeof(Regs) / sizeof(Regs[0])) && Regs[i].uPort && (Regs[i].uPort != port); i++) {}
+    if (i == sizeof(Regs) / sizeof(Regs[0]))
+    {
+        printf("too many registers\n");
+        exit(1);
+    }
+    Regs[i].uPort = port;
+    return &Regs[i].u32Value;
+}
+
+#undef inpw
+#undef outpw
+#define inpw(port)          (*host_reg((uintptr_t)(port)))
+#define outpw(port, value)  (*host_reg((uintptr_t)(port)) = (value))
+
+#include "prof.c"
+
+static int Errors;
+
+#define CHECK(c, ...)   do { if (!(c)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); Errors++; } } while (0)
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Driver functions prof.c calls                                                                           */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static BOOL IBit = TRUE;
+static uint32_t CpuMHz = 300, PclkMHz = 150;
+
+BOOL sysGetIBitState(void)
+{
+    return IBit;
+}
+
+INT32 sysSetLocalInterrupt(INT32 nIntState)
+{
+    IBit = (nIntState == ENABLE_IRQ);
+    return 0;
+}
+
+UINT32 sysGetClock(CLK_Type clk)
+{
+    return (clk == SYS_CPU) ? CpuMHz : (clk == SYS_PCLK01) ? PclkMHz : 0;
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Reference                                                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static unsigned Seed = 1;
+
+static uint32_t rnd(uint32_t n)
+{
+    return (uint32_t)rand_r(&Seed) % n;
+}
+
+static uint32_t ref_bin(uint32_t u32Ticks)
+{
+    uint32_t u32Bin = 0;
+
+    while (u32Ticks)
+    {
+        u32Ticks >>= 1;
+        u32Bin++;
+    }
+    return (u32Bin < SYS_PROF_BINS) ? u32Bin : SYS_PROF_BINS - 1;
+}
+
+/* Random duration, mostly short, sometimes past 24 bits */
+static uint32_t random_ticks(void)
+{
+    switch (rnd(4))
+    {
+    case 0:
+        return rnd(16);
+    case 1:
+        return rnd(1u << rnd(25));
+    case 2:
+        return (uint32_t)rand_r(&Seed) << 1 | rnd(2);
+    default:
+        return 1u << rnd(32);
+    }
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Tests                                                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static void test_init(void)
+{
+    int e = Errors;
+
+    outpw(REG_CLK_PCLKEN0, 0x10000);
+    outpw(REG_CLK_DIVCTL8, 0x0E00000F);
+    outpw(REG_ETMR4_PRECNT, 0xFF);
+    sysProfInit();
+    CHECK(inpw(REG_CLK_PCLKEN0) == (0x10000 | (1 << 12)), "PCLKEN0 0x%08x", inpw(REG_CLK_PCLKEN0));
+    CHECK(inpw(REG_CLK_DIVCTL8) == 0x0D00000F, "DIVCTL8 0x%08x, ETIMER4 not on PCLK01", inpw(REG_CLK_DIVCTL8));
+    CHECK(inpw(REG_ETMR4_PRECNT) == 0 && inpw(REG_ETMR4_CMPR) == SYS_PROF_TICK_MASK, "prescaler %u, compare 0x%x",
+          inpw(REG_ETMR4_PRECNT), inpw(REG_ETMR4_CMPR));
+    CHECK(inpw(REG_ETMR4_CTL) == ((3 << 4) | 1), "CTL 0x%x, not counting in continuous mode", inpw(REG_ETMR4_CTL));
+    CHECK(sysProfGetTickRate() == 150000000, "tick rate %u", sysProfGetTickRate());
+    printf("timer set-up: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+static void test_bin(void)
+{
+    uint32_t i, n, t;
+    int e = Errors;
+
+    CHECK(sysProfGetBin(0) == 0, "bin of 0 ticks");
+    for (n = 0; n < 32; n++)
+    {
+        for (i = 0; i < 3; i++)
+        {
+            t = (1u << n) - 1 + i;
+            CHECK(sysProfGetBin(t) == ref_bin(t), "bin of %u is %u, expected %u", t, sysProfGetBin(t), ref_bin(t));
+        }
+    }
+    CHECK(sysProfGetBin(0xFFFFFFFF) == SYS_PROF_BINS - 1, "bin of 0xFFFFFFFF");
+    CHECK(sysProfGetBin(SYS_PROF_TICK_MASK) == 24, "bin of the longest span");
+    for (i = 0; i < 1000000; i++)
+    {
+        t = random_ticks();
+        if (sysProfGetBin(t) != ref_bin(t))
+        {
+            CHECK(0, "bin of %u is %u, expected %u", t, sysProfGetBin(t), ref_bin(t));
+            break;
+        }
+    }
+    printf("histogram bins: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+SYS_PROF_DEFINE(s_sWrap, "wrap")
+SYS_PROF_DEFINE(s_sSince, "since")
+
+static void test_wrap(void)
+{
+    uint32_t u32Stamp, u32Span, i;
+    uint64_t u64Total = 0;
+    int e = Errors;
+
+    for (i = 0; i < 1000; i++)
+    {
+        /* Start close to the top of the counter, often wrapping during the span */
+        Ticks = SYS_PROF_TICK_MASK - rnd(64);
+        u32Span = (i % 10 == 9) ? (1u << 24) + rnd(100) : rnd(128);
+        SYS_PROF_BEGIN(s_sWrap);
+        SYS_PROF_STAMP(u32Stamp);
+        Ticks += u32Span;
+        SYS_PROF_END(s_sWrap);
+        SYS_PROF_SINCE(s_sSince, u32Stamp);
+        u64Total += u32Span & SYS_PROF_TICK_MASK;
+        CHECK(s_sWrap.au32Hist[ref_bin(u32Span & SYS_PROF_TICK_MASK)] > 0, "span %u not in its bin", u32Span);
+    }
+    CHECK(s_sWrap.u32Count == 1000 && s_sWrap.u64Total == u64Total, "%u spans, %llu ticks, expected %llu", s_sWrap.u32Count,
+          (unsigned long long)s_sWrap.u64Total, (unsigned long long)u64Total);
+    CHECK(s_sWrap.u32Max < 128, "longest span %u, spans over 2^24 ticks not wrapped", s_sWrap.u32Max);
+    CHECK(s_sSince.u32Count == s_sWrap.u32Count && s_sSince.u64Total == s_sWrap.u64Total && s_sSince.u32Min == s_sWrap.u32Min &&
+          memcmp(s_sSince.au32Hist, s_sWrap.au32Hist, sizeof(s_sWrap.au32Hist)) == 0, "SYS_PROF_SINCE differs from SYS_PROF_END");
+    printf("24-bit counter wrap: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+static void test_add(void)
+{
+    static SYS_PROF_T asProbe[3] = { { "a" }, { "b" }, { "c" } };
+    struct
+    {
+        uint32_t u32Count, u32Min, u32Max;
+        uint64_t u64Total;
+        uint32_t au32Hist[SYS_PROF_BINS];
+    } asRef[3];
+    SYS_PROF_T *psProbe;
+    uint32_t u32Round, i, j, t, n;
+    BOOL bIBit;
+    int e = Errors;
+
+    for (u32Round = 0; u32Round < 3; u32Round++)
+    {
+        memset(asRef, 0, sizeof(asRef));
+        for (i = 0; i < 100000; i++)
+        {
+            j = rnd(3);
+            t = random_ticks();
+            bIBit = rnd(2);
+            IBit = bIBit;
+            sysProfAdd(&asProbe[j], t);
+            CHECK(IBit == bIBit, "I-bit %d after sysProfAdd, was %d", IBit, bIBit);
+
+            t &= SYS_PROF_TICK_MASK;
+            if ((asRef[j].u32Count == 0) || (t < asRef[j].u32Min))
+                asRef[j].u32Min = t;
+            if (t > asRef[j].u32Max)
+                asRef[j].u32Max = t;
+            asRef[j].u32Count++;
+            asRef[j].u64Total += t;
+            asRef[j].au32Hist[ref_bin(t)]++;
+        }
+        IBit = TRUE;
+        for (j = 0; j < 3; j++)
+        {
+            CHECK(asProbe[j].u32Count == asRef[j].u32Count && asProbe[j].u32Min == asRef[j].u32Min && asProbe[j].u32Max == asRef[j].u32Max &&
+                  asProbe[j].u64Total == asRef[j].u64Total, "round %u, probe %u: count %u min %u max %u total %llu, expected %u %u %u %llu",
+                  u32Round, j, asProbe[j].u32Count, asProbe[j].u32Min, asProbe[j].u32Max, (unsigned long long)asProbe[j].u64Total,
+                  asRef[j].u32Count, asRef[j].u32Min, asRef[j].u32Max, (unsigned long long)asRef[j].u64Total);
+            CHECK(memcmp(asProbe[j].au32Hist, asRef[j].au32Hist, sizeof(asRef[j].au32Hist)) == 0, "round %u, probe %u: histogram", u32Round, j);
+        }
+
+        /* Each probe is listed once, with the ones of the other tests */
+        for (j = 0; j < 3; j++)
+        {
+            for (n = 0, psProbe = _sys_psProfList; psProbe != NULL; psProbe = psProbe->psNext)
+                n += (psProbe == &asProbe[j]);
+            CHECK(n == 1, "round %u: probe %u listed %u times", u32Round, j, n);
+        }
+        for (n = 0, psProbe = _sys_psProfList; psProbe != NULL; psProbe = psProbe->psNext)
+            n++;
+        CHECK(n == 5, "%u probes listed", n);
+
+        IBit = FALSE;
+        sysProfReset();
+        CHECK(!IBit, "sysProfReset enabled IRQ");
+        IBit = TRUE;
+        for (psProbe = _sys_psProfList; psProbe != NULL; psProbe = psProbe->psNext)
+        {
+            for (t = 0, i = 0; i < SYS_PROF_BINS; i++)
+                t |= psProbe->au32Hist[i];
+            CHECK(psProbe->u32Count == 0 && psProbe->u32Min == 0 && psProbe->u32Max == 0 && psProbe->u64Total == 0 && t == 0,
+                  "probe %s not reset", psProbe->pcName);
+        }
+        if (Errors != e)
+            break;
+    }
+
+    /* The first duration after a reset sets the minimum, even when it is above the old one */
+    sysProfAdd(&asProbe[0], 1000);
+    sysProfAdd(&asProbe[0], 2000);
+    CHECK(asProbe[0].u32Min == 1000 && asProbe[0].u32Max == 2000, "min %u max %u after a reset", asProbe[0].u32Min, asProbe[0].u32Max);
+    sysProfReset();
+    CHECK(asProbe[0].u32Min == 0, "min %u after a reset", asProbe[0].u32Min);
+    printf("probe statistics: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+SYS_PROF_DEFINE(s_sDump, "dump probe")
+
+static void test_dump(void)
+{
+    char acOut[4096];
+    unsigned count, min, avg, max, total;
+    FILE *f;
+    int fd, n;
+    int e = Errors;
+
+    /* 300 MHz CPU, 150 MHz ticks: one tick is two cycles */
+    CHECK(sys_prof_cycles(0) == 0 && sys_prof_cycles(12345) == 24690, "12345 ticks are %u cycles", sys_prof_cycles(12345));
+    CHECK(sys_prof_cycles(0x7FFFFFFF) == 0xFFFFFFFE && sys_prof_cycles(0x80000000ull) == 0xFFFFFFFF, "cycles not saturated at 32 bits");
+    CpuMHz = 300;
+    PclkMHz = 75;
+    CHECK(sys_prof_cycles(100) == 400, "100 ticks at 75 MHz are %u cycles", sys_prof_cycles(100));
+    PclkMHz = 150;
+
+    sysProfAdd(&s_sDump, 100);
+    sysProfAdd(&s_sDump, 300);
+    sysProfAdd(&s_sDump, 2000);
+
+    /* Only the probe that recorded since the reset is printed */
+    f = tmpfile();
+    fflush(stdout);
+    fd = dup(1);
+    dup2(fileno(f), 1);
+    sysProfDump();
+    fflush(stdout);
+    dup2(fd, 1);
+    close(fd);
+    rewind(f);
+    n = (int)fread(acOut, 1, sizeof(acOut) - 1, f);
+    acOut[n < 0 ? 0 : n] = '\0';
+    fclose(f);
+
+    CHECK(strstr(acOut, "wrap") == NULL && strstr(acOut, "dump probe") != NULL, "dump:\n%s", acOut);
+    n = sscanf(strstr(acOut, "dump probe") ? strstr(acOut, "dump probe") + 11 : "", "%u %u %u %u %u", &count, &min, &avg, &max, &total);
+    CHECK(n == 5 && count == 3 && min == 200 && avg == 1600 && max == 4000 && total == 4, "dump line: %d fields, %u %u %u %u %u",
+          n, count, min, avg, max, total);
+    CHECK(strstr(acOut, " 7:1 9:1 11:1") != NULL, "histogram line missing:\n%s", acOut);
+    printf("cycles and dump: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+int main(void)
+{
+    test_init();
+    test_bin();
+    test_wrap();
+    test_add();
+    test_dump();
+
+    printf("prof: %s\n", Errors ? "FAIL" : "PASS");
+    return Errors != 0;
+}
@@ -0,0 +1,324 @@
+/*
+ * Host check of the sample rate converter, Driver/Source/resample.c, built
+ * with the C versions of the DSP instructions.
+ *
+ * - THD+N of two -1 dBFS tones for the conversions of the I2S_Resample
+ *   sample, which must stay below -80 dB.
+ * - The output does not depend on how the input is split into calls, and
+ *   i2sSrcReadFifo() takes only the input its outputs need.
+ * - The UAC microphone and speaker bridges of the sample over 60 s of
+ *   simulated USB and I2S clocks up to 300 ppm apart. After the loop has
+ *   settled the FIFO neither overruns nor underruns, and the mean drift
+ *   correction is within 10 ppm of the true clock offset.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "resample.c"
+
+#define IN_MAX          48000       /* One second at the highest input rate */
+#define OUT_MAX         (48000 + 64)
+#define AMPLITUDE       29204       /* -1 dBFS */
+#define FIFO_FRAMES     1024
+#define FIFO_TARGET     512
+#define PERIOD_FRAMES   48          /* 1 ms I2S period at 48 kHz */
+#define BRIDGE_SECONDS  60
+
+static int16_t i16Coef[I2S_SRC_COEF_SIZE(I2S_SRC_TAPS_MAX)] __attribute__((aligned(32)));
+static uint32_t au32Hist[I2S_SRC_HIST_SIZE(I2S_SRC_TAPS_MAX)];
+static uint32_t au32In[IN_MAX], au32Out[OUT_MAX], au32Ref[OUT_MAX];
+static I2S_SRC_T sSrc;
+static int Errors;
+
+#define CHECK(c, ...)   do { if (!(c)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); Errors++; } } while (0)
+
+static const struct
+{
+    uint32_t u32In, u32Out, u32Taps;
+    int32_t i32Ppb;
+} tests[] =
+{
+    { 44100, 48000, 32,  0 },
+    { 48000, 44100, 36,  0 },
+    { 44100, 48000, 64,  0 },
+    { 16000, 48000, 32,  0 },
+    { 48000, 16000, 96,  0 },
+    { 48000, 48000, 32,  100000 },
+};
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Driver functions resample.c calls                                                                       */
+/*---------------------------------------------------------------------------------------------------------*/
+
+void sysMemSet(void *pvDst, INT32 i32Val, UINT32 u32Len)
+{
+    memset(pvDst, i32Val, u32Len);
+}
+
+void sysMemCopy(void *pvDst, const void *pvSrc, UINT32 u32Len)
+{
+    memcpy(pvDst, pvSrc, u32Len);
+}
+
+static void fifo_init(I2S_FIFO_T *psFifo, uint32_t *pu32Buf, uint32_t u32Size)
+{
+    psFifo->pu32Buf = pu32Buf;
+    psFifo->u32Size = u32Size;
+    psFifo->u32Head = psFifo->u32Tail = 0;
+}
+
+static uint32_t fifo_count(I2S_FIFO_T *psFifo)
+{
+    return psFifo->u32Head - psFifo->u32Tail;
+}
+
+static uint32_t fifo_write(I2S_FIFO_T *psFifo, const uint32_t *pu32Src, uint32_t n)
+{
+    uint32_t i;
+
+    if (n > psFifo->u32Size - fifo_count(psFifo))
+        n = psFifo->u32Size - fifo_count(psFifo);
+    for (i = 0; i < n; i++)
+        psFifo->pu32Buf[(psFifo->u32Head + i) & (psFifo->u32Size - 1)] = pu32Src[i];
+    psFifo->u32Head += n;
+    return n;
+}
+
+static uint32_t fifo_read(I2S_FIFO_T *psFifo, uint32_t *pu32Dst, uint32_t n)
+{
+    uint32_t i;
+
+    if (n > fifo_count(psFifo))
+        n = fifo_count(psFifo);
+    for (i = 0; i < n; i++)
+        pu32Dst[i] = psFifo->pu32Buf[(psFifo->u32Tail + i) & (psFifo->u32Size - 1)];
+    psFifo->u32Tail += n;
+    return n;
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Test signal and THD+N, as in SampleCode/I2S_Resample                                                    */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static void gen_tone(uint32_t *pu32Buf, uint32_t n, double f, int ch)
+{
+    uint32_t i, v;
+
+    for (i = 0; i < n; i++)
+    {
+        v = (uint16_t)(int16_t)lrint(sin(2 * M_PI * f * i) * AMPLITUDE);
+        pu32Buf[i] = ch ? (pu32Buf[i] & 0xFFFF) | (v << 16) : (pu32Buf[i] & 0xFFFF0000) | v;
+    }
+}
+
+/* Noise and distortion to signal ratio in dB, the signal a least squares fit of a sine at f cycles per sample */
+static double thdn(const uint32_t *pu32Buf, uint32_t n, double f, int ch)
+{
+    double ss = 0, cc = 0, sc = 0, s1 = 0, c1 = 0, vs = 0, vc = 0, v1 = 0, ps = 0, pn = 0;
+    double s, c, v, fit, a, b, dc, det;
+    uint32_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        v = (int16_t)(ch ? pu32Buf[i] >> 16 : pu32Buf[i]);
+        s = sin(2 * M_PI * f * i);
+        c = cos(2 * M_PI * f * i);
+        ss += s * s; cc += c * c; sc += s * c; s1 += s; c1 += c;
+        vs += v * s; vc += v * c; v1 += v;
+    }
+    det = ss * (cc * n - c1 * c1) - sc * (sc * n - c1 * s1) + s1 * (sc * c1 - cc * s1);
+    a = (vs * (cc * n - c1 * c1) - sc * (vc * n - c1 * v1) + s1 * (vc * c1 - cc * v1)) / det;
+    b = (ss * (vc * n - v1 * c1) - vs * (sc * n - c1 * s1) + s1 * (sc * v1 - vc * s1)) / det;
+    dc = (ss * (cc * v1 - c1 * vc) - sc * (sc * v1 - c1 * vs) + s1 * (sc * vc - cc * vs)) / det;
+    for (i = 0; i < n; i++)
+    {
+        v = (int16_t)(ch ? pu32Buf[i] >> 16 : pu32Buf[i]);
+        fit = a * sin(2 * M_PI * f * i) + b * cos(2 * M_PI * f * i) + dc;
+        ps += (fit - dc) * (fit - dc);
+        pn += (v - fit) * (v - fit);
+    }
+    return 10.0 * log10(pn / ps);
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Tests                                                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/* One second of input in blocks of 1 .. u32MaxBlock frames, returns the output frames */
+static uint32_t convert(uint32_t k, uint32_t u32MaxBlock, uint32_t *pu32Out, unsigned *seed)
+{
+    uint32_t u32InRate = tests[k].u32In, u32Used = 0, u32Made = 0, n;
+
+    i2sSrcInit(&sSrc, u32InRate, tests[k].u32Out, tests[k].u32Taps, i16Coef, au32Hist);
+    i2sSrcSetDrift(&sSrc, tests[k].i32Ppb);
+    while (u32Used < u32InRate)
+    {
+        n = 1 + (uint32_t)rand_r(seed) % u32MaxBlock;
+        if (n > u32InRate - u32Used)
+            n = u32InRate - u32Used;
+        u32Made += i2sSrcProcess(&sSrc, &au32In[u32Used], &n, &pu32Out[u32Made], OUT_MAX - u32Made);
+        u32Used += n;
+    }
+    return u32Made;
+}
+
+static void test_quality(void)
+{
+    uint32_t k, u32Low, u32Taps, u32Made, u32Ref;
+    double fl = 997.0, fr, scale, l, r;
+    unsigned seed = 1;
+
+    printf("rates          tap   ppm  left THD+N  right THD+N\n");
+    for (k = 0; k < sizeof(tests) / sizeof(tests[0]); k++)
+    {
+        u32Low = tests[k].u32In < tests[k].u32Out ? tests[k].u32In : tests[k].u32Out;
+        u32Taps = tests[k].u32Taps;
+        fr = u32Low * 0.2;
+        scale = 1.0 + tests[k].i32Ppb * 1e-9;
+        gen_tone(au32In, tests[k].u32In, fl / tests[k].u32In, 0);
+        gen_tone(au32In, tests[k].u32In, fr / tests[k].u32In, 1);
+
+        u32Ref = convert(k, tests[k].u32In, au32Ref, &seed);
+        u32Made = convert(k, 200, au32Out, &seed);
+        CHECK(u32Made == u32Ref && memcmp(au32Out, au32Ref, u32Made * 4) == 0, "output depends on the input blocks");
+
+        /* The first u32Taps outputs hold the start-up transient */
+        l = thdn(&au32Out[u32Taps], u32Made - 2 * u32Taps, fl * scale / tests[k].u32Out, 0);
+        r = thdn(&au32Out[u32Taps], u32Made - 2 * u32Taps, fr * scale / tests[k].u32Out, 1);
+        printf("%5u -> %5u %3u %+5d  %6.1f dB   %6.1f dB\n", tests[k].u32In, tests[k].u32Out, u32Taps,
+               tests[k].i32Ppb / 1000, l, r);
+        CHECK(l < -80.0 && r < -80.0, "THD+N above -80 dB");
+    }
+}
+
+static void test_read_fifo(void)
+{
+    static uint32_t au32Buf[FIFO_FRAMES];
+    I2S_FIFO_T sFifo;
+    uint32_t n, u32Made = 0, u32Fed = 0;
+
+    gen_tone(au32In, IN_MAX, 997.0 / 48000, 0);
+    i2sSrcInit(&sSrc, 48000, 44100, 32, i16Coef, au32Hist);
+    fifo_init(&sFifo, au32Buf, FIFO_FRAMES);
+    while (u32Made < 40000)
+    {
+        u32Fed += fifo_write(&sFifo, &au32In[u32Fed], 1 + (u32Fed * 7 % 300));
+        n = i2sSrcReadFifo(&sSrc, &sFifo, &au32Out[u32Made], 1 + (u32Made * 13 % 100));
+        u32Made += n;
+        /* Only the frames under the taps of the next output are taken ahead */
+        CHECK(sFifo.u32Tail <= (uint64_t)u32Made * 48000 / 44100 + 32 + 1, "%u frames taken for %u outputs", sFifo.u32Tail, u32Made);
+        if (Errors)
+            return;
+    }
+    i2sSrcInit(&sSrc, 48000, 44100, 32, i16Coef, au32Hist);
+    n = IN_MAX;
+    i2sSrcProcess(&sSrc, au32In, &n, au32Ref, u32Made);
+    CHECK(memcmp(au32Out, au32Ref, u32Made * 4) == 0, "i2sSrcReadFifo() output differs from i2sSrcProcess()");
+}
+
+static I2S_FIFO_T sFifo;
+static uint32_t au32Fifo[FIFO_FRAMES];
+static uint32_t u32Overruns, u32Underruns, u32Started;
+
+static void mic_in(uint32_t *pu32Data, uint32_t n)
+{
+    if (u32Started)
+        i2sSrcTrack(&sSrc, fifo_count(&sFifo), FIFO_TARGET);
+    if (i2sSrcWriteFifo(&sSrc, &sFifo, pu32Data, n) < n)
+        u32Overruns++;
+}
+
+static void spk_out(uint32_t *pu32Data, uint32_t n)
+{
+    if (u32Started)
+    {
+        i2sSrcTrack(&sSrc, fifo_count(&sFifo), FIFO_TARGET);
+        if (i2sSrcReadFifo(&sSrc, &sFifo, pu32Data, n) < n)
+            u32Underruns++;
+    }
+}
+
+/* The UAC bridges of the sample in 1 ms steps, returns the mean correction of the last half in ppm */
+static double bridge(int speaker, int32_t i32UsbPpm, int32_t i32I2sPpm)
+{
+    uint32_t au32Usb[64], au32Period[PERIOD_FRAMES];
+    double usb = 0.0, i2s = 0.0, sum = 0.0, mean, truth;
+    uint32_t ms, n, u32Xruns = 0;
+
+    i2sSrcInit(&sSrc, speaker ? 48000 : 44100, speaker ? 44100 : 48000, 32, i16Coef, au32Hist);
+    fifo_init(&sFifo, au32Fifo, FIFO_FRAMES);
+    gen_tone(au32Usb, 64, 997.0 / 44100, 0);
+    memset(au32Period, 0, sizeof(au32Period));
+    u32Overruns = u32Underruns = u32Started = 0;
+
+    for (ms = 0; ms < BRIDGE_SECONDS * 1000; ms++)
+    {
+        usb += 44.1 * (1.0 + i32UsbPpm * 1e-6);
+        n = (uint32_t)usb;
+        usb -= n;
+        if (!speaker)
+        {
+            mic_in(au32Usb, n);
+            if (!u32Started && (fifo_count(&sFifo) >= FIFO_TARGET))
+                u32Started = 1;
+        }
+        else
+            spk_out(au32Usb, n);
+
+        i2s += 1.0 + i32I2sPpm * 1e-6;
+        while (i2s >= 1.0)
+        {
+            i2s -= 1.0;
+            if (!speaker && u32Started && (fifo_read(&sFifo, au32Period, PERIOD_FRAMES) < PERIOD_FRAMES))
+                u32Underruns++;
+            if (speaker)
+            {
+                if (fifo_write(&sFifo, au32Period, PERIOD_FRAMES) < PERIOD_FRAMES)
+                    u32Overruns++;
+                if (fifo_count(&sFifo) >= FIFO_TARGET)
+                    u32Started = 1;
+            }
+        }
+
+        if (ms == BRIDGE_SECONDS * 1000 / 2)
+            u32Xruns = u32Overruns + u32Underruns;
+        if (ms >= BRIDGE_SECONDS * 1000 / 2)
+            sum += sSrc.i32Ppb;
+    }
+
+    /* Parts per million the input side runs faster than its nominal rate against the output side */
+    truth = speaker ? i32I2sPpm - i32UsbPpm : i32UsbPpm - i32I2sPpm;
+    mean = sum / (BRIDGE_SECONDS * 500) / 1000;
+    printf("%-8s %+5d %+5d  true %+5.0f ppm  mean correction %+7.1f ppm  xruns %u / %u\n",
+           speaker ? "speaker" : "mic", i32UsbPpm, i32I2sPpm, truth, mean, u32Xruns, u32Overruns + u32Underruns);
+    CHECK(fabs(mean - truth) <= 10.0, "mean correction %.1f ppm, true offset %.0f ppm", mean, truth);
+    CHECK(u32Overruns + u32Underruns == u32Xruns, "xruns after the loop settled");
+    return mean;
+}
+
+static void test_bridges(void)
+{
+    static const int32_t ppm[][2] = { { 0, 0 }, { 120, 0 }, { -250, 30 }, { 0, -80 }, { 200, 150 }, { 300, 0 }, { -300, 0 }, { 150, -150 } };
+    uint32_t k;
+
+    for (k = 0; k < sizeof(ppm) / sizeof(ppm[0]); k++)
+    {
+        bridge(0, ppm[k][0], ppm[k][1]);
+        bridge(1, ppm[k][0], ppm[k][1]);
+    }
+}
+
+int main(void)
+{
+    test_quality();
+    test_read_fifo();
+    test_bridges();
+
+    printf("resample: %s\n", Errors ? "FAIL" : "PASS");
+    return Errors != 0;
+}
@@ -0,0 +1,357 @@
+/*
+ * Decoder of the FreeRTOS trace ring, SampleCode/FreeRTOS/trace.c.
+ *
+ *   tracedec <uart capture> [<trace.json>]
+ *
+ * Reads what vTraceDump() prints between its markers, with any other UART
+ * output around it, and prints:
+ *
+ * - CPU usage of every task from its switches, time in ISRs excluded, and
+ *   of all ISRs together, over the time from the first task switch in the
+ *   ring to its last record;
+ * - log2 histograms of the run time of every interrupt source, and of the
+ *   latency of the tick interrupt carried by its records.
+ *
+ * With a second argument it also writes Chrome trace JSON for
+ * "chrome://tracing" or ui.perfetto.dev: task and ISR slices and queue
+ * operations.
+ *
+ * The 32-bit record times are extended to 64 bits, so a ring across the
+ * wrap of the run-time counter decodes in order.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+#define TD_MAX_TASKS    256
+#define TD_MAX_IRQ      256
+#define TD_NAME_LEN     32
+#define TD_HIST_BINS    12      /* 0, 1, 2-3, 4-7 ... 512-1023, >= 1024 us */
+
+typedef struct
+{
+    uint32_t hz;                /* Run-time counter rate */
+    uint32_t tick;              /* Interrupt number of the tick */
+    uint32_t count;
+    uint32_t size;
+    xTraceRecord *rec;
+    uint64_t *time;             /* Record times extended to 64 bits */
+    char name[TD_MAX_TASKS][TD_NAME_LEN];
+} TraceDump;
+
+typedef struct
+{
+    uint64_t span;                          /* Counts from the first task switch to the last record */
+    uint64_t task[TD_MAX_TASKS];            /* Counts each task ran, ISRs excluded */
+    uint32_t runs[TD_MAX_TASKS];            /* Times each task was switched in */
+    uint64_t isr;                           /* Counts in ISRs within the span */
+    uint32_t isr_count[TD_MAX_IRQ];
+    uint32_t isr_hist[TD_MAX_IRQ][TD_HIST_BINS];
+    uint32_t tick_hist[TD_HIST_BINS];
+} TraceStats;
+
+static double td_us(const TraceDump *d, uint64_t counts)
+{
+    return (double)counts * 1e6 / d->hz;
+}
+
+static uint32_t td_bin(const TraceDump *d, uint64_t counts)
+{
+    uint64_t us = counts * 1000000 / d->hz;
+    uint32_t bin = 0;
+
+    while ((us != 0) && (bin < TD_HIST_BINS - 1))
+    {
+        us >>= 1;
+        bin++;
+    }
+    return bin;
+}
+
+static int td_add(TraceDump *d, const xTraceRecord *r)
+{
+    if (d->count == d->size)
+    {
+        d->size = d->size ? d->size * 2 : 4096;
+        d->rec = realloc(d->rec, d->size * sizeof(d->rec[0]));
+        d->time = realloc(d->time, d->size * sizeof(d->time[0]));
+        if (!d->rec || !d->time)
+            return -1;
+    }
+    d->time[d->count] = d->count ? d->time[d->count - 1] + (uint32_t)(r->ulTime - d->rec[d->count - 1].ulTime) : r->ulTime;
+    d->rec[d->count++] = *r;
+    return 0;
+}
+
+/* Reads the first dump in f. Returns 0, or -1 without a complete dump. */
+static int trace_read(FILE *f, TraceDump *d)
+{
+    char line[256], *p;
+    unsigned a, b, c, e;
+    int in = 0;
+    xTraceRecord r;
+
+    memset(d, 0, sizeof(*d));
+    while (fgets(line, sizeof(line), f))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (!in)
+        {
+            in = (strcmp(line, "--- trace dump begin ---") == 0);
+            continue;
+        }
+        if (strcmp(line, "--- trace dump end ---") == 0)
+            return d->hz ? 0 : -1;
+        if (sscanf(line, "hz %u", &a) == 1)
+            d->hz = a;
+        else if (sscanf(line, "tick %u", &a) == 1)
+            d->tick = a;
+        else if ((strncmp(line, "task ", 5) == 0) && (sscanf(line + 5, "%u", &a) == 1) && (a < TD_MAX_TASKS))
+        {
+            p = strchr(line + 5, ' ');
+            if (p)
+                snprintf(d->name[a], TD_NAME_LEN, "%s", p + 1);
+        }
+        else if (sscanf(line, "%8x %2x %2x %4x", &a, &e, &b, &c) == 4)
+        {
+            r.ulTime = a;
+            r.ucEvent = (uint8_t)e;
+            r.ucArg = (uint8_t)b;
+            r.usId = (uint16_t)c;
+            if (td_add(d, &r) != 0)
+                return -1;
+        }
+    }
+    return -1;
+}
+
+static void trace_free(TraceDump *d)
+{
+    free(d->rec);
+    free(d->time);
+    d->rec = NULL;
+    d->time = NULL;
+}
+
+static const char *trace_task_name(const TraceDump *d, uint32_t n, char *buf)
+{
+    if ((n < TD_MAX_TASKS) && (d->name[n][0] != '\0'))
+        return d->name[n];
+    sprintf(buf, "task %u", n);
+    return buf;
+}
+
+static void trace_analyse(const TraceDump *d, TraceStats *s)
+{
+    uint64_t since = 0, start = 0, isr_start = 0;
+    uint32_t i, task = 0, irq = 0;
+    int known = 0, in_isr = 0;
+    const xTraceRecord *r;
+
+    memset(s, 0, sizeof(*s));
+    for (i = 0; i < d->count; i++)
+    {
+        r = &d->rec[i];
+        switch (r->ucEvent)
+        {
+        case traceEV_TASK_SWITCH:
+            /* A switch from an ISR charges the new task from the ISR exit */
+            if (known && !in_isr)
+                s->task[task] += d->time[i] - since;
+            if (!known)
+                start = d->time[i];
+            task = r->usId;
+            s->runs[task]++;
+            since = d->time[i];
+            known = 1;
+            break;
+
+        case traceEV_ISR_ENTER:
+            if (known && !in_isr)
+                s->task[task] += d->time[i] - since;
+            in_isr = 1;
+            isr_start = d->time[i];
+            irq = r->ucArg;
+            if (irq == d->tick)
+                s->tick_hist[td_bin(d, r->usId)]++;
+            break;
+
+        case traceEV_ISR_EXIT:
+            /* An exit without its entry opens the ring */
+            if (in_isr && (r->ucArg == irq))
+            {
+                s->isr_count[irq]++;
+                s->isr_hist[irq][td_bin(d, d->time[i] - isr_start)]++;
+                if (known)
+                    s->isr += d->time[i] - isr_start;
+            }
+            in_isr = 0;
+            since = d->time[i];
+            break;
+
+        default:
+            break;
+        }
+    }
+    if (known)
+    {
+        if (!in_isr)
+            s->task[task] += d->time[d->count - 1] - since;
+        else
+            s->isr += d->time[d->count - 1] - isr_start;
+        s->span = d->time[d->count - 1] - start;
+    }
+}
+
+static void trace_print_hist(FILE *out, const char *name, const uint32_t *hist)
+{
+    uint32_t i;
+
+    fprintf(out, "%-12s", name);
+    for (i = 0; i < TD_HIST_BINS; i++)
+        fprintf(out, " %6u", hist[i]);
+    fprintf(out, "\n");
+}
+
+static void trace_report(const TraceDump *d, const TraceStats *s, FILE *out)
+{
+    char buf[TD_NAME_LEN];
+    uint32_t i, j;
+
+    fprintf(out, "%u records, %.3f ms from the first task switch\n", d->count, td_us(d, s->span) / 1000);
+    fprintf(out, "Task            Time(us)      CPU   Runs\n");
+    for (i = 0; i < TD_MAX_TASKS; i++)
+    {
+        if (s->runs[i] == 0)
+            continue;
+        fprintf(out, "%-12s %11.0f  %6.2f%%  %5u\n", trace_task_name(d, i, buf), td_us(d, s->task[i]),
+                s->span ? 100.0 * s->task[i] / s->span : 0.0, s->runs[i]);
+    }
+    fprintf(out, "%-12s %11.0f  %6.2f%%\n", "(ISRs)", td_us(d, s->isr), s->span ? 100.0 * s->isr / s->span : 0.0);
+
+    fprintf(out, "\n%-12s", "Run (us)");
+    for (i = 0; i < TD_HIST_BINS - 1; i++)
+        fprintf(out, " %6u", i ? 1u << (i - 1) : 0);
+    fprintf(out, " %5u+\n", 1u << (TD_HIST_BINS - 2));
+    for (i = 0; i < TD_MAX_IRQ; i++)
+    {
+        if (s->isr_count[i] == 0)
+            continue;
+        sprintf(buf, "IRQ %u", i);
+        trace_print_hist(out, buf, s->isr_hist[i]);
+    }
+    for (i = 0, j = 0; i < TD_HIST_BINS; i++)
+        j += s->tick_hist[i];
+    if (j)
+        trace_print_hist(out, "Tick lat.", s->tick_hist);
+}
+
+static void trace_chrome(const TraceDump *d, FILE *out)
+{
+    static const char * const queue_ops[] =
+    {
+        "send", "receive", "send from ISR", "receive from ISR", "block", "timeout"
+    };
+    char buf[TD_NAME_LEN];
+    uint64_t base, task_start = 0, isr_start = 0;
+    uint32_t i, task = 0;
+    int known = 0, in_isr = 0;
+    const xTraceRecord *r;
+
+    base = d->count ? d->time[0] : 0;
+    fprintf(out, "{\"traceEvents\":[\n");
+    for (i = 0; i < d->count; i++)
+    {
+        r = &d->rec[i];
+        switch (r->ucEvent)
+        {
+        case traceEV_TASK_SWITCH:
+            if (known)
+                fprintf(out, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1},\n",
+                        trace_task_name(d, task, buf), td_us(d, task_start - base), td_us(d, d->time[i] - task_start));
+            task = r->usId;
+            task_start = d->time[i];
+            known = 1;
+            break;
+
+        case traceEV_ISR_ENTER:
+            isr_start = d->time[i];
+            in_isr = 1;
+            break;
+
+        case traceEV_ISR_EXIT:
+            if (in_isr)
+                fprintf(out, "{\"name\":\"IRQ %u\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":2},\n",
+                        r->ucArg, td_us(d, isr_start - base), td_us(d, d->time[i] - isr_start));
+            in_isr = 0;
+            break;
+
+        case traceEV_QUEUE_SEND:
+        case traceEV_QUEUE_RECEIVE:
+        case traceEV_QUEUE_SEND_ISR:
+        case traceEV_QUEUE_RECV_ISR:
+        case traceEV_QUEUE_BLOCK:
+        case traceEV_QUEUE_FAILED:
+            fprintf(out, "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":3,\"args\":{\"queue\":\"%04x\",\"type\":%u}},\n",
+                    queue_ops[r->ucEvent - traceEV_QUEUE_SEND], td_us(d, d->time[i] - base), r->usId, r->ucArg);
+            break;
+
+        default:
+            break;
+        }
+    }
+    if (known)
+        fprintf(out, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1},\n",
+                trace_task_name(d, task, buf), td_us(d, task_start - base), td_us(d, d->time[d->count - 1] - task_start));
+    fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Tasks\"}},\n");
+    fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"ISRs\"}},\n");
+    fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":3,\"args\":{\"name\":\"Queues\"}}\n");
+    fprintf(out, "]}\n");
+}
+
+#ifndef TRACEDEC_NO_MAIN
+static TraceDump Dump;
+static TraceStats Stats;
+
+int main(int argc, char *argv[])
+{
+    FILE *f;
+
+    if ((argc < 2) || (argc > 3))
+    {
+        fprintf(stderr, "usage: %s <uart capture> [<trace.json>]\n", argv[0]);
+        return 2;
+    }
+    f = fopen(argv[1], "r");
+    if (!f)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    if (trace_read(f, &Dump) != 0)
+    {
+        fprintf(stderr, "%s: no complete trace dump\n", argv[1]);
+        fclose(f);
+        return 1;
+    }
+    fclose(f);
+
+    trace_analyse(&Dump, &Stats);
+    trace_report(&Dump, &Stats, stdout);
+    if (argc == 3)
+    {
+        f = fopen(argv[2], "w");
+        if (!f)
+        {
+            perror(argv[2]);
+            return 1;
+        }
+        trace_chrome(&Dump, f);
+        fclose(f);
+    }
+    trace_free(&Dump);
+    return 0;
+}
+#endif
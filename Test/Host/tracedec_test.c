@@ -0,0 +1,311 @@
+/*
+ * Host check of the trace ring decoder, Test/Host/tracedec.c.
+ *
+ * A model of the FreeRTOS sample writes a dump as vTraceDump() prints it,
+ * inside other UART output with CR LF line ends, and keeps the true task
+ * and ISR times of its schedule.
+ *
+ * - Random schedules of tasks, interrupts, switches from the tick interrupt
+ *   and queue operations, across the wrap of the run-time counter: the task
+ *   and ISR times, the run counts and the ISR and tick latency histograms.
+ * - The Chrome trace JSON of the same dump: one slice per task run and per
+ *   ISR, one instant per queue operation, slice durations that add up to
+ *   the schedule, and a closed event list.
+ * - A ring that starts inside an ISR and before the first task switch.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACEDEC_NO_MAIN
+#include "tracedec.c"
+
+static int Errors;
+
+#define CHECK(c, ...)   do { if (!(c)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); Errors++; } } while (0)
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Model of the sample                                                                                     */
+/*---------------------------------------------------------------------------------------------------------*/
+
+#define HZ          750000
+#define TICK_IRQ    34
+#define TASKS       5
+
+static const char *Names[TASKS] = { "IDLE", "Check", "QConsB1", "QProdB2", "Tmr Svc" };
+
+static unsigned Seed = 1;
+
+static uint32_t rnd(uint32_t n)
+{
+    return (uint32_t)rand_r(&Seed) % n;
+}
+
+static FILE *Out;
+static uint32_t Now;
+static TraceStats Want;
+static uint32_t Records, QueueOps, IsrRuns, TaskRuns;
+
+static void emit(uint8_t ev, uint8_t arg, uint16_t id)
+{
+    fprintf(Out, "%08x %02x %02x %04x\r\n", Now, ev, arg, id);
+    Records++;
+}
+
+static uint32_t us_bin(uint64_t counts)
+{
+    uint64_t us = counts * 1000000 / HZ;
+    uint32_t bin = 0;
+
+    while (us)
+    {
+        us >>= 1;
+        bin++;
+    }
+    return bin < TD_HIST_BINS ? bin : TD_HIST_BINS - 1;
+}
+
+static void switch_to(uint32_t task)
+{
+    emit(traceEV_TASK_SWITCH, 0, (uint16_t)task);
+    Want.runs[task]++;
+    TaskRuns++;
+}
+
+static void schedule(uint32_t steps, uint32_t start)
+{
+    uint32_t step, task, d, lat, irq;
+
+    Now = start;
+    memset(&Want, 0, sizeof(Want));
+    Records = QueueOps = IsrRuns = TaskRuns = 0;
+
+    fprintf(Out, "FreeRTOS is starting ...\r\nCheck Task is running ...\r\n\r\n--- trace dump begin ---\r\n");
+    fprintf(Out, "hz %u\r\ntick %u\r\n", HZ, TICK_IRQ);
+    for (task = 0; task < TASKS; task++)
+        fprintf(Out, "task %u %s\r\n", task + 1, Names[task]);
+
+    task = 1 + rnd(TASKS);
+    switch_to(task);
+    for (step = 0; step < steps; step++)
+    {
+        d = rnd(step & 64 ? 20000 : 300);
+        Now += d;
+        Want.task[task] += d;
+        switch (rnd(6))
+        {
+        case 0:
+        case 1:
+            /* An interrupt, the tick one maybe switching tasks */
+            irq = rnd(3) ? TICK_IRQ : 20 + rnd(10);
+            lat = (irq == TICK_IRQ) ? rnd(step & 32 ? 2000 : 20) : 0;
+            d = rnd(step & 16 ? 1500 : 40);
+            emit(traceEV_ISR_ENTER, (uint8_t)irq, (uint16_t)lat);
+            Now += d / 2;
+            if ((irq == TICK_IRQ) && rnd(2))
+            {
+                task = 1 + rnd(TASKS);
+                switch_to(task);
+            }
+            Now += d - d / 2;
+            emit(traceEV_ISR_EXIT, (uint8_t)irq, 0);
+            Want.isr += d;
+            Want.isr_count[irq]++;
+            Want.isr_hist[irq][us_bin(d)]++;
+            if (irq == TICK_IRQ)
+                Want.tick_hist[us_bin(lat)]++;
+            IsrRuns++;
+            break;
+
+        case 2:
+            /* A yield */
+            task = 1 + rnd(TASKS);
+            switch_to(task);
+            break;
+
+        default:
+            emit((uint8_t)(traceEV_QUEUE_SEND + rnd(6)), (uint8_t)rnd(5), (uint16_t)rnd(0x10000));
+            QueueOps++;
+            break;
+        }
+    }
+    fprintf(Out, "--- trace dump end ---\r\nIdle: 12 wakeups/s\r\n");
+}
+
+static int decode(TraceDump *d)
+{
+    int ret;
+
+    rewind(Out);
+    ret = trace_read(Out, d);
+    rewind(Out);
+    return ret;
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Tests                                                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static TraceDump Dump;
+static TraceStats Stats;
+
+static int stats_match(uint32_t round)
+{
+    uint32_t i;
+    uint64_t total = 0;
+    int e = Errors;
+
+    for (i = 0; i < TD_MAX_TASKS; i++)
+    {
+        CHECK(Stats.task[i] == Want.task[i] && Stats.runs[i] == Want.runs[i], "round %u: task %u ran %llu counts in %u runs, expected %llu in %u",
+              round, i, (unsigned long long)Stats.task[i], Stats.runs[i], (unsigned long long)Want.task[i], Want.runs[i]);
+        total += Stats.task[i];
+    }
+    CHECK(Stats.isr == Want.isr, "round %u: %llu counts in ISRs, expected %llu", round,
+          (unsigned long long)Stats.isr, (unsigned long long)Want.isr);
+    CHECK(Stats.span == total + Stats.isr, "round %u: span %llu is not the sum of the tasks and ISRs", round, (unsigned long long)Stats.span);
+    CHECK(memcmp(Stats.isr_count, Want.isr_count, sizeof(Want.isr_count)) == 0, "round %u: ISR counts", round);
+    CHECK(memcmp(Stats.isr_hist, Want.isr_hist, sizeof(Want.isr_hist)) == 0, "round %u: ISR histograms", round);
+    CHECK(memcmp(Stats.tick_hist, Want.tick_hist, sizeof(Want.tick_hist)) == 0, "round %u: tick latency histogram", round);
+    return Errors == e;
+}
+
+static void test_stats(void)
+{
+    uint32_t round;
+    char report[8192];
+    FILE *f;
+
+    for (round = 0; round < 100; round++)
+    {
+        Out = tmpfile();
+        /* Every other round crosses the wrap of the 32-bit counter */
+        schedule(2000 + rnd(4000), (round & 1) ? 0xFFFFFFFFu - rnd(1000000) : rnd(0x80000000u));
+        CHECK(decode(&Dump) == 0, "round %u: dump not read", round);
+        CHECK(Dump.count == Records && Dump.hz == HZ && Dump.tick == TICK_IRQ, "round %u: %u records read of %u", round, Dump.count, Records);
+        CHECK(strcmp(Dump.name[2], "Check") == 0 && strcmp(Dump.name[5], "Tmr Svc") == 0, "round %u: task names", round);
+        trace_analyse(&Dump, &Stats);
+        fclose(Out);
+        if (!stats_match(round))
+            break;
+        trace_free(&Dump);
+    }
+
+    /* The report names the tasks and the interrupt sources */
+    f = fmemopen(report, sizeof(report), "w");
+    trace_report(&Dump, &Stats, f);
+    fclose(f);
+    CHECK(strstr(report, "QProdB2") && strstr(report, "IRQ 34") && strstr(report, "Tick lat."), "report:\n%s", report);
+    trace_free(&Dump);
+    printf("task and ISR statistics: %s\n", Errors ? "FAIL" : "ok");
+}
+
+static void test_chrome(void)
+{
+    static char json[4 << 20];
+    uint32_t slices = 0, isrs = 0, instants = 0, depth = 0;
+    double dur, task_us = 0, isr_us = 0;
+    char *p;
+    FILE *f;
+    int e = Errors;
+
+    Out = tmpfile();
+    schedule(3000, 0xFFFFF000u);
+    CHECK(decode(&Dump) == 0, "dump not read");
+    fclose(Out);
+
+    f = fmemopen(json, sizeof(json) - 1, "w");
+    trace_chrome(&Dump, f);
+    fclose(f);
+
+    CHECK(strncmp(json, "{\"traceEvents\":[\n", 17) == 0, "JSON start");
+    for (p = json; *p; p++)
+    {
+        if ((*p == '{') || (*p == '['))
+            depth++;
+        else if ((*p == '}') || (*p == ']'))
+        {
+            CHECK(depth > 0 && p[-1] != ',' && !(p[-1] == '\n' && p[-2] == ','), "JSON closes an empty or trailing element at %ld", (long)(p - json));
+            depth--;
+        }
+    }
+    CHECK(depth == 0, "JSON brackets do not balance");
+
+    for (p = json; (p = strstr(p, "\"ph\":\"X\"")) != NULL; p++)
+    {
+        CHECK(sscanf(strstr(p, "\"dur\":"), "\"dur\":%lf", &dur) == 1, "slice without a duration");
+        if (strstr(p, "\"tid\":1}") == strstr(p, "\"tid\":"))
+        {
+            slices++;
+            task_us += dur;
+        }
+        else
+        {
+            isrs++;
+            isr_us += dur;
+        }
+    }
+    for (p = json; (p = strstr(p, "\"ph\":\"i\"")) != NULL; p++)
+        instants++;
+
+    CHECK(slices == TaskRuns && isrs == IsrRuns && instants == QueueOps, "%u task slices, %u ISR slices, %u queue operations, expected %u, %u and %u",
+          slices, isrs, instants, TaskRuns, IsrRuns, QueueOps);
+    /* Task slices run from switch to switch and cover the ISRs in them */
+    CHECK(task_us > td_us(&Dump, Dump.time[Dump.count - 1] - Dump.time[0]) - 0.001 * slices &&
+          task_us < td_us(&Dump, Dump.time[Dump.count - 1] - Dump.time[0]) + 0.001 * slices, "task slices last %.3f us", task_us);
+    CHECK(isr_us > td_us(&Dump, Want.isr) - 0.001 * isrs && isr_us < td_us(&Dump, Want.isr) + 0.001 * isrs, "ISR slices last %.3f us", isr_us);
+    trace_free(&Dump);
+    printf("Chrome trace JSON: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+static void test_partial(void)
+{
+    int e = Errors;
+
+    /* The ring overwrote the start of an ISR and the switch to the running task */
+    Out = tmpfile();
+    fprintf(Out, "--- trace dump begin ---\nhz %u\ntick %u\n", HZ, TICK_IRQ);
+    fprintf(Out, "00000100 05 22 0000\n");      /* Exit of the tick without its entry */
+    fprintf(Out, "00000180 06 00 1234\n");
+    fprintf(Out, "00000200 04 15 0000\n");      /* A whole ISR before the first switch */
+    fprintf(Out, "00000250 05 15 0000\n");
+    fprintf(Out, "00000300 01 00 0003\n");      /* The accounting starts here */
+    fprintf(Out, "00000400 04 22 0010\n");
+    fprintf(Out, "00000420 01 00 0004\n");      /* Switch in the tick interrupt */
+    fprintf(Out, "00000440 05 22 0000\n");
+    fprintf(Out, "00000500 04 15 0000\n");
+    fprintf(Out, "00000520 08 01 4321\n");      /* Ends inside this ISR */
+    fprintf(Out, "--- trace dump end ---\n");
+    CHECK(decode(&Dump) == 0 && Dump.count == 10, "partial ring not read");
+    fclose(Out);
+    trace_analyse(&Dump, &Stats);
+
+    CHECK(Stats.span == 0x220, "span %llu", (unsigned long long)Stats.span);
+    CHECK(Stats.task[3] == 0x100 && Stats.task[4] == 0xC0, "task times %llu and %llu", (unsigned long long)Stats.task[3],
+          (unsigned long long)Stats.task[4]);
+    CHECK(Stats.isr == 0x60, "%llu counts in ISRs", (unsigned long long)Stats.isr);
+    CHECK(Stats.isr_count[0x22] == 1 && Stats.isr_count[0x15] == 1, "ISR counts %u and %u", Stats.isr_count[0x22], Stats.isr_count[0x15]);
+    CHECK(Stats.tick_hist[us_bin(0x10)] == 1, "tick latency");
+    CHECK(strcmp(trace_task_name(&Dump, 3, (char[TD_NAME_LEN]){0}), "task 3") == 0, "name of an unnamed task");
+    trace_free(&Dump);
+
+    /* A capture cut off before the end marker */
+    Out = tmpfile();
+    fprintf(Out, "--- trace dump begin ---\nhz %u\n00000100 01 00 0001\n", HZ);
+    CHECK(decode(&Dump) != 0, "incomplete dump accepted");
+    fclose(Out);
+    trace_free(&Dump);
+    printf("partial ring: %s\n", Errors != e ? "FAIL" : "ok");
+}
+
+int main(void)
+{
+    test_stats();
+    test_chrome();
+    test_partial();
+
+    printf("tracedec: %s\n", Errors ? "FAIL" : "PASS");
+    return Errors != 0;
+}
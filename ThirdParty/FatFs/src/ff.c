@@ -500,7 +500,7 @@ static BYTE CurrVol;			/* Current drive */
 #endif
 
 #if _FS_LOCK != 0
-static FILESEM Files[_FS_LOCK];	/* Open object lock semaphores */
+static FILESEM Files[_VOLUMES][_FS_LOCK];	/* Open object lock semaphores of each volume */
 #endif
 
 #if _USE_LFN == 0			/* Non-LFN configuration */
@@ -668,12 +668,16 @@ void st_qword (BYTE* ptr, QWORD val)	/* Store an 8-byte word in little-endian */
 /* Copy memory to memory */
 static
 void mem_cpy (void* dst, const void* src, UINT cnt) {
+#ifdef _FS_MEMCPY
+	_FS_MEMCPY(dst, src, cnt);
+#else
 	BYTE *d = (BYTE*)dst;
 	const BYTE *s = (const BYTE*)src;
 
 	if (cnt) {
 		do *d++ = *s++; while (--cnt);
 	}
+#endif
 }
 
 /* Fill memory block */
@@ -739,6 +743,21 @@ void unlock_fs (
 /* File lock control functions                                           */
 /*-----------------------------------------------------------------------*/
 #if _FS_LOCK != 0
+/* Each volume has its own semaphore table. It is accessed only while the
+/  volume is locked, so that objects on different volumes can be opened and
+/  closed in parallel at the thread-safe configuration. */
+
+static
+FILESEM* lock_tbl (	/* Returns the semaphore table of the volume */
+	FATFS* fs		/* File system object registered to the volume */
+)
+{
+	UINT vol;
+
+	for (vol = 0; vol < _VOLUMES - 1 && FatFs[vol] != fs; vol++) ;
+	return Files[vol];
+}
+
 
 static
 FRESULT chk_lock (	/* Check if the file can be accessed */
@@ -746,6 +765,7 @@ FRESULT chk_lock (	/* Check if the file can be accessed */
 	int acc			/* Desired access type (0:Read, 1:Write, 2:Delete/Rename) */
 )
 {
+	FILESEM *Files = lock_tbl(dp->obj.fs);
 	UINT i, be;
 
 	/* Search file semaphore table */
@@ -768,8 +788,11 @@ FRESULT chk_lock (	/* Check if the file can be accessed */
 
 
 static
-int enq_lock (void)	/* Check if an entry is available for a new object */
+int enq_lock (	/* Check if an entry is available for a new object */
+	FATFS* fs	/* File system object */
+)
 {
+	FILESEM *Files = lock_tbl(fs);
 	UINT i;
 
 	for (i = 0; i < _FS_LOCK && Files[i].fs; i++) ;
@@ -783,6 +806,7 @@ UINT inc_lock (	/* Increment object open counter and returns its index (0:Intern
 	int acc		/* Desired access (0:Read, 1:Write, 2:Delete/Rename) */
 )
 {
+	FILESEM *Files = lock_tbl(dp->obj.fs);
 	UINT i;
 
 
@@ -811,9 +835,11 @@ UINT inc_lock (	/* Increment object open counter and returns its index (0:Intern
 
 static
 FRESULT dec_lock (	/* Decrement object open counter */
+	FATFS* fs,		/* File system object */
 	UINT i			/* Semaphore index (1..) */
 )
 {
+	FILESEM *Files = lock_tbl(fs);
 	WORD n;
 	FRESULT res;
 
@@ -837,6 +863,7 @@ void clear_lock (	/* Clear lock entries of the volume */
 	FATFS *fs
 )
 {
+	FILESEM *Files = lock_tbl(fs);
 	UINT i;
 
 	for (i = 0; i < _FS_LOCK; i++) {
@@ -1395,6 +1422,33 @@ DWORD clmt_clust (	/* <2:Error, >=2:Cluster number */
 	}
 	return cl + *tbl;	/* Return the cluster number */
 }
+
+
+
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Contiguous sectors left in a fragment of the CLMT      */
+/*-----------------------------------------------------------------------*/
+
+static
+DWORD clmt_span (	/* 0:Error, >0:Number of sectors from ofs to the end of its fragment */
+	FIL* fp,		/* Pointer to the file object */
+	DWORD ofs		/* File offset to be converted */
+)
+{
+	DWORD cl, ncl, *tbl;
+	FATFS *fs = fp->obj.fs;
+
+
+	tbl = fp->cltbl + 1;	/* Top of CLMT */
+	cl = ofs / SS(fs) / fs->csize;	/* Cluster order from top of the file */
+	for (;;) {
+		ncl = *tbl++;			/* Number of cluters in the fragment */
+		if (ncl == 0) return 0;	/* End of table? (error) */
+		if (cl < ncl) break;	/* In this fragment? */
+		cl -= ncl; tbl++;		/* Next fragment */
+	}
+	return (ncl - cl) * fs->csize - (ofs / SS(fs) & (fs->csize - 1));
+}
 #endif	/* _USE_FASTSEEK */
 
 
@@ -3240,7 +3294,7 @@ FRESULT f_open (
 			if (res != FR_OK) {					/* No file, create new */
 				if (res == FR_NO_FILE)			/* There is no file to open, create a new entry */
 #if _FS_LOCK != 0
-					res = enq_lock() ? dir_register(&dj) : FR_TOO_MANY_OPEN_FILES;
+					res = enq_lock(dj.obj.fs) ? dir_register(&dj) : FR_TOO_MANY_OPEN_FILES;
 #else
 					res = dir_register(&dj);
 #endif
@@ -3384,6 +3438,9 @@ FRESULT f_read (
 	DWORD clst, sect;
 	FSIZE_t remain;
 	UINT rcnt, cc, csect;
+#if _USE_FASTSEEK
+	DWORD ncs;
+#endif
 	BYTE *rbuff = (BYTE*)buff;
 
 
@@ -3420,12 +3477,22 @@ FRESULT f_read (
 			sect += csect;
 			cc = btr / SS(fs);					/* When remaining bytes >= sector size, */
 			if (cc) {							/* Read maximum contiguous sectors directly */
+#if _USE_FASTSEEK
+				if (fp->cltbl) {				/* Clip at the end of the contiguous fragment */
+					ncs = clmt_span(fp, (DWORD)fp->fptr);
+					if (!ncs) ABORT(fs, FR_INT_ERR);
+					if (cc > ncs) cc = ncs;
+				} else
+#endif
 				if (csect + cc > fs->csize) {	/* Clip at cluster boundary */
 					cc = fs->csize - csect;
 				}
 				if (disk_read(fs->drv, rbuff, sect, cc) != RES_OK) {
 					ABORT(fs, FR_DISK_ERR);
 				}
+#if _USE_FASTSEEK
+				fp->clust += (csect + cc - 1) / fs->csize;	/* Last cluster touched by the transfer */
+#endif
 #if !_FS_READONLY && _FS_MINIMIZE <= 2			/* Replace one of the read sectors with cached data if it contains a dirty sector */
 #if _FS_TINY
 				if (fs->wflag && fs->winsect - sect < cc) {
@@ -3491,6 +3558,9 @@ FRESULT f_write (
 	FATFS *fs;
 	DWORD clst, sect;
 	UINT wcnt, cc, csect;
+#if _USE_FASTSEEK
+	DWORD ncs;
+#endif
 	const BYTE *wbuff = (const BYTE*)buff;
 
 
@@ -3548,12 +3618,22 @@ FRESULT f_write (
 			sect += csect;
 			cc = btw / SS(fs);				/* When remaining bytes >= sector size, */
 			if (cc) {						/* Write maximum contiguous sectors directly */
+#if _USE_FASTSEEK
+				if (fp->cltbl) {			/* Clip at the end of the contiguous fragment */
+					ncs = clmt_span(fp, (DWORD)fp->fptr);
+					if (!ncs) ABORT(fs, FR_INT_ERR);
+					if (cc > ncs) cc = ncs;
+				} else
+#endif
 				if (csect + cc > fs->csize) {	/* Clip at cluster boundary */
 					cc = fs->csize - csect;
 				}
 				if (disk_write(fs->drv, wbuff, sect, cc) != RES_OK) {
 					ABORT(fs, FR_DISK_ERR);
 				}
+#if _USE_FASTSEEK
+				fp->clust += (csect + cc - 1) / fs->csize;	/* Last cluster touched by the transfer */
+#endif
 #if _FS_MINIMIZE <= 2
 #if _FS_TINY
 				if (fs->winsect - sect < cc) {	/* Refill sector cache if it gets invalidated by the direct write */
@@ -3706,7 +3786,7 @@ FRESULT f_close (
 		res = validate(fp, &fs);	/* Lock volume */
 		if (res == FR_OK) {
 #if _FS_LOCK != 0
-			res = dec_lock(fp->obj.lockid);	/* Decrement file open counter */
+			res = dec_lock(fs, fp->obj.lockid);	/* Decrement file open counter */
 			if (res == FR_OK)
 #endif
 			{
@@ -3897,14 +3977,14 @@ FRESULT f_lseek (
 		if (ofs == CREATE_LINKMAP) {	/* Create CLMT */
 			tbl = fp->cltbl;
 			tlen = *tbl++; ulen = 2;	/* Given table size and required table size */
-			cl = fp->sclust;			/* Top of the chain */
+			cl = fp->obj.sclust;			/* Top of the chain */
 			if (cl) {
 				do {
 					/* Get a fragment */
 					tcl = cl; ncl = 0; ulen += 2;	/* Top, length and used items */
 					do {
 						pcl = cl; ncl++;
-						cl = get_fat(fs, cl);
+						cl = get_fat(&fp->obj, cl);
 						if (cl <= 1) ABORT(fs, FR_INT_ERR);
 						if (cl == 0xFFFFFFFF) ABORT(fs, FR_DISK_ERR);
 					} while (cl == pcl + 1);
@@ -3920,8 +4000,8 @@ FRESULT f_lseek (
 				res = FR_NOT_ENOUGH_CORE;	/* Given table size is smaller than required */
 			}
 		} else {						/* Fast seek */
-			if (ofs > fp->fsize) {		/* Clip offset at the file size */
-				ofs = fp->fsize;
+			if (ofs > fp->obj.objsize) {		/* Clip offset at the file size */
+				ofs = fp->obj.objsize;
 			}
 			fp->fptr = ofs;				/* Set file pointer */
 			if (ofs) {
@@ -3934,7 +4014,7 @@ FRESULT f_lseek (
 #if !_FS_READONLY
 					if (fp->flag & _FA_DIRTY) {		/* Write-back dirty sector cache */
 						if (disk_write(fs->drv, fp->buf, fp->sect, 1) != RES_OK) {
-							ABORT(fp, FR_DISK_ERR);
+							ABORT(fs, FR_DISK_ERR);
 						}
 						fp->flag &= ~_FA_DIRTY;
 					}
@@ -4120,7 +4200,7 @@ FRESULT f_closedir (
 	if (res == FR_OK) {
 #if _FS_LOCK != 0
 		if (dp->obj.lockid) {				/* Decrement sub-directory open counter */
-			res = dec_lock(dp->obj.lockid);
+			res = dec_lock(fs, dp->obj.lockid);
 		}
 		if (res == FR_OK)
 #endif
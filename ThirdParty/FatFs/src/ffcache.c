@@ -0,0 +1,662 @@
+/*---------------------------------------------------------------------------/
+/  FatFs sector cache - read-ahead and write-behind below disk_read/write
+/---------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "ffcache.h"
+
+#if _MIN_SS != _MAX_SS
+#error ffcache supports fixed sector size only
+#endif
+
+#define SS			_MAX_SS
+#define NIL			0xFFFF
+
+#define EF_VALID	0x01	/* Entry holds a sector */
+#define EF_DIRTY	0x02	/* Sector is not written to the device yet */
+#define EF_BUSY		0x04	/* Device I/O in progress, the entry must not be reused */
+
+#define MAX_RUN		(_FFC_READ_AHEAD * 2)	/* Largest device command of the pool */
+#define MAX_DIRTY	(_FFC_SECTORS / 2)		/* Dirty entries the pool may hold */
+
+#ifdef _FS_MEMCPY
+#define	COPY(d,s,n)		_FS_MEMCPY(d,s,n)
+#else
+#define	COPY(d,s,n)		memcpy(d,s,n)
+#endif
+
+/* Lock order is device, then pool. The pool lock is never held across a
+/  device command. An entry is set busy only by a task holding the device
+/  lock of its drive, so that task is the only one that sees entries of the
+/  drive in flux. Relocks after a device command retry until granted, so
+/  that busy entries are always released. */
+#if _FS_REENTRANT
+static _SYNC_t PoolLock;			/* Guards the pool and the drive states */
+#define	LOCK_POOL()		ff_req_grant(PoolLock)
+#define	RELOCK_POOL()	while (!ff_req_grant(PoolLock))
+#define	UNLOCK_POOL()	ff_rel_grant(PoolLock)
+#define	LOCK_DEV(dev)	ff_req_grant((dev)->sobj)
+#define	UNLOCK_DEV(dev)	ff_rel_grant((dev)->sobj)
+#else
+#define	LOCK_POOL()		1
+#define	RELOCK_POOL()
+#define	UNLOCK_POOL()
+#define	LOCK_DEV(dev)	1
+#define	UNLOCK_DEV(dev)
+#endif
+
+typedef struct {
+	FFC_DEV*	dev;		/* Attached device */
+	DWORD	nsect;			/* Number of sectors on the drive (0:unknown) */
+	DWORD	next;			/* Sector following the last read request */
+	UINT	ndirty;			/* Number of dirty entries of the drive */
+	FFC_STAT	stat;		/* Statistics */
+} DRIVE;
+
+static DRIVE Drive[_VOLUMES];
+static BYTE Init;
+
+
+#if _FFC_SECTORS
+
+typedef struct {
+	DWORD	sect;			/* Sector number */
+	BYTE	pdrv;			/* Physical drive number */
+	BYTE	flag;			/* EF_xxx */
+	WORD	prev, next;		/* LRU list links (prev is toward the head) */
+	WORD	hnext;			/* Hash chain link */
+} ENTRY;
+
+static BYTE Pool[_FFC_SECTORS][SS];	/* Sector data */
+static ENTRY Ent[_FFC_SECTORS];		/* Entry table */
+static WORD Hash[_FFC_SECTORS];		/* Hash chain heads */
+static WORD Head, Tail;				/* Most/least recently used entry */
+static UINT NDirty;					/* Number of dirty entries in the pool */
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Hash chain and LRU list maintenance                                   */
+/*-----------------------------------------------------------------------*/
+
+static
+UINT hash (BYTE pdrv, DWORD sect)
+{
+	return (UINT)((sect ^ ((DWORD)pdrv << 24)) % _FFC_SECTORS);
+}
+
+
+static
+void init_pool (void)
+{
+	UINT i;
+
+
+	for (i = 0; i < _FFC_SECTORS; i++) {
+		Ent[i].flag = 0;
+		Ent[i].prev = (WORD)(i ? i - 1 : NIL);
+		Ent[i].next = (WORD)(i < _FFC_SECTORS - 1 ? i + 1 : NIL);
+		Ent[i].hnext = NIL;
+		Hash[i] = NIL;
+	}
+	Head = 0; Tail = _FFC_SECTORS - 1;
+	NDirty = 0;
+}
+
+
+static
+WORD lookup (BYTE pdrv, DWORD sect)
+{
+	WORD i;
+
+
+	for (i = Hash[hash(pdrv, sect)]; i != NIL; i = Ent[i].hnext) {
+		if (Ent[i].sect == sect && Ent[i].pdrv == pdrv) break;
+	}
+	return i;
+}
+
+
+static
+void unhash (WORD i)
+{
+	WORD *p;
+
+
+	for (p = &Hash[hash(Ent[i].pdrv, Ent[i].sect)]; *p != NIL; p = &Ent[*p].hnext) {
+		if (*p == i) {
+			*p = Ent[i].hnext;
+			break;
+		}
+	}
+}
+
+
+static
+void unlink_lru (WORD i)
+{
+	if (Ent[i].prev != NIL) Ent[Ent[i].prev].next = Ent[i].next; else Head = Ent[i].next;
+	if (Ent[i].next != NIL) Ent[Ent[i].next].prev = Ent[i].prev; else Tail = Ent[i].prev;
+}
+
+
+static
+void touch (WORD i)	/* Move the entry to the head of LRU list */
+{
+	if (i == Head) return;
+	unlink_lru(i);
+	Ent[i].prev = NIL; Ent[i].next = Head;
+	Ent[Head].prev = i; Head = i;
+}
+
+
+static
+void set_dirty (WORD i, int dirty)
+{
+	if (!(Ent[i].flag & EF_DIRTY) == !dirty) return;
+	if (dirty) {
+		Ent[i].flag |= EF_DIRTY;
+		Drive[Ent[i].pdrv].ndirty++; NDirty++;
+	} else {
+		Ent[i].flag &= ~EF_DIRTY;
+		Drive[Ent[i].pdrv].ndirty--; NDirty--;
+	}
+}
+
+
+static
+void drop (WORD i)	/* Invalidate the entry and move it to the tail of LRU list */
+{
+	set_dirty(i, 0);
+	unhash(i);
+	Ent[i].flag = 0;
+	if (i == Tail) return;
+	unlink_lru(i);
+	Ent[i].next = NIL; Ent[i].prev = Tail;
+	Ent[Tail].next = i; Tail = i;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Assign clean entries to sectors                                       */
+/*-----------------------------------------------------------------------*/
+
+static
+UINT reserve (	/* Returns the number of entries assigned */
+	BYTE pdrv,		/* Physical drive number */
+	DWORD sect,		/* First sector */
+	UINT n,			/* Number of sectors */
+	WORD* ent		/* Assigned entries, busy until released */
+)
+{
+	WORD i, p;
+	UINT k = 0;
+
+
+	for (i = Tail; i != NIL && k < n; i = p) {	/* Least recently used clean entries first */
+		p = Ent[i].prev;
+		if (Ent[i].flag & (EF_DIRTY | EF_BUSY)) continue;
+		if (Ent[i].flag & EF_VALID) unhash(i);
+		Ent[i].sect = sect + k;
+		Ent[i].pdrv = pdrv;
+		Ent[i].flag = EF_VALID | EF_BUSY;
+		Ent[i].hnext = Hash[hash(pdrv, sect + k)];
+		Hash[hash(pdrv, sect + k)] = i;
+		touch(i);
+		ent[k++] = i;
+	}
+	return k;
+}
+
+
+static
+void release (	/* Unpin reserved entries, keeping the first n of them */
+	const WORD* ent,	/* Entries */
+	UINT count,			/* Number of entries */
+	UINT n				/* Number of entries that hold valid data */
+)
+{
+	UINT k;
+
+
+	for (k = 0; k < count; k++) {
+		if (k < n) Ent[ent[k]].flag &= ~EF_BUSY; else drop(ent[k]);
+	}
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Write back all dirty sectors of a drive in sector order               */
+/*-----------------------------------------------------------------------*/
+
+static
+DRESULT flush (	/* Called with the device lock of the drive */
+	BYTE pdrv		/* Physical drive number */
+)
+{
+	DRIVE *dr = &Drive[pdrv];
+	FFC_DEV *dev = dr->dev;
+	WORD ent[MAX_RUN], i;
+	UINT run, j;
+	DWORD sect;
+	DRESULT res;
+
+
+	for (;;) {
+		if (!LOCK_POOL()) return RES_NOTRDY;
+		for (ent[0] = NIL, i = 0; i < _FFC_SECTORS; i++) {	/* Lowest dirty sector of the drive */
+			if ((Ent[i].flag & (EF_DIRTY | EF_BUSY)) == EF_DIRTY && Ent[i].pdrv == pdrv
+				&& (ent[0] == NIL || Ent[i].sect < Ent[ent[0]].sect)) ent[0] = i;
+		}
+		if (ent[0] == NIL) break;
+		sect = Ent[ent[0]].sect;
+		Ent[ent[0]].flag |= EF_BUSY;
+		for (run = 1; run < dev->nstage && run < MAX_RUN; run++) {	/* Pin the run of adjacent dirty sectors */
+			i = lookup(pdrv, sect + run);
+			if (i == NIL || (Ent[i].flag & (EF_DIRTY | EF_BUSY)) != EF_DIRTY) break;
+			Ent[i].flag |= EF_BUSY;
+			ent[run] = i;
+		}
+		UNLOCK_POOL();
+
+		if (run == 1) {
+			res = dev->write(pdrv, Pool[ent[0]], sect, 1);
+		} else {
+			for (j = 0; j < run; j++) COPY(dev->stage + j * SS, Pool[ent[j]], SS);
+			res = dev->write(pdrv, dev->stage, sect, run);
+		}
+		dr->stat.wrcmd++;
+		if (res == RES_OK) dr->stat.wrsect += run;
+
+		RELOCK_POOL();
+		for (j = 0; j < run; j++) {
+			Ent[ent[j]].flag &= ~EF_BUSY;
+			if (res == RES_OK) set_dirty(ent[j], 0);
+		}
+		UNLOCK_POOL();
+		if (res != RES_OK) return res;
+	}
+	UNLOCK_POOL();
+	return RES_OK;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Read a run of missing sectors into the pool                           */
+/*-----------------------------------------------------------------------*/
+
+static
+DRESULT fetch (
+	BYTE pdrv,		/* Physical drive number */
+	BYTE* buff,		/* Data buffer for the first n sectors */
+	DWORD sector,	/* Start sector number */
+	UINT n,			/* Number of sectors requested */
+	UINT total		/* Number of sectors to read, n plus read-ahead */
+)
+{
+	DRIVE *dr = &Drive[pdrv];
+	FFC_DEV *dev = dr->dev;
+	WORD ent[MAX_RUN];
+	UINT got, k;
+	DRESULT res;
+
+
+	if (!LOCK_DEV(dev)) return RES_NOTRDY;
+	if (!LOCK_POOL()) {
+		UNLOCK_DEV(dev);
+		return RES_NOTRDY;
+	}
+	got = reserve(pdrv, sector, total, ent);
+	if (got < total && dr->ndirty) {	/* Own dirty sectors crowd the pool, write them back */
+		release(ent, got, 0);
+		UNLOCK_POOL();
+		res = flush(pdrv);
+		if (res != RES_OK) {
+			UNLOCK_DEV(dev);
+			return res;
+		}
+		RELOCK_POOL();
+		got = reserve(pdrv, sector, total, ent);
+	}
+	if (got < n) {		/* Entries are busy with other devices, read past the pool */
+		release(ent, got, 0);
+		got = 0;
+		total = n;
+	} else {
+		total = got;
+	}
+	UNLOCK_POOL();
+
+	res = dev->read(pdrv, dev->stage, sector, total);
+	dr->stat.rdcmd++;
+	if (res != RES_OK && total > n) {	/* Read-ahead may run off the media, retry the requested part */
+		total = n;
+		res = dev->read(pdrv, dev->stage, sector, total);
+		dr->stat.rdcmd++;
+	}
+	if (res == RES_OK) {
+		dr->stat.miss += n;
+		dr->stat.ahead += total - n;
+		for (k = 0; k < got && k < total; k++) COPY(Pool[ent[k]], dev->stage + k * SS, SS);
+		COPY(buff, dev->stage, n * SS);
+	}
+
+	if (got) {
+		RELOCK_POOL();
+		release(ent, got, res == RES_OK ? total : 0);
+		UNLOCK_POOL();
+	}
+	UNLOCK_DEV(dev);
+	return res;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Hold written sectors in the pool                                      */
+/*-----------------------------------------------------------------------*/
+
+#if _FFC_WRITE_BEHIND
+static
+int hold (	/* 1:Done, 0:No room, write through */
+	BYTE pdrv,			/* Physical drive number */
+	const BYTE* buff,	/* Data to be written */
+	DWORD sector,		/* Start sector number */
+	UINT count,			/* Number of sectors to write */
+	DRESULT* res		/* Result when done */
+)
+{
+	DRIVE *dr = &Drive[pdrv];
+	UINT k, need, avail;
+	WORD i;
+
+
+	*res = RES_NOTRDY;
+	if (!LOCK_POOL()) return 1;
+	if (NDirty + count > MAX_DIRTY && dr->ndirty) {	/* Make room by writing back the drive */
+		UNLOCK_POOL();
+		if (!LOCK_DEV(dr->dev)) return 1;
+		*res = flush(pdrv);
+		UNLOCK_DEV(dr->dev);
+		if (*res != RES_OK) return 1;
+		if (!LOCK_POOL()) {
+			*res = RES_NOTRDY;
+			return 1;
+		}
+	}
+	for (need = k = 0; k < count; k++) {
+		if (lookup(pdrv, sector + k) == NIL) need++;
+	}
+	for (avail = i = 0; i < _FFC_SECTORS; i++) {
+		if (!(Ent[i].flag & (EF_DIRTY | EF_BUSY))) avail++;
+	}
+	if (NDirty + count > MAX_DIRTY || avail < need + count) {	/* Other drives hold the room */
+		UNLOCK_POOL();
+		return 0;
+	}
+
+	for (k = 0; k < count; k++) {
+		i = lookup(pdrv, sector + k);
+		if (i == NIL) {
+			reserve(pdrv, sector + k, 1, &i);
+			Ent[i].flag &= ~EF_BUSY;
+		} else {
+			touch(i);
+		}
+		COPY(Pool[i], buff + k * SS, SS);
+		set_dirty(i, 1);
+	}
+	UNLOCK_POOL();
+	*res = RES_OK;
+	return 1;
+}
+#endif
+
+#endif	/* _FFC_SECTORS */
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Initialize the Cache                                                  */
+/*-----------------------------------------------------------------------*/
+
+void ffc_init (void)
+{
+	if (Init) return;
+#if _FFC_SECTORS
+	init_pool();
+#endif
+#if _FS_REENTRANT
+	if (!ff_cre_syncobj(0, &PoolLock)) return;
+#endif
+	Init = 1;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Attach a Device to a Drive                                            */
+/*-----------------------------------------------------------------------*/
+
+void ffc_attach (
+	BYTE pdrv,			/* Physical drive number */
+	FFC_DEV* dev,		/* Device functions and staging buffer */
+	DWORD nsect			/* Number of sectors on the drive (0:unknown) */
+)
+{
+	DRIVE *dr = &Drive[pdrv];
+#if _FFC_SECTORS
+	WORD i;
+#endif
+
+
+	if (pdrv >= _VOLUMES) return;
+	ffc_init();
+#if _FS_REENTRANT
+	if (!dev->sobj && !ff_cre_syncobj(pdrv, &dev->sobj)) return;
+#endif
+	if (!LOCK_POOL()) return;
+#if _FFC_SECTORS
+	for (i = 0; i < _FFC_SECTORS; i++) {	/* Sectors of the previous media are no longer valid */
+		if ((Ent[i].flag & EF_VALID) && Ent[i].pdrv == pdrv) drop(i);
+	}
+#endif
+	memset(dr, 0, sizeof (DRIVE));
+	dr->dev = dev;
+	dr->nsect = nsect;
+	dr->next = 0xFFFFFFFF;
+	UNLOCK_POOL();
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Read Sector(s)                                                        */
+/*-----------------------------------------------------------------------*/
+
+DRESULT ffc_read (
+	BYTE pdrv,		/* Physical drive number */
+	BYTE* buff,		/* Data buffer to store read data */
+	DWORD sector,	/* Start sector number */
+	UINT count		/* Number of sectors to read */
+)
+{
+	DRIVE *dr = &Drive[pdrv];
+	FFC_DEV *dev;
+	DRESULT res;
+#if _FFC_SECTORS
+	UINT n, total, k, seq;
+	WORD i;
+#endif
+
+
+	if (pdrv >= _VOLUMES || !dr->dev) return RES_NOTRDY;
+	dev = dr->dev;
+
+#if _FFC_SECTORS
+	seq = (sector == dr->next);
+	dr->next = sector + count;
+
+	if (count > _FFC_READ_AHEAD) {	/* Bulk transfer goes straight to the device */
+		if (!LOCK_DEV(dev)) return RES_NOTRDY;
+		res = dev->read(pdrv, buff, sector, count);
+		dr->stat.rdcmd++;
+		if (res == RES_OK) {	/* Cached sectors may not be written back yet. The device */
+			RELOCK_POOL();		/* lock keeps them from being written back meanwhile. */
+			for (k = 0; k < count; k++) {
+				i = lookup(pdrv, sector + k);
+				if (i != NIL && (Ent[i].flag & EF_DIRTY)) COPY(buff + k * SS, Pool[i], SS);
+			}
+			UNLOCK_POOL();
+		}
+		UNLOCK_DEV(dev);
+		return res;
+	}
+
+	if (!LOCK_POOL()) return RES_NOTRDY;
+	while (count) {
+		i = lookup(pdrv, sector);
+		if (i != NIL) {		/* Hit */
+			COPY(buff, Pool[i], SS);
+			touch(i);
+			dr->stat.hit++;
+			buff += SS; sector++; count--;
+			continue;
+		}
+
+		/* Miss: fetch the run of missing sectors, extended when the drive is read sequentially */
+		for (n = 1; n < count && n < dev->nstage && lookup(pdrv, sector + n) == NIL; n++) ;
+		total = n;
+		if (seq && n == count) {
+			while (total < n + _FFC_READ_AHEAD && total < dev->nstage && total < _FFC_SECTORS / 2
+				&& (!dr->nsect || sector + total < dr->nsect) && lookup(pdrv, sector + total) == NIL) total++;
+		}
+		UNLOCK_POOL();
+		res = fetch(pdrv, buff, sector, n, total);
+		if (res != RES_OK) return res;
+		buff += n * SS; sector += n; count -= n;
+		if (!LOCK_POOL()) return RES_NOTRDY;
+	}
+	UNLOCK_POOL();
+	return RES_OK;
+#else
+	if (!LOCK_DEV(dev)) return RES_NOTRDY;
+	res = dev->read(pdrv, buff, sector, count);
+	dr->stat.rdcmd++;
+	UNLOCK_DEV(dev);
+	return res;
+#endif
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Write Sector(s)                                                       */
+/*-----------------------------------------------------------------------*/
+
+DRESULT ffc_write (
+	BYTE pdrv,			/* Physical drive number */
+	const BYTE* buff,	/* Data to be written */
+	DWORD sector,		/* Start sector number */
+	UINT count			/* Number of sectors to write */
+)
+{
+	DRIVE *dr = &Drive[pdrv];
+	FFC_DEV *dev;
+	DRESULT res;
+#if _FFC_SECTORS
+	UINT k;
+	WORD i;
+#endif
+
+
+	if (pdrv >= _VOLUMES || !dr->dev) return RES_NOTRDY;
+	dev = dr->dev;
+
+#if _FFC_SECTORS
+#if _FFC_WRITE_BEHIND
+	if (count <= _FFC_READ_AHEAD && hold(pdrv, buff, sector, count, &res)) return res;
+#endif
+
+	if (!LOCK_DEV(dev)) return RES_NOTRDY;
+	if (count > _FFC_READ_AHEAD) {	/* Bulk transfer goes straight to the device */
+		if (!LOCK_POOL()) {
+			UNLOCK_DEV(dev);
+			return RES_NOTRDY;
+		}
+		for (k = 0; k < count; k++) {	/* Drop superseded sectors before they can be written back */
+			i = lookup(pdrv, sector + k);
+			if (i != NIL) drop(i);
+		}
+		UNLOCK_POOL();
+	}
+	res = dev->write(pdrv, buff, sector, count);
+	dr->stat.wrcmd++;
+	if (res == RES_OK) dr->stat.wrsect += count;
+	if (res == RES_OK && count <= _FFC_READ_AHEAD) {
+		RELOCK_POOL();
+		for (k = 0; k < count; k++) {	/* Keep cached copies consistent */
+			i = lookup(pdrv, sector + k);
+			if (i != NIL) {
+				COPY(Pool[i], buff + k * SS, SS);
+				set_dirty(i, 0);
+			}
+		}
+		UNLOCK_POOL();
+	}
+	UNLOCK_DEV(dev);
+	return res;
+#else
+	if (!LOCK_DEV(dev)) return RES_NOTRDY;
+	res = dev->write(pdrv, buff, sector, count);
+	dr->stat.wrcmd++;
+	if (res == RES_OK) dr->stat.wrsect += count;
+	UNLOCK_DEV(dev);
+	return res;
+#endif
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Write Back Dirty Sectors                                              */
+/*-----------------------------------------------------------------------*/
+
+DRESULT ffc_sync (
+	BYTE pdrv		/* Physical drive number */
+)
+{
+#if _FFC_SECTORS
+	DRESULT res;
+
+
+	if (pdrv >= _VOLUMES || !Drive[pdrv].dev) return RES_NOTRDY;
+	if (!LOCK_DEV(Drive[pdrv].dev)) return RES_NOTRDY;
+	res = flush(pdrv);
+	UNLOCK_DEV(Drive[pdrv].dev);
+	return res;
+#else
+	if (pdrv >= _VOLUMES || !Drive[pdrv].dev) return RES_NOTRDY;
+	return RES_OK;
+#endif
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Get Statistics                                                        */
+/*-----------------------------------------------------------------------*/
+
+void ffc_get_stat (
+	BYTE pdrv,		/* Physical drive number */
+	FFC_STAT* st,	/* Pointer to the statistics to be returned */
+	int reset		/* 1:Clear the counters after reading */
+)
+{
+	if (pdrv >= _VOLUMES) return;
+	*st = Drive[pdrv].stat;
+	if (reset) memset(&Drive[pdrv].stat, 0, sizeof (FFC_STAT));
+}
@@ -0,0 +1,89 @@
+/*---------------------------------------------------------------------------/
+/  FatFs sector cache - read-ahead and write-behind below disk_read/write
+/----------------------------------------------------------------------------/
+/  The cache sits between the diskio glue and the storage driver. The glue
+/  attaches a device (read/write functions and a DMA-capable staging buffer)
+/  to each physical drive and routes disk_read(), disk_write() and CTRL_SYNC
+/  through ffc_read(), ffc_write() and ffc_sync().
+/
+/  - Sectors are kept in one LRU pool shared by all drives.
+/  - When a drive is read sequentially, the missing run is extended by
+/    _FFC_READ_AHEAD sectors and fetched with one device command.
+/  - Writes are held as dirty sectors and written back on CTRL_SYNC, on
+/    eviction or when half of the pool is dirty. Dirty sectors of a drive
+/    are written in sector order and adjacent ones are coalesced into one
+/    device command.
+/  - Requests longer than _FFC_READ_AHEAD sectors (the direct multi-sector
+/    transfers of f_read/f_write) bypass the pool.
+/
+/  At the thread-safe configuration (_FS_REENTRANT) the pool is guarded by
+/  a mutex that is never held across a device command, and every device
+/  has its own one, held for each command. Entries being read or written
+/  back are pinned, so other drives do not reuse them meanwhile. Drives
+/  that share a controller or a staging buffer must share one FFC_DEV;
+/  drives on separate devices transfer in parallel. Requests for one drive
+/  must come from one task at a time, which the FatFs volume lock ensures.
+/  Call ffc_init() before the tasks start.
+/
+/  Data held dirty in the cache is lost on power failure or media removal
+/  until FatFs syncs the file (f_sync/f_close) or the volume.
+/---------------------------------------------------------------------------*/
+
+#ifndef _FFCACHE
+#define _FFCACHE
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ff.h"
+#include "diskio.h"
+
+/* Number of sectors in the cache pool. 0 turns ffc_read/ffc_write into a
+/  pass-through to the attached device. */
+#ifndef _FFC_SECTORS
+#define _FFC_SECTORS		64
+#endif
+
+/* Sectors fetched ahead of a sequential read. Also the largest request
+/  that goes through the pool; longer requests go straight to the device. */
+#ifndef _FFC_READ_AHEAD
+#define _FFC_READ_AHEAD		8
+#endif
+
+/* 0:Write-through, 1:Write-behind */
+#ifndef _FFC_WRITE_BEHIND
+#define _FFC_WRITE_BEHIND	1
+#endif
+
+typedef struct {
+	DRESULT (*read) (BYTE pdrv, BYTE* buff, DWORD sector, UINT count);			/* Device read */
+	DRESULT (*write) (BYTE pdrv, const BYTE* buff, DWORD sector, UINT count);	/* Device write */
+	BYTE*	stage;		/* Staging buffer for multi-sector device commands */
+	UINT	nstage;		/* Size of the staging buffer in unit of sector (>= 1) */
+#if _FS_REENTRANT
+	_SYNC_t	sobj;		/* Device lock, created by ffc_attach() */
+#endif
+} FFC_DEV;
+
+typedef struct {
+	DWORD	hit;		/* Sectors served from the pool */
+	DWORD	miss;		/* Sectors read from the device on a miss */
+	DWORD	ahead;		/* Sectors read ahead */
+	DWORD	rdcmd;		/* Device read commands */
+	DWORD	wrcmd;		/* Device write commands */
+	DWORD	wrsect;		/* Sectors written to the device */
+} FFC_STAT;
+
+void ffc_init (void);														/* Initialize the cache pool */
+void ffc_attach (BYTE pdrv, FFC_DEV* dev, DWORD nsect);					/* Attach a device and drop cached sectors of the drive */
+DRESULT ffc_read (BYTE pdrv, BYTE* buff, DWORD sector, UINT count);			/* Read sector(s) through the cache */
+DRESULT ffc_write (BYTE pdrv, const BYTE* buff, DWORD sector, UINT count);	/* Write sector(s) through the cache */
+DRESULT ffc_sync (BYTE pdrv);												/* Write back dirty sectors of the drive */
+void ffc_get_stat (BYTE pdrv, FFC_STAT* st, int reset);						/* Get (and clear) statistics of the drive */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FFCACHE */
@@ -39,16 +39,25 @@
 /  f_findnext(). (0:Disable, 1:Enable 2:Enable with matching altname[] too) */
 
 
+#ifndef _USE_MKFS
 #define	_USE_MKFS		0
-/* This option switches f_mkfs() function. (0:Disable or 1:Enable) */
+#endif
+/* This option switches f_mkfs() function. (0:Disable or 1:Enable) A project
+/  may define it, e.g. to format the NOR flash drive of ffnor. */
 
 
-#define	_USE_FASTSEEK	0
-/* This option switches fast seek function. (0:Disable or 1:Enable) */
+#ifndef _USE_FASTSEEK
+#define	_USE_FASTSEEK	1
+#endif
+/* This option switches fast seek function. (0:Disable or 1:Enable) A project
+/  may disable it to save the link map code and RAM. */
 
 
-#define	_USE_EXPAND		0
-/* This option switches f_expand function. (0:Disable or 1:Enable) */
+#ifndef _USE_EXPAND
+#define	_USE_EXPAND		1
+#endif
+/* This option switches f_expand function. (0:Disable or 1:Enable) A project
+/  may disable it if it does not preallocate files. */
 
 
 #define _USE_CHMOD		1
@@ -153,7 +162,7 @@
 
 
 #define _STR_VOLUME_ID	0
-#define _VOLUME_STRS	"RAM","NAND","CF","SD1","SD2","USB1","USB2","USB3"
+#define _VOLUME_STRS	"RAM","NAND","CF","SD1","SD2","USB1","USB2","USB3","NOR"
 /* _STR_VOLUME_ID switches string support of volume ID.
 /  When _STR_VOLUME_ID is set to 1, also pre-defined strings can be used as drive
 /  number in the path name. _VOLUME_STRS defines the drive ID strings for each
@@ -180,10 +189,13 @@
 /  disk_ioctl() function. */
 
 
+#ifndef _USE_TRIM
 #define	_USE_TRIM	0
+#endif
 /* This option switches support of ATA-TRIM. (0:Disable or 1:Enable)
 /  To enable Trim function, also CTRL_TRIM command should be implemented to the
-/  disk_ioctl() function. */
+/  disk_ioctl() function. A project may define it; ffnor stops copying trimmed
+/  sectors when it collects garbage. */
 
 
 #define _FS_NOFSINFO	0
@@ -198,6 +210,16 @@
 */
 
 
+#ifdef FATFS_USE_SYSMEMCOPY
+#define _FS_MEMCPY(dst,src,cnt)	sysMemCopy(dst,src,cnt)
+void sysMemCopy(void* dst, const void* src, unsigned int cnt);
+#endif
+/* Block copy for sector and file data in ff.c, ffcache.c and ffnor.c. Projects
+/  that add the LDM/STM copy of the SYS driver (Driver/Source/memops.c) define
+/  FATFS_USE_SYSMEMCOPY to use it. Other projects fall back to the byte loop in
+/  ff.c and memcpy() in ffcache.c and ffnor.c. */
+
+
 
 /*---------------------------------------------------------------------------/
 / System Configurations
@@ -230,7 +252,11 @@
 /  These options have no effect at read-only configuration (_FS_READONLY = 1). */
 
 
+#ifdef FATFS_FREERTOS
+#define	_FS_LOCK	8
+#else
 #define	_FS_LOCK	0
+#endif
 /* The option _FS_LOCK switches file lock function to control duplicated file open
 /  and illegal operation to open objects. This option must be 0 when _FS_READONLY
 /  is 1.
@@ -238,13 +264,21 @@
 /  0:  Disable file lock function. To avoid volume corruption, application program
 /      should avoid illegal open, remove and rename to the open objects.
 /  >0: Enable file lock function. The value defines how many files/sub-directories
-/      can be opened simultaneously under file lock control. Note that the file
-/      lock control is independent of re-entrancy. */
+/      can be opened simultaneously under file lock control on each volume. Note
+/      that the file lock control is independent of re-entrancy. */
 
 
+#ifdef FATFS_FREERTOS
+#include "FreeRTOS.h"
+#include "semphr.h"
+#define _FS_REENTRANT	1
+#define _FS_TIMEOUT		pdMS_TO_TICKS(1000)
+#define	_SYNC_t			SemaphoreHandle_t
+#else
 #define _FS_REENTRANT	0
 #define _FS_TIMEOUT		1000
 #define	_SYNC_t			HANDLE
+#endif
 /* The option _FS_REENTRANT switches the re-entrancy (thread safe) of the FatFs
 /  module itself. Note that regardless of this option, file access to different
 /  volume is always re-entrant and volume control functions, f_mount(), f_mkfs()
@@ -255,7 +289,8 @@
 /   1: Enable re-entrancy. Also user provided synchronization handlers,
 /      ff_req_grant(), ff_rel_grant(), ff_del_syncobj() and ff_cre_syncobj()
 /      function, must be added to the project. Samples are available in
-/      option/syscall.c.
+/      option/syscall.c. FreeRTOS applications define FATFS_FREERTOS and add
+/      option/syscall_freertos.c, which gives each volume its own mutex.
 /
 /  The _FS_TIMEOUT defines timeout period in unit of time tick.
 /  The _SYNC_t defines O/S dependent sync object type. e.g. HANDLE, ID, OS_EVENT*,
@@ -0,0 +1,658 @@
+/*---------------------------------------------------------------------------/
+/  FatFs NOR flash translation layer - log-structured sectors on erase blocks
+/---------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "ffnor.h"
+
+#if _MIN_SS != _MAX_SS
+#error ffnor supports fixed sector size only
+#endif
+
+#if _FNOR_WBUF < 1 || _FNOR_WBUF > 32
+#error Wrong _FNOR_WBUF setting
+#endif
+
+#define SS			_MAX_SS
+#define NONE		0xFFFFFFFF
+#define MAGIC		0x524F4E46	/* "FNOR" */
+#define TRIM_FLAG	0x80000000	/* Tag is a trimmed range */
+#define TRIM_MAX	0xFFFF		/* Longest range of a trim tag */
+
+/* Block header */
+#define H_MAGIC		0
+#define H_EC		4			/* Erase count, written after erase */
+#define H_ECN		8			/* Its complement */
+#define H_SEQ		12			/* Sequence number, written when the block is taken */
+#define H_SEQN		16			/* Its complement */
+
+/* Tag of a slot */
+#define T_LSN		0			/* Logical sector, or first one of a trimmed range | TRIM_FLAG */
+#define T_CNT		4			/* 1, or number of trimmed sectors */
+#define T_SUM		6			/* Check sum, an erased or torn tag fails it */
+
+#define BS_FREE		0			/* Erased, header holds the erase count */
+#define BS_DIRTY	1			/* To be erased before use */
+#define BS_OPEN		2			/* Being filled */
+#define BS_FULL		3			/* Filled */
+
+#ifdef _FS_MEMCPY
+#define	COPY(d,s,n)		_FS_MEMCPY(d,s,n)
+#else
+#define	COPY(d,s,n)		memcpy(d,s,n)
+#endif
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Helpers                                                               */
+/*-----------------------------------------------------------------------*/
+
+static
+WORD ld_word (const BYTE* p)
+{
+	return (WORD)(p[0] | p[1] << 8);
+}
+
+
+static
+DWORD ld_dword (const BYTE* p)
+{
+	return (DWORD)p[0] | (DWORD)p[1] << 8 | (DWORD)p[2] << 16 | (DWORD)p[3] << 24;
+}
+
+
+static
+void st_word (BYTE* p, WORD val)
+{
+	p[0] = (BYTE)val; p[1] = (BYTE)(val >> 8);
+}
+
+
+static
+void st_dword (BYTE* p, DWORD val)
+{
+	p[0] = (BYTE)val; p[1] = (BYTE)(val >> 8); p[2] = (BYTE)(val >> 16); p[3] = (BYTE)(val >> 24);
+}
+
+
+static
+WORD tag_sum (DWORD lsn, WORD cnt)
+{
+	return (WORD)(lsn ^ (lsn >> 16) ^ cnt ^ 0x5AA5);
+}
+
+
+static
+void put_tag (BYTE* p, DWORD lsn, WORD cnt)
+{
+	st_dword(p + T_LSN, lsn);
+	st_word(p + T_CNT, cnt);
+	st_word(p + T_SUM, tag_sum(lsn, cnt));
+}
+
+
+static
+DWORD blk_addr (FNOR* fn, DWORD b)
+{
+	return fn->dev->base + b * fn->dev->blksz;
+}
+
+
+static
+DWORD tag_addr (FNOR* fn, DWORD b, DWORD i)
+{
+	return blk_addr(fn, b) + FNOR_HDR_SIZE + i * FNOR_TAG_SIZE;
+}
+
+
+static
+DWORD slot_addr (FNOR* fn, DWORD p)	/* Address of the data of slot p (block * nslot + index) */
+{
+	DWORD b = p / fn->nslot;
+
+
+	return blk_addr(fn, b) + fn->dev->blksz - (fn->nslot - (p - b * fn->nslot)) * SS;
+}
+
+
+static
+int unmap (FNOR* fn, DWORD lsn)	/* Forget the current copy of a sector */
+{
+	DWORD p = fn->map[lsn];
+
+
+	if (p == NONE) return 0;
+	fn->blk[p / fn->nslot].valid--;
+	fn->map[lsn] = NONE;
+	return 1;
+}
+
+
+static
+UINT find_held (FNOR* fn, DWORD lsn)	/* Index of a sector in the write buffer (nw:not held) */
+{
+	UINT i;
+
+
+	for (i = 0; i < fn->nw && fn->wlsn[i] != lsn; i++) ;
+	return i;
+}
+
+
+static
+int is_blank (FNOR* fn, DWORD b, DWORD ofs, DWORD len)	/* Check if a part of a block is erased */
+{
+	UINT n, i;
+
+
+	for ( ; len; ofs += n, len -= n) {
+		n = len < sizeof fn->gbuf ? len : sizeof fn->gbuf;
+		if (fn->dev->read(fn->dev->ctx, blk_addr(fn, b) + ofs, fn->gbuf, n)) return 0;
+		for (i = 0; i < n; i++) {
+			if (fn->gbuf[i] != 0xFF) return 0;
+		}
+	}
+	return 1;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Block allocation                                                      */
+/*-----------------------------------------------------------------------*/
+
+static
+DRESULT erase_block (FNOR* fn, DWORD b)	/* Erase a block and record its erase count */
+{
+	const FNOR_DEV *dev = fn->dev;
+	FNOR_BLK *bp = &fn->blk[b];
+	BYTE hdr[12];
+	DWORD ec = bp->ec + 1;
+
+
+	bp->state = BS_DIRTY;
+	if (dev->erase(dev->ctx, blk_addr(fn, b), dev->blksz)) return RES_ERROR;
+	fn->stat.erase++;
+	st_dword(hdr + H_MAGIC, MAGIC);
+	st_dword(hdr + H_EC, ec);
+	st_dword(hdr + H_ECN, ~ec);
+	if (dev->program(dev->ctx, blk_addr(fn, b), hdr, sizeof hdr)) return RES_ERROR;
+	bp->ec = ec;
+	bp->seq = 0;
+	bp->valid = 0;
+	bp->guess = 0;
+	bp->state = BS_FREE;
+	if (ec > fn->stat.ecmax) fn->stat.ecmax = ec;
+	return RES_OK;
+}
+
+
+static
+DRESULT take_block (FNOR* fn)	/* Close the open block and open the least (or most) worn free one */
+{
+	const FNOR_DEV *dev = fn->dev;
+	FNOR_BLK *bp;
+	DWORD b, sel = NONE;
+	BYTE s[8];
+
+
+	if (fn->open != NONE) fn->blk[fn->open].state = BS_FULL;
+	fn->open = NONE;
+
+	for (b = 0; b < dev->nblk; b++) {
+		if (fn->blk[b].state > BS_DIRTY) continue;
+		if (sel == NONE || (fn->worn ? fn->blk[b].ec > fn->blk[sel].ec : fn->blk[b].ec < fn->blk[sel].ec)) sel = b;
+	}
+	if (sel == NONE) return RES_ERROR;
+	bp = &fn->blk[sel];
+	if (bp->state == BS_DIRTY && erase_block(fn, sel) != RES_OK) return RES_ERROR;
+
+	st_dword(s, fn->seq);
+	st_dword(s + 4, ~fn->seq);
+	if (dev->program(dev->ctx, blk_addr(fn, sel) + H_SEQ, s, sizeof s)) {
+		bp->state = BS_DIRTY;
+		return RES_ERROR;
+	}
+	bp->seq = fn->seq++;
+	bp->state = BS_OPEN;
+	fn->nfree--;
+	fn->open = sel;
+	fn->next = 0;
+	return RES_OK;
+}
+
+
+static
+DRESULT append (		/* Program sectors to the open block, map them to their new slots */
+	FNOR* fn,
+	const DWORD* lsn,	/* Sector numbers, no duplicates */
+	const BYTE* data,	/* Sector data */
+	UINT k				/* Number of sectors (1.._FNOR_WBUF) */
+)
+{
+	const FNOR_DEV *dev = fn->dev;
+	BYTE tag[_FNOR_WBUF * FNOR_TAG_SIZE];
+	UINT n, i;
+	DWORD p;
+
+
+	while (k) {
+		if (fn->open == NONE || fn->next >= fn->nslot) {
+			if (take_block(fn) != RES_OK) return RES_ERROR;
+		}
+		n = fn->nslot - fn->next;
+		if (n > k) n = k;
+		p = fn->open * fn->nslot + fn->next;
+
+		/* Data first, then the tags that make it valid */
+		for (i = 0; i < n; i++) put_tag(tag + i * FNOR_TAG_SIZE, lsn[i], 1);
+		if (dev->program(dev->ctx, slot_addr(fn, p), data, n * SS)
+			|| dev->program(dev->ctx, tag_addr(fn, fn->open, fn->next), tag, n * FNOR_TAG_SIZE)) {
+			fn->next = fn->nslot;	/* Do not reuse the slots */
+			return RES_ERROR;
+		}
+		for (i = 0; i < n; i++) {
+			unmap(fn, lsn[i]);
+			fn->map[lsn[i]] = p + i;
+		}
+		fn->blk[fn->open].valid += (WORD)n;
+		fn->next += n;
+		fn->stat.prog += n;
+		lsn += n; data += n * SS; k -= n;
+	}
+	return RES_OK;
+}
+
+
+static
+DRESULT put_trim (FNOR* fn, DWORD lsn, WORD cnt)	/* Append a trim tag */
+{
+	BYTE tag[FNOR_TAG_SIZE];
+
+
+	if (fn->open == NONE || fn->next >= fn->nslot) {
+		if (take_block(fn) != RES_OK) return RES_ERROR;
+	}
+	put_tag(tag, lsn | TRIM_FLAG, cnt);
+	if (fn->dev->program(fn->dev->ctx, tag_addr(fn, fn->open, fn->next), tag, sizeof tag)) {
+		fn->next = fn->nslot;
+		return RES_ERROR;
+	}
+	fn->next++;
+	return RES_OK;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Garbage collection and wear levelling                                 */
+/*-----------------------------------------------------------------------*/
+
+static
+DRESULT collect (FNOR* fn, DWORD v)	/* Move the live sectors of a block away and erase it */
+{
+	const FNOR_DEV *dev = fn->dev;
+	DWORD lsn[_FNOR_WBUF];
+	DWORD i, p = v * fn->nslot;
+	UINT k = 0;
+
+
+	if (fn->blk[v].valid) {
+		if (dev->read(dev->ctx, tag_addr(fn, v, 0), fn->tbuf, fn->nslot * FNOR_TAG_SIZE)) return RES_ERROR;
+		for (i = 0; i < fn->nslot; i++) {
+			lsn[k] = ld_dword(fn->tbuf + i * FNOR_TAG_SIZE + T_LSN);
+			if (lsn[k] >= fn->nsect || fn->map[lsn[k]] != p + i) continue;	/* Trim tag or stale copy */
+			if (dev->read(dev->ctx, slot_addr(fn, p + i), fn->gbuf + k * SS, SS)) return RES_ERROR;
+			if (++k == _FNOR_WBUF) {
+				if (append(fn, lsn, fn->gbuf, k) != RES_OK) return RES_ERROR;
+				fn->stat.gccopy += k;
+				k = 0;
+			}
+		}
+		if (k) {
+			if (append(fn, lsn, fn->gbuf, k) != RES_OK) return RES_ERROR;
+			fn->stat.gccopy += k;
+		}
+	}
+	if (erase_block(fn, v) != RES_OK) return RES_ERROR;
+	fn->nfree++;
+	return RES_OK;
+}
+
+
+static
+DRESULT make_room (FNOR* fn)	/* Collect blocks until the collector reserve is free */
+{
+	DWORD b, v;
+	DRESULT res;
+	int gc = 0;
+
+
+	while (fn->nfree < fn->nkeep) {
+		for (v = NONE, b = 0; b < fn->dev->nblk; b++) {	/* Fewest live sectors, less worn on a tie */
+			if (fn->blk[b].state != BS_FULL) continue;
+			if (v == NONE || fn->blk[b].valid < fn->blk[v].valid
+				|| (fn->blk[b].valid == fn->blk[v].valid && fn->blk[b].ec < fn->blk[v].ec)) v = b;
+		}
+		if (v == NONE || fn->blk[v].valid >= fn->nslot) return RES_ERROR;
+		if (collect(fn, v) != RES_OK) return RES_ERROR;
+		gc = 1;
+	}
+
+	if (gc) {	/* Blocks were erased, move the sectors of a block left far behind */
+		for (v = NONE, b = 0; b < fn->dev->nblk; b++) {
+			if (fn->blk[b].state == BS_FULL && (v == NONE || fn->blk[b].ec < fn->blk[v].ec)) v = b;
+		}
+		if (v != NONE && fn->blk[v].ec + _FNOR_WEAR_GAP < fn->stat.ecmax) {
+			fn->next = fn->nslot;	/* Its cold sectors go to a new block, the most worn free one */
+			fn->worn = 1;
+			res = collect(fn, v);
+			fn->worn = 0;
+			return res;
+		}
+	}
+	return RES_OK;
+}
+
+
+static
+DRESULT flush (FNOR* fn)	/* Program the held sectors */
+{
+	if (!fn->nw) return RES_OK;
+	if (make_room(fn) != RES_OK) return RES_ERROR;
+	if (append(fn, fn->wlsn, fn->wbuf, fn->nw) != RES_OK) return RES_ERROR;
+	fn->nw = 0;
+	return RES_OK;
+}
+
+
+static
+DRESULT trim (FNOR* fn, DWORD st, DWORD ed)	/* Unmap sectors st..ed and log it */
+{
+	DWORD s, n, i, cnt;
+	UINT j, k;
+
+
+	if (st > ed || st >= fn->nsect) return RES_PARERR;
+	if (ed >= fn->nsect) ed = fn->nsect - 1;
+
+	for (j = k = 0; j < fn->nw; j++) {	/* Drop held sectors of the range */
+		if (fn->wlsn[j] >= st && fn->wlsn[j] <= ed) continue;
+		if (j != k) {
+			fn->wlsn[k] = fn->wlsn[j];
+			COPY(fn->wbuf + k * SS, fn->wbuf + j * SS, SS);
+		}
+		k++;
+	}
+	fn->nw = k;
+
+	for (s = st; s <= ed; s += n) {
+		n = ed - s + 1;
+		if (n > TRIM_MAX) n = TRIM_MAX;
+		for (cnt = i = 0; i < n; i++) cnt += unmap(fn, s + i);
+		if (!cnt) continue;		/* Nothing on the flash to forget */
+		fn->stat.trim += cnt;
+		if (make_room(fn) != RES_OK || put_trim(fn, s, (WORD)n) != RES_OK) return RES_ERROR;
+	}
+	return RES_OK;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Mount a Region                                                        */
+/*-----------------------------------------------------------------------*/
+
+DRESULT fnor_mount (
+	FNOR* fn,				/* Volume object */
+	const FNOR_DEV* dev,	/* Device functions and region */
+	DWORD* work				/* Work area of FNOR_WORK_SIZE(dev->nblk, dev->blksz) DWORDs */
+)
+{
+	FNOR_BLK *bp;
+	BYTE hdr[FNOR_HDR_SIZE];
+	const BYTE *t;
+	DWORD b, i, j, gap, spare, nused, seq, lsn, ecsum, neck;
+	WORD cnt;
+
+
+	fn->dev = 0;
+	if (!dev || !work || dev->blksz < 4096 || dev->blksz > FNOR_BLK_MAX || dev->blksz % SS) return RES_PARERR;
+	fn->nslot = FNOR_SLOTS(dev->blksz);
+	fn->nkeep = 2 + (_FNOR_WBUF + fn->nslot - 1) / fn->nslot;	/* Survives a flush and a collection cut by power loss */
+	spare = dev->nblk * _FNOR_RESERVE / 100;
+	if (spare < fn->nkeep + 2) spare = fn->nkeep + 2;
+	if (dev->nblk <= spare) return RES_PARERR;
+	fn->nsect = (dev->nblk - spare) * fn->nslot;
+	fn->map = work;
+	fn->blk = (FNOR_BLK*)(work + dev->nblk * fn->nslot);
+	fn->order = work + dev->nblk * (fn->nslot + 3);
+	fn->dev = dev;
+	fn->seq = 1;
+	fn->nfree = 0;
+	fn->open = NONE;
+	fn->next = 0;
+	fn->nw = 0;
+	fn->worn = 0;
+	memset(&fn->stat, 0, sizeof (FNOR_STAT));
+	for (i = 0; i < fn->nsect; i++) fn->map[i] = NONE;
+
+	/* Classify the blocks by their headers */
+	nused = ecsum = neck = 0;
+	for (b = 0; b < dev->nblk; b++) {
+		bp = &fn->blk[b];
+		bp->seq = 0; bp->ec = 0; bp->valid = 0; bp->guess = 0;
+		if (dev->read(dev->ctx, blk_addr(fn, b), hdr, sizeof hdr)) goto fail;
+		if (ld_dword(hdr + H_MAGIC) == MAGIC && (ld_dword(hdr + H_EC) ^ ld_dword(hdr + H_ECN)) == NONE) {
+			bp->ec = ld_dword(hdr + H_EC);
+			ecsum += bp->ec; neck++;
+			seq = ld_dword(hdr + H_SEQ);
+			if ((seq ^ ld_dword(hdr + H_SEQN)) == NONE && seq != 0 && seq != NONE) {
+				bp->seq = seq;
+				bp->state = BS_FULL;	/* Slots left in the last open block may be torn, it is not reopened */
+				fn->order[nused++] = b;
+				if (seq >= fn->seq) fn->seq = seq + 1;
+			} else if (seq == NONE && ld_dword(hdr + H_SEQN) == NONE
+				&& is_blank(fn, b, FNOR_HDR_SIZE, fn->nslot * FNOR_TAG_SIZE)) {
+				bp->state = BS_FREE;
+			} else {
+				bp->state = BS_DIRTY;
+			}
+		} else {	/* Never used, or its erase was cut */
+			bp->guess = 1;
+			bp->state = is_blank(fn, b, 0, dev->blksz) ? BS_FREE : BS_DIRTY;
+		}
+	}
+
+	/* Lost erase counts are taken as the average */
+	for (b = 0; b < dev->nblk; b++) {
+		bp = &fn->blk[b];
+		if (bp->guess) {
+			bp->ec = neck ? ecsum / neck : 0;
+			if (bp->state == BS_FREE) {		/* Blank, give it a header without an erase */
+				st_dword(hdr + H_MAGIC, MAGIC);
+				st_dword(hdr + H_EC, bp->ec);
+				st_dword(hdr + H_ECN, ~bp->ec);
+				if (dev->program(dev->ctx, blk_addr(fn, b), hdr, 12)) bp->state = BS_DIRTY;
+			}
+		}
+		if (bp->state <= BS_DIRTY) fn->nfree++;
+		if (bp->ec > fn->stat.ecmax) fn->stat.ecmax = bp->ec;
+	}
+	if (!fn->nfree) goto fail;
+
+	/* Replay the tags of the used blocks, oldest first */
+	for (gap = nused / 2; gap; gap /= 2) {
+		for (i = gap; i < nused; i++) {
+			b = fn->order[i];
+			for (j = i; j >= gap && fn->blk[fn->order[j - gap]].seq > fn->blk[b].seq; j -= gap) fn->order[j] = fn->order[j - gap];
+			fn->order[j] = b;
+		}
+	}
+	for (j = 0; j < nused; j++) {
+		b = fn->order[j];
+		if (dev->read(dev->ctx, tag_addr(fn, b, 0), fn->tbuf, fn->nslot * FNOR_TAG_SIZE)) goto fail;
+		for (i = 0; i < fn->nslot; i++) {
+			t = fn->tbuf + i * FNOR_TAG_SIZE;
+			lsn = ld_dword(t + T_LSN);
+			cnt = ld_word(t + T_CNT);
+			if (ld_word(t + T_SUM) != tag_sum(lsn, cnt)) continue;	/* Unwritten or torn */
+			if (lsn & TRIM_FLAG) {
+				lsn &= ~TRIM_FLAG;
+				if (lsn >= fn->nsect || cnt > fn->nsect - lsn) continue;
+				while (cnt--) unmap(fn, lsn++);
+			} else {
+				if (lsn >= fn->nsect || cnt != 1) continue;
+				unmap(fn, lsn);
+				fn->map[lsn] = b * fn->nslot + i;
+				fn->blk[b].valid++;
+			}
+		}
+	}
+	return RES_OK;
+
+fail:
+	fn->dev = 0;
+	return RES_ERROR;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Read Sector(s)                                                        */
+/*-----------------------------------------------------------------------*/
+
+DRESULT fnor_read (
+	FNOR* fn,		/* Volume object */
+	BYTE* buff,		/* Data buffer to store read data */
+	DWORD sector,	/* Start sector number */
+	UINT count		/* Number of sectors to read */
+)
+{
+	DWORD p;
+	UINT n, i;
+
+
+	if (!fn->dev) return RES_NOTRDY;
+	if (sector >= fn->nsect || count > fn->nsect - sector) return RES_PARERR;
+
+	for ( ; count; buff += n * SS, sector += n, count -= n) {
+		n = 1;
+		i = find_held(fn, sector);
+		if (i < fn->nw) {
+			COPY(buff, fn->wbuf + i * SS, SS);
+			continue;
+		}
+		p = fn->map[sector];
+		if (p == NONE) {	/* Never written or trimmed */
+			memset(buff, 0xFF, SS);
+			continue;
+		}
+		/* Extend the read over following sectors held in the following slots of the block */
+		while (n < count && (p + n) % fn->nslot && fn->map[sector + n] == p + n && find_held(fn, sector + n) == fn->nw) n++;
+		if (fn->dev->read(fn->dev->ctx, slot_addr(fn, p), buff, n * SS)) return RES_ERROR;
+		fn->stat.rdcmd++;
+	}
+	return RES_OK;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Write Sector(s)                                                       */
+/*-----------------------------------------------------------------------*/
+
+DRESULT fnor_write (
+	FNOR* fn,			/* Volume object */
+	const BYTE* buff,	/* Data to be written */
+	DWORD sector,		/* Start sector number */
+	UINT count			/* Number of sectors to write */
+)
+{
+	UINT i;
+
+
+	if (!fn->dev) return RES_NOTRDY;
+	if (sector >= fn->nsect || count > fn->nsect - sector) return RES_PARERR;
+
+	for ( ; count; buff += SS, sector++, count--) {
+		i = find_held(fn, sector);
+		if (i < fn->nw) {
+			fn->stat.merged++;
+		} else {
+			if (fn->nw == _FNOR_WBUF && flush(fn) != RES_OK) return RES_ERROR;
+			i = fn->nw++;
+			fn->wlsn[i] = sector;
+		}
+		COPY(fn->wbuf + i * SS, buff, SS);
+		fn->stat.wrsect++;
+	}
+	return RES_OK;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Miscellaneous Functions                                               */
+/*-----------------------------------------------------------------------*/
+
+DRESULT fnor_ioctl (
+	FNOR* fn,		/* Volume object */
+	BYTE cmd,		/* Control code */
+	void* buff		/* Buffer to send/receive control data */
+)
+{
+	if (!fn->dev) return RES_NOTRDY;
+
+	switch (cmd) {
+	case CTRL_SYNC:
+		return flush(fn);
+
+	case GET_SECTOR_COUNT:
+		*(DWORD*)buff = fn->nsect;
+		return RES_OK;
+
+	case GET_SECTOR_SIZE:
+		*(WORD*)buff = SS;
+		return RES_OK;
+
+	case GET_BLOCK_SIZE:	/* Sectors are remapped, aligning the FAT data area to an erase block gains nothing */
+		*(DWORD*)buff = 1;
+		return RES_OK;
+
+	case CTRL_TRIM:
+		return trim(fn, ((DWORD*)buff)[0], ((DWORD*)buff)[1]);
+	}
+	return RES_PARERR;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Get Statistics                                                        */
+/*-----------------------------------------------------------------------*/
+
+void fnor_get_stat (
+	FNOR* fn,		/* Volume object */
+	FNOR_STAT* st,	/* Pointer to the statistics to be returned */
+	int reset		/* 1:Clear the counters after reading */
+)
+{
+	DWORD b, ecmax = fn->stat.ecmax;
+
+
+	if (!fn->dev) {
+		memset(st, 0, sizeof (FNOR_STAT));
+		return;
+	}
+	fn->stat.ecmin = NONE;
+	for (b = 0; b < fn->dev->nblk; b++) {
+		if (fn->blk[b].ec < fn->stat.ecmin) fn->stat.ecmin = fn->blk[b].ec;
+	}
+	*st = fn->stat;
+	if (reset) {
+		memset(&fn->stat, 0, sizeof (FNOR_STAT));
+		fn->stat.ecmax = ecmax;
+	}
+}
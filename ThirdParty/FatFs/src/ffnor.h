@@ -0,0 +1,137 @@
+/*---------------------------------------------------------------------------/
+/  FatFs NOR flash translation layer - log-structured sectors on erase blocks
+/----------------------------------------------------------------------------/
+/  The layer turns a region of NOR flash into a drive of 512-byte sectors
+/  that can be rewritten without a read-erase-write of the erase block
+/  around them. The diskio glue attaches a device (read, program and erase
+/  functions and the geometry of the region) with fnor_mount() and routes
+/  disk_read(), disk_write() and disk_ioctl() through fnor_read(),
+/  fnor_write() and fnor_ioctl().
+/
+/  - Every erase block starts with a header (erase count and allocation
+/    sequence number), followed by one tag per sector slot and the slots.
+/    A tag names the logical sector held by its slot, or a range of
+/    sectors trimmed by CTRL_TRIM.
+/  - Sectors are appended to the open block. A rewrite goes to a new slot
+/    and the RAM map follows it; the old slot becomes garbage. The map is
+/    rebuilt by fnor_mount() from the tags, the newest copy wins.
+/  - Written sectors are held in a buffer of _FNOR_WBUF sectors, rewrites
+/    of a held sector are merged, and the buffer is programmed as one run
+/    of slots and one run of tags on CTRL_SYNC or when it is full.
+/  - When free blocks run low the block with the fewest live sectors is
+/    collected: its live sectors are copied to the open block and it is
+/    erased. New blocks are taken lowest erase count first, and a block
+/    that falls _FNOR_WEAR_GAP erases behind the most worn one is
+/    collected to put its cold sectors on a worn block.
+/
+/  Data is programmed before the tags that validate it and a block header
+/  is completed before its first tag, so a power failure loses at most the
+/  sectors written since the last CTRL_SYNC. A trim is a hint: its tag is
+/  not carried over when its block is collected, so sectors trimmed before
+/  a power cycle may read back old data afterwards.
+/
+/  The work area holds the map (4 bytes per logical sector) and the block
+/  table; FNOR_WORK_SIZE() gives its size in DWORDs. The layer takes no
+/  lock of its own, FatFs serializes the accesses to a volume.
+/---------------------------------------------------------------------------*/
+
+#ifndef _FFNOR
+#define _FFNOR
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ff.h"
+#include "diskio.h"
+
+/* Sectors held by the write buffer of a volume (1..32) */
+#ifndef _FNOR_WBUF
+#define _FNOR_WBUF			8
+#endif
+
+/* Blocks kept out of the logical size for garbage collection, in percent
+/  of the region. At least the blocks the collector needs to make progress
+/  are kept. More spare blocks lower the copying done by the collector on
+/  a full drive. */
+#ifndef _FNOR_RESERVE
+#define _FNOR_RESERVE		5
+#endif
+
+/* Erase count difference that moves the sectors of the least worn block */
+#ifndef _FNOR_WEAR_GAP
+#define _FNOR_WEAR_GAP		64
+#endif
+
+#define FNOR_HDR_SIZE		32		/* Block header */
+#define FNOR_TAG_SIZE		8		/* Tag of a slot */
+#define FNOR_BLK_MAX		65536	/* Largest erase block */
+
+/* Sector slots of an erase block of blksz bytes */
+#define FNOR_SLOTS(blksz)	(((blksz) - FNOR_HDR_SIZE) / (_MAX_SS + FNOR_TAG_SIZE))
+
+/* Size of the work area in unit of DWORD */
+#define FNOR_WORK_SIZE(nblk, blksz)	((nblk) * (FNOR_SLOTS(blksz) + 4))
+
+typedef struct {
+	int (*read) (void* ctx, DWORD addr, BYTE* buff, UINT len);			/* Read bytes (0:OK) */
+	int (*program) (void* ctx, DWORD addr, const BYTE* buff, UINT len);	/* Program bytes within one block (0:OK) */
+	int (*erase) (void* ctx, DWORD addr, DWORD len);					/* Erase one block (0:OK) */
+	void*	ctx;		/* Argument passed to the functions */
+	DWORD	base;		/* Flash address of the region, block aligned */
+	DWORD	nblk;		/* Number of erase blocks in the region */
+	DWORD	blksz;		/* Erase block size (4096..FNOR_BLK_MAX, multiple of _MAX_SS) */
+} FNOR_DEV;
+
+typedef struct {
+	DWORD	wrsect;		/* Sectors written by the host */
+	DWORD	merged;		/* Host writes merged into a held sector */
+	DWORD	prog;		/* Slots programmed, host and collector */
+	DWORD	gccopy;		/* Slots copied by the collector */
+	DWORD	erase;		/* Blocks erased */
+	DWORD	trim;		/* Sectors trimmed */
+	DWORD	rdcmd;		/* Device read commands for host reads */
+	DWORD	ecmin;		/* Lowest erase count of the region */
+	DWORD	ecmax;		/* Highest erase count of the region */
+} FNOR_STAT;
+
+typedef struct {
+	DWORD	seq;		/* Allocation sequence number (0:not in use) */
+	DWORD	ec;			/* Erase count */
+	WORD	valid;		/* Slots holding the current copy of a sector */
+	BYTE	state;		/* Block state */
+	BYTE	guess;		/* Erase count was lost and estimated at mount */
+} FNOR_BLK;
+
+typedef struct {
+	const FNOR_DEV*	dev;	/* Attached device */
+	DWORD*	map;		/* Slot of each logical sector (0xFFFFFFFF:unmapped) */
+	FNOR_BLK*	blk;	/* Block table */
+	DWORD*	order;		/* Work area of the mount scan */
+	DWORD	nsect;		/* Number of logical sectors */
+	DWORD	nslot;		/* Slots per block */
+	DWORD	seq;		/* Next allocation sequence number */
+	DWORD	nfree;		/* Erased or erasable blocks */
+	DWORD	nkeep;		/* Free blocks kept for the collector */
+	DWORD	open;		/* Block being filled (0xFFFFFFFF:none) */
+	DWORD	next;		/* Next slot of the open block */
+	UINT	nw;			/* Sectors held in the write buffer */
+	BYTE	worn;		/* Take the most worn free block next */
+	DWORD	wlsn[_FNOR_WBUF];			/* Sector numbers of the held sectors */
+	BYTE	wbuf[_FNOR_WBUF * _MAX_SS];	/* Held sectors */
+	BYTE	gbuf[_FNOR_WBUF * _MAX_SS];	/* Collector copy buffer */
+	BYTE	tbuf[FNOR_SLOTS(FNOR_BLK_MAX) * FNOR_TAG_SIZE];	/* Tags of one block */
+	FNOR_STAT	stat;	/* Statistics */
+} FNOR;
+
+DRESULT fnor_mount (FNOR* fn, const FNOR_DEV* dev, DWORD* work);		/* Scan the region and rebuild the map */
+DRESULT fnor_read (FNOR* fn, BYTE* buff, DWORD sector, UINT count);		/* Read sector(s) */
+DRESULT fnor_write (FNOR* fn, const BYTE* buff, DWORD sector, UINT count);	/* Write sector(s) */
+DRESULT fnor_ioctl (FNOR* fn, BYTE cmd, void* buff);					/* CTRL_SYNC, GET_SECTOR_COUNT/SIZE, GET_BLOCK_SIZE, CTRL_TRIM */
+void fnor_get_stat (FNOR* fn, FNOR_STAT* st, int reset);				/* Get (and clear) statistics */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FFNOR */
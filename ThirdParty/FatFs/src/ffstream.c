@@ -0,0 +1,166 @@
+/*---------------------------------------------------------------------------/
+/  FatFs streaming extension - fast seek and contiguous file streaming
+/---------------------------------------------------------------------------*/
+
+#include "ffstream.h"
+
+
+/*-----------------------------------------------------------------------*/
+/* Attach the cluster link map table to the file                         */
+/*-----------------------------------------------------------------------*/
+
+static
+FRESULT ffs_attach (
+	FFSTREAM* st	/* Pointer to the stream object */
+)
+{
+	FRESULT res;
+
+
+	st->clmt[0] = _FFS_CLMT_ITEMS;		/* Size of the table */
+	st->fil.cltbl = st->clmt;
+	res = f_lseek(&st->fil, CREATE_LINKMAP);
+	if (res == FR_NOT_ENOUGH_CORE) {	/* Too fragmented for the table */
+		st->fil.cltbl = 0;				/* Stay in normal seek mode */
+		res = FR_OK;
+	}
+	return res;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Open a File as a Stream                                               */
+/*-----------------------------------------------------------------------*/
+
+FRESULT ffs_open (
+	FFSTREAM* st,		/* Pointer to the blank stream object */
+	const TCHAR* path,	/* Pointer to the file name */
+	BYTE mode			/* Access mode and file open mode flags */
+)
+{
+	FRESULT res;
+
+
+	st->rec = 0;
+	res = f_open(&st->fil, path, mode);
+	if (res == FR_OK) {
+		res = ffs_attach(st);
+		if (res != FR_OK) f_close(&st->fil);
+	}
+	return res;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Create a Recording Stream                                             */
+/*-----------------------------------------------------------------------*/
+
+FRESULT ffs_create (
+	FFSTREAM* st,		/* Pointer to the blank stream object */
+	const TCHAR* path,	/* Pointer to the file name */
+	FSIZE_t size		/* Number of bytes to pre-allocate (0:none) */
+)
+{
+	FRESULT res;
+
+
+	res = f_open(&st->fil, path, FA_CREATE_ALWAYS | FA_WRITE | FA_READ);
+	if (res != FR_OK) return res;
+	st->rec = 1;
+
+	if (size) {
+		res = f_expand(&st->fil, size, 1);	/* Allocate one contiguous extent */
+		if (res == FR_DENIED) res = FR_OK;	/* No contiguous space, the file grows in normal mode */
+	}
+	if (res == FR_OK) res = ffs_attach(st);
+	if (res != FR_OK) f_close(&st->fil);
+	return res;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Read/Write/Seek/Sync                                                  */
+/*-----------------------------------------------------------------------*/
+
+FRESULT ffs_read (
+	FFSTREAM* st,	/* Pointer to the stream object */
+	void* buff,		/* Pointer to data buffer */
+	UINT btr,		/* Number of bytes to read */
+	UINT* br		/* Pointer to number of bytes read */
+)
+{
+	return f_read(&st->fil, buff, btr, br);
+}
+
+
+FRESULT ffs_write (
+	FFSTREAM* st,		/* Pointer to the stream object */
+	const void* buff,	/* Pointer to the data to be written */
+	UINT btw,			/* Number of bytes to write */
+	UINT* bw			/* Pointer to number of bytes written */
+)
+{
+	FRESULT res;
+	UINT n;
+
+
+	res = f_write(&st->fil, buff, btw, bw);
+	if (res == FR_OK && *bw < btw && st->fil.cltbl) {
+		/* The CLMT cannot stretch the cluster chain. Drop it and continue
+		   in normal mode, which allocates clusters on the FAT. */
+		st->fil.cltbl = 0;
+		res = f_write(&st->fil, (const BYTE*)buff + *bw, btw - *bw, &n);
+		*bw += n;
+	}
+	return res;
+}
+
+
+FRESULT ffs_seek (
+	FFSTREAM* st,	/* Pointer to the stream object */
+	FSIZE_t ofs		/* Offset from top of the file */
+)
+{
+	return f_lseek(&st->fil, ofs);
+}
+
+
+FRESULT ffs_sync (
+	FFSTREAM* st	/* Pointer to the stream object */
+)
+{
+	return f_sync(&st->fil);
+}
+
+
+int ffs_is_fast (
+	FFSTREAM* st	/* Pointer to the stream object */
+)
+{
+	return st->fil.cltbl ? 1 : 0;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Close the Stream                                                      */
+/*-----------------------------------------------------------------------*/
+
+FRESULT ffs_close (
+	FFSTREAM* st	/* Pointer to the stream object */
+)
+{
+	FRESULT res = FR_OK;
+
+
+	if (st->rec && st->fil.fptr < st->fil.obj.objsize) {
+		res = f_truncate(&st->fil);		/* Release the unused part of the pre-allocation */
+	}
+	if (res == FR_OK) {
+		res = f_close(&st->fil);
+	}
+	return res;
+}
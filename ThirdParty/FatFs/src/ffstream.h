@@ -0,0 +1,54 @@
+/*---------------------------------------------------------------------------/
+/  FatFs streaming extension - fast seek and contiguous file streaming
+/----------------------------------------------------------------------------/
+/  A stream keeps the cluster link map table (CLMT) of a file attached for
+/  as long as the file is open. Seeks are then resolved without walking the
+/  FAT and f_read()/f_write() move whole contiguous fragments with a single
+/  disk_read()/disk_write() instead of one cluster per call.
+/
+/  Recording streams are pre-allocated as one contiguous extent with
+/  f_expand() and trimmed to the written size when closed.
+/
+/  Requires _USE_FASTSEEK = 1 and _USE_EXPAND = 1 in ffconf.h.
+/---------------------------------------------------------------------------*/
+
+#ifndef _FFSTREAM
+#define _FFSTREAM
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ff.h"
+
+#if !_USE_FASTSEEK || !_USE_EXPAND
+#error ffstream requires _USE_FASTSEEK and _USE_EXPAND
+#endif
+
+/* Number of CLMT items kept per stream. Each fragment of the file takes two
+/  items and the table needs two more, so 32 covers 15 fragments. A file with
+/  more fragments is still accessible, in normal (FAT walking) mode. */
+#ifndef _FFS_CLMT_ITEMS
+#define _FFS_CLMT_ITEMS		32
+#endif
+
+typedef struct {
+	FIL		fil;						/* FatFs file object */
+	DWORD	clmt[_FFS_CLMT_ITEMS];		/* Cluster link map table of the file */
+	BYTE	rec;						/* 1:Recording stream, trimmed at fptr when closed */
+} FFSTREAM;
+
+FRESULT ffs_open (FFSTREAM* st, const TCHAR* path, BYTE mode);		/* Open a file and attach its CLMT */
+FRESULT ffs_create (FFSTREAM* st, const TCHAR* path, FSIZE_t size);	/* Create a recording file with a contiguous pre-allocated extent */
+FRESULT ffs_read (FFSTREAM* st, void* buff, UINT btr, UINT* br);		/* Read data from the stream */
+FRESULT ffs_write (FFSTREAM* st, const void* buff, UINT btw, UINT* bw);	/* Write data to the stream */
+FRESULT ffs_seek (FFSTREAM* st, FSIZE_t ofs);						/* Move the stream pointer */
+FRESULT ffs_sync (FFSTREAM* st);									/* Flush cached data of the stream */
+FRESULT ffs_close (FFSTREAM* st);									/* Close the stream */
+int ffs_is_fast (FFSTREAM* st);										/* 1:CLMT attached, 0:Normal seek mode */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FFSTREAM */
@@ -0,0 +1,102 @@
+/*------------------------------------------------------------------------*/
+/* OS dependent controls for FatFs on FreeRTOS                            */
+/*------------------------------------------------------------------------*/
+/* Built with FATFS_FREERTOS defined, see _FS_REENTRANT in ffconf.h.
+/  Every volume gets its own mutex, so file access to SD and USB volumes
+/  from different tasks only serializes on the same volume. The mutexes
+/  have priority inheritance, a low priority logging task holding a volume
+/  does not block a higher priority task on the same volume indefinitely.
+/  configUSE_MUTEXES must be 1 in FreeRTOSConfig.h.
+*/
+
+#include "../ff.h"
+#include "task.h"
+
+
+#if _FS_REENTRANT
+/*------------------------------------------------------------------------*/
+/* Create a Synchronization Object                                        */
+/*------------------------------------------------------------------------*/
+
+int ff_cre_syncobj (	/* 1:Function succeeded, 0:Could not create the sync object */
+	BYTE vol,			/* Corresponding volume (logical drive number) */
+	_SYNC_t *sobj		/* Pointer to return the created sync object */
+)
+{
+	(void)vol;
+	*sobj = xSemaphoreCreateMutex();
+	return (int)(*sobj != NULL);
+}
+
+
+
+/*------------------------------------------------------------------------*/
+/* Delete a Synchronization Object                                        */
+/*------------------------------------------------------------------------*/
+
+int ff_del_syncobj (	/* 1:Function succeeded, 0:Could not delete due to any error */
+	_SYNC_t sobj		/* Sync object tied to the logical drive to be deleted */
+)
+{
+	vSemaphoreDelete(sobj);
+	return 1;
+}
+
+
+
+/*------------------------------------------------------------------------*/
+/* Request Grant to Access the Volume                                     */
+/*------------------------------------------------------------------------*/
+
+int ff_req_grant (	/* 1:Got a grant to access the volume, 0:Could not get a grant */
+	_SYNC_t sobj	/* Sync object to wait */
+)
+{
+	if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) return 1;	/* Mounted before the scheduler runs */
+	return (int)(xSemaphoreTake(sobj, _FS_TIMEOUT) == pdTRUE);
+}
+
+
+
+/*------------------------------------------------------------------------*/
+/* Release Grant to Access the Volume                                     */
+/*------------------------------------------------------------------------*/
+
+void ff_rel_grant (
+	_SYNC_t sobj	/* Sync object to be signaled */
+)
+{
+	if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) return;
+	xSemaphoreGive(sobj);
+}
+
+#endif
+
+
+
+
+#if _USE_LFN == 3	/* LFN with a working buffer on the heap */
+/*------------------------------------------------------------------------*/
+/* Allocate a memory block                                                */
+/*------------------------------------------------------------------------*/
+
+void* ff_memalloc (	/* Returns pointer to the allocated memory block */
+	UINT msize		/* Number of bytes to allocate */
+)
+{
+	return pvPortMalloc(msize);
+}
+
+
+/*------------------------------------------------------------------------*/
+/* Free a memory block                                                    */
+/*------------------------------------------------------------------------*/
+
+void ff_memfree (
+	void* mblock	/* Pointer to the memory block to free */
+)
+{
+	vPortFree(mblock);
+}
+
+#endif
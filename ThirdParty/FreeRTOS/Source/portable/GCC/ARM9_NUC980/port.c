@@ -212,44 +212,248 @@ void vPortEndScheduler( void )
 /*-----------------------------------------------------------*/
 
 /* Interrupt Handler */
-void systemIrqHandler(UINT32 num)
+SYS_FASTCODE void systemIrqHandler(UINT32 num)
 {
+	traceISR_ENTER(num);
 	if (num != 0)
 		(*sysIrqHandlerTable[num])();
+	traceISR_EXIT(num);
 
 	outpw(REG_AIC_EOIS, 1);
 }
 
 /*-----------------------------------------------------------*/
-extern void vPreemptiveTick( void );
-static void prvSetupTimerInterrupt( void )
+
+/* Counts of TIMER5 per tick.  The longest sleep keeps the wakeup compare
+within half of the counter range, so a compare value can always be told to
+be ahead of or behind the counter.
+
+The same cap keeps the timebase right.  The 24-bit counter wraps every 1.4 s,
+and ullPortGetTimebase() only extends it from the last tick or wakeup, so
+one must come within a wrap.  The cap allows 698 ticks at 1 kHz, 0.7 s.
+Interrupts held off for longer than 1.4 s, or a timebase read that long after
+vPortStartTimebase() before the scheduler starts, lose whole wraps. */
+#define portTICK_COUNTS				( portTIMEBASE_HZ / configTICK_RATE_HZ )
+#define portHALF_RANGE				( portTIMEBASE_MASK >> 1 )
+#define portMAX_SUPPRESSED_TICKS	( ( portHALF_RANGE / portTICK_COUNTS ) - 1UL )
+
+/* A compare value found behind the counter is moved this far ahead of it. */
+#define portCOMPARE_MARGIN			( 24UL )
+
+#define portTIMER_COUNT()			( inpw( REG_ETMR5_DR ) & portTIMEBASE_MASK )
+#define portWAIT_FOR_INTERRUPT()	asm volatile ( "MOV R0, #0 \n\t MCR p15, 0, R0, c7, c0, 4" ::: "r0", "memory" )
+
+/* Counter value at which the next tick is due. */
+static volatile uint32_t ulNextTickCount = 0;
+
+/* 64-bit timebase, extended from the counter at every tick and wakeup, at
+least once per counter wrap. */
+static volatile uint64_t ullTimebase = 0;
+static volatile uint32_t ulTimebaseCount = 0;
+static volatile uint32_t ulTimebaseSequence = 0;
+
+static volatile uint32_t ulSleepCount = 0;
+static volatile uint32_t ulSuppressedTicks = 0;
+
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvCountReached( uint32_t ulCount, uint32_t ulNow )
 {
-	uint32_t ulCompareMatch;
+	return ( ( ( ulNow - ulCount ) & portTIMEBASE_MASK ) <= portHALF_RANGE ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
 
-	// enable timer5 clock
-	outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 13));
-	/* Calculate the match value required for our wanted tick rate. */
-	ulCompareMatch = 12000000 / configTICK_RATE_HZ;
-	outpw(REG_ETMR5_CTL, 0);
+static void prvSetCompare( uint32_t ulCount )
+{
+uint32_t ulNow;
 
-	/* Protect against divide by zero.  Using an if() statement still results
-	in a warning - hence the #if. */
-	#if portPRESCALE_VALUE != 0
+	/* The compare register does not take 0 or 1. */
+	if( ulCount < 2UL )
 	{
-		ulCompareMatch /= ( portPRESCALE_VALUE + 1 );
+		ulCount = 2UL;
 	}
-	#endif
+	outpw( REG_ETMR5_CMPR, ulCount );
 
+	/* If the counter passed the compare value before it was written the match
+	would only come after the counter wraps.  Raise it now instead, the tick
+	handler catches up with the ticks due. */
+	ulNow = portTIMER_COUNT();
+	if( prvCountReached( ulCount, ulNow ) != pdFALSE )
+	{
+		ulCount = ( ulNow + portCOMPARE_MARGIN ) & portTIMEBASE_MASK;
+		if( ulCount < 2UL )
+		{
+			ulCount = 2UL;
+		}
+		outpw( REG_ETMR5_CMPR, ulCount );
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* Called with interrupts disabled. */
+static void prvUpdateTimebase( uint32_t ulNow )
+{
+	ulTimebaseSequence++;
+	ullTimebase += ( ulNow - ulTimebaseCount ) & portTIMEBASE_MASK;
+	ulTimebaseCount = ulNow;
+	ulTimebaseSequence++;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t ullPortGetTimebase( void )
+{
+uint64_t ullBase;
+uint32_t ulSequence, ulCount, ulNow;
+
+	/* The tick interrupt may update the base while it is read.  Read again
+	until the sequence shows no update. */
+	do
+	{
+		ulSequence = ulTimebaseSequence;
+		ullBase = ullTimebase;
+		ulCount = ulTimebaseCount;
+		ulNow = portTIMER_COUNT();
+	} while( ( ulSequence != ulTimebaseSequence ) || ( ( ulSequence & 1UL ) != 0UL ) );
+
+	return ullBase + ( ( ulNow - ulCount ) & portTIMEBASE_MASK );
+}
+/*-----------------------------------------------------------*/
+
+/* Also called by vTaskStartScheduler() through
+portCONFIGURE_TIMER_FOR_RUN_TIME_STATS(), before the tick is set up. */
+void vPortStartTimebase( void )
+{
+	if( ( inpw( REG_ETMR5_CTL ) & 0x1UL ) != 0UL )
+	{
+		return;
+	}
+
+	// enable timer5 clock, count continuously at 12 MHz
+	outpw( REG_CLK_PCLKEN0, inpw( REG_CLK_PCLKEN0 ) | ( 1 << 13 ) );
+	outpw( REG_ETMR5_CTL, 0 );
+	outpw( REG_ETMR5_PRECNT, 0 );
+	outpw( REG_ETMR5_CMPR, portTICK_COUNTS );
+	outpw( REG_ETMR5_CTL, 0x31 );
+	ulTimebaseCount = portTIMER_COUNT();
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulPortGetRunTimeCounter( void )
+{
+	return ( uint32_t ) ( ullPortGetTimebase() >> portRUN_TIME_SHIFT );
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetSleepStats( uint32_t *pulSleeps, uint32_t *pulSuppressedTicks )
+{
+	*pulSleeps = ulSleepCount;
+	*pulSuppressedTicks = ulSuppressedTicks;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortTickHandler( void )
+{
+BaseType_t xSwitchRequired = pdFALSE;
+uint32_t ulNow;
+
+	traceISR_ENTER( IRQ_TIMER5 );
+	outpw( REG_ETMR5_ISR, 0x1 );
+
+	/* More than one tick is due when a wakeup left its last tick to this
+	interrupt, or when the interrupt was held off for longer than a tick. */
+	ulNow = portTIMER_COUNT();
+	prvUpdateTimebase( ulNow );
+	while( prvCountReached( ulNextTickCount, ulNow ) != pdFALSE )
+	{
+		if( xTaskIncrementTick() != pdFALSE )
+		{
+			xSwitchRequired = pdTRUE;
+		}
+		ulNextTickCount = ( ulNextTickCount + portTICK_COUNTS ) & portTIMEBASE_MASK;
+	}
+	prvSetCompare( ulNextTickCount );
+	traceISR_EXIT( IRQ_TIMER5 );
+
+	return xSwitchRequired;
+}
+/*-----------------------------------------------------------*/
+
+#if configUSE_TICKLESS_IDLE != 0
+
+	void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
+	{
+	uint32_t ulLastTickCount, ulNow, ulCompleteTicks;
+	TickType_t xModifiableIdleTime;
+
+		if( xExpectedIdleTime > portMAX_SUPPRESSED_TICKS )
+		{
+			xExpectedIdleTime = portMAX_SUPPRESSED_TICKS;
+		}
+
+		/* Interrupts stay masked until the tick count is corrected.  Wait for
+		interrupt still returns when an interrupt is pending. */
+		portDISABLE_INTERRUPTS();
+		if( eTaskConfirmSleepModeStatus() == eAbortSleep )
+		{
+			portENABLE_INTERRUPTS();
+			return;
+		}
+
+		ulLastTickCount = ( ulNextTickCount - portTICK_COUNTS ) & portTIMEBASE_MASK;
+		prvSetCompare( ( ulLastTickCount + ( xExpectedIdleTime * portTICK_COUNTS ) ) & portTIMEBASE_MASK );
+
+		xModifiableIdleTime = xExpectedIdleTime;
+		configPRE_SLEEP_PROCESSING( xModifiableIdleTime );
+		if( xModifiableIdleTime > 0 )
+		{
+			portWAIT_FOR_INTERRUPT();
+			ulSleepCount++;
+		}
+		configPOST_SLEEP_PROCESSING( xExpectedIdleTime );
+
+		/* Step over the ticks that passed in the sleep.  When the wakeup
+		compare ended the sleep its tick is left to the pending tick interrupt,
+		which also unblocks the task waiting for it. */
+		ulNow = portTIMER_COUNT();
+		prvUpdateTimebase( ulNow );
+		ulCompleteTicks = ( ( ulNow - ulLastTickCount ) & portTIMEBASE_MASK ) / portTICK_COUNTS;
+		if( ulCompleteTicks >= xExpectedIdleTime )
+		{
+			ulCompleteTicks = xExpectedIdleTime - 1UL;
+		}
+		ulNextTickCount = ( ulLastTickCount + ( ( ulCompleteTicks + 1UL ) * portTICK_COUNTS ) ) & portTIMEBASE_MASK;
+		prvSetCompare( ulNextTickCount );
+		ulSuppressedTicks += ulCompleteTicks;
+		vTaskStepTick( ulCompleteTicks );
+
+		portENABLE_INTERRUPTS();
+	}
+
+#endif /* configUSE_TICKLESS_IDLE */
+/*-----------------------------------------------------------*/
+#if configUSE_PREEMPTION == 1
+extern void vPreemptiveTick( void );
+#else
+extern void vNonPreemptiveTick( void );
+#endif
+static void prvSetupTimerInterrupt( void )
+{
+	uint32_t ulNow;
 
+	vPortStartTimebase();
 
 #if configUSE_PREEMPTION == 1
 	sysInstallIrqHandler(vPreemptiveTick);
+#else
+	sysInstallIrqHandler(vNonPreemptiveTick);
 #endif
 
 	_sys_bIsAICInitial = TRUE;
-	// set up timer and enable timer 5 interrupt
-	outpw(REG_ETMR5_CMPR, ulCompareMatch);
-	outpw(REG_ETMR5_CTL, 0x11);
+	// the first tick is due one period from now
+	ulNow = portTIMER_COUNT();
+	prvUpdateTimebase(ulNow);
+	ulNextTickCount = (ulNow + portTICK_COUNTS) & portTIMEBASE_MASK;
+	prvSetCompare(ulNextTickCount);
 	outpw(REG_ETMR5_IER, 0x1);
 	sysEnableInterrupt(IRQ_TIMER5);
 
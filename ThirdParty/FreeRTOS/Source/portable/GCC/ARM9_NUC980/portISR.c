@@ -98,7 +98,7 @@ volatile uint32_t ulCriticalNesting = 9999UL;
 /*-----------------------------------------------------------*/
 
 /* ISR to handle manual context switches (from a call to taskYIELD()). */
-void vPortYieldProcessor( void ) __attribute__((interrupt("SWI"), naked));
+void vPortYieldProcessor( void ) __attribute__((interrupt("SWI"), naked, section(".fastcode")));
 /*
  * The scheduler can only be started from ARM mode, hence the inclusion of this
  * function here.
@@ -156,29 +156,31 @@ extern void systemIrqHandler(UINT32 num);
 
 #if configUSE_PREEMPTION == 0
 
-	void __attribute__ ((interrupt ("IRQ"))) vNonPreemptiveTick( void )
+	void __attribute__ ((interrupt ("IRQ"), section(".fastcode"))) vNonPreemptiveTick( void )
 	{
 		UINT32 volatile _mIRQNUM;
 
-		/* Increment the tick count - this may make a delaying task ready
-		to run - but a context switch is not performed. */
-		xTaskIncrementTick();
-
 		_mIRQNUM = inpw(REG_AIC_IRQNUM);
 		if (_mIRQNUM != IRQ_TIMER5)
+		{
 			systemIrqHandler(_mIRQNUM);
+		}
+		else
+		{
+			/* Increment the tick count - this may make a delaying task ready
+			to run - but a context switch is not performed. */
+			xPortTickHandler();
 
-		// clear TIF1
-		outpw(REG_ETMR5_ISR, 0x1);
-		// Acknowledge the Interrupt
-		outpw(REG_AIC_EOIS, 0x01);
+			// Acknowledge the Interrupt
+			outpw(REG_AIC_EOIS, 0x01);
+		}
 	}
 #else  /* else preemption is turned on */
 
 	/* The preemptive scheduler is defined as "naked" as the full context is
 	saved on entry as part of the context switch. */
 	//void __attribute__ ((interrupt ("IRQ"))) vPreemptiveTick( void )
-	void  __attribute__((naked)) vPreemptiveTick( void )
+	void  __attribute__((naked, section(".fastcode"))) vPreemptiveTick( void )
 	{
 		/* Save the context of the interrupted task. */
 		portSAVE_CONTEXT();
@@ -196,14 +198,13 @@ extern void systemIrqHandler(UINT32 num);
 		{
 			//*(unsigned int volatile *)(0xb0070000) = 'T';
 			/* Increment the RTOS tick count, then look for the highest priority
-			task that is ready to run. */
-			if( xTaskIncrementTick() != pdFALSE )
+			task that is ready to run.  The handler also clears the timer
+			interrupt and sets the compare for the next tick. */
+			if( xPortTickHandler() != pdFALSE )
 			{
 				vTaskSwitchContext();
 			}
 
-			// clear TIF1
-			outpw(REG_ETMR5_ISR, 0x1);
 			// Acknowledge the Interrupt
 			outpw(REG_AIC_EOIS, 0x01);
 		}
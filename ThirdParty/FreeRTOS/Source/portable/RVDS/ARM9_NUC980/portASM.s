@@ -29,7 +29,7 @@
 	INCLUDE portmacro.inc
 
 	IMPORT	vTaskSwitchContext
-	IMPORT	xTaskIncrementTick
+	IMPORT	xPortTickHandler
 	IMPORT	systemIrqHandler
 
 	EXPORT	vPortYieldProcessor
@@ -40,7 +40,6 @@
 
 REG_AIC_IRQNUM	EQU	0xB0042120
 REG_AIC_EOIS	EQU	0xB0042150
-REG_ETMR5_ISR	EQU	0xB0052110
 IRQ_TIMER5		EQU	0x00000022
 
 	ARM
@@ -65,6 +64,13 @@ vPortYield
 	SVC 0
 	bx lr
 
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; The context switch paths below are linked with the SYS_FASTCODE
+; functions so sysLockFastCode() keeps them in the I-cache.
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+
+	AREA	|.fastcode|, CODE, READONLY
+
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 ; Interrupt service routine for the SWI interrupt.  The vector table is
 ; configured in the startup.s file.
@@ -116,9 +122,10 @@ vPreemptiveTick
 	B RestoreContext
 
 SkipIrqHandler
-	LDR R0, =xTaskIncrementTick			; Increment the tick count.  
-	MOV LR, PC							; This may make a delayed task ready
-	BX R0								; to run.
+	LDR R0, =xPortTickHandler			; Increment the tick count, clear the
+	MOV LR, PC							; timer interrupt and set the next tick.
+	BX R0								; This may make a delayed task ready
+										; to run.
 
 	CMP R0, #0
 	BEQ SkipContextSwitch
@@ -127,11 +134,8 @@ SkipIrqHandler
 	BX R0
 
 SkipContextSwitch
-	LDR R0, =REG_ETMR5_ISR				; Clear the timer interrupt.
-	LDR R1, =1
-	STR R1, [R0] 
-
 	LDR R0, =REG_AIC_EOIS				; Acknowledge end of IRQ handler.
+	LDR R1, =1
 	STR R1,[R0]
 
 RestoreContext
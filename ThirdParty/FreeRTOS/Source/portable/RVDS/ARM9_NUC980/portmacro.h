@@ -129,6 +129,41 @@ extern void vPortExitCritical( void );
 #define portEXIT_CRITICAL()			vPortExitCritical();
 /*-----------------------------------------------------------*/
 
+/* Timebase and tickless idle.  TIMER5 counts continuously at portTIMEBASE_HZ.
+The tick interrupt is a compare match that moves forward by one tick period at
+every tick, so the counter is never stopped or reloaded. */
+#define portTIMEBASE_HZ				( 12000000UL )
+#define portTIMEBASE_MASK			( 0xFFFFFFUL )	/* 24-bit counter */
+
+extern BaseType_t xPortTickHandler( void );
+extern void vPortStartTimebase( void );
+extern uint64_t ullPortGetTimebase( void );
+extern uint32_t ulPortGetRunTimeCounter( void );
+extern void vPortGetSleepStats( uint32_t *pulSleeps, uint32_t *pulSuppressedTicks );
+
+/* Run-time statistics count the timebase shifted right by portRUN_TIME_SHIFT,
+750 kHz, so the counter wraps every 95 minutes and reading it divides
+nothing.  Convert to time with portRUN_TIME_HZ where it is reported. */
+#define portRUN_TIME_SHIFT			( 4UL )
+#define portRUN_TIME_HZ				( portTIMEBASE_HZ >> portRUN_TIME_SHIFT )
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()	vPortStartTimebase()
+#define portGET_RUN_TIME_COUNTER_VALUE()			ulPortGetRunTimeCounter()
+
+/* Called around every interrupt the port dispatches, the tick included.
+Interrupts are disabled. */
+#ifndef traceISR_ENTER
+	#define traceISR_ENTER( ulIrq )
+#endif
+#ifndef traceISR_EXIT
+	#define traceISR_EXIT( ulIrq )
+#endif
+
+#if configUSE_TICKLESS_IDLE != 0
+	extern void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime );
+	#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime )	vPortSuppressTicksAndSleep( xExpectedIdleTime )
+#endif
+/*-----------------------------------------------------------*/
+
 /* Compiler specifics. */
 #define inline
 #define register
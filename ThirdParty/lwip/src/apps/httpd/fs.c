@@ -55,8 +55,20 @@ int fs_read_async_custom(struct fs_file *file, char *buffer, int count, fs_wait_
 #else /* LWIP_HTTPD_FS_ASYNC_READ */
 int fs_read_custom(struct fs_file *file, char *buffer, int count);
 #endif /* LWIP_HTTPD_FS_ASYNC_READ */
+#if LWIP_HTTPD_FS_ZEROCOPY
+#if LWIP_HTTPD_FS_ASYNC_READ
+int fs_read_nocopy_async_custom(struct fs_file *file, const char **buffer, int count, fs_wait_cb callback_fn, void *callback_arg);
+#else /* LWIP_HTTPD_FS_ASYNC_READ */
+int fs_read_nocopy_custom(struct fs_file *file, const char **buffer, int count);
+#endif /* LWIP_HTTPD_FS_ASYNC_READ */
+void fs_release_nocopy_custom(const char *buffer);
+#endif /* LWIP_HTTPD_FS_ZEROCOPY */
 #endif /* LWIP_HTTPD_CUSTOM_FILES */
 
+#if LWIP_HTTPD_FS_ZEROCOPY && !(LWIP_HTTPD_CUSTOM_FILES && LWIP_HTTPD_DYNAMIC_FILE_READ)
+#error "LWIP_HTTPD_FS_ZEROCOPY needs LWIP_HTTPD_CUSTOM_FILES and LWIP_HTTPD_DYNAMIC_FILE_READ"
+#endif
+
 /*-----------------------------------------------------------------------------------*/
 err_t
 fs_open(struct fs_file *file, const char *name)
@@ -67,6 +79,9 @@ fs_open(struct fs_file *file, const char *name)
      return ERR_ARG;
   }
 
+#if LWIP_HTTPD_ETAG
+  file->etag = NULL;
+#endif /* LWIP_HTTPD_ETAG */
 #if LWIP_HTTPD_CUSTOM_FILES
   if (fs_open_custom(file, name)) {
     file->is_custom_file = 1;
@@ -150,6 +165,42 @@ fs_read(struct fs_file *file, char *buffer, int count)
 }
 #endif /* LWIP_HTTPD_DYNAMIC_FILE_READ */
 /*-----------------------------------------------------------------------------------*/
+#if LWIP_HTTPD_FS_ZEROCOPY
+#if LWIP_HTTPD_FS_ASYNC_READ
+int
+fs_read_nocopy_async(struct fs_file *file, const char **buffer, int count, fs_wait_cb callback_fn, void *callback_arg)
+#else /* LWIP_HTTPD_FS_ASYNC_READ */
+int
+fs_read_nocopy(struct fs_file *file, const char **buffer, int count)
+#endif /* LWIP_HTTPD_FS_ASYNC_READ */
+{
+  if(file->index == file->len) {
+    return FS_READ_EOF;
+  }
+  if (file->is_custom_file) {
+#if LWIP_HTTPD_FS_ASYNC_READ
+    return fs_read_nocopy_async_custom(file, buffer, count, callback_fn, callback_arg);
+#else /* LWIP_HTTPD_FS_ASYNC_READ */
+    return fs_read_nocopy_custom(file, buffer, count);
+#endif /* LWIP_HTTPD_FS_ASYNC_READ */
+  }
+  /* fsdata files are sent from file->data in one piece */
+  LWIP_UNUSED_ARG(buffer);
+  LWIP_UNUSED_ARG(count);
+#if LWIP_HTTPD_FS_ASYNC_READ
+  LWIP_UNUSED_ARG(callback_fn);
+  LWIP_UNUSED_ARG(callback_arg);
+#endif /* LWIP_HTTPD_FS_ASYNC_READ */
+  return 0;
+}
+
+void
+fs_release_nocopy(const char *buffer)
+{
+  fs_release_nocopy_custom(buffer);
+}
+#endif /* LWIP_HTTPD_FS_ZEROCOPY */
+/*-----------------------------------------------------------------------------------*/
 #if LWIP_HTTPD_FS_ASYNC_READ
 int
 fs_is_file_ready(struct fs_file *file, fs_wait_cb callback_fn, void *callback_arg)
@@ -111,6 +111,17 @@
 #if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
 #define HTTP11_CONNECTIONKEEPALIVE  "Connection: keep-alive"
 #define HTTP11_CONNECTIONKEEPALIVE2 "Connection: Keep-Alive"
+#define HTTP11_CONNECTIONCLOSE      "Connection: close"
+#define HTTP11_CONNECTIONCLOSE2     "Connection: Close"
+#endif
+#if LWIP_HTTPD_ETAG
+#define HTTP_HDR_IF_NONE_MATCH      "If-None-Match:"
+#if !LWIP_HTTPD_DYNAMIC_HEADERS
+#error "LWIP_HTTPD_ETAG needs LWIP_HTTPD_DYNAMIC_HEADERS"
+#endif
+#endif
+#if LWIP_HTTPD_FS_ZEROCOPY && LWIP_HTTPD_SSI
+#error "LWIP_HTTPD_FS_ZEROCOPY does not support SSI"
 #endif
 
 /** These defines check whether tcp_write has to copy data or not */
@@ -122,6 +133,12 @@
 #if LWIP_HTTPD_SSI
 /* Copy for SSI files, no copy for non-SSI files */
 #define HTTP_IS_DATA_VOLATILE(hs)   ((hs)->ssi ? TCP_WRITE_FLAG_COPY : 0)
+#elif LWIP_HTTPD_FS_ZEROCOPY
+/** Don't copy blocks lent by the file system (they are kept until acknowledged)
+ * nor data sent from the file system directly */
+#define HTTP_IS_DATA_VOLATILE(hs) (((hs)->zc.current || ((hs->file != NULL) && (hs->handle != NULL) && \
+                                   (hs->file == (const char*)hs->handle->data + hs->handle->len - hs->left))) \
+                                   ? 0 : TCP_WRITE_FLAG_COPY)
 #else /* LWIP_HTTPD_SSI */
 /** Default: don't copy if the data is sent from file-system directly */
 #define HTTP_IS_DATA_VOLATILE(hs) (((hs->file != NULL) && (hs->handle != NULL) && (hs->file == \
@@ -180,12 +197,18 @@ static char http_uri_buf[LWIP_HTTPD_URI_BUF_LEN+1];
 /* The number of individual strings that comprise the headers sent before each
  * requested file.
  */
-#define NUM_FILE_HDR_STRINGS 5
 #define HDR_STRINGS_IDX_HTTP_STATUS          0 /* e.g. "HTTP/1.0 200 OK\r\n" */
 #define HDR_STRINGS_IDX_SERVER_NAME          1 /* e.g. "Server: "HTTPD_SERVER_AGENT"\r\n" */
 #define HDR_STRINGS_IDX_CONTENT_LEN_KEPALIVE 2 /* e.g. "Content-Length: xy\r\n" and/or "Connection: keep-alive\r\n" */
 #define HDR_STRINGS_IDX_CONTENT_LEN_NR       3 /* the byte count, when content-length is used */
+#if LWIP_HTTPD_ETAG
+#define HDR_STRINGS_IDX_ETAG                 4 /* the "ETag: " line provided by the file system */
+#define HDR_STRINGS_IDX_CONTENT_TYPE         5 /* the content type (or default answer content type including default document) */
+#define NUM_FILE_HDR_STRINGS 6
+#else /* LWIP_HTTPD_ETAG */
 #define HDR_STRINGS_IDX_CONTENT_TYPE         4 /* the content type (or default answer content type including default document) */
+#define NUM_FILE_HDR_STRINGS 5
+#endif /* LWIP_HTTPD_ETAG */
 
 /* The dynamically generated Content-Length buffer needs space for CRLF + NULL */
 #define LWIP_HTTPD_MAX_CONTENT_LEN_OFFSET 3
@@ -227,6 +250,19 @@ struct http_ssi_state {
 };
 #endif /* LWIP_HTTPD_SSI */
 
+#if LWIP_HTTPD_FS_ZEROCOPY
+/** Blocks the file system has lent to a connection. tcp_write() references
+ * them without copying, so they are given back only when the peer has
+ * acknowledged them. This outlives the file (persistent connections). */
+struct http_zc_state {
+  const char *buf[LWIP_HTTPD_FS_ZEROCOPY_BLOCKS]; /* Lent blocks, oldest first */
+  u32_t end[LWIP_HTTPD_FS_ZEROCOPY_BLOCKS];       /* Sequence number following each block */
+  u8_t count;     /* Number of lent blocks */
+  u8_t current;   /* hs->file points into the newest lent block */
+  u8_t closing;   /* Close the connection when all blocks are given back */
+};
+#endif /* LWIP_HTTPD_FS_ZEROCOPY */
+
 struct http_state {
 #if LWIP_HTTPD_KILL_OLD_ON_CONNECTIONS_EXCEEDED
   struct http_state *next;
@@ -244,6 +280,9 @@ struct http_state {
   char *buf;        /* File read buffer. */
   int buf_len;      /* Size of file read buffer, buf. */
 #endif /* LWIP_HTTPD_DYNAMIC_FILE_READ */
+#if LWIP_HTTPD_FS_ZEROCOPY
+  struct http_zc_state zc;
+#endif /* LWIP_HTTPD_FS_ZEROCOPY */
   u32_t left;       /* Number of unsent bytes in buf. */
   u8_t retries;
 #if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
@@ -263,6 +302,10 @@ struct http_state {
                         current string */
   u16_t hdr_index;   /* The index of the hdr string currently being sent. */
 #endif /* LWIP_HTTPD_DYNAMIC_HEADERS */
+#if LWIP_HTTPD_ETAG
+  const char *inm;   /* "If-None-Match:" line of the request being parsed */
+  u16_t inm_len;
+#endif /* LWIP_HTTPD_ETAG */
 #if LWIP_HTTPD_TIMING
   u32_t time_started;
 #endif /* LWIP_HTTPD_TIMING */
@@ -493,6 +536,36 @@ http_state_eof(struct http_state *hs)
 #endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
 }
 
+#if LWIP_HTTPD_FS_ZEROCOPY
+/** Give lent blocks back to the file system once the pcb does not reference
+ * them any more: all bytes of the block and the segment holding its last byte
+ * (at most one MSS further) are acknowledged, or everything sent is.
+ * With pcb == NULL (connection reset or aborted) all blocks are given back.
+ */
+static void
+http_zc_release(struct http_state *hs, struct tcp_pcb *pcb)
+{
+  u8_t i;
+  while (hs->zc.count > 0) {
+    if (pcb != NULL) {
+      s32_t acked = (s32_t)(pcb->lastack - hs->zc.end[0]);
+      if ((acked < 0) || ((acked < (s32_t)pcb->mss) && (pcb->lastack != pcb->snd_lbb))) {
+        break;
+      }
+    }
+    fs_release_nocopy(hs->zc.buf[0]);
+    hs->zc.count--;
+    for (i = 0; i < hs->zc.count; i++) {
+      hs->zc.buf[i] = hs->zc.buf[i + 1];
+      hs->zc.end[i] = hs->zc.end[i + 1];
+    }
+  }
+  if (hs->zc.count == 0) {
+    hs->zc.current = 0;
+  }
+}
+#endif /* LWIP_HTTPD_FS_ZEROCOPY */
+
 /** Free a struct http_state.
  * Also frees the file data if dynamic.
  */
@@ -500,6 +573,9 @@ static void
 http_state_free(struct http_state *hs)
 {
   if (hs != NULL) {
+#if LWIP_HTTPD_FS_ZEROCOPY
+    http_zc_release(hs, NULL);
+#endif /* LWIP_HTTPD_FS_ZEROCOPY */
     http_state_eof(hs);
     http_remove_connection(hs);
     HTTP_FREE_HTTP_STATE(hs);
@@ -598,6 +674,14 @@ http_close_or_abort_conn(struct tcp_pcb *pcb, struct http_state *hs, u8_t abort_
   }
 #endif /* LWIP_HTTPD_SUPPORT_POST*/
 
+#if LWIP_HTTPD_FS_ZEROCOPY
+  if ((hs != NULL) && (hs->zc.count > 0) && !abort_conn) {
+    /* The pcb would still send from lent blocks after tcp_close():
+       close when the peer has acknowledged them (see http_sent) */
+    hs->zc.closing = 1;
+    return ERR_OK;
+  }
+#endif /* LWIP_HTTPD_FS_ZEROCOPY */
 
   tcp_arg(pcb, NULL);
   tcp_recv(pcb, NULL);
@@ -643,6 +727,9 @@ http_eof(struct tcp_pcb *pcb, struct http_state *hs)
   /* HTTP/1.1 persistent connection? (Not supported for SSI) */
 #if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
   if (hs->keepalive) {
+#if LWIP_HTTPD_FS_ZEROCOPY
+    struct http_zc_state zc = hs->zc;
+#endif /* LWIP_HTTPD_FS_ZEROCOPY */
     http_remove_connection(hs);
 
     http_state_eof(hs);
@@ -650,6 +737,11 @@ http_eof(struct tcp_pcb *pcb, struct http_state *hs)
     /* restore state: */
     hs->pcb = pcb;
     hs->keepalive = 1;
+#if LWIP_HTTPD_FS_ZEROCOPY
+    /* blocks of the last response may still be in flight */
+    hs->zc = zc;
+    hs->zc.current = 0;
+#endif /* LWIP_HTTPD_FS_ZEROCOPY */
     http_add_connection(hs);
     /* ensure nagle doesn't interfere with sending all data as fast as possible: */
     tcp_nagle_disable(pcb);
@@ -838,6 +930,9 @@ get_http_headers(struct http_state *hs, const char *uri)
   hs->hdrs[HDR_STRINGS_IDX_SERVER_NAME] = g_psHTTPHeaderStrings[HTTP_HDR_SERVER];
   hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_KEPALIVE] = NULL;
   hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_NR] = NULL;
+#if LWIP_HTTPD_ETAG
+  hs->hdrs[HDR_STRINGS_IDX_ETAG] = ((hs->handle != NULL) && (uri != NULL)) ? hs->handle->etag : NULL;
+#endif /* LWIP_HTTPD_ETAG */
 
   /* Is this a normal file or the special case we use to send back the
      default "404: Page not found" response? */
@@ -1083,6 +1178,42 @@ http_check_eof(struct tcp_pcb *pcb, struct http_state *hs)
     return 0;
   }
 #if LWIP_HTTPD_DYNAMIC_FILE_READ
+#if LWIP_HTTPD_FS_ZEROCOPY
+  hs->zc.current = 0;
+  if (hs->zc.count >= LWIP_HTTPD_FS_ZEROCOPY_BLOCKS) {
+    /* Wait until the peer acknowledges a lent block (http_sent) */
+    return 0;
+  }
+  {
+    const char *block;
+    /* Try to send the next block straight from the file system */
+#if LWIP_HTTPD_FS_ASYNC_READ
+    count = fs_read_nocopy_async(hs->handle, &block, bytes_left, http_continue, hs);
+#else /* LWIP_HTTPD_FS_ASYNC_READ */
+    count = fs_read_nocopy(hs->handle, &block, bytes_left);
+#endif /* LWIP_HTTPD_FS_ASYNC_READ */
+    if (count > 0) {
+      LWIP_DEBUGF(HTTPD_DEBUG, ("Lent %d bytes.\n", count));
+      /* All data before the block has been enqueued already */
+      hs->zc.buf[hs->zc.count] = block;
+      hs->zc.end[hs->zc.count] = pcb->snd_lbb + (u32_t)count;
+      hs->zc.count++;
+      hs->zc.current = 1;
+      hs->left = count;
+      hs->file = block;
+      return 1;
+    }
+    if (count == FS_READ_DELAYED) {
+      return 0;
+    }
+    if (count < 0) {
+      LWIP_DEBUGF(HTTPD_DEBUG, ("End of file.\n"));
+      http_eof(pcb, hs);
+      return 0;
+    }
+    /* No block to lend: read a copy into hs->buf */
+  }
+#endif /* LWIP_HTTPD_FS_ZEROCOPY */
   /* Do we already have a send buffer allocated? */
   if(hs->buf) {
     /* Yes - get the length of the buffer */
@@ -2007,15 +2138,27 @@ http_parse_request(struct pbuf *inp, struct http_state *hs, struct tcp_pcb *pcb)
         if (lwip_strnstr(data, CRLF CRLF, data_len) != NULL) {
           char *uri = sp1 + 1;
 #if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
-          /* This is HTTP/1.0 compatible: for strict 1.1, a connection
-             would always be persistent unless "close" was specified. */
+          /* HTTP/1.0 clients ask for a persistent connection with
+             "keep-alive", for HTTP/1.1 it is the default unless "close"
+             was specified. */
           if (!is_09 && (lwip_strnstr(data, HTTP11_CONNECTIONKEEPALIVE, data_len) ||
-              lwip_strnstr(data, HTTP11_CONNECTIONKEEPALIVE2, data_len))) {
+              lwip_strnstr(data, HTTP11_CONNECTIONKEEPALIVE2, data_len) ||
+              (!strncmp(sp2 + 1, "HTTP/1.1", 8) &&
+               !lwip_strnstr(data, HTTP11_CONNECTIONCLOSE, data_len) &&
+               !lwip_strnstr(data, HTTP11_CONNECTIONCLOSE2, data_len)))) {
             hs->keepalive = 1;
           } else {
             hs->keepalive = 0;
           }
 #endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+#if LWIP_HTTPD_ETAG
+          /* remember the validator for http_init_file(), data is valid until then */
+          hs->inm = lwip_strnstr(data, HTTP_HDR_IF_NONE_MATCH, data_len);
+          if (hs->inm != NULL) {
+            char *inm_end = lwip_strnstr(hs->inm, CRLF, data_len - (u16_t)(hs->inm - data));
+            hs->inm_len = (u16_t)((inm_end != NULL) ? (inm_end - hs->inm) : 0);
+          }
+#endif /* LWIP_HTTPD_ETAG */
           /* null-terminate the METHOD (pbuf is freed anyway wen returning) */
           *sp1 = 0;
           uri[uri_len] = 0;
@@ -2212,6 +2355,35 @@ http_find_file(struct http_state *hs, const char *uri, int is_09)
   return http_init_file(hs, file, is_09, uri, tag_check, params);
 }
 
+#if LWIP_HTTPD_ETAG
+/** Check if the entity tag of the file is listed in the "If-None-Match:"
+ * line of the request.
+ */
+static u8_t
+http_etag_matches(struct http_state *hs)
+{
+  const char *tag, *tag_end;
+  u16_t tag_len, i;
+
+  if (hs->inm == NULL) {
+    return 0;
+  }
+  /* the quoted tag of the "ETag: " line */
+  tag = strchr(hs->hdrs[HDR_STRINGS_IDX_ETAG], '"');
+  tag_end = (tag != NULL) ? strchr(tag + 1, '"') : NULL;
+  if (tag_end == NULL) {
+    return 0;
+  }
+  tag_len = (u16_t)(tag_end + 1 - tag);
+  for (i = 0; i + tag_len <= hs->inm_len; i++) {
+    if (!memcmp(&hs->inm[i], tag, tag_len)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+#endif /* LWIP_HTTPD_ETAG */
+
 /** Initialize a http connection with a file to send (if found).
  * Called by http_find_file and http_find_error_file.
  *
@@ -2328,6 +2500,25 @@ http_init_file(struct http_state *hs, struct fs_file *file, int is_09, const cha
      }
   }
 #endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+#if LWIP_HTTPD_ETAG
+  if ((hs->hdr_index == 0) && (hs->hdrs[HDR_STRINGS_IDX_ETAG] != NULL) && http_etag_matches(hs)) {
+    /* The client has the current version: send the headers only */
+    fs_close(hs->handle);
+    hs->handle = NULL;
+    hs->file = NULL;
+    hs->left = 0;
+    hs->hdrs[HDR_STRINGS_IDX_HTTP_STATUS] = g_psHTTPHeaderStrings[HTTP_HDR_NOT_MODIFIED];
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+    hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_KEPALIVE] =
+      g_psHTTPHeaderStrings[hs->keepalive ? HTTP_HDR_CONN_KEEPALIVE : HTTP_HDR_CONN_CLOSE];
+#else /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+    hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_KEPALIVE] = NULL;
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+    hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_NR] = NULL;
+    hs->hdrs[HDR_STRINGS_IDX_CONTENT_TYPE] = CRLF;
+  }
+  hs->inm = NULL;
+#endif /* LWIP_HTTPD_ETAG */
   return ERR_OK;
 }
 
@@ -2367,6 +2558,16 @@ http_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
 
   hs->retries = 0;
 
+#if LWIP_HTTPD_FS_ZEROCOPY
+  http_zc_release(hs, pcb);
+  if (hs->zc.closing) {
+    if (hs->zc.count == 0) {
+      http_close_conn(pcb, hs);
+    }
+    return ERR_OK;
+  }
+#endif /* LWIP_HTTPD_FS_ZEROCOPY */
+
   http_send(pcb, hs);
 
   return ERR_OK;
@@ -2400,6 +2601,17 @@ http_poll(void *arg, struct tcp_pcb *pcb)
 #endif /* LWIP_HTTPD_ABORT_ON_CLOSE_MEM_ERROR */
     return ERR_OK;
   } else {
+#if LWIP_HTTPD_FS_ZEROCOPY
+    if (hs->zc.closing) {
+      /* waiting for lent blocks to be acknowledged before closing */
+      if (++hs->retries >= HTTPD_MAX_RETRIES) {
+        LWIP_DEBUGF(HTTPD_DEBUG, ("http_poll: lent blocks not acknowledged, abort\n"));
+        http_close_or_abort_conn(pcb, hs, 1);
+        return ERR_ABRT;
+      }
+      return ERR_OK;
+    }
+#endif /* LWIP_HTTPD_FS_ZEROCOPY */
     hs->retries++;
     if (hs->retries == HTTPD_MAX_RETRIES) {
       LWIP_DEBUGF(HTTPD_DEBUG, ("http_poll: too many retries, close\n"));
@@ -2459,6 +2671,14 @@ http_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
     tcp_recved(pcb, p->tot_len);
   }
 
+#if LWIP_HTTPD_FS_ZEROCOPY
+  if (hs->zc.closing) {
+    /* no more requests on a connection being closed */
+    pbuf_free(p);
+    return ERR_OK;
+  }
+#endif /* LWIP_HTTPD_FS_ZEROCOPY */
+
 #if LWIP_HTTPD_SUPPORT_POST
   if (hs->post_content_len_left > 0) {
     /* reset idle counter when POST data is received */
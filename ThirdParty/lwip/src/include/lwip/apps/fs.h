@@ -69,6 +69,9 @@ struct fs_file {
 #if LWIP_HTTPD_FILE_STATE
   void *state;
 #endif /* LWIP_HTTPD_FILE_STATE */
+#if LWIP_HTTPD_ETAG
+  const char *etag;
+#endif /* LWIP_HTTPD_ETAG */
 };
 
 #if LWIP_HTTPD_FS_ASYNC_READ
@@ -84,6 +87,14 @@ int fs_read_async(struct fs_file *file, char *buffer, int count, fs_wait_cb call
 int fs_read(struct fs_file *file, char *buffer, int count);
 #endif /* LWIP_HTTPD_FS_ASYNC_READ */
 #endif /* LWIP_HTTPD_DYNAMIC_FILE_READ */
+#if LWIP_HTTPD_FS_ZEROCOPY
+#if LWIP_HTTPD_FS_ASYNC_READ
+int fs_read_nocopy_async(struct fs_file *file, const char **buffer, int count, fs_wait_cb callback_fn, void *callback_arg);
+#else /* LWIP_HTTPD_FS_ASYNC_READ */
+int fs_read_nocopy(struct fs_file *file, const char **buffer, int count);
+#endif /* LWIP_HTTPD_FS_ASYNC_READ */
+void fs_release_nocopy(const char *buffer);
+#endif /* LWIP_HTTPD_FS_ZEROCOPY */
 #if LWIP_HTTPD_FS_ASYNC_READ
 int fs_is_file_ready(struct fs_file *file, fs_wait_cb callback_fn, void *callback_arg);
 #endif /* LWIP_HTTPD_FS_ASYNC_READ */
@@ -310,6 +310,35 @@
 #define LWIP_HTTPD_FS_ASYNC_READ      0
 #endif
 
+/** LWIP_HTTPD_FS_ZEROCOPY==1: let custom files lend their read blocks to
+ * tcp_write() instead of copying file data into a per-connection buffer.
+ * Needs LWIP_HTTPD_CUSTOM_FILES and LWIP_HTTPD_DYNAMIC_FILE_READ and provide
+ * the functions:
+ * - "int fs_read_nocopy_custom(struct fs_file *file, const char **buffer, int count)"
+ *    (or fs_read_nocopy_async_custom() with LWIP_HTTPD_FS_ASYNC_READ)
+ *    Returns the number of bytes in *buffer, FS_READ_EOF, FS_READ_DELAYED
+ *    or 0 if no block can be lent (the data is then read with fs_read()).
+ * - "void fs_release_nocopy_custom(const char *buffer)"
+ *    Called once the peer has acknowledged all data of the block, even if
+ *    the file has been closed in between.
+ */
+#if !defined LWIP_HTTPD_FS_ZEROCOPY || defined __DOXYGEN__
+#define LWIP_HTTPD_FS_ZEROCOPY        0
+#endif
+
+/** Maximum number of blocks a connection holds lent at a time */
+#if !defined LWIP_HTTPD_FS_ZEROCOPY_BLOCKS || defined __DOXYGEN__
+#define LWIP_HTTPD_FS_ZEROCOPY_BLOCKS 2
+#endif
+
+/** LWIP_HTTPD_ETAG==1: send the "ETag:" header line a file system provides
+ * in fs_file.etag (e.g. "ETag: \"1f40-4c215a32\"\r\n") and answer requests
+ * with a matching "If-None-Match:" with 304 Not Modified and no body.
+ * Needs LWIP_HTTPD_DYNAMIC_HEADERS. */
+#if !defined LWIP_HTTPD_ETAG || defined __DOXYGEN__
+#define LWIP_HTTPD_ETAG               0
+#endif
+
 /** Set this to 1 to include "fsdata_custom.c" instead of "fsdata.c" for the
  * file system (to prevent changing the file included in CVS) */
 #if !defined HTTPD_USE_CUSTOM_FSDATA || defined __DOXYGEN__
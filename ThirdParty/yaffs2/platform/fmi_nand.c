@@ -68,6 +68,11 @@ static const int g_i32ParityNum[3][3] = {
     { 240,    368,    360 },  // For 8K
 };
 
+/* Page transfers through the FMI with hardware ECC; the program busy wait is in nand_base.c */
+SYS_PROF_DEFINE(s_sProfNandWrite, "nand write page")
+SYS_PROF_DEFINE(s_sProfNandRead, "nand read page")
+SYS_PROF_DEFINE(s_sProfNandOob, "nand read oob")
+
 extern uint32_t get_ticks(void);
 void udelay(unsigned int tick)
 {
@@ -560,6 +565,7 @@ static int nuvoton_nand_write_page_hwecc(struct mtd_info *mtd, struct nand_chip
     uint32_t hweccbytes=chip->ecc.layout->eccbytes;
     register char * ptr=(char *)REG_NANDRA0;
 
+    SYS_PROF_BEGIN(s_sProfNandWrite);
     //debug("nuvoton_nand_write_page_hwecc\n");
     memset ( (void*)ptr, 0xFF, mtd->oobsize );
     memcpy ( (void*)ptr, (void*)chip->oob_poi,  mtd->oobsize - chip->ecc.total );
@@ -572,6 +578,7 @@ static int nuvoton_nand_write_page_hwecc(struct mtd_info *mtd, struct nand_chip
     // Copy parity code in calc to oob_poi
     memcpy ( (void*)(chip->oob_poi+hweccbytes), (void*)ecc_calc, chip->ecc.total);
 
+    SYS_PROF_END(s_sProfNandWrite);
     return 0;
 }
 
@@ -589,6 +596,7 @@ static int nuvoton_nand_read_page_hwecc_oob_first(struct mtd_info *mtd, struct n
     char * ptr= (char *)REG_NANDRA0;
     int volatile i;
 
+    SYS_PROF_BEGIN(s_sProfNandRead);
     //debug("nuvoton_nand_read_page_hwecc_oob_first\n");
     /* At first, read the OOB area  */
     nuvoton_nand_command(mtd, NAND_CMD_READOOB, 0, page);
@@ -604,6 +612,7 @@ static int nuvoton_nand_read_page_hwecc_oob_first(struct mtd_info *mtd, struct n
     // Fouth, restore OOB data from SMRA
     memcpy ( (void*)chip->oob_poi, (void*)ptr, mtd->oobsize );
 
+    SYS_PROF_END(s_sProfNandRead);
     return 0;
 }
 
@@ -618,6 +627,7 @@ static int nuvoton_nand_read_oob_hwecc(struct mtd_info *mtd, struct nand_chip *c
 {
     char * ptr=(char *)REG_NANDRA0;
 
+    SYS_PROF_BEGIN(s_sProfNandOob);
     /* At first, read the OOB area  */
     nuvoton_nand_command(mtd, NAND_CMD_READOOB, 0, page);
 
@@ -626,6 +636,7 @@ static int nuvoton_nand_read_oob_hwecc(struct mtd_info *mtd, struct nand_chip *c
     // Second, copy OOB data to SMRA for page read
     memcpy ( (void*)ptr, (void*)chip->oob_poi, mtd->oobsize );
 
+    SYS_PROF_END(s_sProfNandOob);
     return 0;
 }
 